@@ -464,6 +464,7 @@ bool AbstractCommand::prepareForRetry(time_t wait)
     // We don't use wait so that Command can be executed by
     // DownloadEngine::setRefreshInterval(std::chrono::milliseconds(0)).
     command->setStatus(Command::STATUS_INACTIVE);
+    command->setWakeupTimeAfter(std::chrono::seconds(wait));
   }
   e_->addCommand(std::move(command));
   return true;
@@ -773,7 +774,20 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     return ipaddr;
   }
 
+  {
+    std::string error;
+    if (e_->findCachedNameResolutionFailure(error, hostname, port)) {
+      A2_LOG_INFO(fmt(MSG_DNS_NEGATIVE_CACHE_HIT, getCuid(), hostname.c_str(),
+                      error.c_str()));
+      throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
+                             hostname.c_str(), error.c_str()),
+                         error_code::NAME_RESOLVE_ERROR);
+    }
+  }
+
   std::string ipaddr;
+  // TTL of each address in addrs if it is known.
+  std::vector<int> ttls;
 #ifdef ENABLE_ASYNC_DNS
   if (getOption()->getAsBool(PREF_ASYNC_DNS)) {
     if (!asyncNameResolverMan_->started()) {
@@ -786,6 +800,10 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
             ->getOrCreateServerStat(req_->getHost(), req_->getProtocol())
             ->setError();
       }
+      if (asyncNameResolverMan_->isNegativeAnswer()) {
+        e_->cacheNameResolutionFailure(hostname, port,
+                                       asyncNameResolverMan_->getLastError());
+      }
       throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
                              hostname.c_str(),
                              asyncNameResolverMan_->getLastError().c_str()),
@@ -794,7 +812,7 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
       return A2STR::NIL;
 
     case 1:
-      asyncNameResolverMan_->getResolvedAddress(addrs);
+      asyncNameResolverMan_->getResolvedAddress(addrs, ttls);
       if (addrs.empty()) {
         throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
                                hostname.c_str(), "No address returned"),
@@ -811,12 +829,21 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     if (e_->getOption()->getAsBool(PREF_DISABLE_IPV6)) {
       res.setFamily(AF_INET);
     }
-    res.resolve(addrs, hostname);
+    try {
+      res.resolve(addrs, hostname);
+    }
+    catch (RecoverableException& ex) {
+      if (res.isNegativeAnswer()) {
+        e_->cacheNameResolutionFailure(hostname, port, ex.what());
+      }
+      throw;
+    }
   }
   A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_COMPLETE, getCuid(), hostname.c_str(),
                   strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
-  for (const auto& addr : addrs) {
-    e_->cacheIPAddress(hostname, addr, port);
+  for (size_t i = 0; i < addrs.size(); ++i) {
+    e_->cacheIPAddress(hostname, addrs[i], port,
+                       std::chrono::seconds(i < ttls.size() ? ttls[i] : -1));
   }
   ipaddr = e_->findCachedIPAddress(hostname, port);
   return ipaddr;
@@ -940,6 +967,26 @@ void AbstractCommand::checkSocketRecvBuffer()
 
 void AbstractCommand::addCommandSelf()
 {
+#ifdef ENABLE_ASYNC_DNS
+  const auto resolverChecked = asyncNameResolverMan_->resolverChecked();
+#else  // !ENABLE_ASYNC_DNS
+  const auto resolverChecked = false;
+#endif // !ENABLE_ASYNC_DNS
+  if ((checkSocketIsReadable_ || checkSocketIsWritable_) && !resolverChecked) {
+    // The socket wakes this command up.  Wake it up when it times out
+    // or when it is time to look for a faster server.
+    auto timeout = checkPoint_;
+    timeout.advance(timeout_);
+    auto serverStatTime = serverStatTimer_;
+    serverStatTime.advance(10_s);
+    setWakeupTime(std::min(timeout, serverStatTime));
+  }
+  else {
+    // Without socket to check, this command polls its state, for
+    // example, the availability of a segment.  The name resolver also
+    // needs this to process its timeout.
+    setWakeupTimeAfter(1_s);
+  }
   e_->addCommand(std::unique_ptr<Command>(this));
 }
 
@@ -53,6 +53,7 @@
 #include "DownloadFailureException.h"
 #include "error_code.h"
 #include "LogFactory.h"
+#include "SharedFd.h"
 
 namespace aria2 {
 
@@ -66,7 +67,9 @@ AbstractDiskWriter::AbstractDiskWriter(const std::string& filename)
       readOnly_(false),
       enableMmap_(false),
       mapaddr_(nullptr),
-      maplen_(0)
+      maplen_(0),
+      queuedOffset_(0),
+      queuedLength_(0)
 
 {
 }
@@ -130,6 +133,15 @@ void AbstractDiskWriter::openFile(int64_t totalLength)
 
 void AbstractDiskWriter::closeFile()
 {
+  if (!queuedWrites_.empty()) {
+    try {
+      AbstractDiskWriter::flushWrites();
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_ERROR_EX(fmt("Flushing writes to %s failed", filename_.c_str()),
+                      e);
+    }
+  }
 #if defined(HAVE_MMAP) || defined(__MINGW32__)
   if (mapaddr_) {
     int errNum = 0;
@@ -441,27 +453,77 @@ bool isDiskFullError(int errNum)
 }
 } // namespace
 
+namespace {
+void throwWriteError(const std::string& filename, int errNum)
+{
+  // If the error indicates disk full situation, throw
+  // DownloadFailureException and abort download instantly.
+  if (isDiskFullError(errNum)) {
+    throw DOWNLOAD_FAILURE_EXCEPTION3(
+        errNum,
+        fmt(EX_FILE_WRITE, filename.c_str(), fileStrerror(errNum).c_str()),
+        error_code::NOT_ENOUGH_DISK_SPACE);
+  }
+  else {
+    throw DL_ABORT_EX3(
+        errNum,
+        fmt(EX_FILE_WRITE, filename.c_str(), fileStrerror(errNum).c_str()),
+        error_code::FILE_IO_ERROR);
+  }
+}
+} // namespace
+
 void AbstractDiskWriter::writeData(const unsigned char* data, size_t len,
                                    int64_t offset)
 {
   ensureMmapWrite(len, offset);
   if (writeDataInternal(data, len, offset) < 0) {
-    int errNum = fileError();
-    // If the error indicates disk full situation, throw
-    // DownloadFailureException and abort download instantly.
-    if (isDiskFullError(errNum)) {
-      throw DOWNLOAD_FAILURE_EXCEPTION3(
-          errNum,
-          fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
-          error_code::NOT_ENOUGH_DISK_SPACE);
+    throwWriteError(filename_, fileError());
+  }
+}
+
+void AbstractDiskWriter::queueWrite(const unsigned char* data, size_t len,
+                                    int64_t offset)
+{
+#ifdef HAVE_PWRITEV
+  if (!enableMmap_ && !mapaddr_) {
+    if (!queuedWrites_.empty() &&
+        queuedOffset_ + static_cast<int64_t>(queuedLength_) != offset) {
+      flushWrites();
     }
-    else {
-      throw DL_ABORT_EX3(
-          errNum,
-          fmt(EX_FILE_WRITE, filename_.c_str(), fileStrerror(errNum).c_str()),
-          error_code::FILE_IO_ERROR);
+    if (queuedWrites_.empty()) {
+      queuedOffset_ = offset;
     }
+    queuedWrites_.push_back(QueuedWrite{data, len});
+    queuedLength_ += len;
+    return;
   }
+#endif // HAVE_PWRITEV
+  writeData(data, len, offset);
+}
+
+void AbstractDiskWriter::flushWrites()
+{
+  if (queuedWrites_.empty()) {
+    return;
+  }
+#ifdef HAVE_PWRITEV
+  std::vector<struct iovec> iovs;
+  iovs.reserve(queuedWrites_.size());
+  for (auto& w : queuedWrites_) {
+    iovs.push_back({const_cast<unsigned char*>(w.data), w.len});
+  }
+  auto offset = queuedOffset_;
+  queuedWrites_.clear();
+  queuedLength_ = 0;
+  A2_LOG_DEBUG(fmt("Writing %lu buffers at offset=%" PRId64 " to %s",
+                   static_cast<unsigned long>(iovs.size()), offset,
+                   filename_.c_str()));
+  int errNum = util::pwritevAll(fd_, iovs.data(), iovs.size(), offset);
+  if (errNum != 0) {
+    throwWriteError(filename_, errNum);
+  }
+#endif // HAVE_PWRITEV
 }
 
 ssize_t AbstractDiskWriter::readData(unsigned char* data, size_t len,
@@ -590,4 +652,62 @@ void AbstractDiskWriter::dropCache(int64_t len, int64_t offset)
 #endif // HAVE_POSIX_FADVISE
 }
 
+int AbstractDiskWriter::dupFd()
+{
+#if defined(HAVE_PWRITE) && !defined(__MINGW32__)
+  // Data written via mmap is not ordered with pwrite(2) from another
+  // thread.  Let the caller fall back to writeData().
+  if (fd_ == A2_BAD_FD || readOnly_ || enableMmap_ || mapaddr_) {
+    return -1;
+  }
+  int fd;
+  while ((fd = dup(fd_)) == -1 && errno == EINTR)
+    ;
+  if (fd != -1) {
+    util::make_fd_cloexec(fd);
+  }
+  return fd;
+#else  // !HAVE_PWRITE || __MINGW32__
+  return -1;
+#endif // !HAVE_PWRITE || __MINGW32__
+}
+
+int AbstractDiskWriter::dupReadFd()
+{
+#ifndef __MINGW32__
+  // The queued writes are not in the file yet.
+  if (fd_ == A2_BAD_FD || !queuedWrites_.empty()) {
+    return -1;
+  }
+  int fd;
+  while ((fd = dup(fd_)) == -1 && errno == EINTR)
+    ;
+  if (fd != -1) {
+    util::make_fd_cloexec(fd);
+  }
+  return fd;
+#else  // __MINGW32__
+  return -1;
+#endif // __MINGW32__
+}
+
+std::shared_ptr<SharedFd> AbstractDiskWriter::shareReadFd()
+{
+  // The queued writes are not in the file yet.
+  if (!queuedWrites_.empty()) {
+    return nullptr;
+  }
+  auto fd = sharedReadFd_.lock();
+  if (fd) {
+    return fd;
+  }
+  int newFd = dupReadFd();
+  if (newFd == -1) {
+    return nullptr;
+  }
+  fd = std::make_shared<SharedFd>(newFd);
+  sharedReadFd_ = fd;
+  return fd;
+}
+
 } // namespace aria2
@@ -37,6 +37,7 @@
 
 #include "DiskWriter.h"
 #include <string>
+#include <vector>
 
 namespace aria2 {
 
@@ -58,6 +59,19 @@ private:
   unsigned char* mapaddr_;
   int64_t maplen_;
 
+  struct QueuedWrite {
+    const unsigned char* data;
+    size_t len;
+  };
+  // Contiguous writes queued by queueWrite(), which start at
+  // queuedOffset_.
+  std::vector<QueuedWrite> queuedWrites_;
+  int64_t queuedOffset_;
+  size_t queuedLength_;
+
+  // The file descriptor returned by shareReadFd() last time.
+  std::weak_ptr<SharedFd> sharedReadFd_;
+
   ssize_t writeDataInternal(const unsigned char* data, size_t len,
                             int64_t offset);
   ssize_t readDataInternal(unsigned char* data, size_t len, int64_t offset);
@@ -69,6 +83,16 @@ private:
 protected:
   void createFile(int addFlags = 0);
 
+  const std::string& getFilename() const { return filename_; }
+
+#ifndef __MINGW32__
+  int getFd() const { return fd_; }
+#endif // !__MINGW32__
+
+  // Returns true if data is, or is going to be, accessed through
+  // memory mapped file.
+  bool isMmapEnabled() const { return enableMmap_ || mapaddr_; }
+
 public:
   AbstractDiskWriter(const std::string& filename);
   virtual ~AbstractDiskWriter();
@@ -100,6 +124,20 @@ public:
   virtual void enableMmap() CXX11_OVERRIDE;
 
   virtual void dropCache(int64_t len, int64_t offset) CXX11_OVERRIDE;
+
+  virtual int dupFd() CXX11_OVERRIDE;
+
+  virtual int dupReadFd() CXX11_OVERRIDE;
+
+  virtual std::shared_ptr<SharedFd> shareReadFd() CXX11_OVERRIDE;
+
+  // Queues the write if it is contiguous to the queued ones, so that
+  // they are written with a single pwritev(2) call.  Otherwise,
+  // flushes the queued writes first.
+  virtual void queueWrite(const unsigned char* data, size_t len,
+                          int64_t offset) CXX11_OVERRIDE;
+
+  virtual void flushWrites() CXX11_OVERRIDE;
 };
 
 } // namespace aria2
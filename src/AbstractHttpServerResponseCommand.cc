@@ -128,6 +128,9 @@ bool AbstractHttpServerResponseCommand::execute()
     }
     else {
       updateReadWriteCheck();
+      auto timeout = timeoutTimer_;
+      timeout.advance(30_s);
+      setWakeupTime(timeout);
       e_->addCommand(std::unique_ptr<Command>(this));
       return false;
     }
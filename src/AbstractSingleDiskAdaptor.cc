@@ -39,6 +39,7 @@
 #include "FileEntry.h"
 #include "TruncFileAllocationIterator.h"
 #include "WrDiskCacheEntry.h"
+#include "DiskWriteQueue.h"
 #include "LogFactory.h"
 #ifdef HAVE_SOME_FALLOCATE
 #  include "FallocFileAllocationIterator.h"
@@ -94,15 +95,44 @@ ssize_t AbstractSingleDiskAdaptor::readDataDropCache(unsigned char* data,
   return rv;
 }
 
-void AbstractSingleDiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
+void AbstractSingleDiskAdaptor::queueCache(const WrDiskCacheEntry* entry)
 {
   for (auto& d : entry->getDataSet()) {
     A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", d->goff,
                      static_cast<unsigned long>(d->len)));
-    writeData(d->data + d->offset, d->len, d->goff);
+    diskWriter_->queueWrite(d->data + d->offset, d->len, d->goff);
   }
 }
 
+void AbstractSingleDiskAdaptor::flushCache() { diskWriter_->flushWrites(); }
+
+bool AbstractSingleDiskAdaptor::prepareWriteJob(const WrDiskCacheEntry* entry,
+                                                DiskWriteJob& job)
+{
+  for (auto& d : entry->getDataSet()) {
+    if (!job.addWrite(diskWriter_.get(), d->goff, d->data + d->offset,
+                      d->len)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int AbstractSingleDiskAdaptor::dupReadFd(int64_t offset, size_t len,
+                                         int64_t& fileOffset)
+{
+  fileOffset = offset;
+  return diskWriter_->dupReadFd();
+}
+
+std::shared_ptr<SharedFd>
+AbstractSingleDiskAdaptor::shareReadFd(int64_t offset, size_t len,
+                                       int64_t& fileOffset)
+{
+  fileOffset = offset;
+  return diskWriter_->shareReadFd();
+}
+
 bool AbstractSingleDiskAdaptor::fileExists()
 {
   return File(getFilePath()).exists();
@@ -70,7 +70,18 @@ public:
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) CXX11_OVERRIDE;
 
-  virtual void writeCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+  virtual void queueCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+
+  virtual void flushCache() CXX11_OVERRIDE;
+
+  virtual bool prepareWriteJob(const WrDiskCacheEntry* entry,
+                               DiskWriteJob& job) CXX11_OVERRIDE;
+
+  virtual int dupReadFd(int64_t offset, size_t len,
+                        int64_t& fileOffset) CXX11_OVERRIDE;
+
+  virtual std::shared_ptr<SharedFd>
+  shareReadFd(int64_t offset, size_t len, int64_t& fileOffset) CXX11_OVERRIDE;
 
   virtual bool fileExists() CXX11_OVERRIDE;
 
@@ -121,10 +121,15 @@ bool ActivePeerConnectionCommand::execute()
       if (btRuntime_->getConnections() == 0 &&
           !pieceStorage_->downloadFinished()) {
         btAnnounce_->overrideMinInterval(BtAnnounce::DEFAULT_ANNOUNCE_INTERVAL);
+        // Let TrackerWatcherCommand reschedule the announce.
+        e_->wakeupCommands(requestGroup_->getGID());
       }
     }
   }
-  e_->addCommand(std::unique_ptr<Command>(this));
+  auto deadline = checkPoint_;
+  deadline.advance(interval_);
+  e_->addTimerCommand(std::unique_ptr<Command>(this), deadline,
+                      requestGroup_->getGID());
   return false;
 }
 
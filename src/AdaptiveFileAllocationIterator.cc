@@ -114,4 +114,10 @@ int64_t AdaptiveFileAllocationIterator::getTotalLength()
   return totalLength_;
 }
 
+bool AdaptiveFileAllocationIterator::canAllocateInWorker()
+{
+  // The first call probes fallocate support and logs the result.
+  return allocator_ && allocator_->canAllocateInWorker();
+}
+
 } // namespace aria2
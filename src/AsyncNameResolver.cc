@@ -40,25 +40,76 @@
 #include "LogFactory.h"
 #include "SocketCore.h"
 #include "util.h"
+#ifndef HAVE_LIBCARES
+#  include "DNSStubResolver.h"
+#endif // !HAVE_LIBCARES
 
 namespace aria2 {
 
-void callback(void* arg, int status, int timeouts, struct hostent* host)
+#ifdef HAVE_LIBCARES
+
+namespace {
+// RFC 1035 class and types.  Defined here because not all platforms
+// have arpa/nameser.h.
+constexpr int DNS_CLASS_IN = 1;
+constexpr int DNS_TYPE_A = 1;
+constexpr int DNS_TYPE_AAAA = 28;
+// Large enough for the addresses in a response fitting in 64KiB.
+constexpr int MAX_ADDRTTLS = 256;
+} // namespace
+
+void callback(void* arg, int status, int timeouts, unsigned char* abuf,
+              int alen)
 {
   AsyncNameResolver* resolverPtr = reinterpret_cast<AsyncNameResolver*>(arg);
   if (status != ARES_SUCCESS) {
     resolverPtr->error_ = ares_strerror(status);
+    resolverPtr->errorCode_ = status;
     resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
     return;
   }
-  for (char** ap = host->h_addr_list; *ap; ++ap) {
-    char addrstring[NI_MAXHOST];
-    if (inetNtop(host->h_addrtype, *ap, addrstring, sizeof(addrstring)) == 0) {
-      resolverPtr->resolvedAddresses_.push_back(addrstring);
+  struct hostent* host = nullptr;
+  int naddrttls = MAX_ADDRTTLS;
+  if (resolverPtr->family_ == AF_INET) {
+    std::vector<ares_addrttl> addrttls(naddrttls);
+    status = ares_parse_a_reply(abuf, alen, &host, addrttls.data(), &naddrttls);
+    if (status == ARES_SUCCESS) {
+      for (int i = 0; i < naddrttls; ++i) {
+        char addrstring[NI_MAXHOST];
+        if (inetNtop(AF_INET, &addrttls[i].ipaddr, addrstring,
+                     sizeof(addrstring)) == 0) {
+          resolverPtr->resolvedAddresses_.push_back(addrstring);
+          resolverPtr->resolvedTTLs_.push_back(addrttls[i].ttl);
+        }
+      }
+    }
+  }
+  else {
+    std::vector<ares_addr6ttl> addrttls(naddrttls);
+    status =
+        ares_parse_aaaa_reply(abuf, alen, &host, addrttls.data(), &naddrttls);
+    if (status == ARES_SUCCESS) {
+      for (int i = 0; i < naddrttls; ++i) {
+        char addrstring[NI_MAXHOST];
+        if (inetNtop(AF_INET6, &addrttls[i].ip6addr, addrstring,
+                     sizeof(addrstring)) == 0) {
+          resolverPtr->resolvedAddresses_.push_back(addrstring);
+          resolverPtr->resolvedTTLs_.push_back(addrttls[i].ttl);
+        }
+      }
     }
   }
-  if (resolverPtr->resolvedAddresses_.empty()) {
+  if (host) {
+    ares_free_hostent(host);
+  }
+  if (status != ARES_SUCCESS) {
+    resolverPtr->error_ = ares_strerror(status);
+    resolverPtr->errorCode_ = status;
+    resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
+  }
+  else if (resolverPtr->resolvedAddresses_.empty()) {
     resolverPtr->error_ = "no address returned or address conversion failed";
+    resolverPtr->errorCode_ = ARES_ENODATA;
     resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
   }
   else {
@@ -72,7 +123,7 @@ AsyncNameResolver::AsyncNameResolver(int family
                                      ares_addr_node* servers
 #endif // HAVE_ARES_ADDR_NODE
                                      )
-    : status_(STATUS_READY), family_(family)
+    : status_(STATUS_READY), family_(family), errorCode_(ARES_SUCCESS)
 {
   // TODO evaluate return value
   ares_init(&channel_);
@@ -91,8 +142,36 @@ AsyncNameResolver::~AsyncNameResolver() { ares_destroy(channel_); }
 void AsyncNameResolver::resolve(const std::string& name)
 {
   hostname_ = name;
+  // ares_gethostbyname() does not tell the TTL of the records, so we
+  // look up the hosts file by ourselves and send the query with
+  // ares_search(), whose raw response carries TTLs.
+  struct hostent* host;
+  if (ares_gethostbyname_file(channel_, name.c_str(), family_, &host) ==
+      ARES_SUCCESS) {
+    for (char** ap = host->h_addr_list; *ap; ++ap) {
+      char addrstring[NI_MAXHOST];
+      if (inetNtop(host->h_addrtype, *ap, addrstring, sizeof(addrstring)) ==
+          0) {
+        resolvedAddresses_.push_back(addrstring);
+        resolvedTTLs_.push_back(-1);
+      }
+    }
+    ares_free_hostent(host);
+    if (!resolvedAddresses_.empty()) {
+      status_ = STATUS_SUCCESS;
+      return;
+    }
+  }
   status_ = STATUS_QUERYING;
-  ares_gethostbyname(channel_, name.c_str(), family_, callback, this);
+  ares_search(channel_, name.c_str(), DNS_CLASS_IN,
+              family_ == AF_INET ? DNS_TYPE_A : DNS_TYPE_AAAA, callback, this);
+}
+
+bool AsyncNameResolver::isNegativeAnswer() const
+{
+  return status_ == STATUS_ERROR &&
+         (errorCode_ == ARES_ENOTFOUND || errorCode_ == ARES_ENODATA ||
+          errorCode_ == ARES_ESERVFAIL);
 }
 
 int AsyncNameResolver::getFds(fd_set* rfdsPtr, fd_set* wfdsPtr) const
@@ -105,8 +184,6 @@ void AsyncNameResolver::process(fd_set* rfdsPtr, fd_set* wfdsPtr)
   ares_process(channel_, rfdsPtr, wfdsPtr);
 }
 
-#ifdef HAVE_LIBCARES
-
 int AsyncNameResolver::getsock(sock_t* sockets) const
 {
   return ares_getsock(channel_, reinterpret_cast<ares_socket_t*>(sockets),
@@ -118,21 +195,136 @@ void AsyncNameResolver::process(ares_socket_t readfd, ares_socket_t writefd)
   ares_process_fd(channel_, readfd, writefd);
 }
 
-#endif // HAVE_LIBCARES
+void AsyncNameResolver::reset()
+{
+  hostname_ = A2STR::NIL;
+  resolvedAddresses_.clear();
+  resolvedTTLs_.clear();
+  error_.clear();
+  errorCode_ = ARES_SUCCESS;
+  status_ = STATUS_READY;
+  ares_destroy(channel_);
+  // TODO evaluate return value
+  ares_init(&channel_);
+}
 
-bool AsyncNameResolver::operator==(const AsyncNameResolver& resolver) const
+#else  // !HAVE_LIBCARES
+
+AsyncNameResolver::AsyncNameResolver(
+    int family, std::vector<std::pair<std::string, uint16_t>> servers)
+    : status_(STATUS_READY),
+      family_(family),
+      servers_(std::move(servers)),
+      stub_(make_unique<DNSStubResolver>(family,
+                                         getSystemResolvConf(servers_))),
+      errorCode_(DNSStubResolver::ERR_NONE)
 {
-  return this == &resolver;
+}
+
+AsyncNameResolver::~AsyncNameResolver() = default;
+
+void AsyncNameResolver::resolve(const std::string& name)
+{
+  hostname_ = name;
+  stub_->resolve(name);
+  updateStatus();
+}
+
+void AsyncNameResolver::updateStatus()
+{
+  switch (stub_->getStatus()) {
+  case DNSStubResolver::STATUS_SUCCESS:
+    resolvedAddresses_ = stub_->getResolvedAddresses();
+    resolvedTTLs_ = stub_->getResolvedTTLs();
+    status_ = STATUS_SUCCESS;
+    break;
+  case DNSStubResolver::STATUS_ERROR:
+    error_ = stub_->getError();
+    errorCode_ = stub_->getErrorCode();
+    status_ = STATUS_ERROR;
+    break;
+  case DNSStubResolver::STATUS_QUERYING:
+    status_ = STATUS_QUERYING;
+    break;
+  default:
+    break;
+  }
+}
+
+bool AsyncNameResolver::isNegativeAnswer() const
+{
+  return stub_->isNegativeAnswer();
+}
+
+int AsyncNameResolver::getFds(fd_set* rfdsPtr, fd_set* wfdsPtr) const
+{
+  const auto& socket = stub_->getSocket();
+  if (!socket || !socket->isOpen()) {
+    return 0;
+  }
+  sock_t fd = socket->getSockfd();
+  if (stub_->wantRead()) {
+    FD_SET(fd, rfdsPtr);
+  }
+  if (stub_->wantWrite()) {
+    FD_SET(fd, wfdsPtr);
+  }
+  return fd + 1;
+}
+
+void AsyncNameResolver::process(fd_set* rfdsPtr, fd_set* wfdsPtr)
+{
+  const auto& socket = stub_->getSocket();
+  bool readable = false;
+  bool writable = false;
+  if (socket && socket->isOpen()) {
+    sock_t fd = socket->getSockfd();
+    readable = FD_ISSET(fd, rfdsPtr);
+    writable = FD_ISSET(fd, wfdsPtr);
+  }
+  stub_->process(readable, writable);
+  updateStatus();
+}
+
+int AsyncNameResolver::getsock(sock_t* sockets) const
+{
+  const auto& socket = stub_->getSocket();
+  if (!socket || !socket->isOpen()) {
+    return 0;
+  }
+  int bitmask = 0;
+  sockets[0] = socket->getSockfd();
+  if (stub_->wantRead()) {
+    bitmask |= 1;
+  }
+  if (stub_->wantWrite()) {
+    bitmask |= 1 << ARES_GETSOCK_MAXNUM;
+  }
+  return bitmask;
+}
+
+void AsyncNameResolver::process(ares_socket_t readfd, ares_socket_t writefd)
+{
+  stub_->process(readfd != ARES_SOCKET_BAD, writefd != ARES_SOCKET_BAD);
+  updateStatus();
 }
 
 void AsyncNameResolver::reset()
 {
   hostname_ = A2STR::NIL;
   resolvedAddresses_.clear();
+  resolvedTTLs_.clear();
+  error_.clear();
+  errorCode_ = DNSStubResolver::ERR_NONE;
   status_ = STATUS_READY;
-  ares_destroy(channel_);
-  // TODO evaluate return value
-  ares_init(&channel_);
+  stub_ = make_unique<DNSStubResolver>(family_, getSystemResolvConf(servers_));
+}
+
+#endif // !HAVE_LIBCARES
+
+bool AsyncNameResolver::operator==(const AsyncNameResolver& resolver) const
+{
+  return this == &resolver;
 }
 
 #ifdef HAVE_ARES_ADDR_NODE
@@ -162,4 +354,30 @@ ares_addr_node* parseAsyncDNSServers(const std::string& serversOpt)
 
 #endif // HAVE_ARES_ADDR_NODE
 
+#ifndef HAVE_LIBCARES
+
+std::vector<std::pair<std::string, uint16_t>>
+parseAsyncDNSServers(const std::string& serversOpt)
+{
+  std::vector<std::string> servers;
+  util::split(std::begin(serversOpt), std::end(serversOpt),
+              std::back_inserter(servers), ',', true /* doStrip */);
+  std::vector<std::pair<std::string, uint16_t>> res;
+  for (const auto& s : servers) {
+    unsigned char binAddr[sizeof(struct in6_addr)];
+    size_t len = net::getBinAddr(binAddr, s);
+    if (len == 0) {
+      continue;
+    }
+    char addrstring[NI_MAXHOST];
+    if (inetNtop(len == 4 ? AF_INET : AF_INET6, binAddr, addrstring,
+                 sizeof(addrstring)) == 0) {
+      res.emplace_back(addrstring, 53);
+    }
+  }
+  return res;
+}
+
+#endif // !HAVE_LIBCARES
+
 } // namespace aria2
@@ -39,16 +39,36 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 
-#include <ares.h>
+#ifdef HAVE_LIBCARES
+#  include <ares.h>
+#endif // HAVE_LIBCARES
 
 #include "a2netcompat.h"
 
+#ifndef HAVE_LIBCARES
+// Without c-ares, the built-in DNSStubResolver is used.  These mimic
+// the c-ares definitions used by the event polls.
+typedef sock_t ares_socket_t;
+#  define ARES_SOCKET_BAD ((sock_t)-1)
+#  define ARES_GETSOCK_MAXNUM 16
+#  define ARES_GETSOCK_READABLE(bits, num) (bits & (1 << (num)))
+#  define ARES_GETSOCK_WRITABLE(bits, num)                                     \
+    (bits & (1 << ((num) + ARES_GETSOCK_MAXNUM)))
+#endif // !HAVE_LIBCARES
+
 namespace aria2 {
 
+#ifndef HAVE_LIBCARES
+class DNSStubResolver;
+#endif // !HAVE_LIBCARES
+
 class AsyncNameResolver {
+#ifdef HAVE_LIBCARES
   friend void callback(void* arg, int status, int timeouts,
-                       struct hostent* host);
+                       unsigned char* abuf, int alen);
+#endif // HAVE_LIBCARES
 
 public:
   enum STATUS {
@@ -61,10 +81,25 @@ public:
 private:
   STATUS status_;
   int family_;
+#ifdef HAVE_LIBCARES
   ares_channel channel_;
+#else  // !HAVE_LIBCARES
+  // Name servers given by --async-dns-server.  If empty, the ones in
+  // /etc/resolv.conf are used.
+  std::vector<std::pair<std::string, uint16_t>> servers_;
+  std::unique_ptr<DNSStubResolver> stub_;
+
+  // Copies the result of stub_ once it is done.
+  void updateStatus();
+#endif // !HAVE_LIBCARES
 
   std::vector<std::string> resolvedAddresses_;
+  // TTL of each address in resolvedAddresses_.  -1 if it is unknown.
+  std::vector<int> resolvedTTLs_;
   std::string error_;
+  // c-ares status code of the failed lookup, or
+  // DNSStubResolver::ERROR_CODE without c-ares.
+  int errorCode_;
   std::string hostname_;
 
 public:
@@ -73,6 +108,11 @@ public:
                     ,
                     ares_addr_node* servers
 #endif // HAVE_ARES_ADDR_NODE
+#ifndef HAVE_LIBCARES
+                    ,
+                    std::vector<std::pair<std::string, uint16_t>> servers =
+                        std::vector<std::pair<std::string, uint16_t>>()
+#endif // !HAVE_LIBCARES
   );
 
   ~AsyncNameResolver();
@@ -84,8 +124,15 @@ public:
     return resolvedAddresses_;
   }
 
+  const std::vector<int>& getResolvedTTLs() const { return resolvedTTLs_; }
+
   const std::string& getError() const { return error_; }
 
+  // Returns true if the lookup failed because the name does not exist
+  // or has no record of the requested family (NXDOMAIN, NODATA), or
+  // the server failed (SERVFAIL).  Such answers can be cached.
+  bool isNegativeAnswer() const;
+
   STATUS getStatus() const { return status_; }
 
   int getFds(fd_set* rfdsPtr, fd_set* wfdsPtr) const;
@@ -93,14 +140,11 @@ public:
   void process(fd_set* rfdsPtr, fd_set* wfdsPtr);
 
   int getFamily() const { return family_; }
-#ifdef HAVE_LIBCARES
 
   int getsock(sock_t* sockets) const;
 
   void process(ares_socket_t readfd, ares_socket_t writefd);
 
-#endif // HAVE_LIBCARES
-
   bool operator==(const AsyncNameResolver& resolver) const;
 
   void setAddr(const std::string& addrString);
@@ -116,6 +160,15 @@ ares_addr_node* parseAsyncDNSServers(const std::string& serversOpt);
 
 #endif // HAVE_ARES_ADDR_NODE
 
+#ifndef HAVE_LIBCARES
+
+// Parses comma separated list of numeric addresses of name servers.
+// Invalid addresses are ignored.
+std::vector<std::pair<std::string, uint16_t>>
+parseAsyncDNSServers(const std::string& serversOpt);
+
+#endif // !HAVE_LIBCARES
+
 } // namespace aria2
 
 #endif // D_ASYNC_NAME_RESOLVER_H
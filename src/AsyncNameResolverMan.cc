@@ -93,6 +93,10 @@ void AsyncNameResolverMan::startAsyncFamily(const std::string& hostname,
                                           ,
                                           e->getAsyncDNSServers()
 #endif // HAVE_ARES_ADDR_NODE
+#ifndef HAVE_LIBCARES
+                                          ,
+                                          e->getAsyncDNSServers()
+#endif // !HAVE_LIBCARES
       );
   asyncNameResolver_[numResolver_]->resolve(hostname);
   setNameResolverCheck(numResolver_, e, command);
@@ -111,6 +115,20 @@ void AsyncNameResolverMan::getResolvedAddress(
   return;
 }
 
+void AsyncNameResolverMan::getResolvedAddress(std::vector<std::string>& res,
+                                              std::vector<int>& ttls) const
+{
+  for (size_t i = 0; i < numResolver_; ++i) {
+    if (asyncNameResolver_[i]->getStatus() ==
+        AsyncNameResolver::STATUS_SUCCESS) {
+      auto& addrs = asyncNameResolver_[i]->getResolvedAddresses();
+      auto& addrTTLs = asyncNameResolver_[i]->getResolvedTTLs();
+      res.insert(std::end(res), std::begin(addrs), std::end(addrs));
+      ttls.insert(std::end(ttls), std::begin(addrTTLs), std::end(addrTTLs));
+    }
+  }
+}
+
 void AsyncNameResolverMan::setNameResolverCheck(DownloadEngine* e,
                                                 Command* command)
 {
@@ -194,6 +212,19 @@ const std::string& AsyncNameResolverMan::getLastError() const
   return A2STR::NIL;
 }
 
+bool AsyncNameResolverMan::isNegativeAnswer() const
+{
+  if (numResolver_ == 0) {
+    return false;
+  }
+  for (size_t i = 0; i < numResolver_; ++i) {
+    if (!asyncNameResolver_[i]->isNegativeAnswer()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void AsyncNameResolverMan::reset(DownloadEngine* e, Command* command)
 {
   disableNameResolverCheck(e, command);
@@ -65,6 +65,10 @@ public:
                   Command* command);
   // Appends resolved addresses to |res|.
   void getResolvedAddress(std::vector<std::string>& res) const;
+  // Appends resolved addresses to |res| and their TTL to |ttls|.  The
+  // TTL is -1 if it is unknown.
+  void getResolvedAddress(std::vector<std::string>& res,
+                          std::vector<int>& ttls) const;
   // Adds resolvers to DownloadEngine to check event notification.
   void setNameResolverCheck(DownloadEngine* e, Command* command);
   // Removes resolvers from DownloadEngine.
@@ -76,6 +80,9 @@ public:
   int getStatus() const;
   // Returns last error string
   const std::string& getLastError() const;
+  // Returns true if all resolvers failed with the answer which can be
+  // cached as negative, such as NXDOMAIN.
+  bool isNegativeAnswer() const;
   // Resets state. Also removes resolvers from DownloadEngine.
   void reset(DownloadEngine* e, Command* command);
 
@@ -45,6 +45,11 @@
 
 namespace aria2 {
 
+namespace {
+// The delay before trying the IPv4 address.
+constexpr auto INITIAL_TIMEOUT = 300_ms;
+} // namespace
+
 BackupConnectInfo::BackupConnectInfo() : cancel(false) {}
 
 BackupIPv4ConnectCommand::BackupIPv4ConnectCommand(
@@ -113,13 +118,15 @@ bool BackupIPv4ConnectCommand::execute()
         retval = true;
       }
     }
+    else if (timeoutCheck_.difference(global::wallclock()) >= timeout_) {
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - Backup connection command timeout",
+                      getCuid()));
+      retval = true;
+    }
   }
-  else if (!socket_) {
-    // TODO Although we check 300ms initial timeout as described in
-    // RFC 6555, the interval will be much longer and around 1 second
-    // due to the refresh interval mechanism in DownloadEngine.
-    if (startTime_.difference(global::wallclock()) >=
-        std::chrono::milliseconds(300)) {
+  else {
+    // We check 300ms initial timeout as described in RFC 6555.
+    if (startTime_.difference(global::wallclock()) >= INITIAL_TIMEOUT) {
       socket_ = std::make_shared<SocketCore>();
       try {
         socket_->establishConnection(ipaddr_, port_);
@@ -134,12 +141,17 @@ bool BackupIPv4ConnectCommand::execute()
       }
     }
   }
-  else if (timeoutCheck_.difference(global::wallclock()) >= timeout_) {
-    A2_LOG_INFO(
-        fmt("CUID#%" PRId64 " - Backup connection command timeout", getCuid()));
-    retval = true;
-  }
   if (!retval) {
+    if (socket_) {
+      // mainCommand_ does not wake this command up when it cancels
+      // this command.
+      setWakeupTimeAfter(1_s);
+    }
+    else {
+      auto t = startTime_;
+      t.advance(INITIAL_TIMEOUT);
+      setWakeupTime(t);
+    }
     e_->addCommand(std::unique_ptr<Command>(this));
   }
   return retval;
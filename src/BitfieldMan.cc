@@ -66,6 +66,7 @@ BitfieldMan::BitfieldMan(int32_t blockLength, int64_t totalLength)
     useBitfield_ = new unsigned char[bitfieldLength_];
     memset(bitfield_, 0, bitfieldLength_);
     memset(useBitfield_, 0, bitfieldLength_);
+    updateFreeSummary();
     updateCache();
   }
 }
@@ -91,6 +92,7 @@ BitfieldMan::BitfieldMan(const BitfieldMan& bitfieldMan)
     filterBitfield_ = new unsigned char[bitfieldLength_];
     memcpy(filterBitfield_, bitfieldMan.filterBitfield_, bitfieldLength_);
   }
+  updateFreeSummary();
   updateCache();
 }
 
@@ -120,6 +122,7 @@ BitfieldMan& BitfieldMan::operator=(const BitfieldMan& bitfieldMan)
       filterBitfield_ = nullptr;
     }
 
+    updateFreeSummary();
     updateCache();
   }
   return *this;
@@ -156,48 +159,41 @@ bool BitfieldMan::hasMissingPiece(const unsigned char* peerBitfield,
   if (bitfieldLength_ != length) {
     return false;
   }
-  bool retval = false;
-  for (size_t i = 0; i < bitfieldLength_; ++i) {
-    unsigned char temp = peerBitfield[i] & ~bitfield_[i];
-    if (filterEnabled_) {
-      temp &= filterBitfield_[i];
-    }
-    if (temp & 0xffu) {
-      retval = true;
-      break;
-    }
+  if (filterEnabled_) {
+    return bitfield::anySetBit(array(peerBitfield) & ~array(bitfield_) &
+                                   array(filterBitfield_),
+                               blocks_);
+  }
+  else {
+    return bitfield::anySetBit(array(peerBitfield) & ~array(bitfield_),
+                               blocks_);
   }
-  return retval;
 }
 
 bool BitfieldMan::getFirstMissingUnusedIndex(size_t& index) const
 {
-  if (filterEnabled_) {
-    return bitfield::getFirstSetBitIndex(
-        index,
-        ~array(bitfield_) & ~array(useBitfield_) & array(filterBitfield_),
-        blocks_);
-  }
-  else {
-    return bitfield::getFirstSetBitIndex(
-        index, ~array(bitfield_) & ~array(useBitfield_), blocks_);
+  size_t i = freeSummary_.next(0);
+  if (i == freeSummary_.size()) {
+    return false;
   }
+  index = i * 64 + bitfield::countLeadingZero64(getFreeWord(i));
+  return true;
 }
 
 size_t BitfieldMan::getFirstNMissingUnusedIndex(std::vector<size_t>& out,
                                                 size_t n) const
 {
-  if (filterEnabled_) {
-    return bitfield::getFirstNSetBitIndex(
-        std::back_inserter(out), n,
-        ~array(bitfield_) & ~array(useBitfield_) & array(filterBitfield_),
-        blocks_);
-  }
-  else {
-    return bitfield::getFirstNSetBitIndex(
-        std::back_inserter(out), n, ~array(bitfield_) & ~array(useBitfield_),
-        blocks_);
+  size_t count = 0;
+  for (size_t i = freeSummary_.next(0); count < n && i < freeSummary_.size();
+       i = freeSummary_.next(i + 1)) {
+    uint64_t v = getFreeWord(i);
+    for (; count < n && v; ++count) {
+      size_t c = bitfield::countLeadingZero64(v);
+      out.push_back(i * 64 + c);
+      v ^= 0x8000000000000000llu >> c;
+    }
   }
+  return count;
 }
 
 bool BitfieldMan::getFirstMissingIndex(size_t& index) const
@@ -212,29 +208,70 @@ bool BitfieldMan::getFirstMissingIndex(size_t& index) const
 }
 
 namespace {
+// Returns the first index at or after index whose bit is not set in
+// bitfield, or blocks if there is no such index.  The words which
+// summary marks empty are skipped, so summary must not mark a word
+// empty if it contains such a bit.
 template <typename Array>
-size_t getStartIndex(size_t index, const Array& bitfield, size_t blocks)
+size_t getStartIndex(size_t index, const Array& bitfield, size_t blocks,
+                     const BitfieldSummary& summary)
 {
-  while (index < blocks && bitfield::test(bitfield, blocks, index)) {
-    ++index;
-  }
-  if (blocks <= index) {
-    return blocks;
-  }
-  else {
-    return index;
+  while (index < blocks) {
+    size_t w = summary.next(index / 64);
+    if (w * 64 >= blocks) {
+      return blocks;
+    }
+    if (w != index / 64) {
+      index = w * 64;
+    }
+    size_t end = std::min(blocks, (w + 1) * 64);
+    if (end == (w + 1) * 64) {
+      uint64_t v =
+          ~bitfield::wordToBitOrder(bitfield::getWord(bitfield, w)) &
+          (UINT64_MAX >> (index % 64));
+      if (v) {
+        return w * 64 + bitfield::countLeadingZero64(v);
+      }
+    }
+    else {
+      for (; index < end; ++index) {
+        if (!bitfield::test(bitfield, blocks, index)) {
+          return index;
+        }
+      }
+    }
+    index = end;
   }
+  return blocks;
 }
 } // namespace
 
 namespace {
+// Returns the first index in [index, limit) whose bit is set in
+// bitfield, or limit if there is no such index.  limit must be less
+// than or equal to blocks.
 template <typename Array>
-size_t getEndIndex(size_t index, const Array& bitfield, size_t blocks)
-{
-  while (index < blocks && !bitfield::test(bitfield, blocks, index)) {
-    ++index;
+size_t getEndIndex(size_t index, size_t limit, const Array& bitfield,
+                   size_t blocks)
+{
+  while (index < limit) {
+    size_t w = index / 64;
+    if ((w + 1) * 64 <= blocks) {
+      uint64_t v = bitfield::wordToBitOrder(bitfield::getWord(bitfield, w)) &
+                   (UINT64_MAX >> (index % 64));
+      if (v) {
+        return std::min(limit, w * 64 + bitfield::countLeadingZero64(v));
+      }
+      index = (w + 1) * 64;
+    }
+    else if (bitfield::test(bitfield, blocks, index)) {
+      return index;
+    }
+    else {
+      ++index;
+    }
   }
-  return index;
+  return limit;
 }
 } // namespace
 
@@ -243,18 +280,20 @@ template <typename Array>
 bool getSparseMissingUnusedIndex(size_t& index, int32_t minSplitSize,
                                  const Array& bitfield,
                                  const unsigned char* useBitfield,
-                                 int32_t blockLength, size_t blocks)
+                                 int32_t blockLength, size_t blocks,
+                                 const BitfieldSummary& summary)
 {
   BitfieldMan::Range maxRange;
   BitfieldMan::Range currentRange;
   size_t nextIndex = 0;
   while (nextIndex < blocks) {
-    currentRange.startIndex = getStartIndex(nextIndex, bitfield, blocks);
+    currentRange.startIndex =
+        getStartIndex(nextIndex, bitfield, blocks, summary);
     if (currentRange.startIndex == blocks) {
       break;
     }
     currentRange.endIndex =
-        getEndIndex(currentRange.startIndex, bitfield, blocks);
+        getEndIndex(currentRange.startIndex, blocks, bitfield, blocks);
 
     if (currentRange.startIndex > 0) {
       if (bitfield::test(useBitfield, blocks, currentRange.startIndex - 1)) {
@@ -308,13 +347,13 @@ bool BitfieldMan::getSparseMissingUnusedIndex(
         index, minSplitSize,
         array(ignoreBitfield) | ~array(filterBitfield_) | array(bitfield_) |
             array(useBitfield_),
-        useBitfield_, blockLength_, blocks_);
+        useBitfield_, blockLength_, blocks_, freeSummary_);
   }
   else {
     return aria2::getSparseMissingUnusedIndex(
         index, minSplitSize,
         array(ignoreBitfield) | array(bitfield_) | array(useBitfield_),
-        useBitfield_, blockLength_, blocks_);
+        useBitfield_, blockLength_, blocks_, freeSummary_);
   }
 }
 
@@ -324,24 +363,18 @@ bool getGeomMissingUnusedIndex(size_t& index, int32_t minSplitSize,
                                const Array& bitfield,
                                const unsigned char* useBitfield,
                                int32_t blockLength, size_t blocks, double base,
-                               size_t offsetIndex)
+                               size_t offsetIndex,
+                               const BitfieldSummary& summary)
 {
   double start = 0;
   double end = 1;
   while (start + offsetIndex < blocks) {
-    index = blocks;
-    for (size_t i = start + offsetIndex,
-                eoi = std::min(blocks, static_cast<size_t>(end + offsetIndex));
-         i < eoi; ++i) {
-      if (bitfield::test(useBitfield, blocks, i)) {
-        break;
-      }
-      else if (!bitfield::test(bitfield, blocks, i)) {
-        index = i;
-        break;
-      }
-    }
-    if (index < blocks) {
+    size_t eoi = std::min(blocks, static_cast<size_t>(end + offsetIndex));
+    // Find the first block which is either used or available.
+    size_t i = getEndIndex(static_cast<size_t>(start + offsetIndex), eoi,
+                           array(useBitfield) | ~bitfield, blocks);
+    if (i < eoi && !bitfield::test(useBitfield, blocks, i)) {
+      index = i;
       return true;
     }
     else {
@@ -350,7 +383,7 @@ bool getGeomMissingUnusedIndex(size_t& index, int32_t minSplitSize,
     }
   }
   return getSparseMissingUnusedIndex(index, minSplitSize, bitfield, useBitfield,
-                                     blockLength, blocks);
+                                     blockLength, blocks, summary);
 }
 } // namespace
 
@@ -365,13 +398,13 @@ bool BitfieldMan::getGeomMissingUnusedIndex(size_t& index, int32_t minSplitSize,
         index, minSplitSize,
         array(ignoreBitfield) | ~array(filterBitfield_) | array(bitfield_) |
             array(useBitfield_),
-        useBitfield_, blockLength_, blocks_, base, offsetIndex);
+        useBitfield_, blockLength_, blocks_, base, offsetIndex, freeSummary_);
   }
   else {
     return aria2::getGeomMissingUnusedIndex(
         index, minSplitSize,
         array(ignoreBitfield) | array(bitfield_) | array(useBitfield_),
-        useBitfield_, blockLength_, blocks_, base, offsetIndex);
+        useBitfield_, blockLength_, blocks_, base, offsetIndex, freeSummary_);
   }
 }
 
@@ -381,7 +414,8 @@ bool getInorderMissingUnusedIndex(size_t& index, size_t startIndex,
                                   size_t lastIndex, int32_t minSplitSize,
                                   const Array& bitfield,
                                   const unsigned char* useBitfield,
-                                  int32_t blockLength, size_t blocks)
+                                  int32_t blockLength, size_t blocks,
+                                  const BitfieldSummary& summary)
 {
   // We always return first piece if it is available.
   if (!bitfield::test(bitfield, blocks, startIndex) &&
@@ -389,34 +423,34 @@ bool getInorderMissingUnusedIndex(size_t& index, size_t startIndex,
     index = startIndex;
     return true;
   }
+  // The number of consecutive free blocks needed to satisfy
+  // minSplitSize.
+  size_t splitBlocks = 1;
+  if (minSplitSize > blockLength) {
+    splitBlocks = (static_cast<int64_t>(minSplitSize) + blockLength - 1) /
+                  blockLength;
+  }
   for (size_t i = startIndex + 1; i < lastIndex;) {
-    if (!bitfield::test(bitfield, blocks, i) &&
-        !bitfield::test(useBitfield, blocks, i)) {
-      // If previous piece has already been retrieved, we can download
-      // from this index.
-      if (!bitfield::test(useBitfield, blocks, i - 1) &&
-          bitfield::test(bitfield, blocks, i - 1)) {
-        index = i;
-        return true;
-      }
-      // Check free space of minSplitSize.  When checking this, we use
-      // blocks instead of lastIndex.
-      size_t j;
-      for (j = i; j < blocks; ++j) {
-        if (bitfield::test(bitfield, blocks, j) ||
-            bitfield::test(useBitfield, blocks, j)) {
-          break;
-        }
-        if (static_cast<int64_t>(j - i + 1) * blockLength >= minSplitSize) {
-          index = j;
-          return true;
-        }
-      }
-      i = j + 1;
+    i = getStartIndex(i, bitfield, blocks, summary);
+    if (i >= lastIndex) {
+      break;
     }
-    else {
-      ++i;
+    // If previous piece has already been retrieved, we can download
+    // from this index.
+    if (!bitfield::test(useBitfield, blocks, i - 1) &&
+        bitfield::test(bitfield, blocks, i - 1)) {
+      index = i;
+      return true;
     }
+    // Check free space of minSplitSize.  When checking this, we use
+    // blocks instead of lastIndex.
+    size_t j =
+        getEndIndex(i, std::min(blocks, i + splitBlocks), bitfield, blocks);
+    if (j - i == splitBlocks) {
+      index = j - 1;
+      return true;
+    }
+    i = j + 1;
   }
   return false;
 }
@@ -431,13 +465,13 @@ bool BitfieldMan::getInorderMissingUnusedIndex(
         index, 0, blocks_, minSplitSize,
         array(ignoreBitfield) | ~array(filterBitfield_) | array(bitfield_) |
             array(useBitfield_),
-        useBitfield_, blockLength_, blocks_);
+        useBitfield_, blockLength_, blocks_, freeSummary_);
   }
   else {
     return aria2::getInorderMissingUnusedIndex(
         index, 0, blocks_, minSplitSize,
         array(ignoreBitfield) | array(bitfield_) | array(useBitfield_),
-        useBitfield_, blockLength_, blocks_);
+        useBitfield_, blockLength_, blocks_, freeSummary_);
   }
 }
 
@@ -451,13 +485,13 @@ bool BitfieldMan::getInorderMissingUnusedIndex(
         index, startIndex, endIndex, minSplitSize,
         array(ignoreBitfield) | ~array(filterBitfield_) | array(bitfield_) |
             array(useBitfield_),
-        useBitfield_, blockLength_, blocks_);
+        useBitfield_, blockLength_, blocks_, freeSummary_);
   }
   else {
     return aria2::getInorderMissingUnusedIndex(
         index, startIndex, endIndex, minSplitSize,
         array(ignoreBitfield) | array(bitfield_) | array(useBitfield_),
-        useBitfield_, blockLength_, blocks_);
+        useBitfield_, blockLength_, blocks_, freeSummary_);
   }
 }
 
@@ -465,15 +499,23 @@ namespace {
 template <typename Array>
 bool copyBitfield(unsigned char* dst, const Array& src, size_t blocks)
 {
+  uint64_t wbits = 0;
+  size_t nwords = blocks / 64;
+  for (size_t i = 0; i < nwords; ++i) {
+    uint64_t v = bitfield::getWord(src, i);
+    memcpy(dst + i * sizeof(v), &v, sizeof(v));
+    wbits |= v;
+  }
   unsigned char bits = 0;
   size_t len = (blocks + 7) / 8;
-  for (size_t i = 0; i < len - 1; ++i) {
+  for (size_t i = nwords * 8; i < len; ++i) {
     dst[i] = src[i];
+    if (i == len - 1) {
+      dst[i] &= bitfield::lastByteMask(blocks);
+    }
     bits |= dst[i];
   }
-  dst[len - 1] = src[len - 1] & bitfield::lastByteMask(blocks);
-  bits |= dst[len - 1];
-  return bits != 0;
+  return wbits != 0 || bits != 0;
 }
 } // namespace
 
@@ -538,8 +580,7 @@ size_t BitfieldMan::countMissingBlock() const { return cachedNumMissingBlock_; }
 size_t BitfieldMan::countMissingBlockNow() const
 {
   if (filterEnabled_) {
-    return bitfield::countSetBit(filterBitfield_, blocks_) -
-           bitfield::countSetBitSlow(array(bitfield_) & array(filterBitfield_),
+    return bitfield::countSetBitSlow(array(filterBitfield_) & ~array(bitfield_),
                                      blocks_);
   }
   else {
@@ -557,6 +598,45 @@ size_t BitfieldMan::countFilteredBlockNow() const
   }
 }
 
+uint64_t BitfieldMan::getFreeWord(size_t i) const
+{
+  uint64_t v;
+  if ((i + 1) * 8 <= bitfieldLength_) {
+    v = ~bitfield::getWord(bitfield_, i) & ~bitfield::getWord(useBitfield_, i);
+    if (filterEnabled_) {
+      v &= bitfield::getWord(filterBitfield_, i);
+    }
+  }
+  else {
+    unsigned char buf[sizeof(v)] = {};
+    for (size_t j = i * 8; j < bitfieldLength_; ++j) {
+      buf[j - i * 8] = ~bitfield_[j] & ~useBitfield_[j] &
+                       (filterEnabled_ ? filterBitfield_[j] : 0xffu);
+    }
+    memcpy(&v, buf, sizeof(v));
+  }
+  v = bitfield::wordToBitOrder(v);
+  if ((i + 1) * 64 > blocks_) {
+    // Clear the bits beyond the last block
+    v &= ~(UINT64_MAX >> (blocks_ % 64));
+  }
+  return v;
+}
+
+void BitfieldMan::updateFreeSummary(size_t i)
+{
+  freeSummary_.set(i, getFreeWord(i) != 0);
+}
+
+void BitfieldMan::updateFreeSummary()
+{
+  size_t nwords = (blocks_ + 63) / 64;
+  freeSummary_.reset(nwords);
+  for (size_t i = 0; i < nwords; ++i) {
+    updateFreeSummary(i);
+  }
+}
+
 bool BitfieldMan::setBitInternal(unsigned char* bitfield, size_t index, bool on)
 {
   if (blocks_ <= index) {
@@ -569,6 +649,7 @@ bool BitfieldMan::setBitInternal(unsigned char* bitfield, size_t index, bool on)
   else {
     bitfield[index / 8] &= ~mask;
   }
+  updateFreeSummary(index / 64);
   return true;
 }
 
@@ -599,12 +680,8 @@ bool BitfieldMan::unsetBit(size_t index)
 bool BitfieldMan::isFilteredAllBitSet() const
 {
   if (filterEnabled_) {
-    for (size_t i = 0; i < bitfieldLength_; ++i) {
-      if ((bitfield_[i] & filterBitfield_[i]) != filterBitfield_[i]) {
-        return false;
-      }
-    }
-    return true;
+    return !bitfield::anySetBit(array(filterBitfield_) & ~array(bitfield_),
+                                blocks_);
   }
   else {
     return isAllBitSet();
@@ -617,12 +694,19 @@ bool testAllBitSet(const unsigned char* bitfield, size_t length, size_t blocks)
   if (length == 0) {
     return true;
   }
-  for (size_t i = 0; i < length - 1; ++i) {
+  size_t nwords = blocks / 64;
+  for (size_t i = 0; i < nwords; ++i) {
+    if (bitfield::getWord(bitfield, i) != UINT64_MAX) {
+      return false;
+    }
+  }
+  for (size_t i = nwords * 8; i < length - 1; ++i) {
     if (bitfield[i] != 0xffu) {
       return false;
     }
   }
-  return bitfield[length - 1] == bitfield::lastByteMask(blocks);
+  return length == nwords * 8 ||
+         bitfield[length - 1] == bitfield::lastByteMask(blocks);
 }
 } // namespace
 
@@ -667,12 +751,14 @@ void BitfieldMan::setBitfield(const unsigned char* bitfield,
   }
   memcpy(bitfield_, bitfield, bitfieldLength_);
   memset(useBitfield_, 0, bitfieldLength_);
+  updateFreeSummary();
   updateCache();
 }
 
 void BitfieldMan::clearAllBit()
 {
   memset(bitfield_, 0, bitfieldLength_);
+  updateFreeSummary();
   updateCache();
 }
 
@@ -687,6 +773,7 @@ void BitfieldMan::setAllBit()
 void BitfieldMan::clearAllUseBit()
 {
   memset(useBitfield_, 0, bitfieldLength_);
+  updateFreeSummary();
   updateCache();
 }
 
@@ -759,12 +846,14 @@ void BitfieldMan::enableFilter()
 {
   ensureFilterBitfield();
   filterEnabled_ = true;
+  updateFreeSummary();
   updateCache();
 }
 
 void BitfieldMan::disableFilter()
 {
   filterEnabled_ = false;
+  updateFreeSummary();
   updateCache();
 }
 
@@ -775,6 +864,7 @@ void BitfieldMan::clearFilter()
     filterBitfield_ = nullptr;
   }
   filterEnabled_ = false;
+  updateFreeSummary();
   updateCache();
 }
 
@@ -39,6 +39,8 @@
 
 #include <vector>
 
+#include "BitfieldSummary.h"
+
 namespace aria2 {
 
 class BitfieldMan {
@@ -61,6 +63,22 @@ private:
 
   bool filterEnabled_;
 
+  // Summary of the 64 blocks words which contain a block which is
+  // missing, unused and, if filter is enabled, filtered.  Lookups use
+  // it to skip the blocks which can never be selected.
+  BitfieldSummary freeSummary_;
+
+  // Returns i-th 64 blocks word of missing, unused and, if filter is
+  // enabled, filtered blocks.  The most significant bit represents the
+  // block at 64 * i.
+  uint64_t getFreeWord(size_t i) const;
+
+  // Updates freeSummary_ for i-th word.
+  void updateFreeSummary(size_t i);
+
+  // Rebuilds whole freeSummary_.
+  void updateFreeSummary();
+
   bool setBitInternal(unsigned char* bitfield, size_t index, bool on);
   bool setFilterBit(size_t index);
 
@@ -0,0 +1,105 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BitfieldSummary.h"
+
+#include "bitfield.h"
+
+namespace aria2 {
+
+namespace {
+const uint64_t TOP_BIT = 0x8000000000000000llu;
+} // namespace
+
+BitfieldSummary::BitfieldSummary() : nwords_(0) {}
+
+void BitfieldSummary::reset(size_t nwords)
+{
+  nwords_ = nwords;
+  level1_.assign((nwords + 63) / 64, 0);
+  level2_.assign((level1_.size() + 63) / 64, 0);
+}
+
+void BitfieldSummary::set(size_t i, bool nonEmpty)
+{
+  assert(i < nwords_);
+  uint64_t& w = level1_[i / 64];
+  if (nonEmpty) {
+    w |= TOP_BIT >> (i % 64);
+  }
+  else {
+    w &= ~(TOP_BIT >> (i % 64));
+  }
+  size_t j = i / 64;
+  if (w) {
+    level2_[j / 64] |= TOP_BIT >> (j % 64);
+  }
+  else {
+    level2_[j / 64] &= ~(TOP_BIT >> (j % 64));
+  }
+}
+
+bool BitfieldSummary::test(size_t i) const
+{
+  assert(i < nwords_);
+  return level1_[i / 64] & (TOP_BIT >> (i % 64));
+}
+
+size_t BitfieldSummary::next(size_t i) const
+{
+  if (i >= nwords_) {
+    return nwords_;
+  }
+  size_t j = i / 64;
+  uint64_t w = level1_[j] & (UINT64_MAX >> (i % 64));
+  if (w) {
+    return j * 64 + bitfield::countLeadingZero64(w);
+  }
+  // Find the next non-zero word of the first level using the second
+  // level.
+  ++j;
+  for (size_t k = j / 64; k < level2_.size(); ++k) {
+    uint64_t v = level2_[k];
+    if (k == j / 64) {
+      v &= UINT64_MAX >> (j % 64);
+    }
+    if (v) {
+      size_t l = k * 64 + bitfield::countLeadingZero64(v);
+      return l * 64 + bitfield::countLeadingZero64(level1_[l]);
+    }
+  }
+  return nwords_;
+}
+
+} // namespace aria2
@@ -0,0 +1,79 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_BITFIELD_SUMMARY_H
+#define D_BITFIELD_SUMMARY_H
+
+#include "common.h"
+
+#include <vector>
+
+namespace aria2 {
+
+// Two level summary of a bitfield, which tracks the 64 bits words
+// containing at least one bit of interest.  Bit i of the first level
+// is set if word i is not empty, and bit j of the second level is set
+// if the j-th 64 bits word of the first level is not 0.  In both
+// levels, the bit for the lowest index is the most significant bit.
+class BitfieldSummary {
+public:
+  BitfieldSummary();
+
+  // Resizes the summary to cover nwords words, all of which are
+  // empty.
+  void reset(size_t nwords);
+
+  // Marks i-th word as non-empty if nonEmpty is true.  Otherwise
+  // marks it as empty.
+  void set(size_t i, bool nonEmpty);
+
+  // Returns true if i-th word is marked as non-empty.
+  bool test(size_t i) const;
+
+  // Returns the smallest index of non-empty word, which is greater than
+  // or equal to i.  If there is no such word, returns size().
+  size_t next(size_t i) const;
+
+  // Returns the number of words this summary covers.
+  size_t size() const { return nwords_; }
+
+private:
+  std::vector<uint64_t> level1_;
+  std::vector<uint64_t> level2_;
+  size_t nwords_;
+};
+
+} // namespace aria2
+
+#endif // D_BITFIELD_SUMMARY_H
@@ -42,6 +42,7 @@
 
 #include "a2time.h"
 #include "a2functional.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
@@ -119,6 +120,11 @@ public:
 
   virtual void overrideMinInterval(std::chrono::seconds interval) = 0;
 
+  /**
+   * Returns the time when the regular announce becomes ready.
+   */
+  virtual Timer getNextAnnounceTime() = 0;
+
   virtual void setTcpPort(uint16_t port) = 0;
 
   static const std::string FAILURE_REASON;
@@ -58,9 +58,12 @@
 #include "PeerStorage.h"
 #include "array_fun.h"
 #include "WrDiskCache.h"
+#include "RdDiskCache.h"
+#include "RequestGroup.h"
 #include "WrDiskCacheEntry.h"
 #include "DownloadFailureException.h"
 #include "BtRejectMessage.h"
+#include "SharedFd.h"
 
 namespace aria2 {
 
@@ -73,7 +76,8 @@ BtPieceMessage::BtPieceMessage(size_t index, int32_t begin, int32_t blockLength)
       blockLength_(blockLength),
       data_(nullptr),
       downloadContext_(nullptr),
-      peerStorage_(nullptr)
+      peerStorage_(nullptr),
+      workerPool_(nullptr)
 {
   setUploading(true);
 }
@@ -118,10 +122,11 @@ void BtPieceMessage::doReceivedAction()
     if (piece->getWrDiskCacheEntry()) {
       // Write Disk Cache enabled. Unfortunately, it incurs extra data
       // copy.
-      auto dataCopy = new unsigned char[blockLength_];
+      size_t capacity;
+      auto dataCopy = WrDiskCacheEntry::allocateData(blockLength_, capacity);
       memcpy(dataCopy, data_ + 9, blockLength_);
       piece->updateWrCache(getPieceStorage()->getWrDiskCache(), dataCopy, 0,
-                           blockLength_, blockLength_, offset);
+                           blockLength_, capacity, offset);
     }
     else {
       getPieceStorage()->getDiskAdaptor()->writeData(data_ + 9, blockLength_,
@@ -134,6 +139,9 @@ void BtPieceMessage::doReceivedAction()
     piece->updateHash(begin_, data_ + 9, blockLength_);
     getBtMessageDispatcher()->removeOutstandingRequest(slot);
     if (piece->pieceComplete()) {
+      if (checkPieceHashInWorker(piece)) {
+        return;
+      }
       if (checkPieceHash(piece)) {
         onNewPiece(piece);
       }
@@ -189,6 +197,10 @@ struct PieceSendUpdate : public ProgressUpdate {
       headerLength -= m;
       length -= m;
     }
+    // The speed is updated when the data is actually sent, since the
+    // data queued with sendfile(2) may stay in the queue for a while.
+    peer->updateUploadSpeed(length);
+    dctx->updateUploadSpeed(length);
     peer->updateUploadLength(length);
     dctx->updateUploadLength(length);
   }
@@ -215,18 +227,72 @@ void BtPieceMessage::send()
 void BtPieceMessage::pushPieceData(int64_t offset, int32_t length) const
 {
   assert(length <= static_cast<int32_t>(MAX_BLOCK_LENGTH));
+  auto peerConnection = getPeerConnection();
+  // The file does not have all the data of a piece which is not
+  // complete: some of them may be still in the write cache, or being
+  // written by DiskWriteQueue.  Take them from memory.
+  std::shared_ptr<Piece> piece;
+  if (!getPieceStorage()->hasPiece(index_)) {
+    piece = getPieceStorage()->getPiece(index_);
+    if (!piece->getWrDiskCacheEntry()) {
+      piece.reset();
+    }
+  }
+  if (!piece && peerConnection->isSendFileAvailable()) {
+    // Plaintext connection: send the block from the file with
+    // sendfile(2) instead of copying it into the send buffer.
+    // The blocks of the same file share one file descriptor.
+    int64_t fileOffset;
+    auto fd = getPieceStorage()->getDiskAdaptor()->shareReadFd(offset, length,
+                                                               fileOffset);
+    if (fd) {
+      auto header = std::vector<unsigned char>(MESSAGE_HEADER_LENGTH);
+      createMessageHeader(header.data());
+      peerConnection->pushBytes(std::move(header));
+      peerConnection->pushFile(
+          std::move(fd), fileOffset, length,
+          make_unique<PieceSendUpdate>(downloadContext_, getPeer(), 0));
+      return;
+    }
+  }
   auto buf = std::vector<unsigned char>(length + MESSAGE_HEADER_LENGTH);
   createMessageHeader(buf.data());
   ssize_t r;
-  r = getPieceStorage()->getDiskAdaptor()->readData(
-      buf.data() + MESSAGE_HEADER_LENGTH, length, offset);
+  // Serve the popular pieces from memory rather than reading the same
+  // blocks from disk for each peer.  Only the pieces which
+  // hasPiece() reports are cached: they are not complete until their
+  // data have been written to the file, so the cache never holds
+  // stale data.
+  auto rdDiskCache = getPieceStorage()->getRdDiskCache();
+  auto group = downloadContext_->getOwnerRequestGroup();
+  const unsigned char* pieceData = nullptr;
+  int64_t pieceOffset =
+      static_cast<int64_t>(index_) * downloadContext_->getPieceLength();
+  int32_t pieceLength = getPieceStorage()->getPieceLength(index_);
+  if (rdDiskCache && group && getPieceStorage()->hasPiece(index_) &&
+      offset >= pieceOffset && offset + length <= pieceOffset + pieceLength) {
+    pieceData =
+        rdDiskCache->get(group->getGID(), index_, pieceOffset, pieceLength,
+                         getPieceStorage()->getDiskAdaptor().get());
+  }
+  if (pieceData) {
+    memcpy(buf.data() + MESSAGE_HEADER_LENGTH,
+           pieceData + (offset - pieceOffset), length);
+    r = length;
+  }
+  else if (piece) {
+    r = piece->readDataWithWrCache(buf.data() + MESSAGE_HEADER_LENGTH, length,
+                                   offset, getPieceStorage()->getDiskAdaptor());
+  }
+  else {
+    r = getPieceStorage()->getDiskAdaptor()->readData(
+        buf.data() + MESSAGE_HEADER_LENGTH, length, offset);
+  }
   if (r == length) {
     const auto& peer = getPeer();
     getPeerConnection()->pushBytes(
         std::move(buf), make_unique<PieceSendUpdate>(downloadContext_, peer,
                                                      MESSAGE_HEADER_LENGTH));
-    peer->updateUploadSpeed(length);
-    downloadContext_->updateUploadSpeed(length);
   }
   else {
     throw DL_ABORT_EX(EX_DATA_READ);
@@ -262,6 +328,47 @@ bool BtPieceMessage::checkPieceHash(const std::shared_ptr<Piece>& piece)
   }
 }
 
+bool BtPieceMessage::checkPieceHashInWorker(
+    const std::shared_ptr<Piece>& piece)
+{
+  if (!getPieceStorage()->isEndGame() && piece->isHashCalculated()) {
+    // Only the digest is left to calculate.
+    return false;
+  }
+  auto pieceStorage = getPieceStorage();
+  auto peerStorage = peerStorage_;
+  auto expectedHash = downloadContext_->getPieceHash(piece->getIndex());
+  auto cuid = getCuid();
+  auto ipaddr = getPeer()->getIPAddress();
+  // This message and the peer connection may be gone when the
+  // callback is called.  The PieceStorage cancels the verification
+  // before pieceStorage and peerStorage are released.
+  return pieceStorage->verifyPieceInWorker(
+      piece, workerPool_,
+      [piece, pieceStorage, peerStorage, expectedHash, cuid,
+       ipaddr](const std::string& actualHash) {
+        if (actualHash == expectedHash) {
+          A2_LOG_INFO(fmt(MSG_GOT_NEW_PIECE, cuid,
+                          static_cast<unsigned long>(piece->getIndex())));
+          pieceStorage->completePiece(piece);
+          pieceStorage->advertisePiece(cuid, piece->getIndex(),
+                                       global::wallclock());
+          return;
+        }
+        if (actualHash.empty()) {
+          piece->clearAllBlock(pieceStorage->getWrDiskCache());
+        }
+        else {
+          A2_LOG_INFO(fmt(MSG_GOT_WRONG_PIECE, cuid,
+                          static_cast<unsigned long>(piece->getIndex())));
+          piece->clearAllBlock(pieceStorage->getWrDiskCache());
+          piece->destroyHashContext();
+          peerStorage->addBadPeer(ipaddr);
+        }
+        pieceStorage->cancelPiece(piece, cuid);
+      });
+}
+
 void BtPieceMessage::onNewPiece(const std::shared_ptr<Piece>& piece)
 {
   if (piece->getWrDiskCacheEntry()) {
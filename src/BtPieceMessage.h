@@ -42,6 +42,7 @@ namespace aria2 {
 class Piece;
 class DownloadContext;
 class PeerStorage;
+class WorkerPool;
 
 class BtPieceMessage : public AbstractBtMessage {
 private:
@@ -51,6 +52,7 @@ private:
   const unsigned char* data_;
   DownloadContext* downloadContext_;
   PeerStorage* peerStorage_;
+  WorkerPool* workerPool_;
 
   bool checkPieceHash(const std::shared_ptr<Piece>& piece);
 
@@ -58,6 +60,8 @@ private:
 
   void onWrongPiece(const std::shared_ptr<Piece>& piece);
 
+  bool checkPieceHashInWorker(const std::shared_ptr<Piece>& piece);
+
   void pushPieceData(int64_t offset, int32_t length) const;
 
 public:
@@ -91,6 +95,8 @@ public:
 
   void setPeerStorage(PeerStorage* peerStorage);
 
+  void setWorkerPool(WorkerPool* workerPool) { workerPool_ = workerPool; }
+
   static std::unique_ptr<BtPieceMessage> create(const unsigned char* data,
                                                 size_t dataLength);
 
@@ -45,6 +45,7 @@
 #include "RecoverableException.h"
 #include "util.h"
 #include "fmt.h"
+#include "WorkerPool.h"
 
 namespace aria2 {
 
@@ -54,17 +55,27 @@ CheckIntegrityCommand::CheckIntegrityCommand(cuid_t cuid,
                                              CheckIntegrityEntry* entry)
     : RealtimeCommand{cuid, requestGroup, e}, entry_{entry}
 {
+  entry_->setWorkerPool(e->getWorkerPool().get(), [this]() {
+    setStatusRealtime();
+    getDownloadEngine()->setNoWait(true);
+  });
 }
 
 CheckIntegrityCommand::~CheckIntegrityCommand()
 {
-  getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry();
+  getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry(entry_);
 }
 
 bool CheckIntegrityCommand::executeInternal()
 {
   if (getRequestGroup()->isHaltRequested()) {
-    return true;
+    if (!entry_->hasPendingJobs()) {
+      return true;
+    }
+    // Wait for the pieces being hashed in worker threads.
+    setStatusInactive();
+    getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
+    return false;
   }
   entry_->validateChunk();
   if (entry_->finished()) {
@@ -92,6 +103,10 @@ bool CheckIntegrityCommand::executeInternal()
     return true;
   }
   else {
+    if (entry_->isWaiting()) {
+      // Sleep until a piece hashed in a worker thread is ready.
+      setStatusInactive();
+    }
     getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
     return false;
   }
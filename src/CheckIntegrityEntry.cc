@@ -76,6 +76,24 @@ int64_t CheckIntegrityEntry::getCurrentLength()
 
 bool CheckIntegrityEntry::finished() { return validator_->finished(); }
 
+void CheckIntegrityEntry::setWorkerPool(WorkerPool* workerPool,
+                                        std::function<void()> wakeup)
+{
+  if (validator_) {
+    validator_->setWorkerPool(workerPool, std::move(wakeup));
+  }
+}
+
+bool CheckIntegrityEntry::isWaiting()
+{
+  return validator_ && validator_->isWaiting();
+}
+
+bool CheckIntegrityEntry::hasPendingJobs()
+{
+  return validator_ && validator_->hasPendingJobs();
+}
+
 void CheckIntegrityEntry::cutTrailingGarbage()
 {
   getRequestGroup()->getPieceStorage()->getDiskAdaptor()->cutTrailingGarbage();
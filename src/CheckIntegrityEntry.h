@@ -39,6 +39,7 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
 
 #include "ProgressAwareEntry.h"
 
@@ -46,6 +47,7 @@ namespace aria2 {
 
 class IteratableValidator;
 class DownloadEngine;
+class WorkerPool;
 class FileAllocationEntry;
 
 class CheckIntegrityEntry : public RequestGroupEntry,
@@ -75,6 +77,12 @@ public:
 
   virtual bool finished() CXX11_OVERRIDE;
 
+  void setWorkerPool(WorkerPool* workerPool, std::function<void()> wakeup);
+
+  bool isWaiting();
+
+  bool hasPendingJobs();
+
   virtual bool isValidationReady() = 0;
 
   virtual void initValidator() = 0;
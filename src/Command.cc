@@ -34,6 +34,8 @@
 /* copyright --> */
 #include "Command.h"
 #include "LogFactory.h"
+#include "DownloadEngine.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -43,10 +45,25 @@ Command::Command(cuid_t cuid)
       readEvent_(false),
       writeEvent_(false),
       errorEvent_(false),
-      hupEvent_(false)
+      hupEvent_(false),
+      wakeup_(true),
+      wakeupTime_(Timer::zero()),
+      engine_(nullptr),
+      routine_(false),
+      serial_(0),
+      ready_(false),
+      armed_(false),
+      armedTime_(Timer::zero())
 {
 }
 
+void Command::notifyReady()
+{
+  if (engine_) {
+    engine_->markCommandReady(this);
+  }
+}
+
 void Command::transitStatus()
 {
   switch (status_) {
@@ -57,15 +74,37 @@ void Command::transitStatus()
   }
 }
 
-void Command::setStatus(STATUS status) { status_ = status; }
+void Command::setStatus(STATUS status)
+{
+  status_ = status;
+  if (statusMatch(STATUS_ACTIVE)) {
+    notifyReady();
+  }
+}
 
-void Command::readEventReceived() { readEvent_ = true; }
+void Command::readEventReceived()
+{
+  readEvent_ = true;
+  notifyReady();
+}
 
-void Command::writeEventReceived() { writeEvent_ = true; }
+void Command::writeEventReceived()
+{
+  writeEvent_ = true;
+  notifyReady();
+}
 
-void Command::errorEventReceived() { errorEvent_ = true; }
+void Command::errorEventReceived()
+{
+  errorEvent_ = true;
+  notifyReady();
+}
 
-void Command::hupEventReceived() { hupEvent_ = true; }
+void Command::hupEventReceived()
+{
+  hupEvent_ = true;
+  notifyReady();
+}
 
 void Command::clearIOEvents()
 {
@@ -75,4 +114,31 @@ void Command::clearIOEvents()
   hupEvent_ = false;
 }
 
+void Command::setWakeupTime(const Timer& t)
+{
+  wakeup_ = true;
+  wakeupTime_ = t;
+  if (engine_) {
+    engine_->armCommand(this);
+  }
+}
+
+void Command::setWakeupTimeAfter(std::chrono::milliseconds interval)
+{
+  auto t = global::wallclock();
+  t.advance(interval);
+  setWakeupTime(t);
+}
+
+void Command::clearWakeupTime() { wakeup_ = false; }
+
+bool Command::getWakeupTime(Timer& t) const
+{
+  if (!wakeup_) {
+    return false;
+  }
+  t = wakeupTime_;
+  return true;
+}
+
 } // namespace aria2
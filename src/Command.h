@@ -36,11 +36,14 @@
 #define D_COMMAND_H
 
 #include "common.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
 typedef int64_t cuid_t;
 
+class DownloadEngine;
+
 class Command {
 public:
   enum STATUS {
@@ -61,6 +64,31 @@ private:
   bool errorEvent_;
   bool hupEvent_;
 
+  bool wakeup_;
+  Timer wakeupTime_;
+
+  // The following members are maintained by DownloadEngine.
+
+  // The engine whose command queue or routine command queue this
+  // command is in, or nullptr.
+  DownloadEngine* engine_;
+  // true if this command is in the routine command queue of engine_.
+  bool routine_;
+  // Identifies this command in engine_.  0 until it is first queued.
+  uint64_t serial_;
+  // true if this command is in the ready list of engine_.
+  bool ready_;
+  // true if the timer wheel of engine_ has an entry for this command
+  // which expires at armedTime_.  The entries which expire later are
+  // ignored.
+  bool armed_;
+  Timer armedTime_;
+
+  // Tells engine_ that this command has to be executed.
+  void notifyReady();
+
+  friend class DownloadEngine;
+
 protected:
   bool readEventEnabled() const { return readEvent_; }
 
@@ -79,11 +107,19 @@ public:
 
   cuid_t getCuid() const { return cuid_; }
 
-  void setStatusActive() { status_ = STATUS_ACTIVE; }
+  void setStatusActive()
+  {
+    status_ = STATUS_ACTIVE;
+    notifyReady();
+  }
 
   void setStatusInactive() { status_ = STATUS_INACTIVE; }
 
-  void setStatusRealtime() { status_ = STATUS_REALTIME; }
+  void setStatusRealtime()
+  {
+    status_ = STATUS_REALTIME;
+    notifyReady();
+  }
 
   void setStatus(STATUS status);
 
@@ -103,6 +139,28 @@ public:
   void hupEventReceived();
 
   void clearIOEvents();
+
+  // Makes DownloadEngine execute this command at t even if it
+  // receives no event.  DownloadEngine clears the wake up time before
+  // executing the command, so that the command which does not call
+  // this function again is only executed by an event, a status change
+  // or DownloadEngine::setRefreshInterval().  The command added to
+  // DownloadEngine by the other one is executed in the next
+  // iteration.  The routine command is executed in every iteration
+  // anyway; its wake up time limits the time DownloadEngine waits for
+  // an event.
+  void setWakeupTime(const Timer& t);
+
+  // Same as setWakeupTime(t) where t is interval after now.
+  void setWakeupTimeAfter(std::chrono::milliseconds interval);
+
+  // Makes DownloadEngine execute this command only when it receives
+  // an event.
+  void clearWakeupTime();
+
+  // Stores the wake up time in t and returns true, or returns false
+  // if it has no wake up time.
+  bool getWakeupTime(Timer& t) const;
 };
 
 } // namespace aria2
@@ -287,6 +287,22 @@ ConsoleStatCalc::ConsoleStatCalc(std::chrono::seconds summaryInterval,
   }
 }
 
+bool ConsoleStatCalc::getNextCalculationTime(Timer& next) const
+{
+  next = cp_;
+  next.advance(1_s);
+  if (readoutVisibility_) {
+    return true;
+  }
+  if (summaryInterval_ > 0_s) {
+    auto summaryTime = lastSummaryNotified_;
+    summaryTime.advance(summaryInterval_);
+    next = std::max(next, summaryTime);
+    return true;
+  }
+  return false;
+}
+
 void ConsoleStatCalc::calculateStat(const DownloadEngine* e)
 {
   if (cp_.difference(global::wallclock()) + A2_DELTA_MILLIS <
@@ -347,8 +363,8 @@ void ConsoleStatCalc::calculateStat(const DownloadEngine* e)
   }
 
   {
-    auto& entry = e->getFileAllocationMan()->getPickedEntry();
-    if (entry) {
+    auto& entries = e->getFileAllocationMan()->getPickedEntries();
+    for (auto& entry : entries) {
       o << " [FileAlloc:#"
         << GroupId::toAbbrevHex(entry->getRequestGroup()->getGID()) << " "
         << sizeFormatter(entry->getCurrentLength()) << "B/"
@@ -360,14 +376,14 @@ void ConsoleStatCalc::calculateStat(const DownloadEngine* e)
         o << "--";
       }
       o << "%)]";
-      if (e->getFileAllocationMan()->hasNext()) {
-        o << "(+" << e->getFileAllocationMan()->countEntryInQueue() << ")";
-      }
+    }
+    if (!entries.empty() && e->getFileAllocationMan()->hasNext()) {
+      o << "(+" << e->getFileAllocationMan()->countEntryInQueue() << ")";
     }
   }
   {
-    auto& entry = e->getCheckIntegrityMan()->getPickedEntry();
-    if (entry) {
+    auto& entries = e->getCheckIntegrityMan()->getPickedEntries();
+    for (auto& entry : entries) {
       o << " [Checksum:#"
         << GroupId::toAbbrevHex(entry->getRequestGroup()->getGID()) << " "
         << sizeFormatter(entry->getCurrentLength()) << "B/"
@@ -379,9 +395,9 @@ void ConsoleStatCalc::calculateStat(const DownloadEngine* e)
         o << "--";
       }
       o << "%)]";
-      if (e->getCheckIntegrityMan()->hasNext()) {
-        o << "(+" << e->getCheckIntegrityMan()->countEntryInQueue() << ")";
-      }
+    }
+    if (!entries.empty() && e->getCheckIntegrityMan()->hasNext()) {
+      o << "(+" << e->getCheckIntegrityMan()->countEntryInQueue() << ")";
     }
   }
   if (isTTY_) {
@@ -77,6 +77,8 @@ public:
 
   virtual void calculateStat(const DownloadEngine* e) CXX11_OVERRIDE;
 
+  virtual bool getNextCalculationTime(Timer& next) const CXX11_OVERRIDE;
+
   void setReadoutVisibility(bool visibility)
   {
     readoutVisibility_ = visibility;
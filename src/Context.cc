@@ -66,6 +66,7 @@
 #include "ProtocolDetector.h"
 #include "RecoverableException.h"
 #include "SocketCore.h"
+#include "SocketRecvBuffer.h"
 #include "DownloadContext.h"
 #include "fmt.h"
 #include "console.h"
@@ -224,6 +225,7 @@ Context::Context(bool standalone, int argc, char** argv, const KeyVals& options)
   SocketCore::setIpDscp(op->getAsInt(PREF_DSCP));
   SocketCore::setSocketRecvBufferSize(
       op->getAsInt(PREF_SOCKET_RECV_BUFFER_SIZE));
+  SocketRecvBuffer::setMaxCapacity(op->getAsInt(PREF_MAX_READ_BUFFER_SIZE));
   net::checkAddrconfig();
 
   if (!net::getIPv4AddrConfigured() && !net::getIPv6AddrConfigured()) {
@@ -99,6 +99,8 @@ bool DHTEntryPointNameResolveCommand::execute()
         std::vector<std::string> res;
         int rv = resolveHostname(res, hostname);
         if (rv == 0) {
+          // The resolver may time out without an event.
+          setWakeupTimeAfter(1_s);
           e_->addCommand(std::unique_ptr<Command>(this));
           return false;
         }
@@ -125,7 +125,27 @@ bool DHTGetPeersCommand::execute()
     task_.reset();
   }
 
-  e_->addCommand(std::unique_ptr<Command>(this));
+  if (task_) {
+    // Check the progress of the task once a second.
+    setWakeupTimeAfter(1_s);
+    e_->addCommand(std::unique_ptr<Command>(this));
+  }
+  else {
+    // Sleep until the earliest time the next lookup might become due.
+    // The number of peers may change meanwhile, so use the shortest
+    // interval which is applicable to the current retry state.
+    auto deadline = lastGetPeerTime_;
+    if (numRetry_ && btRuntime_->lessThanMinPeers()) {
+      deadline.advance(GET_PEER_INTERVAL_RETRY);
+    }
+    else {
+      deadline.advance(GET_PEER_INTERVAL_ZERO);
+    }
+    auto now = global::wallclock();
+    now.advance(1_s);
+    e_->addTimerCommand(std::unique_ptr<Command>(this),
+                        std::max(deadline, now), requestGroup_->getGID());
+  }
   return false;
 }
 
@@ -164,6 +164,8 @@ bool DHTInteractionCommand::execute()
       udpTrackerClient_->requestFail(UDPT_ERR_NETWORK);
     }
   }
+  // Process the timeouts of DHT messages and UDP tracker requests.
+  setWakeupTimeAfter(1_s);
   e_->addRoutineCommand(std::unique_ptr<Command>(this));
   return false;
 }
@@ -33,12 +33,25 @@
  */
 /* copyright --> */
 #include "DNSCache.h"
+
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+
 #include "A2STR.h"
+#include "BufferedFile.h"
+#include "File.h"
+#include "LogFactory.h"
+#include "TimeA2.h"
+#include "fmt.h"
+#include "message.h"
+#include "util.h"
 
 namespace aria2 {
 
-DNSCache::AddrEntry::AddrEntry(const std::string& addr)
-    : addr_(addr), good_(true)
+DNSCache::AddrEntry::AddrEntry(const std::string& addr, const Timer& expiry,
+                               std::chrono::seconds ttl)
+    : addr_(addr), good_(true), expiry_(expiry), ttl_(std::move(ttl))
 {
 }
 
@@ -51,12 +64,23 @@ DNSCache::AddrEntry& DNSCache::AddrEntry::operator=(const AddrEntry& c)
   if (this != &c) {
     addr_ = c.addr_;
     good_ = c.good_;
+    expiry_ = c.expiry_;
+    ttl_ = c.ttl_;
   }
   return *this;
 }
 
+bool DNSCache::AddrEntry::expired(const Timer& now) const
+{
+  return expiry_ <= now;
+}
+
 DNSCache::CacheEntry::CacheEntry(const std::string& hostname, uint16_t port)
-    : hostname_(hostname), port_(port)
+    : hostname_(hostname),
+      port_(port),
+      negative_(false),
+      negativeExpiry_(Timer::zero()),
+      used_(false)
 {
 }
 
@@ -70,23 +94,28 @@ DNSCache::CacheEntry& DNSCache::CacheEntry::operator=(const CacheEntry& c)
     hostname_ = c.hostname_;
     port_ = c.port_;
     addrEntries_ = c.addrEntries_;
+    negative_ = c.negative_;
+    error_ = c.error_;
+    negativeExpiry_ = c.negativeExpiry_;
+    used_ = c.used_;
   }
   return *this;
 }
 
-bool DNSCache::CacheEntry::add(const std::string& addr)
+bool DNSCache::CacheEntry::add(const std::string& addr, const Timer& expiry,
+                               std::chrono::seconds ttl)
 {
-  for (std::vector<AddrEntry>::const_iterator i = addrEntries_.begin(),
-                                              eoi = addrEntries_.end();
-       i != eoi; ++i) {
-    if ((*i).addr_ == addr) {
-      return false;
-    }
+  auto i = find(addr);
+  if (i != addrEntries_.end()) {
+    // Keep good_ as it is.  The address is still bad even if DNS
+    // server keeps returning it.
+    (*i).expiry_ = expiry;
+    (*i).ttl_ = std::move(ttl);
+    return false;
   }
-  addrEntries_.push_back(AddrEntry(addr));
+  addrEntries_.push_back(AddrEntry(addr, expiry, std::move(ttl)));
   return true;
 }
-
 std::vector<DNSCache::AddrEntry>::iterator
 DNSCache::CacheEntry::find(const std::string& addr)
 {
@@ -114,10 +143,10 @@ bool DNSCache::CacheEntry::contains(const std::string& addr) const
   return find(addr) != addrEntries_.end();
 }
 
-const std::string& DNSCache::CacheEntry::getGoodAddr() const
+const std::string& DNSCache::CacheEntry::getGoodAddr(const Timer& now) const
 {
   for (auto& elem : addrEntries_) {
-    if (elem.good_) {
+    if (elem.good_ && !elem.expired(now)) {
       return (elem).addr_;
     }
   }
@@ -132,6 +161,37 @@ void DNSCache::CacheEntry::markBad(const std::string& addr)
   }
 }
 
+bool DNSCache::CacheEntry::removeExpired(const Timer& now)
+{
+  if (negative_) {
+    return negativeExpiry_ <= now;
+  }
+  addrEntries_.erase(std::remove_if(std::begin(addrEntries_),
+                                    std::end(addrEntries_),
+                                    [&now](const AddrEntry& ent) {
+                                      return ent.expired(now);
+                                    }),
+                     std::end(addrEntries_));
+  return addrEntries_.empty();
+}
+
+bool DNSCache::CacheEntry::needRefresh(const Timer& now) const
+{
+  if (negative_) {
+    return false;
+  }
+  for (auto& elem : addrEntries_) {
+    if (!elem.good_ || elem.expired(now)) {
+      continue;
+    }
+    auto remaining = now.difference(elem.expiry_);
+    if (remaining * 4 <= elem.ttl_) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool DNSCache::CacheEntry::operator<(const CacheEntry& e) const
 {
   int r = hostname_.compare(e.hostname_);
@@ -146,7 +206,7 @@ bool DNSCache::CacheEntry::operator==(const CacheEntry& e) const
   return hostname_ == e.hostname_ && port_ == e.port_;
 }
 
-DNSCache::DNSCache() {}
+DNSCache::DNSCache() : minTTL_(30_s), maxTTL_(1_h), negativeTTL_(5_s) {}
 
 DNSCache::DNSCache(const DNSCache& c) = default;
 
@@ -156,44 +216,107 @@ DNSCache& DNSCache::operator=(const DNSCache& c)
 {
   if (this != &c) {
     entries_ = c.entries_;
+    minTTL_ = c.minTTL_;
+    maxTTL_ = c.maxTTL_;
+    negativeTTL_ = c.negativeTTL_;
   }
   return *this;
 }
 
-const std::string& DNSCache::find(const std::string& hostname,
-                                  uint16_t port) const
+std::shared_ptr<DNSCache::CacheEntry>
+DNSCache::findEntry(const std::string& hostname, uint16_t port) const
 {
   auto target = std::make_shared<CacheEntry>(hostname, port);
   auto i = entries_.find(target);
   if (i == entries_.end()) {
-    return A2STR::NIL;
-  }
-  else {
-    return (*i)->getGoodAddr();
+    return nullptr;
   }
+  return *i;
 }
 
-void DNSCache::put(const std::string& hostname, const std::string& ipaddr,
-                   uint16_t port)
+std::shared_ptr<DNSCache::CacheEntry>
+DNSCache::findOrCreateEntry(const std::string& hostname, uint16_t port)
 {
   auto target = std::make_shared<CacheEntry>(hostname, port);
   auto i = entries_.lower_bound(target);
   if (i != entries_.end() && *(*i) == *target) {
-    (*i)->add(ipaddr);
+    return *i;
   }
-  else {
-    target->add(ipaddr);
-    entries_.insert(i, target);
+  entries_.insert(i, target);
+  return target;
+}
+
+std::chrono::seconds DNSCache::clampTTL(std::chrono::seconds ttl) const
+{
+  if (ttl.count() < 0) {
+    return maxTTL_;
+  }
+  return std::max(minTTL_, std::min(maxTTL_, ttl));
+}
+
+const std::string& DNSCache::find(const std::string& hostname,
+                                  uint16_t port) const
+{
+  auto entry = findEntry(hostname, port);
+  if (!entry || entry->negative_) {
+    return A2STR::NIL;
   }
+  entry->used_ = true;
+  return entry->getGoodAddr(global::wallclock());
+}
+
+void DNSCache::put(const std::string& hostname, const std::string& ipaddr,
+                   uint16_t port)
+{
+  put(hostname, ipaddr, port, std::chrono::seconds(-1));
+}
+
+void DNSCache::put(const std::string& hostname, const std::string& ipaddr,
+                   uint16_t port, std::chrono::seconds ttl)
+{
+  auto entry = findOrCreateEntry(hostname, port);
+  if (entry->negative_) {
+    entry->negative_ = false;
+    entry->error_.clear();
+  }
+  ttl = clampTTL(std::move(ttl));
+  auto expiry = global::wallclock();
+  expiry.advance(ttl);
+  entry->add(ipaddr, expiry, std::move(ttl));
+}
+
+void DNSCache::putNegative(const std::string& hostname, uint16_t port,
+                           const std::string& error)
+{
+  if (negativeTTL_.count() == 0) {
+    return;
+  }
+  auto entry = findOrCreateEntry(hostname, port);
+  entry->addrEntries_.clear();
+  entry->negative_ = true;
+  entry->error_ = error;
+  entry->negativeExpiry_ = global::wallclock();
+  entry->negativeExpiry_.advance(negativeTTL_);
+}
+
+bool DNSCache::findNegative(std::string& error, const std::string& hostname,
+                            uint16_t port) const
+{
+  auto entry = findEntry(hostname, port);
+  if (!entry || !entry->negative_ ||
+      entry->negativeExpiry_ <= global::wallclock()) {
+    return false;
+  }
+  error = entry->error_;
+  return true;
 }
 
 void DNSCache::markBad(const std::string& hostname, const std::string& ipaddr,
                        uint16_t port)
 {
-  auto target = std::make_shared<CacheEntry>(hostname, port);
-  auto i = entries_.find(target);
-  if (i != entries_.end()) {
-    (*i)->markBad(ipaddr);
+  auto entry = findEntry(hostname, port);
+  if (entry) {
+    entry->markBad(ipaddr);
   }
 }
 
@@ -203,4 +326,171 @@ void DNSCache::remove(const std::string& hostname, uint16_t port)
   entries_.erase(target);
 }
 
+void DNSCache::removeExpired()
+{
+  const auto& now = global::wallclock();
+  for (auto i = std::begin(entries_); i != std::end(entries_);) {
+    if ((*i)->removeExpired(now)) {
+      entries_.erase(i++);
+    }
+    else {
+      ++i;
+    }
+  }
+}
+
+bool DNSCache::nextRefreshCandidate(std::string& hostname, uint16_t& port)
+{
+  const auto& now = global::wallclock();
+  for (auto& entry : entries_) {
+    if (entry->used_ && entry->needRefresh(now)) {
+      entry->used_ = false;
+      hostname = entry->hostname_;
+      port = entry->port_;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DNSCache::save(const std::string& filename) const
+{
+  std::string tempfile = filename;
+  tempfile += "__temp";
+  {
+    BufferedFile fp(tempfile.c_str(), BufferedFile::WRITE);
+    if (!fp) {
+      A2_LOG_ERROR(
+          fmt(MSG_OPENING_WRITABLE_DNS_CACHE_FILE_FAILED, filename.c_str()));
+      return false;
+    }
+    const auto& now = global::wallclock();
+    auto epoch = Time().getTimeFromEpoch();
+    for (auto& entry : entries_) {
+      if (entry->negative_) {
+        continue;
+      }
+      for (auto& addrEntry : entry->addrEntries_) {
+        if (!addrEntry.good_ || addrEntry.expired(now)) {
+          continue;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::seconds>(
+            now.difference(addrEntry.expiry_));
+        auto l = fmt("host=%s, port=%u, addr=%s, ttl=%ld, expires=%ld\n",
+                     entry->hostname_.c_str(), entry->port_,
+                     addrEntry.addr_.c_str(),
+                     static_cast<long>(addrEntry.ttl_.count()),
+                     static_cast<long>(epoch + remaining.count()));
+        if (fp.write(l.data(), l.size()) != l.size()) {
+          A2_LOG_ERROR(
+              fmt(MSG_WRITING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+        }
+      }
+    }
+    if (fp.close() == EOF) {
+      A2_LOG_ERROR(fmt(MSG_WRITING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+      return false;
+    }
+  }
+  if (File(tempfile).renameTo(filename)) {
+    A2_LOG_NOTICE(fmt(MSG_DNS_CACHE_SAVED, filename.c_str()));
+    return true;
+  }
+  else {
+    A2_LOG_ERROR(fmt(MSG_WRITING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+    return false;
+  }
+}
+
+namespace {
+// Field and FIELD_NAMES must have same order except for MAX_FIELD.
+enum Field { S_ADDR, S_EXPIRES, S_HOST, S_PORT, S_TTL, MAX_FIELD };
+
+const char* FIELD_NAMES[] = {
+    "addr", "expires", "host", "port", "ttl",
+};
+} // namespace
+
+namespace {
+int idField(std::string::const_iterator first, std::string::const_iterator last)
+{
+  int i;
+  for (i = 0; i < MAX_FIELD; ++i) {
+    if (util::streq(first, last, FIELD_NAMES[i])) {
+      return i;
+    }
+  }
+  return i;
+}
+} // namespace
+
+bool DNSCache::load(const std::string& filename)
+{
+  BufferedFile fp(filename.c_str(), BufferedFile::READ);
+  if (!fp) {
+    A2_LOG_ERROR(
+        fmt(MSG_OPENING_READABLE_DNS_CACHE_FILE_FAILED, filename.c_str()));
+    return false;
+  }
+  auto epoch = Time().getTimeFromEpoch();
+  while (1) {
+    std::string line = fp.getLine();
+    if (line.empty()) {
+      if (fp.eof()) {
+        break;
+      }
+      else if (!fp) {
+        A2_LOG_ERROR(fmt(MSG_READING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+        return false;
+      }
+      else {
+        continue;
+      }
+    }
+    auto p = util::stripIter(line.begin(), line.end());
+    if (p.first == p.second) {
+      continue;
+    }
+    std::vector<Scip> items;
+    util::splitIter(p.first, p.second, std::back_inserter(items), ',');
+    std::vector<std::string> m(MAX_FIELD);
+    for (auto& item : items) {
+      auto kv = util::divide(item.first, item.second, '=');
+      int id = idField(kv.first.first, kv.first.second);
+      if (id != MAX_FIELD) {
+        m[id].assign(kv.second.first, kv.second.second);
+      }
+    }
+    if (m[S_HOST].empty() || m[S_ADDR].empty()) {
+      continue;
+    }
+    uint32_t port;
+    if (!util::parseUIntNoThrow(port, m[S_PORT]) || port > UINT16_MAX) {
+      continue;
+    }
+    int64_t expires;
+    if (!util::parseLLIntNoThrow(expires, m[S_EXPIRES]) || expires <= epoch) {
+      continue;
+    }
+    uint32_t ttl;
+    if (!util::parseUIntNoThrow(ttl, m[S_TTL])) {
+      continue;
+    }
+    // The TTL was clamped when the address was resolved.  Don't apply
+    // the floor again here, or an address near its expiry gets its
+    // lifetime extended.
+    auto remaining = std::chrono::seconds(
+        std::min(expires - epoch, static_cast<int64_t>(maxTTL_.count())));
+    auto expiry = global::wallclock();
+    expiry.advance(remaining);
+    auto entry = findOrCreateEntry(m[S_HOST], port);
+    if (entry->negative_) {
+      continue;
+    }
+    entry->add(m[S_ADDR], expiry, std::chrono::seconds(ttl));
+  }
+  A2_LOG_NOTICE(fmt(MSG_DNS_CACHE_LOADED, filename.c_str()));
+  return true;
+}
+
 } // namespace aria2
@@ -41,28 +41,53 @@
 #include <set>
 #include <algorithm>
 #include <vector>
+#include <memory>
+#include <chrono>
 
 #include "a2functional.h"
+#include "TimerA2.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
+// Caches the result of name resolution.  Each address expires after
+// its TTL, clamped to [getMinTTL(), getMaxTTL()].  An address whose
+// TTL is not known (e.g., it was resolved by getaddrinfo()) is kept
+// for getMaxTTL().  A failed lookup can be cached for
+// getNegativeTTL() so that the same name is not queried over and over
+// again.  Expiry is measured against global::wallclock().
 class DNSCache {
 private:
   struct AddrEntry {
     std::string addr_;
     bool good_;
+    Timer expiry_;
+    // Clamped TTL of this address.  Used to decide when this address
+    // should be refreshed.
+    std::chrono::seconds ttl_;
 
-    AddrEntry(const std::string& addr);
+    AddrEntry(const std::string& addr, const Timer& expiry,
+              std::chrono::seconds ttl);
     AddrEntry(const AddrEntry& c);
     ~AddrEntry();
 
     AddrEntry& operator=(const AddrEntry& c);
+
+    bool expired(const Timer& now) const;
   };
 
   struct CacheEntry {
     std::string hostname_;
     uint16_t port_;
     std::vector<AddrEntry> addrEntries_;
+    // true if this entry records a failed lookup.  addrEntries_ is
+    // empty in this case.
+    bool negative_;
+    std::string error_;
+    Timer negativeExpiry_;
+    // true if this entry has been looked up since its addresses were
+    // last stored.  Only such entries are refreshed in background.
+    bool used_;
 
     CacheEntry(const std::string& hostname, uint16_t port);
     CacheEntry(const CacheEntry& c);
@@ -70,7 +95,10 @@ private:
 
     CacheEntry& operator=(const CacheEntry& c);
 
-    bool add(const std::string& addr);
+    // Adds addr.  If addr already exists, its expiry is updated and
+    // false is returned.
+    bool add(const std::string& addr, const Timer& expiry,
+             std::chrono::seconds ttl);
 
     std::vector<AddrEntry>::iterator find(const std::string& addr);
 
@@ -78,13 +106,13 @@ private:
 
     bool contains(const std::string& addr) const;
 
-    const std::string& getGoodAddr() const;
+    const std::string& getGoodAddr(const Timer& now) const;
 
     template <typename OutputIterator>
-    void getAllGoodAddrs(OutputIterator out) const
+    void getAllGoodAddrs(OutputIterator out, const Timer& now) const
     {
       for (auto& elem : addrEntries_) {
-        if (elem.good_) {
+        if (elem.good_ && !elem.expired(now)) {
           *out++ = elem.addr_;
         }
       }
@@ -92,6 +120,14 @@ private:
 
     void markBad(const std::string& addr);
 
+    // Removes expired addresses.  Returns true if this entry has no
+    // use anymore and can be removed.
+    bool removeExpired(const Timer& now);
+
+    // Returns true if one of good addresses is within the last
+    // quarter of its TTL.
+    bool needRefresh(const Timer& now) const;
+
     bool operator<(const CacheEntry& e) const;
 
     bool operator==(const CacheEntry& e) const;
@@ -102,6 +138,18 @@ private:
       CacheEntrySet;
   CacheEntrySet entries_;
 
+  std::chrono::seconds minTTL_;
+  std::chrono::seconds maxTTL_;
+  std::chrono::seconds negativeTTL_;
+
+  std::shared_ptr<CacheEntry> findEntry(const std::string& hostname,
+                                        uint16_t port) const;
+
+  std::shared_ptr<CacheEntry> findOrCreateEntry(const std::string& hostname,
+                                                uint16_t port);
+
+  std::chrono::seconds clampTTL(std::chrono::seconds ttl) const;
+
 public:
   DNSCache();
   DNSCache(const DNSCache& c);
@@ -115,20 +163,72 @@ public:
   void findAll(OutputIterator out, const std::string& hostname,
                uint16_t port) const
   {
-    auto target = std::make_shared<CacheEntry>(hostname, port);
-    auto i = entries_.find(target);
-    if (i != entries_.end()) {
-      (*i)->getAllGoodAddrs(out);
+    auto entry = findEntry(hostname, port);
+    if (entry && !entry->negative_) {
+      entry->used_ = true;
+      entry->getAllGoodAddrs(out, global::wallclock());
     }
   }
 
+  // Stores ipaddr, whose TTL is unknown, for hostname and port.
   void put(const std::string& hostname, const std::string& ipaddr,
            uint16_t port);
 
+  // Stores ipaddr for hostname and port.  ttl is the TTL of the
+  // resource record.  Negative ttl means that TTL is unknown.
+  void put(const std::string& hostname, const std::string& ipaddr,
+           uint16_t port, std::chrono::seconds ttl);
+
+  // Records that the lookup of hostname failed with error.  The
+  // addresses stored for hostname and port are discarded.  This
+  // function does nothing if getNegativeTTL() is 0.
+  void putNegative(const std::string& hostname, uint16_t port,
+                   const std::string& error);
+
+  // Returns true if the failed lookup of hostname is cached, and
+  // assigns its error message to error.
+  bool findNegative(std::string& error, const std::string& hostname,
+                    uint16_t port) const;
+
   void markBad(const std::string& hostname, const std::string& ipaddr,
                uint16_t port);
 
   void remove(const std::string& hostname, uint16_t port);
+
+  // Removes expired addresses and expired negative entries.
+  void removeExpired();
+
+  // Finds an entry which has been looked up since it was last stored
+  // and whose addresses are about to expire, and assigns its hostname
+  // and port to hostname and port.  Returns true if such entry is
+  // found.  The entry is not returned again until it is looked up
+  // again.
+  bool nextRefreshCandidate(std::string& hostname, uint16_t& port);
+
+  size_t size() const { return entries_.size(); }
+
+  // Saves unexpired good addresses to filename.  The expiry is stored
+  // as seconds since the Epoch, so that the file can be loaded after
+  // restart.
+  bool save(const std::string& filename) const;
+
+  // Loads addresses saved by save().  Expired addresses are ignored.
+  bool load(const std::string& filename);
+
+  void setMinTTL(std::chrono::seconds ttl) { minTTL_ = std::move(ttl); }
+
+  const std::chrono::seconds& getMinTTL() const { return minTTL_; }
+
+  void setMaxTTL(std::chrono::seconds ttl) { maxTTL_ = std::move(ttl); }
+
+  const std::chrono::seconds& getMaxTTL() const { return maxTTL_; }
+
+  void setNegativeTTL(std::chrono::seconds ttl)
+  {
+    negativeTTL_ = std::move(ttl);
+  }
+
+  const std::chrono::seconds& getNegativeTTL() const { return negativeTTL_; }
 };
 
 } // namespace aria2
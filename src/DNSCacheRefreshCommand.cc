@@ -0,0 +1,142 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DNSCacheRefreshCommand.h"
+#include "DownloadEngine.h"
+#include "RequestGroupMan.h"
+#include "DNSCache.h"
+#include "Option.h"
+#include "prefs.h"
+#include "LogFactory.h"
+#include "fmt.h"
+#include "a2functional.h"
+#include "wallclock.h"
+#ifdef ENABLE_ASYNC_DNS
+#  include "AsyncNameResolverMan.h"
+#endif // ENABLE_ASYNC_DNS
+
+namespace aria2 {
+
+DNSCacheRefreshCommand::DNSCacheRefreshCommand(cuid_t cuid, DownloadEngine* e,
+                                               std::chrono::seconds interval)
+    : Command{cuid},
+      e_{e},
+#ifdef ENABLE_ASYNC_DNS
+      asyncNameResolverMan_{make_unique<AsyncNameResolverMan>()},
+#endif // ENABLE_ASYNC_DNS
+      port_{0},
+      checkPoint_{global::wallclock()},
+      interval_{std::move(interval)}
+{
+#ifdef ENABLE_ASYNC_DNS
+  configureAsyncNameResolverMan(asyncNameResolverMan_.get(), e_->getOption());
+#endif // ENABLE_ASYNC_DNS
+}
+
+DNSCacheRefreshCommand::~DNSCacheRefreshCommand()
+{
+#ifdef ENABLE_ASYNC_DNS
+  asyncNameResolverMan_->disableNameResolverCheck(e_, this);
+#endif // ENABLE_ASYNC_DNS
+}
+
+bool DNSCacheRefreshCommand::execute()
+{
+  if (e_->getRequestGroupMan()->downloadFinished() || e_->isHaltRequested()) {
+    return true;
+  }
+#ifdef ENABLE_ASYNC_DNS
+  if (asyncNameResolverMan_->started()) {
+    if (!finishRefresh()) {
+      // The resolver may time out without an event.
+      setWakeupTimeAfter(1_s);
+      e_->addCommand(std::unique_ptr<Command>(this));
+      return false;
+    }
+  }
+#endif // ENABLE_ASYNC_DNS
+  const auto& dnsCache = e_->getDNSCache();
+  if (checkPoint_.difference(global::wallclock()) >= interval_) {
+    checkPoint_ = global::wallclock();
+    dnsCache->removeExpired();
+  }
+#ifdef ENABLE_ASYNC_DNS
+  if (e_->getOption()->getAsBool(PREF_ASYNC_DNS) &&
+      dnsCache->nextRefreshCandidate(hostname_, port_)) {
+    A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - Refreshing DNS cache for %s",
+                     getCuid(), hostname_.c_str()));
+    asyncNameResolverMan_->startAsync(hostname_, e_, this);
+    setWakeupTimeAfter(1_s);
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+#endif // ENABLE_ASYNC_DNS
+  auto deadline = checkPoint_;
+  deadline.advance(interval_);
+  e_->addTimerCommand(std::unique_ptr<Command>(this), deadline);
+  return false;
+}
+
+#ifdef ENABLE_ASYNC_DNS
+
+bool DNSCacheRefreshCommand::finishRefresh()
+{
+  switch (asyncNameResolverMan_->getStatus()) {
+  case 0:
+    return false;
+  case 1: {
+    std::vector<std::string> addrs;
+    std::vector<int> ttls;
+    asyncNameResolverMan_->getResolvedAddress(addrs, ttls);
+    for (size_t i = 0; i < addrs.size(); ++i) {
+      e_->cacheIPAddress(hostname_, addrs[i], port_,
+                         std::chrono::seconds(i < ttls.size() ? ttls[i] : -1));
+    }
+    break;
+  }
+  default:
+    // Keep the current addresses until they expire.  A download
+    // resolves the name by itself after that.
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Refreshing DNS cache for %s failed:%s",
+                    getCuid(), hostname_.c_str(),
+                    asyncNameResolverMan_->getLastError().c_str()));
+    break;
+  }
+  asyncNameResolverMan_->reset(e_, this);
+  return true;
+}
+
+#endif // ENABLE_ASYNC_DNS
+
+} // namespace aria2
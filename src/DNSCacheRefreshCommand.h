@@ -0,0 +1,88 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DNS_CACHE_REFRESH_COMMAND_H
+#define D_DNS_CACHE_REFRESH_COMMAND_H
+
+#include "Command.h"
+
+#include <string>
+#include <memory>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class DownloadEngine;
+#ifdef ENABLE_ASYNC_DNS
+class AsyncNameResolverMan;
+#endif // ENABLE_ASYNC_DNS
+
+// Removes expired entries from DNSCache every interval.  If
+// asynchronous DNS is enabled, this command also resolves the entries
+// which are in use and about to expire, so that downloads find fresh
+// addresses in the cache and don't wait for name resolution.  Only
+// one name is resolved at a time.
+class DNSCacheRefreshCommand : public Command {
+private:
+  DownloadEngine* e_;
+#ifdef ENABLE_ASYNC_DNS
+  std::unique_ptr<AsyncNameResolverMan> asyncNameResolverMan_;
+#endif // ENABLE_ASYNC_DNS
+  // Hostname and port being refreshed
+  std::string hostname_;
+  uint16_t port_;
+
+  Timer checkPoint_;
+  std::chrono::seconds interval_;
+
+#ifdef ENABLE_ASYNC_DNS
+  // Stores the result of the refresh in progress into DNSCache.
+  // Returns false if the refresh has not completed yet.
+  bool finishRefresh();
+#endif // ENABLE_ASYNC_DNS
+
+public:
+  DNSCacheRefreshCommand(cuid_t cuid, DownloadEngine* e,
+                         std::chrono::seconds interval);
+
+  virtual ~DNSCacheRefreshCommand();
+
+  virtual bool execute() CXX11_OVERRIDE;
+};
+
+} // namespace aria2
+
+#endif // D_DNS_CACHE_REFRESH_COMMAND_H
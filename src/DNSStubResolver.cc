@@ -0,0 +1,827 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DNSStubResolver.h"
+
+#include <cstring>
+#include <climits>
+#include <algorithm>
+
+#include "BufferedFile.h"
+#include "File.h"
+#include "LogFactory.h"
+#include "SimpleRandomizer.h"
+#include "SocketCore.h"
+#include "DlRetryEx.h"
+#include "wallclock.h"
+#include "fmt.h"
+#include "util.h"
+
+namespace aria2 {
+
+namespace {
+// Removes trailing dot of fully qualified name.
+std::string stripRootDot(const std::string& name)
+{
+  if (!name.empty() && name.back() == '.') {
+    return name.substr(0, name.size() - 1);
+  }
+  return name;
+}
+} // namespace
+
+namespace dns {
+
+namespace {
+constexpr size_t HEADER_LENGTH = 12;
+constexpr size_t MAX_NAME_LENGTH = 255;
+constexpr size_t MAX_LABEL_LENGTH = 63;
+constexpr uint16_t FLAG_QR = 0x8000u;
+constexpr uint16_t FLAG_TC = 0x0200u;
+constexpr uint16_t FLAG_RD = 0x0100u;
+// The maximum number of CNAME records followed.
+constexpr int MAX_CNAME_CHAIN = 16;
+} // namespace
+
+namespace {
+void putUint16(std::string& s, uint16_t n)
+{
+  s += static_cast<char>(n >> 8);
+  s += static_cast<char>(n & 0xffu);
+}
+} // namespace
+
+namespace {
+uint16_t getUint16(const unsigned char* p) { return (p[0] << 8) | p[1]; }
+} // namespace
+
+namespace {
+uint32_t getUint32(const unsigned char* p)
+{
+  return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) |
+         p[3];
+}
+} // namespace
+
+std::string createQuery(uint16_t id, const std::string& name, uint16_t type)
+{
+  auto n = stripRootDot(name);
+  if (n.empty() || n.size() > MAX_NAME_LENGTH - 2) {
+    return "";
+  }
+  std::string query;
+  putUint16(query, id);
+  putUint16(query, FLAG_RD);
+  // QDCOUNT, ANCOUNT, NSCOUNT, ARCOUNT
+  putUint16(query, 1);
+  putUint16(query, 0);
+  putUint16(query, 0);
+  putUint16(query, 0);
+  for (auto first = std::begin(n), last = std::end(n); first != last;) {
+    auto eol = std::find(first, last, '.');
+    auto len = static_cast<size_t>(eol - first);
+    if (len == 0 || len > MAX_LABEL_LENGTH) {
+      return "";
+    }
+    query += static_cast<char>(len);
+    query.append(first, eol);
+    first = eol;
+    if (first != last) {
+      ++first;
+      if (first == last) {
+        return "";
+      }
+    }
+  }
+  query += '\0';
+  putUint16(query, type);
+  putUint16(query, CLASS_IN);
+  return query;
+}
+
+namespace {
+// Reads possibly compressed domain name at data+offset into name and
+// advances offset past the name.  Returns false if the name is
+// malformed.
+bool readName(std::string& name, const unsigned char* data, size_t len,
+              size_t& offset)
+{
+  name.clear();
+  size_t pos = offset;
+  bool jumped = false;
+  // Bounds the number of compression pointers to detect loops.
+  for (int jumps = 0;;) {
+    if (pos >= len) {
+      return false;
+    }
+    size_t labelLen = data[pos];
+    if ((labelLen & 0xc0u) == 0xc0u) {
+      if (pos + 1 >= len || ++jumps > 64) {
+        return false;
+      }
+      if (!jumped) {
+        offset = pos + 2;
+        jumped = true;
+      }
+      pos = ((labelLen & 0x3fu) << 8) | data[pos + 1];
+      continue;
+    }
+    if (labelLen & 0xc0u) {
+      return false;
+    }
+    ++pos;
+    if (labelLen == 0) {
+      break;
+    }
+    if (pos + labelLen > len) {
+      return false;
+    }
+    if (!name.empty()) {
+      name += '.';
+    }
+    name.append(data + pos, data + pos + labelLen);
+    if (name.size() > MAX_NAME_LENGTH) {
+      return false;
+    }
+    pos += labelLen;
+  }
+  if (!jumped) {
+    offset = pos;
+  }
+  return true;
+}
+} // namespace
+
+namespace {
+struct ResourceRecord {
+  std::string name;
+  uint16_t type;
+  uint32_t ttl;
+  std::string rdata;
+};
+} // namespace
+
+bool parseResponse(Response& res, const unsigned char* data, size_t len,
+                   const std::string& name, uint16_t type)
+{
+  if (len < HEADER_LENGTH) {
+    return false;
+  }
+  res.id = getUint16(data);
+  uint16_t flags = getUint16(data + 2);
+  if ((flags & FLAG_QR) == 0) {
+    return false;
+  }
+  res.truncated = flags & FLAG_TC;
+  res.rcode = flags & 0xfu;
+  res.addrs.clear();
+  uint16_t qdcount = getUint16(data + 4);
+  uint16_t ancount = getUint16(data + 6);
+  if (qdcount != 1) {
+    return false;
+  }
+  size_t offset = HEADER_LENGTH;
+  std::string qname;
+  if (!readName(qname, data, len, offset) || offset + 4 > len) {
+    return false;
+  }
+  auto target = stripRootDot(name);
+  if (!util::strieq(qname, target) || getUint16(data + offset) != type ||
+      getUint16(data + offset + 2) != CLASS_IN) {
+    return false;
+  }
+  offset += 4;
+  if (res.truncated || res.rcode != RCODE_NOERROR) {
+    return true;
+  }
+  std::vector<ResourceRecord> rrs;
+  for (size_t i = 0; i < ancount; ++i) {
+    ResourceRecord rr;
+    if (!readName(rr.name, data, len, offset) || offset + 10 > len) {
+      return false;
+    }
+    rr.type = getUint16(data + offset);
+    uint16_t rclass = getUint16(data + offset + 2);
+    rr.ttl = getUint32(data + offset + 4);
+    // RFC 2181 section 8: the value with the most significant bit set
+    // is treated as zero.
+    if (rr.ttl & 0x80000000u) {
+      rr.ttl = 0;
+    }
+    size_t rdlength = getUint16(data + offset + 8);
+    offset += 10;
+    if (offset + rdlength > len) {
+      return false;
+    }
+    if (rclass == CLASS_IN) {
+      if (rr.type == TYPE_CNAME) {
+        size_t rdoffset = offset;
+        if (!readName(rr.rdata, data, len, rdoffset)) {
+          return false;
+        }
+        rrs.push_back(std::move(rr));
+      }
+      else if (rr.type == type) {
+        rr.rdata.assign(data + offset, data + offset + rdlength);
+        rrs.push_back(std::move(rr));
+      }
+    }
+    offset += rdlength;
+  }
+  // Follows CNAME chain from the queried name.  The addresses are
+  // valid only as long as every alias leading to them is.
+  uint32_t chainTTL = UINT32_MAX;
+  for (int i = 0; i < MAX_CNAME_CHAIN; ++i) {
+    auto it = std::find_if(std::begin(rrs), std::end(rrs),
+                           [&target](const ResourceRecord& rr) {
+                             return rr.type == TYPE_CNAME &&
+                                    util::strieq(rr.name, target);
+                           });
+    if (it == std::end(rrs)) {
+      break;
+    }
+    target = (*it).rdata;
+    chainTTL = std::min(chainTTL, (*it).ttl);
+  }
+  int family = type == TYPE_A ? AF_INET : AF_INET6;
+  size_t addrlen = type == TYPE_A ? 4 : 16;
+  for (const auto& rr : rrs) {
+    if (rr.type != type || rr.rdata.size() != addrlen ||
+        !util::strieq(rr.name, target)) {
+      continue;
+    }
+    char addrstring[NI_MAXHOST];
+    if (inetNtop(family, rr.rdata.data(), addrstring, sizeof(addrstring)) ==
+        0) {
+      res.addrs.emplace_back(addrstring, std::min(chainTTL, rr.ttl));
+    }
+  }
+  return true;
+}
+
+} // namespace dns
+
+ResolvConf::ResolvConf()
+    : ndots(1),
+      timeout(std::chrono::seconds(5)),
+      attempts(2),
+      hostsFile("/etc/hosts")
+{
+}
+
+namespace {
+// The maximum number of name servers and search domains the system
+// resolver uses.
+constexpr size_t MAX_NAME_SERVERS = 3;
+constexpr size_t MAX_SEARCH_DOMAINS = 6;
+constexpr uint16_t DNS_PORT = 53;
+} // namespace
+
+namespace {
+// Returns numeric address ip in canonical form, or empty string if ip
+// is not a numeric address.
+std::string normalizeAddress(const std::string& ip)
+{
+  unsigned char binAddr[sizeof(struct in6_addr)];
+  size_t len = net::getBinAddr(binAddr, ip);
+  if (len == 0) {
+    return "";
+  }
+  char addrstring[NI_MAXHOST];
+  if (inetNtop(len == 4 ? AF_INET : AF_INET6, binAddr, addrstring,
+               sizeof(addrstring)) != 0) {
+    return "";
+  }
+  return addrstring;
+}
+} // namespace
+
+void parseResolvConf(ResolvConf& conf, const std::string& filename)
+{
+  BufferedFile fp(filename.c_str(), BufferedFile::READ);
+  if (fp) {
+    while (1) {
+      std::string line = fp.getLine();
+      if (line.empty()) {
+        if (fp.eof() || !fp) {
+          break;
+        }
+        continue;
+      }
+      if (line[0] == '#' || line[0] == ';') {
+        continue;
+      }
+      std::vector<std::string> tokens;
+      std::replace(std::begin(line), std::end(line), '\t', ' ');
+      util::split(std::begin(line), std::end(line), std::back_inserter(tokens),
+                  ' ', true);
+      if (tokens.size() < 2) {
+        continue;
+      }
+      if (tokens[0] == "nameserver") {
+        auto addr = normalizeAddress(tokens[1]);
+        if (!addr.empty() && conf.servers.size() < MAX_NAME_SERVERS) {
+          conf.servers.emplace_back(addr, DNS_PORT);
+        }
+      }
+      else if (tokens[0] == "domain") {
+        conf.search.assign(1, stripRootDot(tokens[1]));
+      }
+      else if (tokens[0] == "search") {
+        conf.search.clear();
+        for (auto i = std::begin(tokens) + 1, eoi = std::end(tokens);
+             i != eoi && conf.search.size() < MAX_SEARCH_DOMAINS; ++i) {
+          conf.search.push_back(stripRootDot(*i));
+        }
+      }
+      else if (tokens[0] == "options") {
+        for (auto i = std::begin(tokens) + 1, eoi = std::end(tokens); i != eoi;
+             ++i) {
+          auto colon = (*i).find(':');
+          if (colon == std::string::npos) {
+            continue;
+          }
+          auto key = (*i).substr(0, colon);
+          int32_t value;
+          if (!util::parseIntNoThrow(value, (*i).substr(colon + 1)) ||
+              value < 0) {
+            continue;
+          }
+          // Same upper bounds as glibc.
+          if (key == "ndots") {
+            conf.ndots = std::min(value, 15);
+          }
+          else if (key == "timeout") {
+            conf.timeout =
+                std::chrono::seconds(std::max(1, std::min(value, 30)));
+          }
+          else if (key == "attempts") {
+            conf.attempts = std::max(1, std::min(value, 5));
+          }
+        }
+      }
+    }
+  }
+  if (conf.servers.empty()) {
+    conf.servers.emplace_back("127.0.0.1", DNS_PORT);
+  }
+}
+
+ResolvConfLoader::ResolvConfLoader(std::string filename)
+    : filename_(std::move(filename)), mtime_(0), size_(0)
+{
+}
+
+std::shared_ptr<const ResolvConf> ResolvConfLoader::get()
+{
+  File f(filename_);
+  auto mtime = f.getModifiedTime().getTimeFromEpoch();
+  auto size = f.size();
+  if (!conf_ || mtime != mtime_ || size != size_) {
+    if (conf_) {
+      A2_LOG_INFO(fmt("%s changed. Reloading.", filename_.c_str()));
+    }
+    auto conf = std::make_shared<ResolvConf>();
+    parseResolvConf(*conf, filename_);
+    conf_ = conf;
+    mtime_ = mtime;
+    size_ = size;
+  }
+  return conf_;
+}
+
+std::shared_ptr<const ResolvConf> getSystemResolvConf(
+    const std::vector<std::pair<std::string, uint16_t>>& servers)
+{
+  static ResolvConfLoader loader("/etc/resolv.conf");
+  auto conf = loader.get();
+  if (servers.empty()) {
+    return conf;
+  }
+  auto c = std::make_shared<ResolvConf>(*conf);
+  c->servers = servers;
+  return c;
+}
+
+void lookupHostsFile(std::vector<std::string>& addrs,
+                     const std::string& filename, const std::string& name,
+                     int family)
+{
+  BufferedFile fp(filename.c_str(), BufferedFile::READ);
+  if (!fp) {
+    return;
+  }
+  auto target = stripRootDot(name);
+  while (1) {
+    std::string line = fp.getLine();
+    if (line.empty()) {
+      if (fp.eof() || !fp) {
+        break;
+      }
+      continue;
+    }
+    auto hash = line.find('#');
+    if (hash != std::string::npos) {
+      line.erase(hash);
+    }
+    std::vector<std::string> tokens;
+    std::replace(std::begin(line), std::end(line), '\t', ' ');
+    util::split(std::begin(line), std::end(line), std::back_inserter(tokens),
+                ' ', true);
+    if (tokens.size() < 2) {
+      continue;
+    }
+    unsigned char binAddr[sizeof(struct in6_addr)];
+    size_t len = net::getBinAddr(binAddr, tokens[0]);
+    if (len != (family == AF_INET ? 4 : 16)) {
+      continue;
+    }
+    if (std::find_if(std::begin(tokens) + 1, std::end(tokens),
+                     [&target](const std::string& alias) {
+                       return util::strieq(alias, target);
+                     }) == std::end(tokens)) {
+      continue;
+    }
+    auto addr = normalizeAddress(tokens[0]);
+    if (std::find(std::begin(addrs), std::end(addrs), addr) ==
+        std::end(addrs)) {
+      addrs.push_back(addr);
+    }
+  }
+}
+
+DNSStubResolver::DNSStubResolver(int family,
+                                 std::shared_ptr<const ResolvConf> conf)
+    : family_(family),
+      type_(family == AF_INET ? dns::TYPE_A : dns::TYPE_AAAA),
+      conf_(std::move(conf)),
+      status_(STATUS_READY),
+      errorCode_(ERR_NONE),
+      candidateIndex_(0),
+      serverIndex_(0),
+      tries_(0),
+      candidateError_(ERR_NONE),
+      servfail_(false),
+      id_(0),
+      tcp_(false),
+      connected_(false),
+      sendOffset_(0)
+{
+}
+
+DNSStubResolver::~DNSStubResolver() { closeSocket(); }
+
+void DNSStubResolver::resolve(const std::string& name)
+{
+  lookupHostsFile(resolvedAddresses_, conf_->hostsFile, name, family_);
+  if (!resolvedAddresses_.empty()) {
+    resolvedTTLs_.assign(resolvedAddresses_.size(), -1);
+    status_ = STATUS_SUCCESS;
+    return;
+  }
+  status_ = STATUS_QUERYING;
+  if (conf_->servers.empty()) {
+    fail(ERR_BADQUERY);
+    return;
+  }
+  // Like the system resolver, the name with at least ndots dots is
+  // tried as is first, and the others are tried with the search
+  // domains first.  The name ending with dot is never searched.
+  candidates_.clear();
+  auto n = std::count(std::begin(name), std::end(name), '.');
+  if (!name.empty() && name.back() == '.') {
+    candidates_.push_back(name);
+  }
+  else {
+    if (n >= conf_->ndots) {
+      candidates_.push_back(name);
+    }
+    for (const auto& domain : conf_->search) {
+      if (!domain.empty()) {
+        candidates_.push_back(name + "." + domain);
+      }
+    }
+    if (n < conf_->ndots) {
+      candidates_.push_back(name);
+    }
+  }
+  candidateIndex_ = 0;
+  candidateError_ = ERR_NONE;
+  tries_ = 0;
+  servfail_ = false;
+  tcp_ = false;
+  sendQuery();
+}
+
+void DNSStubResolver::sendQuery()
+{
+  const auto& candidate = candidates_[candidateIndex_];
+  const auto& server = conf_->servers[serverIndex_];
+  ++tries_;
+  SimpleRandomizer::getInstance()->getRandomBytes(
+      reinterpret_cast<unsigned char*>(&id_), sizeof(id_));
+  auto query = dns::createQuery(id_, candidate, type_);
+  if (query.empty()) {
+    // Other candidates are longer.
+    fail(candidateError_ == ERR_NONE ? ERR_BADQUERY : candidateError_);
+    return;
+  }
+  A2_LOG_DEBUG(fmt("DNS query %s %s to %s port %u over %s, id=%u",
+                   type_ == dns::TYPE_A ? "A" : "AAAA", candidate.c_str(),
+                   server.first.c_str(), server.second, tcp_ ? "TCP" : "UDP",
+                   id_));
+  closeSocket();
+  queryTimer_ = global::wallclock();
+  try {
+    if (tcp_) {
+      socket_ = std::make_shared<SocketCore>();
+      socket_->establishConnection(server.first, server.second);
+      connected_ = false;
+      sendBuf_.clear();
+      dns::putUint16(sendBuf_, query.size());
+      sendBuf_ += query;
+      sendOffset_ = 0;
+      recvBuf_.clear();
+    }
+    else {
+      unsigned char binAddr[sizeof(struct in6_addr)];
+      int family =
+          net::getBinAddr(binAddr, server.first) == 4 ? AF_INET : AF_INET6;
+      socket_ = std::make_shared<SocketCore>(SOCK_DGRAM);
+      socket_->bind(nullptr, 0, family);
+      socket_->setNonBlockingMode();
+      socket_->writeData(query.data(), query.size(), server.first,
+                         server.second);
+    }
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_DEBUG_EX(fmt("Failed to send DNS query to %s",
+                        server.first.c_str()),
+                    e);
+    nextServer();
+  }
+}
+
+void DNSStubResolver::process(bool readable, bool writable)
+{
+  if (status_ != STATUS_QUERYING) {
+    return;
+  }
+  try {
+    if (tcp_) {
+      processTCP(writable);
+    }
+    else {
+      processUDP();
+    }
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_DEBUG_EX(fmt("DNS query to %s failed",
+                        conf_->servers[serverIndex_].first.c_str()),
+                    e);
+    nextServer();
+  }
+  if (status_ == STATUS_QUERYING &&
+      queryTimer_.difference(global::wallclock()) >= conf_->timeout) {
+    A2_LOG_DEBUG(fmt("DNS query to %s timed out",
+                     conf_->servers[serverIndex_].first.c_str()));
+    nextServer();
+  }
+}
+
+void DNSStubResolver::processUDP()
+{
+  const auto& server = conf_->servers[serverIndex_];
+  // Large enough for the responses without EDNS0.
+  unsigned char buf[4096];
+  for (;;) {
+    Endpoint sender;
+    ssize_t len = socket_->readDataFrom(buf, sizeof(buf), sender);
+    if (len == 0) {
+      if (socket_->wantRead()) {
+        break;
+      }
+      continue;
+    }
+    if (sender.port != server.second ||
+        normalizeAddress(sender.addr) != server.first) {
+      A2_LOG_DEBUG(fmt("Ignored DNS response from %s port %u",
+                       sender.addr.c_str(), sender.port));
+      continue;
+    }
+    if (handleResponse(buf, len)) {
+      return;
+    }
+  }
+}
+
+void DNSStubResolver::processTCP(bool writable)
+{
+  if (!connected_) {
+    if (!writable) {
+      return;
+    }
+    auto error = socket_->getSocketError();
+    if (!error.empty()) {
+      throw DL_RETRY_EX(fmt("Failed to connect: %s", error.c_str()));
+    }
+    connected_ = true;
+  }
+  while (sendOffset_ < sendBuf_.size()) {
+    ssize_t len = socket_->writeData(sendBuf_.data() + sendOffset_,
+                                     sendBuf_.size() - sendOffset_);
+    if (len == 0) {
+      return;
+    }
+    sendOffset_ += len;
+  }
+  unsigned char buf[4096];
+  for (;;) {
+    size_t len = sizeof(buf);
+    socket_->readData(buf, len);
+    if (len == 0) {
+      if (socket_->wantRead()) {
+        return;
+      }
+      throw DL_RETRY_EX("Got EOF from DNS server");
+    }
+    recvBuf_.append(buf, buf + len);
+    if (recvBuf_.size() < 2) {
+      continue;
+    }
+    size_t msglen = dns::getUint16(
+        reinterpret_cast<const unsigned char*>(recvBuf_.data()));
+    if (recvBuf_.size() < 2 + msglen) {
+      continue;
+    }
+    if (!handleResponse(
+            reinterpret_cast<const unsigned char*>(recvBuf_.data()) + 2,
+            msglen)) {
+      throw DL_RETRY_EX("Bad DNS response");
+    }
+    return;
+  }
+}
+
+bool DNSStubResolver::handleResponse(const unsigned char* data, size_t len)
+{
+  const auto& candidate = candidates_[candidateIndex_];
+  dns::Response res;
+  if (!dns::parseResponse(res, data, len, candidate, type_) ||
+      res.id != id_) {
+    A2_LOG_DEBUG("Ignored DNS response not matching the query");
+    return false;
+  }
+  if (res.truncated && !tcp_) {
+    A2_LOG_DEBUG("DNS response was truncated. Retrying over TCP");
+    tcp_ = true;
+    // The retry over TCP does not consume attempts.
+    --tries_;
+    sendQuery();
+    return true;
+  }
+  switch (res.rcode) {
+  case dns::RCODE_NOERROR:
+    if (res.addrs.empty()) {
+      if (candidateError_ != ERR_NXDOMAIN) {
+        candidateError_ = ERR_NODATA;
+      }
+      nextCandidate();
+      return true;
+    }
+    closeSocket();
+    for (const auto& a : res.addrs) {
+      resolvedAddresses_.push_back(a.first);
+      resolvedTTLs_.push_back(
+          static_cast<int>(std::min(a.second, static_cast<uint32_t>(INT_MAX))));
+    }
+    status_ = STATUS_SUCCESS;
+    return true;
+  case dns::RCODE_NXDOMAIN:
+    // Like glibc, NODATA for any candidate takes precedence over
+    // NXDOMAIN since the name exists.
+    if (candidateError_ == ERR_NONE) {
+      candidateError_ = ERR_NXDOMAIN;
+    }
+    nextCandidate();
+    return true;
+  case dns::RCODE_SERVFAIL:
+    servfail_ = true;
+    // fall through
+  default:
+    A2_LOG_DEBUG(fmt("DNS server %s returned rcode %d",
+                     conf_->servers[serverIndex_].first.c_str(), res.rcode));
+    nextServer();
+    return true;
+  }
+}
+
+void DNSStubResolver::nextServer()
+{
+  if (tries_ >= conf_->attempts * static_cast<int>(conf_->servers.size())) {
+    fail(servfail_ ? ERR_SERVFAIL : ERR_TIMEOUT);
+    return;
+  }
+  serverIndex_ = (serverIndex_ + 1) % conf_->servers.size();
+  tcp_ = false;
+  sendQuery();
+}
+
+void DNSStubResolver::nextCandidate()
+{
+  ++candidateIndex_;
+  if (candidateIndex_ == candidates_.size()) {
+    fail(candidateError_);
+    return;
+  }
+  tries_ = 0;
+  servfail_ = false;
+  tcp_ = false;
+  sendQuery();
+}
+
+void DNSStubResolver::fail(ERROR_CODE errorCode)
+{
+  closeSocket();
+  errorCode_ = errorCode;
+  status_ = STATUS_ERROR;
+}
+
+void DNSStubResolver::closeSocket()
+{
+  if (socket_) {
+    socket_->closeConnection();
+    socket_.reset();
+  }
+}
+
+bool DNSStubResolver::wantRead() const
+{
+  return status_ == STATUS_QUERYING && socket_ &&
+         (!tcp_ || (connected_ && sendOffset_ == sendBuf_.size()));
+}
+
+bool DNSStubResolver::wantWrite() const
+{
+  return status_ == STATUS_QUERYING && socket_ && tcp_ &&
+         (!connected_ || sendOffset_ < sendBuf_.size());
+}
+
+const char* DNSStubResolver::getError() const
+{
+  switch (errorCode_) {
+  case ERR_NONE:
+    return "";
+  case ERR_NXDOMAIN:
+    return "Domain name not found";
+  case ERR_NODATA:
+    return "DNS server returned answer with no data";
+  case ERR_SERVFAIL:
+    return "DNS server returned general failure";
+  case ERR_TIMEOUT:
+    return "Timeout while contacting DNS servers";
+  case ERR_BADQUERY:
+  default:
+    return "Misformatted domain name or no DNS server";
+  }
+}
+
+bool DNSStubResolver::isNegativeAnswer() const
+{
+  return status_ == STATUS_ERROR &&
+         (errorCode_ == ERR_NXDOMAIN || errorCode_ == ERR_NODATA ||
+          errorCode_ == ERR_SERVFAIL);
+}
+
+} // namespace aria2
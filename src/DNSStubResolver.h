@@ -0,0 +1,252 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DNS_STUB_RESOLVER_H
+#define D_DNS_STUB_RESOLVER_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class SocketCore;
+
+namespace dns {
+
+// RFC 1035 types, class and response codes.
+constexpr uint16_t TYPE_A = 1;
+constexpr uint16_t TYPE_CNAME = 5;
+constexpr uint16_t TYPE_AAAA = 28;
+constexpr uint16_t CLASS_IN = 1;
+
+constexpr int RCODE_NOERROR = 0;
+constexpr int RCODE_SERVFAIL = 2;
+constexpr int RCODE_NXDOMAIN = 3;
+
+// Returns DNS query message with ID id asking type records of name
+// with recursion desired.  Returns empty string if name cannot be
+// encoded as a domain name.
+std::string createQuery(uint16_t id, const std::string& name, uint16_t type);
+
+struct Response {
+  uint16_t id;
+  int rcode;
+  bool truncated;
+  // Addresses in numeric presentation format and their TTL in
+  // seconds.  The TTL includes the CNAME records leading to the
+  // address.
+  std::vector<std::pair<std::string, uint32_t>> addrs;
+};
+
+// Parses DNS response message data of length len which answers the
+// type query of name.  Returns false if data is malformed or its
+// question section does not match name and type.
+bool parseResponse(Response& res, const unsigned char* data, size_t len,
+                   const std::string& name, uint16_t type);
+
+} // namespace dns
+
+// Resolver configuration read from resolv.conf(5).
+struct ResolvConf {
+  // Numeric address and port of name servers.
+  std::vector<std::pair<std::string, uint16_t>> servers;
+  std::vector<std::string> search;
+  int ndots;
+  std::chrono::seconds timeout;
+  int attempts;
+  std::string hostsFile;
+
+  ResolvConf();
+};
+
+// Reads nameserver, domain, search and options lines of filename into
+// conf.  If no name server is given, 127.0.0.1 is used like the
+// system resolver does.
+void parseResolvConf(ResolvConf& conf, const std::string& filename);
+
+// Holds the configuration read from a resolv.conf(5) file, and reads
+// the file again when its modification time or size changes, so that
+// the changes made by DHCP clients or VPN software take effect
+// without restart.
+class ResolvConfLoader {
+public:
+  ResolvConfLoader(std::string filename);
+
+  // Returns the current configuration.  The file is checked with
+  // stat(2) on every call.
+  std::shared_ptr<const ResolvConf> get();
+
+private:
+  std::string filename_;
+  time_t mtime_;
+  int64_t size_;
+  std::shared_ptr<const ResolvConf> conf_;
+};
+
+// Returns the configuration read from /etc/resolv.conf.  If servers is
+// not empty, it replaces the name servers in the file.
+std::shared_ptr<const ResolvConf> getSystemResolvConf(
+    const std::vector<std::pair<std::string, uint16_t>>& servers =
+        std::vector<std::pair<std::string, uint16_t>>());
+
+// Appends addresses of family for name listed in hosts file filename
+// to addrs.
+void lookupHostsFile(std::vector<std::string>& addrs,
+                     const std::string& filename, const std::string& name,
+                     int family);
+
+// Non-blocking stub resolver which queries A or AAAA records of a name
+// to the recursive name servers in ResolvConf.  Queries are sent over
+// UDP and retried over TCP if the response is truncated.  The caller
+// watches getSocket() for the events told by wantRead() and
+// wantWrite() and calls process() when the socket is ready and
+// periodically to handle retransmission.
+class DNSStubResolver {
+public:
+  enum STATUS {
+    STATUS_READY,
+    STATUS_QUERYING,
+    STATUS_SUCCESS,
+    STATUS_ERROR,
+  };
+
+  enum ERROR_CODE {
+    ERR_NONE,
+    // The name does not exist.
+    ERR_NXDOMAIN,
+    // The name exists but has no address of the requested family.
+    ERR_NODATA,
+    // All name servers failed to answer the query.
+    ERR_SERVFAIL,
+    // No response was received.
+    ERR_TIMEOUT,
+    // The name is not a valid domain name or no name server is
+    // configured.
+    ERR_BADQUERY,
+  };
+
+  DNSStubResolver(int family, std::shared_ptr<const ResolvConf> conf);
+
+  ~DNSStubResolver();
+
+  void resolve(const std::string& name);
+
+  // readable and writable tell whether getSocket() got ready.
+  void process(bool readable, bool writable);
+
+  const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
+
+  bool wantRead() const;
+
+  bool wantWrite() const;
+
+  STATUS getStatus() const { return status_; }
+
+  const std::vector<std::string>& getResolvedAddresses() const
+  {
+    return resolvedAddresses_;
+  }
+
+  // TTL of each address in getResolvedAddresses().  -1 if the address
+  // came from the hosts file.
+  const std::vector<int>& getResolvedTTLs() const { return resolvedTTLs_; }
+
+  ERROR_CODE getErrorCode() const { return errorCode_; }
+
+  const char* getError() const;
+
+  // Returns true if the lookup failed with NXDOMAIN, NODATA or
+  // SERVFAIL.
+  bool isNegativeAnswer() const;
+
+private:
+  void sendQuery();
+
+  void processUDP();
+
+  void processTCP(bool writable);
+
+  // Handles the response to the current query.  Returns false if data
+  // is not the response to it.
+  bool handleResponse(const unsigned char* data, size_t len);
+
+  // Sends the query to the next server or fails if all attempts are
+  // used up.
+  void nextServer();
+
+  // Queries the next candidate name in search list or fails.
+  void nextCandidate();
+
+  void fail(ERROR_CODE errorCode);
+
+  void closeSocket();
+
+  int family_;
+  uint16_t type_;
+  std::shared_ptr<const ResolvConf> conf_;
+  STATUS status_;
+  ERROR_CODE errorCode_;
+  std::vector<std::string> resolvedAddresses_;
+  std::vector<int> resolvedTTLs_;
+
+  // Names to query in order, built from the name and search list.
+  std::vector<std::string> candidates_;
+  size_t candidateIndex_;
+  size_t serverIndex_;
+  // The number of queries sent for the current candidate.
+  int tries_;
+  // The error reported if all candidates fail.
+  ERROR_CODE candidateError_;
+  bool servfail_;
+
+  uint16_t id_;
+  std::shared_ptr<SocketCore> socket_;
+  bool tcp_;
+  bool connected_;
+  std::string sendBuf_;
+  size_t sendOffset_;
+  std::string recvBuf_;
+  // The time when the current query was sent.
+  Timer queryTimer_;
+};
+
+} // namespace aria2
+
+#endif // D_DNS_STUB_RESOLVER_H
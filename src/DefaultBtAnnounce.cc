@@ -419,4 +419,12 @@ void DefaultBtAnnounce::overrideMinInterval(std::chrono::seconds interval)
   minInterval_ = std::move(interval);
 }
 
+Timer DefaultBtAnnounce::getNextAnnounceTime()
+{
+  auto t = prevAnnounceTimer_;
+  t.advance(userDefinedInterval_.count() == 0 ? minInterval_
+                                              : userDefinedInterval_);
+  return t;
+}
+
 } // namespace aria2
@@ -130,6 +130,8 @@ public:
   virtual void
   overrideMinInterval(std::chrono::seconds interval) CXX11_OVERRIDE;
 
+  virtual Timer getNextAnnounceTime() CXX11_OVERRIDE;
+
   virtual void setTcpPort(uint16_t port) CXX11_OVERRIDE { tcpPort_ = port; }
 
   void setRandomizer(Randomizer* randomizer);
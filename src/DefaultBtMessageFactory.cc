@@ -84,7 +84,8 @@ DefaultBtMessageFactory::DefaultBtMessageFactory()
       routingTable_{nullptr},
       taskQueue_{nullptr},
       taskFactory_{nullptr},
-      metadataGetMode_(false)
+      metadataGetMode_(false),
+      workerPool_{nullptr}
 {
 }
 
@@ -155,6 +156,7 @@ DefaultBtMessageFactory::createBtMessage(const unsigned char* data,
       }
       m->setDownloadContext(downloadContext_);
       m->setPeerStorage(peerStorage_);
+      m->setWorkerPool(workerPool_);
       msg = std::move(m);
       break;
     }
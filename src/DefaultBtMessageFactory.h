@@ -50,6 +50,7 @@ class BtRequestFactory;
 class PeerConnection;
 class ExtensionMessageFactory;
 class DHTNode;
+class WorkerPool;
 class DHTRoutingTable;
 class DHTTaskQueue;
 class DHTTaskFactory;
@@ -82,6 +83,8 @@ private:
 
   bool metadataGetMode_;
 
+  WorkerPool* workerPool_;
+
   void setCommonProperty(AbstractBtMessage* msg);
 
 public:
@@ -178,6 +181,8 @@ public:
   void setTaskFactory(DHTTaskFactory* taskFactory);
 
   void enableMetadataGetMode() { metadataGetMode_ = true; }
+
+  void setWorkerPool(WorkerPool* workerPool) { workerPool_ = workerPool; }
 };
 
 } // namespace aria2
@@ -34,13 +34,28 @@
 /* copyright --> */
 #include "DefaultDiskWriterFactory.h"
 #include "DefaultDiskWriter.h"
+#ifdef HAVE_IO_URING
+#  include "IoUringDiskWriter.h"
+#  include "DiskIoUring.h"
+#endif // HAVE_IO_URING
 #include "a2functional.h"
 
 namespace aria2 {
 
+DefaultDiskWriterFactory::DefaultDiskWriterFactory(
+    std::shared_ptr<DiskIoUring> uring)
+    : uring_(std::move(uring))
+{
+}
+
 std::unique_ptr<DiskWriter>
 DefaultDiskWriterFactory::newDiskWriter(const std::string& filename)
 {
+#ifdef HAVE_IO_URING
+  if (uring_) {
+    return make_unique<IoUringDiskWriter>(filename, uring_);
+  }
+#endif // HAVE_IO_URING
   return make_unique<DefaultDiskWriter>(filename);
 }
 
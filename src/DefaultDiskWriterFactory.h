@@ -37,12 +37,23 @@
 
 #include "DiskWriterFactory.h"
 
+#include <memory>
+
 namespace aria2 {
 
 class DiskWriter;
+class DiskIoUring;
 
 class DefaultDiskWriterFactory : public DiskWriterFactory {
+private:
+  std::shared_ptr<DiskIoUring> uring_;
+
 public:
+  // If uring is not nullptr, and aria2 is built with io_uring
+  // support, IoUringDiskWriter using uring is created instead of
+  // DefaultDiskWriter.
+  DefaultDiskWriterFactory(std::shared_ptr<DiskIoUring> uring = nullptr);
+
   virtual std::unique_ptr<DiskWriter>
   newDiskWriter(const std::string& filename) CXX11_OVERRIDE;
 };
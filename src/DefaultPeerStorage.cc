@@ -324,10 +324,12 @@ void DefaultPeerStorage::returnPeer(const std::shared_ptr<Peer>& peer)
   }
 }
 
+namespace {
+constexpr auto CHOKE_ROUND_INTERVAL = 10_s;
+} // namespace
+
 bool DefaultPeerStorage::chokeRoundIntervalElapsed()
 {
-  constexpr auto CHOKE_ROUND_INTERVAL = 10_s;
-
   if (pieceStorage_->downloadFinished()) {
     return seederStateChoke_->getLastRound().difference(global::wallclock()) >=
            CHOKE_ROUND_INTERVAL;
@@ -337,6 +339,15 @@ bool DefaultPeerStorage::chokeRoundIntervalElapsed()
          CHOKE_ROUND_INTERVAL;
 }
 
+Timer DefaultPeerStorage::getNextChokeRoundTime()
+{
+  auto t = pieceStorage_->downloadFinished()
+               ? seederStateChoke_->getLastRound()
+               : leecherStateChoke_->getLastRound();
+  t.advance(CHOKE_ROUND_INTERVAL);
+  return t;
+}
+
 void DefaultPeerStorage::executeChoke()
 {
   if (pieceStorage_->downloadFinished()) {
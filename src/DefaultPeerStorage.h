@@ -116,6 +116,8 @@ public:
 
   virtual bool chokeRoundIntervalElapsed() CXX11_OVERRIDE;
 
+  virtual Timer getNextChokeRoundTime() CXX11_OVERRIDE;
+
   virtual void executeChoke() CXX11_OVERRIDE;
 
   void deleteUnusedPeer(size_t delSize);
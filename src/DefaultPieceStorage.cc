@@ -36,6 +36,8 @@
 
 #include <numeric>
 #include <algorithm>
+#include <cassert>
+#include <cerrno>
 
 #include "DownloadContext.h"
 #include "Piece.h"
@@ -51,6 +53,7 @@
 #include "DefaultDiskWriterFactory.h"
 #include "FileEntry.h"
 #include "DlAbortEx.h"
+#include "RecoverableException.h"
 #include "util.h"
 #include "a2functional.h"
 #include "Option.h"
@@ -67,14 +70,48 @@
 #include "SingletonHolder.h"
 #include "Notifier.h"
 #include "WrDiskCache.h"
+#include "RdDiskCache.h"
 #include "RequestGroup.h"
+#include "RequestGroupMan.h"
 #include "SimpleRandomizer.h"
+#include "WrDiskCacheEntry.h"
+#include "WorkerPool.h"
+#include "MessageDigest.h"
+#include "message_digest_helper.h"
+#include "a2io.h"
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
 
+struct DefaultPieceStorage::VerifyJob {
+  std::shared_ptr<Piece> piece;
+  int fd;
+  int64_t offset;
+  std::unique_ptr<MessageDigest> ctx;
+  std::function<void(const std::string&)> callback;
+  std::string digest;
+  // The errno of a failed read.  -1 if the file is too short.
+  int errNum;
+  bool cancelled;
+
+  VerifyJob(std::shared_ptr<Piece> piece, int fd, int64_t offset,
+            std::unique_ptr<MessageDigest> ctx,
+            std::function<void(const std::string&)> callback)
+      : piece(std::move(piece)),
+        fd(fd),
+        offset(offset),
+        ctx(std::move(ctx)),
+        callback(std::move(callback)),
+        errNum(0),
+        cancelled(false)
+  {
+  }
+
+  ~VerifyJob() { close(fd); }
+};
+
 DefaultPieceStorage::DefaultPieceStorage(
     const std::shared_ptr<DownloadContext>& downloadContext,
     const Option* option)
@@ -92,7 +129,8 @@ DefaultPieceStorage::DefaultPieceStorage(
       pieceStatMan_(std::make_shared<PieceStatMan>(
           downloadContext->getNumPieces(), true)),
       pieceSelector_(make_unique<RarestPieceSelector>(pieceStatMan_)),
-      wrDiskCache_(nullptr)
+      wrDiskCache_(nullptr),
+      rdDiskCache_(nullptr)
 {
   const std::string& pieceSelectorOpt =
       option_->get(PREF_STREAM_PIECE_SELECTOR);
@@ -114,7 +152,19 @@ DefaultPieceStorage::DefaultPieceStorage(
   }
 }
 
-DefaultPieceStorage::~DefaultPieceStorage() = default;
+DefaultPieceStorage::~DefaultPieceStorage()
+{
+  // The WrDiskCache may already be gone.  Just make sure that the
+  // completions do not touch this object.
+  for (auto& job : verifyJobs_) {
+    job->cancelled = true;
+  }
+  for (auto& w : writingPieces_) {
+    if (w.piece->getWrDiskCacheEntry()) {
+      w.piece->getWrDiskCacheEntry()->setAsyncWriteCallback(nullptr);
+    }
+  }
+}
 
 std::shared_ptr<Piece> DefaultPieceStorage::checkOutPiece(size_t index,
                                                           cuid_t cuid)
@@ -461,6 +511,24 @@ void DefaultPieceStorage::completePiece(const std::shared_ptr<Piece>& piece)
   if (!piece) {
     return;
   }
+  auto ent = piece->getWrDiskCacheEntry();
+  if (ent && ent->isAsyncWritePending()) {
+    // The file does not have the whole piece yet.  Keep the piece in
+    // use until it does, so that the piece is not advertised, uploaded
+    // or saved as complete, and the download does not finish before
+    // that.
+    if (!piece->isVerifying()) {
+      A2_LOG_DEBUG(fmt("Waiting for the data of piece index=%lu to be"
+                       " written",
+                       static_cast<unsigned long>(piece->getIndex())));
+      piece->setVerifying(true);
+      writingPieces_.push_back(WritingPiece{piece, false, 0});
+      auto p = piece.get();
+      ent->setAsyncWriteCallback(
+          [this, p](int errNum) { onPieceWritten(p, errNum); });
+    }
+    return;
+  }
   deleteUsedPiece(piece);
   //   if(!isEndGame()) {
   //     reduceUsedPieces(100);
@@ -468,6 +536,7 @@ void DefaultPieceStorage::completePiece(const std::shared_ptr<Piece>& piece)
   if (allDownloadFinished()) {
     return;
   }
+  invalidateRdDiskCache(piece->getIndex());
   bitfieldMan_->setBit(piece->getIndex());
   bitfieldMan_->unsetUseBit(piece->getIndex());
   addPieceStats(piece->getIndex());
@@ -484,6 +553,11 @@ void DefaultPieceStorage::completePiece(const std::shared_ptr<Piece>& piece)
     }
 #ifdef ENABLE_BITTORRENT
     if (downloadContext_->hasAttribute(CTX_ATTR_BT)) {
+      auto group = downloadContext_->getOwnerRequestGroup();
+      if (group && group->getRequestGroupMan()) {
+        // Wake up TrackerWatcherCommand to send completed event.
+        group->getRequestGroupMan()->requestWakeup(group->getGID());
+      }
       if (!bittorrent::getTorrentAttrs(downloadContext_)->metadata.empty()) {
 #  ifdef __MINGW32__
         // On Windows, if aria2 opens files with GENERIC_WRITE access
@@ -496,8 +570,6 @@ void DefaultPieceStorage::completePiece(const std::shared_ptr<Piece>& piece)
         diskAdaptor_->enableReadOnly();
         diskAdaptor_->openFile();
 #  endif // __MINGW32__
-        auto group = downloadContext_->getOwnerRequestGroup();
-
         util::executeHookByOptName(group, option_,
                                    PREF_ON_BT_DOWNLOAD_COMPLETE);
         SingletonHolder<Notifier>::instance()->notifyDownloadEvent(
@@ -510,6 +582,45 @@ void DefaultPieceStorage::completePiece(const std::shared_ptr<Piece>& piece)
   }
 }
 
+void DefaultPieceStorage::onPieceWritten(Piece* p, int errNum)
+{
+  auto i = std::find_if(
+      std::begin(writingPieces_), std::end(writingPieces_),
+      [p](const WritingPiece& w) { return w.piece.get() == p; });
+  assert(i != std::end(writingPieces_));
+  auto w = std::move(*i);
+  writingPieces_.erase(i);
+  auto& piece = w.piece;
+  piece->setVerifying(false);
+  auto group = downloadContext_->getOwnerRequestGroup();
+  if (errNum != 0) {
+    auto msg = fmt("Write disk cache flush failure index=%lu: %s",
+                   static_cast<unsigned long>(piece->getIndex()),
+                   util::safeStrerror(errNum).c_str());
+    A2_LOG_ERROR(msg);
+    // Download the piece again, although the download fails anyway.
+    piece->clearAllBlock(wrDiskCache_);
+    bitfieldMan_->unsetUseBit(piece->getIndex());
+    deleteUsedPiece(piece);
+    if (group) {
+      group->setLastErrorCode(errNum == ENOSPC
+                                  ? error_code::NOT_ENOUGH_DISK_SPACE
+                                  : error_code::FILE_IO_ERROR,
+                              msg.c_str());
+      group->setHaltRequested(true);
+    }
+    return;
+  }
+  completePiece(piece);
+  if (w.advertised) {
+    advertisePiece(w.cuid, piece->getIndex(), global::wallclock());
+  }
+  if (group && group->getRequestGroupMan()) {
+    // The commands may be waiting for the completion of the download.
+    group->getRequestGroupMan()->requestWakeup(group->getGID());
+  }
+}
+
 bool DefaultPieceStorage::isSelectiveDownloadingMode()
 {
   return bitfieldMan_->isFilterEnabled();
@@ -523,6 +634,10 @@ void DefaultPieceStorage::cancelPiece(const std::shared_ptr<Piece>& piece,
     return;
   }
   piece->removeUser(cuid);
+  if (piece->isVerifying()) {
+    // Keep the piece in use until its hash is verified.
+    return;
+  }
   if (!piece->getUsed()) {
     bitfieldMan_->unsetUseBit(piece->getIndex());
   }
@@ -533,6 +648,102 @@ void DefaultPieceStorage::cancelPiece(const std::shared_ptr<Piece>& piece,
   }
 }
 
+bool DefaultPieceStorage::verifyPieceInWorker(
+    const std::shared_ptr<Piece>& piece, WorkerPool* workerPool,
+    std::function<void(const std::string&)> callback)
+{
+#if defined(HAVE_PWRITE) && !defined(__MINGW32__)
+  if (!workerPool || workerPool->getNumThreads() == 0 || piece->isVerifying()) {
+    return false;
+  }
+  if (piece->getWrDiskCacheEntry()) {
+    // The worker thread reads the whole piece from the file.
+    piece->flushWrCache(wrDiskCache_);
+    if (piece->getWrDiskCacheEntry()->getError() !=
+        WrDiskCacheEntry::CACHE_ERR_SUCCESS ||
+        piece->getWrDiskCacheEntry()->isAsyncWritePending()) {
+      // The file does not have the whole piece yet.  Hash it with the
+      // data in memory instead.
+      return false;
+    }
+  }
+  int64_t offset =
+      static_cast<int64_t>(piece->getIndex()) * downloadContext_->getPieceLength();
+  int64_t fileOffset;
+  int fd;
+  try {
+    fd = getDiskAdaptor()->dupReadFd(offset, piece->getLength(), fileOffset);
+  }
+  catch (RecoverableException& e) {
+    return false;
+  }
+  if (fd == -1) {
+    return false;
+  }
+  A2_LOG_DEBUG(fmt("Verifying piece index=%lu in worker thread",
+                   static_cast<unsigned long>(piece->getIndex())));
+  auto job = std::make_shared<VerifyJob>(
+      piece, fd, fileOffset,
+      MessageDigest::create(downloadContext_->getPieceHashType()),
+      std::move(callback));
+  piece->setVerifying(true);
+  verifyJobs_.push_back(job);
+  auto length = piece->getLength();
+  workerPool->submit(
+      [job, length]() {
+        job->errNum =
+            message_digest::update(job->ctx.get(), job->fd, job->offset, length);
+        if (job->errNum == 0) {
+          job->digest = job->ctx->digest();
+        }
+      },
+      [this, job]() {
+        if (!job->cancelled) {
+          onPieceVerified(job);
+        }
+      });
+  return true;
+#else  // !HAVE_PWRITE || __MINGW32__
+  return false;
+#endif // !HAVE_PWRITE || __MINGW32__
+}
+
+void DefaultPieceStorage::onPieceVerified(const std::shared_ptr<VerifyJob>& job)
+{
+  verifyJobs_.erase(
+      std::find(std::begin(verifyJobs_), std::end(verifyJobs_), job));
+  job->piece->setVerifying(false);
+  if (job->errNum != 0) {
+    A2_LOG_ERROR(fmt("Reading piece index=%lu for verification failed: %s",
+                     static_cast<unsigned long>(job->piece->getIndex()),
+                     job->errNum == -1 ? "data is too short"
+                                       : util::safeStrerror(job->errNum).c_str()));
+  }
+  job->callback(job->digest);
+}
+
+void DefaultPieceStorage::cancelPieceVerification()
+{
+  for (auto& job : verifyJobs_) {
+    job->cancelled = true;
+    job->piece->setVerifying(false);
+    // Download the piece again rather than leaving it complete but
+    // unverified.
+    job->piece->clearAllBlock(wrDiskCache_);
+    job->piece->destroyHashContext();
+  }
+  verifyJobs_.clear();
+  for (auto& w : writingPieces_) {
+    if (w.piece->getWrDiskCacheEntry()) {
+      w.piece->getWrDiskCacheEntry()->setAsyncWriteCallback(nullptr);
+    }
+    w.piece->setVerifying(false);
+    // The data may not reach the file.
+    w.piece->clearAllBlock(wrDiskCache_);
+  }
+  writingPieces_.clear();
+}
+
 bool DefaultPieceStorage::hasPiece(size_t index)
 {
   return bitfieldMan_->isBitSet(index);
@@ -651,6 +862,7 @@ void DefaultPieceStorage::initStorage()
     multiDiskAdaptor->setFileEntries(downloadContext_->getFileEntries().begin(),
                                      downloadContext_->getFileEntries().end());
     multiDiskAdaptor->setPieceLength(downloadContext_->getPieceLength());
+    multiDiskAdaptor->setDiskWriterFactory(diskWriterFactory_);
     diskAdaptor_ = std::move(multiDiskAdaptor);
   }
   if (option_->get(PREF_FILE_ALLOCATION) == V_FALLOC) {
@@ -664,6 +876,7 @@ void DefaultPieceStorage::initStorage()
 void DefaultPieceStorage::setBitfield(const unsigned char* bitfield,
                                       size_t bitfieldLength)
 {
+  invalidateRdDiskCache();
   bitfieldMan_->setBitfield(bitfield, bitfieldLength);
   addPieceStats(bitfield, bitfieldLength);
 }
@@ -685,6 +898,8 @@ std::shared_ptr<DiskAdaptor> DefaultPieceStorage::getDiskAdaptor()
 
 WrDiskCache* DefaultPieceStorage::getWrDiskCache() { return wrDiskCache_; }
 
+RdDiskCache* DefaultPieceStorage::getRdDiskCache() { return rdDiskCache_; }
+
 void DefaultPieceStorage::flushWrDiskCacheEntry()
 {
   if (!wrDiskCache_) {
@@ -710,6 +925,14 @@ int32_t DefaultPieceStorage::getPieceLength(size_t index)
 void DefaultPieceStorage::advertisePiece(cuid_t cuid, size_t index,
                                          Timer registeredTime)
 {
+  for (auto& w : writingPieces_) {
+    if (w.piece->getIndex() == index) {
+      // Advertised when its data have been written.
+      w.advertised = true;
+      w.cuid = cuid;
+      return;
+    }
+  }
   haves_.emplace_back(nextHaveIndex_++, cuid, index, std::move(registeredTime));
 }
 
@@ -751,6 +974,7 @@ void DefaultPieceStorage::markAllPiecesDone() { bitfieldMan_->setAllBit(); }
 
 void DefaultPieceStorage::markPiecesDone(int64_t length)
 {
+  invalidateRdDiskCache();
   if (length == bitfieldMan_->getTotalLength()) {
     bitfieldMan_->setAllBit();
   }
@@ -782,9 +1006,26 @@ void DefaultPieceStorage::markPiecesDone(int64_t length)
 
 void DefaultPieceStorage::markPieceMissing(size_t index)
 {
+  invalidateRdDiskCache(index);
   bitfieldMan_->unsetBit(index);
 }
 
+void DefaultPieceStorage::invalidateRdDiskCache(size_t index)
+{
+  auto group = downloadContext_->getOwnerRequestGroup();
+  if (rdDiskCache_ && group) {
+    rdDiskCache_->remove(group->getGID(), index);
+  }
+}
+
+void DefaultPieceStorage::invalidateRdDiskCache()
+{
+  auto group = downloadContext_->getOwnerRequestGroup();
+  if (rdDiskCache_ && group) {
+    rdDiskCache_->remove(group->getGID());
+  }
+}
+
 void DefaultPieceStorage::addInFlightPiece(
     const std::vector<std::shared_ptr<Piece>>& pieces)
 {
@@ -95,6 +95,27 @@ private:
   std::unique_ptr<StreamPieceSelector> streamPieceSelector_;
 
   WrDiskCache* wrDiskCache_;
+  RdDiskCache* rdDiskCache_;
+
+  struct VerifyJob;
+  // The pieces being hashed in worker threads.
+  std::vector<std::shared_ptr<VerifyJob>> verifyJobs_;
+
+  void onPieceVerified(const std::shared_ptr<VerifyJob>& job);
+
+  struct WritingPiece {
+    std::shared_ptr<Piece> piece;
+    // true if advertisePiece() has been called for the piece.
+    bool advertised;
+    cuid_t cuid;
+  };
+  // The complete pieces whose data are still being written by
+  // DiskWriteQueue.  See completePiece().
+  std::vector<WritingPiece> writingPieces_;
+
+  // Called when the asynchronous writes of |piece| in writingPieces_
+  // have finished.  |errNum| is the errno of the failed write, or 0.
+  void onPieceWritten(Piece* piece, int errNum);
 #ifdef ENABLE_BITTORRENT
   void getMissingPiece(std::vector<std::shared_ptr<Piece>>& pieces,
                        size_t minMissingBlocks, const unsigned char* bitfield,
@@ -110,6 +131,12 @@ private:
   void deleteUsedPiece(const std::shared_ptr<Piece>& piece);
   std::shared_ptr<Piece> findUsedPiece(size_t index) const;
 
+  // Removes the piece |index| of this download from RdDiskCache,
+  // because its data on disk are being rewritten.
+  void invalidateRdDiskCache(size_t index);
+  // Removes all pieces of this download from RdDiskCache.
+  void invalidateRdDiskCache();
+
   // Returns the sum of completed length of in-flight pieces
   int64_t getInFlightPieceCompletedLength() const;
   // Returns the sum of completed length of in-flight pieces
@@ -188,6 +215,12 @@ public:
   virtual void cancelPiece(const std::shared_ptr<Piece>& piece,
                            cuid_t cuid) CXX11_OVERRIDE;
 
+  virtual bool verifyPieceInWorker(
+      const std::shared_ptr<Piece>& piece, WorkerPool* workerPool,
+      std::function<void(const std::string&)> callback) CXX11_OVERRIDE;
+
+  virtual void cancelPieceVerification() CXX11_OVERRIDE;
+
   virtual bool hasPiece(size_t index) CXX11_OVERRIDE;
 
   virtual bool isPieceUsed(size_t index) CXX11_OVERRIDE;
@@ -234,6 +267,8 @@ public:
 
   virtual WrDiskCache* getWrDiskCache() CXX11_OVERRIDE;
 
+  virtual RdDiskCache* getRdDiskCache() CXX11_OVERRIDE;
+
   virtual void flushWrDiskCacheEntry() CXX11_OVERRIDE;
 
   virtual int32_t getPieceLength(size_t index) CXX11_OVERRIDE;
@@ -300,6 +335,8 @@ public:
   std::unique_ptr<PieceSelector> popPieceSelector();
 
   void setWrDiskCache(WrDiskCache* wrDiskCache) { wrDiskCache_ = wrDiskCache; }
+
+  void setRdDiskCache(RdDiskCache* rdDiskCache) { rdDiskCache_ = rdDiskCache; }
 };
 
 } // namespace aria2
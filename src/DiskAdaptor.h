@@ -48,7 +48,9 @@ namespace aria2 {
 class FileEntry;
 class FileAllocationIterator;
 class WrDiskCacheEntry;
+class DiskWriteJob;
 class OpenedFileCounter;
+class SharedFd;
 
 class DiskAdaptor : public BinaryStream {
 public:
@@ -111,8 +113,49 @@ public:
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) = 0;
 
-  // Writes cached data to the underlying disk.
-  virtual void writeCache(const WrDiskCacheEntry* entry) = 0;
+  // Writes cached data to the underlying disk.  This is
+  // queueCache() followed by flushCache().
+  void writeCache(const WrDiskCacheEntry* entry);
+
+  // Queues the writes of the cached data of |entry|.  Writes to
+  // adjacent regions, including those of the entries queued in a row,
+  // may be merged into one system call.  The cached data must be kept
+  // until flushCache() returns.  If exception is thrown, no write is
+  // left queued.
+  virtual void queueCache(const WrDiskCacheEntry* entry) = 0;
+
+  // Completes the writes queued by queueCache().
+  virtual void flushCache() = 0;
+
+  // Fills |job| with the writes of the cached data so that they can
+  // be performed in another thread.  Returns false if it is not
+  // supported; the caller must use writeCache() instead.  The default
+  // implementation returns false.
+  virtual bool prepareWriteJob(const WrDiskCacheEntry* entry,
+                               DiskWriteJob& job)
+  {
+    return false;
+  }
+
+  // Returns a duplicate of the file descriptor of the file which
+  // contains the whole range [offset, offset + len), so that the
+  // data can be sent with sendfile(2).  The offset of the range in
+  // the file is stored in |fileOffset|.  The caller must close the
+  // returned file descriptor.  Returns -1 if it is not available.
+  // The default implementation returns -1.
+  virtual int dupReadFd(int64_t offset, size_t len, int64_t& fileOffset)
+  {
+    return -1;
+  }
+
+  // Like dupReadFd(), but returns the file descriptor shared with the
+  // other callers.  See DiskWriter::shareReadFd().  Returns nullptr if
+  // it is not available.  The default implementation returns nullptr.
+  virtual std::shared_ptr<SharedFd>
+  shareReadFd(int64_t offset, size_t len, int64_t& fileOffset)
+  {
+    return nullptr;
+  }
 
   void setFileAllocationMethod(FileAllocationMethod method)
   {
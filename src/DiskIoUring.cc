@@ -0,0 +1,177 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DiskIoUring.h"
+
+#include <sys/uio.h>
+
+#include <cassert>
+
+#include "IoUring.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "a2functional.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+// Writes up to BUFFER_SIZE bytes which cannot be merged with adjacent
+// writes are staged in one of NUM_BUFFERS registered buffers.  16KiB
+// matches the block size of BitTorrent and the size of DataCell of
+// HTTP/FTP downloads.
+constexpr size_t NUM_BUFFERS = 8;
+// The number of file table slots.  This covers the default of
+// --bt-max-open-files.  The files opened beyond it are accessed with
+// their file descriptors.
+constexpr size_t NUM_FILES = 128;
+} // namespace
+
+const uint32_t DiskIoUring::ENTRIES = 64;
+
+const size_t DiskIoUring::BUFFER_SIZE = 16_k;
+
+DiskIoUring::DiskIoUring() : ring_(make_unique<IoUring>(ENTRIES))
+{
+  if (!ring_->good()) {
+    A2_LOG_INFO("io_uring is not available. Using normal file I/O");
+    ring_.reset();
+    return;
+  }
+  // Register an empty (sparse) file table, whose slots are filled
+  // when files are opened.
+  std::vector<int> fds(NUM_FILES, -1);
+  int rv = ring_->registerFiles(fds.data(), fds.size());
+  if (rv == 0) {
+    for (size_t i = NUM_FILES; i > 0; --i) {
+      freeFiles_.push_back(i - 1);
+    }
+  }
+  else {
+    A2_LOG_DEBUG(fmt("Registering io_uring files failed: %s",
+                     util::safeStrerror(-rv).c_str()));
+  }
+  buffers_ = make_unique<unsigned char[]>(NUM_BUFFERS * BUFFER_SIZE);
+  struct iovec iovs[NUM_BUFFERS];
+  for (size_t i = 0; i < NUM_BUFFERS; ++i) {
+    iovs[i].iov_base = buffers_.get() + i * BUFFER_SIZE;
+    iovs[i].iov_len = BUFFER_SIZE;
+  }
+  rv = ring_->registerBuffers(iovs, NUM_BUFFERS);
+  if (rv == 0) {
+    for (size_t i = NUM_BUFFERS; i > 0; --i) {
+      freeBuffers_.push_back(i - 1);
+    }
+  }
+  else {
+    // Registration may fail due to RLIMIT_MEMLOCK.  Writes are still
+    // performed through io_uring without fixed buffers.
+    A2_LOG_DEBUG(fmt("Registering io_uring buffers failed: %s",
+                     util::safeStrerror(-rv).c_str()));
+    buffers_.reset();
+  }
+  A2_LOG_DEBUG(fmt("Using io_uring for disk I/O, fixedFiles=%d, "
+                   "fixedBuffers=%d",
+                   !freeFiles_.empty(), static_cast<bool>(buffers_)));
+}
+
+DiskIoUring::~DiskIoUring() {}
+
+bool DiskIoUring::good() const { return ring_ != nullptr; }
+
+void DiskIoUring::shutdown()
+{
+  // Closing io_uring file descriptor releases registered files and
+  // buffers.
+  ring_.reset();
+  freeFiles_.clear();
+  freeBuffers_.clear();
+}
+
+int DiskIoUring::registerFile(int fd)
+{
+  if (!ring_ || freeFiles_.empty()) {
+    return -1;
+  }
+  int index = freeFiles_.back();
+  int rv = ring_->updateFiles(index, &fd, 1);
+  if (rv < 0) {
+    A2_LOG_DEBUG(fmt("Registering io_uring file failed: %s",
+                     util::safeStrerror(-rv).c_str()));
+    return -1;
+  }
+  freeFiles_.pop_back();
+  return index;
+}
+
+void DiskIoUring::unregisterFile(int index)
+{
+  if (!ring_) {
+    return;
+  }
+  int fd = -1;
+  ring_->updateFiles(index, &fd, 1);
+  freeFiles_.push_back(index);
+}
+
+int DiskIoUring::getBuffer()
+{
+  if (freeBuffers_.empty()) {
+    return -1;
+  }
+  int index = freeBuffers_.back();
+  freeBuffers_.pop_back();
+  return index;
+}
+
+void DiskIoUring::putBuffer(int index)
+{
+  assert(index >= 0 && static_cast<size_t>(index) < NUM_BUFFERS);
+  if (ring_) {
+    freeBuffers_.push_back(index);
+  }
+}
+
+unsigned char* DiskIoUring::getBufferData(int index) const
+{
+  return buffers_.get() + index * BUFFER_SIZE;
+}
+
+uint64_t DiskIoUring::getNumEnterCalls() const
+{
+  return ring_ ? ring_->getNumEnterCalls() : 0;
+}
+
+} // namespace aria2
@@ -0,0 +1,106 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DISK_IO_URING_H
+#define D_DISK_IO_URING_H
+
+#include "common.h"
+
+#include <memory>
+#include <vector>
+
+namespace aria2 {
+
+class IoUring;
+
+// The io_uring instance shared by the IoUringDiskWriters of one
+// download session, together with a pool of registered (fixed)
+// buffers and a table of registered files.  Writers use the ring
+// synchronously: they submit their requests and wait for all of them
+// to complete before returning, so that requests of different writers
+// are never in flight at the same time.
+class DiskIoUring {
+public:
+  DiskIoUring();
+
+  ~DiskIoUring();
+
+  DiskIoUring(const DiskIoUring&) = delete;
+  DiskIoUring& operator=(const DiskIoUring&) = delete;
+
+  // Returns true if the ring is usable.
+  bool good() const;
+
+  IoUring* getRing() const { return ring_.get(); }
+
+  // Drops the ring after an unexpected error.  The writers fall back
+  // to normal file I/O.
+  void shutdown();
+
+  // Registers |fd| to the file table, and returns its index.  Returns
+  // -1 if the table is full or not available.
+  int registerFile(int fd);
+
+  // Removes the file at |index| from the file table.
+  void unregisterFile(int index);
+
+  // Returns the index of a free fixed buffer, or -1 if none is left.
+  int getBuffer();
+
+  // Returns the free buffer |index| to the pool.
+  void putBuffer(int index);
+
+  unsigned char* getBufferData(int index) const;
+
+  // Returns the number of io_uring_enter(2) calls made so far.
+  uint64_t getNumEnterCalls() const;
+
+  // The number of submission queue entries, which is also the maximum
+  // number of requests in flight.
+  static const uint32_t ENTRIES;
+
+  // The size of a fixed buffer.
+  static const size_t BUFFER_SIZE;
+
+private:
+  std::unique_ptr<IoUring> ring_;
+  std::unique_ptr<unsigned char[]> buffers_;
+  std::vector<int> freeBuffers_;
+  // Free slots of the file table.
+  std::vector<int> freeFiles_;
+};
+
+} // namespace aria2
+
+#endif // D_DISK_IO_URING_H
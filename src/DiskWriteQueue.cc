@@ -0,0 +1,204 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DiskWriteQueue.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "DownloadEngine.h"
+#include "WorkerPool.h"
+#include "DiskAdaptor.h"
+#include "DiskWriter.h"
+#include "RecoverableException.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+DiskWriteJob::DiskWriteJob() : seq_(0), errNum_(0), done_(false) {}
+
+DiskWriteJob::~DiskWriteJob()
+{
+  if (state_ && !done_) {
+    // Discarded without being run; the data is lost.
+    state_->finish(ECANCELED);
+  }
+  for (auto& p : fds_) {
+    close(p.second);
+  }
+  for (auto& e : cells_) {
+    WrDiskCacheEntry::freeData(e->data);
+    delete e;
+  }
+}
+
+bool DiskWriteJob::addWrite(DiskWriter* diskWriter, int64_t offset,
+                            const unsigned char* data, size_t len)
+{
+  int fd = -1;
+  for (auto& p : fds_) {
+    if (p.first == diskWriter) {
+      fd = p.second;
+      break;
+    }
+  }
+  if (fd == -1) {
+    fd = diskWriter->dupFd();
+    if (fd == -1) {
+      return false;
+    }
+    fds_.push_back(std::make_pair(diskWriter, fd));
+  }
+  writes_.push_back(Write{fd, offset, data, len});
+  return true;
+}
+
+void DiskWriteJob::run()
+{
+  if (state_) {
+    state_->waitTurn(seq_);
+  }
+#ifdef HAVE_PWRITEV
+  // Cells are added in the order of offset.  Merge the adjacent
+  // writes to the same file into one pwritev(2) call.
+  std::vector<struct iovec> iovs;
+  for (size_t i = 0; i < writes_.size() && errNum_ == 0;) {
+    auto& w = writes_[i];
+    auto end = w.offset;
+    iovs.clear();
+    for (; i < writes_.size() && writes_[i].fd == w.fd &&
+           writes_[i].offset == end;
+         ++i) {
+      iovs.push_back({const_cast<unsigned char*>(writes_[i].data),
+                      writes_[i].len});
+      end += writes_[i].len;
+    }
+    errNum_ = util::pwritevAll(w.fd, iovs.data(), iovs.size(), w.offset);
+  }
+#elif defined(HAVE_PWRITE)
+  for (auto& w : writes_) {
+    size_t off = 0;
+    while (off < w.len) {
+      auto n = pwrite(w.fd, w.data + off, w.len - off, w.offset + off);
+      if (n == -1) {
+        if (errno == EINTR) {
+          continue;
+        }
+        errNum_ = errno;
+        break;
+      }
+      off += n;
+    }
+    if (errNum_ != 0) {
+      break;
+    }
+  }
+#else  // !HAVE_PWRITE
+  // DiskWriter::dupFd() never succeeds without pwrite(2).
+  errNum_ = ENOSYS;
+#endif // !HAVE_PWRITE
+  done_ = true;
+  if (state_) {
+    state_->finish(errNum_);
+  }
+}
+
+void DiskWriteJob::setState(
+    std::shared_ptr<WrDiskCacheEntry::AsyncWriteState> state, uint64_t seq)
+{
+  state_ = std::move(state);
+  seq_ = seq;
+}
+
+void DiskWriteJob::release()
+{
+  if (state_) {
+    state_->release(seq_);
+    state_->checkDone();
+  }
+}
+
+DiskWriteQueue::DiskWriteQueue(DownloadEngine* e, size_t limit)
+    : e_(e), limit_(limit), size_(0)
+{
+}
+
+bool DiskWriteQueue::push(WrDiskCacheEntry* ent)
+{
+  auto len = ent->getSize();
+  if (len == 0) {
+    return true;
+  }
+  auto job = std::make_shared<DiskWriteJob>();
+  try {
+    if (!ent->getDiskAdaptor()->prepareWriteJob(ent, *job)) {
+      return false;
+    }
+  }
+  catch (RecoverableException& e) {
+    // Let the synchronous write report the error.
+    return false;
+  }
+  uint64_t seq;
+  auto state = ent->startAsyncWrite(job->getDataCells(), seq);
+  job->setState(std::move(state), seq);
+  size_ += len;
+  A2_LOG_DEBUG(fmt("Queued async cache flush size=%lu, queue=%lu",
+                   static_cast<unsigned long>(len),
+                   static_cast<unsigned long>(size_)));
+  e_->getWorkerPool()->submit([job]() { job->run(); },
+                              [this, job, len]() { onComplete(*job, len); });
+  return true;
+}
+
+void DiskWriteQueue::onComplete(DiskWriteJob& job, size_t len)
+{
+  job.release();
+  auto full = isFull();
+  size_ -= len;
+  if (job.getErrNum() != 0) {
+    A2_LOG_ERROR(fmt("Error when trying to flush write cache: %s",
+                     util::safeStrerror(job.getErrNum()).c_str()));
+  }
+  if (full && !isFull()) {
+    // Wake up the commands which stopped reading from sockets.
+    e_->setRefreshInterval(std::chrono::milliseconds(0));
+  }
+}
+
+} // namespace aria2
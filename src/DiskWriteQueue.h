@@ -0,0 +1,140 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DISK_WRITE_QUEUE_H
+#define D_DISK_WRITE_QUEUE_H
+
+#include "common.h"
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include "WrDiskCacheEntry.h"
+
+namespace aria2 {
+
+class DownloadEngine;
+class DiskWriter;
+
+// Writes of cached data performed in a worker thread.  DiskAdaptor
+// fills this object in DiskAdaptor::prepareWriteJob().
+class DiskWriteJob {
+public:
+  DiskWriteJob();
+
+  // Closes the file descriptors and deletes the data cells.  If run()
+  // has not been called, the job is reported to the state as failed.
+  ~DiskWriteJob();
+
+  DiskWriteJob(const DiskWriteJob&) = delete;
+  DiskWriteJob& operator=(const DiskWriteJob&) = delete;
+
+  // Adds the write of [data, data + len) at |offset| of the file
+  // opened by |diskWriter|.  Returns false if the file cannot be
+  // written from another thread.
+  bool addWrite(DiskWriter* diskWriter, int64_t offset,
+                const unsigned char* data, size_t len);
+
+  // Waits for the earlier jobs of the same entry, performs the writes
+  // and finishes the state.  This function is called in a worker
+  // thread.
+  void run();
+
+  // Returns the errno of the failed write, or 0.
+  int getErrNum() const { return errNum_; }
+
+  // The data cells written by this job, which are deleted with this
+  // object.
+  WrDiskCacheEntry::DataCellSet& getDataCells() { return cells_; }
+
+  // Sets the state of the entry whose data this job writes, and the
+  // sequence number returned by WrDiskCacheEntry::startAsyncWrite().
+  void setState(std::shared_ptr<WrDiskCacheEntry::AsyncWriteState> state,
+                uint64_t seq);
+
+  // Tells the state that the data of this job are no longer needed by
+  // the event loop thread, and notifies the owner of the entry if all
+  // its writes have finished.
+  void release();
+
+private:
+  struct Write {
+    int fd;
+    int64_t offset;
+    const unsigned char* data;
+    size_t len;
+  };
+
+  // Pairs of DiskWriter and the duplicate of its file descriptor.
+  std::vector<std::pair<DiskWriter*, int>> fds_;
+  std::vector<Write> writes_;
+  WrDiskCacheEntry::DataCellSet cells_;
+  std::shared_ptr<WrDiskCacheEntry::AsyncWriteState> state_;
+  uint64_t seq_;
+  int errNum_;
+  bool done_;
+};
+
+// DiskWriteQueue writes the data evicted from WrDiskCache in
+// WorkerPool's threads, so that a slow disk does not stall the event
+// loop.  The number of bytes being written is bounded.  When it
+// reaches the limit, isFull() returns true and the download commands
+// stop reading from sockets until it drains.
+class DiskWriteQueue {
+public:
+  DiskWriteQueue(DownloadEngine* e, size_t limit);
+
+  // Takes the cached data of |ent| and writes it asynchronously.
+  // Returns false if the data cannot be written asynchronously, for
+  // example, the file is memory mapped.  In that case, the data is
+  // left in |ent| and the caller must write it synchronously.
+  bool push(WrDiskCacheEntry* ent);
+
+  bool isFull() const { return size_ >= limit_; }
+
+  // Returns the number of bytes being written.
+  size_t getSize() const { return size_; }
+
+private:
+  void onComplete(DiskWriteJob& job, size_t len);
+
+  DownloadEngine* e_;
+  size_t limit_;
+  size_t size_;
+};
+
+} // namespace aria2
+
+#endif // D_DISK_WRITE_QUEUE_H
@@ -37,8 +37,12 @@
 
 #include "BinaryStream.h"
 
+#include <memory>
+
 namespace aria2 {
 
+class SharedFd;
+
 /**
  * Interface for writing to a binary stream of bytes.
  *
@@ -85,6 +89,42 @@ public:
 
   // Drops cache in range [offset, offset + len)
   virtual void dropCache(int64_t len, int64_t offset) {}
+
+  // Returns a duplicate of the file descriptor of the opened file, so
+  // that another thread can write to the file with pwrite(2) even if
+  // this object closes the file in the meantime.  The caller must
+  // close the returned file descriptor.  Returns -1 if it is not
+  // available.  The default implementation returns -1.
+  virtual int dupFd() { return -1; }
+
+  // Returns a duplicate of the file descriptor of the opened file to
+  // send its data with sendfile(2).  Unlike dupFd(), the file may be
+  // opened in read-only mode.  The caller must close the returned
+  // file descriptor.  Returns -1 if it is not available.  The default
+  // implementation returns -1.
+  virtual int dupReadFd() { return -1; }
+
+  // Returns the file descriptor like dupReadFd(), but the same one is
+  // returned while the previous one is still referenced, so that
+  // the data queued to be sent do not take a file descriptor each.
+  // Returns nullptr if it is not available.  The default
+  // implementation returns nullptr.
+  virtual std::shared_ptr<SharedFd> shareReadFd() { return nullptr; }
+
+  // Writes data like writeData(), but the write may be deferred until
+  // flushWrites() is called, so that the implementation can submit
+  // several writes to the kernel at once.  data must be kept valid
+  // until flushWrites() returns.  The default implementation just
+  // calls writeData().
+  virtual void queueWrite(const unsigned char* data, size_t len,
+                          int64_t offset)
+  {
+    writeData(data, len, offset);
+  }
+
+  // Completes the writes queued by queueWrite().  Throws exception if
+  // any of them failed.  The default implementation does nothing.
+  virtual void flushWrites() {}
 };
 
 } // namespace aria2
@@ -109,6 +109,12 @@ DownloadCommand::~DownloadCommand()
 {
   peerStat_->downloadStop();
   getSegmentMan()->updateFastestPeerStat(peerStat_);
+  const auto& recvBuf = getSocketRecvBuffer();
+  A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - Received %" PRIu64
+                   " bytes in %" PRIu64 " read calls, buffer size=%lu",
+                   getCuid(), recvBuf->getRecvBytes(),
+                   recvBuf->getRecvCount(),
+                   static_cast<unsigned long>(recvBuf->getCapacity())));
 }
 
 namespace {
@@ -135,7 +141,8 @@ bool DownloadCommand::executeInternal()
   if (getDownloadEngine()
           ->getRequestGroupMan()
           ->doesOverallDownloadSpeedExceed() ||
-      getRequestGroup()->doesDownloadSpeedExceed()) {
+      getRequestGroup()->doesDownloadSpeedExceed() ||
+      getDownloadEngine()->getRequestGroupMan()->isWriteQueueFull()) {
     addCommandSelf();
     disableReadCheckSocket();
     disableWriteCheckSocket();
@@ -147,56 +154,10 @@ bool DownloadCommand::executeInternal()
       getPieceStorage()->getDiskAdaptor();
   std::shared_ptr<Segment> segment = getSegments().front();
   bool eof = false;
-  if (getSocketRecvBuffer()->bufferEmpty()) {
-    // Only read from socket when buffer is empty.  Imagine that When
-    // segment length is *short* and we are using HTTP pilelining.  We
-    // issued 2 requests in pipeline. When reading first response
-    // header, we may read its response body and 2nd response header
-    // and 2nd response body in buffer if they are small enough to fit
-    // in buffer. And then server may sends EOF.  In this case, we
-    // read data from socket here, we will get EOF and leaves 2nd
-    // response unprocessed.  To prevent this, we don't read from
-    // socket when buffer is not empty.
-    eof = getSocketRecvBuffer()->recv() == 0 && !getSocket()->wantRead() &&
-          !getSocket()->wantWrite();
-  }
-  if (!eof) {
-    size_t bufSize;
-    if (sinkFilterOnly_) {
-      if (segment->getLength() > 0) {
-        if (segment->getPosition() + segment->getLength() <=
-            getFileEntry()->getLastOffset()) {
-          bufSize = std::min(static_cast<size_t>(segment->getLength() -
-                                                 segment->getWrittenLength()),
-                             getSocketRecvBuffer()->getBufferLength());
-        }
-        else {
-          bufSize =
-              std::min(static_cast<size_t>(getFileEntry()->getLastOffset() -
-                                           segment->getPositionToWrite()),
-                       getSocketRecvBuffer()->getBufferLength());
-        }
-      }
-      else {
-        bufSize = getSocketRecvBuffer()->getBufferLength();
-      }
-      streamFilter_->transform(diskAdaptor, segment,
-                               getSocketRecvBuffer()->getBuffer(), bufSize);
-    }
-    else {
-      // It is possible that segment is completed but we have some bytes
-      // of stream to read. For example, chunked encoding has "0"+CRLF
-      // after data. After we read data(at this moment segment is
-      // completed), we need another 3bytes(or more if it has trailers).
-      streamFilter_->transform(diskAdaptor, segment,
-                               getSocketRecvBuffer()->getBuffer(),
-                               getSocketRecvBuffer()->getBufferLength());
-      bufSize = streamFilter_->getBytesProcessed();
-    }
-    getSocketRecvBuffer()->drain(bufSize);
-    peerStat_->updateDownload(bufSize);
-    getDownloadContext()->updateDownload(bufSize);
-  }
+  size_t n = receiveBody(segment, eof);
+  peerStat_->updateDownload(n);
+  getDownloadContext()->updateDownload(n);
+
   bool segmentPartComplete = false;
   // Note that GrowSegment::complete() always returns false.
   if (sinkFilterOnly_) {
@@ -294,6 +255,82 @@ bool DownloadCommand::executeInternal()
   }
 }
 
+size_t DownloadCommand::receiveBody(const std::shared_ptr<Segment>& segment,
+                                    bool& eof)
+{
+  const std::shared_ptr<DiskAdaptor>& diskAdaptor =
+      getPieceStorage()->getDiskAdaptor();
+  size_t n = 0;
+  if (sinkFilterOnly_ && segment->getLength() > 0 &&
+      segment->getPiece()->getWrDiskCacheEntry() &&
+      getSocketRecvBuffer()->bufferEmpty()) {
+    // Receive data directly into write disk cache, skipping the copy
+    // through SocketRecvBuffer.  The same condition as below applies
+    // here: we only read from socket when buffer is empty.
+    size_t maxlen = getSinkWriteLength(segment);
+    if (maxlen > 0) {
+      n = static_cast<SinkStreamFilter*>(streamFilter_.get())
+              ->receive(getSocketRecvBuffer().get(), segment, maxlen);
+      eof = n == 0 && !getSocket()->wantRead() && !getSocket()->wantWrite();
+    }
+  }
+  else {
+    if (getSocketRecvBuffer()->bufferEmpty()) {
+      // Only read from socket when buffer is empty.  Imagine that
+      // When segment length is *short* and we are using HTTP
+      // pilelining.  We issued 2 requests in pipeline. When reading
+      // first response header, we may read its response body and 2nd
+      // response header and 2nd response body in buffer if they are
+      // small enough to fit in buffer. And then server may sends
+      // EOF.  In this case, we read data from socket here, we will
+      // get EOF and leaves 2nd response unprocessed.  To prevent
+      // this, we don't read from socket when buffer is not empty.
+      eof = getSocketRecvBuffer()->recv() == 0 &&
+            !getSocket()->wantRead() && !getSocket()->wantWrite();
+    }
+    if (!eof) {
+      size_t bufSize;
+      if (sinkFilterOnly_) {
+        if (segment->getLength() > 0) {
+          bufSize = std::min(getSinkWriteLength(segment),
+                             getSocketRecvBuffer()->getBufferLength());
+        }
+        else {
+          bufSize = getSocketRecvBuffer()->getBufferLength();
+        }
+        streamFilter_->transform(diskAdaptor, segment,
+                                 getSocketRecvBuffer()->getBuffer(), bufSize);
+      }
+      else {
+        // It is possible that segment is completed but we have some
+        // bytes of stream to read. For example, chunked encoding has
+        // "0"+CRLF after data. After we read data(at this moment
+        // segment is completed), we need another 3bytes(or more if it
+        // has trailers).
+        streamFilter_->transform(diskAdaptor, segment,
+                                 getSocketRecvBuffer()->getBuffer(),
+                                 getSocketRecvBuffer()->getBufferLength());
+        bufSize = streamFilter_->getBytesProcessed();
+      }
+      getSocketRecvBuffer()->drain(bufSize);
+      n = bufSize;
+    }
+  }
+  return n;
+}
+
+size_t
+DownloadCommand::getSinkWriteLength(const std::shared_ptr<Segment>& segment)
+{
+  if (segment->getPosition() + segment->getLength() <=
+      getFileEntry()->getLastOffset()) {
+    return segment->getLength() - segment->getWrittenLength();
+  }
+  else {
+    return getFileEntry()->getLastOffset() - segment->getPositionToWrite();
+  }
+}
+
 bool DownloadCommand::shouldEnableWriteCheck()
 {
   return getSocket()->wantWrite();
@@ -72,6 +72,18 @@ private:
 protected:
   virtual bool executeInternal() CXX11_OVERRIDE;
 
+  // Reads response body from the connection and writes it to
+  // |segment| through the stream filter.  Returns the number of bytes
+  // received.  |eof| is set to true if the remote endpoint has no
+  // more data to send.
+  virtual size_t receiveBody(const std::shared_ptr<Segment>& segment,
+                             bool& eof);
+
+  // Returns the number of bytes which can be written to |segment|
+  // without crossing the end of segment or file.  Only meaningful
+  // when sinkFilterOnly_ is true and segment->getLength() > 0.
+  size_t getSinkWriteLength(const std::shared_ptr<Segment>& segment);
+
   virtual bool noCheck() const CXX11_OVERRIDE;
 
   virtual bool prepareForNextSegment();
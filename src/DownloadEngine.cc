@@ -50,6 +50,7 @@
 #include "LogFactory.h"
 #include "Logger.h"
 #include "SocketCore.h"
+#include "SocketPool.h"
 #include "util.h"
 #include "a2functional.h"
 #include "DlAbortEx.h"
@@ -73,8 +74,12 @@
 #ifdef ENABLE_WEBSOCKET
 #  include "WebSocketSessionMan.h"
 #endif // ENABLE_WEBSOCKET
+#ifdef ENABLE_HTTP2
+#  include "Http2Session.h"
+#endif // ENABLE_HTTP2
 #include "Option.h"
 #include "util_security.h"
+#include "WorkerPool.h"
 
 namespace aria2 {
 
@@ -91,15 +96,39 @@ volatile sig_atomic_t globalHaltRequested = 0;
 } // namespace global
 
 namespace {
-constexpr auto DEFAULT_REFRESH_INTERVAL = 1_s;
+// The resolution of the deadline of the commands added by
+// addTimerCommand() and the wake up time of the commands.
+constexpr auto TIMER_COMMAND_TICK = 100_ms;
+// The upper limit of the time waitData() waits for an event.  Signals
+// interrupt EventPoll::poll(), except for the one which arrives just
+// before it is called.  This limit bounds the delay of the latter.
+#ifdef __MINGW32__
+// Signal handlers run in another thread and cannot interrupt poll.
+constexpr auto MAX_WAIT_INTERVAL = 1_s;
+#else  // !__MINGW32__
+constexpr auto MAX_WAIT_INTERVAL = 60_s;
+#endif // !__MINGW32__
+} // namespace
+
+namespace {
+// WorkerPool's wakeup file descriptor is registered to EventPoll with
+// this command.  It is never executed; EventPoll just marks it and
+// the engine processes the completions after each poll.
+class WorkerPoolWakeupCommand : public Command {
+public:
+  WorkerPoolWakeupCommand(cuid_t cuid) : Command(cuid) {}
+
+  virtual bool execute() CXX11_OVERRIDE { return false; }
+};
 } // namespace
 
 DownloadEngine::DownloadEngine(std::unique_ptr<EventPoll> eventPoll)
     : eventPoll_(std::move(eventPoll)),
       haltRequested_(0),
+      socketPool_(make_unique<SocketPool>()),
       noWait_(true),
-      refreshInterval_(DEFAULT_REFRESH_INTERVAL),
-      lastRefresh_(Timer::zero()),
+      refreshRequested_(false),
+      refreshTime_(Timer::zero()),
       cookieStorage_(make_unique<CookieStorage>()),
 #ifdef ENABLE_BITTORRENT
       btRegistry_(make_unique<BtRegistry>()),
@@ -108,7 +137,12 @@ DownloadEngine::DownloadEngine(std::unique_ptr<EventPoll> eventPoll)
       asyncDNSServers_(nullptr),
 #endif // HAVE_ARES_ADDR_NODE
       dnsCache_(make_unique<DNSCache>()),
-      option_(nullptr)
+      option_(nullptr),
+      timerWheel_(TIMER_COMMAND_TICK, global::wallclock()),
+      nextCommandSerial_(1),
+      executingCommand_(nullptr),
+      workerPoolWakeupCommand_(make_unique<WorkerPoolWakeupCommand>(0)),
+      workerPool_(make_unique<WorkerPool>(0))
 {
   unsigned char sessionId[20];
   util::generateRandomKey(sessionId);
@@ -117,26 +151,132 @@ DownloadEngine::DownloadEngine(std::unique_ptr<EventPoll> eventPoll)
 
 DownloadEngine::~DownloadEngine()
 {
+  setWorkerPool(nullptr);
 #ifdef HAVE_ARES_ADDR_NODE
   setAsyncDNSServers(nullptr);
 #endif // HAVE_ARES_ADDR_NODE
+  // The commands may change the status of each other while they are
+  // destroyed.
+  for (auto& i : commands_) {
+    i.second->engine_ = nullptr;
+  }
+  for (auto& command : routineCommands_) {
+    command->engine_ = nullptr;
+  }
 }
 
-namespace {
-void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
-                    Command::STATUS statusFilter)
+void DownloadEngine::attachCommand(Command* command, bool routine)
 {
-  size_t max = commands.size();
-  for (size_t i = 0; i < max; ++i) {
-    auto com = std::move(commands.front());
-    commands.pop_front();
-    if (!com->statusMatch(statusFilter)) {
+  if (command->serial_ == 0) {
+    command->serial_ = nextCommandSerial_++;
+  }
+  command->engine_ = this;
+  command->routine_ = routine;
+  // The command added by the other one, for example, the command
+  // which has been waiting for the file allocation, has to check its
+  // state.  Only the command which adds itself back waits for an
+  // event or its wake up time.
+  if (command != executingCommand_ ||
+      command->statusMatch(Command::STATUS_ACTIVE)) {
+    markCommandReady(command);
+  }
+  armCommand(command);
+}
+
+std::unique_ptr<Command> DownloadEngine::detachCommand(uint64_t serial)
+{
+  auto i = commands_.find(serial);
+  if (i == std::end(commands_)) {
+    return nullptr;
+  }
+  auto command = std::move((*i).second);
+  commands_.erase(i);
+  command->engine_ = nullptr;
+  command->ready_ = false;
+  return command;
+}
+
+void DownloadEngine::markCommandReady(Command* command)
+{
+  if (command->routine_ || command->ready_) {
+    return;
+  }
+  command->ready_ = true;
+  readyCommands_.push_back(command);
+}
+
+void DownloadEngine::armCommand(Command* command)
+{
+  auto t = Timer::zero();
+  // The wake up time of the ready command is cleared before it is
+  // executed.
+  if (command->ready_ || !command->getWakeupTime(t)) {
+    return;
+  }
+  // The entry which has already expired may have been ignored while
+  // command was not in commands_.
+  if (command->armed_ && command->armedTime_ <= t &&
+      global::wallclock() < command->armedTime_) {
+    return;
+  }
+  command->armed_ = true;
+  command->armedTime_ = t;
+  timerWheel_.add(command->serial_, t);
+}
+
+void DownloadEngine::onCommandTimer(Command* command)
+{
+  if (command->armed_ && global::wallclock() < command->armedTime_) {
+    // Superseded by the entry which expires earlier.
+    return;
+  }
+  command->armed_ = false;
+  auto t = Timer::zero();
+  if (!command->getWakeupTime(t)) {
+    return;
+  }
+  if (t <= global::wallclock()) {
+    markCommandReady(command);
+  }
+  else {
+    armCommand(command);
+  }
+}
+
+void DownloadEngine::executeCommand()
+{
+  std::vector<Command*> ready;
+  ready.swap(readyCommands_);
+  for (auto command : ready) {
+    auto com = detachCommand(command->serial_);
+    com->transitStatus();
+    com->clearWakeupTime();
+    executingCommand_ = com.get();
+    auto done = com->execute();
+    executingCommand_ = nullptr;
+    if (done) {
+      com.reset();
+    }
+    else {
       com->clearIOEvents();
-      commands.push_back(std::move(com));
-      continue;
+      com.release();
     }
+  }
+}
+
+void DownloadEngine::executeRoutineCommand()
+{
+  size_t max = routineCommands_.size();
+  for (size_t i = 0; i < max; ++i) {
+    auto com = std::move(routineCommands_.front());
+    routineCommands_.pop_front();
+    com->engine_ = nullptr;
     com->transitStatus();
-    if (com->execute()) {
+    com->clearWakeupTime();
+    executingCommand_ = com.get();
+    auto done = com->execute();
+    executingCommand_ = nullptr;
+    if (done) {
       com.reset();
     }
     else {
@@ -145,7 +285,6 @@ void executeCommand(std::deque<std::unique_ptr<Command>>& commands,
     }
   }
 }
-} // namespace
 
 namespace {
 class GlobalHaltRequestedFinalizer {
@@ -166,23 +305,35 @@ private:
 int DownloadEngine::run(bool oneshot)
 {
   GlobalHaltRequestedFinalizer ghrf(oneshot);
-  while (!commands_.empty() || !routineCommands_.empty()) {
-    if (!commands_.empty()) {
+  while (!commands_.empty() || !routineCommands_.empty() ||
+         !timerCommands_.empty()) {
+    if (!commands_.empty() || !timerCommands_.empty()) {
       waitData();
     }
     noWait_ = false;
     global::wallclock().reset();
+    workerPool_->processCompletions();
     calculateStatistics();
-    if (lastRefresh_.difference(global::wallclock()) + A2_DELTA_MILLIS >=
-        refreshInterval_) {
-      refreshInterval_ = DEFAULT_REFRESH_INTERVAL;
-      lastRefresh_ = global::wallclock();
-      executeCommand(commands_, Command::STATUS_ALL);
+    if (requestGroupMan_) {
+      auto gids = requestGroupMan_->takeWakeupRequests();
+      if (!gids.empty()) {
+        for (auto gid : gids) {
+          wakeupCommands(gid);
+        }
+        // The other commands of the downloads have to know the change
+        // too.
+        setRefreshInterval(std::chrono::milliseconds(0));
+      }
     }
-    else {
-      executeCommand(commands_, Command::STATUS_ACTIVE);
+    wakeupTimerCommands();
+    if (refreshRequested_ && refreshTime_ <= global::wallclock()) {
+      refreshRequested_ = false;
+      for (auto& i : commands_) {
+        markCommandReady(i.second.get());
+      }
     }
-    executeCommand(routineCommands_, Command::STATUS_ALL);
+    executeCommand();
+    executeRoutineCommand();
     afterEachIteration();
     if (!noWait_ && oneshot) {
       return 1;
@@ -192,15 +343,48 @@ int DownloadEngine::run(bool oneshot)
   return 0;
 }
 
+bool DownloadEngine::getNextWakeup(Timer& next) const
+{
+  bool found = false;
+  auto t = Timer::zero();
+  if (timerWheel_.getNextExpiry(t) && (!found || t < next)) {
+    next = t;
+    found = true;
+  }
+  if (refreshRequested_ && (!found || refreshTime_ < next)) {
+    next = refreshTime_;
+    found = true;
+  }
+  if (statCalc_ && statCalc_->getNextCalculationTime(t) &&
+      (!found || t < next)) {
+    next = t;
+    found = true;
+  }
+  return found;
+}
+
 void DownloadEngine::waitData()
 {
   struct timeval tv;
-  if (noWait_) {
+  if (noWait_ || workerPool_->completionReady()) {
     tv.tv_sec = tv.tv_usec = 0;
   }
   else {
-    auto t =
-        std::chrono::duration_cast<std::chrono::microseconds>(refreshInterval_);
+    std::chrono::milliseconds interval = MAX_WAIT_INTERVAL;
+    if (workerPool_->getWakeupFd() == -1 && workerPool_->countPending() > 0) {
+      // We cannot get notified when a job finishes.  Check
+      // completions frequently.
+      interval = std::min(interval, std::chrono::milliseconds(10));
+    }
+    auto next = Timer::zero();
+    if (getNextWakeup(next)) {
+      // Round up so that we do not wake up just before the deadline.
+      auto d = global::wallclock().difference(next) +
+               std::chrono::microseconds(999);
+      interval = std::min(
+          interval, std::chrono::duration_cast<std::chrono::milliseconds>(d));
+    }
+    auto t = std::chrono::duration_cast<std::chrono::microseconds>(interval);
     tv.tv_sec = t.count() / 1000000;
     tv.tv_usec = t.count() % 1000000;
   }
@@ -275,12 +459,16 @@ void DownloadEngine::requestHalt()
 {
   haltRequested_ = std::max(haltRequested_, 1);
   requestGroupMan_->halt();
+  // Every command has to notice the halt.
+  setRefreshInterval(std::chrono::milliseconds(0));
 }
 
 void DownloadEngine::requestForceHalt()
 {
   haltRequested_ = std::max(haltRequested_, 2);
   requestGroupMan_->forceHalt();
+  // Every command has to notice the halt.
+  setRefreshInterval(std::chrono::milliseconds(0));
 }
 
 void DownloadEngine::setStatCalc(std::unique_ptr<StatCalc> statCalc)
@@ -288,6 +476,21 @@ void DownloadEngine::setStatCalc(std::unique_ptr<StatCalc> statCalc)
   statCalc_ = std::move(statCalc);
 }
 
+void DownloadEngine::setWorkerPool(std::unique_ptr<WorkerPool> workerPool)
+{
+  if (workerPool_ && workerPool_->getWakeupFd() != -1) {
+    eventPoll_->deleteEvents(workerPool_->getWakeupFd(),
+                             workerPoolWakeupCommand_.get(),
+                             EventPoll::EVENT_READ);
+  }
+  workerPool_ = std::move(workerPool);
+  if (workerPool_ && workerPool_->getWakeupFd() != -1) {
+    eventPoll_->addEvents(workerPool_->getWakeupFd(),
+                          workerPoolWakeupCommand_.get(),
+                          EventPoll::EVENT_READ);
+  }
+}
+
 #ifdef ENABLE_ASYNC_DNS
 bool DownloadEngine::addNameResolverCheck(
     const std::shared_ptr<AsyncNameResolver>& resolver, Command* command)
@@ -306,34 +509,107 @@ void DownloadEngine::setNoWait(bool b) { noWait_ = b; }
 
 void DownloadEngine::addRoutineCommand(std::unique_ptr<Command> command)
 {
+  attachCommand(command.get(), true);
   routineCommands_.push_back(std::move(command));
 }
 
-void DownloadEngine::poolSocket(const std::string& key,
-                                const SocketPoolEntry& entry)
+void DownloadEngine::addTimerCommand(std::unique_ptr<Command> command,
+                                     const Timer& deadline, a2_gid_t gid)
 {
-  A2_LOG_INFO(fmt("Pool socket for %s", key.c_str()));
-  std::multimap<std::string, SocketPoolEntry>::value_type p(key, entry);
-  socketPool_.insert(p);
+  auto serial = nextCommandSerial_++;
+  timerCommands_.insert(
+      std::make_pair(serial, TimerCommandEntry{std::move(command), gid}));
+  timerWheel_.add(serial, deadline);
+  if (gid != 0) {
+    timerCommandGids_.insert(std::make_pair(gid, serial));
+  }
 }
 
-void DownloadEngine::evictSocketPool()
+void DownloadEngine::wakeupTimerCommand(uint64_t serial)
 {
-  if (socketPool_.empty()) {
+  auto i = timerCommands_.find(serial);
+  if (i == std::end(timerCommands_)) {
+    // Already woken up by wakeupCommands().
     return;
   }
+  auto& entry = (*i).second;
+  if (entry.gid != 0) {
+    auto range = timerCommandGids_.equal_range(entry.gid);
+    for (auto j = range.first; j != range.second; ++j) {
+      if ((*j).second == serial) {
+        timerCommandGids_.erase(j);
+        break;
+      }
+    }
+  }
+  entry.command->setStatusActive();
+  addCommand(std::move(entry.command));
+  timerCommands_.erase(i);
+}
+
+void DownloadEngine::wakeupCommands(a2_gid_t gid)
+{
+  auto range = timerCommandGids_.equal_range(gid);
+  std::vector<uint64_t> serials;
+  for (auto i = range.first; i != range.second; ++i) {
+    serials.push_back((*i).second);
+  }
+  for (auto serial : serials) {
+    wakeupTimerCommand(serial);
+  }
+}
+
+void DownloadEngine::wakeupTimerCommands()
+{
+  std::vector<uint64_t> serials;
+  // Always advance the wheel, even if it is empty, so that it does
+  // not have to catch up with a long idle period later.
+  timerWheel_.expire(global::wallclock(), serials);
+  if (!timerCommands_.empty() &&
+      (haltRequested_ ||
+       (requestGroupMan_ && requestGroupMan_->downloadFinished()))) {
+    // Their entries in timerWheel_ are ignored when they expire.
+    for (auto& i : timerCommands_) {
+      serials.push_back(i.first);
+    }
+  }
+  for (auto serial : serials) {
+    if (timerCommands_.count(serial)) {
+      wakeupTimerCommand(serial);
+      continue;
+    }
+    auto i = commands_.find(serial);
+    if (i != std::end(commands_)) {
+      onCommandTimer((*i).second.get());
+    }
+  }
+}
 
-  std::multimap<std::string, SocketPoolEntry> newPool;
-  A2_LOG_DEBUG("Scanning SocketPool and erasing timed out entry.");
-  for (auto& elem : socketPool_) {
-    if (!elem.second.isTimeout()) {
-      newPool.insert(elem);
+void DownloadEngine::evictSocketPool()
+{
+#ifdef ENABLE_HTTP2
+  for (auto i = std::begin(http2Sessions_); i != std::end(http2Sessions_);) {
+    const auto& session = (*i).second;
+    if (session->isIdleTimeout(15_s) ||
+        (session->isIdle() && !session->canSubmitRequest())) {
+      A2_LOG_DEBUG(fmt("Removing HTTP/2 session to %s", (*i).first.c_str()));
+      i = http2Sessions_.erase(i);
+    }
+    else {
+      ++i;
     }
   }
-  A2_LOG_DEBUG(
-      fmt("%lu entries removed.",
-          static_cast<unsigned long>(socketPool_.size() - newPool.size())));
-  socketPool_ = std::move(newPool);
+#endif // ENABLE_HTTP2
+
+  if (socketPool_->empty()) {
+    return;
+  }
+
+  auto n = socketPool_->evictTimedOut();
+  if (n > 0) {
+    A2_LOG_DEBUG(fmt("%lu timed out entries removed from SocketPool.",
+                     static_cast<unsigned long>(n)));
+  }
 }
 
 namespace {
@@ -359,23 +635,21 @@ void DownloadEngine::poolSocket(const std::string& ipaddr, uint16_t port,
                                 const std::string& proxyhost,
                                 uint16_t proxyport,
                                 const std::shared_ptr<SocketCore>& sock,
-                                const std::string& options,
-                                std::chrono::seconds timeout)
+                                const std::string& options)
 {
-  SocketPoolEntry e(sock, options, std::move(timeout));
-  poolSocket(createSockPoolKey(ipaddr, port, username, proxyhost, proxyport),
-             e);
+  socketPool_->add(
+      createSockPoolKey(ipaddr, port, username, proxyhost, proxyport), sock,
+      options);
 }
 
 void DownloadEngine::poolSocket(const std::string& ipaddr, uint16_t port,
                                 const std::string& proxyhost,
                                 uint16_t proxyport,
-                                const std::shared_ptr<SocketCore>& sock,
-                                std::chrono::seconds timeout)
+                                const std::shared_ptr<SocketCore>& sock)
 {
-  SocketPoolEntry e(sock, std::move(timeout));
-  poolSocket(createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport),
-             e);
+  socketPool_->add(
+      createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport), sock,
+      A2STR::NIL);
 }
 
 namespace {
@@ -396,20 +670,18 @@ bool getPeerInfo(Endpoint& res, const std::shared_ptr<SocketCore>& socket)
 
 void DownloadEngine::poolSocket(const std::shared_ptr<Request>& request,
                                 const std::shared_ptr<Request>& proxyRequest,
-                                const std::shared_ptr<SocketCore>& socket,
-                                std::chrono::seconds timeout)
+                                const std::shared_ptr<SocketCore>& socket)
 {
   if (proxyRequest) {
     // If proxy is defined, then pool socket with its hostname.
     poolSocket(request->getHost(), request->getPort(), proxyRequest->getHost(),
-               proxyRequest->getPort(), socket, std::move(timeout));
+               proxyRequest->getPort(), socket);
     return;
   }
 
   Endpoint peerInfo;
   if (getPeerInfo(peerInfo, socket)) {
-    poolSocket(peerInfo.addr, peerInfo.port, A2STR::NIL, 0, socket,
-               std::move(timeout));
+    poolSocket(peerInfo.addr, peerInfo.port, A2STR::NIL, 0, socket);
   }
 }
 
@@ -417,40 +689,21 @@ void DownloadEngine::poolSocket(const std::shared_ptr<Request>& request,
                                 const std::string& username,
                                 const std::shared_ptr<Request>& proxyRequest,
                                 const std::shared_ptr<SocketCore>& socket,
-                                const std::string& options,
-                                std::chrono::seconds timeout)
+                                const std::string& options)
 {
   if (proxyRequest) {
     // If proxy is defined, then pool socket with its hostname.
     poolSocket(request->getHost(), request->getPort(), username,
                proxyRequest->getHost(), proxyRequest->getPort(), socket,
-               options, std::move(timeout));
+               options);
     return;
   }
 
   Endpoint peerInfo;
   if (getPeerInfo(peerInfo, socket)) {
     poolSocket(peerInfo.addr, peerInfo.port, username, A2STR::NIL, 0, socket,
-               options, std::move(timeout));
-  }
-}
-
-std::multimap<std::string, DownloadEngine::SocketPoolEntry>::iterator
-DownloadEngine::findSocketPoolEntry(const std::string& key)
-{
-  std::pair<std::multimap<std::string, SocketPoolEntry>::iterator,
-            std::multimap<std::string, SocketPoolEntry>::iterator>
-      range = socketPool_.equal_range(key);
-  for (auto i = range.first, eoi = range.second; i != eoi; ++i) {
-    const SocketPoolEntry& e = (*i).second;
-    // We assume that if socket is readable it means peer shutdowns
-    // connection and the socket will receive EOF. So skip it.
-    if (!e.isTimeout() && !e.getSocket()->isReadable(0)) {
-      A2_LOG_INFO(fmt("Found socket for %s", key.c_str()));
-      return i;
-    }
+               options);
   }
-  return socketPool_.end();
 }
 
 std::shared_ptr<SocketCore>
@@ -458,14 +711,9 @@ DownloadEngine::popPooledSocket(const std::string& ipaddr, uint16_t port,
                                 const std::string& proxyhost,
                                 uint16_t proxyport)
 {
-  std::shared_ptr<SocketCore> s;
-  auto i = findSocketPoolEntry(
-      createSockPoolKey(ipaddr, port, A2STR::NIL, proxyhost, proxyport));
-  if (i != socketPool_.end()) {
-    s = (*i).second.getSocket();
-    socketPool_.erase(i);
-  }
-  return s;
+  std::string options;
+  return socketPool_->pop(options, createSockPoolKey(ipaddr, port, A2STR::NIL,
+                                                     proxyhost, proxyport));
 }
 
 std::shared_ptr<SocketCore>
@@ -474,15 +722,8 @@ DownloadEngine::popPooledSocket(std::string& options, const std::string& ipaddr,
                                 const std::string& proxyhost,
                                 uint16_t proxyport)
 {
-  std::shared_ptr<SocketCore> s;
-  auto i = findSocketPoolEntry(
-      createSockPoolKey(ipaddr, port, username, proxyhost, proxyport));
-  if (i != socketPool_.end()) {
-    s = (*i).second.getSocket();
-    options = (*i).second.getOptions();
-    socketPool_.erase(i);
-  }
-  return s;
+  return socketPool_->pop(
+      options, createSockPoolKey(ipaddr, port, username, proxyhost, proxyport));
 }
 
 std::shared_ptr<SocketCore>
@@ -514,24 +755,25 @@ DownloadEngine::popPooledSocket(std::string& options,
   return s;
 }
 
-DownloadEngine::SocketPoolEntry::SocketPoolEntry(
-    const std::shared_ptr<SocketCore>& socket, const std::string& options,
-    std::chrono::seconds timeout)
-    : socket_(socket), options_(options), timeout_(std::move(timeout))
+size_t DownloadEngine::countPooledSocket(const std::string& ipaddr,
+                                         uint16_t port) const
 {
+  return socketPool_->count(
+      createSockPoolKey(ipaddr, port, A2STR::NIL, A2STR::NIL, 0));
 }
 
-DownloadEngine::SocketPoolEntry::SocketPoolEntry(
-    const std::shared_ptr<SocketCore>& socket, std::chrono::seconds timeout)
-    : socket_(socket), timeout_(std::move(timeout))
+void DownloadEngine::addPendingPooledSocket(const std::string& ipaddr,
+                                            uint16_t port)
 {
+  socketPool_->addPending(
+      createSockPoolKey(ipaddr, port, A2STR::NIL, A2STR::NIL, 0));
 }
 
-DownloadEngine::SocketPoolEntry::~SocketPoolEntry() = default;
-
-bool DownloadEngine::SocketPoolEntry::isTimeout() const
+void DownloadEngine::removePendingPooledSocket(const std::string& ipaddr,
+                                               uint16_t port)
 {
-  return registeredTime_.difference(global::wallclock()) >= timeout_;
+  socketPool_->removePending(
+      createSockPoolKey(ipaddr, port, A2STR::NIL, A2STR::NIL, 0));
 }
 
 cuid_t DownloadEngine::newCUID() { return cuidCounter_.newID(); }
@@ -549,6 +791,26 @@ void DownloadEngine::cacheIPAddress(const std::string& hostname,
   dnsCache_->put(hostname, ipaddr, port);
 }
 
+void DownloadEngine::cacheIPAddress(const std::string& hostname,
+                                    const std::string& ipaddr, uint16_t port,
+                                    std::chrono::seconds ttl)
+{
+  dnsCache_->put(hostname, ipaddr, port, std::move(ttl));
+}
+
+void DownloadEngine::cacheNameResolutionFailure(const std::string& hostname,
+                                                uint16_t port,
+                                                const std::string& error)
+{
+  dnsCache_->putNegative(hostname, port, error);
+}
+
+bool DownloadEngine::findCachedNameResolutionFailure(
+    std::string& error, const std::string& hostname, uint16_t port) const
+{
+  return dnsCache_->findNegative(error, hostname, port);
+}
+
 void DownloadEngine::markBadIPAddress(const std::string& hostname,
                                       const std::string& ipaddr, uint16_t port)
 {
@@ -573,6 +835,41 @@ DownloadEngine::getAuthConfigFactory() const
   return authConfigFactory_;
 }
 
+#ifdef ENABLE_HTTP2
+std::shared_ptr<Http2Session>
+DownloadEngine::findHttp2Session(const std::string& hostname, uint16_t port)
+{
+  auto i = http2Sessions_.find(fmt("%s(%u)", hostname.c_str(), port));
+  if (i == std::end(http2Sessions_)) {
+    return nullptr;
+  }
+  const auto& session = (*i).second;
+  if (!session->canSubmitRequest()) {
+    return nullptr;
+  }
+  return session;
+}
+
+void DownloadEngine::addHttp2Session(
+    const std::shared_ptr<Http2Session>& session)
+{
+  http2Sessions_[fmt("%s(%u)", session->getHostname().c_str(),
+                     session->getPort())] = session;
+}
+
+void DownloadEngine::markHttp2Unsupported(const std::string& hostname,
+                                          uint16_t port)
+{
+  http2UnsupportedHosts_.insert(fmt("%s(%u)", hostname.c_str(), port));
+}
+
+bool DownloadEngine::isHttp2Unsupported(const std::string& hostname,
+                                        uint16_t port) const
+{
+  return http2UnsupportedHosts_.count(fmt("%s(%u)", hostname.c_str(), port));
+}
+#endif // ENABLE_HTTP2
+
 const std::unique_ptr<CookieStorage>& DownloadEngine::getCookieStorage() const
 {
   return cookieStorage_;
@@ -580,19 +877,26 @@ const std::unique_ptr<CookieStorage>& DownloadEngine::getCookieStorage() const
 
 void DownloadEngine::setRefreshInterval(std::chrono::milliseconds interval)
 {
-  refreshInterval_ = std::move(interval);
+  auto t = global::wallclock();
+  t.advance(interval);
+  if (!refreshRequested_ || t < refreshTime_) {
+    refreshRequested_ = true;
+    refreshTime_ = t;
+  }
 }
 
 void DownloadEngine::addCommand(std::vector<std::unique_ptr<Command>> commands)
 {
-  commands_.insert(commands_.end(),
-                   std::make_move_iterator(std::begin(commands)),
-                   std::make_move_iterator(std::end(commands)));
+  for (auto& command : commands) {
+    addCommand(std::move(command));
+  }
 }
 
 void DownloadEngine::addCommand(std::unique_ptr<Command> command)
 {
-  commands_.push_back(std::move(command));
+  attachCommand(command.get(), false);
+  auto serial = command->serial_;
+  commands_[serial] = std::move(command);
 }
 
 void DownloadEngine::setRequestGroupMan(std::unique_ptr<RequestGroupMan> rgman)
@@ -40,8 +40,10 @@
 #include <string>
 #include <deque>
 #include <map>
+#include <set>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 #include "a2netcompat.h"
 #include "TimerA2.h"
@@ -50,6 +52,9 @@
 #include "FileAllocationMan.h"
 #include "CheckIntegrityMan.h"
 #include "DNSCache.h"
+#include "TimerWheel.h"
+#include "GroupId.h"
+#include "Command.h"
 #ifdef ENABLE_ASYNC_DNS
 #  include "AsyncNameResolver.h"
 #endif // ENABLE_ASYNC_DNS
@@ -60,11 +65,15 @@ class Option;
 class RequestGroupMan;
 class StatCalc;
 class SocketCore;
+class SocketPool;
 class CookieStorage;
 class AuthConfigFactory;
 class Request;
 class EventPoll;
-class Command;
+class WorkerPool;
+#ifdef ENABLE_HTTP2
+class Http2Session;
+#endif // ENABLE_HTTP2
 #ifdef ENABLE_BITTORRENT
 class BtRegistry;
 #endif // ENABLE_BITTORRENT
@@ -85,49 +94,75 @@ class DownloadEngine {
 private:
   void waitData();
 
-  std::string sessionId_;
+  // Processes the expired entries of timerWheel_: moves the commands
+  // in timerCommands_ whose deadline has passed to commands_, and
+  // puts the commands in commands_ whose wake up time has passed to
+  // the ready list.  If the engine has nothing to do any longer, all
+  // commands in timerCommands_ are moved.
+  void wakeupTimerCommands();
 
-  std::unique_ptr<EventPoll> eventPoll_;
+  // Moves the command in timerCommands_ identified by serial to
+  // commands_.
+  void wakeupTimerCommand(uint64_t serial);
 
-  std::unique_ptr<StatCalc> statCalc_;
+  // Handles the expiry of the timer wheel entry of command in
+  // commands_.
+  void onCommandTimer(Command* command);
 
-  int haltRequested_;
+  // Executes the commands in the ready list.
+  void executeCommand();
 
-  class SocketPoolEntry {
-  private:
-    std::shared_ptr<SocketCore> socket_;
-    // protocol specific option string
-    std::string options_;
+  void executeRoutineCommand();
 
-    std::chrono::seconds timeout_;
+  // Makes command belong to this object.  If routine is true, it is
+  // in routineCommands_.  Otherwise, it is in commands_.
+  void attachCommand(Command* command, bool routine);
 
-    Timer registeredTime_;
+  // Takes the command identified by serial out of commands_.
+  std::unique_ptr<Command> detachCommand(uint64_t serial);
 
-  public:
-    SocketPoolEntry(const std::shared_ptr<SocketCore>& socket,
-                    const std::string& option, std::chrono::seconds timeout);
+  // Called by Command when command in commands_ has to be executed.
+  void markCommandReady(Command* command);
 
-    SocketPoolEntry(const std::shared_ptr<SocketCore>& socket,
-                    std::chrono::seconds timeout);
+  // Called by Command when the wake up time of command has changed.
+  // Registers the wake up time to timerWheel_ unless an entry which
+  // expires no later than that is already registered.
+  void armCommand(Command* command);
 
-    ~SocketPoolEntry();
+  // Stores in next the earliest time at which a command has to be
+  // executed without an event, and returns true.  Returns false if
+  // there is no such time.
+  bool getNextWakeup(Timer& next) const;
 
-    bool isTimeout() const;
+  friend class Command;
 
-    const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
+  std::string sessionId_;
 
-    const std::string& getOptions() const { return options_; }
-  };
+  std::unique_ptr<EventPoll> eventPoll_;
+
+  std::unique_ptr<StatCalc> statCalc_;
+
+  int haltRequested_;
+
+  // Idle connections kept for reuse
+  std::unique_ptr<SocketPool> socketPool_;
 
-  // key = IP address:port, value = SocketPoolEntry
-  std::multimap<std::string, SocketPoolEntry> socketPool_;
+#ifdef ENABLE_HTTP2
+  // key = hostname(port), value = HTTP/2 session shared by the
+  // commands downloading from the host.  The session which no command
+  // uses is removed by evictSocketPool() after a while.
+  std::map<std::string, std::shared_ptr<Http2Session>> http2Sessions_;
 
-  Timer lastSocketPoolScan_;
+  // hostname(port) of the servers which do not talk HTTP/2.
+  std::set<std::string> http2UnsupportedHosts_;
+#endif // ENABLE_HTTP2
 
   bool noWait_;
 
-  std::chrono::milliseconds refreshInterval_;
-  Timer lastRefresh_;
+  // true if all commands in commands_ should be executed at
+  // refreshTime_.  See setRefreshInterval().
+  bool refreshRequested_;
+  Timer refreshTime_;
 
   std::unique_ptr<CookieStorage> cookieStorage_;
 
@@ -140,6 +175,9 @@ private:
 #ifdef HAVE_ARES_ADDR_NODE
   ares_addr_node* asyncDNSServers_;
 #endif // HAVE_ARES_ADDR_NODE
+#ifndef HAVE_LIBCARES
+  std::vector<std::pair<std::string, uint16_t>> asyncDNSServers_;
+#endif // !HAVE_LIBCARES
 
   std::unique_ptr<DNSCache> dnsCache_;
 
@@ -158,23 +196,52 @@ private:
 
   void afterEachIteration();
 
-  void poolSocket(const std::string& key, const SocketPoolEntry& entry);
-
-  std::multimap<std::string, SocketPoolEntry>::iterator
-  findSocketPoolEntry(const std::string& key);
-
   std::unique_ptr<RequestGroupMan> requestGroupMan_;
   std::unique_ptr<FileAllocationMan> fileAllocationMan_;
   std::unique_ptr<CheckIntegrityMan> checkIntegrityMan_;
   Option* option_;
+  // The commands in commands_ to be executed in the next iteration,
+  // in the order they became ready: the ones with an event, the
+  // active or realtime ones and the ones whose wake up time has
+  // passed.
+  std::vector<Command*> readyCommands_;
   // Ensure that Commands are cleaned up before requestGroupMan_ is
   // deleted.
   std::deque<std::unique_ptr<Command>> routineCommands_;
-  std::deque<std::unique_ptr<Command>> commands_;
+  // Commands waiting for an event or their wake up time, keyed by
+  // Command::serial_.
+  std::unordered_map<uint64_t, std::unique_ptr<Command>> commands_;
+  struct TimerCommandEntry {
+    std::unique_ptr<Command> command;
+    // GID of the download the command belongs to, or 0.
+    a2_gid_t gid;
+  };
+  // Commands sleeping until their deadline, keyed by serial number.
+  // See addTimerCommand().
+  std::map<uint64_t, TimerCommandEntry> timerCommands_;
+  // Serial numbers in timerCommands_ ordered by deadline, and
+  // Command::serial_ of the commands in commands_ and routineCommands_
+  // ordered by wake up time.  The serial number which is no longer in
+  // timerCommands_ or commands_ is ignored when it expires.
+  TimerWheel<uint64_t> timerWheel_;
+  // Serial numbers in timerCommands_ of the commands which belong to
+  // a download, keyed by GID.
+  std::multimap<a2_gid_t, uint64_t> timerCommandGids_;
+  // The next serial number for timerCommands_ and Command::serial_.
+  uint64_t nextCommandSerial_;
+  // The command being executed by executeCommand() or
+  // executeRoutineCommand(), or nullptr.
+  Command* executingCommand_;
 
   std::unique_ptr<util::security::HMAC> tokenHMAC_;
   std::unique_ptr<util::security::HMACResult> tokenExpected_;
 
+  // Receives readiness of workerPool_'s wakeup file descriptor.
+  std::unique_ptr<Command> workerPoolWakeupCommand_;
+  // Declared last so that worker threads are joined before the
+  // objects used by their jobs are destroyed.
+  std::unique_ptr<WorkerPool> workerPool_;
+
 public:
   DownloadEngine(std::unique_ptr<EventPoll> eventPoll);
 
@@ -235,6 +302,16 @@ public:
 
   void setStatCalc(std::unique_ptr<StatCalc> statCalc);
 
+  // Replaces the WorkerPool.  By default, DownloadEngine has the
+  // WorkerPool without threads, which executes jobs in the event loop
+  // thread.
+  void setWorkerPool(std::unique_ptr<WorkerPool> workerPool);
+
+  const std::unique_ptr<WorkerPool>& getWorkerPool() const
+  {
+    return workerPool_;
+  }
+
   bool isHaltRequested() const { return haltRequested_; }
 
   bool isForceHaltRequested() const { return haltRequested_ >= 2; }
@@ -247,28 +324,40 @@ public:
 
   void addRoutineCommand(std::unique_ptr<Command> command);
 
+  // Puts command to sleep until deadline.  Sleeping commands are not
+  // executed, even by setRefreshInterval(), until deadline has
+  // passed.  They are woken up early when halt is requested or all
+  // downloads have finished.  If gid is not 0, command belongs to the
+  // download identified by gid, and it is also woken up by
+  // wakeupCommands(gid).  A woken up command is moved to the ordinary
+  // command queue with the active status.
+  void addTimerCommand(std::unique_ptr<Command> command,
+                       const Timer& deadline, a2_gid_t gid = 0);
+
+  // Wakes up the sleeping commands which belong to the download
+  // identified by gid.
+  void wakeupCommands(a2_gid_t gid);
+
+  size_t countTimerCommand() const { return timerCommands_.size(); }
+
   void poolSocket(const std::string& ipaddr, uint16_t port,
                   const std::string& username, const std::string& proxyhost,
                   uint16_t proxyport, const std::shared_ptr<SocketCore>& sock,
-                  const std::string& options,
-                  std::chrono::seconds timeout = 15_s);
+                  const std::string& options);
 
   void poolSocket(const std::shared_ptr<Request>& request,
                   const std::string& username,
                   const std::shared_ptr<Request>& proxyRequest,
                   const std::shared_ptr<SocketCore>& socket,
-                  const std::string& options,
-                  std::chrono::seconds timeout = 15_s);
+                  const std::string& options);
 
   void poolSocket(const std::string& ipaddr, uint16_t port,
                   const std::string& proxyhost, uint16_t proxyport,
-                  const std::shared_ptr<SocketCore>& sock,
-                  std::chrono::seconds timeout = 15_s);
+                  const std::shared_ptr<SocketCore>& sock);
 
   void poolSocket(const std::shared_ptr<Request>& request,
                   const std::shared_ptr<Request>& proxyRequest,
-                  const std::shared_ptr<SocketCore>& socket,
-                  std::chrono::seconds timeout = 15_s);
+                  const std::shared_ptr<SocketCore>& socket);
 
   std::shared_ptr<SocketCore> popPooledSocket(const std::string& ipaddr,
                                               uint16_t port,
@@ -289,6 +378,37 @@ public:
 
   void evictSocketPool();
 
+  // Returns the number of idle connections to ipaddr:port in the
+  // socket pool, including the ones being established ahead of need.
+  size_t countPooledSocket(const std::string& ipaddr, uint16_t port) const;
+
+  // Tells that a connection to ipaddr:port is being established ahead
+  // of need and will be pooled.  Call removePendingPooledSocket() when
+  // it is pooled or fails.
+  void addPendingPooledSocket(const std::string& ipaddr, uint16_t port);
+
+  void removePendingPooledSocket(const std::string& ipaddr, uint16_t port);
+
+  const std::unique_ptr<SocketPool>& getSocketPool() const
+  {
+    return socketPool_;
+  }
+
+#ifdef ENABLE_HTTP2
+  // Returns HTTP/2 session connected to |hostname|:|port| which can
+  // accept new stream, or nullptr if there is no such session.
+  std::shared_ptr<Http2Session> findHttp2Session(const std::string& hostname,
+                                                 uint16_t port);
+
+  void addHttp2Session(const std::shared_ptr<Http2Session>& session);
+
+  // Remembers that |hostname|:|port| does not talk HTTP/2, so that
+  // HTTP/1.1 is used for it from now on.
+  void markHttp2Unsupported(const std::string& hostname, uint16_t port);
+
+  bool isHttp2Unsupported(const std::string& hostname, uint16_t port) const;
+#endif // ENABLE_HTTP2
+
   const std::unique_ptr<CookieStorage>& getCookieStorage() const;
 
 #ifdef ENABLE_BITTORRENT
@@ -313,15 +433,37 @@ public:
   void cacheIPAddress(const std::string& hostname, const std::string& ipaddr,
                       uint16_t port);
 
+  // Caches ipaddr with its TTL.  Negative ttl means that TTL is
+  // unknown.
+  void cacheIPAddress(const std::string& hostname, const std::string& ipaddr,
+                      uint16_t port, std::chrono::seconds ttl);
+
+  // Caches the failed name resolution of hostname for a short while.
+  void cacheNameResolutionFailure(const std::string& hostname, uint16_t port,
+                                  const std::string& error);
+
+  // Returns true if the failed name resolution of hostname is cached.
+  // Its error message is assigned to error.
+  bool findCachedNameResolutionFailure(std::string& error,
+                                       const std::string& hostname,
+                                       uint16_t port) const;
+
   void markBadIPAddress(const std::string& hostname, const std::string& ipaddr,
                         uint16_t port);
 
   void removeCachedIPAddress(const std::string& hostname, uint16_t port);
 
+  const std::unique_ptr<DNSCache>& getDNSCache() const { return dnsCache_; }
+
   void setAuthConfigFactory(std::unique_ptr<AuthConfigFactory> factory);
 
   const std::unique_ptr<AuthConfigFactory>& getAuthConfigFactory() const;
 
+  // Executes all commands in the command queue once, interval
+  // later, regardless of their status and wake up time.  Call this
+  // function when something happened which the commands waiting for
+  // an event should know.  The commands sleeping in the timer are not
+  // affected; use wakeupCommands() for them.
   void setRefreshInterval(std::chrono::milliseconds interval);
 
   const std::string getSessionId() const { return sessionId_; }
@@ -332,6 +474,20 @@ public:
   ares_addr_node* getAsyncDNSServers() const { return asyncDNSServers_; }
 #endif // HAVE_ARES_ADDR_NODE
 
+#ifndef HAVE_LIBCARES
+  void setAsyncDNSServers(
+      std::vector<std::pair<std::string, uint16_t>> asyncDNSServers)
+  {
+    asyncDNSServers_ = std::move(asyncDNSServers);
+  }
+
+  const std::vector<std::pair<std::string, uint16_t>>&
+  getAsyncDNSServers() const
+  {
+    return asyncDNSServers_;
+  }
+#endif // !HAVE_LIBCARES
+
 #ifdef ENABLE_WEBSOCKET
   void setWebSocketSessionMan(std::unique_ptr<rpc::WebSocketSessionMan> wsman);
   const std::unique_ptr<rpc::WebSocketSessionMan>&
@@ -58,12 +58,18 @@
 #include "DownloadContext.h"
 #include "array_fun.h"
 #include "EvictSocketPoolCommand.h"
+#include "DNSCacheRefreshCommand.h"
+#include "PreconnectDispatcherCommand.h"
+#include "SocketPool.h"
 #ifdef HAVE_LIBUV
 #  include "LibuvEventPoll.h"
 #endif // HAVE_LIBUV
 #ifdef HAVE_EPOLL
 #  include "EpollEventPoll.h"
 #endif // HAVE_EPOLL
+#ifdef HAVE_IO_URING
+#  include "IoUringEventPoll.h"
+#endif // HAVE_IO_URING
 #ifdef HAVE_PORT_ASSOCIATE
 #  include "PortEventPoll.h"
 #endif // HAVE_PORT_ASSOCIATE
@@ -78,6 +84,9 @@
 #include "FileAllocationEntry.h"
 #include "HttpListenCommand.h"
 #include "LogFactory.h"
+#include "WorkerPool.h"
+#include "WrDiskCache.h"
+#include "DiskWriteQueue.h"
 
 namespace aria2 {
 
@@ -109,6 +118,17 @@ std::unique_ptr<EventPoll> createEventPoll(Option* op)
   }
   else
 #endif // HAVE_EPLL
+#ifdef HAVE_IO_URING
+      if (pollMethod == V_IO_URING) {
+    auto ep = make_unique<IoUringEventPoll>();
+    if (!ep->good()) {
+      throw DL_ABORT_EX("Initializing IoUringEventPoll failed."
+                        " Try --event-poll=select");
+    }
+    return std::move(ep);
+  }
+  else
+#endif // HAVE_IO_URING
 #ifdef HAVE_KQUEUE
       if (pollMethod == V_KQUEUE) {
     auto kp = make_unique<KqueueEventPoll>();
@@ -152,14 +172,28 @@ std::unique_ptr<DownloadEngine> DownloadEngineFactory::newDownloadEngine(
       op->getAsInt(PREF_MAX_CONCURRENT_DOWNLOADS);
   auto e = make_unique<DownloadEngine>(createEventPoll(op));
   e->setOption(op);
+  e->setWorkerPool(make_unique<WorkerPool>(op->getAsInt(PREF_WORKER_THREADS)));
   {
     auto requestGroupMan = make_unique<RequestGroupMan>(
         std::move(requestGroups), MAX_CONCURRENT_DOWNLOADS, op);
     requestGroupMan->initWrDiskCache();
+    if (requestGroupMan->getWrDiskCache() &&
+        e->getWorkerPool()->getNumThreads() > 0) {
+      requestGroupMan->getWrDiskCache()->setDiskWriteQueue(
+          make_unique<DiskWriteQueue>(
+              e.get(), op->getAsInt(PREF_MAX_DISK_WRITE_QUEUE)));
+    }
     e->setRequestGroupMan(std::move(requestGroupMan));
   }
-  e->setFileAllocationMan(make_unique<FileAllocationMan>());
-  e->setCheckIntegrityMan(make_unique<CheckIntegrityMan>());
+  e->setFileAllocationMan(make_unique<FileAllocationMan>(
+      op->getAsInt(PREF_MAX_CONCURRENT_FILE_ALLOCATIONS)));
+  e->setCheckIntegrityMan(make_unique<CheckIntegrityMan>(
+      op->getAsInt(PREF_MAX_CONCURRENT_INTEGRITY_CHECKS)));
+  e->getSocketPool()->setMaxIdle(op->getAsInt(PREF_MAX_IDLE_CONNECTIONS));
+  e->getSocketPool()->setMaxIdlePerHost(
+      op->getAsInt(PREF_MAX_IDLE_CONNECTIONS_PER_HOST));
+  e->getSocketPool()->setIdleTimeout(
+      std::chrono::seconds(op->getAsInt(PREF_IDLE_CONNECTION_TIMEOUT)));
   e->addRoutineCommand(
       make_unique<FillRequestGroupCommand>(e->newCUID(), e.get()));
   e->addRoutineCommand(make_unique<FileAllocationDispatcherCommand>(
@@ -167,7 +201,13 @@ std::unique_ptr<DownloadEngine> DownloadEngineFactory::newDownloadEngine(
   e->addRoutineCommand(make_unique<CheckIntegrityDispatcherCommand>(
       e->newCUID(), e->getCheckIntegrityMan().get(), e.get()));
   e->addRoutineCommand(
-      make_unique<EvictSocketPoolCommand>(e->newCUID(), e.get(), 30_s));
+      make_unique<EvictSocketPoolCommand>(e->newCUID(), e.get(), 1_s));
+  e->addRoutineCommand(
+      make_unique<DNSCacheRefreshCommand>(e->newCUID(), e.get(), 1_s));
+  if (op->getAsInt(PREF_PRE_CONNECT) > 0) {
+    e->addRoutineCommand(make_unique<PreconnectDispatcherCommand>(
+        e->newCUID(), e.get(), 1_s));
+  }
 
   if (op->getAsInt(PREF_AUTO_SAVE_INTERVAL) > 0) {
     e->addRoutineCommand(make_unique<AutoSaveCommand>(
@@ -83,7 +83,8 @@ struct epoll_event EpollEventPoll::KSocketEntry::getEvents()
 
 EpollEventPoll::EpollEventPoll()
     : epEventsSize_(EPOLL_EVENTS_MAX),
-      epEvents_(make_unique<struct epoll_event[]>(epEventsSize_))
+      epEvents_(make_unique<struct epoll_event[]>(epEventsSize_)),
+      numSyscalls_(0)
 {
   epfd_ = epoll_create(EPOLL_EVENTS_MAX);
 }
@@ -103,16 +104,21 @@ EpollEventPoll::~EpollEventPoll()
 
 bool EpollEventPoll::good() const { return epfd_ != -1; }
 
+int EpollEventPoll::ctl(int op, sock_t socket, struct epoll_event* event)
+{
+  ++numSyscalls_;
+  return epoll_ctl(epfd_, op, socket, event);
+}
+
 void EpollEventPoll::poll(const struct timeval& tv)
 {
   // timeout is millisec
   int timeout = tv.tv_sec * 1000 + tv.tv_usec / 1000;
 
-  int res;
-  while ((res = epoll_wait(epfd_, epEvents_.get(), EPOLL_EVENTS_MAX,
-                           timeout)) == -1 &&
-         errno == EINTR)
-    ;
+  // Do not retry on EINTR, so that DownloadEngine notices the signal
+  // without waiting for the timeout.
+  ++numSyscalls_;
+  int res = epoll_wait(epfd_, epEvents_.get(), EPOLL_EVENTS_MAX, timeout);
 
   if (res > 0) {
     for (int i = 0; i < res; ++i) {
@@ -120,7 +126,7 @@ void EpollEventPoll::poll(const struct timeval& tv)
       p->processEvents(epEvents_[i].events);
     }
   }
-  else if (res == -1) {
+  else if (res == -1 && errno != EINTR) {
     int errNum = errno;
     A2_LOG_INFO(
         fmt("epoll_wait error: %s", util::safeStrerror(errNum).c_str()));
@@ -174,13 +180,13 @@ bool EpollEventPoll::addEvents(sock_t socket,
     event.addSelf(&socketEntry);
 
     struct epoll_event epEvent = socketEntry.getEvents();
-    r = epoll_ctl(epfd_, EPOLL_CTL_MOD, socketEntry.getSocket(), &epEvent);
+    r = ctl(EPOLL_CTL_MOD, socketEntry.getSocket(), &epEvent);
     if (r == -1) {
       // try EPOLL_CTL_ADD: There is a chance that previously socket X is
       // added to epoll, but it is closed and is not yet removed from
       // SocketEntries. In this case, EPOLL_CTL_MOD is failed with ENOENT.
 
-      r = epoll_ctl(epfd_, EPOLL_CTL_ADD, socketEntry.getSocket(), &epEvent);
+      r = ctl(EPOLL_CTL_ADD, socketEntry.getSocket(), &epEvent);
       errNum = errno;
     }
   }
@@ -195,7 +201,7 @@ bool EpollEventPoll::addEvents(sock_t socket,
     event.addSelf(&socketEntry);
 
     struct epoll_event epEvent = socketEntry.getEvents();
-    r = epoll_ctl(epfd_, EPOLL_CTL_ADD, socketEntry.getSocket(), &epEvent);
+    r = ctl(EPOLL_CTL_ADD, socketEntry.getSocket(), &epEvent);
     errNum = errno;
   }
   if (r == -1) {
@@ -240,7 +246,7 @@ bool EpollEventPoll::deleteEvents(sock_t socket,
     // In kernel before 2.6.9, epoll_ctl with EPOLL_CTL_DEL requires non-null
     // pointer of epoll_event.
     struct epoll_event ev = {0, {0}};
-    r = epoll_ctl(epfd_, EPOLL_CTL_DEL, socketEntry.getSocket(), &ev);
+    r = ctl(EPOLL_CTL_DEL, socketEntry.getSocket(), &ev);
     errNum = errno;
     socketEntries_.erase(i);
   }
@@ -248,7 +254,7 @@ bool EpollEventPoll::deleteEvents(sock_t socket,
     // If socket is closed, then it seems it is automatically removed from
     // epoll, so following EPOLL_CTL_MOD may fail.
     struct epoll_event epEvent = socketEntry.getEvents();
-    r = epoll_ctl(epfd_, EPOLL_CTL_MOD, socketEntry.getSocket(), &epEvent);
+    r = ctl(EPOLL_CTL_MOD, socketEntry.getSocket(), &epEvent);
     errNum = errno;
     if (r == -1) {
       A2_LOG_DEBUG(fmt("Failed to delete socket event, but may be ignored:%s",
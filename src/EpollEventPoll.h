@@ -89,6 +89,10 @@ private:
 
   static const size_t EPOLL_EVENTS_MAX = 1024;
 
+  uint64_t numSyscalls_;
+
+  int ctl(int op, sock_t socket, struct epoll_event* event);
+
   bool addEvents(sock_t socket, const KEvent& event);
 
   bool deleteEvents(sock_t socket, const KEvent& event);
@@ -108,6 +112,10 @@ public:
 
   virtual void poll(const struct timeval& tv) CXX11_OVERRIDE;
 
+  // Returns the number of epoll_ctl(2) and epoll_wait(2) calls made
+  // so far.
+  uint64_t getNumSyscalls() const { return numSyscalls_; }
+
   virtual bool addEvents(sock_t socket, Command* command,
                          EventPoll::EventType events) CXX11_OVERRIDE;
 
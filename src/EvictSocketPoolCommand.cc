@@ -40,7 +40,7 @@ namespace aria2 {
 
 EvictSocketPoolCommand::EvictSocketPoolCommand(cuid_t cuid, DownloadEngine* e,
                                                std::chrono::seconds interval)
-    : TimeBasedCommand(cuid, e, std::move(interval), true)
+    : TimeBasedCommand(cuid, e, std::move(interval))
 {
 }
 
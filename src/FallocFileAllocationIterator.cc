@@ -67,4 +67,15 @@ int64_t FallocFileAllocationIterator::getCurrentLength() { return offset_; }
 
 int64_t FallocFileAllocationIterator::getTotalLength() { return totalLength_; }
 
+bool FallocFileAllocationIterator::canAllocateInWorker()
+{
+#ifdef __MINGW32__
+  // AbstractDiskWriter::allocate() logs a warning if SetFileValidData
+  // fails.
+  return false;
+#else  // !__MINGW32__
+  return true;
+#endif // !__MINGW32__
+}
+
 } // namespace aria2
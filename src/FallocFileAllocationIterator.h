@@ -58,6 +58,8 @@ public:
   virtual int64_t getCurrentLength() CXX11_OVERRIDE;
 
   virtual int64_t getTotalLength() CXX11_OVERRIDE;
+
+  virtual bool canAllocateInWorker() CXX11_OVERRIDE;
 };
 
 } // namespace aria2
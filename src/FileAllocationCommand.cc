@@ -49,6 +49,7 @@
 #include "wallclock.h"
 #include "RequestGroupMan.h"
 #include "fmt.h"
+#include "WorkerPool.h"
 
 namespace aria2 {
 
@@ -56,21 +57,47 @@ FileAllocationCommand::FileAllocationCommand(
     cuid_t cuid, RequestGroup* requestGroup, DownloadEngine* e,
     FileAllocationEntry* fileAllocationEntry)
     : RealtimeCommand{cuid, requestGroup, e},
-      fileAllocationEntry_{fileAllocationEntry}
+      fileAllocationEntry_{fileAllocationEntry},
+      jobRunning_{false},
+      jobCompleted_{false}
 {
 }
 
 FileAllocationCommand::~FileAllocationCommand()
 {
-  getDownloadEngine()->getFileAllocationMan()->dropPickedEntry();
+  getDownloadEngine()->getFileAllocationMan()->dropPickedEntry(
+      fileAllocationEntry_);
 }
 
 bool FileAllocationCommand::executeInternal()
 {
+  if (jobRunning_) {
+    // Sleep until the completion of the job wakes us up.
+    setStatusInactive();
+    getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+  if (jobError_) {
+    auto error = jobError_;
+    jobError_ = nullptr;
+    std::rethrow_exception(error);
+  }
+  auto resumed = jobCompleted_;
+  jobCompleted_ = false;
   if (getRequestGroup()->isHaltRequested()) {
     return true;
   }
-  fileAllocationEntry_->allocateChunk();
+  if (!resumed || !fileAllocationEntry_->finished()) {
+    if (getDownloadEngine()->getWorkerPool()->getNumThreads() > 0 &&
+        !fileAllocationEntry_->finished() &&
+        fileAllocationEntry_->canAllocateInWorker()) {
+      submitJob();
+      setStatusInactive();
+      getDownloadEngine()->addCommand(std::unique_ptr<Command>(this));
+      return false;
+    }
+    fileAllocationEntry_->allocateChunk();
+  }
   if (fileAllocationEntry_->finished()) {
     A2_LOG_DEBUG(fmt(
         MSG_ALLOCATION_COMPLETED,
@@ -90,6 +117,28 @@ bool FileAllocationCommand::executeInternal()
   }
 }
 
+void FileAllocationCommand::submitJob()
+{
+  jobRunning_ = true;
+  auto entry = fileAllocationEntry_;
+  getDownloadEngine()->getWorkerPool()->submit(
+      [this, entry]() {
+        try {
+          entry->allocateChunksInWorker(std::chrono::milliseconds(100));
+        }
+        catch (RecoverableException& e) {
+          jobError_ = std::current_exception();
+        }
+      },
+      [this, entry]() {
+        jobRunning_ = false;
+        jobCompleted_ = true;
+        entry->updateProgress();
+        setStatusRealtime();
+        getDownloadEngine()->setNoWait(true);
+      });
+}
+
 bool FileAllocationCommand::handleException(Exception& e)
 {
   getRequestGroup()->setLastErrorCode(e.getErrorCode(), e.what());
@@ -38,6 +38,7 @@
 #include "RealtimeCommand.h"
 
 #include <memory>
+#include <exception>
 
 #include "TimerA2.h"
 
@@ -49,6 +50,15 @@ class FileAllocationCommand : public RealtimeCommand {
 private:
   FileAllocationEntry* fileAllocationEntry_;
   Timer timer_;
+  // True while chunks are being allocated in a worker thread.  This
+  // command must not be deleted until the job completes.
+  bool jobRunning_;
+  // True if the last chunks were allocated in a worker thread.
+  bool jobCompleted_;
+  // The exception thrown by the job, if any.
+  std::exception_ptr jobError_;
+
+  void submitJob();
 
 public:
   FileAllocationCommand(cuid_t cuid, RequestGroup* requestGroup,
@@ -46,21 +46,18 @@ FileAllocationEntry::FileAllocationEntry(RequestGroup* requestGroup,
     : RequestGroupEntry{requestGroup, std::move(nextCommand)},
       fileAllocationIterator_{requestGroup->getPieceStorage()
                                   ->getDiskAdaptor()
-                                  ->fileAllocationIterator()}
+                                  ->fileAllocationIterator()},
+      currentLength_{0},
+      totalLength_{0}
 {
+  updateProgress();
 }
 
 FileAllocationEntry::~FileAllocationEntry() = default;
 
-int64_t FileAllocationEntry::getCurrentLength()
-{
-  return fileAllocationIterator_->getCurrentLength();
-}
+int64_t FileAllocationEntry::getCurrentLength() { return currentLength_; }
 
-int64_t FileAllocationEntry::getTotalLength()
-{
-  return fileAllocationIterator_->getTotalLength();
-}
+int64_t FileAllocationEntry::getTotalLength() { return totalLength_; }
 
 bool FileAllocationEntry::finished()
 {
@@ -70,6 +67,29 @@ bool FileAllocationEntry::finished()
 void FileAllocationEntry::allocateChunk()
 {
   fileAllocationIterator_->allocateChunk();
+  updateProgress();
+}
+
+bool FileAllocationEntry::canAllocateInWorker()
+{
+  return fileAllocationIterator_->canAllocateInWorker();
+}
+
+void FileAllocationEntry::allocateChunksInWorker(
+    std::chrono::milliseconds timeout)
+{
+  auto start = std::chrono::steady_clock::now();
+  do {
+    fileAllocationIterator_->allocateChunk();
+  } while (!fileAllocationIterator_->finished() &&
+           fileAllocationIterator_->canAllocateInWorker() &&
+           std::chrono::steady_clock::now() - start < timeout);
+}
+
+void FileAllocationEntry::updateProgress()
+{
+  currentLength_ = fileAllocationIterator_->getCurrentLength();
+  totalLength_ = fileAllocationIterator_->getTotalLength();
 }
 
 } // namespace aria2
@@ -39,6 +39,7 @@
 
 #include <vector>
 #include <memory>
+#include <chrono>
 
 #include "ProgressAwareEntry.h"
 
@@ -53,6 +54,12 @@ class FileAllocationEntry : public RequestGroupEntry,
 private:
   std::unique_ptr<FileAllocationIterator> fileAllocationIterator_;
 
+  // Progress is cached here so that it can be read from the main
+  // thread while allocateChunksInWorker() runs in a worker thread.
+  int64_t currentLength_;
+
+  int64_t totalLength_;
+
 public:
   FileAllocationEntry(
       RequestGroup* requestGroup,
@@ -68,6 +75,19 @@ public:
 
   void allocateChunk();
 
+  // Returns true if the next chunk can be allocated by
+  // allocateChunksInWorker().
+  bool canAllocateInWorker();
+
+  // Allocates chunks until allocation finishes, the next chunk cannot
+  // be allocated in a worker thread, or timeout elapses.  This
+  // function is meant to be called from a worker thread; the progress
+  // is not updated until updateProgress() is called from the main
+  // thread.
+  void allocateChunksInWorker(std::chrono::milliseconds timeout);
+
+  void updateProgress();
+
   virtual void
   prepareForNextAction(std::vector<std::unique_ptr<Command>>& commands,
                        DownloadEngine* e) = 0;
@@ -52,6 +52,11 @@ public:
   virtual int64_t getCurrentLength() = 0;
 
   virtual int64_t getTotalLength() = 0;
+
+  // Returns true if the next allocateChunk() call only does blocking
+  // I/O on an already opened file, and touches neither the logger nor
+  // other shared state.  Such a call may be made from a worker thread.
+  virtual bool canAllocateInWorker() { return false; }
 };
 
 } // namespace aria2
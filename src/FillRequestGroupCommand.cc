@@ -91,6 +91,9 @@ bool FillRequestGroupCommand::execute()
       lastExecTime = now;
       rgman->requestQueueCheck();
     }
+    auto wakeupTime = lastExecTime;
+    wakeupTime.advance(1_s);
+    setWakeupTime(wakeupTime);
   }
 
   return false;
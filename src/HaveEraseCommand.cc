@@ -43,7 +43,7 @@ namespace aria2 {
 
 HaveEraseCommand::HaveEraseCommand(cuid_t cuid, DownloadEngine* e,
                                    std::chrono::seconds interval)
-    : TimeBasedCommand(cuid, e, std::move(interval), true)
+    : TimeBasedCommand(cuid, e, std::move(interval))
 {
 }
 
@@ -0,0 +1,323 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Http2DownloadCommand.h"
+
+#include <algorithm>
+
+#include "Http2Session.h"
+#include "Request.h"
+#include "RequestGroup.h"
+#include "DownloadEngine.h"
+#include "HttpRequest.h"
+#include "HttpHeader.h"
+#include "Range.h"
+#include "Segment.h"
+#include "SocketCore.h"
+#include "SocketRecvBuffer.h"
+#include "StreamFilter.h"
+#include "PieceStorage.h"
+#include "DiskAdaptor.h"
+#include "FileEntry.h"
+#include "Option.h"
+#include "CookieStorage.h"
+#include "AuthConfigFactory.h"
+#include "DownloadContext.h"
+#include "DlRetryEx.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "prefs.h"
+#include "util.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+Http2DownloadCommand::Http2DownloadCommand(
+    cuid_t cuid, const std::shared_ptr<Request>& req,
+    const std::shared_ptr<FileEntry>& fileEntry, RequestGroup* requestGroup,
+    DownloadEngine* e, const std::shared_ptr<Http2Session>& session)
+    : DownloadCommand(cuid, req, fileEntry, requestGroup, e,
+                      session->getSocket(),
+                      std::make_shared<SocketRecvBuffer>(session->getSocket())),
+      session_(session),
+      streamId_(-1),
+      startOffset_(0),
+      endOffset_(0),
+      responseChecked_(false)
+{
+  session_->addCommand(this);
+  setReadCheckSocket(getSocket());
+  setWriteCheckSocketIf(getSocket(), session_->wantWrite());
+}
+
+Http2DownloadCommand::~Http2DownloadCommand()
+{
+  session_->removeCommand(this);
+  if (streamId_ != -1) {
+    session_->closeStream(streamId_);
+    session_->send();
+  }
+}
+
+namespace {
+// Converts HTTP/1.1 request header |request| into HTTP/2 header
+// fields.  The connection-specific header fields are removed.
+std::vector<std::pair<std::string, std::string>>
+createHttp2Header(const std::string& request)
+{
+  std::vector<std::pair<std::string, std::string>> nva;
+  auto eol = request.find("\r\n");
+  // Request line is "METHOD SP PATH SP HTTP/1.1"
+  auto sp1 = request.find(' ');
+  auto sp2 = request.rfind(' ', eol);
+  nva.emplace_back(":method", request.substr(0, sp1));
+  nva.emplace_back(":scheme", "https");
+  nva.emplace_back(":path", request.substr(sp1 + 1, sp2 - sp1 - 1));
+  for (auto first = eol + 2; first < request.size();) {
+    auto last = request.find("\r\n", first);
+    if (last == std::string::npos) {
+      last = request.size();
+    }
+    auto colon = request.find(':', first);
+    if (colon < last) {
+      auto name = util::toLower(request.substr(first, colon - first));
+      auto value = util::strip(request.substr(colon + 1, last - colon - 1));
+      if (name == "host") {
+        // :authority must precede regular header fields.
+        nva.insert(std::begin(nva) + 3,
+                   std::make_pair(":authority", std::move(value)));
+      }
+      else if (name != "connection" && name != "keep-alive" &&
+               name != "proxy-connection" && name != "te" &&
+               name != "transfer-encoding" && name != "upgrade") {
+        nva.emplace_back(std::move(name), std::move(value));
+      }
+    }
+    first = last + 2;
+  }
+  return nva;
+}
+} // namespace
+
+void Http2DownloadCommand::submitRequest()
+{
+  const auto& segment = getSegments().front();
+  size_t nextIndex = getPieceStorage()->getNextUsedIndex(segment->getIndex());
+  int64_t endOffset = std::min(
+      getFileEntry()->getLength(),
+      getFileEntry()->gtoloff(static_cast<int64_t>(segment->getSegmentLength()) *
+                              nextIndex));
+
+  HttpRequest httpRequest;
+  httpRequest.setUserAgent(getOption()->get(PREF_USER_AGENT));
+  httpRequest.setRequest(getRequest());
+  httpRequest.setFileEntry(getFileEntry());
+  httpRequest.setSegment(segment);
+  httpRequest.addHeader(getOption()->get(PREF_HEADER));
+  httpRequest.setCookieStorage(getDownloadEngine()->getCookieStorage().get());
+  httpRequest.setAuthConfigFactory(
+      getDownloadEngine()->getAuthConfigFactory().get());
+  httpRequest.setOption(getOption().get());
+  httpRequest.setAcceptMetalink(getDownloadContext()->getAcceptMetalink());
+  // Response body is written to the disk as is.
+  httpRequest.disableAcceptGZip();
+  if (getOption()->getAsBool(PREF_HTTP_NO_CACHE)) {
+    httpRequest.enableNoCache();
+  }
+  else {
+    httpRequest.disableNoCache();
+  }
+  httpRequest.setEndOffsetOverride(endOffset);
+
+  auto range = httpRequest.getRange();
+  startOffset_ = range.startByte;
+  endOffset_ = range.endByte + 1;
+
+  auto request = httpRequest.createRequest();
+  A2_LOG_INFO(fmt("CUID#%" PRId64 " - Requesting over HTTP/2:\n%s",
+                  getCuid(), request.c_str()));
+  streamId_ = session_->submitRequest(createHttp2Header(request), this);
+  if (streamId_ == -1) {
+    throw DL_RETRY_EX("Could not submit HTTP/2 request");
+  }
+  session_->send();
+}
+
+bool Http2DownloadCommand::checkResponse()
+{
+  const auto& header = session_->findStream(streamId_)->header;
+  A2_LOG_INFO(fmt("CUID#%" PRId64 " - HTTP/2 response status=%d, stream=%d",
+                  getCuid(), header.getStatusCode(), streamId_));
+  if (header.getStatusCode() != 206) {
+    return false;
+  }
+  if (header.defined(HttpHeader::CONTENT_ENCODING) &&
+      header.find(HttpHeader::CONTENT_ENCODING) != "identity") {
+    return false;
+  }
+  auto range = header.getRange();
+  return range.startByte == startOffset_ && range.endByte + 1 == endOffset_ &&
+         range.entityLength == getFileEntry()->getLength();
+}
+
+bool Http2DownloadCommand::fallback(const char* reason)
+{
+  A2_LOG_INFO(fmt("CUID#%" PRId64 " - %s. Falling back to HTTP/1.1.",
+                  getCuid(), reason));
+  getDownloadEngine()->markHttp2Unsupported(getRequest()->getHost(),
+                                            getRequest()->getPort());
+  return prepareForRetry(0);
+}
+
+bool Http2DownloadCommand::waitSession()
+{
+  setReadCheckSocket(getSocket());
+  setWriteCheckSocketIf(getSocket(), session_->wantWrite());
+  addCommandSelf();
+  return false;
+}
+
+bool Http2DownloadCommand::executeInternal()
+{
+  if (session_->getState() == Http2Session::CONNECTING) {
+    if (!getSocket()->isWritable(0)) {
+      return waitSession();
+    }
+    if (!checkIfConnectionEstablished(getSocket(), session_->getHostname(),
+                                      session_->getAddr(),
+                                      session_->getPort())) {
+      session_->fail(fmt("Could not connect to %s:%u",
+                         session_->getAddr().c_str(), session_->getPort()));
+      return true;
+    }
+    session_->onConnected();
+  }
+  session_->performIO();
+  switch (session_->getState()) {
+  case Http2Session::CONNECTING:
+  case Http2Session::TLS_HANDSHAKE:
+    return waitSession();
+  case Http2Session::NOT_SUPPORTED:
+    return fallback("HTTP/2 was not negotiated");
+  case Http2Session::FAILED:
+    throw DL_RETRY_EX(session_->getError());
+  case Http2Session::CONNECTED:
+    break;
+  }
+  if (streamId_ == -1) {
+    if (!session_->canSubmitRequest()) {
+      // The server refused more streams.  Open new connection.
+      return prepareForRetry(0);
+    }
+    submitRequest();
+    return waitSession();
+  }
+  auto stream = session_->findStream(streamId_);
+  if (!responseChecked_) {
+    if (!stream->headerReceived) {
+      if (stream->closed) {
+        throw DL_RETRY_EX(fmt("HTTP/2 stream was closed, error_code=%u",
+                              stream->errorCode));
+      }
+      return waitSession();
+    }
+    if (!checkResponse()) {
+      return fallback("Unexpected HTTP/2 response");
+    }
+    responseChecked_ = true;
+  }
+  if (DownloadCommand::executeInternal()) {
+    return true;
+  }
+  if (stream->getDataLength() > 0) {
+    // The remaining data are not tied to socket event.
+    setStatus(Command::STATUS_ONESHOT_REALTIME);
+    getDownloadEngine()->setNoWait(true);
+  }
+  return false;
+}
+
+size_t Http2DownloadCommand::receiveBody(const std::shared_ptr<Segment>& segment,
+                                         bool& eof)
+{
+  auto stream = session_->findStream(streamId_);
+  size_t len = std::min(stream->getDataLength(), getSinkWriteLength(segment));
+  if (len > 0) {
+    getStreamFilter()->transform(getPieceStorage()->getDiskAdaptor(), segment,
+                                 stream->getData(), len);
+    session_->consume(streamId_, len);
+    session_->send();
+  }
+  eof = stream->closed && stream->getDataLength() == 0;
+  if (eof && stream->errorCode != NGHTTP2_NO_ERROR) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - HTTP/2 stream was reset,"
+                    " error_code=%u",
+                    getCuid(), stream->errorCode));
+  }
+  return len;
+}
+
+bool Http2DownloadCommand::noCheck() const
+{
+  if (DownloadCommand::noCheck()) {
+    return true;
+  }
+  switch (session_->getState()) {
+  case Http2Session::NOT_SUPPORTED:
+  case Http2Session::FAILED:
+    return true;
+  case Http2Session::CONNECTED: {
+    if (streamId_ == -1) {
+      return true;
+    }
+    auto stream = session_->findStream(streamId_);
+    return stream->getDataLength() > 0 || stream->closed ||
+           (!responseChecked_ && stream->headerReceived);
+  }
+  default:
+    return false;
+  }
+}
+
+int64_t Http2DownloadCommand::getRequestEndOffset() const
+{
+  return endOffset_;
+}
+
+bool Http2DownloadCommand::shouldEnableWriteCheck()
+{
+  return session_->wantWrite();
+}
+
+} // namespace aria2
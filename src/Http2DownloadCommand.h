@@ -0,0 +1,95 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_HTTP2_DOWNLOAD_COMMAND_H
+#define D_HTTP2_DOWNLOAD_COMMAND_H
+
+#include "DownloadCommand.h"
+
+namespace aria2 {
+
+class Http2Session;
+
+// Downloads a range of the file as a stream of HTTP/2 session.  The
+// session is shared with the other commands downloading from the same
+// host, and each of them works on its own segments just like a
+// separate HTTP/1.1 connection does.
+class Http2DownloadCommand : public DownloadCommand {
+private:
+  std::shared_ptr<Http2Session> session_;
+
+  int32_t streamId_;
+
+  // The requested range [startOffset_, endOffset_) in file local
+  // offset.
+  int64_t startOffset_;
+  int64_t endOffset_;
+
+  // true if the response header has been validated.
+  bool responseChecked_;
+
+  void submitRequest();
+
+  // Returns true if the response to the request is 206 Partial
+  // Content for the requested range, without content coding.
+  bool checkResponse();
+
+  bool waitSession();
+
+  // Gives up HTTP/2 for the host and retries with HTTP/1.1.
+  bool fallback(const char* reason);
+
+protected:
+  virtual bool executeInternal() CXX11_OVERRIDE;
+
+  virtual size_t receiveBody(const std::shared_ptr<Segment>& segment,
+                             bool& eof) CXX11_OVERRIDE;
+
+  virtual bool noCheck() const CXX11_OVERRIDE;
+
+  virtual int64_t getRequestEndOffset() const CXX11_OVERRIDE;
+
+  virtual bool shouldEnableWriteCheck() CXX11_OVERRIDE;
+
+public:
+  Http2DownloadCommand(cuid_t cuid, const std::shared_ptr<Request>& req,
+                       const std::shared_ptr<FileEntry>& fileEntry,
+                       RequestGroup* requestGroup, DownloadEngine* e,
+                       const std::shared_ptr<Http2Session>& session);
+  virtual ~Http2DownloadCommand();
+};
+
+} // namespace aria2
+
+#endif // D_HTTP2_DOWNLOAD_COMMAND_H
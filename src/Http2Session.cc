@@ -0,0 +1,542 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Http2Session.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "SocketCore.h"
+#include "DownloadEngine.h"
+#include "Command.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "RecoverableException.h"
+#include "a2functional.h"
+#include "message.h"
+#include "util.h"
+#include "fmt.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+const int32_t Http2Session::STREAM_WINDOW_SIZE;
+const int32_t Http2Session::CONNECTION_WINDOW_SIZE;
+
+Http2Stream::Http2Stream(int32_t streamId, Command* command)
+    : streamId(streamId),
+      command(command),
+      headerReceived(false),
+      dataFirst(0),
+      closed(false),
+      errorCode(NGHTTP2_NO_ERROR)
+{
+}
+
+namespace {
+ssize_t sendCallback(nghttp2_session* session, const uint8_t* data,
+                     size_t length, int flags, void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  const auto& socket = h2session->getSocket();
+  try {
+    ssize_t r = socket->writeData(data, length);
+    if (r == 0) {
+      if (socket->wantRead() || socket->wantWrite()) {
+        return NGHTTP2_ERR_WOULDBLOCK;
+      }
+      return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    return r;
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_DEBUG_EX(EX_EXCEPTION_CAUGHT, e);
+    return NGHTTP2_ERR_CALLBACK_FAILURE;
+  }
+}
+} // namespace
+
+namespace {
+ssize_t recvCallback(nghttp2_session* session, uint8_t* buf, size_t length,
+                     int flags, void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  const auto& socket = h2session->getSocket();
+  try {
+    socket->readData(buf, length);
+    if (length == 0) {
+      if (socket->wantRead() || socket->wantWrite()) {
+        return NGHTTP2_ERR_WOULDBLOCK;
+      }
+      return NGHTTP2_ERR_EOF;
+    }
+    return length;
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_DEBUG_EX(EX_EXCEPTION_CAUGHT, e);
+    return NGHTTP2_ERR_CALLBACK_FAILURE;
+  }
+}
+} // namespace
+
+namespace {
+int onHeaderCallback(nghttp2_session* session, const nghttp2_frame* frame,
+                     const uint8_t* name, size_t namelen, const uint8_t* value,
+                     size_t valuelen, uint8_t flags, void* userData)
+{
+  if (frame->hd.type != NGHTTP2_HEADERS ||
+      frame->headers.cat != NGHTTP2_HCAT_RESPONSE) {
+    return 0;
+  }
+  auto h2session = static_cast<Http2Session*>(userData);
+  h2session->onHeader(frame->hd.stream_id,
+                      std::string(name, name + namelen),
+                      std::string(value, value + valuelen));
+  return 0;
+}
+} // namespace
+
+namespace {
+int onFrameRecvCallback(nghttp2_session* session, const nghttp2_frame* frame,
+                        void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  switch (frame->hd.type) {
+  case NGHTTP2_HEADERS:
+    if (frame->headers.cat == NGHTTP2_HCAT_RESPONSE) {
+      h2session->onHeaderComplete(frame->hd.stream_id);
+    }
+    break;
+  case NGHTTP2_GOAWAY:
+    h2session->onGoaway();
+    break;
+  }
+  return 0;
+}
+} // namespace
+
+namespace {
+int onDataChunkRecvCallback(nghttp2_session* session, uint8_t flags,
+                            int32_t streamId, const uint8_t* data, size_t len,
+                            void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  h2session->onData(streamId, data, len);
+  return 0;
+}
+} // namespace
+
+namespace {
+int onStreamCloseCallback(nghttp2_session* session, int32_t streamId,
+                          uint32_t errorCode, void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  h2session->onStreamClose(streamId, errorCode);
+  return 0;
+}
+} // namespace
+
+Http2Session::Http2Session(const std::shared_ptr<SocketCore>& socket,
+                           const std::string& hostname,
+                           const std::string& addr, uint16_t port, bool secure,
+                           DownloadEngine* e)
+    : socket_(socket),
+      hostname_(hostname),
+      addr_(addr),
+      port_(port),
+      secure_(secure),
+      e_(e),
+      session_(nullptr),
+      state_(CONNECTING),
+      goawayReceived_(false)
+{
+}
+
+Http2Session::~Http2Session()
+{
+  if (session_) {
+    if (state_ == CONNECTED) {
+      nghttp2_session_terminate_session(session_, NGHTTP2_NO_ERROR);
+      nghttp2_session_send(session_);
+    }
+    nghttp2_session_del(session_);
+  }
+}
+
+void Http2Session::initSession()
+{
+  nghttp2_session_callbacks* callbacks;
+  if (nghttp2_session_callbacks_new(&callbacks) != 0) {
+    throw std::bad_alloc();
+  }
+  nghttp2_session_callbacks_set_send_callback(callbacks, sendCallback);
+  nghttp2_session_callbacks_set_recv_callback(callbacks, recvCallback);
+  nghttp2_session_callbacks_set_on_header_callback(callbacks,
+                                                   onHeaderCallback);
+  nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+                                                       onFrameRecvCallback);
+  nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+      callbacks, onDataChunkRecvCallback);
+  nghttp2_session_callbacks_set_on_stream_close_callback(
+      callbacks, onStreamCloseCallback);
+
+  nghttp2_option* opt;
+  if (nghttp2_option_new(&opt) != 0) {
+    nghttp2_session_callbacks_del(callbacks);
+    throw std::bad_alloc();
+  }
+  // Flow control window is opened only when the downloaded data is
+  // handed to the disk, so that the server cannot send more than we
+  // can hold.
+  nghttp2_option_set_no_auto_window_update(opt, 1);
+
+  int rv = nghttp2_session_client_new2(&session_, callbacks, this, opt);
+  nghttp2_option_del(opt);
+  nghttp2_session_callbacks_del(callbacks);
+  if (rv != 0) {
+    throw std::bad_alloc();
+  }
+
+  nghttp2_settings_entry iv[] = {
+      {NGHTTP2_SETTINGS_ENABLE_PUSH, 0},
+      {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE,
+       static_cast<uint32_t>(STREAM_WINDOW_SIZE)}};
+  nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, iv,
+                          sizeof(iv) / sizeof(iv[0]));
+  // The initial connection window is fixed to 65535 by the protocol.
+  nghttp2_submit_window_update(
+      session_, NGHTTP2_FLAG_NONE, 0,
+      CONNECTION_WINDOW_SIZE - NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE);
+}
+
+void Http2Session::onConnected()
+{
+  if (state_ != CONNECTING) {
+    return;
+  }
+  if (secure_) {
+    setState(TLS_HANDSHAKE);
+  }
+  else {
+    initSession();
+    setState(CONNECTED);
+  }
+}
+
+void Http2Session::performIO()
+{
+  if (state_ == TLS_HANDSHAKE) {
+#ifdef ENABLE_SSL
+    try {
+      if (!socket_->tlsConnect(hostname_, port_)) {
+        return;
+      }
+    }
+    catch (RecoverableException& e) {
+      fail(e.what());
+      return;
+    }
+    auto proto = socket_->getAlpnProtocol();
+    if (proto != "h2") {
+      A2_LOG_INFO(fmt("HTTP/2 is not supported by %s:%u",
+                      hostname_.c_str(), port_));
+      setState(NOT_SUPPORTED);
+      return;
+    }
+    A2_LOG_INFO(fmt("HTTP/2 connection to %s:%u established",
+                    hostname_.c_str(), port_));
+    initSession();
+    setState(CONNECTED);
+#else  // !ENABLE_SSL
+    fail("TLS is not supported");
+    return;
+#endif // !ENABLE_SSL
+  }
+  if (state_ != CONNECTED) {
+    return;
+  }
+  int rv = nghttp2_session_recv(session_);
+  if (rv != 0) {
+    if (rv == NGHTTP2_ERR_EOF) {
+      fail(EX_GOT_EOF);
+    }
+    else {
+      fail(fmt("HTTP/2 session error: %s", nghttp2_strerror(rv)));
+    }
+    return;
+  }
+  send();
+}
+
+void Http2Session::send()
+{
+  if (state_ != CONNECTED) {
+    return;
+  }
+  int rv = nghttp2_session_send(session_);
+  if (rv != 0) {
+    fail(fmt("HTTP/2 session error: %s", nghttp2_strerror(rv)));
+    return;
+  }
+  if (!nghttp2_session_want_read(session_) &&
+      !nghttp2_session_want_write(session_)) {
+    fail("HTTP/2 session was shut down");
+  }
+}
+
+bool Http2Session::canSubmitRequest() const
+{
+  if (state_ == NOT_SUPPORTED || state_ == FAILED || goawayReceived_) {
+    return false;
+  }
+  if (!session_) {
+    // We do not know the limit until the server SETTINGS arrive.
+    // HTTP/2 specification recommends that it is no smaller than
+    // 100.
+    return streams_.size() < 100;
+  }
+  return streams_.size() < nghttp2_session_get_remote_settings(
+                               session_, NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+}
+
+int32_t Http2Session::submitRequest(
+    const std::vector<std::pair<std::string, std::string>>& nva,
+    Command* command)
+{
+  std::vector<nghttp2_nv> nv;
+  nv.reserve(nva.size());
+  for (auto& kv : nva) {
+    nghttp2_nv n;
+    n.name = reinterpret_cast<uint8_t*>(const_cast<char*>(kv.first.c_str()));
+    n.namelen = kv.first.size();
+    n.value = reinterpret_cast<uint8_t*>(const_cast<char*>(kv.second.c_str()));
+    n.valuelen = kv.second.size();
+    n.flags = NGHTTP2_NV_FLAG_NONE;
+    nv.push_back(n);
+  }
+  int32_t streamId =
+      nghttp2_submit_request(session_, nullptr, nv.data(), nv.size(), nullptr,
+                             nullptr);
+  if (streamId < 0) {
+    A2_LOG_INFO(fmt("HTTP/2 request could not be submitted: %s",
+                    nghttp2_strerror(streamId)));
+    return -1;
+  }
+  streams_.insert(std::make_pair(
+      streamId, make_unique<Http2Stream>(streamId, command)));
+  return streamId;
+}
+
+Http2Stream* Http2Session::findStream(int32_t streamId) const
+{
+  auto i = streams_.find(streamId);
+  if (i == streams_.end()) {
+    return nullptr;
+  }
+  return (*i).second.get();
+}
+
+void Http2Session::consume(int32_t streamId, size_t len)
+{
+  auto stream = findStream(streamId);
+  if (!stream || len == 0) {
+    return;
+  }
+  stream->dataFirst += len;
+  if (stream->dataFirst == stream->data.size()) {
+    stream->data.clear();
+    stream->dataFirst = 0;
+  }
+  if (session_) {
+    nghttp2_session_consume(session_, streamId, len);
+  }
+}
+
+void Http2Session::closeStream(int32_t streamId)
+{
+  auto i = streams_.find(streamId);
+  if (i == streams_.end()) {
+    return;
+  }
+  auto& stream = (*i).second;
+  if (session_) {
+    if (!stream->closed) {
+      nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, streamId,
+                                NGHTTP2_CANCEL);
+    }
+    // Give back the connection-level window held by the data which
+    // are never processed.
+    nghttp2_session_consume(session_, streamId, stream->getDataLength());
+  }
+  streams_.erase(i);
+}
+
+void Http2Session::addCommand(Command* command)
+{
+  commands_.push_back(command);
+}
+
+void Http2Session::removeCommand(Command* command)
+{
+  commands_.erase(std::remove(std::begin(commands_), std::end(commands_),
+                              command),
+                  std::end(commands_));
+  if (commands_.empty()) {
+    idleTimer_ = global::wallclock();
+  }
+}
+
+bool Http2Session::isIdleTimeout(std::chrono::seconds timeout) const
+{
+  return commands_.empty() &&
+         idleTimer_.difference(global::wallclock()) >= timeout;
+}
+
+bool Http2Session::wantRead() const
+{
+  switch (state_) {
+  case TLS_HANDSHAKE:
+    return socket_->wantRead();
+  case CONNECTED:
+    return nghttp2_session_want_read(session_);
+  default:
+    return false;
+  }
+}
+
+bool Http2Session::wantWrite() const
+{
+  switch (state_) {
+  case CONNECTING:
+    return true;
+  case TLS_HANDSHAKE:
+    return socket_->wantWrite();
+  case CONNECTED:
+    return socket_->wantWrite() || nghttp2_session_want_write(session_);
+  default:
+    return false;
+  }
+}
+
+void Http2Session::onHeader(int32_t streamId, const std::string& name,
+                            const std::string& value)
+{
+  auto stream = findStream(streamId);
+  if (!stream) {
+    return;
+  }
+  if (name == ":status") {
+    uint32_t status;
+    if (util::parseUIntNoThrow(status, value)) {
+      stream->header.setStatusCode(status);
+    }
+    return;
+  }
+  int hdKey = idInterestingHeader(name.c_str());
+  if (hdKey != HttpHeader::MAX_INTERESTING_HEADER) {
+    stream->header.put(hdKey, value);
+  }
+}
+
+void Http2Session::onHeaderComplete(int32_t streamId)
+{
+  auto stream = findStream(streamId);
+  if (!stream) {
+    return;
+  }
+  // Ignore informational (1xx) response.
+  if (stream->header.getStatusCode() / 100 == 1) {
+    stream->header.clearField();
+    return;
+  }
+  stream->headerReceived = true;
+  wakeUp(stream->command);
+}
+
+void Http2Session::onData(int32_t streamId, const uint8_t* data, size_t len)
+{
+  auto stream = findStream(streamId);
+  if (!stream) {
+    // The stream has been canceled.  Nobody will process these data.
+    nghttp2_session_consume(session_, streamId, len);
+    return;
+  }
+  stream->data.insert(std::end(stream->data), data, data + len);
+  wakeUp(stream->command);
+}
+
+void Http2Session::onStreamClose(int32_t streamId, uint32_t errorCode)
+{
+  auto stream = findStream(streamId);
+  if (!stream) {
+    return;
+  }
+  stream->closed = true;
+  stream->errorCode = errorCode;
+  wakeUp(stream->command);
+}
+
+void Http2Session::onGoaway()
+{
+  A2_LOG_INFO(fmt("HTTP/2 GOAWAY received from %s:%u", hostname_.c_str(),
+                  port_));
+  goawayReceived_ = true;
+}
+
+void Http2Session::fail(const std::string& error)
+{
+  A2_LOG_INFO(fmt("HTTP/2 connection to %s:%u failed: %s", hostname_.c_str(),
+                  port_, error.c_str()));
+  error_ = error;
+  setState(FAILED);
+}
+
+void Http2Session::setState(State state)
+{
+  state_ = state;
+  for (auto command : commands_) {
+    wakeUp(command);
+  }
+}
+
+void Http2Session::wakeUp(Command* command)
+{
+  if (!command) {
+    return;
+  }
+  command->setStatus(Command::STATUS_ONESHOT_REALTIME);
+  e_->setNoWait(true);
+}
+
+} // namespace aria2
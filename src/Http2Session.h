@@ -0,0 +1,212 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_HTTP2_SESSION_H
+#define D_HTTP2_SESSION_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <nghttp2/nghttp2.h>
+
+#include "HttpHeader.h"
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class SocketCore;
+class DownloadEngine;
+class Command;
+
+// A request/response exchange multiplexed in Http2Session.
+struct Http2Stream {
+  int32_t streamId;
+  // The command which consumes the response.  It is woken up when
+  // something happens to this stream.
+  Command* command;
+  // Response header fields.  Only the interesting headers are stored.
+  HttpHeader header;
+  // true if the whole response header has been received.
+  bool headerReceived;
+  // Response body received but not consumed yet.  The data in
+  // [dataFirst, data.size()) is available.
+  std::vector<unsigned char> data;
+  size_t dataFirst;
+  // true if the stream was closed by the remote endpoint.
+  bool closed;
+  // HTTP/2 error code the stream was closed with.
+  uint32_t errorCode;
+
+  Http2Stream(int32_t streamId, Command* command);
+
+  size_t getDataLength() const { return data.size() - dataFirst; }
+
+  const unsigned char* getData() const { return data.data() + dataFirst; }
+};
+
+// HTTP/2 client session over single connection, built on top of
+// nghttp2.  The session is shared by the commands which download
+// different ranges of the same host concurrently; each of them owns
+// one stream.  Connection-level I/O is driven by whichever command
+// calls performIO() first.
+class Http2Session {
+public:
+  enum State {
+    // Waiting for TCP connection to be established.
+    CONNECTING,
+    // Performing TLS handshake and ALPN negotiation.
+    TLS_HANDSHAKE,
+    // HTTP/2 connection is ready.
+    CONNECTED,
+    // The remote endpoint did not select HTTP/2 in ALPN.  The
+    // connection must not be used for HTTP/2.
+    NOT_SUPPORTED,
+    // The connection failed or was shut down.  See getError().
+    FAILED
+  };
+
+  // The per-stream flow control window advertised to the server.
+  // Large windows keep the pipe full on long fat network.
+  static const int32_t STREAM_WINDOW_SIZE = 16 * 1024 * 1024;
+  // The connection-level flow control window shared by all streams.
+  static const int32_t CONNECTION_WINDOW_SIZE = 64 * 1024 * 1024;
+
+  // If |secure| is false, the session starts with HTTP/2 connection
+  // preface without TLS, assuming prior knowledge.
+  Http2Session(const std::shared_ptr<SocketCore>& socket,
+               const std::string& hostname, const std::string& addr,
+               uint16_t port, bool secure, DownloadEngine* e);
+  ~Http2Session();
+
+  // Call this function when the TCP connection is established.
+  void onConnected();
+
+  // Performs TLS handshake if it is not finished, and then receives
+  // and sends HTTP/2 frames as much as possible without blocking.
+  // Errors are reported by changing the state to FAILED.
+  void performIO();
+
+  // Sends the pending frames, such as WINDOW_UPDATE emitted by
+  // consume().
+  void send();
+
+  State getState() const { return state_; }
+
+  const std::string& getError() const { return error_; }
+
+  // Returns true if new stream can be opened in this session.
+  bool canSubmitRequest() const;
+
+  // Submits request with the header fields |nva|, which must include
+  // the pseudo header fields.  |command| is woken up when the
+  // response arrives.  Returns stream ID, or -1 if it fails.
+  int32_t submitRequest(const std::vector<std::pair<std::string, std::string>>&
+                            nva,
+                        Command* command);
+
+  Http2Stream* findStream(int32_t streamId) const;
+
+  // Tells that |len| bytes of response body of the stream
+  // |streamId| have been processed, and drops them from the buffer.
+  // The flow control window is opened accordingly.
+  void consume(int32_t streamId, size_t len);
+
+  // Cancels the stream |streamId| if it is still open, and forgets
+  // it.
+  void closeStream(int32_t streamId);
+
+  // Registers |command| to be woken up when the state changes.
+  void addCommand(Command* command);
+
+  void removeCommand(Command* command);
+
+  // Returns true if no command uses this session.
+  bool isIdle() const { return commands_.empty(); }
+
+  // Returns true if no command has used this session for |timeout|.
+  bool isIdleTimeout(std::chrono::seconds timeout) const;
+
+  // Marks this session failed with the message |error|.
+  void fail(const std::string& error);
+
+  bool wantRead() const;
+
+  bool wantWrite() const;
+
+  const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
+
+  const std::string& getHostname() const { return hostname_; }
+
+  const std::string& getAddr() const { return addr_; }
+
+  uint16_t getPort() const { return port_; }
+
+  // The followings are used by nghttp2 callbacks.
+  void onHeader(int32_t streamId, const std::string& name,
+                const std::string& value);
+  void onHeaderComplete(int32_t streamId);
+  void onData(int32_t streamId, const uint8_t* data, size_t len);
+  void onStreamClose(int32_t streamId, uint32_t errorCode);
+  void onGoaway();
+
+private:
+  void initSession();
+
+  void setState(State state);
+
+  void wakeUp(Command* command);
+
+  std::shared_ptr<SocketCore> socket_;
+  std::string hostname_;
+  std::string addr_;
+  uint16_t port_;
+  bool secure_;
+  DownloadEngine* e_;
+  nghttp2_session* session_;
+  State state_;
+  std::string error_;
+  bool goawayReceived_;
+  std::map<int32_t, std::unique_ptr<Http2Stream>> streams_;
+  std::vector<Command*> commands_;
+  // The time when the last command stopped using this session.
+  Timer idleTimer_;
+};
+
+} // namespace aria2
+
+#endif // D_HTTP2_SESSION_H
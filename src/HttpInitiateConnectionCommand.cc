@@ -55,6 +55,12 @@
 #include "ConnectCommand.h"
 #include "HttpRequestConnectChain.h"
 #include "HttpProxyRequestConnectChain.h"
+#include "RequestGroup.h"
+#include "PieceStorage.h"
+#ifdef ENABLE_HTTP2
+#  include "Http2Session.h"
+#  include "Http2DownloadCommand.h"
+#endif // ENABLE_HTTP2
 
 namespace aria2 {
 
@@ -116,6 +122,11 @@ std::unique_ptr<Command> HttpInitiateConnectionCommand::createNextCommand(
     }
   }
   else {
+#ifdef ENABLE_HTTP2
+    if (shouldUseHttp2()) {
+      return createHttp2DownloadCommand(hostname, addr, port);
+    }
+#endif // ENABLE_HTTP2
     std::shared_ptr<SocketCore> pooledSocket =
         getDownloadEngine()->popPooledSocket(resolvedAddresses,
                                              getRequest()->getPort());
@@ -147,4 +158,45 @@ std::unique_ptr<Command> HttpInitiateConnectionCommand::createNextCommand(
   }
 }
 
+#ifdef ENABLE_HTTP2
+bool HttpInitiateConnectionCommand::shouldUseHttp2() const
+{
+  // HTTP/2 streams only download ranges, so the file size must be
+  // known already.
+  return getRequest()->getProtocol() == "https" &&
+         getOption()->getAsBool(PREF_ENABLE_HTTP2) && getPieceStorage() &&
+         getRequestGroup()->getTotalLength() > 0 &&
+         !getDownloadEngine()->isHttp2Unsupported(getRequest()->getHost(),
+                                                  getRequest()->getPort());
+}
+
+std::unique_ptr<Command> HttpInitiateConnectionCommand::createHttp2DownloadCommand(
+    const std::string& hostname, const std::string& addr, uint16_t port)
+{
+  auto session = getDownloadEngine()->findHttp2Session(getRequest()->getHost(),
+                                                       getRequest()->getPort());
+  if (session) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Reusing HTTP/2 connection to %s:%u",
+                    getCuid(), session->getAddr().c_str(),
+                    session->getPort()));
+    getRequest()->setConnectedAddrInfo(session->getHostname(),
+                                       session->getAddr(), session->getPort());
+  }
+  else {
+    A2_LOG_INFO(fmt(MSG_CONNECTING_TO_SERVER, getCuid(), addr.c_str(), port));
+    createSocket();
+    getSocket()->setAlpnProtocols({"h2", "http/1.1"});
+    getSocket()->establishConnection(addr, port);
+
+    getRequest()->setConnectedAddrInfo(hostname, addr, port);
+    session = std::make_shared<Http2Session>(getSocket(), hostname, addr, port,
+                                             true, getDownloadEngine());
+    getDownloadEngine()->addHttp2Session(session);
+  }
+  return make_unique<Http2DownloadCommand>(getCuid(), getRequest(),
+                                           getFileEntry(), getRequestGroup(),
+                                           getDownloadEngine(), session);
+}
+#endif // ENABLE_HTTP2
+
 } // namespace aria2
@@ -58,6 +58,8 @@ namespace aria2 {
 //                 |                +------------> HttpProxyRequestCommand
 //                 |                |  otherwise
 //                 |                +------------> HttpRequestCommand
+//                 | HTTP/2 is enabled for https?
+//                 +-----------------------------> Http2DownloadCommand
 //                 | direct connection
 //                 +-----------------------------> HttpRequestCommand
 //
@@ -67,6 +69,17 @@ namespace aria2 {
 // resolution is in progress. After address resolution completed,
 // calling execute() returns true.
 class HttpInitiateConnectionCommand : public InitiateConnectionCommand {
+private:
+#ifdef ENABLE_HTTP2
+  bool shouldUseHttp2() const;
+
+  // Returns Http2DownloadCommand which shares the existing HTTP/2
+  // session to the host, or opens new one.
+  std::unique_ptr<Command> createHttp2DownloadCommand(const std::string& hostname,
+                                                      const std::string& addr,
+                                                      uint16_t port);
+#endif // ENABLE_HTTP2
+
 protected:
   virtual std::unique_ptr<Command> createNextCommand(
       const std::string& hostname, const std::string& addr, uint16_t port,
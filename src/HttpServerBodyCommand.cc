@@ -172,6 +172,14 @@ void HttpServerBodyCommand::updateWriteCheck()
   }
 }
 
+void HttpServerBodyCommand::addCommandSelf()
+{
+  auto timeout = timeoutTimer_;
+  timeout.advance(30_s);
+  setWakeupTime(timeout);
+  e_->addCommand(std::unique_ptr<Command>(this));
+}
+
 bool HttpServerBodyCommand::execute()
 {
   if (e_->getRequestGroupMan()->downloadFinished() || e_->isHaltRequested()) {
@@ -318,7 +326,7 @@ bool HttpServerBodyCommand::execute()
       }
       else {
         updateWriteCheck();
-        e_->addCommand(std::unique_ptr<Command>(this));
+        addCommandSelf();
         return false;
       }
     }
@@ -328,7 +336,7 @@ bool HttpServerBodyCommand::execute()
         return true;
       }
       else {
-        e_->addCommand(std::unique_ptr<Command>(this));
+        addCommandSelf();
         return false;
       }
     }
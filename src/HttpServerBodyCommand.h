@@ -63,6 +63,9 @@ private:
                                 const std::string& callback);
   void addHttpServerResponseCommand(bool delayed);
   void updateWriteCheck();
+  // Adds this command back to e_.  It is woken up when the request
+  // times out at the latest.
+  void addCommandSelf();
 
 public:
   HttpServerBodyCommand(cuid_t cuid,
@@ -168,6 +168,14 @@ void HttpServerCommand::updateWriteCheck()
   }
 }
 
+void HttpServerCommand::addCommandSelf()
+{
+  auto timeout = timeoutTimer_;
+  timeout.advance(30_s);
+  setWakeupTime(timeout);
+  e_->addCommand(std::unique_ptr<Command>(this));
+}
+
 bool HttpServerCommand::execute()
 {
   if (e_->getRequestGroupMan()->downloadFinished() || e_->isHaltRequested()) {
@@ -185,7 +193,7 @@ bool HttpServerCommand::execute()
         // finished.
         if (!socket_->tlsAccept()) {
           updateWriteCheck();
-          e_->addCommand(std::unique_ptr<Command>(this));
+          addCommandSelf();
           return false;
         }
       }
@@ -193,7 +201,7 @@ bool HttpServerCommand::execute()
 
       if (!httpServer_->receiveRequest()) {
         updateWriteCheck();
-        e_->addCommand(std::unique_ptr<Command>(this));
+        addCommandSelf();
         return false;
       }
       // CORS preflight request uses OPTIONS method. It is not
@@ -263,7 +271,7 @@ bool HttpServerCommand::execute()
         return true;
       }
       else {
-        e_->addCommand(std::unique_ptr<Command>(this));
+        addCommandSelf();
         return false;
       }
     }
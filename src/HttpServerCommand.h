@@ -57,6 +57,9 @@ private:
 
   void checkSocketRecvBuffer();
   void updateWriteCheck();
+  // Adds this command back to e_.  It is woken up when the request
+  // times out at the latest.
+  void addCommandSelf();
 
 public:
   HttpServerCommand(cuid_t cuid, DownloadEngine* e,
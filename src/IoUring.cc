@@ -0,0 +1,267 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "IoUring.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+IoUring::IoUring(uint32_t sqEntries, uint32_t cqEntries)
+    : fd_(-1),
+      features_(0),
+      sqRing_(MAP_FAILED),
+      sqRingSize_(0),
+      cqRing_(MAP_FAILED),
+      cqRingSize_(0),
+      sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED)),
+      sqesSize_(0),
+      sqeTail_(0),
+      numEnterCalls_(0)
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  if (cqEntries > 0) {
+    params.flags |= IORING_SETUP_CQSIZE;
+    params.cq_entries = cqEntries;
+  }
+  int fd = syscall(__NR_io_uring_setup, sqEntries, &params);
+  if (fd == -1) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("io_uring_setup failed: %s",
+                    util::safeStrerror(errNum).c_str()));
+    return;
+  }
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cqRingSize_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sqRing_ == MAP_FAILED) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("mmap for io_uring SQ ring failed: %s",
+                    util::safeStrerror(errNum).c_str()));
+    close(fd);
+    return;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cqRing_ = sqRing_;
+  }
+  else {
+    cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cqRing_ == MAP_FAILED) {
+      int errNum = errno;
+      A2_LOG_INFO(fmt("mmap for io_uring CQ ring failed: %s",
+                      util::safeStrerror(errNum).c_str()));
+      munmap(sqRing_, sqRingSize_);
+      sqRing_ = MAP_FAILED;
+      close(fd);
+      return;
+    }
+  }
+  sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = static_cast<struct io_uring_sqe*>(
+      mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+  if (sqes_ == MAP_FAILED) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("mmap for io_uring SQEs failed: %s",
+                    util::safeStrerror(errNum).c_str()));
+    if (cqRing_ != sqRing_) {
+      munmap(cqRing_, cqRingSize_);
+    }
+    munmap(sqRing_, sqRingSize_);
+    sqRing_ = cqRing_ = MAP_FAILED;
+    close(fd);
+    return;
+  }
+  auto sq = static_cast<char*>(sqRing_);
+  sqHead_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+  sqTail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+  sqMask_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+  sqEntries_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_entries);
+  sqArray_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+  auto cq = static_cast<char*>(cqRing_);
+  cqHead_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+  cqTail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+  cqMask_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  sqeTail_ = *sqTail_;
+  features_ = params.features;
+  fd_ = fd;
+}
+
+IoUring::~IoUring()
+{
+  if (fd_ == -1) {
+    return;
+  }
+  munmap(sqes_, sqesSize_);
+  if (cqRing_ != sqRing_) {
+    munmap(cqRing_, cqRingSize_);
+  }
+  munmap(sqRing_, sqRingSize_);
+  close(fd_);
+}
+
+struct io_uring_sqe* IoUring::getSqe()
+{
+  if (countQueued() >= *sqEntries_) {
+    if (submit() < 0 || countQueued() >= *sqEntries_) {
+      return nullptr;
+    }
+  }
+  auto sqe = &sqes_[sqeTail_ & *sqMask_];
+  memset(sqe, 0, sizeof(*sqe));
+  ++sqeTail_;
+  return sqe;
+}
+
+void IoUring::flushSqes()
+{
+  uint32_t tail = *sqTail_;
+  if (tail == sqeTail_) {
+    return;
+  }
+  for (; tail != sqeTail_; ++tail) {
+    sqArray_[tail & *sqMask_] = tail & *sqMask_;
+  }
+  __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+}
+
+int IoUring::enter(uint32_t toSubmit, uint32_t minComplete, uint32_t flags,
+                   const void* arg, size_t argsz, bool restart)
+{
+  ++numEnterCalls_;
+  int rv;
+  while ((rv = syscall(__NR_io_uring_enter, fd_, toSubmit, minComplete, flags,
+                       arg, argsz)) == -1 &&
+         errno == EINTR && restart)
+    ;
+  return rv == -1 ? -errno : rv;
+}
+
+int IoUring::submitAndWait(uint32_t waitNr, const struct timespec* timeout)
+{
+  flushSqes();
+  uint32_t toSubmit = countQueued();
+  uint32_t flags = 0;
+  if (waitNr > 0) {
+    flags |= IORING_ENTER_GETEVENTS;
+  }
+  if (toSubmit == 0 && waitNr == 0) {
+    return 0;
+  }
+  int rv;
+  if (timeout && waitNr > 0) {
+    struct __kernel_timespec ts;
+    ts.tv_sec = timeout->tv_sec;
+    ts.tv_nsec = timeout->tv_nsec;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof(arg));
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+    // Do not restart on EINTR, so that DownloadEngine notices the
+    // signal without waiting for the timeout.
+    rv = enter(toSubmit, waitNr, flags | IORING_ENTER_EXT_ARG, &arg,
+               sizeof(arg), false);
+  }
+  else {
+    rv = enter(toSubmit, waitNr, flags, nullptr, 0);
+  }
+  if (rv == -ETIME || rv == -EINTR) {
+    // Timeout is reported even if some entries were submitted.
+    // Submission itself never fails with ETIME, so we just report how
+    // many entries were consumed by the kernel.
+    return toSubmit - countQueued();
+  }
+  return rv;
+}
+
+int IoUring::registerFiles(const int* fds, uint32_t nfds)
+{
+  int rv = syscall(__NR_io_uring_register, fd_, IORING_REGISTER_FILES, fds,
+                   nfds);
+  return rv == -1 ? -errno : rv;
+}
+
+int IoUring::unregisterFiles()
+{
+  int rv = syscall(__NR_io_uring_register, fd_, IORING_UNREGISTER_FILES,
+                   nullptr, 0);
+  return rv == -1 ? -errno : rv;
+}
+
+int IoUring::updateFiles(uint32_t offset, const int* fds, uint32_t nfds)
+{
+  struct io_uring_files_update update;
+  memset(&update, 0, sizeof(update));
+  update.offset = offset;
+  update.fds = reinterpret_cast<uint64_t>(fds);
+  int rv = syscall(__NR_io_uring_register, fd_, IORING_REGISTER_FILES_UPDATE,
+                   &update, nfds);
+  return rv == -1 ? -errno : rv;
+}
+
+int IoUring::registerBuffers(const struct iovec* iovs, uint32_t niovs)
+{
+  int rv = syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, iovs,
+                   niovs);
+  return rv == -1 ? -errno : rv;
+}
+
+int IoUring::unregisterBuffers()
+{
+  int rv = syscall(__NR_io_uring_register, fd_, IORING_UNREGISTER_BUFFERS,
+                   nullptr, 0);
+  return rv == -1 ? -errno : rv;
+}
+
+} // namespace aria2
@@ -0,0 +1,169 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_IO_URING_H
+#define D_IO_URING_H
+
+#include "common.h"
+
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+struct timespec;
+struct iovec;
+
+namespace aria2 {
+
+// Thin wrapper of Linux io_uring interface.  We use raw system calls
+// instead of liburing to avoid another external dependency.  This
+// class is not thread-safe.
+class IoUring {
+public:
+  // Sets up io_uring with sqEntries submission queue entries and
+  // cqEntries completion queue entries.  If cqEntries is 0, the
+  // kernel default (twice as large as sqEntries) is used.
+  IoUring(uint32_t sqEntries, uint32_t cqEntries = 0);
+
+  ~IoUring();
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  bool good() const { return fd_ != -1; }
+
+  // Returns IORING_FEAT_* bits supported by the kernel.
+  uint32_t getFeatures() const { return features_; }
+
+  // Returns cleared submission queue entry.  If the submission queue
+  // is full, queued entries are submitted first.  Returns nullptr if
+  // no entry is available.
+  struct io_uring_sqe* getSqe();
+
+  // Returns the number of entries queued by getSqe() but not
+  // submitted yet.
+  uint32_t countQueued() const
+  {
+    return sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+  }
+
+  // Submits queued entries and waits until at least waitNr
+  // completions are available or timeout expires.  If timeout is
+  // nullptr, waits without timeout.  timeout requires
+  // IORING_FEAT_EXT_ARG.  Returns the number of submitted entries, or
+  // -errno.  Timeout is not an error, and returns 0 or the number of
+  // submitted entries.  A signal interrupts the wait with timeout,
+  // which is reported as timeout.
+  int submitAndWait(uint32_t waitNr, const struct timespec* timeout);
+
+  int submit() { return submitAndWait(0, nullptr); }
+
+  // Calls f(const io_uring_cqe&) for each available completion queue
+  // entry and returns the number of entries processed.
+  template <typename F> size_t reap(F f)
+  {
+    size_t n = 0;
+    uint32_t head = *cqHead_;
+    for (;;) {
+      uint32_t tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+      if (head == tail) {
+        break;
+      }
+      for (; head != tail; ++head, ++n) {
+        f(cqes_[head & *cqMask_]);
+      }
+      __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+    return n;
+  }
+
+  // Registers file descriptors with IORING_REGISTER_FILES.  Returns
+  // 0 on success, or -errno.
+  int registerFiles(const int* fds, uint32_t nfds);
+
+  int unregisterFiles();
+
+  // Replaces nfds registered files starting at offset with fds using
+  // IORING_REGISTER_FILES_UPDATE.  -1 clears the slot.  Returns the
+  // number of updated slots, or -errno.
+  int updateFiles(uint32_t offset, const int* fds, uint32_t nfds);
+
+  // Registers buffers with IORING_REGISTER_BUFFERS.  Returns 0 on
+  // success, or -errno.
+  int registerBuffers(const struct iovec* iovs, uint32_t niovs);
+
+  int unregisterBuffers();
+
+  // Returns the number of io_uring_enter(2) calls made so far.
+  uint64_t getNumEnterCalls() const { return numEnterCalls_; }
+
+private:
+  // Restarts io_uring_enter(2) on EINTR if restart is true.
+  int enter(uint32_t toSubmit, uint32_t minComplete, uint32_t flags,
+            const void* arg, size_t argsz, bool restart = true);
+
+  void flushSqes();
+
+  int fd_;
+
+  uint32_t features_;
+
+  void* sqRing_;
+  size_t sqRingSize_;
+  void* cqRing_;
+  size_t cqRingSize_;
+  struct io_uring_sqe* sqes_;
+  size_t sqesSize_;
+
+  uint32_t* sqHead_;
+  uint32_t* sqTail_;
+  uint32_t* sqMask_;
+  uint32_t* sqEntries_;
+  uint32_t* sqArray_;
+
+  uint32_t* cqHead_;
+  uint32_t* cqTail_;
+  uint32_t* cqMask_;
+  struct io_uring_cqe* cqes_;
+
+  // Tail of the entries handed out by getSqe().  It is published to
+  // the kernel by flushSqes().
+  uint32_t sqeTail_;
+
+  uint64_t numEnterCalls_;
+};
+
+} // namespace aria2
+
+#endif // D_IO_URING_H
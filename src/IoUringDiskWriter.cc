@@ -0,0 +1,396 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "IoUringDiskWriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <cassert>
+
+#include "IoUring.h"
+#include "DiskIoUring.h"
+#include "DlAbortEx.h"
+#include "DownloadFailureException.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "message.h"
+#include "error_code.h"
+#include "util.h"
+#include "a2functional.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+IoUringDiskWriter::IoUringDiskWriter(const std::string& filename,
+                                     std::shared_ptr<DiskIoUring> uring)
+    : DefaultDiskWriter(filename),
+      uring_(std::move(uring)),
+      active_(false),
+      fileIndex_(-1)
+{
+}
+
+IoUringDiskWriter::~IoUringDiskWriter() { closeFile(); }
+
+void IoUringDiskWriter::initAndOpenFile(int64_t totalLength)
+{
+  DefaultDiskWriter::initAndOpenFile(totalLength);
+  setupRing();
+}
+
+void IoUringDiskWriter::openExistingFile(int64_t totalLength)
+{
+  DefaultDiskWriter::openExistingFile(totalLength);
+  setupRing();
+}
+
+void IoUringDiskWriter::closeFile()
+{
+  if (!pending_.empty()) {
+    try {
+      flushWrites();
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_ERROR_EX(fmt("Flushing writes to %s failed",
+                          getFilename().c_str()),
+                      e);
+    }
+  }
+  teardownRing();
+  DefaultDiskWriter::closeFile();
+}
+
+void IoUringDiskWriter::setupRing()
+{
+  teardownRing();
+  int fd = getFd();
+  if (fd == -1 || isMmapEnabled()) {
+    return;
+  }
+  if (!uring_) {
+    uring_ = std::make_shared<DiskIoUring>();
+  }
+  if (!uring_->good()) {
+    A2_LOG_DEBUG(fmt("io_uring is not available for %s",
+                     getFilename().c_str()));
+    return;
+  }
+  fileIndex_ = uring_->registerFile(fd);
+  active_ = true;
+  A2_LOG_DEBUG(fmt("Using io_uring for %s, fileIndex=%d",
+                   getFilename().c_str(), fileIndex_));
+}
+
+void IoUringDiskWriter::teardownRing()
+{
+  assert(pending_.empty());
+  if (fileIndex_ != -1) {
+    uring_->unregisterFile(fileIndex_);
+    fileIndex_ = -1;
+  }
+  active_ = false;
+}
+
+bool IoUringDiskWriter::usesRing() const
+{
+  // mmap may be enabled after the file is opened.  Then we fall back
+  // to AbstractDiskWriter, which writes to the mapped memory.
+  return active_ && uring_->good() && !isMmapEnabled();
+}
+
+namespace {
+void prepareSqe(struct io_uring_sqe* sqe, uint8_t opcode, int fd,
+                int fileIndex, uint64_t addr, size_t len, int64_t offset)
+{
+  sqe->opcode = opcode;
+  if (fileIndex != -1) {
+    sqe->fd = fileIndex;
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+  else {
+    sqe->fd = fd;
+  }
+  sqe->addr = addr;
+  sqe->len = len;
+  sqe->off = offset;
+}
+
+// Removes the first |n| bytes from |iovs|.
+void advanceIovs(std::vector<struct iovec>& iovs, size_t n)
+{
+  auto i = std::begin(iovs);
+  for (; n > 0 && n >= (*i).iov_len; ++i) {
+    n -= (*i).iov_len;
+  }
+  iovs.erase(std::begin(iovs), i);
+  if (n > 0) {
+    iovs.front().iov_base = static_cast<char*>(iovs.front().iov_base) + n;
+    iovs.front().iov_len -= n;
+  }
+}
+
+// The maximum number of buffers merged into one request.
+constexpr size_t MAX_MERGED_IOVS = 64;
+} // namespace
+
+bool IoUringDiskWriter::submitWrite(size_t index)
+{
+  auto sqe = uring_->getRing()->getSqe();
+  if (!sqe) {
+    return false;
+  }
+  auto& req = pending_[index];
+  if (req.bufIndex != -1) {
+    prepareSqe(sqe, IORING_OP_WRITE_FIXED, getFd(), fileIndex_,
+               reinterpret_cast<uint64_t>(
+                   uring_->getBufferData(req.bufIndex) + req.written),
+               req.len - req.written, req.offset + req.written);
+    sqe->buf_index = req.bufIndex;
+  }
+  else if (req.iovs.size() == 1) {
+    prepareSqe(sqe, IORING_OP_WRITE, getFd(), fileIndex_,
+               reinterpret_cast<uint64_t>(req.iovs[0].iov_base),
+               req.iovs[0].iov_len, req.offset + req.written);
+  }
+  else {
+    prepareSqe(sqe, IORING_OP_WRITEV, getFd(), fileIndex_,
+               reinterpret_cast<uint64_t>(req.iovs.data()), req.iovs.size(),
+               req.offset + req.written);
+  }
+  sqe->user_data = index;
+  return true;
+}
+
+void IoUringDiskWriter::writeData(const unsigned char* data, size_t len,
+                                  int64_t offset)
+{
+  queueWrite(data, len, offset);
+  flushWrites();
+}
+
+void IoUringDiskWriter::queueWrite(const unsigned char* data, size_t len,
+                                   int64_t offset)
+{
+  if (!usesRing()) {
+    DefaultDiskWriter::writeData(data, len, offset);
+    return;
+  }
+  if (len == 0) {
+    return;
+  }
+  struct iovec iov = {const_cast<unsigned char*>(data), len};
+  if (!pending_.empty()) {
+    auto& last = pending_.back();
+    if (last.offset + static_cast<int64_t>(last.len) == offset &&
+        last.iovs.size() < MAX_MERGED_IOVS) {
+      last.iovs.push_back(iov);
+      last.len += len;
+      return;
+    }
+  }
+  pending_.push_back(WriteRequest{{iov}, offset, len, 0, -1});
+}
+
+void IoUringDiskWriter::flushWrites()
+{
+  if (pending_.empty()) {
+    return;
+  }
+  // Copying a large or merged write costs more than the kernel saves
+  // with a fixed buffer.
+  for (auto& req : pending_) {
+    if (req.iovs.size() == 1 && req.len <= DiskIoUring::BUFFER_SIZE) {
+      req.bufIndex = uring_->getBuffer();
+      if (req.bufIndex != -1) {
+        memcpy(uring_->getBufferData(req.bufIndex), req.iovs[0].iov_base,
+               req.len);
+      }
+    }
+  }
+  // The ring is gone if another writer hit an error after the writes
+  // were queued.
+  auto ring = uring_->getRing();
+  int errNum = 0;
+  size_t next = 0;
+  size_t numInflight = 0;
+  // Short writes to submit again.
+  std::vector<size_t> retries;
+  while (ring) {
+    while (errNum == 0 && numInflight < DiskIoUring::ENTRIES &&
+           (!retries.empty() || next < pending_.size())) {
+      auto index = retries.empty() ? next : retries.back();
+      // getSqe() submits the queued entries if the submission queue
+      // is full.  If it still fails, wait for the requests in flight
+      // and try again.
+      if (!submitWrite(index)) {
+        break;
+      }
+      if (retries.empty()) {
+        ++next;
+      }
+      else {
+        retries.pop_back();
+      }
+      ++numInflight;
+    }
+    if (numInflight == 0) {
+      break;
+    }
+    int rv = ring->submitAndWait(numInflight, nullptr);
+    if (rv < 0 && rv != -EAGAIN && rv != -EBUSY && rv != -EINTR) {
+      // This should not happen unless the ring is broken.  Drop it,
+      // and use normal file I/O from now on.
+      errNum = -rv;
+      uring_->shutdown();
+      break;
+    }
+    ring->reap([&](const struct io_uring_cqe& cqe) {
+      --numInflight;
+      auto index = static_cast<size_t>(cqe.user_data);
+      auto& req = pending_[index];
+      if (cqe.res <= 0) {
+        if (errNum == 0) {
+          errNum = cqe.res == 0 ? EIO : -cqe.res;
+        }
+        return;
+      }
+      req.written += cqe.res;
+      if (req.written < req.len) {
+        advanceIovs(req.iovs, cqe.res);
+        retries.push_back(index);
+      }
+    });
+  }
+  if (errNum == 0) {
+    // The ring is gone, or the submission queue stayed full although
+    // nothing was in flight.  Write the rest synchronously.
+    auto writeRest = [this](WriteRequest& req) {
+      for (auto& iov : req.iovs) {
+        DefaultDiskWriter::writeData(
+            static_cast<const unsigned char*>(iov.iov_base), iov.iov_len,
+            req.offset + req.written);
+        req.written += iov.iov_len;
+      }
+    };
+    try {
+      for (auto index : retries) {
+        writeRest(pending_[index]);
+      }
+      for (; next < pending_.size(); ++next) {
+        writeRest(pending_[next]);
+      }
+    }
+    catch (RecoverableException& e) {
+      clearPending();
+      throw;
+    }
+  }
+  clearPending();
+  if (errNum == 0) {
+    return;
+  }
+  if (errNum == ENOSPC) {
+    throw DOWNLOAD_FAILURE_EXCEPTION3(errNum,
+                                      fmt(EX_FILE_WRITE, getFilename().c_str(),
+                                          util::safeStrerror(errNum).c_str()),
+                                      error_code::NOT_ENOUGH_DISK_SPACE);
+  }
+  throw DL_ABORT_EX3(errNum,
+                     fmt(EX_FILE_WRITE, getFilename().c_str(),
+                         util::safeStrerror(errNum).c_str()),
+                     error_code::FILE_IO_ERROR);
+}
+
+void IoUringDiskWriter::clearPending()
+{
+  for (auto& req : pending_) {
+    if (req.bufIndex != -1) {
+      uring_->putBuffer(req.bufIndex);
+    }
+  }
+  pending_.clear();
+}
+
+ssize_t IoUringDiskWriter::readData(unsigned char* data, size_t len,
+                                    int64_t offset)
+{
+  if (!usesRing()) {
+    return DefaultDiskWriter::readData(data, len, offset);
+  }
+  // io_uring does not order requests in flight.  Complete pending
+  // writes first so that we read what has been written.
+  flushWrites();
+  if (!usesRing()) {
+    return DefaultDiskWriter::readData(data, len, offset);
+  }
+  auto ring = uring_->getRing();
+  // Nothing is queued after flushWrites(), so this only fails if the
+  // submission of the queued entries failed.
+  auto sqe = ring->getSqe();
+  if (!sqe) {
+    return DefaultDiskWriter::readData(data, len, offset);
+  }
+  // Data is read directly into the caller's buffer.  Staging it in a
+  // fixed buffer would only add a copy.
+  prepareSqe(sqe, IORING_OP_READ, getFd(), fileIndex_,
+             reinterpret_cast<uint64_t>(data), len, offset);
+  int res;
+  for (;;) {
+    int rv = ring->submitAndWait(1, nullptr);
+    if (rv < 0 && rv != -EAGAIN && rv != -EBUSY && rv != -EINTR) {
+      res = rv;
+      uring_->shutdown();
+      break;
+    }
+    if (ring->reap([&res](const struct io_uring_cqe& cqe) {
+          res = cqe.res;
+        }) > 0) {
+      break;
+    }
+  }
+  if (res < 0) {
+    throw DL_ABORT_EX3(-res,
+                       fmt(EX_FILE_READ, getFilename().c_str(),
+                           util::safeStrerror(-res).c_str()),
+                       error_code::FILE_IO_ERROR);
+  }
+  return res;
+}
+
+uint64_t IoUringDiskWriter::getNumEnterCalls() const
+{
+  return uring_ ? uring_->getNumEnterCalls() : 0;
+}
+
+} // namespace aria2
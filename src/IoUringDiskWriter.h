@@ -0,0 +1,121 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_IO_URING_DISK_WRITER_H
+#define D_IO_URING_DISK_WRITER_H
+
+#include "DefaultDiskWriter.h"
+
+#include <sys/uio.h>
+
+#include <memory>
+#include <vector>
+
+namespace aria2 {
+
+class DiskIoUring;
+
+// DiskWriter which performs reads and writes through io_uring.  Writes
+// queued by queueWrite() are submitted to the kernel with a single
+// io_uring_enter(2) call in flushWrites().  Contiguous writes are
+// merged into one request, and a small write which cannot be merged
+// is staged in a registered (fixed) buffer.  The ring, the buffers
+// and the file table are shared with the other writers through
+// DiskIoUring.  If io_uring is not available, or mmap is enabled, this
+// class behaves exactly like DefaultDiskWriter.
+class IoUringDiskWriter : public DefaultDiskWriter {
+public:
+  // If |uring| is nullptr, this object creates its own DiskIoUring.
+  IoUringDiskWriter(const std::string& filename,
+                    std::shared_ptr<DiskIoUring> uring = nullptr);
+
+  virtual ~IoUringDiskWriter();
+
+  virtual void initAndOpenFile(int64_t totalLength = 0) CXX11_OVERRIDE;
+
+  virtual void openExistingFile(int64_t totalLength = 0) CXX11_OVERRIDE;
+
+  virtual void closeFile() CXX11_OVERRIDE;
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         int64_t offset) CXX11_OVERRIDE;
+
+  virtual ssize_t readData(unsigned char* data, size_t len,
+                           int64_t offset) CXX11_OVERRIDE;
+
+  virtual void queueWrite(const unsigned char* data, size_t len,
+                          int64_t offset) CXX11_OVERRIDE;
+
+  virtual void flushWrites() CXX11_OVERRIDE;
+
+  // Returns true if the opened file is served by io_uring.
+  bool isIoUringActive() const { return usesRing(); }
+
+  // Returns the number of io_uring_enter(2) calls made through the
+  // ring this object uses.
+  uint64_t getNumEnterCalls() const;
+
+private:
+  struct WriteRequest {
+    std::vector<struct iovec> iovs;
+    int64_t offset;
+    size_t len;
+    // The number of bytes written so far.
+    size_t written;
+    // Index of the fixed buffer holding a copy of data, or -1.
+    int bufIndex;
+  };
+
+  void setupRing();
+
+  void teardownRing();
+
+  bool usesRing() const;
+
+  bool submitWrite(size_t index);
+
+  // Returns the fixed buffers of the queued writes, and forgets them.
+  void clearPending();
+
+  std::shared_ptr<DiskIoUring> uring_;
+  // True if the opened file is served by io_uring.
+  bool active_;
+  // Index of the opened file in the file table of uring_, or -1.
+  int fileIndex_;
+  std::vector<WriteRequest> pending_;
+};
+
+} // namespace aria2
+
+#endif // D_IO_URING_DISK_WRITER_H
@@ -0,0 +1,351 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "IoUringEventPoll.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <numeric>
+
+#include "IoUring.h"
+#include "Command.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "a2functional.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+// User data of IORING_OP_POLL_REMOVE requests.  Their completions
+// are ignored.
+constexpr uint64_t POLL_REMOVE_USER_DATA = 0;
+} // namespace
+
+namespace {
+// The kernel reads poll32_events as two 16 bit halves in the legacy
+// layout, so they have to be swapped on big endian hosts.  liburing
+// does the same in io_uring_prep_poll_add().
+uint32_t toPollMask(uint32_t events)
+{
+#ifdef WORDS_BIGENDIAN
+  return (events << 16) | (events >> 16);
+#else  // !WORDS_BIGENDIAN
+  return events;
+#endif // !WORDS_BIGENDIAN
+}
+} // namespace
+
+const size_t IoUringEventPoll::IO_URING_ENTRIES;
+
+IoUringEventPoll::KSocketEntry::KSocketEntry(sock_t s)
+    : SocketEntry<KCommandEvent, KADNSEvent>(s)
+{
+}
+
+int accumulateEvent(int events, const IoUringEventPoll::KEvent& event)
+{
+  return events | event.getEvents();
+}
+
+int IoUringEventPoll::KSocketEntry::getEvents()
+{
+#ifdef ENABLE_ASYNC_DNS
+
+  return std::accumulate(adnsEvents_.begin(), adnsEvents_.end(),
+                         std::accumulate(commandEvents_.begin(),
+                                         commandEvents_.end(), 0,
+                                         accumulateEvent),
+                         accumulateEvent);
+
+#else // !ENABLE_ASYNC_DNS
+
+  return std::accumulate(commandEvents_.begin(), commandEvents_.end(), 0,
+                         accumulateEvent);
+
+#endif // !ENABLE_ASYNC_DNS
+}
+
+IoUringEventPoll::IoUringEventPoll()
+    : ring_(make_unique<IoUring>(IO_URING_ENTRIES, IO_URING_ENTRIES * 4)),
+      // Start from 1 so that user data never becomes
+      // POLL_REMOVE_USER_DATA.
+      nextSerial_(1)
+{
+  if (ring_->good() && !(ring_->getFeatures() & IORING_FEAT_EXT_ARG)) {
+    A2_LOG_INFO("io_uring does not support IORING_FEAT_EXT_ARG.");
+    ring_.reset();
+  }
+}
+
+IoUringEventPoll::~IoUringEventPoll() = default;
+
+bool IoUringEventPoll::good() const { return ring_ && ring_->good(); }
+
+uint64_t IoUringEventPoll::getNumSyscalls() const
+{
+  return ring_ ? ring_->getNumEnterCalls() : 0;
+}
+
+void IoUringEventPoll::cancelPoll(sock_t socket)
+{
+  auto i = armedPolls_.find(socket);
+  if (i == std::end(armedPolls_)) {
+    return;
+  }
+  auto sqe = ring_->getSqe();
+  if (sqe) {
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (*i).second.userData;
+    sqe->user_data = POLL_REMOVE_USER_DATA;
+  }
+  armedPolls_.erase(i);
+}
+
+void IoUringEventPoll::updatePolls()
+{
+  for (auto socket : dirtySockets_) {
+    auto i = socketEntries_.find(socket);
+    int events = i == std::end(socketEntries_) ? 0 : (*i).second.getEvents();
+    auto a = armedPolls_.find(socket);
+    if (a != std::end(armedPolls_)) {
+      if ((*a).second.events == events) {
+        continue;
+      }
+      cancelPoll(socket);
+    }
+    if (events == 0) {
+      continue;
+    }
+    auto sqe = ring_->getSqe();
+    if (!sqe) {
+      A2_LOG_DEBUG(fmt("Failed to get io_uring SQE for socket %d", socket));
+      continue;
+    }
+    auto userData = (static_cast<uint64_t>(nextSerial_++) << 32) |
+                    static_cast<uint32_t>(socket);
+    if (nextSerial_ == 0) {
+      nextSerial_ = 1;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = socket;
+    sqe->poll32_events = toPollMask(events);
+    sqe->user_data = userData;
+    armedPolls_.insert(std::make_pair(socket, ArmedPoll{events, userData}));
+  }
+  dirtySockets_.clear();
+}
+
+void IoUringEventPoll::poll(const struct timeval& tv)
+{
+  updatePolls();
+
+  struct timespec ts;
+  ts.tv_sec = tv.tv_sec;
+  ts.tv_nsec = tv.tv_usec * 1000;
+
+  int rv = ring_->submitAndWait(1, &ts);
+  if (rv < 0) {
+    A2_LOG_INFO(fmt("io_uring_enter error: %s",
+                    util::safeStrerror(-rv).c_str()));
+  }
+
+  ring_->reap([this](const struct io_uring_cqe& cqe) {
+    if (cqe.user_data == POLL_REMOVE_USER_DATA) {
+      return;
+    }
+    auto socket = static_cast<sock_t>(cqe.user_data & 0xffffffffu);
+    auto a = armedPolls_.find(socket);
+    if (a == std::end(armedPolls_) || (*a).second.userData != cqe.user_data) {
+      // Stale completion of the canceled request.
+      return;
+    }
+    armedPolls_.erase(a);
+    if (cqe.res < 0) {
+      if (cqe.res != -ECANCELED) {
+        A2_LOG_DEBUG(fmt("Poll request for socket %d failed: %s", socket,
+                         util::safeStrerror(-cqe.res).c_str()));
+      }
+      return;
+    }
+    auto i = socketEntries_.find(socket);
+    if (i != std::end(socketEntries_)) {
+      (*i).second.processEvents(cqe.res);
+      // Re-arm in the next poll() call.
+      dirtySockets_.insert(socket);
+    }
+  });
+
+#ifdef ENABLE_ASYNC_DNS
+  // It turns out that we have to call ares_process_fd before ares's
+  // own timeout and ares may create new sockets or closes socket in
+  // their API. So we call ares_process_fd for all ares_channel and
+  // re-register their sockets.
+  for (auto& i : nameResolverEntries_) {
+    auto& ent = i.second;
+    ent.processTimeout();
+    ent.removeSocketEvents(this);
+    ent.addSocketEvents(this);
+  }
+#endif // ENABLE_ASYNC_DNS
+
+  // TODO timeout of name resolver is determined in Command(AbstractCommand,
+  // DHTEntryPoint...Command)
+}
+
+namespace {
+int translateEvents(EventPoll::EventType events)
+{
+  int newEvents = 0;
+  if (EventPoll::EVENT_READ & events) {
+    newEvents |= POLLIN;
+  }
+  if (EventPoll::EVENT_WRITE & events) {
+    newEvents |= POLLOUT;
+  }
+  if (EventPoll::EVENT_ERROR & events) {
+    newEvents |= POLLERR;
+  }
+  if (EventPoll::EVENT_HUP & events) {
+    newEvents |= POLLHUP;
+  }
+  return newEvents;
+}
+} // namespace
+
+bool IoUringEventPoll::addEvents(sock_t socket,
+                                 const IoUringEventPoll::KEvent& event)
+{
+  auto i = socketEntries_.lower_bound(socket);
+  if (i == std::end(socketEntries_) || (*i).first != socket) {
+    i = socketEntries_.insert(i, std::make_pair(socket, KSocketEntry(socket)));
+  }
+  event.addSelf(&(*i).second);
+  dirtySockets_.insert(socket);
+  return true;
+}
+
+bool IoUringEventPoll::addEvents(sock_t socket, Command* command,
+                                 EventPoll::EventType events)
+{
+  int pollEvents = translateEvents(events);
+  return addEvents(socket, KCommandEvent(command, pollEvents));
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::addEvents(sock_t socket, Command* command, int events,
+                                 const std::shared_ptr<AsyncNameResolver>& rs)
+{
+  return addEvents(socket, KADNSEvent(rs, command, socket, events));
+}
+#endif // ENABLE_ASYNC_DNS
+
+bool IoUringEventPoll::deleteEvents(sock_t socket,
+                                    const IoUringEventPoll::KEvent& event)
+{
+  auto i = socketEntries_.find(socket);
+  if (i == std::end(socketEntries_)) {
+    A2_LOG_DEBUG(fmt("Socket %d is not found in SocketEntries.", socket));
+    return false;
+  }
+
+  auto& socketEntry = (*i).second;
+  event.removeSelf(&socketEntry);
+  if (socketEntry.eventEmpty()) {
+    socketEntries_.erase(i);
+    // The socket may be closed and its descriptor reused before the
+    // next poll() call.  Since the poll request holds a reference to
+    // the old file, cancel it now rather than comparing events later.
+    cancelPoll(socket);
+    dirtySockets_.erase(socket);
+  }
+  else {
+    dirtySockets_.insert(socket);
+  }
+  return true;
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::deleteEvents(
+    sock_t socket, Command* command,
+    const std::shared_ptr<AsyncNameResolver>& rs)
+{
+  return deleteEvents(socket, KADNSEvent(rs, command, socket, 0));
+}
+#endif // ENABLE_ASYNC_DNS
+
+bool IoUringEventPoll::deleteEvents(sock_t socket, Command* command,
+                                    EventPoll::EventType events)
+{
+  int pollEvents = translateEvents(events);
+  return deleteEvents(socket, KCommandEvent(command, pollEvents));
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::addNameResolver(
+    const std::shared_ptr<AsyncNameResolver>& resolver, Command* command)
+{
+  auto key = std::make_pair(resolver.get(), command);
+  auto itr = nameResolverEntries_.lower_bound(key);
+
+  if (itr != std::end(nameResolverEntries_) && (*itr).first == key) {
+    return false;
+  }
+
+  itr = nameResolverEntries_.insert(
+      itr, std::make_pair(key, KAsyncNameResolverEntry(resolver, command)));
+  (*itr).second.addSocketEvents(this);
+  return true;
+}
+
+bool IoUringEventPoll::deleteNameResolver(
+    const std::shared_ptr<AsyncNameResolver>& resolver, Command* command)
+{
+  auto key = std::make_pair(resolver.get(), command);
+  auto itr = nameResolverEntries_.find(key);
+  if (itr == std::end(nameResolverEntries_)) {
+    return false;
+  }
+
+  (*itr).second.removeSocketEvents(this);
+  nameResolverEntries_.erase(itr);
+  return true;
+}
+#endif // ENABLE_ASYNC_DNS
+
+} // namespace aria2
@@ -49,11 +49,109 @@
 #include "LogFactory.h"
 #include "Logger.h"
 #include "MessageDigest.h"
+#include "MessageDigestBatch.h"
 #include "fmt.h"
 #include "DlAbortEx.h"
+#include "WorkerPool.h"
+#include "message_digest_helper.h"
+#include "a2io.h"
 
 namespace aria2 {
 
+namespace {
+// The maximum number of pieces per worker thread which are submitted
+// at once.  Keeping more than one piece per thread lets the reads of
+// the next pieces proceed while the current ones are hashed.
+constexpr size_t JOBS_PER_THREAD = 2;
+} // namespace
+
+// Hashes a piece in a worker thread.  If fd is -1, the piece could
+// not be read from a worker thread and has been hashed in the main
+// thread before the job was queued.
+struct IteratableChunkChecksumValidator::HashJob {
+  size_t index;
+  int fd;
+  int64_t offset;
+  size_t length;
+  std::unique_ptr<MessageDigest> ctx;
+  std::string digest;
+  // The errno of a failed read.  -1 if the file is too short.
+  int errNum;
+  bool done;
+  // True if the validator has been destroyed while the job is
+  // running.  The completion must not touch the validator then.
+  bool cancelled;
+
+  HashJob(size_t index, int fd, int64_t offset, size_t length)
+      : index(index),
+        fd(fd),
+        offset(offset),
+        length(length),
+        errNum(0),
+        done(false),
+        cancelled(false)
+  {
+  }
+
+  ~HashJob()
+  {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+
+  void run()
+  {
+#ifdef HAVE_POSIX_FADVISE
+    posix_fadvise(fd, offset, length, POSIX_FADV_WILLNEED);
+#endif // HAVE_POSIX_FADVISE
+    errNum = message_digest::update(ctx.get(), fd, offset, length);
+#ifdef HAVE_POSIX_FADVISE
+    posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+#endif // HAVE_POSIX_FADVISE
+    if (errNum == 0) {
+      digest = ctx->digest();
+    }
+  }
+};
+
+// Hashes pieces of the same length together in a worker thread.
+struct IteratableChunkChecksumValidator::HashBatch {
+  std::vector<std::shared_ptr<HashJob>> jobs;
+  std::string hashType;
+  std::unique_ptr<MessageDigestBatch> ctx;
+
+  void run()
+  {
+    std::vector<int> fds;
+    std::vector<int64_t> offsets;
+    for (auto& job : jobs) {
+      fds.push_back(job->fd);
+      offsets.push_back(job->offset);
+#ifdef HAVE_POSIX_FADVISE
+      posix_fadvise(job->fd, job->offset, job->length, POSIX_FADV_WILLNEED);
+#endif // HAVE_POSIX_FADVISE
+    }
+    if (message_digest::update(ctx.get(), fds.data(), offsets.data(),
+                               jobs[0]->length) != 0) {
+      // Hash them one by one, so that each piece gets its own result.
+      for (auto& job : jobs) {
+        job->ctx = MessageDigest::create(hashType);
+        job->run();
+      }
+      return;
+    }
+    auto digests = ctx->digest();
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      jobs[i]->digest = std::move(digests[i]);
+#ifdef HAVE_POSIX_FADVISE
+      posix_fadvise(jobs[i]->fd, jobs[i]->offset, jobs[i]->length,
+                    POSIX_FADV_DONTNEED);
+#endif // HAVE_POSIX_FADVISE
+    }
+  }
+};
+
 IteratableChunkChecksumValidator::IteratableChunkChecksumValidator(
     const std::shared_ptr<DownloadContext>& dctx,
     const std::shared_ptr<PieceStorage>& pieceStorage)
@@ -61,30 +159,33 @@ IteratableChunkChecksumValidator::IteratableChunkChecksumValidator(
       pieceStorage_(pieceStorage),
       bitfield_(make_unique<BitfieldMan>(dctx_->getPieceLength(),
                                          dctx_->getTotalLength())),
-      currentIndex_(0)
+      currentIndex_(0),
+      workerPool_(nullptr),
+      nextIndex_(0),
+      numRunning_(0),
+      lanes_(1)
 {
 }
 
-IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator() = default;
+IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator()
+{
+  for (auto& job : jobs_) {
+    job->cancelled = true;
+  }
+}
 
 void IteratableChunkChecksumValidator::validateChunk()
 {
   if (!finished()) {
+#if defined(HAVE_PWRITE) && !defined(__MINGW32__)
+    if (workerPool_ && workerPool_->getNumThreads() > 0) {
+      validateChunksInWorker();
+      return;
+    }
+#endif // HAVE_PWRITE && !__MINGW32__
     std::string actualChecksum;
     try {
       actualChecksum = calculateActualChecksum();
-      if (actualChecksum == dctx_->getPieceHashes()[currentIndex_]) {
-        bitfield_->setBit(currentIndex_);
-      }
-      else {
-        A2_LOG_INFO(
-            fmt(EX_INVALID_CHUNK_CHECKSUM,
-                static_cast<unsigned long>(currentIndex_),
-                static_cast<int64_t>(getCurrentOffset()),
-                util::toHex(dctx_->getPieceHashes()[currentIndex_]).c_str(),
-                util::toHex(actualChecksum).c_str()));
-        bitfield_->unsetBit(currentIndex_);
-      }
     }
     catch (RecoverableException& ex) {
       A2_LOG_DEBUG_EX(fmt("Caught exception while validating piece index=%lu."
@@ -92,8 +193,8 @@ void IteratableChunkChecksumValidator::validateChunk()
                           " Continue operation.",
                           static_cast<unsigned long>(currentIndex_)),
                       ex);
-      bitfield_->unsetBit(currentIndex_);
     }
+    updateBitfield(currentIndex_, actualChecksum);
 
     ++currentIndex_;
     if (finished()) {
@@ -103,25 +204,192 @@ void IteratableChunkChecksumValidator::validateChunk()
   }
 }
 
+void IteratableChunkChecksumValidator::updateBitfield(
+    size_t index, const std::string& actualChecksum)
+{
+  if (actualChecksum.empty()) {
+    // The piece could not be read.
+    bitfield_->unsetBit(index);
+  }
+  else if (actualChecksum == dctx_->getPieceHashes()[index]) {
+    bitfield_->setBit(index);
+  }
+  else {
+    A2_LOG_INFO(fmt(EX_INVALID_CHUNK_CHECKSUM, static_cast<unsigned long>(index),
+                    static_cast<int64_t>(index) * dctx_->getPieceLength(),
+                    util::toHex(dctx_->getPieceHashes()[index]).c_str(),
+                    util::toHex(actualChecksum).c_str()));
+    bitfield_->unsetBit(index);
+  }
+}
+
+void IteratableChunkChecksumValidator::validateChunksInWorker()
+{
+  while (!jobs_.empty() && jobs_.front()->done) {
+    auto& job = *jobs_.front();
+    if (job.errNum != 0) {
+      A2_LOG_DEBUG(fmt("Reading piece index=%lu failed: %s. Some part of"
+                       " file may be missing. Continue operation.",
+                       static_cast<unsigned long>(job.index),
+                       job.errNum == -1
+                           ? "data is too short"
+                           : util::safeStrerror(job.errNum).c_str()));
+    }
+    updateBitfield(job.index, job.digest);
+    jobs_.pop_front();
+    ++currentIndex_;
+  }
+  auto maxJobs = workerPool_->getNumThreads() * JOBS_PER_THREAD * lanes_;
+  while (nextIndex_ < dctx_->getNumPieces() && jobs_.size() < maxJobs) {
+    if (!submitJobs()) {
+      // Hashed in this thread.  Do not block the event loop for more
+      // than one piece per call.
+      break;
+    }
+  }
+  if (finished()) {
+    pieceStorage_->setBitfield(bitfield_->getBitfield(),
+                               bitfield_->getBitfieldLength());
+  }
+}
+
+bool IteratableChunkChecksumValidator::submitJobs()
+{
+  std::vector<std::shared_ptr<HashJob>> batch;
+  // The last piece is usually shorter than the others, so it never
+  // joins a batch.
+  if (lanes_ > 1 && nextIndex_ + lanes_ < dctx_->getNumPieces()) {
+    for (size_t i = 0; i < lanes_; ++i) {
+      auto job = createJob(nextIndex_ + i);
+      if (job->fd == -1) {
+        break;
+      }
+      batch.push_back(std::move(job));
+    }
+  }
+  if (batch.size() == lanes_) {
+    nextIndex_ += lanes_;
+    submitBatch(std::move(batch));
+    return true;
+  }
+  if (!batch.empty()) {
+    // Some piece cannot be read in a worker thread.  Hash the ones
+    // before it one by one.
+    nextIndex_ += batch.size();
+    for (auto& job : batch) {
+      submitJob(job);
+    }
+    return true;
+  }
+  auto job = createJob(nextIndex_++);
+  submitJob(job);
+  return job->fd != -1;
+}
+
+std::shared_ptr<IteratableChunkChecksumValidator::HashJob>
+IteratableChunkChecksumValidator::createJob(size_t index)
+{
+  int64_t offset = static_cast<int64_t>(index) * dctx_->getPieceLength();
+  size_t length = getPieceLength(index);
+  int64_t fileOffset = 0;
+  int fd = -1;
+  try {
+    fd = pieceStorage_->getDiskAdaptor()->dupReadFd(offset, length,
+                                                    fileOffset);
+  }
+  catch (RecoverableException& ex) {
+    // Let digest() report the error.
+  }
+  return std::make_shared<HashJob>(index, fd, fileOffset, length);
+}
+
+void IteratableChunkChecksumValidator::submitJob(
+    const std::shared_ptr<HashJob>& job)
+{
+  jobs_.push_back(job);
+  if (job->fd == -1) {
+    // The piece spans multiple files, or the file is not open.
+    try {
+      job->digest = digest(static_cast<int64_t>(job->index) *
+                               dctx_->getPieceLength(),
+                           job->length);
+    }
+    catch (RecoverableException& ex) {
+      A2_LOG_DEBUG_EX(fmt("Caught exception while validating piece index=%lu."
+                          " Some part of file may be missing."
+                          " Continue operation.",
+                          static_cast<unsigned long>(job->index)),
+                      ex);
+    }
+    job->done = true;
+    return;
+  }
+  job->ctx = MessageDigest::create(dctx_->getPieceHashType());
+  ++numRunning_;
+  workerPool_->submit([job]() { job->run(); },
+                      [this, job]() {
+                        if (job->cancelled) {
+                          return;
+                        }
+                        --numRunning_;
+                        job->done = true;
+                        if (wakeup_ && (job == jobs_.front() ||
+                                        numRunning_ == 0)) {
+                          wakeup_();
+                        }
+                      });
+}
+
+void IteratableChunkChecksumValidator::submitBatch(
+    std::vector<std::shared_ptr<HashJob>> jobs)
+{
+  auto batch = std::make_shared<HashBatch>();
+  batch->jobs = std::move(jobs);
+  batch->hashType = dctx_->getPieceHashType();
+  batch->ctx = MessageDigestBatch::create(batch->hashType, batch->jobs.size());
+  jobs_.insert(std::end(jobs_), std::begin(batch->jobs),
+               std::end(batch->jobs));
+  ++numRunning_;
+  workerPool_->submit([batch]() { batch->run(); },
+                      [this, batch]() {
+                        if (batch->jobs.front()->cancelled) {
+                          return;
+                        }
+                        --numRunning_;
+                        for (auto& job : batch->jobs) {
+                          job->done = true;
+                        }
+                        if (wakeup_ && (batch->jobs.front() == jobs_.front() ||
+                                        numRunning_ == 0)) {
+                          wakeup_();
+                        }
+                      });
+}
+
 std::string IteratableChunkChecksumValidator::calculateActualChecksum()
 {
-  int64_t offset = getCurrentOffset();
-  size_t length;
+  return digest(getCurrentOffset(), getPieceLength(currentIndex_));
+}
+
+size_t IteratableChunkChecksumValidator::getPieceLength(size_t index) const
+{
   // When validating last piece
-  if (currentIndex_ + 1 == dctx_->getNumPieces()) {
-    length = dctx_->getTotalLength() - offset;
+  if (index + 1 == dctx_->getNumPieces()) {
+    return dctx_->getTotalLength() -
+           static_cast<int64_t>(index) * dctx_->getPieceLength();
   }
   else {
-    length = dctx_->getPieceLength();
+    return dctx_->getPieceLength();
   }
-  return digest(offset, length);
 }
 
 void IteratableChunkChecksumValidator::init()
 {
   ctx_ = MessageDigest::create(dctx_->getPieceHashType());
+  lanes_ = MessageDigestBatch::getLanes(dctx_->getPieceHashType());
   bitfield_->clearAllBit();
   currentIndex_ = 0;
+  nextIndex_ = 0;
 }
 
 std::string IteratableChunkChecksumValidator::digest(int64_t offset,
@@ -164,4 +432,21 @@ int64_t IteratableChunkChecksumValidator::getTotalLength() const
   return dctx_->getTotalLength();
 }
 
+void IteratableChunkChecksumValidator::setWorkerPool(
+    WorkerPool* workerPool, std::function<void()> wakeup)
+{
+  workerPool_ = workerPool;
+  wakeup_ = std::move(wakeup);
+}
+
+bool IteratableChunkChecksumValidator::isWaiting() const
+{
+  return !jobs_.empty() && !jobs_.front()->done;
+}
+
+bool IteratableChunkChecksumValidator::hasPendingJobs() const
+{
+  return numRunning_ > 0;
+}
+
 } // namespace aria2
@@ -39,6 +39,8 @@
 
 #include <string>
 #include <memory>
+#include <deque>
+#include <vector>
 
 namespace aria2 {
 
@@ -55,10 +57,41 @@ private:
   size_t currentIndex_;
   std::unique_ptr<MessageDigest> ctx_;
 
+  struct HashJob;
+  struct HashBatch;
+
+  WorkerPool* workerPool_;
+  std::function<void()> wakeup_;
+  // Pieces being hashed, in the order of index.  The results are
+  // applied to bitfield_ from the front, so that currentIndex_ always
+  // advances in order.
+  std::deque<std::shared_ptr<HashJob>> jobs_;
+  // The index of the next piece to submit.
+  size_t nextIndex_;
+  // The number of jobs running in worker threads.
+  size_t numRunning_;
+  // The number of pieces hashed together by one job.  See
+  // MessageDigestBatch::getLanes().
+  size_t lanes_;
+
   std::string calculateActualChecksum();
 
   std::string digest(int64_t offset, size_t length);
 
+  size_t getPieceLength(size_t index) const;
+
+  void updateBitfield(size_t index, const std::string& actualChecksum);
+
+  void validateChunksInWorker();
+
+  std::shared_ptr<HashJob> createJob(size_t index);
+
+  bool submitJobs();
+
+  void submitJob(const std::shared_ptr<HashJob>& job);
+
+  void submitBatch(std::vector<std::shared_ptr<HashJob>> jobs);
+
 public:
   IteratableChunkChecksumValidator(
       const std::shared_ptr<DownloadContext>& dctx,
@@ -75,6 +108,13 @@ public:
   virtual int64_t getCurrentOffset() const CXX11_OVERRIDE;
 
   virtual int64_t getTotalLength() const CXX11_OVERRIDE;
+
+  virtual void setWorkerPool(WorkerPool* workerPool,
+                             std::function<void()> wakeup) CXX11_OVERRIDE;
+
+  virtual bool isWaiting() const CXX11_OVERRIDE;
+
+  virtual bool hasPendingJobs() const CXX11_OVERRIDE;
 };
 
 } // namespace aria2
@@ -39,8 +39,12 @@
 
 #include <unistd.h>
 
+#include <functional>
+
 namespace aria2 {
 
+class WorkerPool;
+
 /**
  * This class provides the interface to validate files.
  *
@@ -62,6 +66,23 @@ public:
   virtual int64_t getCurrentOffset() const = 0;
 
   virtual int64_t getTotalLength() const = 0;
+
+  // Lets the validator hash chunks in the worker threads of
+  // workerPool.  wakeup is called in the main thread when a chunk
+  // hashed in a worker thread is ready to be consumed by
+  // validateChunk().  The default implementation does nothing.
+  virtual void setWorkerPool(WorkerPool* workerPool,
+                             std::function<void()> wakeup)
+  {
+  }
+
+  // Returns true if validateChunk() cannot make progress until wakeup
+  // is called.
+  virtual bool isWaiting() const { return false; }
+
+  // Returns true if a chunk is being hashed in a worker thread.  The
+  // validator must not be destroyed while this function returns true.
+  virtual bool hasPendingJobs() const { return false; }
 };
 
 } // namespace aria2
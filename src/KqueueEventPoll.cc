@@ -112,11 +112,10 @@ bool KqueueEventPoll::good() const { return kqfd_ != -1; }
 void KqueueEventPoll::poll(const struct timeval& tv)
 {
   struct timespec timeout = {tv.tv_sec, tv.tv_usec * 1000};
-  int res;
-  while ((res = kevent(kqfd_, kqEvents_.get(), 0, kqEvents_.get(),
-                       kqEventsSize_, &timeout)) == -1 &&
-         errno == EINTR)
-    ;
+  // Do not retry on EINTR, so that DownloadEngine notices the signal
+  // without waiting for the timeout.
+  int res = kevent(kqfd_, kqEvents_.get(), 0, kqEvents_.get(), kqEventsSize_,
+                   &timeout);
   if (res > 0) {
     for (int i = 0; i < res; ++i) {
       KSocketEntry* p = reinterpret_cast<KSocketEntry*>(kqEvents_[i].udata);
@@ -131,7 +130,7 @@ void KqueueEventPoll::poll(const struct timeval& tv)
       p->processEvents(events);
     }
   }
-  else if (res == -1) {
+  else if (res == -1 && errno != EINTR) {
     int errNum = errno;
     A2_LOG_INFO(fmt("kevent error: %s", util::safeStrerror(errNum).c_str()));
   }
@@ -55,6 +55,10 @@ TLSVersion getProtocolFromSession(gnutls_session_t& session)
     return TLS_PROTO_TLS11;
   case GNUTLS_TLS1_2:
     return TLS_PROTO_TLS12;
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  case GNUTLS_TLS1_3:
+    return TLS_PROTO_TLS13;
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
   default:
     return TLS_PROTO_NONE;
   }
@@ -159,6 +163,7 @@ int GnuTLSSession::init(sock_t sockfd)
   // or later
   gnutls_transport_set_ptr(sslSession_,
                            (gnutls_transport_ptr_t)(ptrdiff_t)sockfd);
+  gnutls_session_set_ptr(sslSession_, this);
   return TLS_ERR_OK;
 }
 
@@ -173,6 +178,100 @@ int GnuTLSSession::setSNIHostname(const std::string& hostname)
   return TLS_ERR_OK;
 }
 
+int GnuTLSSession::setAlpnProtocols(const std::vector<std::string>& protocols)
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030200
+  std::vector<gnutls_datum_t> data;
+  for (auto& proto : protocols) {
+    gnutls_datum_t d;
+    d.data = reinterpret_cast<unsigned char*>(const_cast<char*>(proto.c_str()));
+    d.size = proto.size();
+    data.push_back(d);
+  }
+  rv_ = gnutls_alpn_set_protocols(sslSession_, data.data(), data.size(), 0);
+  if (rv_ != GNUTLS_E_SUCCESS) {
+    return TLS_ERR_ERROR;
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030200
+  return TLS_ERR_OK;
+}
+
+std::string GnuTLSSession::getAlpnProtocol()
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030200
+  gnutls_datum_t d;
+  if (gnutls_alpn_get_selected_protocol(sslSession_, &d) ==
+      GNUTLS_E_SUCCESS) {
+    return std::string(d.data, d.data + d.size);
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030200
+  return A2STR::NIL;
+}
+
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+namespace {
+// With TLS 1.3, session ticket arrives after handshake, and the
+// session data is only usable for resumption after that.
+int sessionTicketHook(gnutls_session_t session, unsigned int htype,
+                      unsigned when, unsigned int incoming,
+                      const gnutls_datum_t* msg)
+{
+  if (incoming) {
+    static_cast<GnuTLSSession*>(gnutls_session_get_ptr(session))
+        ->storeSession();
+  }
+  return 0;
+}
+} // namespace
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
+
+int GnuTLSSession::setSessionCacheKey(const std::string& key)
+{
+  sessionCacheKey_ = key;
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  gnutls_handshake_set_hook_function(sslSession_,
+                                     GNUTLS_HANDSHAKE_NEW_SESSION_TICKET,
+                                     GNUTLS_HOOK_POST, sessionTicketHook);
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
+  auto cache = tlsContext_->getSessionCache();
+  auto data = cache->take(key);
+  if (data.empty()) {
+    return TLS_ERR_OK;
+  }
+  rv_ = gnutls_session_set_data(sslSession_, data.data(), data.size());
+  if (rv_ != GNUTLS_E_SUCCESS) {
+    // Just do full handshake.
+    cache->remove(key);
+  }
+  return TLS_ERR_OK;
+}
+
+bool GnuTLSSession::isSessionResumed()
+{
+  return gnutls_session_is_resumed(sslSession_) != 0;
+}
+
+void GnuTLSSession::storeSession()
+{
+  if (sessionCacheKey_.empty()) {
+    return;
+  }
+  gnutls_datum_t data;
+  if (gnutls_session_get_data2(sslSession_, &data) != GNUTLS_E_SUCCESS) {
+    return;
+  }
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  // TLS 1.3 tickets are for one connection only.
+  bool reusable = gnutls_protocol_get_version(sslSession_) != GNUTLS_TLS1_3;
+#else  // GNUTLS_VERSION_NUMBER >= 0x030603
+  bool reusable = true;
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
+  tlsContext_->getSessionCache()->put(
+      sessionCacheKey_, std::string(data.data, data.data + data.size),
+      reusable);
+  gnutls_free(data.data);
+}
+
 int GnuTLSSession::closeConnection()
 {
   rv_ = gnutls_bye(sslSession_, GNUTLS_SHUT_WR);
@@ -354,6 +453,12 @@ int GnuTLSSession::tlsConnect(const std::string& hostname, TLSVersion& version,
 
   version = getProtocolFromSession(sslSession_);
 
+  // TLS 1.3 session is stored by sessionTicketHook when the ticket
+  // arrives.
+  if (version != TLS_PROTO_TLS13) {
+    storeSession();
+  }
+
   return TLS_ERR_OK;
 }
 
@@ -51,6 +51,11 @@ public:
   ~GnuTLSSession();
   virtual int init(sock_t sockfd) CXX11_OVERRIDE;
   virtual int setSNIHostname(const std::string& hostname) CXX11_OVERRIDE;
+  virtual int
+  setAlpnProtocols(const std::vector<std::string>& protocols) CXX11_OVERRIDE;
+  virtual std::string getAlpnProtocol() CXX11_OVERRIDE;
+  virtual int setSessionCacheKey(const std::string& key) CXX11_OVERRIDE;
+  virtual bool isSessionResumed() CXX11_OVERRIDE;
   virtual int closeConnection() CXX11_OVERRIDE;
   virtual int checkDirection() CXX11_OVERRIDE;
   virtual ssize_t writeData(const void* data, size_t len) CXX11_OVERRIDE;
@@ -61,9 +66,13 @@ public:
   virtual std::string getLastErrorString() CXX11_OVERRIDE;
   virtual size_t getRecvBufferedLength() CXX11_OVERRIDE { return 0; }
 
+  // Stores the current session to the session cache of the context.
+  void storeSession();
+
 private:
   gnutls_session_t sslSession_;
   GnuTLSContext* tlsContext_;
+  std::string sessionCacheKey_;
   // Last error code from gnutls library functions
   int rv_;
 };
@@ -45,6 +45,8 @@
 #include "fmt.h"
 #include "message.h"
 #include "BufferedFile.h"
+#include "LibsslTLSSession.h"
+#include "libssl_compat.h"
 
 namespace {
 struct bio_deleter {
@@ -91,6 +93,18 @@ typedef std::unique_ptr<STACK_OF(X509), x509_sk_deleter> x509_sk_t;
 
 namespace aria2 {
 
+namespace {
+int newSessionCallback(SSL* ssl, SSL_SESSION* sess)
+{
+  auto tlsSession = static_cast<OpenSSLTLSSession*>(SSL_get_app_data(ssl));
+  if (tlsSession) {
+    tlsSession->storeSession(sess);
+  }
+  // We do not keep the reference to |sess|.
+  return 0;
+}
+} // namespace
+
 TLSContext* TLSContext::make(TLSSessionSide side, TLSVersion minVer)
 {
   return new OpenSSLTLSContext(side, minVer);
@@ -158,12 +172,34 @@ OpenSSLTLSContext::OpenSSLTLSContext(TLSSessionSide side, TLSVersion minVer)
   }
 #  endif // OPENSSL_NO_ECDH
 #endif   // OPENSSL_VERSION_NUMBER >= 0x0090800fL
+
+  if (side_ == TLS_CLIENT) {
+    // OpenSSL never looks up its internal cache on client side.  The
+    // new sessions, including TLS 1.3 tickets received after
+    // handshake, are handed to sessionCache_ which is keyed by host
+    // and port.
+    SSL_CTX_set_session_cache_mode(sslCtx_, SSL_SESS_CACHE_CLIENT |
+                                                SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(sslCtx_, newSessionCallback);
+  }
 }
 
 OpenSSLTLSContext::~OpenSSLTLSContext() { SSL_CTX_free(sslCtx_); }
 
 bool OpenSSLTLSContext::good() const { return good_; }
 
+bool OpenSSLTLSContext::enableKernelTLS()
+{
+#if OPENSSL_KTLS_API
+  // OpenSSL silently keeps encrypting in user space if the kernel
+  // lacks TLS ULP or the negotiated cipher is not supported by it.
+  SSL_CTX_set_options(sslCtx_, SSL_OP_ENABLE_KTLS);
+  return true;
+#else  // !OPENSSL_KTLS_API
+  return false;
+#endif // !OPENSSL_KTLS_API
+}
+
 bool OpenSSLTLSContext::addCredentialFile(const std::string& certfile,
                                           const std::string& keyfile)
 {
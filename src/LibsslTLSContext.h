@@ -42,6 +42,7 @@
 #include <openssl/ssl.h>
 
 #include "TLSContext.h"
+#include "TLSSessionCache.h"
 #include "DlAbortEx.h"
 
 namespace aria2 {
@@ -72,10 +73,18 @@ public:
     verifyPeer_ = verify;
   }
 
+  virtual TLSSessionCache* getSessionCache() CXX11_OVERRIDE
+  {
+    return &sessionCache_;
+  }
+
+  virtual bool enableKernelTLS() CXX11_OVERRIDE;
+
   SSL_CTX* getSSLCtx() const { return sslCtx_; }
 
 private:
   SSL_CTX* sslCtx_;
+  TLSSessionCache sessionCache_;
   TLSSessionSide side_;
   bool good_;
   bool verifyPeer_;
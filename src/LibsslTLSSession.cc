@@ -39,7 +39,9 @@
 #include <openssl/x509v3.h>
 
 #include "LogFactory.h"
+#include "Logger.h"
 #include "util.h"
+#include "fmt.h"
 #include "SocketCore.h"
 
 namespace aria2 {
@@ -81,6 +83,8 @@ int OpenSSLTLSSession::init(sock_t sockfd)
   if (rv_ == 0) {
     return TLS_ERR_ERROR;
   }
+  // Used by the new session callback of OpenSSLTLSContext.
+  SSL_set_app_data(ssl_, this);
   return TLS_ERR_OK;
 }
 
@@ -96,6 +100,92 @@ int OpenSSLTLSSession::setSNIHostname(const std::string& hostname)
   return TLS_ERR_OK;
 }
 
+int OpenSSLTLSSession::setAlpnProtocols(
+    const std::vector<std::string>& protocols)
+{
+#if !LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x10002000L
+  std::string wire;
+  for (auto& proto : protocols) {
+    wire += static_cast<char>(proto.size());
+    wire += proto;
+  }
+  ERR_clear_error();
+  // Unlike the most of OpenSSL functions, this returns 0 on success.
+  if (SSL_set_alpn_protos(ssl_,
+                          reinterpret_cast<const unsigned char*>(wire.c_str()),
+                          wire.size()) != 0) {
+    return TLS_ERR_ERROR;
+  }
+#endif // !LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x10002000L
+  return TLS_ERR_OK;
+}
+
+std::string OpenSSLTLSSession::getAlpnProtocol()
+{
+#if !LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x10002000L
+  const unsigned char* data;
+  unsigned int len;
+  SSL_get0_alpn_selected(ssl_, &data, &len);
+  if (data) {
+    return std::string(data, data + len);
+  }
+#endif // !LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x10002000L
+  return A2STR::NIL;
+}
+
+int OpenSSLTLSSession::setSessionCacheKey(const std::string& key)
+{
+  sessionCacheKey_ = key;
+  auto cache = tlsContext_->getSessionCache();
+  auto data = cache->take(key);
+  if (data.empty()) {
+    return TLS_ERR_OK;
+  }
+  ERR_clear_error();
+  auto p = reinterpret_cast<const unsigned char*>(data.data());
+  auto sess = d2i_SSL_SESSION(nullptr, &p, data.size());
+  if (!sess) {
+    cache->remove(key);
+    return TLS_ERR_OK;
+  }
+  rv_ = SSL_set_session(ssl_, sess);
+  SSL_SESSION_free(sess);
+  if (rv_ != 1) {
+    // Just do full handshake.
+    A2_LOG_DEBUG(fmt("Could not set cached TLS session for %s", key.c_str()));
+    cache->remove(key);
+    ERR_clear_error();
+  }
+  return TLS_ERR_OK;
+}
+
+bool OpenSSLTLSSession::isSessionResumed()
+{
+  return SSL_session_reused(ssl_) == 1;
+}
+
+void OpenSSLTLSSession::storeSession(SSL_SESSION* sess)
+{
+  if (sessionCacheKey_.empty()) {
+    return;
+  }
+  int len = i2d_SSL_SESSION(sess, nullptr);
+  if (len <= 0) {
+    return;
+  }
+  std::string data(len, '\0');
+  auto p = reinterpret_cast<unsigned char*>(&data[0]);
+  i2d_SSL_SESSION(sess, &p);
+#ifdef TLS1_3_VERSION
+  // TLS 1.3 tickets are for one connection only.
+  bool reusable = SSL_SESSION_get_protocol_version(sess) != TLS1_3_VERSION;
+#else  // !TLS1_3_VERSION
+  bool reusable = true;
+#endif // !TLS1_3_VERSION
+  tlsContext_->getSessionCache()->put(sessionCacheKey_, std::move(data),
+                                      reusable);
+}
+
 int OpenSSLTLSSession::closeConnection()
 {
   ERR_clear_error();
@@ -143,6 +233,43 @@ ssize_t OpenSSLTLSSession::writeData(const void* data, size_t len)
   }
 }
 
+bool OpenSSLTLSSession::isKernelTLSSend()
+{
+#if OPENSSL_KTLS_API
+  return BIO_get_ktls_send(SSL_get_wbio(ssl_));
+#else  // !OPENSSL_KTLS_API
+  return false;
+#endif // !OPENSSL_KTLS_API
+}
+
+bool OpenSSLTLSSession::isKernelTLSRecv()
+{
+#if OPENSSL_KTLS_API
+  return BIO_get_ktls_recv(SSL_get_rbio(ssl_));
+#else  // !OPENSSL_KTLS_API
+  return false;
+#endif // !OPENSSL_KTLS_API
+}
+
+ssize_t OpenSSLTLSSession::sendFile(int fd, int64_t offset, size_t len)
+{
+#if OPENSSL_KTLS_API
+  ERR_clear_error();
+  auto ret = SSL_sendfile(ssl_, fd, offset, len, 0);
+  if (ret <= 0) {
+    rv_ = ret;
+    if (wouldblock(ssl_, rv_)) {
+      return TLS_ERR_WOULDBLOCK;
+    }
+    return TLS_ERR_ERROR;
+  }
+  rv_ = 1;
+  return ret;
+#else  // !OPENSSL_KTLS_API
+  return TLS_ERR_ERROR;
+#endif // !OPENSSL_KTLS_API
+}
+
 ssize_t OpenSSLTLSSession::readData(void* data, size_t len)
 {
   ERR_clear_error();
@@ -217,6 +344,12 @@ int OpenSSLTLSSession::handshake(TLSVersion& version)
     break;
 #endif // TLS1_2_VERSION
 
+#ifdef TLS1_3_VERSION
+  case TLS1_3_VERSION:
+    version = TLS_PROTO_TLS13;
+    break;
+#endif // TLS1_3_VERSION
+
   default:
     version = TLS_PROTO_NONE;
     break;
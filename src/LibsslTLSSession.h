@@ -52,6 +52,14 @@ public:
   virtual ~OpenSSLTLSSession();
   virtual int init(sock_t sockfd) CXX11_OVERRIDE;
   virtual int setSNIHostname(const std::string& hostname) CXX11_OVERRIDE;
+  virtual int
+  setAlpnProtocols(const std::vector<std::string>& protocols) CXX11_OVERRIDE;
+  virtual std::string getAlpnProtocol() CXX11_OVERRIDE;
+  virtual int setSessionCacheKey(const std::string& key) CXX11_OVERRIDE;
+  virtual bool isSessionResumed() CXX11_OVERRIDE;
+  virtual bool isKernelTLSSend() CXX11_OVERRIDE;
+  virtual bool isKernelTLSRecv() CXX11_OVERRIDE;
+  virtual ssize_t sendFile(int fd, int64_t offset, size_t len) CXX11_OVERRIDE;
   virtual int closeConnection() CXX11_OVERRIDE;
   virtual int checkDirection() CXX11_OVERRIDE;
   virtual ssize_t writeData(const void* data, size_t len) CXX11_OVERRIDE;
@@ -62,10 +70,15 @@ public:
   virtual std::string getLastErrorString() CXX11_OVERRIDE;
   virtual size_t getRecvBufferedLength() CXX11_OVERRIDE { return 0; }
 
+  // Stores |sess| to the session cache of the context.  This is
+  // called when the server issues new session.
+  void storeSession(SSL_SESSION* sess);
+
 private:
   int handshake(TLSVersion& version);
   SSL* ssl_;
   OpenSSLTLSContext* tlsContext_;
+  std::string sessionCacheKey_;
   // Last error code from openSSL library functions
   int rv_;
 };
@@ -87,6 +87,12 @@ bool LpdDispatchMessageCommand::execute()
       tryCount_ = 0;
     }
   }
+  if (tryCount_ > 0) {
+    setWakeupTimeAfter(1_s);
+  }
+  else {
+    setWakeupTime(dispatcher_->getNextAnnounceTime());
+  }
   e_->addCommand(std::unique_ptr<Command>(this));
   return false;
 }
@@ -99,6 +99,13 @@ bool LpdMessageDispatcher::isAnnounceReady() const
   return timer_.difference(global::wallclock()) >= interval_;
 }
 
+Timer LpdMessageDispatcher::getNextAnnounceTime() const
+{
+  auto t = timer_;
+  t.advance(interval_);
+  return t;
+}
+
 void LpdMessageDispatcher::resetAnnounceTimer()
 {
   timer_ = global::wallclock();
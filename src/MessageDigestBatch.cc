@@ -0,0 +1,150 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "MessageDigestBatch.h"
+
+#include <algorithm>
+
+#include "MessageDigest.h"
+#include "DlAbortEx.h"
+#include "fmt.h"
+#include "a2functional.h"
+#include "crypto_hash_multi.h"
+
+namespace aria2 {
+
+namespace {
+crypto::hash::Algorithms getMultiAlgorithm(const std::string& hashType)
+{
+  if (hashType == "sha-1") {
+    return crypto::hash::algoSHA1;
+  }
+  return crypto::hash::algoNone;
+}
+} // namespace
+
+MessageDigestBatch::MessageDigestBatch(const std::string& hashType, size_t n)
+    : size_(n)
+{
+  auto algo = getMultiAlgorithm(hashType);
+  auto lanes = crypto::hash::multiLanes(algo);
+  if (lanes > 1) {
+    for (size_t i = 0; i < n; i += lanes) {
+      multis_.push_back(crypto::hash::createMulti(algo));
+    }
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    ctxs_.push_back(MessageDigest::create(hashType));
+  }
+}
+
+MessageDigestBatch::~MessageDigestBatch() = default;
+
+size_t MessageDigestBatch::getLanes(const std::string& hashType)
+{
+  return std::max(static_cast<size_t>(1), crypto::hash::multiLanes(
+                                              getMultiAlgorithm(hashType)));
+}
+
+std::unique_ptr<MessageDigestBatch>
+MessageDigestBatch::create(const std::string& hashType, size_t n)
+{
+  if (!MessageDigest::supports(hashType)) {
+    throw DL_ABORT_EX(fmt("Unsupported hash type %s", hashType.c_str()));
+  }
+  return make_unique<MessageDigestBatch>(hashType, n);
+}
+
+size_t MessageDigestBatch::getDigestLength() const
+{
+  if (!multis_.empty()) {
+    return multis_[0]->length();
+  }
+  return ctxs_.empty() ? 0 : ctxs_[0]->getDigestLength();
+}
+
+void MessageDigestBatch::reset()
+{
+  for (auto& multi : multis_) {
+    multi->reset();
+  }
+  for (auto& ctx : ctxs_) {
+    ctx->reset();
+  }
+}
+
+MessageDigestBatch& MessageDigestBatch::update(const void* const* data,
+                                               size_t length)
+{
+  if (!multis_.empty()) {
+    auto lanes = multis_[0]->lanes();
+    std::vector<const void*> lane(lanes);
+    for (size_t i = 0; i < multis_.size(); ++i) {
+      for (size_t j = 0; j < lanes; ++j) {
+        // The unused lanes of the last kernel hash a copy of its first
+        // message.
+        auto k = i * lanes + j;
+        lane[j] = data[k < size_ ? k : i * lanes];
+      }
+      multis_[i]->update(lane.data(), length);
+    }
+    return *this;
+  }
+  for (size_t i = 0; i < size_; ++i) {
+    ctxs_[i]->update(data[i], length);
+  }
+  return *this;
+}
+
+std::vector<std::string> MessageDigestBatch::digest()
+{
+  std::vector<std::string> rv;
+  for (auto& multi : multis_) {
+    auto digests = multi->finalize();
+    for (auto& d : digests) {
+      if (rv.size() == size_) {
+        break;
+      }
+      rv.push_back(std::move(d));
+    }
+  }
+  for (auto& ctx : ctxs_) {
+    rv.push_back(ctx->digest());
+    ctx->reset();
+  }
+  return rv;
+}
+
+} // namespace aria2
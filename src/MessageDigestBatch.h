@@ -0,0 +1,101 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_MESSAGE_DIGEST_BATCH_H
+#define D_MESSAGE_DIGEST_BATCH_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace crypto {
+namespace hash {
+class MultiAlgorithm;
+} // namespace hash
+} // namespace crypto
+
+namespace aria2 {
+
+class MessageDigest;
+
+// Hashes several messages of the same length at once.  If the running
+// CPU has a multi-buffer SIMD kernel for the hash type, the messages
+// are hashed together, getLanes() of them per kernel call.  Otherwise
+// each message is hashed by its own MessageDigest.
+class MessageDigestBatch {
+public:
+  // Made public for make_unique
+  MessageDigestBatch(const std::string& hashType, size_t n);
+  MessageDigestBatch(const MessageDigestBatch&) = delete;
+  MessageDigestBatch& operator=(const MessageDigestBatch&) = delete;
+
+  ~MessageDigestBatch();
+
+  // Returns the number of messages of hashType which the multi-buffer
+  // kernel hashes at once, or 1 if there is no such kernel.  Callers
+  // should batch this many messages; a smaller batch costs as much as
+  // a full one.
+  static size_t getLanes(const std::string& hashType);
+
+  // Creates a batch of n messages.  Throws exception if hashType is
+  // not supported.
+  static std::unique_ptr<MessageDigestBatch> create(const std::string& hashType,
+                                                    size_t n);
+
+  // Returns the number of messages.
+  size_t size() const { return size_; }
+
+  size_t getDigestLength() const;
+
+  void reset();
+
+  // Appends length bytes pointed by data[i] to message i, for each of
+  // the size() messages.
+  MessageDigestBatch& update(const void* const* data, size_t length);
+
+  // Returns the raw digests of the messages, in order, and resets
+  // this object.
+  std::vector<std::string> digest();
+
+private:
+  size_t size_;
+  std::vector<std::unique_ptr<crypto::hash::MultiAlgorithm>> multis_;
+  std::vector<std::unique_ptr<MessageDigest>> ctxs_;
+};
+
+} // namespace aria2
+
+#endif // D_MESSAGE_DIGEST_BATCH_H
@@ -51,6 +51,7 @@
 #include "LogFactory.h"
 #include "SimpleRandomizer.h"
 #include "WrDiskCacheEntry.h"
+#include "DiskWriteQueue.h"
 #include "OpenedFileCounter.h"
 
 namespace aria2 {
@@ -114,7 +115,10 @@ bool DiskWriterEntry::operator<(const DiskWriterEntry& entry) const
   return *fileEntry_ < *entry.fileEntry_;
 }
 
-MultiDiskAdaptor::MultiDiskAdaptor() : pieceLength_{0}, readOnly_{false} {}
+MultiDiskAdaptor::MultiDiskAdaptor()
+    : pieceLength_{0}, readOnly_{false}, queuedDiskWriter_{nullptr}
+{
+}
 
 MultiDiskAdaptor::~MultiDiskAdaptor() { closeFile(); }
 
@@ -131,6 +135,7 @@ createDiskWriterEntry(const std::shared_ptr<FileEntry>& fileEntry)
 void MultiDiskAdaptor::resetDiskWriterEntries()
 {
   assert(openedDiskWriterEntries_.empty());
+  queuedDiskWriter_ = nullptr;
   diskWriterEntries_.clear();
   if (getFileEntries().empty()) {
     return;
@@ -178,13 +183,16 @@ void MultiDiskAdaptor::resetDiskWriterEntries()
       }
     }
   }
-  DefaultDiskWriterFactory dwFactory;
+  DefaultDiskWriterFactory defaultFactory;
+  DiskWriterFactory* dwFactory = diskWriterFactory_
+                                     ? diskWriterFactory_.get()
+                                     : &defaultFactory;
   for (auto& dwent : diskWriterEntries_) {
     if (dwent->needsFileAllocation() || dwent->needsDiskWriter() ||
         dwent->fileExists()) {
       A2_LOG_DEBUG(fmt("Creating DiskWriter for filename=%s",
                        dwent->getFilePath().c_str()));
-      dwent->setDiskWriter(dwFactory.newDiskWriter(dwent->getFilePath()));
+      dwent->setDiskWriter(dwFactory->newDiskWriter(dwent->getFilePath()));
       if (readOnly_) {
         dwent->getDiskWriter()->enableReadOnly();
       }
@@ -410,13 +418,102 @@ ssize_t MultiDiskAdaptor::readData(unsigned char* data, size_t len,
   return totalReadLength;
 }
 
-void MultiDiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
+void MultiDiskAdaptor::queueCache(const WrDiskCacheEntry* entry)
 {
   for (auto& d : entry->getDataSet()) {
     A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", d->goff,
                      static_cast<unsigned long>(d->len)));
-    writeData(d->data + d->offset, d->len, d->goff);
+    auto data = d->data + d->offset;
+    auto first = findFirstDiskWriterEntry(diskWriterEntries_, d->goff);
+    ssize_t rem = d->len;
+    int64_t fileOffset = d->goff - (*first)->getFileEntry()->getOffset();
+    for (auto i = first, eoi = diskWriterEntries_.cend(); i != eoi; ++i) {
+      ssize_t writeLength = calculateLength((*i).get(), fileOffset, rem);
+      auto dw = (*i)->getDiskWriter().get();
+      if (dw != queuedDiskWriter_) {
+        // Opening a file may close other files.  Complete the writes
+        // queued for the previous file first.
+        flushCache();
+        queuedDiskWriter_ = dw;
+      }
+      openIfNot((*i).get(), &DiskWriterEntry::openFile);
+      if (!(*i)->isOpen()) {
+        throwOnDiskWriterNotOpened((*i).get(), d->goff + (d->len - rem));
+      }
+      dw->queueWrite(data + (d->len - rem), writeLength, fileOffset);
+      rem -= writeLength;
+      fileOffset = 0;
+      if (rem == 0) {
+        break;
+      }
+    }
+  }
+}
+
+void MultiDiskAdaptor::flushCache()
+{
+  if (queuedDiskWriter_) {
+    auto dw = queuedDiskWriter_;
+    queuedDiskWriter_ = nullptr;
+    dw->flushWrites();
+  }
+}
+
+bool MultiDiskAdaptor::prepareWriteJob(const WrDiskCacheEntry* entry,
+                                       DiskWriteJob& job)
+{
+  for (auto& d : entry->getDataSet()) {
+    auto data = d->data + d->offset;
+    auto first = findFirstDiskWriterEntry(diskWriterEntries_, d->goff);
+    ssize_t rem = d->len;
+    int64_t fileOffset = d->goff - (*first)->getFileEntry()->getOffset();
+    for (auto i = first, eoi = diskWriterEntries_.cend(); i != eoi; ++i) {
+      ssize_t writeLength = calculateLength((*i).get(), fileOffset, rem);
+      openIfNot((*i).get(), &DiskWriterEntry::openFile);
+      if (!(*i)->isOpen() ||
+          !job.addWrite((*i)->getDiskWriter().get(), fileOffset,
+                        data + (d->len - rem), writeLength)) {
+        return false;
+      }
+      rem -= writeLength;
+      fileOffset = 0;
+      if (rem == 0) {
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+DiskWriterEntry* MultiDiskAdaptor::openReadEntry(int64_t offset, size_t len,
+                                                 int64_t& fileOffset)
+{
+  auto first = findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  auto entry = (*first).get();
+  fileOffset = offset - entry->getFileEntry()->getOffset();
+  if (calculateLength(entry, fileOffset, len) != static_cast<ssize_t>(len)) {
+    // The range spans multiple files.
+    return nullptr;
+  }
+  openIfNot(entry, &DiskWriterEntry::openFile);
+  if (!entry->isOpen()) {
+    return nullptr;
   }
+  return entry;
+}
+
+int MultiDiskAdaptor::dupReadFd(int64_t offset, size_t len,
+                                int64_t& fileOffset)
+{
+  auto entry = openReadEntry(offset, len, fileOffset);
+  return entry ? entry->getDiskWriter()->dupReadFd() : -1;
+}
+
+std::shared_ptr<SharedFd>
+MultiDiskAdaptor::shareReadFd(int64_t offset, size_t len, int64_t& fileOffset)
+{
+  auto entry = openReadEntry(offset, len, fileOffset);
+  return entry ? entry->getDiskWriter()->shareReadFd() : nullptr;
 }
 
 bool MultiDiskAdaptor::fileExists()
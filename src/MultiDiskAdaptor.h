@@ -42,6 +42,7 @@ namespace aria2 {
 class MultiFileAllocationIterator;
 class FileEntry;
 class DiskWriter;
+class DiskWriterFactory;
 
 class DiskWriterEntry {
 private:
@@ -103,10 +104,22 @@ private:
 
   bool readOnly_;
 
+  std::shared_ptr<DiskWriterFactory> diskWriterFactory_;
+
+  // The DiskWriter which has the writes queued by queueCache().
+  DiskWriter* queuedDiskWriter_;
+
   void resetDiskWriterEntries();
 
   void openIfNot(DiskWriterEntry* entry, void (DiskWriterEntry::*f)());
 
+  // Returns the opened entry of the file which contains the whole
+  // range [offset, offset + len), and stores the offset of the range
+  // in the file in |fileOffset|.  Returns nullptr if the range spans
+  // multiple files or the file cannot be opened.
+  DiskWriterEntry* openReadEntry(int64_t offset, size_t len,
+                                 int64_t& fileOffset);
+
   ssize_t readData(unsigned char* data, size_t len, int64_t offset,
                    bool dropCache);
 
@@ -133,7 +146,18 @@ public:
   virtual ssize_t readDataDropCache(unsigned char* data, size_t len,
                                     int64_t offset) CXX11_OVERRIDE;
 
-  virtual void writeCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+  virtual void queueCache(const WrDiskCacheEntry* entry) CXX11_OVERRIDE;
+
+  virtual void flushCache() CXX11_OVERRIDE;
+
+  virtual bool prepareWriteJob(const WrDiskCacheEntry* entry,
+                               DiskWriteJob& job) CXX11_OVERRIDE;
+
+  virtual int dupReadFd(int64_t offset, size_t len,
+                        int64_t& fileOffset) CXX11_OVERRIDE;
+
+  virtual std::shared_ptr<SharedFd>
+  shareReadFd(int64_t offset, size_t len, int64_t& fileOffset) CXX11_OVERRIDE;
 
   virtual bool fileExists() CXX11_OVERRIDE;
 
@@ -156,6 +180,14 @@ public:
 
   int32_t getPieceLength() const { return pieceLength_; }
 
+  // Sets the factory to create DiskWriter for each file.  If it is
+  // not set, DefaultDiskWriterFactory is used.
+  void setDiskWriterFactory(
+      const std::shared_ptr<DiskWriterFactory>& diskWriterFactory)
+  {
+    diskWriterFactory_ = diskWriterFactory;
+  }
+
   virtual void cutTrailingGarbage() CXX11_OVERRIDE;
 
   virtual size_t utime(const Time& actime, const Time& modtime) CXX11_OVERRIDE;
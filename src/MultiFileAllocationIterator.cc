@@ -152,6 +152,14 @@ int64_t MultiFileAllocationIterator::getTotalLength()
   }
 }
 
+bool MultiFileAllocationIterator::canAllocateInWorker()
+{
+  // Moving on to the next file opens it and logs, which must be done
+  // in the main thread.
+  return fileAllocationIterator_ && !fileAllocationIterator_->finished() &&
+         fileAllocationIterator_->canAllocateInWorker();
+}
+
 const DiskWriterEntries&
 MultiFileAllocationIterator::getDiskWriterEntries() const
 {
@@ -198,6 +198,9 @@ int MultiUrlRequestInfo::prepare()
         throw DL_ABORT_EX("Loading private key and/or certificate for secure "
                           "RPC failed.");
       }
+      if (option_->getAsBool(PREF_ENABLE_KTLS)) {
+        svTlsContext->enableKernelTLS();
+      }
       SocketCore::setServerTLSContext(svTlsContext);
     }
 #endif // ENABLE_SSL
@@ -270,6 +273,11 @@ int MultiUrlRequestInfo::prepare()
       }
     }
     clTlsContext->setVerifyPeer(option_->getAsBool(PREF_CHECK_CERTIFICATE));
+    if (option_->getAsBool(PREF_ENABLE_KTLS) &&
+        !clTlsContext->enableKernelTLS()) {
+      A2_LOG_NOTICE("Kernel TLS is not supported by the TLS library in use."
+                    " --enable-ktls is ignored.");
+    }
     SocketCore::setClientTLSContext(clTlsContext);
 #endif
 #ifdef HAVE_ARES_ADDR_NODE
@@ -277,7 +285,26 @@ int MultiUrlRequestInfo::prepare()
         parseAsyncDNSServers(option_->get(PREF_ASYNC_DNS_SERVER));
     e_->setAsyncDNSServers(asyncDNSServers);
 #endif // HAVE_ARES_ADDR_NODE
-
+#if defined(ENABLE_ASYNC_DNS) && !defined(HAVE_LIBCARES)
+    e_->setAsyncDNSServers(
+        parseAsyncDNSServers(option_->get(PREF_ASYNC_DNS_SERVER)));
+#endif // ENABLE_ASYNC_DNS && !HAVE_LIBCARES
+
+    {
+      const auto& dnsCache = e_->getDNSCache();
+      auto maxTTL =
+          std::chrono::seconds(option_->getAsInt(PREF_DNS_CACHE_MAX_TTL));
+      dnsCache->setMaxTTL(maxTTL);
+      dnsCache->setMinTTL(std::min(
+          maxTTL,
+          std::chrono::seconds(option_->getAsInt(PREF_DNS_CACHE_MIN_TTL))));
+      dnsCache->setNegativeTTL(
+          std::chrono::seconds(option_->getAsInt(PREF_DNS_CACHE_NEGATIVE_TTL)));
+      const std::string& dnsCacheFile = option_->get(PREF_DNS_CACHE_FILE);
+      if (!dnsCacheFile.empty() && File(dnsCacheFile).exists()) {
+        dnsCache->load(dnsCacheFile);
+      }
+    }
     std::string serverStatIf = option_->get(PREF_SERVER_STAT_IF);
     if (!serverStatIf.empty()) {
       e_->getRequestGroupMan()->loadServerStat(serverStatIf);
@@ -311,6 +338,10 @@ error_code::Value MultiUrlRequestInfo::getResult()
     e_->getCookieStorage()->saveNsFormat(option_->get(PREF_SAVE_COOKIES));
   }
 
+  const std::string& dnsCacheFile = option_->get(PREF_DNS_CACHE_FILE);
+  if (!dnsCacheFile.empty()) {
+    e_->getDNSCache()->save(dnsCacheFile);
+  }
   const std::string& serverStatOf = option_->get(PREF_SERVER_STAT_OF);
   if (!serverStatOf.empty()) {
     e_->getRequestGroupMan()->saveServerStat(serverStatOf);
@@ -96,6 +96,8 @@ bool NameResolveCommand::execute()
 #ifdef ENABLE_ASYNC_DNS
     if (e_->getOption()->getAsBool(PREF_ASYNC_DNS)) {
       if (resolveHostname(res, hostname) == 0) {
+        // The resolver may time out without an event.
+        setWakeupTimeAfter(1_s);
         e_->addCommand(std::unique_ptr<Command>(this));
         return false;
       }
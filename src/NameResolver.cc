@@ -45,7 +45,9 @@
 
 namespace aria2 {
 
-NameResolver::NameResolver() : socktype_(0), family_(AF_UNSPEC) {}
+NameResolver::NameResolver() : socktype_(0), family_(AF_UNSPEC), lastError_(0)
+{
+}
 
 void NameResolver::resolve(std::vector<std::string>& resolvedAddresses,
                            const std::string& hostname)
@@ -54,6 +56,7 @@ void NameResolver::resolve(std::vector<std::string>& resolvedAddresses,
   int s;
   s = callGetaddrinfo(&res, hostname.c_str(), nullptr, family_, socktype_, 0,
                       0);
+  lastError_ = s;
   if (s) {
     throw DL_ABORT_EX2(
         fmt(EX_RESOLVE_HOSTNAME, hostname.c_str(), gai_strerror(s)),
@@ -70,4 +73,22 @@ void NameResolver::resolve(std::vector<std::string>& resolvedAddresses,
 
 void NameResolver::setSocktype(int socktype) { socktype_ = socktype; }
 
+bool NameResolver::isNegativeAnswer() const
+{
+  switch (lastError_) {
+  case EAI_NONAME:
+#ifdef EAI_NODATA
+  // Some platforms define EAI_NODATA as the same value as EAI_NONAME.
+#  if EAI_NODATA != EAI_NONAME
+  case EAI_NODATA:
+#  endif // EAI_NODATA != EAI_NONAME
+#endif   // EAI_NODATA
+  case EAI_AGAIN:
+  case EAI_FAIL:
+    return true;
+  default:
+    return false;
+  }
+}
+
 } // namespace aria2
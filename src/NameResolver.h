@@ -45,6 +45,8 @@ class NameResolver {
 private:
   int socktype_;
   int family_;
+  // Return value of the last getaddrinfo() call.
+  int lastError_;
 
 public:
   NameResolver();
@@ -60,6 +62,10 @@ public:
 
   // specify protocol family
   void setFamily(int family) { family_ = family; }
+
+  // Returns true if the last resolve() failed because the name does
+  // not exist or the name server failed.  Such answers can be cached.
+  bool isNegativeAnswer() const;
 };
 
 } // namespace aria2
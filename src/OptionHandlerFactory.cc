@@ -86,8 +86,11 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
   }
 #ifdef ENABLE_ASYNC_DNS
   {
+    // Without c-ares, the built-in resolver reads /etc/resolv.conf,
+    // which Windows does not have.
     OptionHandler* op(new BooleanOptionHandler(PREF_ASYNC_DNS, TEXT_ASYNC_DNS,
-#  if defined(__ANDROID__) || defined(ANDROID)
+#  if defined(__ANDROID__) || defined(ANDROID) ||                              \
+      (defined(__MINGW32__) && !defined(HAVE_LIBCARES))
                                                A2_V_FALSE,
 #  else  // !__ANDROID__ && !ANDROID
                                                A2_V_TRUE,
@@ -99,14 +102,15 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
-#  if defined(HAVE_ARES_SET_SERVERS) && defined(HAVE_ARES_ADDR_NODE)
+#  if !defined(HAVE_LIBCARES) ||                                               \
+      (defined(HAVE_ARES_SET_SERVERS) && defined(HAVE_ARES_ADDR_NODE))
   {
     OptionHandler* op(new DefaultOptionHandler(
         PREF_ASYNC_DNS_SERVER, TEXT_ASYNC_DNS_SERVER, NO_DEFAULT_VALUE));
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
-#  endif // HAVE_ARES_SET_SERVERS && HAVE_ARES_ADDR_NODE
+#  endif // !HAVE_LIBCARES || (HAVE_ARES_SET_SERVERS && HAVE_ARES_ADDR_NODE)
 #endif   // ENABLE_ASYNC_DNS
   {
     OptionHandler* op(new BooleanOptionHandler(
@@ -229,6 +233,34 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new LocalFilePathOptionHandler(
+        PREF_DNS_CACHE_FILE, TEXT_DNS_CACHE_FILE, NO_DEFAULT_VALUE,
+        /* acceptStdin = */ false, 0, /* mustExist = */ false));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_DNS_CACHE_MAX_TTL,
+                                              TEXT_DNS_CACHE_MAX_TTL, "3600", 1,
+                                              INT32_MAX));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_DNS_CACHE_MIN_TTL,
+                                              TEXT_DNS_CACHE_MIN_TTL, "30", 0,
+                                              INT32_MAX));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_DNS_CACHE_NEGATIVE_TTL,
+                                              TEXT_DNS_CACHE_NEGATIVE_TTL, "5",
+                                              0, 3600));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(
         new NumberOptionHandler(PREF_DNS_TIMEOUT, NO_DESCRIPTION, "30", 1, 60));
@@ -263,6 +295,19 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+#ifdef HAVE_IO_URING
+  {
+    OptionHandler* op(new BooleanOptionHandler(
+        PREF_ENABLE_DISK_IO_URING, TEXT_ENABLE_DISK_IO_URING, A2_V_FALSE,
+        OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_EXPERIMENTAL);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
+#endif // HAVE_IO_URING
 #if defined(HAVE_MMAP) || defined(__MINGW32__)
   {
     OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_MMAP,
@@ -276,6 +321,17 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     handlers.push_back(op);
   }
 #endif // HAVE_MMAP || __MINGW32__
+#ifdef ENABLE_SSL
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_KTLS,
+                                               TEXT_ENABLE_KTLS, A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_HTTPS);
+    op->addTag(TAG_EXPERIMENTAL);
+    handlers.push_back(op);
+  }
+#endif // ENABLE_SSL
   {
     OptionHandler* op(new BooleanOptionHandler(
         PREF_ENABLE_RPC, TEXT_ENABLE_RPC, A2_V_FALSE, OptionHandler::OPT_ARG));
@@ -302,6 +358,9 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
 #ifdef HAVE_EPOLL
                                                      V_EPOLL,
 #endif // HAVE_EPOLL
+#ifdef HAVE_IO_URING
+                                                     V_IO_URING,
+#endif // HAVE_IO_URING
 #ifdef HAVE_KQUEUE
                                                      V_KQUEUE,
 #endif // HAVE_KQUEUE
@@ -437,6 +496,22 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeGlobalOption(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_MAX_CONCURRENT_FILE_ALLOCATIONS,
+        TEXT_MAX_CONCURRENT_FILE_ALLOCATIONS, "1", 1));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_FILE);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_MAX_CONCURRENT_INTEGRITY_CHECKS,
+        TEXT_MAX_CONCURRENT_INTEGRITY_CHECKS, "1", 1));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_CHECKSUM);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new NumberOptionHandler(PREF_MAX_CONNECTION_PER_SERVER,
                                               TEXT_MAX_CONNECTION_PER_SERVER,
@@ -461,6 +536,13 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new UnitNumberOptionHandler(PREF_MAX_DISK_WRITE_QUEUE,
+                                                  TEXT_MAX_DISK_WRITE_QUEUE,
+                                                  "32M", 1_m));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new NumberOptionHandler(
         PREF_MAX_DOWNLOAD_RESULT, TEXT_MAX_DOWNLOAD_RESULT, "1000", 0));
@@ -468,6 +550,26 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeGlobalOption(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_MAX_IDLE_CONNECTIONS, TEXT_MAX_IDLE_CONNECTIONS, "64", 0));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_MAX_IDLE_CONNECTIONS_PER_HOST, TEXT_MAX_IDLE_CONNECTIONS_PER_HOST,
+        "16", 0));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_IDLE_CONNECTION_TIMEOUT,
+                                              TEXT_IDLE_CONNECTION_TIMEOUT,
+                                              "15", 1, 600));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new UnitNumberOptionHandler(
         PREF_MAX_MMAP_LIMIT, TEXT_MAX_MMAP_LIMIT,
@@ -706,6 +808,13 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new UnitNumberOptionHandler(PREF_MAX_READ_BUFFER_SIZE,
+                                                  TEXT_MAX_READ_BUFFER_SIZE,
+                                                  "256K", 16_k, 16_m));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new BooleanOptionHandler(
         PREF_STDERR, TEXT_STDERR, A2_V_FALSE, OptionHandler::OPT_ARG));
@@ -738,6 +847,12 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_WORKER_THREADS, TEXT_WORKER_THREADS, "0", 0, 256));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new BooleanOptionHandler(
         PREF_RPC_ALLOW_ORIGIN_ALL, TEXT_RPC_ALLOW_ORIGIN_ALL, A2_V_FALSE,
@@ -1076,6 +1191,13 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(
+        new NumberOptionHandler(PREF_PRE_CONNECT, TEXT_PRE_CONNECT, "0", 0, 16));
+    op->addTag(TAG_HTTP);
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new BooleanOptionHandler(
         PREF_ENABLE_HTTP_PIPELINING, TEXT_ENABLE_HTTP_PIPELINING, A2_V_FALSE,
@@ -1086,6 +1208,19 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+#ifdef ENABLE_HTTP2
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_HTTP2,
+                                               TEXT_ENABLE_HTTP2, A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_HTTP);
+    op->addTag(TAG_HTTPS);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
+#endif // ENABLE_HTTP2
   {
     OptionHandler* op(new CumulativeOptionHandler(PREF_HEADER, TEXT_HEADER,
                                                   NO_DEFAULT_VALUE, "\n"));
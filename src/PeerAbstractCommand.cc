@@ -193,6 +193,13 @@ void PeerAbstractCommand::createSocket()
 
 void PeerAbstractCommand::addCommandSelf()
 {
+  // Wake up when the connection times out at the latest.
+  auto timeout = checkPoint_;
+  timeout.advance(timeout_);
+  auto t = Timer::zero();
+  if (!getWakeupTime(t) || timeout < t) {
+    setWakeupTime(timeout);
+  }
   e_->addCommand(std::unique_ptr<Command>(this));
 }
 
@@ -54,7 +54,8 @@ bool PeerChokeCommand::execute()
   if (peerStorage_->chokeRoundIntervalElapsed()) {
     peerStorage_->executeChoke();
   }
-  e_->addCommand(std::unique_ptr<Command>(this));
+  e_->addTimerCommand(std::unique_ptr<Command>(this),
+                      peerStorage_->getNextChokeRoundTime());
   return false;
 }
 
@@ -92,6 +92,20 @@ void PeerConnection::pushBytes(std::vector<unsigned char> data,
   socketBuffer_.pushBytes(std::move(data), std::move(progressUpdate));
 }
 
+bool PeerConnection::isSendFileAvailable() const
+{
+  return !encryptionEnabled_ && socket_->isSendFileAvailable();
+}
+
+void PeerConnection::pushFile(std::shared_ptr<SharedFd> fd, int64_t offset,
+                              size_t length,
+                              std::unique_ptr<ProgressUpdate> progressUpdate)
+{
+  assert(isSendFileAvailable());
+  socketBuffer_.pushFile(std::move(fd), offset, length,
+                         std::move(progressUpdate));
+}
+
 bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength)
 {
   while (1) {
@@ -100,6 +100,18 @@ public:
                  std::unique_ptr<ProgressUpdate> progressUpdate =
                      std::unique_ptr<ProgressUpdate>{});
 
+  // Returns true if pushFile() can be used, that is, the connection
+  // is not encrypted and the socket supports sendfile(2).
+  bool isSendFileAvailable() const;
+
+  // Pushes |length| bytes at |offset| in the file |fd| into send
+  // buffer.  The data is sent without being copied into user space.
+  // This method must not be called unless isSendFileAvailable()
+  // returns true.
+  void pushFile(std::shared_ptr<SharedFd> fd, int64_t offset, size_t length,
+                std::unique_ptr<ProgressUpdate> progressUpdate =
+                    std::unique_ptr<ProgressUpdate>{});
+
   bool receiveMessage(unsigned char* data, size_t& dataLength);
 
   /**
@@ -139,6 +139,7 @@ PeerInteractionCommand::PeerInteractionCommand(
   factory->setPeerStorage(peerStorage.get());
   factory->setExtensionMessageFactory(extensionMessageFactory.get());
   factory->setPeer(getPeer());
+  factory->setWorkerPool(e->getWorkerPool().get());
   if (family == AF_INET) {
     factory->setLocalNode(DHTRegistry::getData().localNode.get());
     factory->setRoutingTable(DHTRegistry::getData().routingTable.get());
@@ -348,7 +349,8 @@ bool PeerInteractionCommand::executeInternal()
       if (getDownloadEngine()
               ->getRequestGroupMan()
               ->doesOverallDownloadSpeedExceed() ||
-          requestGroup_->doesDownloadSpeedExceed()) {
+          requestGroup_->doesDownloadSpeedExceed() ||
+          getDownloadEngine()->getRequestGroupMan()->isWriteQueueFull()) {
         disableReadCheckSocket();
         setNoCheck(true);
       }
@@ -371,7 +373,10 @@ bool PeerInteractionCommand::executeInternal()
   else {
     disableWriteCheckSocket();
   }
-
+  // Keep-alive, request timeouts, choking, the have messages of the
+  // pieces completed by other peers and the speed limit do not come
+  // with a socket event.
+  setWakeupTimeAfter(1_s);
   addCommandSelf();
   return false;
 }
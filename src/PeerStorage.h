@@ -45,6 +45,7 @@
 #include "TransferStat.h"
 #include "Command.h"
 #include "a2functional.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
@@ -119,6 +120,12 @@ public:
 
   virtual bool chokeRoundIntervalElapsed() = 0;
 
+  /**
+   * Returns the time when chokeRoundIntervalElapsed() is expected to
+   * become true.
+   */
+  virtual Timer getNextChokeRoundTime() = 0;
+
   virtual void executeChoke() = 0;
 };
 
@@ -35,6 +35,8 @@
 #include "Piece.h"
 
 #include <array>
+#include <algorithm>
+#include <cstring>
 #include <cassert>
 
 #include "util.h"
@@ -51,14 +53,22 @@
 
 namespace aria2 {
 
-Piece::Piece() : index_(0), length_(0), nextBegin_(0), usedBySegment_(false) {}
+Piece::Piece()
+    : index_(0),
+      length_(0),
+      nextBegin_(0),
+      usedBySegment_(false),
+      verifying_(false)
+{
+}
 
 Piece::Piece(size_t index, int64_t length, int32_t blockLength)
     : bitfield_(make_unique<BitfieldMan>(blockLength, length)),
       index_(index),
       length_(length),
       nextBegin_(0),
-      usedBySegment_(false)
+      usedBySegment_(false),
+      verifying_(false)
 {
 }
 
@@ -258,13 +268,21 @@ Piece::getDigestWithWrCache(size_t pieceLength,
   int64_t start = static_cast<int64_t>(index_) * pieceLength;
   int64_t goff = start;
   if (wrCache_) {
-    const WrDiskCacheEntry::DataCellSet& dataSet = wrCache_->getDataSet();
-    for (auto& d : dataSet) {
+    // The data evicted from the cache may still be being written, so
+    // take them from memory rather than from the file.
+    std::vector<const WrDiskCacheEntry::DataCell*> cells;
+    wrCache_->getDataCells(cells);
+    for (auto d : cells) {
+      auto end = d->goff + static_cast<int64_t>(d->len);
+      if (end <= goff) {
+        continue;
+      }
       if (goff < d->goff) {
         updateHashWithRead(mdctx.get(), adaptor, goff, d->goff - goff);
+        goff = d->goff;
       }
-      mdctx->update(d->data + d->offset, d->len);
-      goff = d->goff + d->len;
+      mdctx->update(d->data + d->offset + (goff - d->goff), end - goff);
+      goff = end;
     }
     updateHashWithRead(mdctx.get(), adaptor, goff, start + length_ - goff);
   }
@@ -274,6 +292,44 @@ Piece::getDigestWithWrCache(size_t pieceLength,
   return mdctx->digest();
 }
 
+ssize_t Piece::readDataWithWrCache(unsigned char* data, size_t len,
+                                   int64_t offset,
+                                   const std::shared_ptr<DiskAdaptor>& adaptor)
+{
+  int64_t last = offset + static_cast<int64_t>(len);
+  int64_t goff = offset;
+  std::vector<const WrDiskCacheEntry::DataCell*> cells;
+  if (wrCache_) {
+    wrCache_->getDataCells(cells);
+  }
+  for (auto d : cells) {
+    if (d->goff >= last) {
+      break;
+    }
+    auto end = std::min(last, d->goff + static_cast<int64_t>(d->len));
+    if (end <= goff) {
+      continue;
+    }
+    if (goff < d->goff) {
+      ssize_t nread = adaptor->readData(data + (goff - offset),
+                                        d->goff - goff, goff);
+      if (nread != d->goff - goff) {
+        return goff - offset + std::max(nread, static_cast<ssize_t>(0));
+      }
+      goff = d->goff;
+    }
+    memcpy(data + (goff - offset), d->data + d->offset + (goff - d->goff),
+           end - goff);
+    goff = end;
+  }
+  if (goff < last) {
+    ssize_t nread =
+        adaptor->readData(data + (goff - offset), last - goff, goff);
+    return goff - offset + std::max(nread, static_cast<ssize_t>(0));
+  }
+  return len;
+}
+
 void Piece::destroyHashContext()
 {
   mdctx_.reset();
@@ -317,7 +373,7 @@ void Piece::flushWrCache(WrDiskCache* diskCache)
   assert(wrCache_);
   ssize_t size = static_cast<ssize_t>(wrCache_->getSize());
   diskCache->update(wrCache_.get(), -size);
-  wrCache_->writeToDisk();
+  wrCache_->writeToDisk(diskCache->getDiskWriteQueue());
 }
 
 void Piece::clearWrCache(WrDiskCache* diskCache)
@@ -346,10 +402,11 @@ void Piece::updateWrCache(WrDiskCache* diskCache, unsigned char* data,
   cell->offset = offset;
   cell->len = len;
   cell->capacity = capacity;
+  auto size = wrCache_->getSize();
   bool rv;
   rv = wrCache_->cacheData(cell);
   assert(rv);
-  rv = diskCache->update(wrCache_.get(), len);
+  rv = diskCache->update(wrCache_.get(), wrCache_->getSize() - size);
   assert(rv);
 }
 
@@ -363,12 +420,33 @@ size_t Piece::appendWrCache(WrDiskCache* diskCache, int64_t goff,
   size_t delta = wrCache_->append(goff, data, len);
   bool rv;
   if (delta > 0) {
-    rv = diskCache->update(wrCache_.get(), delta);
+    // The buffer is already accounted.  Just mark the entry updated.
+    rv = diskCache->update(wrCache_.get(), 0);
     assert(rv);
   }
   return delta;
 }
 
+unsigned char* Piece::getWrCacheAppendBuffer(int64_t goff, size_t& len)
+{
+  if (!wrCache_) {
+    len = 0;
+    return nullptr;
+  }
+  return wrCache_->getAppendBuffer(goff, len);
+}
+
+void Piece::commitWrCacheAppend(WrDiskCache* diskCache, size_t len)
+{
+  assert(wrCache_);
+  wrCache_->commitAppend(len);
+  if (diskCache && len > 0) {
+    // The buffer is already accounted.  Just mark the entry updated.
+    bool rv = diskCache->update(wrCache_.get(), 0);
+    assert(rv);
+  }
+}
+
 void Piece::releaseWrCache(WrDiskCache* diskCache)
 {
   if (diskCache && wrCache_) {
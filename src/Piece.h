@@ -68,6 +68,8 @@ private:
 
   bool usedBySegment_;
 
+  bool verifying_;
+
   Piece(const Piece& piece) = delete;
   Piece& operator=(const Piece& piece) = delete;
 
@@ -162,6 +164,12 @@ public:
   // cached data and data on disk.
   std::string getDigestWithWrCache(size_t pieceLength,
                                    const std::shared_ptr<DiskAdaptor>& adaptor);
+
+  // Reads |len| bytes at |offset| in |adaptor| into |data|, taking the
+  // cached data, including the data being written asynchronously,
+  // from memory.  Returns the number of bytes read.
+  ssize_t readDataWithWrCache(unsigned char* data, size_t len, int64_t offset,
+                              const std::shared_ptr<DiskAdaptor>& adaptor);
   /**
    * Loses current bitfield state.
    */
@@ -174,6 +182,11 @@ public:
   bool getUsedBySegment() const { return usedBySegment_; }
   void setUsedBySegment(bool f) { usedBySegment_ = f; }
 
+  // True while the hash of this piece is calculated in a worker
+  // thread.  See PieceStorage::verifyPieceInWorker().
+  bool isVerifying() const { return verifying_; }
+  void setVerifying(bool f) { verifying_ = f; }
+
   void initWrCache(WrDiskCache* diskCache,
                    const std::shared_ptr<DiskAdaptor>& diskAdaptor);
   void flushWrCache(WrDiskCache* diskCache);
@@ -187,6 +200,13 @@ public:
   }
   size_t appendWrCache(WrDiskCache* diskCache, int64_t goff,
                        const unsigned char* data, size_t len);
+  // Returns the buffer where the data at |goff| can be appended to the
+  // cached data in place, and stores its size in |len|.  Returns
+  // nullptr if there is no such buffer.
+  unsigned char* getWrCacheAppendBuffer(int64_t goff, size_t& len);
+  // Caches |len| bytes written to the buffer returned by
+  // getWrCacheAppendBuffer().
+  void commitWrCacheAppend(WrDiskCache* diskCache, size_t len);
   void releaseWrCache(WrDiskCache* diskCache);
   WrDiskCacheEntry* getWrDiskCacheEntry() const { return wrCache_.get(); }
 };
@@ -43,7 +43,10 @@
 namespace aria2 {
 
 PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle)
-    : order_(pieceNum), counts_(pieceNum)
+    : order_(pieceNum),
+      counts_(pieceNum),
+      positions_(pieceNum),
+      bucketStart_{0, pieceNum}
 {
   for (size_t i = 0; i < pieceNum; ++i) {
     order_[i] = i;
@@ -53,66 +56,87 @@ PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle)
     std::shuffle(order_.begin(), order_.end(),
                  *SimpleRandomizer::getInstance());
   }
+  for (size_t i = 0; i < pieceNum; ++i) {
+    positions_[order_[i]] = i;
+  }
 }
 
 PieceStatMan::~PieceStatMan() = default;
 
-namespace {
-void inc(int& x)
+void PieceStatMan::inc(size_t index)
 {
-  if (x < std::numeric_limits<int>::max()) {
-    ++x;
+  int c = counts_[index];
+  if (c == std::numeric_limits<int>::max()) {
+    return;
+  }
+  if (static_cast<size_t>(c) + 2 == bucketStart_.size()) {
+    bucketStart_.push_back(order_.size());
   }
+  // Move the piece to the last position of its bucket, and then make
+  // that position the first one of the next bucket.
+  size_t last = --bucketStart_[c + 1];
+  size_t pos = positions_[index];
+  size_t other = order_[last];
+  order_[pos] = other;
+  positions_[other] = pos;
+  order_[last] = index;
+  positions_[index] = last;
+  ++counts_[index];
 }
-} // namespace
 
-namespace {
-void sub(int& x)
+void PieceStatMan::sub(size_t index)
 {
-  if (x > 0) {
-    --x;
+  int c = counts_[index];
+  if (c == 0) {
+    return;
   }
+  // Move the piece to the first position of its bucket, and then make
+  // that position the last one of the previous bucket.
+  size_t first = bucketStart_[c]++;
+  size_t pos = positions_[index];
+  size_t other = order_[first];
+  order_[pos] = other;
+  positions_[other] = pos;
+  order_[first] = index;
+  positions_[index] = first;
+  --counts_[index];
 }
-} // namespace
 
 void PieceStatMan::addPieceStats(const unsigned char* bitfield,
                                  size_t bitfieldLength)
 {
-  for (size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      inc(counts_[i]);
-    }
-  }
+  bitfield::forEachSetBit(bitfield, counts_.size(), [this](size_t i) {
+    inc(i);
+    return true;
+  });
 }
 
 void PieceStatMan::subtractPieceStats(const unsigned char* bitfield,
                                       size_t bitfieldLength)
 {
-  for (size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      sub(counts_[i]);
-    }
-  }
+  bitfield::forEachSetBit(bitfield, counts_.size(), [this](size_t i) {
+    sub(i);
+    return true;
+  });
 }
 
 void PieceStatMan::updatePieceStats(const unsigned char* newBitfield,
                                     size_t newBitfieldLength,
                                     const unsigned char* oldBitfield)
 {
-  for (size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    bool inNew = bitfield::test(newBitfield, nbits, i);
-    bool inOld = bitfield::test(oldBitfield, nbits, i);
-    if (inNew) {
-      if (!inOld) {
-        inc(counts_[i]);
-      }
-    }
-    else if (inOld) {
-      sub(counts_[i]);
-    }
-  }
+  using namespace expr;
+  bitfield::forEachSetBit(array(newBitfield) & ~array(oldBitfield),
+                          counts_.size(), [this](size_t i) {
+                            inc(i);
+                            return true;
+                          });
+  bitfield::forEachSetBit(array(oldBitfield) & ~array(newBitfield),
+                          counts_.size(), [this](size_t i) {
+                            sub(i);
+                            return true;
+                          });
 }
 
-void PieceStatMan::addPieceStats(size_t index) { inc(counts_[index]); }
+void PieceStatMan::addPieceStats(size_t index) { inc(index); }
 
 } // namespace aria2
@@ -41,10 +41,25 @@
 
 namespace aria2 {
 
+// Keeps the number of peers which have each piece.  The pieces are
+// also kept sorted by that count in order_, which is divided into one
+// bucket per count: the pieces with count c are stored in
+// order_[bucketStart_[c]] through order_[bucketStart_[c + 1] - 1].
+// When a count changes by one, the piece is swapped with the element
+// at the border of its bucket and the border is moved, so an update
+// takes constant time and the rarest pieces are always at the front of
+// order_.
 class PieceStatMan {
 private:
   std::vector<size_t> order_;
   std::vector<int> counts_;
+  // positions_[i] is the position of piece i in order_.
+  std::vector<size_t> positions_;
+  std::vector<size_t> bucketStart_;
+
+  void inc(size_t index);
+
+  void sub(size_t index);
 
 public:
   PieceStatMan(size_t pieceNum, bool randomShuffle);
@@ -61,6 +76,8 @@ public:
                         size_t newBitfieldLength,
                         const unsigned char* oldBitfield);
 
+  // Returns piece indexes sorted by count in ascending order.  The
+  // order of the pieces with the same count is unspecified.
   const std::vector<size_t>& getOrder() const { return order_; }
 
   const std::vector<int>& getCounts() const { return counts_; }
@@ -40,6 +40,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 
 #include "TimerA2.h"
 #include "Command.h"
@@ -52,6 +53,8 @@ class Peer;
 #endif // ENABLE_BITTORRENT
 class DiskAdaptor;
 class WrDiskCache;
+class RdDiskCache;
+class WorkerPool;
 
 class PieceStorage {
 public:
@@ -157,7 +160,11 @@ public:
   virtual void markPieceMissing(size_t index) = 0;
 
   /**
-   * Tells that the download of the specified piece completes.
+   * Tells that the download of the specified piece completes.  If
+   * the data of the piece are still being written asynchronously, the
+   * piece is completed, and advertised if advertisePiece() is called
+   * meanwhile, when the writes finish.  If they fail, the download
+   * fails.
    */
   virtual void completePiece(const std::shared_ptr<Piece>& piece) = 0;
 
@@ -167,6 +174,27 @@ public:
   virtual void cancelPiece(const std::shared_ptr<Piece>& piece,
                            cuid_t cuid) = 0;
 
+  /**
+   * Flushes the write disk cache of the complete piece and calculates
+   * its hash in a worker thread of workerPool.  callback is called in
+   * the main thread with the raw hash value, or an empty string if
+   * the piece could not be read.  Until then, the piece is marked as
+   * being verified and cancelPiece() keeps it in use.  Returns false
+   * if the piece cannot be hashed in a worker thread.  In that case,
+   * the caller must calculate the hash by itself.
+   */
+  virtual bool
+  verifyPieceInWorker(const std::shared_ptr<Piece>& piece,
+                      WorkerPool* workerPool,
+                      std::function<void(const std::string&)> callback) = 0;
+
+  /**
+   * Discards the pieces being verified in worker threads, and the
+   * pieces waiting for their data to be written.  Their callbacks are
+   * never called.
+   */
+  virtual void cancelPieceVerification() = 0;
+
   /**
    * Returns true if the specified piece is already downloaded.
    * Otherwise returns false.
@@ -226,6 +254,9 @@ public:
 
   virtual WrDiskCache* getWrDiskCache() = 0;
 
+  // Returns the cache of the pieces read for uploading, or nullptr.
+  virtual RdDiskCache* getRdDiskCache() = 0;
+
   // Flushes write disk cache for in-flight piece and evicts them.
   virtual void flushWrDiskCacheEntry() = 0;
 
@@ -52,9 +52,9 @@
 #  include <gnutls/gnutls.h>
 #endif // HAVE_LIBGNUTLS
 
-#ifdef ENABLE_ASYNC_DNS
+#ifdef HAVE_LIBCARES
 #  include <ares.h>
-#endif // ENABLE_ASYNC_DNS
+#endif // HAVE_LIBCARES
 
 #ifdef HAVE_LIBSSH2
 #  include <libssh2.h>
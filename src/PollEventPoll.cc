@@ -88,10 +88,9 @@ void PollEventPoll::poll(const struct timeval& tv)
 {
   // timeout is millisec
   int timeout = tv.tv_sec * 1000 + tv.tv_usec / 1000;
-  int res;
-  while ((res = ::poll(pollfds_.get(), pollfdNum_, timeout)) == -1 &&
-         errno == EINTR)
-    ;
+  // Do not retry on EINTR, so that DownloadEngine notices the signal
+  // without waiting for the timeout.
+  int res = ::poll(pollfds_.get(), pollfdNum_, timeout);
   if (res > 0) {
     for (auto first = pollfds_.get(), last = pollfds_.get() + pollfdNum_;
          first != last; ++first) {
@@ -107,7 +106,7 @@ void PollEventPoll::poll(const struct timeval& tv)
       }
     }
   }
-  else if (res == -1) {
+  else if (res == -1 && errno != EINTR) {
     int errNum = errno;
     A2_LOG_INFO(fmt("poll error: %s", util::safeStrerror(errNum).c_str()));
   }
@@ -0,0 +1,169 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PreconnectCommand.h"
+
+#include "DownloadEngine.h"
+#include "RequestGroupMan.h"
+#include "SocketCore.h"
+#include "LogFactory.h"
+#include "RecoverableException.h"
+#include "DlRetryEx.h"
+#include "wallclock.h"
+#include "fmt.h"
+#include "A2STR.h"
+
+namespace aria2 {
+
+PreconnectCommand::PreconnectCommand(cuid_t cuid, DownloadEngine* e,
+                                     const std::string& hostname,
+                                     const std::string& addr, uint16_t port,
+                                     bool secure, std::chrono::seconds timeout)
+    : Command(cuid),
+      e_(e),
+      socket_(std::make_shared<SocketCore>()),
+      hostname_(hostname),
+      addr_(addr),
+      port_(port),
+      secure_(secure),
+      connected_(false),
+      readCheck_(false),
+      writeCheck_(false),
+      checkPoint_(global::wallclock()),
+      timeout_(std::move(timeout))
+{
+  setStatusActive();
+  e_->addPendingPooledSocket(addr_, port_);
+}
+
+PreconnectCommand::~PreconnectCommand()
+{
+  setReadCheck(false);
+  setWriteCheck(false);
+  e_->removePendingPooledSocket(addr_, port_);
+}
+
+void PreconnectCommand::setReadCheck(bool check)
+{
+  if (check == readCheck_) {
+    return;
+  }
+  readCheck_ = check;
+  if (check) {
+    e_->addSocketForReadCheck(socket_, this);
+  }
+  else {
+    e_->deleteSocketForReadCheck(socket_, this);
+  }
+}
+
+void PreconnectCommand::setWriteCheck(bool check)
+{
+  if (check == writeCheck_) {
+    return;
+  }
+  writeCheck_ = check;
+  if (check) {
+    e_->addSocketForWriteCheck(socket_, this);
+  }
+  else {
+    e_->deleteSocketForWriteCheck(socket_, this);
+  }
+}
+
+bool PreconnectCommand::connect()
+{
+  if (!socket_->isOpen()) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Pre-connecting to %s:%u", getCuid(),
+                    addr_.c_str(), port_));
+    socket_->establishConnection(addr_, port_);
+    setWriteCheck(true);
+    return false;
+  }
+  if (!connected_) {
+    if (!writeEventEnabled() && !errorEventEnabled() && !hupEventEnabled()) {
+      return false;
+    }
+    auto error = socket_->getSocketError();
+    if (!error.empty()) {
+      throw DL_RETRY_EX(fmt("Failed to connect: %s", error.c_str()));
+    }
+    connected_ = true;
+    setWriteCheck(false);
+  }
+#ifdef ENABLE_SSL
+  if (secure_ && !socket_->tlsConnect(hostname_, port_)) {
+    setReadCheck(socket_->wantRead());
+    setWriteCheck(socket_->wantWrite());
+    return false;
+  }
+#endif // ENABLE_SSL
+  return true;
+}
+
+bool PreconnectCommand::execute()
+{
+  if (e_->isHaltRequested() || e_->getRequestGroupMan()->downloadFinished()) {
+    return true;
+  }
+  try {
+    if (connect()) {
+      setReadCheck(false);
+      setWriteCheck(false);
+      A2_LOG_INFO(fmt("CUID#%" PRId64 " - Pooling pre-connected socket to"
+                      " %s:%u",
+                      getCuid(), addr_.c_str(), port_));
+      e_->poolSocket(addr_, port_, A2STR::NIL, 0, socket_);
+      return true;
+    }
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_INFO_EX(fmt("CUID#%" PRId64 " - Pre-connecting to %s:%u failed",
+                       getCuid(), addr_.c_str(), port_),
+                   e);
+    return true;
+  }
+  if (checkPoint_.difference(global::wallclock()) >= timeout_) {
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Pre-connecting to %s:%u timed out",
+                    getCuid(), addr_.c_str(), port_));
+    return true;
+  }
+  auto timeout = checkPoint_;
+  timeout.advance(timeout_);
+  setWakeupTime(timeout);
+  e_->addCommand(std::unique_ptr<Command>(this));
+  return false;
+}
+
+} // namespace aria2
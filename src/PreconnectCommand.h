@@ -0,0 +1,87 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PRECONNECT_COMMAND_H
+#define D_PRECONNECT_COMMAND_H
+
+#include "Command.h"
+
+#include <string>
+#include <memory>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class DownloadEngine;
+class SocketCore;
+
+// Establishes a connection to addr:port ahead of need and puts it into
+// the socket pool.  If secure is true, TLS handshake with hostname is
+// done as well.  The downloads for the host pick up the connection
+// from the pool instead of connecting by themselves.
+class PreconnectCommand : public Command {
+private:
+  DownloadEngine* e_;
+  std::shared_ptr<SocketCore> socket_;
+  std::string hostname_;
+  std::string addr_;
+  uint16_t port_;
+  bool secure_;
+  bool connected_;
+  bool readCheck_;
+  bool writeCheck_;
+  Timer checkPoint_;
+  std::chrono::seconds timeout_;
+
+  void setReadCheck(bool check);
+  void setWriteCheck(bool check);
+
+  // Returns true if the connection is ready to be pooled.
+  bool connect();
+
+public:
+  PreconnectCommand(cuid_t cuid, DownloadEngine* e, const std::string& hostname,
+                    const std::string& addr, uint16_t port, bool secure,
+                    std::chrono::seconds timeout);
+
+  virtual ~PreconnectCommand();
+
+  virtual bool execute() CXX11_OVERRIDE;
+};
+
+} // namespace aria2
+
+#endif // D_PRECONNECT_COMMAND_H
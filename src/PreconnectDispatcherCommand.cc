@@ -0,0 +1,155 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PreconnectDispatcherCommand.h"
+
+#include <map>
+#include <algorithm>
+
+#include "DownloadEngine.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "DownloadContext.h"
+#include "FileEntry.h"
+#include "Option.h"
+#include "prefs.h"
+#include "uri.h"
+#include "SocketPool.h"
+#include "PreconnectCommand.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+PreconnectDispatcherCommand::PreconnectDispatcherCommand(
+    cuid_t cuid, DownloadEngine* e, std::chrono::seconds interval)
+    : TimeBasedCommand(cuid, e, std::move(interval))
+{
+}
+
+PreconnectDispatcherCommand::~PreconnectDispatcherCommand() = default;
+
+void PreconnectDispatcherCommand::preProcess()
+{
+  if (getDownloadEngine()->getRequestGroupMan()->downloadFinished() ||
+      getDownloadEngine()->isHaltRequested()) {
+    enableExit();
+  }
+}
+
+void PreconnectDispatcherCommand::process()
+{
+  auto e = getDownloadEngine();
+  auto option = e->getOption();
+  auto& pool = e->getSocketPool();
+  auto numConn = std::min(
+      static_cast<size_t>(option->getAsInt(PREF_PRE_CONNECT)),
+      pool->getMaxIdlePerHost());
+  if (numConn == 0) {
+    return;
+  }
+  // Pre-connected sockets count against --max-idle-connections.
+  // Leave room for the connections released by active downloads.
+  auto numIdle = pool->size() + pool->countPending();
+  if (numIdle >= pool->getMaxIdle()) {
+    return;
+  }
+  auto budget = pool->getMaxIdle() - numIdle;
+  // Only the downloads which fill the free slots start soon enough to
+  // use the connections before they time out in the pool.
+  auto& rgman = e->getRequestGroupMan();
+  auto maxConcurrent =
+      static_cast<size_t>(std::max(0, rgman->getMaxConcurrentDownloads()));
+  if (maxConcurrent <= rgman->getNumActive()) {
+    return;
+  }
+  auto numStart = maxConcurrent - rgman->getNumActive();
+  // (hostname, port) -> (secure, number of waiting downloads)
+  std::map<std::pair<std::string, uint16_t>, std::pair<bool, size_t>> origins;
+  for (auto& group : rgman->getReservedGroups()) {
+    if (numStart == 0) {
+      break;
+    }
+    // These are skipped when filling the free slots.
+    if (group->isPauseRequested() || !group->isDependencyResolved()) {
+      continue;
+    }
+    --numStart;
+    auto& fileEntries = group->getDownloadContext()->getFileEntries();
+    if (fileEntries.empty() ||
+        fileEntries[0]->getRemainingUris().empty()) {
+      continue;
+    }
+    uri::UriStruct us;
+    if (!uri::parse(us, fileEntries[0]->getRemainingUris().front())) {
+      continue;
+    }
+    bool secure = us.protocol == "https";
+    if (!secure && us.protocol != "http") {
+      continue;
+    }
+    // Connections through a proxy are pooled under the proxy's
+    // address, not the origin's.  Leave them alone.
+    auto& groupOption = group->getOption();
+    if (!groupOption->blank(PREF_ALL_PROXY) ||
+        !groupOption->blank(secure ? PREF_HTTPS_PROXY : PREF_HTTP_PROXY)) {
+      continue;
+    }
+    auto& origin = origins[std::make_pair(us.host, us.port)];
+    origin.first = secure;
+    ++origin.second;
+  }
+  auto timeout = std::chrono::seconds(option->getAsInt(PREF_CONNECT_TIMEOUT));
+  for (auto& origin : origins) {
+    auto& hostname = origin.first.first;
+    auto port = origin.first.second;
+    // Only pre-connect to the hosts already resolved.  Resolving here
+    // would block the event loop.
+    auto& addr = e->findCachedIPAddress(hostname, port);
+    if (addr.empty()) {
+      continue;
+    }
+    auto target = std::min(numConn, origin.second.second);
+    for (auto i = e->countPooledSocket(addr, port); i < target && budget > 0;
+         ++i, --budget) {
+      e->addCommand(make_unique<PreconnectCommand>(
+          e->newCUID(), e, hostname, addr, port, origin.second.first,
+          timeout));
+    }
+    if (budget == 0) {
+      break;
+    }
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,131 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "RdDiskCache.h"
+
+#include "WrDiskCache.h"
+#include "DiskAdaptor.h"
+#include "DlAbortEx.h"
+#include "LogFactory.h"
+#include "fmt.h"
+#include "message.h"
+
+namespace aria2 {
+
+RdDiskCache::RdDiskCache(size_t limit, const WrDiskCache* wrDiskCache)
+    : limit_(limit),
+      total_(0),
+      wrDiskCache_(wrDiskCache),
+      numHits_(0),
+      numMisses_(0)
+{
+}
+
+RdDiskCache::~RdDiskCache()
+{
+  A2_LOG_DEBUG(fmt("Read disk cache hits=%" PRIu64 ", misses=%" PRIu64,
+                   numHits_, numMisses_));
+}
+
+const unsigned char* RdDiskCache::get(a2_gid_t gid, size_t index,
+                                      int64_t offset, size_t length,
+                                      DiskAdaptor* diskAdaptor)
+{
+  auto key = Key(gid, index);
+  auto i = index_.find(key);
+  if (i != std::end(index_)) {
+    ++numHits_;
+    entries_.splice(std::begin(entries_), entries_, (*i).second);
+    return (*i).second->data.data();
+  }
+  ++numMisses_;
+  // Don't let one piece take most of the cache.
+  if (length > limit_ / 4) {
+    return nullptr;
+  }
+  ensureLimit(length);
+  if (wrDiskCache_ && wrDiskCache_->getSize() + length > limit_) {
+    return nullptr;
+  }
+  std::vector<unsigned char> data(length);
+  auto r = diskAdaptor->readData(data.data(), length, offset);
+  if (r != static_cast<ssize_t>(length)) {
+    throw DL_ABORT_EX(EX_DATA_READ);
+  }
+  entries_.push_front(Entry{key, std::move(data)});
+  index_.insert(std::make_pair(key, std::begin(entries_)));
+  total_ += length;
+  A2_LOG_DEBUG(fmt("Cached piece gid=%s, index=%lu, size=%lu",
+                   GroupId::toHex(gid).c_str(),
+                   static_cast<unsigned long>(index),
+                   static_cast<unsigned long>(length)));
+  return entries_.front().data.data();
+}
+
+void RdDiskCache::remove(a2_gid_t gid)
+{
+  for (auto i = index_.lower_bound(Key(gid, 0));
+       i != std::end(index_) && (*i).first.first == gid;) {
+    total_ -= (*i).second->data.size();
+    entries_.erase((*i).second);
+    index_.erase(i++);
+  }
+}
+
+void RdDiskCache::remove(a2_gid_t gid, size_t index)
+{
+  auto i = index_.find(Key(gid, index));
+  if (i == std::end(index_)) {
+    return;
+  }
+  A2_LOG_DEBUG(fmt("Removed cached piece gid=%s, index=%lu",
+                   GroupId::toHex(gid).c_str(),
+                   static_cast<unsigned long>(index)));
+  total_ -= (*i).second->data.size();
+  entries_.erase((*i).second);
+  index_.erase(i);
+}
+
+void RdDiskCache::ensureLimit(size_t size)
+{
+  size_t wrSize = wrDiskCache_ ? wrDiskCache_->getSize() : 0;
+  while (!entries_.empty() && total_ + wrSize + size > limit_) {
+    auto& ent = entries_.back();
+    total_ -= ent.data.size();
+    index_.erase(ent.key);
+    entries_.pop_back();
+  }
+}
+
+} // namespace aria2
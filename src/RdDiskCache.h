@@ -0,0 +1,117 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_RD_DISK_CACHE_H
+#define D_RD_DISK_CACHE_H
+
+#include "common.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "GroupId.h"
+
+namespace aria2 {
+
+class DiskAdaptor;
+class WrDiskCache;
+
+// RdDiskCache caches the data of whole pieces read from disk to serve
+// the block requests from peers while seeding.  The least recently
+// used pieces are evicted first.  The memory is shared with
+// WrDiskCache: the total size of both caches is kept under the limit,
+// and data in WrDiskCache takes precedence.
+class RdDiskCache {
+public:
+  // |wrDiskCache| may be nullptr.
+  RdDiskCache(size_t limit, const WrDiskCache* wrDiskCache);
+  ~RdDiskCache();
+
+  // Returns the data of the piece |index| of the download |gid|,
+  // which is |length| bytes at |offset| in |diskAdaptor|.  On cache
+  // miss, the whole piece is read from |diskAdaptor|.  Returns
+  // nullptr if the piece is too large to be cached.  Throws
+  // DlAbortEx if the piece cannot be read.
+  const unsigned char* get(a2_gid_t gid, size_t index, int64_t offset,
+                           size_t length, DiskAdaptor* diskAdaptor);
+
+  // Removes all pieces of the download |gid|.
+  void remove(a2_gid_t gid);
+
+  // Removes the piece |index| of the download |gid|.  Call this when
+  // the piece is written again or becomes missing.
+  void remove(a2_gid_t gid, size_t index);
+
+  // Evicts least recently used pieces until the total size of this
+  // cache and WrDiskCache fits in the limit.  WrDiskCache calls this
+  // whenever its size changes.
+  void ensureLimit() { ensureLimit(0); }
+
+  size_t getSize() const { return total_; }
+
+  size_t countPieces() const { return index_.size(); }
+
+  uint64_t getNumHits() const { return numHits_; }
+
+  uint64_t getNumMisses() const { return numMisses_; }
+
+private:
+  typedef std::pair<a2_gid_t, size_t> Key;
+
+  struct Entry {
+    Key key;
+    std::vector<unsigned char> data;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  // Evicts least recently used pieces until |size| more bytes fit in
+  // the limit.
+  void ensureLimit(size_t size);
+
+  size_t limit_;
+  // Current number of bytes cached.
+  size_t total_;
+  const WrDiskCache* wrDiskCache_;
+  // The most recently used piece comes first.
+  EntryList entries_;
+  std::map<Key, EntryList::iterator> index_;
+  uint64_t numHits_;
+  uint64_t numMisses_;
+};
+
+} // namespace aria2
+
+#endif // D_RD_DISK_CACHE_H
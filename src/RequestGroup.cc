@@ -59,6 +59,7 @@
 #include "DlAbortEx.h"
 #include "DownloadFailureException.h"
 #include "RequestGroupMan.h"
+#include "RdDiskCache.h"
 #include "DefaultBtProgressInfoFile.h"
 #include "DefaultPieceStorage.h"
 #include "download_handlers.h"
@@ -81,6 +82,7 @@
 #include "RequestGroupCriteria.h"
 #include "CheckIntegrityCommand.h"
 #include "ChecksumCheckIntegrityEntry.h"
+#include "DefaultDiskWriterFactory.h"
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #  include "BtRegistry.h"
@@ -596,10 +598,18 @@ void RequestGroup::initPieceStorage()
 #endif // !ENABLE_BITTORRENT
     if (requestGroupMan_) {
       ps->setWrDiskCache(requestGroupMan_->getWrDiskCache());
+      ps->setRdDiskCache(requestGroupMan_->getRdDiskCache());
     }
     if (diskWriterFactory_) {
       ps->setDiskWriterFactory(diskWriterFactory_);
     }
+#ifdef HAVE_IO_URING
+    else if (requestGroupMan_ &&
+             option_->getAsBool(PREF_ENABLE_DISK_IO_URING)) {
+      ps->setDiskWriterFactory(std::make_shared<DefaultDiskWriterFactory>(
+          requestGroupMan_->getDiskIoUring()));
+    }
+#endif // HAVE_IO_URING
     tempPieceStorage = ps;
   }
   else {
@@ -1002,6 +1012,9 @@ void RequestGroup::setHaltRequested(bool f, HaltReason haltReason)
   if (haltRequested_) {
     pauseRequested_ = false;
     haltReason_ = haltReason;
+    if (requestGroupMan_) {
+      requestGroupMan_->requestWakeup(getGID());
+    }
   }
 #ifdef ENABLE_BITTORRENT
   if (btRuntime_) {
@@ -1022,6 +1035,11 @@ void RequestGroup::setRestartRequested(bool f) { restartRequested_ = f; }
 
 void RequestGroup::releaseRuntimeResource(DownloadEngine* e)
 {
+  if (pieceStorage_) {
+    // The callbacks of the verification refer to the objects released
+    // below.
+    pieceStorage_->cancelPieceVerification();
+  }
 #ifdef ENABLE_BITTORRENT
   e->getBtRegistry()->remove(gid_->getNumericId());
   btRuntime_ = nullptr;
@@ -1029,6 +1047,9 @@ void RequestGroup::releaseRuntimeResource(DownloadEngine* e)
 #endif // ENABLE_BITTORRENT
   if (pieceStorage_) {
     pieceStorage_->removeAdvertisedPiece(Timer::zero());
+    if (pieceStorage_->getRdDiskCache()) {
+      pieceStorage_->getRdDiskCache()->remove(gid_->getNumericId());
+    }
   }
   // Don't reset segmentMan_ and pieceStorage_ here to provide
   // progress information via RPC
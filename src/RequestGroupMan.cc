@@ -78,6 +78,7 @@
 #include "Notifier.h"
 #include "PeerStat.h"
 #include "WrDiskCache.h"
+#include "RdDiskCache.h"
 #include "PieceStorage.h"
 #include "DiskAdaptor.h"
 #include "SimpleRandomizer.h"
@@ -88,6 +89,9 @@
 #ifdef ENABLE_BITTORRENT
 #  include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
+#ifdef HAVE_IO_URING
+#  include "DiskIoUring.h"
+#endif // HAVE_IO_URING
 
 namespace aria2 {
 
@@ -131,7 +135,14 @@ RequestGroupMan::RequestGroupMan(
                       requestGroups.end());
 }
 
-RequestGroupMan::~RequestGroupMan() { openedFileCounter_->deactivate(); }
+RequestGroupMan::~RequestGroupMan()
+{
+  openedFileCounter_->deactivate();
+  if (wrDiskCache_) {
+    // rdDiskCache_ is destroyed first.
+    wrDiskCache_->setRdDiskCache(nullptr);
+  }
+}
 
 bool RequestGroupMan::setupOptimizeConcurrentDownloads(void)
 {
@@ -480,6 +491,9 @@ void RequestGroupMan::removeStoppedGroup(DownloadEngine* e)
   if (numRemoved > 0) {
     A2_LOG_DEBUG(fmt("%lu RequestGroup(s) deleted.",
                      static_cast<unsigned long>(numRemoved)));
+    // The commands which wait for an event might have to exit, for
+    // example, if all downloads have finished.
+    e->setRefreshInterval(std::chrono::milliseconds(0));
   }
 }
 
@@ -989,6 +1003,11 @@ bool RequestGroupMan::doesOverallDownloadSpeedExceed()
          maxOverallDownloadSpeedLimit_ < netStat_.calculateDownloadSpeed();
 }
 
+bool RequestGroupMan::isWriteQueueFull() const
+{
+  return wrDiskCache_ && wrDiskCache_->isWriteQueueFull();
+}
+
 bool RequestGroupMan::doesOverallUploadSpeedExceed()
 {
   return maxOverallUploadSpeedLimit_ > 0 &&
@@ -1051,8 +1070,20 @@ void RequestGroupMan::initWrDiskCache()
   size_t limit = option_->getAsInt(PREF_DISK_CACHE);
   if (limit > 0) {
     wrDiskCache_ = make_unique<WrDiskCache>(limit);
+    rdDiskCache_ = make_unique<RdDiskCache>(limit, wrDiskCache_.get());
+    wrDiskCache_->setRdDiskCache(rdDiskCache_.get());
+  }
+}
+
+#ifdef HAVE_IO_URING
+const std::shared_ptr<DiskIoUring>& RequestGroupMan::getDiskIoUring()
+{
+  if (!diskIoUring_) {
+    diskIoUring_ = std::make_shared<DiskIoUring>();
   }
+  return diskIoUring_;
 }
+#endif // HAVE_IO_URING
 
 void RequestGroupMan::decreaseNumActive()
 {
@@ -60,6 +60,8 @@ class Option;
 class OutputFile;
 class UriListParser;
 class WrDiskCache;
+class DiskIoUring;
+class RdDiskCache;
 class OpenedFileCounter;
 
 typedef IndexedList<a2_gid_t, std::shared_ptr<RequestGroup>> RequestGroupList;
@@ -107,6 +109,9 @@ private:
 
   bool queueCheck_;
 
+  // GIDs of the downloads whose sleeping commands should be woken up.
+  std::vector<a2_gid_t> wakeupRequests_;
+
   // The number of error DownloadResult removed because of upper limit
   // of the queue
   int removedErrorResult_;
@@ -120,9 +125,15 @@ private:
   std::shared_ptr<UriListParser> uriListParser_;
 
   std::unique_ptr<WrDiskCache> wrDiskCache_;
+  // Declared after wrDiskCache_, since this refers to it.
+  std::unique_ptr<RdDiskCache> rdDiskCache_;
 
   std::shared_ptr<OpenedFileCounter> openedFileCounter_;
 
+#ifdef HAVE_IO_URING
+  std::shared_ptr<DiskIoUring> diskIoUring_;
+#endif // HAVE_IO_URING
+
   // The number of stopped downloads so far in total, including
   // evicted DownloadResults.
   size_t numStoppedTotal_;
@@ -291,6 +302,10 @@ public:
   // maxOverallDownloadSpeedLimit_ == 0.  Otherwise returns false.
   bool doesOverallDownloadSpeedExceed();
 
+  // Returns true if the data being written asynchronously reaches
+  // the limit.  Downloads should stop receiving data until it drains.
+  bool isWriteQueueFull() const;
+
   void setMaxOverallDownloadSpeedLimit(int speed)
   {
     maxOverallDownloadSpeedLimit_ = speed;
@@ -318,6 +333,10 @@ public:
 
   void setMaxConcurrentDownloads(int max) { maxConcurrentDownloads_ = max; }
 
+  int getMaxConcurrentDownloads() const { return maxConcurrentDownloads_; }
+
+  size_t getNumActive() const { return numActive_; }
+
   // Call this function if requestGroups_ queue should be maintained.
   // This function is added to reduce the call of maintenance, but at
   // the same time, it provides fast maintenance reaction.
@@ -327,6 +346,21 @@ public:
 
   bool queueCheckRequested() const { return queueCheck_; }
 
+  // Call this function if the commands of the download identified by
+  // gid should notice the change of its state, e.g., halt, as soon as
+  // possible.  DownloadEngine wakes up the commands sleeping in its
+  // timer and lets the others check the state.
+  void requestWakeup(a2_gid_t gid) { wakeupRequests_.push_back(gid); }
+
+  // Returns the GIDs passed to requestWakeup() so far, and forgets
+  // them.
+  std::vector<a2_gid_t> takeWakeupRequests()
+  {
+    std::vector<a2_gid_t> res;
+    res.swap(wakeupRequests_);
+    return res;
+  }
+
   // Returns currently used hosts and its use count.
   void getUsedHosts(std::vector<std::pair<size_t, std::string>>& usedHosts);
 
@@ -343,10 +377,19 @@ public:
 
   WrDiskCache* getWrDiskCache() const { return wrDiskCache_.get(); }
 
-  // Initializes WrDiskCache according to PREF_DISK_CACHE option.  If
-  // its value is 0, cache storage will not be initialized.
+  RdDiskCache* getRdDiskCache() const { return rdDiskCache_.get(); }
+
+  // Initializes WrDiskCache and RdDiskCache according to
+  // PREF_DISK_CACHE option.  Both caches share the limit.  If its
+  // value is 0, cache storage will not be initialized.
   void initWrDiskCache();
 
+#ifdef HAVE_IO_URING
+  // Returns the io_uring shared by the downloads with
+  // --enable-disk-io-uring.  It is created on first use.
+  const std::shared_ptr<DiskIoUring>& getDiskIoUring();
+#endif // HAVE_IO_URING
+
   void setKeepRunning(bool flag) { keepRunning_ = flag; }
 
   bool getKeepRunning() const { return keepRunning_; }
@@ -46,6 +46,9 @@
 #include "OptionHandler.h"
 #include "DownloadEngine.h"
 #include "RequestGroup.h"
+#include "RdDiskCache.h"
+#include "WrDiskCacheEntry.h"
+#include "SlabPool.h"
 #include "download_helper.h"
 #include "util.h"
 #include "fmt.h"
@@ -78,6 +81,11 @@
 #  include "BtAnnounce.h"
 #endif // ENABLE_BITTORRENT
 #include "CheckIntegrityEntry.h"
+#ifdef ENABLE_SSL
+#  include "SocketCore.h"
+#  include "TLSContext.h"
+#  include "TLSSessionCache.h"
+#endif // ENABLE_SSL
 
 namespace aria2 {
 
@@ -125,6 +133,8 @@ const char KEY_SELECTED[] = "selected";
 const char KEY_LENGTH[] = "length";
 const char KEY_URI[] = "uri";
 const char KEY_CURRENT_URI[] = "currentUri";
+const char KEY_TLS_SESSION_HITS[] = "tlsSessionHits";
+const char KEY_TLS_SESSION_MISSES[] = "tlsSessionMisses";
 const char KEY_VERSION[] = "version";
 const char KEY_ENABLED_FEATURES[] = "enabledFeatures";
 const char KEY_METHOD_NAME[] = "methodName";
@@ -145,6 +155,10 @@ const char KEY_NUM_WAITING[] = "numWaiting";
 const char KEY_NUM_STOPPED[] = "numStopped";
 const char KEY_NUM_ACTIVE[] = "numActive";
 const char KEY_NUM_STOPPED_TOTAL[] = "numStoppedTotal";
+const char KEY_READ_CACHE_HITS[] = "readCacheHits";
+const char KEY_READ_CACHE_MISSES[] = "readCacheMisses";
+const char KEY_CACHE_BLOCKS_LIVE[] = "cacheBlocksLive";
+const char KEY_CACHE_BLOCKS_FREE[] = "cacheBlocksFree";
 const char KEY_VERIFIED_LENGTH[] = "verifiedLength";
 const char KEY_VERIFY_PENDING[] = "verifyIntegrityPending";
 } // namespace
@@ -798,14 +812,13 @@ void gatherProgress(Dict* entryDict, const std::shared_ptr<RequestGroup>& group,
   }
 #endif // ENABLE_BITTORRENT
   if (e->getCheckIntegrityMan()) {
-    if (e->getCheckIntegrityMan()->isPicked(
-            [&group](const CheckIntegrityEntry& ent) {
-              return ent.getRequestGroup() == group.get();
-            })) {
-      entryDict->put(
-          KEY_VERIFIED_LENGTH,
-          util::itos(
-              e->getCheckIntegrityMan()->getPickedEntry()->getCurrentLength()));
+    auto entry = e->getCheckIntegrityMan()->findPicked(
+        [&group](const CheckIntegrityEntry& ent) {
+          return ent.getRequestGroup() == group.get();
+        });
+    if (entry) {
+      entryDict->put(KEY_VERIFIED_LENGTH,
+                     util::itos(entry->getCurrentLength()));
     }
     if (e->getCheckIntegrityMan()->isQueued(
             [&group](const CheckIntegrityEntry& ent) {
@@ -1284,6 +1297,16 @@ std::unique_ptr<ValueBase> GetServersRpcMethod::process(const RpcRequest& req,
         serverEntry->put(KEY_CURRENT_URI, req->getCurrentUri());
         serverEntry->put(KEY_DOWNLOAD_SPEED,
                          util::itos(ps->calculateDownloadSpeed()));
+#ifdef ENABLE_SSL
+        const auto& tlsContext = SocketCore::getClientTLSContext();
+        if (req->getProtocol() == "https" && tlsContext &&
+            tlsContext->getSessionCache()) {
+          auto stat = tlsContext->getSessionCache()->getStat(
+              TLSSessionCache::makeKey(req->getHost(), req->getPort()));
+          serverEntry->put(KEY_TLS_SESSION_HITS, util::uitos(stat.hits));
+          serverEntry->put(KEY_TLS_SESSION_MISSES, util::uitos(stat.misses));
+        }
+#endif // ENABLE_SSL
         servers->append(std::move(serverEntry));
       }
     }
@@ -1347,6 +1370,10 @@ std::unique_ptr<ValueBase> ChangeUriRpcMethod::process(const RpcRequest& req,
     e->addCommand(std::move(commands));
     group->getSegmentMan()->recognizeSegmentFor(s);
   }
+  if (delcount) {
+    // Let the commands using the removed URIs notice it.
+    e->setRefreshInterval(std::chrono::milliseconds(0));
+  }
   auto res = List::g();
   res->append(Integer::g(delcount));
   res->append(Integer::g(addcount));
@@ -1390,6 +1417,14 @@ GetGlobalStatRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
   res->put(KEY_NUM_STOPPED, util::uitos(rgman->getDownloadResults().size()));
   res->put(KEY_NUM_STOPPED_TOTAL, util::uitos(rgman->getNumStoppedTotal()));
   res->put(KEY_NUM_ACTIVE, util::uitos(rgman->getRequestGroups().size()));
+  auto rdDiskCache = rgman->getRdDiskCache();
+  res->put(KEY_READ_CACHE_HITS,
+           util::uitos(rdDiskCache ? rdDiskCache->getNumHits() : 0));
+  res->put(KEY_READ_CACHE_MISSES,
+           util::uitos(rdDiskCache ? rdDiskCache->getNumMisses() : 0));
+  auto& pool = WrDiskCacheEntry::getDataPool();
+  res->put(KEY_CACHE_BLOCKS_LIVE, util::uitos(pool.countLive()));
+  res->put(KEY_CACHE_BLOCKS_FREE, util::uitos(pool.countFree()));
   return std::move(res);
 }
 
@@ -45,7 +45,7 @@ namespace aria2 {
 
 SaveSessionCommand::SaveSessionCommand(cuid_t cuid, DownloadEngine* e,
                                        std::chrono::seconds interval)
-    : TimeBasedCommand(cuid, e, std::move(interval), true)
+    : TimeBasedCommand(cuid, e, std::move(interval))
 {
 }
 
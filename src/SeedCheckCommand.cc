@@ -41,6 +41,8 @@
 #include "SeedCriteria.h"
 #include "message.h"
 #include "RequestGroup.h"
+#include "RequestGroupMan.h"
+#include "wallclock.h"
 #include "fmt.h"
 
 namespace aria2 {
@@ -54,7 +56,6 @@ SeedCheckCommand::SeedCheckCommand(cuid_t cuid, RequestGroup* requestGroup,
       seedCriteria_(std::move(seedCriteria)),
       checkStarted_(false)
 {
-  setStatusRealtime();
   requestGroup_->increaseNumCommand();
 }
 
@@ -78,9 +79,15 @@ bool SeedCheckCommand::execute()
     if (seedCriteria_->evaluate()) {
       A2_LOG_NOTICE(MSG_SEEDING_END);
       btRuntime_->setHalt(true);
+      e_->getRequestGroupMan()->requestWakeup(requestGroup_->getGID());
     }
   }
-  e_->addCommand(std::unique_ptr<Command>(this));
+  // Seed criteria are evaluated once a second.  Completion of the
+  // download wakes this command up earlier.
+  auto deadline = global::wallclock();
+  deadline.advance(1_s);
+  e_->addTimerCommand(std::unique_ptr<Command>(this), deadline,
+                      requestGroup_->getGID());
   return false;
 }
 
@@ -192,17 +192,17 @@ void SelectEventPoll::poll(const struct timeval& tv)
   }
 
 #endif // ENABLE_ASYNC_DNS
+  // Do not retry on EINTR, so that DownloadEngine notices the signal
+  // without waiting for the timeout.
   int retval;
-  do {
-    struct timeval ttv = tv;
+  struct timeval ttv = tv;
 #ifdef __MINGW32__
-    // winsock will report non-blocking connect() errors in efds,
-    // unlike posix, which will mark such sockets as writable.
-    retval = select(fdmax_ + 1, &rfds, &wfds, &efds, &ttv);
+  // winsock will report non-blocking connect() errors in efds,
+  // unlike posix, which will mark such sockets as writable.
+  retval = select(fdmax_ + 1, &rfds, &wfds, &efds, &ttv);
 #else  // !__MINGW32__
-    retval = select(fdmax_ + 1, &rfds, &wfds, nullptr, &ttv);
+  retval = select(fdmax_ + 1, &rfds, &wfds, nullptr, &ttv);
 #endif // !__MINGW32__
-  } while (retval == -1 && errno == EINTR);
   if (retval > 0) {
     for (auto& i : socketEntries_) {
       auto& e = i.second;
@@ -223,8 +223,13 @@ void SelectEventPoll::poll(const struct timeval& tv)
   }
   else if (retval == -1) {
     int errNum = errno;
-    A2_LOG_INFO(fmt("select error: %s, fdmax: %d",
-                    util::safeStrerror(errNum).c_str(), fdmax_));
+    if (errNum != EINTR) {
+      A2_LOG_INFO(fmt("select error: %s, fdmax: %d",
+                      util::safeStrerror(errNum).c_str(), fdmax_));
+    }
+    // The contents of fd_set are undefined on error.
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
   }
 #ifdef ENABLE_ASYNC_DNS
 
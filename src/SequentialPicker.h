@@ -38,31 +38,63 @@
 #include "common.h"
 
 #include <deque>
+#include <vector>
 #include <memory>
 #include <functional>
+#include <algorithm>
 
 namespace aria2 {
 
+// SequentialPicker picks queued entries in the order they were
+// pushed.  At most maxPicked entries can be picked at the same time.
 template <typename T> class SequentialPicker {
 private:
   std::deque<std::unique_ptr<T>> entries_;
-  std::unique_ptr<T> pickedEntry_;
+  // Picked entries in the order they were picked.
+  std::vector<std::unique_ptr<T>> pickedEntries_;
+  size_t maxPicked_;
 
 public:
-  bool isPicked() const { return pickedEntry_.get(); }
+  SequentialPicker(size_t maxPicked = 1) : maxPicked_(maxPicked) {}
 
-  const std::unique_ptr<T>& getPickedEntry() const { return pickedEntry_; }
+  bool isPicked() const { return !pickedEntries_.empty(); }
 
-  void dropPickedEntry() { pickedEntry_.reset(); }
+  // Returns true if there is a queued entry and less than maxPicked
+  // entries are picked.
+  bool canPickNext() const
+  {
+    return hasNext() && pickedEntries_.size() < maxPicked_;
+  }
+
+  // Returns the entry picked first among the picked ones, or nullptr.
+  T* getPickedEntry() const
+  {
+    return pickedEntries_.empty() ? nullptr : pickedEntries_.front().get();
+  }
+
+  const std::vector<std::unique_ptr<T>>& getPickedEntries() const
+  {
+    return pickedEntries_;
+  }
+
+  void dropPickedEntry(const T* entry)
+  {
+    auto i = std::find_if(
+        std::begin(pickedEntries_), std::end(pickedEntries_),
+        [entry](const std::unique_ptr<T>& e) { return e.get() == entry; });
+    if (i != std::end(pickedEntries_)) {
+      pickedEntries_.erase(i);
+    }
+  }
 
   bool hasNext() const { return !entries_.empty(); }
 
   T* pickNext()
   {
     if (hasNext()) {
-      pickedEntry_ = std::move(entries_.front());
+      pickedEntries_.push_back(std::move(entries_.front()));
       entries_.pop_front();
-      return pickedEntry_.get();
+      return pickedEntries_.back().get();
     }
     return nullptr;
   }
@@ -74,9 +106,22 @@ public:
 
   size_t countEntryInQueue() const { return entries_.size(); }
 
+  size_t getMaxPicked() const { return maxPicked_; }
+
+  // Returns the picked entry which satisfies |pred|, or nullptr.
+  T* findPicked(const std::function<bool(const T&)>& pred) const
+  {
+    for (auto& e : pickedEntries_) {
+      if (pred(*e)) {
+        return e.get();
+      }
+    }
+    return nullptr;
+  }
+
   bool isPicked(const std::function<bool(const T&)>& pred) const
   {
-    return pickedEntry_ && pred(*pickedEntry_);
+    return findPicked(pred);
   }
 
   bool isQueued(const std::function<bool(const T&)>& pred) const
@@ -65,6 +65,11 @@ public:
 
   virtual int64_t getTotalLength() CXX11_OVERRIDE { return totalLength_; }
 
+  virtual bool canAllocateInWorker() CXX11_OVERRIDE
+  {
+    return buffer_ != nullptr;
+  }
+
   /**
    * Must be called only once, before calling allocateChunk()
    */
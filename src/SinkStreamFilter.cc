@@ -40,7 +40,9 @@
 #include "BinaryStream.h"
 #include "Segment.h"
 #include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
 #include "Piece.h"
+#include "SocketRecvBuffer.h"
 
 namespace aria2 {
 
@@ -72,14 +74,14 @@ ssize_t SinkStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
       assert(wrDiskCache_);
       // If we receive small data (e.g., 1 or 2 bytes), cache entry
       // becomes a headache. To mitigate this problem, we allocate
-      // cache buffer at least 4KiB and append the data to the
+      // cache buffer at least 16KiB and append the data to the
       // contagious cache data.
       size_t alen = piece->appendWrCache(
           wrDiskCache_, segment->getPositionToWrite(), inbuf, wlen);
       if (alen < wlen) {
         size_t len = wlen - alen;
-        size_t capacity = std::max(len, static_cast<size_t>(4_k));
-        auto dataCopy = new unsigned char[capacity];
+        size_t capacity;
+        auto dataCopy = WrDiskCacheEntry::allocateData(len, capacity);
         memcpy(dataCopy, inbuf + alen, len);
         piece->updateWrCache(wrDiskCache_, dataCopy, 0, len, capacity,
                              segment->getPositionToWrite() + alen);
@@ -100,4 +102,79 @@ ssize_t SinkStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
   return bytesProcessed_;
 }
 
+ssize_t SinkStreamFilter::receive(SocketRecvBuffer* recvBuf,
+                                  const std::shared_ptr<Segment>& segment,
+                                  size_t maxlen)
+{
+  const std::shared_ptr<Piece>& piece = segment->getPiece();
+  assert(wrDiskCache_);
+  assert(piece->getWrDiskCacheEntry());
+  assert(segment->getLength() >= segment->getWrittenLength());
+  size_t lenAvail = segment->getLength() - segment->getWrittenLength();
+  // The capacity of recvBuf grows with the throughput of the
+  // connection, and we read as much data at once.
+  size_t rem = std::min(std::min(maxlen, lenAvail), recvBuf->getCapacity());
+  a2iovec iov[A2_IOV_MAX];
+  size_t iovcnt = 0;
+  size_t appendLen;
+  auto appendBuf = piece->getWrCacheAppendBuffer(segment->getPositionToWrite(),
+                                                 appendLen);
+  if (appendBuf) {
+    appendLen = std::min(appendLen, rem);
+    iov[iovcnt].A2IOVEC_BASE = reinterpret_cast<char*>(appendBuf);
+    iov[iovcnt].A2IOVEC_LEN = appendLen;
+    ++iovcnt;
+    rem -= appendLen;
+  }
+  // Like transform(), allocate cache buffer at least 16KiB so that
+  // following reads are appended to it.  One slot of iov is left for
+  // recvBuf.
+  size_t capacities[A2_IOV_MAX];
+  size_t firstCell = iovcnt;
+  for (; rem > 0 && iovcnt < A2_IOV_MAX - 1; ++iovcnt) {
+    auto data = WrDiskCacheEntry::allocateData(std::min<size_t>(rem, 16_k),
+                                               capacities[iovcnt]);
+    size_t len = std::min(capacities[iovcnt], rem);
+    iov[iovcnt].A2IOVEC_BASE = reinterpret_cast<char*>(data);
+    iov[iovcnt].A2IOVEC_LEN = len;
+    rem -= len;
+  }
+  size_t nread;
+  try {
+    nread = recvBuf->recv(iov, iovcnt);
+  }
+  catch (...) {
+    for (size_t i = firstCell; i < iovcnt; ++i) {
+      WrDiskCacheEntry::freeData(
+          reinterpret_cast<unsigned char*>(iov[i].A2IOVEC_BASE));
+    }
+    throw;
+  }
+  size_t left = nread;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    auto data = reinterpret_cast<unsigned char*>(iov[i].A2IOVEC_BASE);
+    size_t len = std::min<size_t>(iov[i].A2IOVEC_LEN, left);
+    if (i < firstCell) {
+      piece->commitWrCacheAppend(wrDiskCache_, len);
+    }
+    else if (len == 0) {
+      WrDiskCacheEntry::freeData(data);
+      continue;
+    }
+    else {
+      piece->updateWrCache(wrDiskCache_, data, 0, len, capacities[i],
+                           segment->getPositionToWrite());
+    }
+    if (len > 0) {
+      if (hashUpdate_) {
+        segment->updateHash(segment->getWrittenLength(), data, len);
+      }
+      segment->updateWrittenLength(len);
+      left -= len;
+    }
+  }
+  bytesProcessed_ = nread;
+  return bytesProcessed_;
+}
+
 } // namespace aria2
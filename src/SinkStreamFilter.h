@@ -40,6 +40,7 @@
 namespace aria2 {
 
 class WrDiskCache;
+class SocketRecvBuffer;
 
 class SinkStreamFilter : public StreamFilter {
 private:
@@ -57,6 +58,17 @@ public:
                             const unsigned char* inbuf,
                             size_t inlen) CXX11_OVERRIDE;
 
+  // Reads at most |maxlen| bytes from the socket of |recvBuf|
+  // directly into the write disk cache of the piece of |segment|,
+  // without copying them through |recvBuf|.  The data are read with
+  // one call to recvBuf->recv(), so if |maxlen| is less than the
+  // capacity of |recvBuf|, the data following them may be stored in
+  // |recvBuf|.  The piece must have WrDiskCacheEntry and
+  // segment->getLength() must be positive.  Returns the number of
+  // bytes written to the cache.
+  ssize_t receive(SocketRecvBuffer* recvBuf,
+                  const std::shared_ptr<Segment>& segment, size_t maxlen);
+
   virtual bool finished() CXX11_OVERRIDE { return true; }
 
   virtual void release() CXX11_OVERRIDE {}
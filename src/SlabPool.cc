@@ -0,0 +1,174 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "SlabPool.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "LogFactory.h"
+#include "Logger.h"
+#include "a2functional.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+SlabPool::SlabPool(size_t blockSize, size_t blocksPerSlab,
+                   size_t maxEmptySlabs)
+    : blockSize_(blockSize),
+      blocksPerSlab_(blocksPerSlab),
+      maxEmptySlabs_(maxEmptySlabs),
+      slabSize_(blockSize * blocksPerSlab),
+      numLive_(0),
+      numEmptySlabs_(0)
+{
+  assert(blockSize_ > 0);
+  assert(blocksPerSlab_ > 0);
+}
+
+SlabPool::~SlabPool()
+{
+  if (numLive_) {
+    A2_LOG_WARN(fmt("SlabPool is destroyed with %lu blocks in use",
+                    static_cast<unsigned long>(numLive_)));
+  }
+}
+
+unsigned char* SlabPool::allocate()
+{
+  if (available_.empty()) {
+    auto slab = make_unique<Slab>();
+    // Not value-initialized; blocks are overwritten by their users.
+    slab->mem.reset(new unsigned char[slabSize_]);
+    slab->freeBlocks.reserve(blocksPerSlab_);
+    for (size_t i = blocksPerSlab_; i > 0; --i) {
+      slab->freeBlocks.push_back(i - 1);
+    }
+    slab->available = true;
+    available_.push_back(slab.get());
+    ++numEmptySlabs_;
+    auto mem = slab->mem.get();
+    auto addr = reinterpret_cast<uintptr_t>(mem);
+    windows_.insert(std::make_pair(addr / slabSize_, slab.get()));
+    if (addr % slabSize_ != 0) {
+      windows_.insert(std::make_pair(addr / slabSize_ + 1, slab.get()));
+    }
+    slabs_.push_back(std::move(slab));
+    A2_LOG_DEBUG(fmt("SlabPool: allocated slab %p, slabs=%lu, live=%lu",
+                     mem, static_cast<unsigned long>(slabs_.size()),
+                     static_cast<unsigned long>(numLive_)));
+  }
+  auto slab = available_.back();
+  if (slab->freeBlocks.size() == blocksPerSlab_) {
+    --numEmptySlabs_;
+  }
+  auto index = slab->freeBlocks.back();
+  slab->freeBlocks.pop_back();
+  if (slab->freeBlocks.empty()) {
+    slab->available = false;
+    available_.pop_back();
+  }
+  ++numLive_;
+  return slab->mem.get() + index * blockSize_;
+}
+
+bool SlabPool::deallocate(unsigned char* p)
+{
+  auto addr = reinterpret_cast<uintptr_t>(p);
+  auto range = windows_.equal_range(addr / slabSize_);
+  Slab* slab = nullptr;
+  size_t off = 0;
+  for (auto i = range.first; i != range.second; ++i) {
+    // Wraps around if p is below the slab.
+    off = addr - reinterpret_cast<uintptr_t>((*i).second->mem.get());
+    if (off < slabSize_) {
+      slab = (*i).second;
+      break;
+    }
+  }
+  if (!slab) {
+    return false;
+  }
+  assert(off % blockSize_ == 0);
+  slab->freeBlocks.push_back(off / blockSize_);
+  --numLive_;
+  if (!slab->available) {
+    slab->available = true;
+    available_.push_back(slab);
+  }
+  if (slab->freeBlocks.size() == blocksPerSlab_) {
+    if (numEmptySlabs_ < maxEmptySlabs_) {
+      ++numEmptySlabs_;
+    }
+    else {
+      releaseSlab(slab);
+    }
+  }
+  return true;
+}
+
+void SlabPool::releaseSlab(Slab* slab)
+{
+  auto mem = slab->mem.get();
+  auto addr = reinterpret_cast<uintptr_t>(mem);
+  for (auto key : {addr / slabSize_, addr / slabSize_ + 1}) {
+    auto range = windows_.equal_range(key);
+    for (auto i = range.first; i != range.second; ++i) {
+      if ((*i).second == slab) {
+        windows_.erase(i);
+        break;
+      }
+    }
+  }
+  available_.erase(
+      std::find(std::begin(available_), std::end(available_), slab));
+  slabs_.erase(std::find_if(std::begin(slabs_), std::end(slabs_),
+                            [slab](const std::unique_ptr<Slab>& s) {
+                              return s.get() == slab;
+                            }));
+  A2_LOG_DEBUG(fmt("SlabPool: released slab %p, slabs=%lu, live=%lu", mem,
+                   static_cast<unsigned long>(slabs_.size()),
+                   static_cast<unsigned long>(numLive_)));
+}
+
+size_t SlabPool::countLive() const { return numLive_; }
+
+size_t SlabPool::countFree() const
+{
+  return slabs_.size() * blocksPerSlab_ - numLive_;
+}
+
+size_t SlabPool::countSlabs() const { return slabs_.size(); }
+
+} // namespace aria2
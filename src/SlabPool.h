@@ -0,0 +1,116 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_SLAB_POOL_H
+#define D_SLAB_POOL_H
+
+#include "common.h"
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+namespace aria2 {
+
+// SlabPool hands out memory blocks of fixed size, which are carved
+// out of larger slabs.  Freed blocks are reused, so that buffers
+// which are allocated and freed at high rate do not hit the general
+// purpose allocator nor fragment the heap.  A slab is released when
+// all its blocks are freed, except for a few slabs kept for reuse.
+// This class is not thread-safe.  Use it only from the event loop
+// thread.
+class SlabPool {
+public:
+  // Creates the pool of |blockSize| bytes blocks.  Each slab holds
+  // |blocksPerSlab| blocks.  At most |maxEmptySlabs| slabs are kept
+  // when all their blocks are freed.
+  SlabPool(size_t blockSize, size_t blocksPerSlab, size_t maxEmptySlabs);
+
+  ~SlabPool();
+
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+
+  // Returns a block of getBlockSize() bytes.
+  unsigned char* allocate();
+
+  // Returns |p| to the pool and returns true if |p| was allocated by
+  // allocate().  Otherwise, returns false and does nothing.  This
+  // function runs in constant time.
+  bool deallocate(unsigned char* p);
+
+  size_t getBlockSize() const { return blockSize_; }
+
+  // Returns the number of blocks in use.
+  size_t countLive() const;
+
+  // Returns the number of blocks which are allocated from the system
+  // but not in use.
+  size_t countFree() const;
+
+  // Returns the number of slabs allocated from the system.
+  size_t countSlabs() const;
+
+private:
+  struct Slab {
+    std::unique_ptr<unsigned char[]> mem;
+    // Indexes of the free blocks in this slab.
+    std::vector<uint32_t> freeBlocks;
+    // True if this slab is in available_.
+    bool available;
+  };
+
+  void releaseSlab(Slab* slab);
+
+  size_t blockSize_;
+  size_t blocksPerSlab_;
+  size_t maxEmptySlabs_;
+  // blockSize_ * blocksPerSlab_
+  size_t slabSize_;
+
+  std::vector<std::unique_ptr<Slab>> slabs_;
+  // Slabs keyed by the index of the slabSize_ bytes windows of the
+  // address space which they overlap.  A slab overlaps at most 2
+  // windows and a window overlaps at most 2 slabs, so that the slab
+  // of a block is found without searching all slabs.
+  std::unordered_multimap<uintptr_t, Slab*> windows_;
+  // Slabs which have at least one free block.
+  std::vector<Slab*> available_;
+  size_t numLive_;
+  size_t numEmptySlabs_;
+};
+
+} // namespace aria2
+
+#endif // D_SLAB_POOL_H
@@ -43,6 +43,7 @@
 #include "fmt.h"
 #include "LogFactory.h"
 #include "a2functional.h"
+#include "SharedFd.h"
 
 namespace aria2 {
 
@@ -102,6 +103,37 @@ const unsigned char* SocketBuffer::StringBufEntry::getData() const
   return reinterpret_cast<const unsigned char*>(str_.c_str());
 }
 
+SocketBuffer::FileBufEntry::FileBufEntry(
+    std::shared_ptr<SharedFd> fd, int64_t offset, size_t length,
+    std::unique_ptr<ProgressUpdate> progressUpdate)
+    : BufEntry(std::move(progressUpdate)),
+      fd_(std::move(fd)),
+      offset_(offset),
+      length_(length)
+{
+}
+
+SocketBuffer::FileBufEntry::~FileBufEntry() = default;
+
+ssize_t
+SocketBuffer::FileBufEntry::send(const std::shared_ptr<SocketCore>& socket,
+                                 size_t offset)
+{
+  return socket->sendFile(fd_->get(), offset_ + offset, length_ - offset);
+}
+
+bool SocketBuffer::FileBufEntry::final(size_t offset) const
+{
+  return length_ <= offset;
+}
+
+size_t SocketBuffer::FileBufEntry::getLength() const { return length_; }
+
+const unsigned char* SocketBuffer::FileBufEntry::getData() const
+{
+  return nullptr;
+}
+
 SocketBuffer::SocketBuffer(std::shared_ptr<SocketCore> socket)
     : socket_(std::move(socket)), offset_(0)
 {
@@ -127,6 +159,17 @@ void SocketBuffer::pushStr(std::string data,
   }
 }
 
+void SocketBuffer::pushFile(std::shared_ptr<SharedFd> fd, int64_t offset,
+                            size_t length,
+                            std::unique_ptr<ProgressUpdate> progressUpdate)
+{
+  if (length == 0) {
+    return;
+  }
+  bufq_.push_back(make_unique<FileBufEntry>(std::move(fd), offset, length,
+                                            std::move(progressUpdate)));
+}
+
 ssize_t SocketBuffer::send()
 {
   a2iovec iov[A2_IOV_MAX];
@@ -136,27 +179,34 @@ ssize_t SocketBuffer::send()
     size_t bufqlen = bufq_.size();
     ssize_t amount = 24_k;
     ssize_t firstlen = bufq_.front()->getLength() - offset_;
-    amount -= firstlen;
-    iov[0].A2IOVEC_BASE = reinterpret_cast<char*>(
-        const_cast<unsigned char*>(bufq_.front()->getData() + offset_));
-    iov[0].A2IOVEC_LEN = firstlen;
+    ssize_t slen;
     num = 1;
-    for (auto i = std::begin(bufq_) + 1, eoi = std::end(bufq_);
-         i != eoi && num < A2_IOV_MAX && num < bufqlen && amount > 0;
-         ++i, ++num) {
-
-      ssize_t len = (*i)->getLength();
-
-      if (amount < len) {
-        break;
+    if (!bufq_.front()->getData()) {
+      // The data is in a file.  It cannot be put in iovec.
+      slen = bufq_.front()->send(socket_, offset_);
+    }
+    else {
+      amount -= firstlen;
+      iov[0].A2IOVEC_BASE = reinterpret_cast<char*>(
+          const_cast<unsigned char*>(bufq_.front()->getData() + offset_));
+      iov[0].A2IOVEC_LEN = firstlen;
+      for (auto i = std::begin(bufq_) + 1, eoi = std::end(bufq_);
+           i != eoi && num < A2_IOV_MAX && num < bufqlen && amount > 0;
+           ++i, ++num) {
+
+        ssize_t len = (*i)->getLength();
+
+        if (amount < len || !(*i)->getData()) {
+          break;
+        }
+
+        amount -= len;
+        iov[num].A2IOVEC_BASE = reinterpret_cast<char*>(
+            const_cast<unsigned char*>((*i)->getData()));
+        iov[num].A2IOVEC_LEN = len;
       }
-
-      amount -= len;
-      iov[num].A2IOVEC_BASE =
-          reinterpret_cast<char*>(const_cast<unsigned char*>((*i)->getData()));
-      iov[num].A2IOVEC_LEN = len;
+      slen = socket_->writeVector(iov, num);
     }
-    ssize_t slen = socket_->writeVector(iov, num);
     if (slen == 0 && !socket_->wantRead() && !socket_->wantWrite()) {
       throw DL_ABORT_EX(fmt(EX_SOCKET_SEND, "Connection closed."));
     }
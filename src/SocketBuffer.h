@@ -45,6 +45,7 @@
 namespace aria2 {
 
 class SocketCore;
+class SharedFd;
 
 struct ProgressUpdate {
   virtual ~ProgressUpdate() = default;
@@ -105,6 +106,25 @@ private:
     std::string str_;
   };
 
+  // The data in a file, which is sent with SocketCore::sendFile().
+  // getData() returns nullptr.
+  class FileBufEntry : public BufEntry {
+  public:
+    FileBufEntry(std::shared_ptr<SharedFd> fd, int64_t offset, size_t length,
+                 std::unique_ptr<ProgressUpdate> progressUpdate);
+    virtual ~FileBufEntry();
+    virtual ssize_t send(const std::shared_ptr<SocketCore>& socket,
+                         size_t offset) CXX11_OVERRIDE;
+    virtual bool final(size_t offset) const CXX11_OVERRIDE;
+    virtual size_t getLength() const CXX11_OVERRIDE;
+    virtual const unsigned char* getData() const CXX11_OVERRIDE;
+
+  private:
+    std::shared_ptr<SharedFd> fd_;
+    int64_t offset_;
+    size_t length_;
+  };
+
   std::shared_ptr<SocketCore> socket_;
 
   std::deque<std::unique_ptr<BufEntry>> bufq_;
@@ -137,6 +157,15 @@ public:
   void pushStr(std::string data,
                std::unique_ptr<ProgressUpdate> progressUpdate = nullptr);
 
+  // Feeds |length| bytes at |offset| in the file |fd| into queue.
+  // The data is sent directly from the file, so the caller must check
+  // that SocketCore::isSendFileAvailable() returns true.  This object
+  // holds a reference to |fd| until the data is sent.  If
+  // progressUpdate is not null, its update() function will be called
+  // each time the data is sent. It can be null.
+  void pushFile(std::shared_ptr<SharedFd> fd, int64_t offset, size_t length,
+                std::unique_ptr<ProgressUpdate> progressUpdate = nullptr);
+
   // Sends data in queue.  Returns the number of bytes sent.
   ssize_t send();
 
@@ -42,6 +42,10 @@
 #ifdef HAVE_IFADDRS_H
 #  include <ifaddrs.h>
 #endif // HAVE_IFADDRS_H
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+#  include <sys/sendfile.h>
+#  define A2_USE_SENDFILE 1
+#endif // HAVE_SENDFILE && HAVE_SYS_SENDFILE_H
 
 #include <cerrno>
 #include <cstring>
@@ -61,6 +65,7 @@
 #ifdef ENABLE_SSL
 #  include "TLSContext.h"
 #  include "TLSSession.h"
+#  include "TLSSessionCache.h"
 #endif // ENABLE_SSL
 #ifdef HAVE_LIBSSH2
 #  include "SSHSession.h"
@@ -753,6 +758,27 @@ bool SocketCore::isReadable(time_t timeout)
 #endif   // !HAVE_POLL
 }
 
+bool SocketCore::isIdleConnectionAlive()
+{
+  try {
+    if (getRecvBufferedLength() == 0 && !isReadable(0)) {
+      return true;
+    }
+#ifdef ENABLE_SSL
+    if (secure_ == A2_TLS_CONNECTED) {
+      char buf;
+      size_t len = 1;
+      readData(&buf, len);
+      return len == 0 && wantRead();
+    }
+#endif // ENABLE_SSL
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_DEBUG_EX("Idle connection is broken", e);
+  }
+  return false;
+}
+
 ssize_t SocketCore::writeVector(a2iovec* iov, size_t iovcnt)
 {
   ssize_t ret = 0;
@@ -796,6 +822,67 @@ ssize_t SocketCore::writeVector(a2iovec* iov, size_t iovcnt)
   return ret;
 }
 
+bool SocketCore::isSendFileAvailable() const
+{
+#ifdef A2_USE_SENDFILE
+  if (!secure_) {
+    return true;
+  }
+#  ifdef ENABLE_SSL
+  // With kernel TLS, the kernel encrypts the file data on the way.
+  return secure_ == A2_TLS_CONNECTED && tlsSession_->isKernelTLSSend();
+#  else  // !ENABLE_SSL
+  return false;
+#  endif // !ENABLE_SSL
+#else    // !A2_USE_SENDFILE
+  return false;
+#endif // !A2_USE_SENDFILE
+}
+
+ssize_t SocketCore::sendFile(int fd, int64_t offset, size_t len)
+{
+  wantRead_ = false;
+  wantWrite_ = false;
+#ifdef A2_USE_SENDFILE
+#  ifdef ENABLE_SSL
+  if (secure_) {
+    ssize_t ret = tlsSession_->sendFile(fd, offset, len);
+    if (ret < 0) {
+      if (ret != TLS_ERR_WOULDBLOCK) {
+        throw DL_RETRY_EX(
+            fmt(EX_SOCKET_SEND, tlsSession_->getLastErrorString().c_str()));
+      }
+      if (tlsSession_->checkDirection() == TLS_WANT_READ) {
+        wantRead_ = true;
+      }
+      else {
+        wantWrite_ = true;
+      }
+      ret = 0;
+    }
+    return ret;
+  }
+#  endif // ENABLE_SSL
+  off_t off = offset;
+  ssize_t ret;
+  while ((ret = sendfile(sockfd_, fd, &off, len)) == -1 &&
+         SOCKET_ERRNO == A2_EINTR)
+    ;
+  int errNum = SOCKET_ERRNO;
+  if (ret == -1) {
+    if (!A2_WOULDBLOCK(errNum)) {
+      throw DL_RETRY_EX(fmt(EX_SOCKET_SEND, errorMsg(errNum).c_str()));
+    }
+    wantWrite_ = true;
+    ret = 0;
+  }
+  return ret;
+#else  // !A2_USE_SENDFILE
+  assert(0);
+  return 0;
+#endif // !A2_USE_SENDFILE
+}
+
 ssize_t SocketCore::writeData(const void* data, size_t len)
 {
   ssize_t ret = 0;
@@ -899,19 +986,89 @@ void SocketCore::readData(void* data, size_t& len)
   len = ret;
 }
 
+ssize_t SocketCore::readVector(a2iovec* iov, size_t iovcnt)
+{
+  ssize_t ret = 0;
+  wantRead_ = false;
+  wantWrite_ = false;
+  if (!secure_
+#ifdef HAVE_LIBSSH2
+      && !sshSession_
+#endif // HAVE_LIBSSH2
+  ) {
+#ifdef __MINGW32__
+    DWORD nrecv;
+    DWORD flags = 0;
+    int rv = WSARecv(sockfd_, iov, iovcnt, &nrecv, &flags, 0, 0);
+    if (rv == 0) {
+      ret = nrecv;
+    }
+    else {
+      ret = -1;
+    }
+#else  // !__MINGW32__
+    while ((ret = readv(sockfd_, iov, iovcnt)) == -1 &&
+           SOCKET_ERRNO == A2_EINTR)
+      ;
+#endif // !__MINGW32__
+    int errNum = SOCKET_ERRNO;
+    if (ret == -1) {
+      if (!A2_WOULDBLOCK(errNum)) {
+        throw DL_RETRY_EX(fmt(EX_SOCKET_RECV, errorMsg(errNum).c_str()));
+      }
+      wantRead_ = true;
+      ret = 0;
+    }
+  }
+  else {
+    // For SSL/TLS and SSH, we could not use readv, so just iterate
+    // vector and read the data in normal way.  Only the first read
+    // may touch the socket; the following reads just take the data
+    // buffered in TLS layer.  Otherwise, EOF might be consumed
+    // together with the data preceding it, and we would never be
+    // notified of it.
+    for (size_t i = 0; i < iovcnt; ++i) {
+      if (i > 0 && getRecvBufferedLength() == 0) {
+        break;
+      }
+      size_t len = iov[i].A2IOVEC_LEN;
+      readData(iov[i].A2IOVEC_BASE, len);
+      ret += len;
+      if (len < static_cast<size_t>(iov[i].A2IOVEC_LEN)) {
+        break;
+      }
+    }
+  }
+  return ret;
+}
+
 #ifdef ENABLE_SSL
 
 bool SocketCore::tlsAccept()
 {
-  return tlsHandshake(svTlsContext_.get(), A2STR::NIL);
+  return tlsHandshake(svTlsContext_.get(), A2STR::NIL, 0);
 }
 
-bool SocketCore::tlsConnect(const std::string& hostname)
+bool SocketCore::tlsConnect(const std::string& hostname, uint16_t port)
 {
-  return tlsHandshake(clTlsContext_.get(), hostname);
+  return tlsHandshake(clTlsContext_.get(), hostname, port);
 }
 
-bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
+void SocketCore::setAlpnProtocols(std::vector<std::string> protocols)
+{
+  alpnProtocols_ = std::move(protocols);
+}
+
+std::string SocketCore::getAlpnProtocol() const
+{
+  if (secure_ != A2_TLS_CONNECTED) {
+    return A2STR::NIL;
+  }
+  return tlsSession_->getAlpnProtocol();
+}
+
+bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname,
+                              uint16_t port)
 {
   wantRead_ = false;
   wantWrite_ = false;
@@ -941,6 +1098,21 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
                               tlsSession_->getLastErrorString().c_str()));
       }
     }
+    if (tlsctx->getSide() == TLS_CLIENT && tlsctx->getSessionCache()) {
+      rv = tlsSession_->setSessionCacheKey(
+          TLSSessionCache::makeKey(hostname, port));
+      if (rv != TLS_ERR_OK) {
+        throw DL_ABORT_EX(fmt(EX_SSL_INIT_FAILURE,
+                              tlsSession_->getLastErrorString().c_str()));
+      }
+    }
+    if (tlsctx->getSide() == TLS_CLIENT && !alpnProtocols_.empty()) {
+      rv = tlsSession_->setAlpnProtocols(alpnProtocols_);
+      if (rv != TLS_ERR_OK) {
+        throw DL_ABORT_EX(fmt(EX_SSL_INIT_FAILURE,
+                              tlsSession_->getLastErrorString().c_str()));
+      }
+    }
     // Done with the setup, now let handshaking begin immediately.
     secure_ = A2_TLS_HANDSHAKING;
     A2_LOG_DEBUG("TLS Handshaking");
@@ -987,7 +1159,25 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
         break;
       }
 
-      // 3. We're connected now!
+      // 3. Account session resumption
+      if (tlsctx->getSide() == TLS_CLIENT && tlsctx->getSessionCache()) {
+        bool resumed = tlsSession_->isSessionResumed();
+        A2_LOG_DEBUG(fmt("TLS session %s for %s",
+                         resumed ? "resumed" : "not resumed",
+                         peerInfo.c_str()));
+        tlsctx->getSessionCache()->countHandshake(
+            TLSSessionCache::makeKey(hostname, port), resumed);
+      }
+
+      // 4. Report kernel TLS offload
+      if (tlsSession_->isKernelTLSSend() || tlsSession_->isKernelTLSRecv()) {
+        A2_LOG_DEBUG(fmt("Kernel TLS enabled for %s: send=%s, recv=%s",
+                         peerInfo.c_str(),
+                         tlsSession_->isKernelTLSSend() ? "yes" : "no",
+                         tlsSession_->isKernelTLSRecv() ? "yes" : "no"));
+      }
+
+      // 5. We're connected now!
       secure_ = A2_TLS_CONNECTED;
       return true;
     }
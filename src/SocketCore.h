@@ -93,13 +93,17 @@ private:
 
   std::shared_ptr<TLSSession> tlsSession_;
 
+  // Protocols offered in TLS ALPN extension on client side handshake
+  std::vector<std::string> alpnProtocols_;
+
   /**
    * Makes this socket secure. The connection must be established
    * before calling this method.
    *
    * If you are going to verify peer's certificate, hostname must be supplied.
    */
-  bool tlsHandshake(TLSContext* tlsctx, const std::string& hostname);
+  bool tlsHandshake(TLSContext* tlsctx, const std::string& hostname,
+                    uint16_t port);
 #endif // ENABLE_SSL
 
 #ifdef HAVE_LIBSSH2
@@ -241,6 +245,12 @@ public:
    */
   bool isReadable(time_t timeout);
 
+  // Returns true if this idle connection is still usable, that is the
+  // peer has neither closed it nor sent any data.  TLS records
+  // carrying no application data, such as TLS 1.3 session tickets,
+  // are consumed.
+  bool isIdleConnectionAlive();
+
   /**
    * Writes data into this socket. data is a pointer pointing the first
    * byte of the data and len is the length of data.
@@ -264,6 +274,17 @@ public:
 
   ssize_t writeVector(a2iovec* iov, size_t iovcnt);
 
+  // Returns true if sendFile() is available for this socket, that is,
+  // sendfile(2) is supported and this is not a TLS connection, or
+  // the TLS records are encrypted by the kernel.
+  bool isSendFileAvailable() const;
+
+  // Sends at most |len| bytes at |offset| in the file |fd| without
+  // copying them into user space.  Returns the number of bytes sent.
+  // If the socket gets EAGAIN, wantWrite_ is set.  This function must
+  // not be called unless isSendFileAvailable() returns true.
+  ssize_t sendFile(int fd, int64_t offset, size_t len);
+
   /**
    * Reads up to len bytes from this socket.
    * data is a pointer pointing the first
@@ -282,6 +303,14 @@ public:
    */
   void readData(void* data, size_t& len);
 
+  // Reads data into the buffers described by |iov| in order, using
+  // readv(2) for a plain connection.  For TLS and SSH connections,
+  // the buffers are filled by readData() one after another while the
+  // data buffered in TLS layer remain.  Returns the number of bytes
+  // read.  0 is returned on EOF, or if the socket gets EAGAIN, in
+  // which case wantRead_ or wantWrite_ is set.
+  ssize_t readVector(a2iovec* iov, size_t iovcnt);
+
   // sender.addr will be numerihost assigned.
   ssize_t readDataFrom(void* data, size_t len, Endpoint& sender);
 
@@ -294,8 +323,17 @@ public:
   // returns true. If handshake has not been done yet, returns false.
   //
   // If you are going to verify peer's certificate, hostname must be
-  // supplied.
-  bool tlsConnect(const std::string& hostname);
+  // supplied.  The hostname and |port| of the origin server identify
+  // the cached TLS session to resume.
+  bool tlsConnect(const std::string& hostname, uint16_t port);
+
+  // Sets protocols to offer in TLS ALPN extension.  This must be
+  // called before tlsConnect().
+  void setAlpnProtocols(std::vector<std::string> protocols);
+
+  // Returns the protocol negotiated by ALPN, or empty string if none
+  // was selected or handshake has not been completed.
+  std::string getAlpnProtocol() const;
 #endif // ENABLE_SSL
 
 #ifdef HAVE_LIBSSH2
@@ -347,6 +385,11 @@ public:
   setClientTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
   static void
   setServerTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
+
+  static const std::shared_ptr<TLSContext>& getClientTLSContext()
+  {
+    return clTlsContext_;
+  }
 #endif // ENABLE_SSL
 
   static void setProtocolFamily(int protocolFamily)
@@ -0,0 +1,191 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "SocketPool.h"
+
+#include <algorithm>
+
+#include "SocketCore.h"
+#include "LogFactory.h"
+#include "wallclock.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+SocketPool::SocketPool()
+    : numPending_(0),
+      maxIdle_(64),
+      maxIdlePerHost_(16),
+      idleTimeout_(std::chrono::seconds(15))
+{
+}
+
+SocketPool::~SocketPool() = default;
+
+bool SocketPool::isTimeout(const Entry& entry) const
+{
+  return entry.registeredTime.difference(global::wallclock()) >= idleTimeout_;
+}
+
+void SocketPool::erase(EntryIter it)
+{
+  auto i = origins_.find((*it).key);
+  if (i != std::end(origins_)) {
+    auto& entries = (*i).second.entries;
+    entries.erase(std::find(std::begin(entries), std::end(entries), it));
+    if (entries.empty() && (*i).second.pending == 0) {
+      origins_.erase(i);
+    }
+  }
+  lru_.erase(it);
+}
+
+void SocketPool::add(const std::string& key,
+                     const std::shared_ptr<SocketCore>& socket,
+                     const std::string& options)
+{
+  if (maxIdle_ == 0 || maxIdlePerHost_ == 0) {
+    return;
+  }
+  A2_LOG_INFO(fmt("Pool socket for %s", key.c_str()));
+  auto& origin = origins_[key];
+  if (origin.entries.size() >= maxIdlePerHost_) {
+    A2_LOG_DEBUG(fmt("Closing the oldest idle connection for %s",
+                     key.c_str()));
+    erase(origin.entries.front());
+  }
+  else if (lru_.size() >= maxIdle_) {
+    A2_LOG_DEBUG(fmt("Closing the least recently pooled connection for %s",
+                     lru_.front().key.c_str()));
+    erase(std::begin(lru_));
+  }
+  lru_.push_back(Entry{key, socket, options, global::wallclock()});
+  origins_[key].entries.push_back(std::prev(std::end(lru_)));
+}
+
+std::shared_ptr<SocketCore> SocketPool::pop(std::string& options,
+                                            const std::string& key)
+{
+  auto i = origins_.find(key);
+  if (i == std::end(origins_)) {
+    return nullptr;
+  }
+  std::shared_ptr<SocketCore> socket;
+  auto& entries = (*i).second.entries;
+  while (!entries.empty()) {
+    auto it = entries.back();
+    entries.pop_back();
+    // The peer may have closed the connection while it was idle.
+    if (!isTimeout(*it) && (*it).socket->isIdleConnectionAlive()) {
+      A2_LOG_INFO(fmt("Found socket for %s", key.c_str()));
+      socket = std::move((*it).socket);
+      options = std::move((*it).options);
+      lru_.erase(it);
+      break;
+    }
+    lru_.erase(it);
+  }
+  if (entries.empty() && (*i).second.pending == 0) {
+    origins_.erase(i);
+  }
+  return socket;
+}
+
+size_t SocketPool::evictTimedOut()
+{
+  size_t n = 0;
+  // lru_ is ordered by the time pooled, and so by the time to expire.
+  while (!lru_.empty() && isTimeout(lru_.front())) {
+    erase(std::begin(lru_));
+    ++n;
+  }
+  return n;
+}
+
+size_t SocketPool::count(const std::string& key) const
+{
+  auto i = origins_.find(key);
+  if (i == std::end(origins_)) {
+    return 0;
+  }
+  return (*i).second.entries.size() + (*i).second.pending;
+}
+
+void SocketPool::addPending(const std::string& key)
+{
+  ++origins_[key].pending;
+  ++numPending_;
+}
+
+void SocketPool::removePending(const std::string& key)
+{
+  auto i = origins_.find(key);
+  if (i == std::end(origins_) || (*i).second.pending == 0) {
+    return;
+  }
+  --numPending_;
+  if (--(*i).second.pending == 0 && (*i).second.entries.empty()) {
+    origins_.erase(i);
+  }
+}
+
+void SocketPool::setMaxIdle(size_t n)
+{
+  maxIdle_ = n;
+  while (lru_.size() > maxIdle_) {
+    erase(std::begin(lru_));
+  }
+}
+
+void SocketPool::setMaxIdlePerHost(size_t n)
+{
+  maxIdlePerHost_ = n;
+  for (auto i = std::begin(origins_); i != std::end(origins_);) {
+    auto next = std::next(i);
+    auto& entries = (*i).second.entries;
+    // The last erase() may remove the origin.
+    for (auto excess = entries.size() > n ? entries.size() - n : 0;
+         excess > 0; --excess) {
+      erase(entries.front());
+    }
+    i = next;
+  }
+}
+
+void SocketPool::setIdleTimeout(std::chrono::seconds timeout)
+{
+  idleTimeout_ = std::move(timeout);
+}
+
+} // namespace aria2
@@ -0,0 +1,150 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_SOCKET_POOL_H
+#define D_SOCKET_POOL_H
+
+#include "common.h"
+
+#include <string>
+#include <memory>
+#include <list>
+#include <vector>
+#include <map>
+#include <chrono>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class SocketCore;
+
+// Keeps idle connections for reuse.  Connections are grouped by key,
+// which identifies the origin (address, port, user and proxy) they
+// are connected to.  The number of idle connections is limited per
+// key and in total, and the least recently pooled one is closed when
+// the limit is exceeded.  All connections share the same idle
+// timeout, so that they time out in the order they were pooled.
+class SocketPool {
+private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<SocketCore> socket;
+    // protocol specific option string
+    std::string options;
+    Timer registeredTime;
+  };
+
+  typedef std::list<Entry>::iterator EntryIter;
+
+  struct Origin {
+    // Idle connections of this origin, the most recently pooled last.
+    std::vector<EntryIter> entries;
+    // The number of connections being established for this origin
+    // ahead of need.
+    size_t pending;
+
+    Origin() : pending(0) {}
+  };
+
+  // All idle connections, the least recently pooled first.
+  std::list<Entry> lru_;
+  std::map<std::string, Origin> origins_;
+
+  // The number of connections being established ahead of need for
+  // all origins.
+  size_t numPending_;
+
+  size_t maxIdle_;
+  size_t maxIdlePerHost_;
+  std::chrono::seconds idleTimeout_;
+
+  bool isTimeout(const Entry& entry) const;
+
+  void erase(EntryIter it);
+
+public:
+  SocketPool();
+
+  ~SocketPool();
+
+  // Pools socket for key.  If the number of idle connections for key
+  // or in total exceeds the limit, the least recently pooled one is
+  // closed.
+  void add(const std::string& key, const std::shared_ptr<SocketCore>& socket,
+           const std::string& options);
+
+  // Removes the most recently pooled connection for key which has not
+  // timed out and is still alive, and returns it.  Its option string
+  // is stored in options.  The timed out or broken connections found
+  // on the way are removed.  Returns nullptr if there is no such
+  // connection.
+  std::shared_ptr<SocketCore> pop(std::string& options, const std::string& key);
+
+  // Removes timed out connections.  Returns the number of removed
+  // connections.
+  size_t evictTimedOut();
+
+  // Returns the number of idle and pending connections for key.
+  size_t count(const std::string& key) const;
+
+  // Returns the number of pending connections for all keys.
+  size_t countPending() const { return numPending_; }
+
+  size_t size() const { return lru_.size(); }
+
+  bool empty() const { return lru_.empty(); }
+
+  // Tells that a connection for key is being established ahead of
+  // need and will be pooled.
+  void addPending(const std::string& key);
+
+  void removePending(const std::string& key);
+
+  void setMaxIdle(size_t n);
+
+  size_t getMaxIdle() const { return maxIdle_; }
+
+  void setMaxIdlePerHost(size_t n);
+
+  size_t getMaxIdlePerHost() const { return maxIdlePerHost_; }
+
+  void setIdleTimeout(std::chrono::seconds timeout);
+
+  std::chrono::seconds getIdleTimeout() const { return idleTimeout_; }
+};
+
+} // namespace aria2
+
+#endif // D_SOCKET_POOL_H
@@ -36,14 +36,40 @@
 
 #include <cstring>
 #include <cassert>
+#include <algorithm>
 
 #include "SocketCore.h"
 #include "LogFactory.h"
+#include "fmt.h"
 
 namespace aria2 {
 
+namespace {
+size_t maxCapacity = SocketRecvBuffer::MIN_CAPACITY;
+// After this number of consecutive short reads, the capacity is
+// halved.
+constexpr size_t SHRINK_THRESHOLD = 16;
+} // namespace
+
+constexpr size_t SocketRecvBuffer::MIN_CAPACITY;
+
+void SocketRecvBuffer::setMaxCapacity(size_t capacity)
+{
+  maxCapacity = std::max(capacity, MIN_CAPACITY);
+}
+
+size_t SocketRecvBuffer::getMaxCapacity() { return maxCapacity; }
+
 SocketRecvBuffer::SocketRecvBuffer(std::shared_ptr<SocketCore> socket)
-    : socket_(std::move(socket)), pos_(buf_.data()), last_(pos_)
+    : buf_(new unsigned char[MIN_CAPACITY]),
+      capacity_(MIN_CAPACITY),
+      nextCapacity_(MIN_CAPACITY),
+      shortReads_(0),
+      socket_(std::move(socket)),
+      pos_(buf_.get()),
+      last_(pos_),
+      recvCount_(0),
+      recvBytes_(0)
 {
 }
 
@@ -51,16 +77,82 @@ SocketRecvBuffer::~SocketRecvBuffer() = default;
 
 ssize_t SocketRecvBuffer::recv()
 {
-  size_t n = std::end(buf_) - last_;
+  if (bufferEmpty()) {
+    truncateBuffer();
+  }
+  size_t n = buf_.get() + capacity_ - last_;
   if (n == 0) {
     A2_LOG_DEBUG("Buffer full");
     return 0;
   }
-  socket_->readData(last_, n);
+  size_t nrequested = n;
+  a2iovec iov;
+  iov.A2IOVEC_BASE = reinterpret_cast<char*>(last_);
+  iov.A2IOVEC_LEN = n;
+  n = socket_->readVector(&iov, 1);
+  ++recvCount_;
+  recvBytes_ += n;
   last_ += n;
+  // Only a read into the whole buffer tells us whether it is large
+  // enough.
+  if (nrequested == capacity_) {
+    updateCapacity(n, nrequested);
+  }
   return n;
 }
 
+ssize_t SocketRecvBuffer::recv(const a2iovec* iov, size_t iovcnt)
+{
+  assert(bufferEmpty());
+  assert(iovcnt < A2_IOV_MAX);
+  truncateBuffer();
+  a2iovec v[A2_IOV_MAX];
+  size_t total = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    v[i] = iov[i];
+    total += iov[i].A2IOVEC_LEN;
+  }
+  size_t vcnt = iovcnt;
+  if (total < capacity_) {
+    v[vcnt].A2IOVEC_BASE = reinterpret_cast<char*>(last_);
+    v[vcnt].A2IOVEC_LEN = capacity_ - total;
+    ++vcnt;
+  }
+  size_t nrequested = std::max(total, capacity_);
+  size_t n = socket_->readVector(v, vcnt);
+  ++recvCount_;
+  recvBytes_ += n;
+  if (n > total) {
+    last_ += n - total;
+  }
+  updateCapacity(n, nrequested);
+  return std::min(n, total);
+}
+
+void SocketRecvBuffer::updateCapacity(size_t nread, size_t nrequested)
+{
+  if (nread == nrequested) {
+    shortReads_ = 0;
+    if (capacity_ < maxCapacity) {
+      nextCapacity_ = std::min(capacity_ * 2, maxCapacity);
+    }
+  }
+  else if (nread < capacity_ / 4) {
+    // Include EAGAIN, that is, nread == 0.  The connection is slow or
+    // idle, and we do not need a large buffer.
+    if (++shortReads_ >= SHRINK_THRESHOLD) {
+      shortReads_ = 0;
+      nextCapacity_ = std::max(capacity_ / 2, MIN_CAPACITY);
+    }
+  }
+  else {
+    shortReads_ = 0;
+  }
+  if (bufferEmpty()) {
+    truncateBuffer();
+  }
+}
+
 void SocketRecvBuffer::drain(size_t n)
 {
   assert(pos_ + n <= last_);
@@ -70,6 +162,16 @@ void SocketRecvBuffer::drain(size_t n)
   }
 }
 
-void SocketRecvBuffer::truncateBuffer() { pos_ = last_ = buf_.data(); }
+void SocketRecvBuffer::truncateBuffer()
+{
+  if (nextCapacity_ != capacity_) {
+    A2_LOG_DEBUG(fmt("Resize receive buffer from %lu to %lu",
+                     static_cast<unsigned long>(capacity_),
+                     static_cast<unsigned long>(nextCapacity_)));
+    capacity_ = nextCapacity_;
+    buf_.reset(new unsigned char[capacity_]);
+  }
+  pos_ = last_ = buf_.get();
+}
 
 } // namespace aria2
@@ -38,14 +38,20 @@
 #include "common.h"
 
 #include <memory>
-#include <array>
 
 #include "a2functional.h"
+#include "a2netcompat.h"
 
 namespace aria2 {
 
 class SocketCore;
 
+// Buffer for the data received from a socket.  The buffer starts
+// with 16KiB, and its capacity is doubled, up to the value set by
+// setMaxCapacity(), each time a read fills the whole buffer.  When
+// reads keep returning much less than the capacity, the capacity is
+// halved again.  The capacity is changed only when the buffer is
+// empty.
 class SocketRecvBuffer {
 public:
   SocketRecvBuffer(std::shared_ptr<SocketCore> socket);
@@ -53,6 +59,13 @@ public:
   // Reads data from socket as much as capacity allows. Returns the
   // number of bytes read.
   ssize_t recv();
+  // Reads data from socket into the |iovcnt| buffers described by
+  // |iov| in order, and then into this buffer, with one read call.
+  // This buffer is only used if the total length of |iov| is less
+  // than the capacity of this buffer, and it must be empty.  Returns
+  // the number of bytes stored in |iov|.  The number of bytes stored
+  // in this buffer is available by getBufferLength().
+  ssize_t recv(const a2iovec* iov, size_t iovcnt);
   // Truncates the contents of buffer to 0.
   void truncateBuffer();
   // Drains first n bytes of data from buffer.  It is an programmer's
@@ -68,11 +81,35 @@ public:
 
   bool bufferEmpty() const { return pos_ == last_; }
 
+  size_t getCapacity() const { return capacity_; }
+
+  // Returns the number of read calls made to the socket.
+  uint64_t getRecvCount() const { return recvCount_; }
+
+  // Returns the total number of bytes read from the socket.
+  uint64_t getRecvBytes() const { return recvBytes_; }
+
+  static void setMaxCapacity(size_t capacity);
+
+  static size_t getMaxCapacity();
+
+  static constexpr size_t MIN_CAPACITY = 16_k;
+
 private:
-  std::array<unsigned char, 16_k> buf_;
+  void updateCapacity(size_t nread, size_t nrequested);
+
+  std::unique_ptr<unsigned char[]> buf_;
+  size_t capacity_;
+  // The capacity applied when the buffer becomes empty.
+  size_t nextCapacity_;
+  // The number of consecutive reads which returned less than a
+  // quarter of capacity_.
+  size_t shortReads_;
   std::shared_ptr<SocketCore> socket_;
   unsigned char* pos_;
   unsigned char* last_;
+  uint64_t recvCount_;
+  uint64_t recvBytes_;
 };
 
 } // namespace aria2
@@ -36,6 +36,7 @@
 #define D_STAT_CALC_H
 
 #include "common.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
@@ -46,6 +47,11 @@ public:
   virtual ~StatCalc() = default;
 
   virtual void calculateStat(const DownloadEngine* e) = 0;
+
+  // Stores in next the time when calculateStat() has something to do
+  // even if nothing happens in DownloadEngine, and returns true.
+  // Returns false if there is no such time.
+  virtual bool getNextCalculationTime(Timer& next) const { return false; }
 };
 
 } // namespace aria2
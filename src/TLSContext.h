@@ -41,6 +41,8 @@
 
 namespace aria2 {
 
+class TLSSessionCache;
+
 enum TLSSessionSide { TLS_CLIENT, TLS_SERVER };
 
 enum TLSVersion {
@@ -49,6 +51,7 @@ enum TLSVersion {
   TLS_PROTO_TLS10,
   TLS_PROTO_TLS11,
   TLS_PROTO_TLS12,
+  TLS_PROTO_TLS13,
 };
 
 class TLSContext {
@@ -70,6 +73,15 @@ public:
   virtual TLSSessionSide getSide() const = 0;
   virtual bool getVerifyPeer() const = 0;
   virtual void setVerifyPeer(bool) = 0;
+
+  // Returns the cache of client side sessions used for resumption,
+  // or nullptr if the backend does not support it.
+  virtual TLSSessionCache* getSessionCache() { return nullptr; }
+
+  // Lets the sessions created after this call hand the negotiated
+  // keys to the kernel, if the kernel and the cipher support it.
+  // Returns false if the backend cannot do kernel TLS at all.
+  virtual bool enableKernelTLS() { return false; }
 };
 
 } // namespace aria2
@@ -38,6 +38,10 @@
 #include "common.h"
 #include "a2netcompat.h"
 #include "TLSContext.h"
+#include "A2STR.h"
+
+#include <string>
+#include <vector>
 
 namespace aria2 {
 
@@ -68,6 +72,49 @@ public:
   // succeeds, or TLS_ERR_ERROR.
   virtual int setSNIHostname(const std::string& hostname) = 0;
 
+  // Sets |protocols| to offer in TLS ALPN extension, in the order of
+  // preference.  This is only meaningful for client side session.
+  // This function returns TLS_ERR_OK if it succeeds, or
+  // TLS_ERR_ERROR.  The backends which do not support ALPN ignore
+  // |protocols|.
+  virtual int setAlpnProtocols(const std::vector<std::string>& protocols)
+  {
+    return TLS_ERR_OK;
+  }
+
+  // Returns the protocol selected by TLS ALPN extension, or empty
+  // string if no protocol was selected.
+  virtual std::string getAlpnProtocol() { return A2STR::NIL; }
+
+  // Tells that this client side session connects to the server
+  // identified by |key| in the session cache of TLSContext.  If the
+  // cache has a session for |key|, the handshake tries to resume it.
+  // The sessions issued by the server are stored under |key|.  This
+  // function returns TLS_ERR_OK if it succeeds, or TLS_ERR_ERROR.
+  // The backends which do not support session cache ignore |key|.
+  virtual int setSessionCacheKey(const std::string& key) { return TLS_ERR_OK; }
+
+  // Returns true if the handshake resumed the cached session.
+  virtual bool isSessionResumed() { return false; }
+
+  // Returns true if the records sent by this session are encrypted by
+  // the kernel.  Only meaningful after handshake.
+  virtual bool isKernelTLSSend() { return false; }
+
+  // Returns true if the records received by this session are
+  // decrypted by the kernel.  Only meaningful after handshake.
+  virtual bool isKernelTLSRecv() { return false; }
+
+  // Sends |len| bytes at |offset| in the file |fd| without copying
+  // them into user space.  This function must not be called unless
+  // isKernelTLSSend() returns true.  It returns the number of bytes
+  // sent if it succeeds, or TLS_ERR_WOULDBLOCK if the underlying
+  // transport blocks, or TLS_ERR_ERROR.
+  virtual ssize_t sendFile(int fd, int64_t offset, size_t len)
+  {
+    return TLS_ERR_ERROR;
+  }
+
   // Closes the SSL/TLS session. Don't close underlying transport
   // socket. This function returns TLS_ERR_OK if it succeeds, or
   // TLS_ERR_ERROR.
@@ -0,0 +1,143 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TLSSessionCache.h"
+
+#include <algorithm>
+
+#include "A2STR.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+TLSSessionCache::TLSSessionCache(size_t capacity, size_t sessionsPerKey)
+    : capacity_(capacity), sessionsPerKey_(sessionsPerKey), clock_(0)
+{
+}
+
+std::string TLSSessionCache::makeKey(const std::string& hostname,
+                                     uint16_t port)
+{
+  return fmt("%s:%u", hostname.c_str(), port);
+}
+
+TLSSessionCache::Entry& TLSSessionCache::touch(const std::string& key)
+{
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    if (entries_.size() >= capacity_) {
+      auto lru = std::min_element(
+          std::begin(entries_), std::end(entries_),
+          [](const std::pair<const std::string, Entry>& lhs,
+             const std::pair<const std::string, Entry>& rhs) {
+            return lhs.second.lastUsed < rhs.second.lastUsed;
+          });
+      entries_.erase(lru);
+    }
+    i = entries_.insert(std::make_pair(key, Entry{{}, Stat{0, 0}, 0})).first;
+  }
+  (*i).second.lastUsed = ++clock_;
+  return (*i).second;
+}
+
+void TLSSessionCache::put(const std::string& key, std::string data,
+                          bool reusable)
+{
+  if (data.empty()) {
+    return;
+  }
+  auto& sessions = touch(key).sessions;
+  if (reusable) {
+    sessions.clear();
+  }
+  sessions.push_back(Session{std::move(data), reusable});
+  if (sessions.size() > sessionsPerKey_) {
+    sessions.pop_front();
+  }
+}
+
+std::string TLSSessionCache::take(const std::string& key)
+{
+  auto i = entries_.find(key);
+  if (i == std::end(entries_) || (*i).second.sessions.empty()) {
+    return A2STR::NIL;
+  }
+  auto& entry = (*i).second;
+  entry.lastUsed = ++clock_;
+  if (entry.sessions.back().reusable) {
+    return entry.sessions.back().data;
+  }
+  auto data = std::move(entry.sessions.back().data);
+  entry.sessions.pop_back();
+  return data;
+}
+
+void TLSSessionCache::remove(const std::string& key)
+{
+  auto i = entries_.find(key);
+  if (i != std::end(entries_)) {
+    (*i).second.sessions.clear();
+  }
+}
+
+void TLSSessionCache::countHandshake(const std::string& key, bool resumed)
+{
+  auto& stat = touch(key).stat;
+  if (resumed) {
+    ++stat.hits;
+  }
+  else {
+    ++stat.misses;
+  }
+}
+
+TLSSessionCache::Stat TLSSessionCache::getStat(const std::string& key) const
+{
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    return Stat{0, 0};
+  }
+  return (*i).second.stat;
+}
+
+size_t TLSSessionCache::countSessions(const std::string& key) const
+{
+  auto i = entries_.find(key);
+  if (i == std::end(entries_)) {
+    return 0;
+  }
+  return (*i).second.sessions.size();
+}
+
+} // namespace aria2
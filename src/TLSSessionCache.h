@@ -0,0 +1,124 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TLS_SESSION_CACHE_H
+#define D_TLS_SESSION_CACHE_H
+
+#include "common.h"
+
+#include <string>
+#include <map>
+#include <deque>
+
+namespace aria2 {
+
+// Client side cache of TLS sessions, keyed by the remote host and
+// port.  A session is stored in the serialized form provided by the
+// TLS backend, so that it can be resumed by the next connection to
+// the same host.  TLS 1.3 session tickets must not be used more than
+// once, so that several of them are kept per host and each one is
+// handed to one connection only.  The number of hosts is limited, and
+// the least recently used one is dropped first, together with its
+// statistics.
+class TLSSessionCache {
+public:
+  struct Stat {
+    // The number of handshakes which resumed the cached session.
+    uint64_t hits;
+    // The number of full handshakes.
+    uint64_t misses;
+  };
+
+  TLSSessionCache(size_t capacity = 256, size_t sessionsPerKey = 8);
+
+  // Returns the key for the connection to |hostname|:|port|.  The
+  // hostname is also sent as SNI, so the key covers SNI too.
+  static std::string makeKey(const std::string& hostname, uint16_t port);
+
+  // Stores the serialized session |data| for |key|.  If |reusable| is
+  // true, the session can be resumed by any number of connections
+  // (TLS 1.2 and earlier) and it replaces the sessions stored before.
+  // Otherwise, it is a single-use TLS 1.3 ticket which is added to the
+  // ones already stored, dropping the oldest one if there are more
+  // than sessionsPerKey of them.
+  void put(const std::string& key, std::string data, bool reusable);
+
+  // Returns the most recently stored session for |key|, or empty
+  // string if there is no such session.  A single-use session is
+  // removed from the cache.
+  std::string take(const std::string& key);
+
+  // Drops the sessions for |key|, for example, when one of them was
+  // rejected by the backend.
+  void remove(const std::string& key);
+
+  // Records the result of handshake with |key|.  If |resumed| is
+  // true, the handshake resumed the cached session.
+  void countHandshake(const std::string& key, bool resumed);
+
+  Stat getStat(const std::string& key) const;
+
+  // Returns the number of hosts in the cache.
+  size_t size() const { return entries_.size(); }
+
+  // Returns the number of sessions stored for |key|.
+  size_t countSessions(const std::string& key) const;
+
+private:
+  struct Session {
+    std::string data;
+    bool reusable;
+  };
+
+  struct Entry {
+    // The oldest session comes first.
+    std::deque<Session> sessions;
+    Stat stat;
+    // Larger value means more recently used.
+    uint64_t lastUsed;
+  };
+
+  // Returns the entry for |key|, creating it if there is none, and
+  // marks it most recently used.
+  Entry& touch(const std::string& key);
+
+  size_t capacity_;
+  size_t sessionsPerKey_;
+  uint64_t clock_;
+  std::map<std::string, Entry> entries_;
+};
+
+} // namespace aria2
+
+#endif // D_TLS_SESSION_CACHE_H
@@ -39,14 +39,12 @@
 namespace aria2 {
 
 TimeBasedCommand::TimeBasedCommand(cuid_t cuid, DownloadEngine* e,
-                                   std::chrono::seconds interval,
-                                   bool routineCommand)
+                                   std::chrono::seconds interval)
     : Command(cuid),
       e_(e),
       checkPoint_(global::wallclock()),
       interval_(std::move(interval)),
-      exit_(false),
-      routineCommand_(routineCommand)
+      exit_(false)
 {
 }
 
@@ -69,12 +67,11 @@ bool TimeBasedCommand::execute()
   if (exit_) {
     return true;
   }
-  if (routineCommand_) {
-    e_->addRoutineCommand(std::unique_ptr<Command>(this));
-  }
-  else {
-    e_->addCommand(std::unique_ptr<Command>(this));
-  }
+  // Sleep until the next checkpoint instead of being examined in
+  // every iteration (routine command) or in every refresh.
+  auto deadline = checkPoint_;
+  deadline.advance(interval_);
+  e_->addTimerCommand(std::unique_ptr<Command>(this), deadline);
   return false;
 }
 
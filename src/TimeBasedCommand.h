@@ -59,8 +59,6 @@ private:
    */
   bool exit_;
 
-  bool routineCommand_;
-
 protected:
   DownloadEngine* getDownloadEngine() const { return e_; }
 
@@ -86,8 +84,11 @@ public:
   virtual void postProcess(){};
 
 public:
+  // Between checkpoints, this command sleeps in DownloadEngine's
+  // timer wheel.  preProcess() and postProcess() are called when it is
+  // woken up, see DownloadEngine::addTimerCommand().
   TimeBasedCommand(cuid_t cuid, DownloadEngine* e,
-                   std::chrono::seconds interval, bool routineCommand = false);
+                   std::chrono::seconds interval);
 
   virtual ~TimeBasedCommand();
 
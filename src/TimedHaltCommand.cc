@@ -45,7 +45,7 @@ namespace aria2 {
 TimedHaltCommand::TimedHaltCommand(cuid_t cuid, DownloadEngine* e,
                                    std::chrono::seconds secondsToHalt,
                                    bool forceHalt)
-    : TimeBasedCommand(cuid, e, std::move(secondsToHalt), true),
+    : TimeBasedCommand(cuid, e, std::move(secondsToHalt)),
       forceHalt_(forceHalt)
 {
 }
@@ -0,0 +1,248 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TIMER_WHEEL_H
+#define D_TIMER_WHEEL_H
+
+#include "common.h"
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+// Hierarchical timing wheel.  Values are registered with a deadline
+// and handed back by expire() once the deadline has passed.  The
+// deadline is rounded up to the tick resolution given in the
+// constructor.  Insertion is O(1) and expire() only touches the slots
+// of the ticks elapsed since the last call, plus the occasional
+// cascade of a higher level slot into the lower levels.  Deadlines
+// beyond the span of the wheel are parked in the last level and
+// re-examined when that slot cascades.
+template <typename T> class TimerWheel {
+public:
+  TimerWheel(std::chrono::milliseconds tick, const Timer& base)
+      : tick_(std::move(tick)),
+        base_(base),
+        current_(0),
+        size_(0),
+        slots_(NUM_LEVELS * NUM_SLOTS)
+  {
+  }
+
+  // Registers value so that it is returned by expire() when deadline
+  // has passed.
+  void add(T value, const Timer& deadline)
+  {
+    ++size_;
+    insert(Entry{toTick(deadline), std::move(value)});
+  }
+
+  // Advances the wheel to now and appends the values whose deadline
+  // has passed to out.
+  void expire(const Timer& now, std::vector<T>& out)
+  {
+    auto target = toTickFloor(now);
+    takeDue(out);
+    while (current_ < target && size_ > 0) {
+      ++current_;
+      for (size_t level = NUM_LEVELS - 1; level > 0; --level) {
+        if ((current_ & ((1ULL << (LEVEL_BITS * level)) - 1)) == 0) {
+          cascade(level);
+        }
+      }
+      auto& slot = slots_[current_ & SLOT_MASK];
+      if (!slot.empty()) {
+        std::vector<Entry> entries;
+        entries.swap(slot);
+        for (auto& e : entries) {
+          insert(std::move(e));
+        }
+      }
+      // Cascading may also have made some values due.
+      takeDue(out);
+    }
+    if (current_ < target) {
+      current_ = target;
+    }
+  }
+
+  // Appends all registered values to out regardless of their
+  // deadline and makes this object empty.
+  void drain(std::vector<T>& out)
+  {
+    takeDue(out);
+    for (auto& slot : slots_) {
+      for (auto& e : slot) {
+        out.push_back(std::move(e.value));
+      }
+      slot.clear();
+    }
+    size_ = 0;
+  }
+
+  // Stores in next the earliest time at which expire() may return a
+  // value and returns true.  The time may be earlier than the actual
+  // deadline of any value, but it is never later than that.  Returns
+  // false if this object is empty.
+  bool getNextExpiry(Timer& next) const
+  {
+    if (size_ == 0) {
+      return false;
+    }
+    if (!due_.empty()) {
+      next = toTimer(current_);
+      return true;
+    }
+    auto t = std::numeric_limits<uint64_t>::max();
+    // Level 0 slots hold the values due within NUM_SLOTS ticks.
+    for (auto i = current_ + 1; i < current_ + NUM_SLOTS; ++i) {
+      if (!slots_[i & SLOT_MASK].empty()) {
+        t = i;
+        break;
+      }
+    }
+    // A non-empty higher level slot cascades into the lower levels at
+    // the beginning of its range.  Nothing in it expires before that.
+    for (size_t level = 1; level < NUM_LEVELS; ++level) {
+      auto shift = LEVEL_BITS * level;
+      for (uint64_t k = 1; k <= NUM_SLOTS; ++k) {
+        auto c = ((current_ >> shift) + k) << shift;
+        if (c >= t) {
+          break;
+        }
+        if (!slots_[level * NUM_SLOTS + ((c >> shift) & SLOT_MASK)].empty()) {
+          t = c;
+          break;
+        }
+      }
+    }
+    next = toTimer(t);
+    return true;
+  }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+private:
+  static constexpr size_t LEVEL_BITS = 6;
+  static constexpr size_t NUM_SLOTS = 1 << LEVEL_BITS;
+  static constexpr uint64_t SLOT_MASK = NUM_SLOTS - 1;
+  static constexpr size_t NUM_LEVELS = 4;
+  // The number of ticks covered by the wheel.
+  static constexpr uint64_t SPAN = 1ULL << (LEVEL_BITS * NUM_LEVELS);
+
+  struct Entry {
+    uint64_t tick;
+    T value;
+  };
+
+  uint64_t toTickFloor(const Timer& t) const
+  {
+    return base_.difference(t) / tick_;
+  }
+
+  uint64_t toTick(const Timer& t) const
+  {
+    auto d = base_.difference(t);
+    return (d + tick_ - Timer::Clock::duration(1)) / tick_;
+  }
+
+  Timer toTimer(uint64_t tick) const
+  {
+    return Timer(base_.getTime() +
+                 static_cast<Timer::Clock::duration::rep>(tick) * tick_);
+  }
+
+  void insert(Entry e)
+  {
+    if (e.tick <= current_) {
+      due_.push_back(std::move(e.value));
+      return;
+    }
+    auto delta = e.tick - current_;
+    if (delta >= SPAN) {
+      // Park it in the last level slot that cascades before the
+      // wheel wraps around.  It is inserted again at that point.
+      auto t = current_ + SPAN - 1;
+      slots_[(NUM_LEVELS - 1) * NUM_SLOTS +
+             ((t >> (LEVEL_BITS * (NUM_LEVELS - 1))) & SLOT_MASK)]
+          .push_back(std::move(e));
+      return;
+    }
+    size_t level = 0;
+    for (; delta >= (1ULL << (LEVEL_BITS * (level + 1))); ++level)
+      ;
+    slots_[level * NUM_SLOTS + ((e.tick >> (LEVEL_BITS * level)) & SLOT_MASK)]
+        .push_back(std::move(e));
+  }
+
+  void cascade(size_t level)
+  {
+    auto& slot = slots_[level * NUM_SLOTS +
+                        ((current_ >> (LEVEL_BITS * level)) & SLOT_MASK)];
+    std::vector<Entry> entries;
+    entries.swap(slot);
+    for (auto& e : entries) {
+      insert(std::move(e));
+    }
+  }
+
+  void takeDue(std::vector<T>& out)
+  {
+    for (auto& v : due_) {
+      out.push_back(std::move(v));
+    }
+    size_ -= due_.size();
+    due_.clear();
+  }
+
+  Timer::Clock::duration tick_;
+  Timer base_;
+  // The number of ticks elapsed since base_ at the last expire().
+  uint64_t current_;
+  size_t size_;
+  std::vector<std::vector<Entry>> slots_;
+  // Values whose deadline has already passed.
+  std::vector<T> due_;
+};
+
+} // namespace aria2
+
+#endif // D_TIMER_WHEEL_H
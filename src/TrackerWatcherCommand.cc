@@ -67,6 +67,7 @@
 #include "UDPTrackerClient.h"
 #include "BtRegistry.h"
 #include "NameResolveCommand.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -218,6 +219,7 @@ bool TrackerWatcherCommand::execute()
     else {
       trackerRequest_->stop(e_);
       e_->setRefreshInterval(std::chrono::milliseconds(0));
+      setWakeupTimeAfter(1_s);
       e_->addCommand(std::unique_ptr<Command>(this));
       return false;
     }
@@ -267,7 +269,22 @@ bool TrackerWatcherCommand::execute()
     return true;
   }
 
-  e_->addCommand(std::unique_ptr<Command>(this));
+  if (trackerRequest_) {
+    // Check the progress of the request once a second, or when the
+    // UDP tracker reply arrives.
+    setWakeupTimeAfter(1_s);
+    e_->addCommand(std::unique_ptr<Command>(this));
+  }
+  else {
+    // Sleep until the next regular announce.  Halt and completion of
+    // the download wake this command up earlier for stopped and
+    // completed event.
+    auto deadline = global::wallclock();
+    deadline.advance(1_s);
+    deadline = std::max(deadline, btAnnounce_->getNextAnnounceTime());
+    e_->addTimerCommand(std::unique_ptr<Command>(this), deadline,
+                        requestGroup_->getGID());
+  }
   return false;
 }
 
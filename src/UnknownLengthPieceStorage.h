@@ -147,6 +147,15 @@ public:
   virtual void cancelPiece(const std::shared_ptr<Piece>& piece,
                            cuid_t cuid) CXX11_OVERRIDE;
 
+  virtual bool verifyPieceInWorker(
+      const std::shared_ptr<Piece>& piece, WorkerPool* workerPool,
+      std::function<void(const std::string&)> callback) CXX11_OVERRIDE
+  {
+    return false;
+  }
+
+  virtual void cancelPieceVerification() CXX11_OVERRIDE {}
+
   /**
    * Returns true if the specified piece is already downloaded.
    * Otherwise returns false.
@@ -216,6 +225,8 @@ public:
 
   virtual WrDiskCache* getWrDiskCache() CXX11_OVERRIDE { return nullptr; }
 
+  virtual RdDiskCache* getRdDiskCache() CXX11_OVERRIDE { return nullptr; }
+
   virtual void flushWrDiskCacheEntry() CXX11_OVERRIDE {}
 
   virtual int32_t getPieceLength(size_t index) CXX11_OVERRIDE;
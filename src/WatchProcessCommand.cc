@@ -67,7 +67,7 @@ namespace aria2 {
 
 WatchProcessCommand::WatchProcessCommand(cuid_t cuid, DownloadEngine* e,
                                          unsigned int pid, bool forceHalt)
-    : TimeBasedCommand(cuid, e, 1_s, true), pid_(pid), forceHalt_(forceHalt)
+    : TimeBasedCommand(cuid, e, 1_s), pid_(pid), forceHalt_(forceHalt)
 {
 }
 
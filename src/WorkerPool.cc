@@ -0,0 +1,224 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "WorkerPool.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "a2io.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+WorkerPool::WorkerPool(size_t numThreads)
+    : numThreads_(0),
+      numPending_(0)
+#ifdef HAVE_STD_THREAD
+      ,
+      shutdown_(false)
+#endif // HAVE_STD_THREAD
+{
+  wakeupFds_[0] = wakeupFds_[1] = -1;
+#ifdef HAVE_STD_THREAD
+  if (numThreads == 0) {
+    return;
+  }
+#  ifndef __MINGW32__
+  if (pipe(wakeupFds_) == -1) {
+    int errNum = errno;
+    A2_LOG_ERROR(fmt("Failed to create pipe for worker threads: %s",
+                     util::safeStrerror(errNum).c_str()));
+    wakeupFds_[0] = wakeupFds_[1] = -1;
+  }
+  else {
+    for (auto fd : wakeupFds_) {
+      int flags;
+      while ((flags = fcntl(fd, F_GETFL, 0)) == -1 && errno == EINTR)
+        ;
+      while (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1 && errno == EINTR)
+        ;
+    }
+  }
+#  endif // !__MINGW32__
+  numThreads_ = numThreads;
+  threads_.reserve(numThreads_);
+  for (size_t i = 0; i < numThreads_; ++i) {
+    threads_.emplace_back(&WorkerPool::workerLoop, this);
+  }
+  A2_LOG_INFO(fmt("Started %lu worker thread(s).",
+                  static_cast<unsigned long>(numThreads_)));
+#else  // !HAVE_STD_THREAD
+  if (numThreads > 0) {
+    A2_LOG_WARN("Worker threads are not available on this platform."
+                " Jobs are executed in the main thread.");
+  }
+#endif // !HAVE_STD_THREAD
+}
+
+WorkerPool::~WorkerPool()
+{
+#ifdef HAVE_STD_THREAD
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  cond_.notify_all();
+  for (auto& th : threads_) {
+    th.join();
+  }
+#endif // HAVE_STD_THREAD
+  for (auto fd : wakeupFds_) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+void WorkerPool::submit(std::function<void()> work,
+                        std::function<void()> completion)
+{
+  ++numPending_;
+#ifdef HAVE_STD_THREAD
+  if (numThreads_ > 0) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(Job{std::move(work), std::move(completion)});
+    }
+    cond_.notify_one();
+    return;
+  }
+#endif // HAVE_STD_THREAD
+  work();
+  completions_.push_back(std::move(completion));
+}
+
+#ifdef HAVE_STD_THREAD
+void WorkerPool::workerLoop()
+{
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this] { return shutdown_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        // Shutting down, and no job is left.
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    job.work();
+    // Destroy the work function here, so that the objects it shares
+    // with the completion are destroyed in the event loop thread.
+    job.work = nullptr;
+    bool notify;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Only the first completion has to wake up the event loop.  It
+      // takes all completions queued so far in one go.
+      notify = completions_.empty();
+      completions_.push_back(std::move(job.completion));
+    }
+    if (notify) {
+      notifyCompletion();
+    }
+  }
+}
+#endif // HAVE_STD_THREAD
+
+void WorkerPool::notifyCompletion()
+{
+#ifndef __MINGW32__
+  if (wakeupFds_[1] == -1) {
+    return;
+  }
+  char c = 0;
+  while (write(wakeupFds_[1], &c, 1) == -1 && errno == EINTR)
+    ;
+#endif // !__MINGW32__
+}
+
+void WorkerPool::drainWakeupFd()
+{
+#ifndef __MINGW32__
+  if (wakeupFds_[0] == -1) {
+    return;
+  }
+  char buf[64];
+  ssize_t r;
+  while ((r = read(wakeupFds_[0], buf, sizeof(buf))) > 0 ||
+         (r == -1 && errno == EINTR))
+    ;
+#endif // !__MINGW32__
+}
+
+bool WorkerPool::completionReady()
+{
+#ifdef HAVE_STD_THREAD
+  if (numThreads_ > 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !completions_.empty();
+  }
+#endif // HAVE_STD_THREAD
+  return !completions_.empty();
+}
+
+size_t WorkerPool::processCompletions()
+{
+  std::deque<std::function<void()>> completions;
+  drainWakeupFd();
+#ifdef HAVE_STD_THREAD
+  if (numThreads_ > 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    completions.swap(completions_);
+  }
+  else
+#endif // HAVE_STD_THREAD
+  {
+    completions.swap(completions_);
+  }
+  for (auto& completion : completions) {
+    --numPending_;
+    if (completion) {
+      completion();
+    }
+  }
+  return completions.size();
+}
+
+} // namespace aria2
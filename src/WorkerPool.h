@@ -0,0 +1,140 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_WORKER_POOL_H
+#define D_WORKER_POOL_H
+
+#include "common.h"
+
+#include <deque>
+#include <functional>
+#include <vector>
+#ifdef HAVE_STD_THREAD
+#  include <thread>
+#  include <mutex>
+#  include <condition_variable>
+#endif // HAVE_STD_THREAD
+
+namespace aria2 {
+
+// WorkerPool runs jobs which would otherwise block the event loop,
+// such as hashing and disk I/O, in a fixed number of threads.  A job
+// consists of work, which is run in one of the worker threads, and
+// completion, which is run in the event loop thread when
+// processCompletions() is called.
+//
+// The work function must not touch objects shared with the event loop
+// thread (Logger, RequestGroupMan, wallclock, etc) other than the ones
+// it is given exclusively for the duration of the job, and it must
+// not throw an exception.  Report errors to the completion through
+// the captured state instead.  The work function is destroyed in the
+// worker thread before the completion is queued, so that the objects
+// shared by both are destroyed in the event loop thread.
+//
+// If the number of threads is 0, or threads are not available on this
+// platform, work is run in the caller's thread inside submit() and the
+// completion is deferred to the next processCompletions() call, so
+// that callers observe the same ordering either way.
+class WorkerPool {
+public:
+  WorkerPool(size_t numThreads);
+
+  // Waits for all submitted jobs to finish, including the ones which
+  // have not been started yet, so that queued disk writes are not
+  // lost.  Pending completions are not called.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  void submit(std::function<void()> work, std::function<void()> completion);
+
+  // Calls completion functions of the finished jobs in the order the
+  // jobs finished.  Returns the number of completions called.
+  size_t processCompletions();
+
+  // Returns true if there is at least one finished job whose
+  // completion has not been called yet.
+  bool completionReady();
+
+  // Returns the number of submitted jobs whose completion has not
+  // been called yet.
+  size_t countPending() const { return numPending_; }
+
+  size_t getNumThreads() const { return numThreads_; }
+
+  // Returns the file descriptor which becomes readable when a job
+  // finishes.  Returns -1 if no such file descriptor is available.
+  // In that case, the caller must check completionReady()
+  // periodically.
+  int getWakeupFd() const { return wakeupFds_[0]; }
+
+private:
+  struct Job {
+    std::function<void()> work;
+    std::function<void()> completion;
+  };
+
+  void notifyCompletion();
+
+  void drainWakeupFd();
+
+  size_t numThreads_;
+
+  // Accessed only from the thread which owns this object.
+  size_t numPending_;
+
+  std::deque<std::function<void()>> completions_;
+
+  int wakeupFds_[2];
+
+#ifdef HAVE_STD_THREAD
+  void workerLoop();
+
+  std::deque<Job> jobs_;
+
+  std::vector<std::thread> threads_;
+
+  // Guards jobs_, completions_ and shutdown_.
+  std::mutex mutex_;
+
+  std::condition_variable cond_;
+
+  bool shutdown_;
+#endif // HAVE_STD_THREAD
+};
+
+} // namespace aria2
+
+#endif // D_WORKER_POOL_H
@@ -35,14 +35,23 @@
 #include "WrDiskCache.h"
 
 #include <cassert>
+#include <vector>
+#include <algorithm>
+#include <functional>
 
 #include "WrDiskCacheEntry.h"
+#include "DiskWriteQueue.h"
+#include "SlabPool.h"
+#include "RdDiskCache.h"
 #include "LogFactory.h"
 #include "fmt.h"
 
 namespace aria2 {
 
-WrDiskCache::WrDiskCache(size_t limit) : limit_(limit), total_(0), clock_(0) {}
+WrDiskCache::WrDiskCache(size_t limit)
+    : limit_(limit), total_(0), clock_(0), rdDiskCache_(nullptr)
+{
+}
 
 WrDiskCache::~WrDiskCache()
 {
@@ -108,22 +117,88 @@ bool WrDiskCache::update(WrDiskCacheEntry* ent, ssize_t delta)
   return true;
 }
 
+namespace {
+int64_t getFirstOffset(const WrDiskCacheEntry* ent)
+{
+  auto& cells = ent->getDataSet();
+  return cells.empty() ? 0 : (*cells.begin())->goff;
+}
+} // namespace
+
 void WrDiskCache::ensureLimit()
 {
-  while (total_ > limit_) {
+  if (total_ > limit_) {
+    evict();
+  }
+  if (rdDiskCache_) {
+    // The data to write take precedence over the data read.
+    rdDiskCache_->ensureLimit();
+  }
+}
+
+void WrDiskCache::evict()
+{
+  // Evict down to 3/4 of the limit rather than just under it.  The
+  // largest entry comes first in set_, and it is at least as large as
+  // the growth which exceeded the limit, so evicting just under the
+  // limit flushes exactly one entry each time and adjacent pieces are
+  // never merged into one write.  The cost is that the cache is 1/4
+  // less full right after the eviction.
+  auto target = limit_ - limit_ / 4;
+  std::vector<WrDiskCacheEntry*> evicted;
+  while (total_ > target) {
     auto i = set_.begin();
     WrDiskCacheEntry* ent = *i;
+    if (ent->getSize() == 0) {
+      break;
+    }
     A2_LOG_DEBUG(fmt("Force flush cache entry size=%lu, clock=%" PRId64,
                      static_cast<unsigned long>(ent->getSizeKey()),
                      ent->getLastUpdate()));
     total_ -= ent->getSize();
-    ent->writeToDisk();
     set_.erase(i);
-
+    evicted.push_back(ent);
+  }
+  // Write the entries of each DiskAdaptor in the order of file offset.
+  std::sort(std::begin(evicted), std::end(evicted),
+            [](const WrDiskCacheEntry* lhs, const WrDiskCacheEntry* rhs) {
+              auto ldisk = lhs->getDiskAdaptor().get();
+              auto rdisk = rhs->getDiskAdaptor().get();
+              return std::less<DiskAdaptor*>()(ldisk, rdisk) ||
+                     (ldisk == rdisk &&
+                      getFirstOffset(lhs) < getFirstOffset(rhs));
+            });
+  std::vector<WrDiskCacheEntry*> entries;
+  for (auto i = std::begin(evicted), eoi = std::end(evicted); i != eoi;) {
+    auto diskAdaptor = (*i)->getDiskAdaptor().get();
+    entries.clear();
+    for (; i != eoi && (*i)->getDiskAdaptor().get() == diskAdaptor; ++i) {
+      if (!diskWriteQueue_ || !diskWriteQueue_->push(*i)) {
+        entries.push_back(*i);
+      }
+    }
+    WrDiskCacheEntry::writeToDisk(entries);
+  }
+  for (auto ent : evicted) {
     ent->setSizeKey(ent->getSize());
     ent->setLastUpdate(++clock_);
     set_.insert(ent);
   }
+  const auto& pool = WrDiskCacheEntry::getDataPool();
+  A2_LOG_DEBUG(fmt("Cache buffer pool live=%lu, free=%lu, slabs=%lu",
+                   static_cast<unsigned long>(pool.countLive()),
+                   static_cast<unsigned long>(pool.countFree()),
+                   static_cast<unsigned long>(pool.countSlabs())));
+}
+
+void WrDiskCache::setDiskWriteQueue(std::unique_ptr<DiskWriteQueue> queue)
+{
+  diskWriteQueue_ = std::move(queue);
+}
+
+bool WrDiskCache::isWriteQueueFull() const
+{
+  return diskWriteQueue_ && diskWriteQueue_->isFull();
 }
 
 } // namespace aria2
@@ -38,12 +38,15 @@
 #include "common.h"
 
 #include <set>
+#include <memory>
 
 #include "a2functional.h"
 
 namespace aria2 {
 
 class WrDiskCacheEntry;
+class DiskWriteQueue;
+class RdDiskCache;
 
 class WrDiskCache {
 public:
@@ -60,11 +63,25 @@ public:
   // negative value.
   bool update(WrDiskCacheEntry* ent, ssize_t delta);
   // Evicts entries from storage so that total size of cache is kept
-  // under the limit.
+  // under the limit.  Then the pieces of RdDiskCache are evicted so
+  // that the total size of both caches is kept under the limit.
   void ensureLimit();
   size_t getSize() const { return total_; }
+  // Makes ensureLimit() write evicted entries with |queue| instead of
+  // writing them synchronously.
+  void setDiskWriteQueue(std::unique_ptr<DiskWriteQueue> queue);
+  DiskWriteQueue* getDiskWriteQueue() const { return diskWriteQueue_.get(); }
+  // Returns true if the asynchronous writes reach the limit, and
+  // downloads should stop receiving data for a while.
+  bool isWriteQueueFull() const;
+  // Sets RdDiskCache which shares the limit with this object.
+  // |rdDiskCache| may be nullptr.
+  void setRdDiskCache(RdDiskCache* rdDiskCache) { rdDiskCache_ = rdDiskCache; }
 
 private:
+  // Flushes entries until the total size goes below the limit.
+  void evict();
+
   typedef std::set<WrDiskCacheEntry*, DerefLess<WrDiskCacheEntry*>> EntrySet;
   // Maximum number of bytes the storage can cache.
   size_t limit_;
@@ -72,6 +89,8 @@ private:
   size_t total_;
   EntrySet set_;
   int64_t clock_;
+  std::unique_ptr<DiskWriteQueue> diskWriteQueue_;
+  RdDiskCache* rdDiskCache_;
 };
 
 } // namespace aria2
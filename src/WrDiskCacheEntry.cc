@@ -35,8 +35,13 @@
 #include "WrDiskCacheEntry.h"
 
 #include <cstring>
+#include <cerrno>
+#include <cassert>
+#include <algorithm>
 
 #include "DiskAdaptor.h"
+#include "SlabPool.h"
+#include "DiskWriteQueue.h"
 #include "RecoverableException.h"
 #include "DownloadFailureException.h"
 #include "LogFactory.h"
@@ -44,6 +49,41 @@
 
 namespace aria2 {
 
+namespace {
+// The size of BitTorrent block and the maximum socket read size, so
+// that a cell fits in one block.
+constexpr size_t DATA_BLOCK_SIZE = 16_k;
+// 1MiB slabs.  Keep 4 empty slabs to absorb fluctuation.
+constexpr size_t DATA_BLOCKS_PER_SLAB = 64;
+constexpr size_t MAX_EMPTY_DATA_SLABS = 4;
+
+SlabPool& getPool()
+{
+  static SlabPool pool(DATA_BLOCK_SIZE, DATA_BLOCKS_PER_SLAB,
+                       MAX_EMPTY_DATA_SLABS);
+  return pool;
+}
+} // namespace
+
+unsigned char* WrDiskCacheEntry::allocateData(size_t len, size_t& capacity)
+{
+  if (len <= DATA_BLOCK_SIZE) {
+    capacity = DATA_BLOCK_SIZE;
+    return getPool().allocate();
+  }
+  capacity = len;
+  return new unsigned char[len];
+}
+
+void WrDiskCacheEntry::freeData(unsigned char* data)
+{
+  if (!getPool().deallocate(data)) {
+    delete[] data;
+  }
+}
+
+const SlabPool& WrDiskCacheEntry::getDataPool() { return getPool(); }
+
 WrDiskCacheEntry::WrDiskCacheEntry(
     const std::shared_ptr<DiskAdaptor>& diskAdaptor)
     : sizeKey_(0),
@@ -57,6 +97,12 @@ WrDiskCacheEntry::WrDiskCacheEntry(
 
 WrDiskCacheEntry::~WrDiskCacheEntry()
 {
+  // The pending write jobs own their data and file descriptors, so we
+  // don't have to wait for them.  The callback may refer to the owner
+  // of this entry.
+  if (asyncWriteState_) {
+    asyncWriteState_->callback_ = nullptr;
+  }
   if (!set_.empty()) {
     A2_LOG_WARN(fmt("WrDiskCacheEntry is not empty size=%lu",
                     static_cast<unsigned long>(size_)));
@@ -67,15 +113,19 @@ WrDiskCacheEntry::~WrDiskCacheEntry()
 void WrDiskCacheEntry::deleteDataCells()
 {
   for (auto& e : set_) {
-    delete[] e->data;
+    freeData(e->data);
     delete e;
   }
   set_.clear();
   size_ = 0;
 }
 
-void WrDiskCacheEntry::writeToDisk()
+void WrDiskCacheEntry::writeToDisk(DiskWriteQueue* queue)
 {
+  takeAsyncWriteError();
+  if (queue && isAsyncWritePending() && queue->push(this)) {
+    return;
+  }
   try {
     diskAdaptor_->writeCache(this);
   }
@@ -87,14 +137,202 @@ void WrDiskCacheEntry::writeToDisk()
   deleteDataCells();
 }
 
-void WrDiskCacheEntry::clear() { deleteDataCells(); }
+void WrDiskCacheEntry::writeToDisk(
+    const std::vector<WrDiskCacheEntry*>& entries)
+{
+  if (entries.empty()) {
+    return;
+  }
+  auto& diskAdaptor = entries.front()->diskAdaptor_;
+  for (auto ent : entries) {
+    assert(ent->diskAdaptor_ == diskAdaptor);
+    ent->takeAsyncWriteError();
+  }
+  try {
+    for (auto ent : entries) {
+      diskAdaptor->queueCache(ent);
+    }
+    diskAdaptor->flushCache();
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_INFO_EX("Merged write of write cache failed. Writing each entry"
+                   " separately",
+                   e);
+    // Writes of different entries may be merged, so we cannot tell
+    // which entries failed.  Write them again one by one, so that the
+    // error is recorded only to the entries whose data cannot be
+    // written.  The writes left queued by the failure are completed
+    // first, ignoring errors, so that they are not blamed on the first
+    // entry.  Their data are written again below anyway.
+    try {
+      diskAdaptor->flushCache();
+    }
+    catch (RecoverableException& ex) {
+    }
+    for (auto ent : entries) {
+      try {
+        diskAdaptor->writeCache(ent);
+      }
+      catch (RecoverableException& ex) {
+        A2_LOG_ERROR_EX("Error when trying to flush write cache", ex);
+        ent->error_ = CACHE_ERR_ERROR;
+        ent->errorCode_ = ex.getErrorCode();
+      }
+    }
+  }
+  for (auto ent : entries) {
+    ent->deleteDataCells();
+  }
+}
+
+void WrDiskCacheEntry::clear()
+{
+  // The data being written are discarded as well.  They still reach
+  // the file, but the write jobs of the data cached later run after
+  // them.
+  if (asyncWriteState_) {
+    asyncWriteState_->writing_.clear();
+  }
+  deleteDataCells();
+}
+
+std::shared_ptr<WrDiskCacheEntry::AsyncWriteState>
+WrDiskCacheEntry::startAsyncWrite(DataCellSet& cells, uint64_t& seq)
+{
+  if (!asyncWriteState_) {
+    asyncWriteState_ = std::make_shared<AsyncWriteState>();
+  }
+  {
+#ifdef HAVE_STD_THREAD
+    std::lock_guard<std::mutex> lock(asyncWriteState_->mutex_);
+#endif // HAVE_STD_THREAD
+    ++asyncWriteState_->numPending_;
+  }
+  seq = ++asyncWriteState_->nextSeq_;
+  cells.swap(set_);
+  set_.clear();
+  size_ = 0;
+  asyncWriteState_->writing_[seq] = &cells;
+  return asyncWriteState_;
+}
+
+bool WrDiskCacheEntry::isAsyncWritePending() const
+{
+  return asyncWriteState_ && asyncWriteState_->isPending();
+}
+
+void WrDiskCacheEntry::setAsyncWriteCallback(
+    std::function<void(int)> callback)
+{
+  assert(!callback || isAsyncWritePending());
+  if (asyncWriteState_) {
+    asyncWriteState_->callback_ = std::move(callback);
+  }
+}
+
+void WrDiskCacheEntry::getDataCells(std::vector<const DataCell*>& cells) const
+{
+  cells.assign(std::begin(set_), std::end(set_));
+  if (!asyncWriteState_ || asyncWriteState_->writing_.empty()) {
+    return;
+  }
+  for (auto& e : asyncWriteState_->writing_) {
+    cells.insert(std::end(cells), std::begin(*e.second), std::end(*e.second));
+  }
+  // The cached data come first among the cells of the same offset,
+  // since they are newer.
+  std::stable_sort(std::begin(cells), std::end(cells),
+                   [](const DataCell* lhs, const DataCell* rhs) {
+                     return lhs->goff < rhs->goff;
+                   });
+}
+
+void WrDiskCacheEntry::takeAsyncWriteError()
+{
+  if (!asyncWriteState_) {
+    return;
+  }
+  int errNum = asyncWriteState_->takeError();
+  if (errNum != 0) {
+    error_ = CACHE_ERR_ERROR;
+    errorCode_ = errNum == ENOSPC ? error_code::NOT_ENOUGH_DISK_SPACE
+                                  : error_code::FILE_IO_ERROR;
+  }
+}
+
+WrDiskCacheEntry::AsyncWriteState::AsyncWriteState()
+    : numPending_(0), finishedSeq_(0), errNum_(0), nextSeq_(0)
+{
+}
+
+void WrDiskCacheEntry::AsyncWriteState::waitTurn(uint64_t seq)
+{
+#ifdef HAVE_STD_THREAD
+  // WorkerPool starts jobs in the order they were submitted, so the
+  // job we are waiting for is already running in another thread.
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this, seq] { return finishedSeq_ + 1 >= seq; });
+#endif // HAVE_STD_THREAD
+}
+
+void WrDiskCacheEntry::AsyncWriteState::finish(int errNum)
+{
+  {
+#ifdef HAVE_STD_THREAD
+    std::lock_guard<std::mutex> lock(mutex_);
+#endif // HAVE_STD_THREAD
+    --numPending_;
+    ++finishedSeq_;
+    if (errNum_ == 0) {
+      errNum_ = errNum;
+    }
+  }
+#ifdef HAVE_STD_THREAD
+  cond_.notify_all();
+#endif // HAVE_STD_THREAD
+}
+
+void WrDiskCacheEntry::AsyncWriteState::release(uint64_t seq)
+{
+  writing_.erase(seq);
+}
+
+int WrDiskCacheEntry::AsyncWriteState::takeError()
+{
+#ifdef HAVE_STD_THREAD
+  std::lock_guard<std::mutex> lock(mutex_);
+#endif // HAVE_STD_THREAD
+  int errNum = errNum_;
+  errNum_ = 0;
+  return errNum;
+}
+
+bool WrDiskCacheEntry::AsyncWriteState::isPending()
+{
+#ifdef HAVE_STD_THREAD
+  std::lock_guard<std::mutex> lock(mutex_);
+#endif // HAVE_STD_THREAD
+  return numPending_ > 0;
+}
+
+void WrDiskCacheEntry::AsyncWriteState::checkDone()
+{
+  if (!callback_ || isPending()) {
+    return;
+  }
+  auto callback = std::move(callback_);
+  callback_ = nullptr;
+  callback(takeError());
+}
 
 bool WrDiskCacheEntry::cacheData(DataCell* dataCell)
 {
   A2_LOG_DEBUG(fmt("WrDiskCacheEntry cache goff=%" PRId64 ", len=%lu",
                    dataCell->goff, static_cast<unsigned long>(dataCell->len)));
   if (set_.insert(dataCell).second) {
-    size_ += dataCell->len;
+    // The whole buffer is accounted, since the rest of it is reserved
+    // for appending.
+    size_ += dataCell->offset + dataCell->capacity;
     return true;
   }
   else {
@@ -105,21 +343,37 @@ bool WrDiskCacheEntry::cacheData(DataCell* dataCell)
 size_t WrDiskCacheEntry::append(int64_t goff, const unsigned char* data,
                                 size_t len)
 {
-  if (set_.empty()) {
+  size_t wlen;
+  auto buf = getAppendBuffer(goff, wlen);
+  if (!buf) {
     return 0;
   }
-  auto i = set_.end();
-  --i;
-  if (static_cast<int64_t>((*i)->goff + (*i)->len) == goff) {
-    size_t wlen = std::min((*i)->capacity - (*i)->len, len);
-    memcpy((*i)->data + (*i)->offset + (*i)->len, data, wlen);
-    (*i)->len += wlen;
-    size_ += wlen;
-    return wlen;
-  }
-  else {
-    return 0;
+  wlen = std::min(wlen, len);
+  memcpy(buf, data, wlen);
+  commitAppend(wlen);
+  return wlen;
+}
+
+unsigned char* WrDiskCacheEntry::getAppendBuffer(int64_t goff, size_t& len)
+{
+  if (!set_.empty()) {
+    auto cell = *set_.rbegin();
+    if (static_cast<int64_t>(cell->goff + cell->len) == goff &&
+        cell->len < cell->capacity) {
+      len = cell->capacity - cell->len;
+      return cell->data + cell->offset + cell->len;
+    }
   }
+  len = 0;
+  return nullptr;
+}
+
+void WrDiskCacheEntry::commitAppend(size_t len)
+{
+  assert(!set_.empty());
+  auto cell = *set_.rbegin();
+  assert(cell->len + len <= cell->capacity);
+  cell->len += len;
 }
 
 } // namespace aria2
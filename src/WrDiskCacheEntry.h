@@ -38,7 +38,14 @@
 #include "common.h"
 
 #include <set>
+#include <map>
+#include <vector>
 #include <memory>
+#include <functional>
+#ifdef HAVE_STD_THREAD
+#  include <mutex>
+#  include <condition_variable>
+#endif // HAVE_STD_THREAD
 
 #include "a2functional.h"
 #include "error_code.h"
@@ -47,6 +54,8 @@ namespace aria2 {
 
 class DiskAdaptor;
 class WrDiskCache;
+class DiskWriteQueue;
+class SlabPool;
 
 class WrDiskCacheEntry {
 public:
@@ -65,14 +74,101 @@ public:
 
   typedef std::set<DataCell*, DerefLess<DataCell*>> DataCellSet;
 
+  // Allocates the buffer of DataCell which can hold at least |len|
+  // bytes, and stores its usable size in |capacity|.  Buffers up to
+  // 16KiB are drawn from a SlabPool shared by all downloads.
+  static unsigned char* allocateData(size_t len, size_t& capacity);
+  // Frees |data| allocated by allocateData() or new[].
+  static void freeData(unsigned char* data);
+  // Returns the pool of DataCell buffers.
+  static const SlabPool& getDataPool();
+
+  // Tracks the writes of this entry's data which are performed in
+  // worker threads by DiskWriteQueue.  It is shared with the write
+  // jobs, which may outlive this entry.
+  class AsyncWriteState {
+  public:
+    AsyncWriteState();
+    // Called by the write job with the sequence number |seq| in a
+    // worker thread before it writes.  Blocks until the jobs started
+    // before it finish, so that the data reach the file in the order
+    // they were queued even if they overlap.
+    void waitTurn(uint64_t seq);
+    // Called by the write job when it finished.  |errNum| is the
+    // errno of the failed write, or 0.
+    void finish(int errNum);
+    // Called in the event loop thread when the completion of the write
+    // job with the sequence number |seq| is processed.
+    void release(uint64_t seq);
+    // Returns the errno of the first failed write and clears it, or 0.
+    // This function does not block.
+    int takeError();
+    // Returns true if a write job has not finished yet.
+    bool isPending();
+    // Called in the event loop thread after release().  If no write
+    // job is pending, calls the callback set by
+    // WrDiskCacheEntry::setAsyncWriteCallback() with takeError().
+    void checkDone();
+
+  private:
+    friend class WrDiskCacheEntry;
+#ifdef HAVE_STD_THREAD
+    std::mutex mutex_;
+    std::condition_variable cond_;
+#endif // HAVE_STD_THREAD
+    size_t numPending_;
+    // The sequence number of the last finished job.
+    uint64_t finishedSeq_;
+    int errNum_;
+    // The rest is accessed only in the event loop thread.
+    uint64_t nextSeq_;
+    // The data being written, which are owned by the write jobs.  The
+    // data discarded by clear() are not listed.
+    std::map<uint64_t, const DataCellSet*> writing_;
+    std::function<void(int)> callback_;
+  };
+
   WrDiskCacheEntry(const std::shared_ptr<DiskAdaptor>& diskAdaptor);
   ~WrDiskCacheEntry();
 
-  // Flushes the cached data to the disk and deletes them.
-  void writeToDisk();
+  // Flushes the cached data to the disk and deletes them.  If the
+  // asynchronous writes of this entry are in progress, the data are
+  // queued to |queue| after them rather than written here, so that the
+  // event loop does not wait for the worker threads.  The error of the
+  // asynchronous writes finished so far is recorded to this entry.
+  void writeToDisk(DiskWriteQueue* queue = nullptr);
+  // Flushes the cached data of |entries|, which must share the same
+  // DiskAdaptor, and deletes them.  The entries should be sorted by
+  // offset, so that adjacent data of different entries are written
+  // together.  If the write fails, each entry is written again
+  // separately, and the error is recorded only to the entries which
+  // fail again.
+  static void writeToDisk(const std::vector<WrDiskCacheEntry*>& entries);
   // Deletes cached data without flushing to the disk.
   void clear();
 
+  // Moves the cached data to |cells| in order to write them in a
+  // worker thread, and returns the state which the write job must
+  // finish.  The sequence number of the job is stored in |seq|.
+  // |cells| must stay alive until AsyncWriteState::release() is
+  // called.
+  std::shared_ptr<AsyncWriteState> startAsyncWrite(DataCellSet& cells,
+                                                   uint64_t& seq);
+  // Returns true if an asynchronous write of this entry is in
+  // progress, and the file does not have all the data yet.
+  bool isAsyncWritePending() const;
+  // Makes |callback| called once in the event loop thread when the
+  // asynchronous writes in progress have finished, with the errno of
+  // the first failed write, or 0.  The error is not recorded to this
+  // entry.  nullptr cancels the callback.  isAsyncWritePending() must
+  // be true when a callback is set.
+  void setAsyncWriteCallback(std::function<void(int)> callback);
+  // Stores the cached data and the data being written asynchronously
+  // to |cells| in the order of offset.  The regions of the cells may
+  // overlap.  The pointers are valid until the next event loop
+  // iteration.
+  void getDataCells(std::vector<const DataCell*>& cells) const;
+
   // Caches |dataCell|
   bool cacheData(DataCell* dataCell);
 
@@ -80,6 +176,18 @@ public:
   // contagious. Returns the number of copied bytes.
   size_t append(int64_t goff, const unsigned char* data, size_t len);
 
+  // Returns the unused space of last dataCell in set_ if the region
+  // starting at |goff| is contagious, and stores its size in |len|.
+  // Otherwise returns nullptr.  The data written to the returned
+  // buffer is cached by commitAppend().
+  unsigned char* getAppendBuffer(int64_t goff, size_t& len);
+  // Caches |len| bytes written to the buffer returned by
+  // getAppendBuffer().
+  void commitAppend(size_t len);
+
+  // Returns the size of the buffers of the cached data.  It includes
+  // the unused space of the buffers, e.g. a cell of 1 byte drawn from
+  // the pool of 16KiB blocks counts as 16KiB.
   size_t getSize() const { return size_; }
   void setSizeKey(size_t sizeKey) { sizeKey_ = sizeKey; }
   size_t getSizeKey() const { return sizeKey_; }
@@ -98,9 +206,17 @@ public:
 
   const DataCellSet& getDataSet() const { return set_; }
 
+  const std::shared_ptr<DiskAdaptor>& getDiskAdaptor() const
+  {
+    return diskAdaptor_;
+  }
+
 private:
   void deleteDataCells();
 
+  // Records the error of the finished asynchronous writes.
+  void takeAsyncWriteError();
+
   size_t sizeKey_;
   int64_t lastUpdate_;
 
@@ -112,6 +228,8 @@ private:
   error_code::Value errorCode_;
 
   std::shared_ptr<DiskAdaptor> diskAdaptor_;
+
+  std::shared_ptr<AsyncWriteState> asyncWriteState_;
 };
 
 } // namespace aria2
@@ -38,6 +38,7 @@
 #include "common.h"
 
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 
 namespace aria2 {
@@ -62,6 +63,12 @@ public:
 };
 
 // Expression Template for array
+//
+// Besides element access with operator[], each expression can be
+// evaluated 8 elements at a time with word(i), which returns the
+// elements [8 * i, 8 * i + 8) packed into a 64 bit word in memory
+// order.  word(i) is only meaningful for arrays of unsigned char, and
+// the caller must not read past the end of the underlying arrays.
 
 namespace expr {
 
@@ -75,20 +82,38 @@ template <typename L, typename R, typename Op> struct BinExpr {
 
   value_type operator[](size_t i) const { return op(lhs[i], rhs[i]); }
 
+  uint64_t word(size_t i) const { return op.word(lhs.word(i), rhs.word(i)); }
+
   L lhs;
   R rhs;
   Op op;
 };
 
+template <typename T> struct bit_and {
+  typedef T result_type;
+
+  T operator()(T lhs, T rhs) const { return lhs & rhs; }
+
+  uint64_t word(uint64_t lhs, uint64_t rhs) const { return lhs & rhs; }
+};
+
+template <typename T> struct bit_or {
+  typedef T result_type;
+
+  T operator()(T lhs, T rhs) const { return lhs | rhs; }
+
+  uint64_t word(uint64_t lhs, uint64_t rhs) const { return lhs | rhs; }
+};
+
 template <typename L, typename R,
-          typename Op = std::bit_and<typename L::value_type>>
+          typename Op = bit_and<typename L::value_type>>
 BinExpr<L, R, Op> operator&(L lhs, R rhs)
 {
   return BinExpr<L, R, Op>(std::forward<L>(lhs), std::forward<R>(rhs), Op());
 }
 
 template <typename L, typename R,
-          typename Op = std::bit_or<typename L::value_type>>
+          typename Op = bit_or<typename L::value_type>>
 BinExpr<L, R, Op> operator|(L lhs, R rhs)
 {
   return BinExpr<L, R, Op>(std::forward<L>(lhs), std::forward<R>(rhs), Op());
@@ -101,12 +126,18 @@ template <typename Arg, typename Op> struct UnExpr {
 
   value_type operator[](size_t i) const { return op(arg[i]); }
 
+  uint64_t word(size_t i) const { return op.word(arg.word(i)); }
+
   Arg arg;
   Op op;
 };
 
-template <typename T> struct bit_neg : std::function<T(T)> {
+template <typename T> struct bit_neg {
+  typedef T result_type;
+
   T operator()(T t) const { return ~t; }
+
+  uint64_t word(uint64_t t) const { return ~t; }
 };
 
 template <typename Arg, typename Op = bit_neg<typename Arg::value_type>>
@@ -122,6 +153,14 @@ template <typename T> struct Array {
 
   T operator[](size_t i) const { return t[i]; }
 
+  uint64_t word(size_t i) const
+  {
+    static_assert(sizeof(T) == 1, "word() requires an array of bytes");
+    uint64_t v;
+    memcpy(&v, t + i * sizeof(v), sizeof(v));
+    return v;
+  }
+
   T* t;
 };
 
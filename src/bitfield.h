@@ -40,8 +40,10 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 
 #include "util.h"
+#include "array_fun.h"
 
 namespace aria2 {
 
@@ -94,6 +96,81 @@ inline size_t countBit32(uint32_t n)
          cntbits[(n >> 16) & 0xffu] + cntbits[(n >> 24) & 0xffu];
 }
 
+inline size_t countBit64(uint64_t n)
+{
+#if defined(__GNUC__) && (defined(__POPCNT__) || defined(__aarch64__))
+  return __builtin_popcountll(n);
+#else  // !(defined(__GNUC__) && (defined(__POPCNT__) || defined(__aarch64__)))
+  // Without a population count instruction, __builtin_popcountll
+  // ends up in a table driven libgcc routine, which is slower than
+  // this.
+  n -= (n >> 1) & 0x5555555555555555llu;
+  n = (n & 0x3333333333333333llu) + ((n >> 2) & 0x3333333333333333llu);
+  n = (n + (n >> 4)) & 0x0f0f0f0f0f0f0f0fllu;
+  return (n * 0x0101010101010101llu) >> 56;
+#endif // !(defined(__GNUC__) && (defined(__POPCNT__) || defined(__aarch64__)))
+}
+
+// Returns the number of leading zero bits in n.  n must not be 0.
+inline size_t countLeadingZero64(uint64_t n)
+{
+  assert(n);
+#ifdef __GNUC__
+  return __builtin_clzll(n);
+#else  // !__GNUC__
+  size_t c = 0;
+  for (; !(n & 0x8000000000000000llu); n <<= 1, ++c)
+    ;
+  return c;
+#endif // !__GNUC__
+}
+
+// Returns i-th 64 bits word of bitfield, that is the bits [64 * i,
+// 64 * i + 64), in memory order.  The bitfield must contain the whole
+// word.
+template <typename T> inline uint64_t getWord(T* bitfield, size_t i)
+{
+  static_assert(sizeof(T) == 1, "bitfield must be an array of bytes");
+  uint64_t v;
+  memcpy(&v, bitfield + i * sizeof(v), sizeof(v));
+  return v;
+}
+
+template <typename L, typename R, typename Op>
+inline uint64_t getWord(const expr::BinExpr<L, R, Op>& bitfield, size_t i)
+{
+  return bitfield.word(i);
+}
+
+template <typename Arg, typename Op>
+inline uint64_t getWord(const expr::UnExpr<Arg, Op>& bitfield, size_t i)
+{
+  return bitfield.word(i);
+}
+
+template <typename T>
+inline uint64_t getWord(const expr::Array<T>& bitfield, size_t i)
+{
+  return bitfield.word(i);
+}
+
+// Fallback for the other indexable containers, such as array_wrapper.
+template <typename Array>
+inline uint64_t getWord(const Array& bitfield, size_t i)
+{
+  unsigned char buf[sizeof(uint64_t)];
+  for (size_t j = 0; j < sizeof(buf); ++j) {
+    buf[j] = bitfield[i * sizeof(buf) + j];
+  }
+  uint64_t v;
+  memcpy(&v, buf, sizeof(v));
+  return v;
+}
+
+// Converts a word returned by getWord() so that the bit for the
+// lowest index becomes the most significant bit.
+inline uint64_t wordToBitOrder(uint64_t v) { return ntoh64(v); }
+
 // Counts set bit in bitfield.
 inline size_t countSetBit(const unsigned char* bitfield, size_t nbits)
 {
@@ -101,21 +178,16 @@ inline size_t countSetBit(const unsigned char* bitfield, size_t nbits)
     return 0;
   }
   size_t count = 0;
-  size_t size = sizeof(uint32_t);
-  size_t len = (nbits + 7) / 8;
-  if (nbits % 32 != 0) {
-    --len;
-    count +=
-        countBit32(static_cast<uint32_t>(bitfield[len] & lastByteMask(nbits)));
+  size_t nwords = nbits / 64;
+  for (size_t i = 0; i < nwords; ++i) {
+    count += countBit64(getWord(bitfield, i));
   }
-  size_t to = len / size;
-  for (size_t i = 0; i < to; ++i) {
-    uint32_t v;
-    memcpy(&v, &bitfield[i * size], sizeof(v));
-    count += countBit32(v);
+  size_t len = (nbits + 7) / 8;
+  for (size_t i = nwords * 8; i < len - 1; ++i) {
+    count += cntbits[bitfield[i]];
   }
-  for (size_t i = len - len % size; i < len; ++i) {
-    count += countBit32(static_cast<uint32_t>(bitfield[i]));
+  if (len > nwords * 8) {
+    count += cntbits[bitfield[len - 1] & lastByteMask(nbits)];
   }
   return count;
 }
@@ -129,31 +201,74 @@ size_t countSetBitSlow(const Array& bitfield, size_t nbits)
     return 0;
   }
   size_t count = 0;
-  size_t to = (nbits + 7) / 8;
-  if (to > 1) {
-    for (size_t i = 0; i < to - 1; ++i) {
-      count += cntbits[static_cast<unsigned char>(bitfield[i])];
-    }
+  size_t nwords = nbits / 64;
+  for (size_t i = 0; i < nwords; ++i) {
+    count += countBit64(getWord(bitfield, i));
+  }
+  size_t len = (nbits + 7) / 8;
+  for (size_t i = nwords * 8; i < len - 1; ++i) {
+    count += cntbits[static_cast<unsigned char>(bitfield[i])];
+  }
+  if (len > nwords * 8) {
+    count += cntbits[static_cast<unsigned char>(bitfield[len - 1]) &
+                     lastByteMask(nbits)];
   }
-  count += cntbits[static_cast<unsigned char>(bitfield[to - 1]) &
-                   lastByteMask(nbits)];
   return count;
 }
 
 void flipBit(unsigned char* data, size_t length, size_t bitIndex);
 
+// Calls fun(index) for each set bit index in bitfield in ascending
+// order, until fun returns false.  bitfield contains nbits bits.
+// Returns false if fun returned false.  Otherwise returns true.
+template <typename Array, typename Fun>
+bool forEachSetBit(const Array& bitfield, size_t nbits, Fun fun)
+{
+  size_t nwords = nbits / 64;
+  for (size_t i = 0; i < nwords; ++i) {
+    uint64_t v = getWord(bitfield, i);
+    if (v == 0) {
+      continue;
+    }
+    v = wordToBitOrder(v);
+    do {
+      size_t c = countLeadingZero64(v);
+      if (!fun(i * 64 + c)) {
+        return false;
+      }
+      v ^= 0x8000000000000000llu >> c;
+    } while (v);
+  }
+  for (size_t i = nwords * 64; i < nbits; i += 8) {
+    unsigned char v = bitfield[i / 8];
+    if (i + 8 > nbits) {
+      v &= lastByteMask(nbits);
+    }
+    for (size_t j = i; v; v <<= 1, ++j) {
+      if ((v & 0x80u) && !fun(j)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 // Stores first set bit index of bitfield to index.  bitfield contains
 // nbits. Returns true if set bit is found. Otherwise returns false.
 template <typename Array>
 bool getFirstSetBitIndex(size_t& index, const Array& bitfield, size_t nbits)
 {
-  for (size_t i = 0; i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      index = i;
-      return true;
-    }
-  }
-  return false;
+  return !forEachSetBit(bitfield, nbits, [&index](size_t i) {
+    index = i;
+    return false;
+  });
+}
+
+// Returns true if bitfield contains at least one set bit.  bitfield
+// contains nbits bits.
+template <typename Array> bool anySetBit(const Array& bitfield, size_t nbits)
+{
+  return !forEachSetBit(bitfield, nbits, [](size_t) { return false; });
 }
 
 // Appends first at most n set bit index in bitfield to out.  bitfield
@@ -165,16 +280,65 @@ size_t getFirstNSetBitIndex(OutputIterator out, size_t n, const Array& bitfield,
   if (n == 0) {
     return 0;
   }
-  const size_t origN = n;
-  for (size_t i = 0; i < nbits; ++i) {
-    if (bitfield::test(bitfield, nbits, i)) {
-      *out++ = i;
-      if (--n == 0) {
-        break;
+  size_t count = 0;
+  forEachSetBit(bitfield, nbits, [&out, &count, n](size_t i) {
+    *out++ = i;
+    return ++count < n;
+  });
+  return count;
+}
+
+// Applies op to counts[i] for each set bit index i in bitfield.
+// bitfield contains nbits bits.  op is an int(int) function object.
+// A run of 64 set bits is handled in a straight loop, which compilers
+// can vectorize.
+template <typename Array, typename Op>
+void updateCounts(int* counts, const Array& bitfield, size_t nbits, Op op)
+{
+  size_t nwords = nbits / 64;
+  for (size_t i = 0; i < nwords; ++i) {
+    uint64_t v = getWord(bitfield, i);
+    if (v == 0) {
+      continue;
+    }
+    int* c = counts + i * 64;
+    if (v == UINT64_MAX) {
+      for (size_t j = 0; j < 64; ++j) {
+        c[j] = op(c[j]);
       }
+      continue;
+    }
+    v = wordToBitOrder(v);
+    do {
+      size_t j = countLeadingZero64(v);
+      c[j] = op(c[j]);
+      v ^= 0x8000000000000000llu >> j;
+    } while (v);
+  }
+  for (size_t i = nwords * 64; i < nbits; ++i) {
+    if (test(bitfield, nbits, i)) {
+      counts[i] = op(counts[i]);
     }
   }
-  return origN - n;
+}
+
+// Increments counts[i] by 1 for each set bit index i in bitfield.
+// The counts saturate at the maximum value of int.
+template <typename Array>
+void incrementCounts(int* counts, const Array& bitfield, size_t nbits)
+{
+  updateCounts(counts, bitfield, nbits, [](int x) {
+    return x < std::numeric_limits<int>::max() ? x + 1 : x;
+  });
+}
+
+// Decrements counts[i] by 1 for each set bit index i in bitfield.
+// The counts never go below 0.
+template <typename Array>
+void decrementCounts(int* counts, const Array& bitfield, size_t nbits)
+{
+  updateCounts(counts, bitfield, nbits,
+               [](int x) { return x > 0 ? x - 1 : x; });
 }
 
 } // namespace bitfield
@@ -73,6 +73,388 @@ template <typename T> static forceinline T par(T b, T c, T d)
 using namespace crypto;
 using namespace crypto::hash;
 
+// Hardware block functions. Each one hashes |n| consecutive 64 byte blocks
+// into |state|, which is kept in host byte order, just like the |transform|s
+// of the portable implementations below do.
+typedef void (*block_fn)(uint32_t* state, const uint8_t* data, size_t n);
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#  define HAVE_HASH_SHANI 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#endif // (__x86_64__ || __i386__) && (__clang__ || __GNUC__ >= 5)
+
+#if defined(__aarch64__) && defined(__AARCH64EL__) &&                          \
+    (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#  define HAVE_HASH_ARMV8 1
+#  include <arm_neon.h>
+#  ifdef __linux__
+#    include <sys/auxv.h>
+#    include <asm/hwcap.h>
+#  endif // __linux__
+#endif // __aarch64__ && __AARCH64EL__ && (__ARM_FEATURE_CRYPTO || ...)
+
+#if defined(HAVE_HASH_SHANI) || defined(HAVE_HASH_ARMV8)
+alignas(16) static const uint32_t sha256_k[] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+#endif // HAVE_HASH_SHANI || HAVE_HASH_ARMV8
+
+#ifdef HAVE_HASH_SHANI
+#  define __hash_target_shani __attribute__((target("sha,sse4.1,ssse3")))
+
+static bool cpu_has_shani()
+{
+  unsigned int a, b, c, d;
+  if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_SSSE3) ||
+      !(c & bit_SSE4_1) || __get_cpuid_max(0, nullptr) < 7) {
+    return false;
+  }
+  __cpuid_count(7, 0, a, b, c, d);
+  // EBX bit 29: SHA extensions
+  return b & (1u << 29);
+}
+
+// Four rounds per step. The message schedule of the words used 1, 2 and 3
+// steps later runs alongside, so that sha1msg1/sha1msg2 latency is hidden.
+__hash_target_shani static void sha1_shani(uint32_t* state,
+                                           const uint8_t* data, size_t n)
+{
+  const __m128i mask =
+      _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  auto abcd = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+  auto e0 = _mm_set_epi32(state[4], 0, 0, 0);
+  __m128i e1, m0, m1, m2, m3;
+
+#define ld(i)                                                                  \
+  _mm_shuffle_epi8(                                                            \
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), mask)
+#define r(ecur, eprev, f, w)                                                   \
+  ecur = _mm_sha1nexte_epu32(ecur, w);                                         \
+  eprev = abcd;                                                                \
+  abcd = _mm_sha1rnds4_epu32(abcd, ecur, f)
+#define s1(a, b) a = _mm_sha1msg1_epu32(a, b)
+#define s2(a, b) a = _mm_sha1msg2_epu32(a, b)
+#define sx(a, b) a = _mm_xor_si128(a, b)
+
+  for (; n; --n, data += 64) {
+    const auto abcd_save = abcd;
+    const auto e0_save = e0;
+
+    m0 = ld(0);
+    e0 = _mm_add_epi32(e0, m0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    m1 = ld(1);
+    r(e1, e0, 0, m1), s1(m0, m1);
+    m2 = ld(2);
+    r(e0, e1, 0, m2), s1(m1, m2), sx(m0, m2);
+    m3 = ld(3);
+    r(e1, e0, 0, m3), s2(m0, m3), s1(m2, m3), sx(m1, m3);
+    r(e0, e1, 0, m0), s2(m1, m0), s1(m3, m0), sx(m2, m0);
+
+    r(e1, e0, 1, m1), s2(m2, m1), s1(m0, m1), sx(m3, m1);
+    r(e0, e1, 1, m2), s2(m3, m2), s1(m1, m2), sx(m0, m2);
+    r(e1, e0, 1, m3), s2(m0, m3), s1(m2, m3), sx(m1, m3);
+    r(e0, e1, 1, m0), s2(m1, m0), s1(m3, m0), sx(m2, m0);
+    r(e1, e0, 1, m1), s2(m2, m1), s1(m0, m1), sx(m3, m1);
+
+    r(e0, e1, 2, m2), s2(m3, m2), s1(m1, m2), sx(m0, m2);
+    r(e1, e0, 2, m3), s2(m0, m3), s1(m2, m3), sx(m1, m3);
+    r(e0, e1, 2, m0), s2(m1, m0), s1(m3, m0), sx(m2, m0);
+    r(e1, e0, 2, m1), s2(m2, m1), s1(m0, m1), sx(m3, m1);
+    r(e0, e1, 2, m2), s2(m3, m2), s1(m1, m2), sx(m0, m2);
+
+    r(e1, e0, 3, m3), s2(m0, m3), s1(m2, m3), sx(m1, m3);
+    r(e0, e1, 3, m0), s2(m1, m0), s1(m3, m0), sx(m2, m0);
+    r(e1, e0, 3, m1), s2(m2, m1), sx(m3, m1);
+    r(e0, e1, 3, m2), s2(m3, m2);
+    r(e1, e0, 3, m3);
+
+    e0 = _mm_sha1nexte_epu32(e0, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
+
+#undef sx
+#undef s2
+#undef s1
+#undef r
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_shuffle_epi32(abcd, 0x1b));
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+// The state is kept as ABEF/CDGH, which is what sha256rnds2 works on.
+__hash_target_shani static void sha256_shani(uint32_t* state,
+                                             const uint8_t* data, size_t n)
+{
+  const __m128i mask =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  auto t = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1);
+  auto s1 = _mm_shuffle_epi32(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+  auto s0 = _mm_alignr_epi8(t, s1, 8);
+  s1 = _mm_blend_epi16(s1, t, 0xf0);
+  __m128i m0, m1, m2, m3;
+
+#define r(w, i)                                                                \
+  t = _mm_add_epi32(w, _mm_load_si128(reinterpret_cast<const __m128i*>(        \
+                           sha256_k + 4 * i)));                                \
+  s1 = _mm_sha256rnds2_epu32(s1, s0, t);                                       \
+  s0 = _mm_sha256rnds2_epu32(s0, s1, _mm_shuffle_epi32(t, 0x0e))
+#define u1(a, b) a = _mm_sha256msg1_epu32(a, b)
+#define u2(a, b, c)                                                            \
+  a = _mm_sha256msg2_epu32(_mm_add_epi32(a, _mm_alignr_epi8(b, c, 4)), b)
+
+  for (; n; --n, data += 64) {
+    const auto s0_save = s0;
+    const auto s1_save = s1;
+
+    m0 = ld(0);
+    r(m0, 0);
+    m1 = ld(1);
+    r(m1, 1), u1(m0, m1);
+    m2 = ld(2);
+    r(m2, 2), u1(m1, m2);
+    m3 = ld(3);
+    r(m3, 3), u2(m0, m3, m2), u1(m2, m3);
+    r(m0, 4), u2(m1, m0, m3), u1(m3, m0);
+    r(m1, 5), u2(m2, m1, m0), u1(m0, m1);
+    r(m2, 6), u2(m3, m2, m1), u1(m1, m2);
+    r(m3, 7), u2(m0, m3, m2), u1(m2, m3);
+    r(m0, 8), u2(m1, m0, m3), u1(m3, m0);
+    r(m1, 9), u2(m2, m1, m0), u1(m0, m1);
+    r(m2, 10), u2(m3, m2, m1), u1(m1, m2);
+    r(m3, 11), u2(m0, m3, m2), u1(m2, m3);
+    r(m0, 12), u2(m1, m0, m3), u1(m3, m0);
+    r(m1, 13), u2(m2, m1, m0);
+    r(m2, 14), u2(m3, m2, m1);
+    r(m3, 15);
+
+    s0 = _mm_add_epi32(s0, s0_save);
+    s1 = _mm_add_epi32(s1, s1_save);
+  }
+
+#undef u2
+#undef u1
+#undef r
+#undef ld
+
+  t = _mm_shuffle_epi32(s0, 0x1b);
+  s1 = _mm_shuffle_epi32(s1, 0xb1);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state),
+                   _mm_blend_epi16(t, s1, 0xf0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4),
+                   _mm_alignr_epi8(s1, t, 8));
+}
+#endif // HAVE_HASH_SHANI
+
+#ifdef HAVE_HASH_ARMV8
+static bool cpu_has_armv8_sha1()
+{
+#  if defined(__linux__) && defined(HWCAP_SHA1)
+  return getauxval(AT_HWCAP) & HWCAP_SHA1;
+#  else  // !__linux__ || !HWCAP_SHA1
+  // We were built for a CPU which has them.
+  return true;
+#  endif // !__linux__ || !HWCAP_SHA1
+}
+
+static bool cpu_has_armv8_sha2()
+{
+#  if defined(__linux__) && defined(HWCAP_SHA2)
+  return getauxval(AT_HWCAP) & HWCAP_SHA2;
+#  else  // !__linux__ || !HWCAP_SHA2
+  return true;
+#  endif // !__linux__ || !HWCAP_SHA2
+}
+
+#  define ld(i)                                                                \
+    vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)))
+
+static void sha1_armv8(uint32_t* state, const uint8_t* data, size_t n)
+{
+  auto abcd = vld1q_u32(state);
+  uint32_t e0 = state[4], e1;
+  uint32x4_t m0, m1, m2, m3;
+  const auto k0 = vdupq_n_u32(0x5a827999);
+  const auto k1 = vdupq_n_u32(0x6ed9eba1);
+  const auto k2 = vdupq_n_u32(0x8f1bbcdc);
+  const auto k3 = vdupq_n_u32(0xca62c1d6);
+
+#  define r(f, k, w)                                                           \
+    e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));                                  \
+    abcd = f(abcd, e0, vaddq_u32(w, k));                                       \
+    e0 = e1
+#  define u(a, b, c, d) a = vsha1su1q_u32(vsha1su0q_u32(a, b, c), d)
+
+  for (; n; --n, data += 64) {
+    const auto abcd_save = abcd;
+    const auto e0_save = e0;
+
+    m0 = ld(0), m1 = ld(1), m2 = ld(2), m3 = ld(3);
+    r(vsha1cq_u32, k0, m0);
+    r(vsha1cq_u32, k0, m1);
+    r(vsha1cq_u32, k0, m2);
+    r(vsha1cq_u32, k0, m3);
+    u(m0, m1, m2, m3), r(vsha1cq_u32, k0, m0);
+
+    u(m1, m2, m3, m0), r(vsha1pq_u32, k1, m1);
+    u(m2, m3, m0, m1), r(vsha1pq_u32, k1, m2);
+    u(m3, m0, m1, m2), r(vsha1pq_u32, k1, m3);
+    u(m0, m1, m2, m3), r(vsha1pq_u32, k1, m0);
+    u(m1, m2, m3, m0), r(vsha1pq_u32, k1, m1);
+
+    u(m2, m3, m0, m1), r(vsha1mq_u32, k2, m2);
+    u(m3, m0, m1, m2), r(vsha1mq_u32, k2, m3);
+    u(m0, m1, m2, m3), r(vsha1mq_u32, k2, m0);
+    u(m1, m2, m3, m0), r(vsha1mq_u32, k2, m1);
+    u(m2, m3, m0, m1), r(vsha1mq_u32, k2, m2);
+
+    u(m3, m0, m1, m2), r(vsha1pq_u32, k3, m3);
+    u(m0, m1, m2, m3), r(vsha1pq_u32, k3, m0);
+    u(m1, m2, m3, m0), r(vsha1pq_u32, k3, m1);
+    u(m2, m3, m0, m1), r(vsha1pq_u32, k3, m2);
+    u(m3, m0, m1, m2), r(vsha1pq_u32, k3, m3);
+
+    abcd = vaddq_u32(abcd, abcd_save);
+    e0 += e0_save;
+  }
+
+#  undef u
+#  undef r
+
+  vst1q_u32(state, abcd);
+  state[4] = e0;
+}
+
+static void sha256_armv8(uint32_t* state, const uint8_t* data, size_t n)
+{
+  auto s0 = vld1q_u32(state);
+  auto s1 = vld1q_u32(state + 4);
+  uint32x4_t m0, m1, m2, m3, t, s;
+
+#  define r(w, i)                                                              \
+    t = vaddq_u32(w, vld1q_u32(sha256_k + 4 * i));                             \
+    s = s0;                                                                    \
+    s0 = vsha256hq_u32(s0, s1, t);                                             \
+    s1 = vsha256h2q_u32(s1, s, t)
+#  define u(a, b, c, d) a = vsha256su1q_u32(vsha256su0q_u32(a, b), c, d)
+
+  for (; n; --n, data += 64) {
+    const auto s0_save = s0;
+    const auto s1_save = s1;
+
+    m0 = ld(0), m1 = ld(1), m2 = ld(2), m3 = ld(3);
+    r(m0, 0), r(m1, 1), r(m2, 2), r(m3, 3);
+    u(m0, m1, m2, m3), r(m0, 4);
+    u(m1, m2, m3, m0), r(m1, 5);
+    u(m2, m3, m0, m1), r(m2, 6);
+    u(m3, m0, m1, m2), r(m3, 7);
+    u(m0, m1, m2, m3), r(m0, 8);
+    u(m1, m2, m3, m0), r(m1, 9);
+    u(m2, m3, m0, m1), r(m2, 10);
+    u(m3, m0, m1, m2), r(m3, 11);
+    u(m0, m1, m2, m3), r(m0, 12);
+    u(m1, m2, m3, m0), r(m1, 13);
+    u(m2, m3, m0, m1), r(m2, 14);
+    u(m3, m0, m1, m2), r(m3, 15);
+
+    s0 = vaddq_u32(s0, s0_save);
+    s1 = vaddq_u32(s1, s1_save);
+  }
+
+#  undef u
+#  undef r
+
+  vst1q_u32(state, s0);
+  vst1q_u32(state + 4, s1);
+}
+
+#  undef ld
+#endif // HAVE_HASH_ARMV8
+
+bool crypto::hash::supports(Algorithms algo, Kernels kernel)
+{
+  switch (kernel) {
+  case kernelPortable:
+    return true;
+#ifdef HAVE_HASH_SHANI
+  case kernelSHANI: {
+    static const bool shani = cpu_has_shani();
+    return shani && (algo == algoSHA1 || algo == algoSHA224 ||
+                     algo == algoSHA256);
+  }
+#endif // HAVE_HASH_SHANI
+#ifdef HAVE_HASH_ARMV8
+  case kernelARMv8: {
+    static const bool sha1 = cpu_has_armv8_sha1();
+    static const bool sha2 = cpu_has_armv8_sha2();
+    return (sha1 && algo == algoSHA1) ||
+           (sha2 && (algo == algoSHA224 || algo == algoSHA256));
+  }
+#endif // HAVE_HASH_ARMV8
+  default:
+    return false;
+  }
+}
+
+Kernels crypto::hash::kernel(Algorithms algo)
+{
+  for (auto k : {kernelSHANI, kernelARMv8}) {
+    if (supports(algo, k)) {
+      return k;
+    }
+  }
+  return kernelPortable;
+}
+
+static block_fn sha1_blocks(Kernels kernel)
+{
+  switch (kernel) {
+#ifdef HAVE_HASH_SHANI
+  case kernelSHANI:
+    return sha1_shani;
+#endif // HAVE_HASH_SHANI
+#ifdef HAVE_HASH_ARMV8
+  case kernelARMv8:
+    return sha1_armv8;
+#endif // HAVE_HASH_ARMV8
+  default:
+    return nullptr;
+  }
+}
+
+static block_fn sha256_blocks(Kernels kernel)
+{
+  switch (kernel) {
+#ifdef HAVE_HASH_SHANI
+  case kernelSHANI:
+    return sha256_shani;
+#endif // HAVE_HASH_SHANI
+#ifdef HAVE_HASH_ARMV8
+  case kernelARMv8:
+    return sha256_armv8;
+#endif // HAVE_HASH_ARMV8
+  default:
+    return nullptr;
+  }
+}
+
 // Our base implementation, doing most of the work, short of |transform|,
 // |digest| and initialization.
 template <typename word_, uint_fast8_t bsize, uint_fast8_t ssize>
@@ -93,6 +475,14 @@ protected:
 
   virtual void transform(const word_t* buffer) = 0;
 
+  // Implementations with hardware block functions override this.
+  virtual void transformBlocks(const uint8_t* data, size_t n)
+  {
+    for (; n; --n, data += sizeof(buffer_)) {
+      transform(reinterpret_cast<const word_t*>(data));
+    }
+  }
+
   virtual std::string digest()
   {
     return std::string((const char*)state_.bytes, sizeof(state_.bytes));
@@ -119,19 +509,20 @@ public:
       bytes += turn;
       offset_ += turn;
       if (likely(offset_ == sizeof(buffer_))) {
-        transform(buffer_.words);
+        transformBlocks(buffer_.bytes, 1);
         offset_ = 0;
       }
     }
 
     // |transform| as many blocks as possible.
-    while (len >= sizeof(buffer_)) {
+    if (len >= sizeof(buffer_)) {
       // |offset_| has to be 0 at this point!
       // Which is guaranteed by the block above.
 
-      transform(reinterpret_cast<const word_t*>(bytes));
-      bytes += sizeof(buffer_);
-      len -= sizeof(buffer_);
+      const size_t n = len / sizeof(buffer_);
+      transformBlocks(bytes, n);
+      bytes += n * sizeof(buffer_);
+      len -= n * sizeof(buffer_);
     }
 
     // Buffer remaining bytes, if any.
@@ -149,12 +540,12 @@ public:
     const uint_fast16_t cutoff = sizeof(buffer_) - sizeof(word_t) * 2;
     buffer_.bytes[offset_] = 0x80;
     if (unlikely(++offset_ == sizeof(buffer_))) {
-      transform(buffer_.words);
+      transformBlocks(buffer_.bytes, 1);
       memset(buffer_.bytes, 0x00, cutoff);
     }
     else if (offset_ > cutoff) {
       memset(buffer_.bytes + offset_, 0x00, sizeof(buffer_) - offset_);
-      transform(buffer_.words);
+      transformBlocks(buffer_.bytes, 1);
       memset(buffer_.bytes, 0x00, cutoff);
     }
     else if (likely(offset_ != cutoff)) {
@@ -178,7 +569,7 @@ public:
     }
 
     // Last transform:
-    transform(buffer_.words);
+    transformBlocks(buffer_.bytes, 1);
 
 #if LITTLE_ENDIAN == BYTE_ORDER
     // On little endian, we still need to swap the bytes.
@@ -370,7 +761,18 @@ class SHA1 : public AlgorithmImpl<uint32_t, 16, 5> {
 private:
   static const word_t initvec[];
 
+  const block_fn blocks_;
+
 protected:
+  virtual void transformBlocks(const uint8_t* data, size_t n)
+  {
+    if (blocks_) {
+      blocks_(state_.words, data, n);
+      return;
+    }
+    AlgorithmImpl::transformBlocks(data, n);
+  }
+
   virtual void transform(const word_t* buffer)
   {
     __hash_assign_words(__crypto_be);
@@ -514,7 +916,7 @@ protected:
   }
 
 public:
-  SHA1() { reset(); }
+  SHA1(Kernels kernel) : blocks_(sha1_blocks(kernel)) { reset(); }
 
   virtual ~SHA1() { reset(); }
 
@@ -535,7 +937,18 @@ class SHA256 : public AlgorithmImpl<uint32_t, 16, 8> {
 private:
   static const word_t initvec[];
 
+  const block_fn blocks_;
+
 protected:
+  virtual void transformBlocks(const uint8_t* data, size_t n)
+  {
+    if (blocks_) {
+      blocks_(state_.words, data, n);
+      return;
+    }
+    AlgorithmImpl::transformBlocks(data, n);
+  }
+
   virtual void transform(const word_t* buffer)
   {
     __hash_assign_words(__crypto_be);
@@ -710,7 +1123,7 @@ protected:
   }
 
 public:
-  SHA256() { reset(); }
+  SHA256(Kernels kernel) : blocks_(sha256_blocks(kernel)) { reset(); }
 
   virtual ~SHA256() { reset(); }
 
@@ -740,7 +1153,7 @@ protected:
   }
 
 public:
-  SHA224() { reset(); }
+  SHA224(Kernels kernel) : SHA256(kernel) { reset(); }
 
   virtual ~SHA224() { reset(); }
 
@@ -1052,20 +1465,25 @@ Algorithms crypto::hash::lookup(const std::string& name)
   return i->second;
 }
 
-std::unique_ptr<Algorithm> crypto::hash::create(Algorithms algo)
+std::unique_ptr<Algorithm> crypto::hash::create(Algorithms algo,
+                                                Kernels kernel)
 {
+  if (unlikely(!supports(algo, kernel))) {
+    throw std::domain_error("Unsupported hash kernel");
+  }
+
   switch (algo) {
   case algoMD5:
     return aria2::make_unique<MD5>();
 
   case algoSHA1:
-    return aria2::make_unique<SHA1>();
+    return aria2::make_unique<SHA1>(kernel);
 
   case algoSHA224:
-    return aria2::make_unique<SHA224>();
+    return aria2::make_unique<SHA224>(kernel);
 
   case algoSHA256:
-    return aria2::make_unique<SHA256>();
+    return aria2::make_unique<SHA256>(kernel);
 
   case algoSHA384:
     return aria2::make_unique<SHA384>();
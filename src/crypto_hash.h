@@ -25,6 +25,14 @@ enum Algorithms {
   algoSHA512 = 0x6,
 };
 
+// Block function implementations. Only SHA-1 and SHA-2/256 (and therefore
+// SHA-224) have hardware accelerated ones.
+enum Kernels {
+  kernelPortable = 0x0,
+  kernelSHANI = 0x1,
+  kernelARMv8 = 0x2,
+};
+
 class Algorithm {
 public:
   Algorithm() = default;
@@ -56,7 +64,20 @@ const std::set<std::string>& all();
 
 Algorithms lookup(const std::string& name);
 
-std::unique_ptr<Algorithm> create(Algorithms algo);
+// Returns true if the running CPU can use |kernel| for |algo|.
+bool supports(Algorithms algo, Kernels kernel);
+
+// Returns the fastest kernel for |algo| the running CPU supports. This is
+// what |create(Algorithms)| uses.
+Kernels kernel(Algorithms algo);
+
+// Throws std::domain_error if |kernel| cannot be used for |algo|.
+std::unique_ptr<Algorithm> create(Algorithms algo, Kernels kernel);
+
+inline std::unique_ptr<Algorithm> create(Algorithms algo)
+{
+  return create(algo, kernel(algo));
+}
 
 inline std::unique_ptr<Algorithm> create(const std::string& name)
 {
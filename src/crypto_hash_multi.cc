@@ -0,0 +1,404 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "crypto_hash_multi.h"
+
+#include <cstring>
+
+#include "crypto_endian.h"
+#include "a2functional.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#  define HAVE_HASH_MULTI_X86 1
+#  include <cpuid.h>
+#  include <immintrin.h>
+#endif // (__x86_64__ || __i386__) && (__clang__ || __GNUC__ >= 5)
+
+using namespace crypto;
+using namespace crypto::hash;
+
+namespace {
+
+// Hashes |n| consecutive 64 byte blocks of each of the 8 messages
+// pointed by |data|.  |state| holds the SHA-1 states lane interleaved:
+// state[8 * i + l] is word i of message l.
+typedef void (*sha1_x8_fn)(uint32_t* state, const uint8_t* const* data,
+                           size_t n);
+
+#ifdef HAVE_HASH_MULTI_X86
+
+// Returns the bits of XCR0, which tell which register states the OS
+// saves on context switches.
+uint64_t xgetbv0()
+{
+  uint32_t lo, hi;
+  __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return static_cast<uint64_t>(hi) << 32 | lo;
+}
+
+enum {
+  CPU_AVX2 = 1,
+  CPU_AVX512VL = 1 << 1,
+};
+
+int cpu_features()
+{
+  unsigned int a, b, c, d;
+  // OSXSAVE and AVX
+  if (!__get_cpuid(1, &a, &b, &c, &d) || (c & (1u << 27 | 1u << 28)) !=
+                                             (1u << 27 | 1u << 28) ||
+      __get_cpuid_max(0, nullptr) < 7) {
+    return 0;
+  }
+  const auto xcr0 = xgetbv0();
+  if ((xcr0 & 0x6) != 0x6) {
+    return 0;
+  }
+  __cpuid_count(7, 0, a, b, c, d);
+  int rv = 0;
+  if (b & (1u << 5)) {
+    rv |= CPU_AVX2;
+    // AVX512F, AVX512VL, and the opmask/ZMM states enabled by the OS.
+    if ((b & (1u << 16)) && (b & (1u << 31)) && (xcr0 & 0xe0) == 0xe0) {
+      rv |= CPU_AVX512VL;
+    }
+  }
+  return rv;
+}
+
+// Loads the next 8 words of each lane and transposes them, so that
+// w[i] holds word i of all lanes.
+#  define __hash_x8_load(w, p, off)                                            \
+    do {                                                                       \
+      __m256i r0, r1, r2, r3, r4, r5, r6, r7, t0, t1, t2, t3, t4, t5, t6, t7;  \
+      r0 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[0] + off)), bswap);            \
+      r1 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[1] + off)), bswap);            \
+      r2 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[2] + off)), bswap);            \
+      r3 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[3] + off)), bswap);            \
+      r4 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[4] + off)), bswap);            \
+      r5 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[5] + off)), bswap);            \
+      r6 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[6] + off)), bswap);            \
+      r7 = _mm256_shuffle_epi8(                                                \
+          _mm256_loadu_si256((const __m256i*)(p[7] + off)), bswap);            \
+      t0 = _mm256_unpacklo_epi32(r0, r1);                                      \
+      t1 = _mm256_unpackhi_epi32(r0, r1);                                      \
+      t2 = _mm256_unpacklo_epi32(r2, r3);                                      \
+      t3 = _mm256_unpackhi_epi32(r2, r3);                                      \
+      t4 = _mm256_unpacklo_epi32(r4, r5);                                      \
+      t5 = _mm256_unpackhi_epi32(r4, r5);                                      \
+      t6 = _mm256_unpacklo_epi32(r6, r7);                                      \
+      t7 = _mm256_unpackhi_epi32(r6, r7);                                      \
+      r0 = _mm256_unpacklo_epi64(t0, t2);                                      \
+      r1 = _mm256_unpackhi_epi64(t0, t2);                                      \
+      r2 = _mm256_unpacklo_epi64(t1, t3);                                      \
+      r3 = _mm256_unpackhi_epi64(t1, t3);                                      \
+      r4 = _mm256_unpacklo_epi64(t4, t6);                                      \
+      r5 = _mm256_unpackhi_epi64(t4, t6);                                      \
+      r6 = _mm256_unpacklo_epi64(t5, t7);                                      \
+      r7 = _mm256_unpackhi_epi64(t5, t7);                                      \
+      w[0] = _mm256_permute2x128_si256(r0, r4, 0x20);                          \
+      w[1] = _mm256_permute2x128_si256(r1, r5, 0x20);                          \
+      w[2] = _mm256_permute2x128_si256(r2, r6, 0x20);                          \
+      w[3] = _mm256_permute2x128_si256(r3, r7, 0x20);                          \
+      w[4] = _mm256_permute2x128_si256(r0, r4, 0x31);                          \
+      w[5] = _mm256_permute2x128_si256(r1, r5, 0x31);                          \
+      w[6] = _mm256_permute2x128_si256(r2, r6, 0x31);                          \
+      w[7] = _mm256_permute2x128_si256(r3, r7, 0x31);                          \
+    } while (0)
+
+#  define __hash_x8_rounds(from, to, f, k)                                     \
+    for (int t = from; t < to; ++t) {                                          \
+      if (t >= 16) {                                                           \
+        w[t & 15] = vrol(vxor4(w[(t - 3) & 15], w[(t - 8) & 15],               \
+                               w[(t - 14) & 15], w[t & 15]),                   \
+                         1);                                                   \
+      }                                                                        \
+      const auto tmp = _mm256_add_epi32(                                       \
+          _mm256_add_epi32(vrol(a, 5), f(b, c, d)),                            \
+          _mm256_add_epi32(_mm256_add_epi32(e, _mm256_set1_epi32(k)),          \
+                           w[t & 15]));                                        \
+      e = d;                                                                   \
+      d = c;                                                                   \
+      c = vrol(b, 30);                                                         \
+      b = a;                                                                   \
+      a = tmp;                                                                 \
+    }
+
+// The kernel, given vrol, vch, vpar, vmaj and vxor4.
+#  define __hash_sha1_x8_body                                                  \
+    const __m256i bswap =                                                      \
+        _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, \
+                         3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12); \
+    const uint8_t* p[8];                                                       \
+    memcpy(p, data, sizeof(p));                                                \
+    auto s = reinterpret_cast<__m256i*>(state);                                \
+    auto a = _mm256_loadu_si256(s);                                            \
+    auto b = _mm256_loadu_si256(s + 1);                                        \
+    auto c = _mm256_loadu_si256(s + 2);                                        \
+    auto d = _mm256_loadu_si256(s + 3);                                        \
+    auto e = _mm256_loadu_si256(s + 4);                                        \
+    for (; n; --n) {                                                           \
+      const auto a0 = a, b0 = b, c0 = c, d0 = d, e0 = e;                       \
+      __m256i w[16];                                                           \
+      __hash_x8_load(w, p, 0);                                                 \
+      __hash_x8_load((w + 8), p, 32);                                          \
+      for (auto& q : p) {                                                      \
+        q += 64;                                                               \
+      }                                                                        \
+      __hash_x8_rounds(0, 20, vch, 0x5a827999);                                \
+      __hash_x8_rounds(20, 40, vpar, 0x6ed9eba1);                              \
+      __hash_x8_rounds(40, 60, vmaj, 0x8f1bbcdc);                              \
+      __hash_x8_rounds(60, 80, vpar, 0xca62c1d6);                              \
+      a = _mm256_add_epi32(a, a0);                                             \
+      b = _mm256_add_epi32(b, b0);                                             \
+      c = _mm256_add_epi32(c, c0);                                             \
+      d = _mm256_add_epi32(d, d0);                                             \
+      e = _mm256_add_epi32(e, e0);                                             \
+    }                                                                          \
+    _mm256_storeu_si256(s, a);                                                 \
+    _mm256_storeu_si256(s + 1, b);                                             \
+    _mm256_storeu_si256(s + 2, c);                                             \
+    _mm256_storeu_si256(s + 3, d);                                             \
+    _mm256_storeu_si256(s + 4, e)
+
+__attribute__((target("avx2"))) void
+sha1_x8_avx2(uint32_t* state, const uint8_t* const* data, size_t n)
+{
+#  define vrol(x, r)                                                           \
+    _mm256_or_si256(_mm256_slli_epi32(x, r), _mm256_srli_epi32(x, 32 - r))
+#  define vch(x, y, z)                                                         \
+    _mm256_xor_si256(z, _mm256_and_si256(x, _mm256_xor_si256(y, z)))
+#  define vpar(x, y, z) _mm256_xor_si256(_mm256_xor_si256(x, y), z)
+#  define vmaj(x, y, z)                                                        \
+    _mm256_or_si256(_mm256_and_si256(x, y),                                    \
+                    _mm256_and_si256(z, _mm256_or_si256(x, y)))
+#  define vxor4(w, x, y, z)                                                    \
+    _mm256_xor_si256(_mm256_xor_si256(w, x), _mm256_xor_si256(y, z))
+
+  __hash_sha1_x8_body;
+
+#  undef vxor4
+#  undef vmaj
+#  undef vpar
+#  undef vch
+#  undef vrol
+}
+
+// AVX-512VL has rotates and three operand logic, which save almost
+// half of the instructions of a round.
+__attribute__((target("avx2,avx512f,avx512vl"))) void
+sha1_x8_avx512vl(uint32_t* state, const uint8_t* const* data, size_t n)
+{
+#  define vrol(x, r) _mm256_rol_epi32(x, r)
+#  define vch(x, y, z) _mm256_ternarylogic_epi32(x, y, z, 0xca)
+#  define vpar(x, y, z) _mm256_ternarylogic_epi32(x, y, z, 0x96)
+#  define vmaj(x, y, z) _mm256_ternarylogic_epi32(x, y, z, 0xe8)
+#  define vxor4(w, x, y, z)                                                    \
+    _mm256_ternarylogic_epi32(w, x, _mm256_xor_si256(y, z), 0x96)
+
+  __hash_sha1_x8_body;
+
+#  undef vxor4
+#  undef vmaj
+#  undef vpar
+#  undef vch
+#  undef vrol
+}
+
+#  undef __hash_sha1_x8_body
+#  undef __hash_x8_rounds
+#  undef __hash_x8_load
+
+sha1_x8_fn sha1_x8()
+{
+  static const auto features = cpu_features();
+  if (features & CPU_AVX512VL) {
+    return sha1_x8_avx512vl;
+  }
+  if (features & CPU_AVX2) {
+    return sha1_x8_avx2;
+  }
+  return nullptr;
+}
+
+#else // !HAVE_HASH_MULTI_X86
+
+sha1_x8_fn sha1_x8() { return nullptr; }
+
+#endif // !HAVE_HASH_MULTI_X86
+
+class SHA1x8 : public MultiAlgorithm {
+private:
+  static const size_t LANES = 8;
+  static const size_t BLOCK = 64;
+
+  const sha1_x8_fn blocks_;
+  uint32_t state_[5 * LANES];
+  uint8_t buffer_[LANES][BLOCK];
+  uint64_t count_;
+  size_t offset_;
+
+  void transformBuffer()
+  {
+    const uint8_t* p[LANES];
+    for (size_t i = 0; i < LANES; ++i) {
+      p[i] = buffer_[i];
+    }
+    blocks_(state_, p, 1);
+  }
+
+public:
+  SHA1x8(sha1_x8_fn blocks) : blocks_(blocks) { reset(); }
+
+  virtual ~SHA1x8() { reset(); }
+
+  virtual void update(const void* const* data, uint64_t len)
+  {
+    const uint8_t* p[LANES];
+    for (size_t i = 0; i < LANES; ++i) {
+      p[i] = reinterpret_cast<const uint8_t*>(data[i]);
+    }
+    count_ += len;
+
+    if (offset_) {
+      const size_t turn = std::min<uint64_t>(len, BLOCK - offset_);
+      for (size_t i = 0; i < LANES; ++i) {
+        memcpy(buffer_[i] + offset_, p[i], turn);
+        p[i] += turn;
+      }
+      len -= turn;
+      offset_ += turn;
+      if (offset_ < BLOCK) {
+        return;
+      }
+      transformBuffer();
+      offset_ = 0;
+    }
+
+    if (len >= BLOCK) {
+      const size_t n = len / BLOCK;
+      blocks_(state_, p, n);
+      for (auto& q : p) {
+        q += n * BLOCK;
+      }
+      len -= n * BLOCK;
+    }
+
+    if (len) {
+      for (size_t i = 0; i < LANES; ++i) {
+        memcpy(buffer_[i], p[i], len);
+      }
+      offset_ = len;
+    }
+  }
+
+  virtual std::vector<std::string> finalize()
+  {
+    // Every message has the same length, and therefore the same padding.
+    for (auto& buf : buffer_) {
+      buf[offset_] = 0x80;
+      memset(buf + offset_ + 1, 0, BLOCK - offset_ - 1);
+    }
+    if (offset_ >= BLOCK - 8) {
+      transformBuffer();
+      for (auto& buf : buffer_) {
+        memset(buf, 0, BLOCK);
+      }
+    }
+    const uint64_t bits = count_ << 3;
+    for (auto& buf : buffer_) {
+      for (int i = 0; i < 8; ++i) {
+        buf[BLOCK - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+      }
+    }
+    transformBuffer();
+
+    std::vector<std::string> rv;
+    for (size_t l = 0; l < LANES; ++l) {
+      uint32_t digest[5];
+      for (size_t i = 0; i < 5; ++i) {
+        digest[i] = __crypto_be(state_[LANES * i + l]);
+      }
+      rv.emplace_back(reinterpret_cast<const char*>(digest), sizeof(digest));
+    }
+    reset();
+    return rv;
+  }
+
+  virtual void reset()
+  {
+    static const uint32_t initvec[] = {0x67452301, 0xefcdab89, 0x98badcfe,
+                                       0x10325476, 0xc3d2e1f0};
+    for (size_t i = 0; i < 5; ++i) {
+      for (size_t l = 0; l < LANES; ++l) {
+        state_[LANES * i + l] = initvec[i];
+      }
+    }
+    memset(buffer_, 0, sizeof(buffer_));
+    count_ = offset_ = 0;
+  }
+
+  virtual size_t lanes() const { return LANES; }
+
+  virtual uint_fast16_t length() const { return 20; }
+};
+
+} // namespace
+
+size_t crypto::hash::multiLanes(Algorithms algo)
+{
+  if (algo == algoSHA1 && sha1_x8()) {
+    return 8;
+  }
+  return 0;
+}
+
+std::unique_ptr<MultiAlgorithm> crypto::hash::createMulti(Algorithms algo)
+{
+  if (algo == algoSHA1) {
+    auto blocks = sha1_x8();
+    if (blocks) {
+      return aria2::make_unique<SHA1x8>(blocks);
+    }
+  }
+  return nullptr;
+}
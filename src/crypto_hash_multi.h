@@ -0,0 +1,87 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2026 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef CRYPTO_HASH_MULTI_H
+#define CRYPTO_HASH_MULTI_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "crypto_hash.h"
+
+namespace crypto {
+namespace hash {
+
+// Hashes several messages of the same length at once, one message per
+// SIMD lane.  Unlike Algorithm, this is compiled regardless of the
+// message digest implementation aria2 is built with.
+class MultiAlgorithm {
+public:
+  MultiAlgorithm() = default;
+
+  virtual ~MultiAlgorithm() = default;
+
+  // Appends |len| bytes pointed by data[i] to message i, for each of
+  // the lanes() messages.
+  virtual void update(const void* const* data, uint64_t len) = 0;
+
+  // Returns the raw digests of all messages and resets this object.
+  virtual std::vector<std::string> finalize() = 0;
+
+  virtual void reset() = 0;
+
+  virtual size_t lanes() const = 0;
+
+  virtual uint_fast16_t length() const = 0;
+
+private:
+  MultiAlgorithm(const MultiAlgorithm&) = delete;
+
+  MultiAlgorithm& operator=(const MultiAlgorithm&) = delete;
+};
+
+// Returns the number of messages the multi-buffer kernel for |algo|
+// hashes at once on the running CPU, or 0 if there is no such kernel.
+size_t multiLanes(Algorithms algo);
+
+// Returns nullptr if multiLanes(algo) is 0.
+std::unique_ptr<MultiAlgorithm> createMulti(Algorithms algo);
+
+} // namespace hash
+} // namespace crypto
+
+#endif // CRYPTO_HASH_MULTI_H
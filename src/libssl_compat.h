@@ -36,6 +36,7 @@
 #define LIBSSL_COMPAT_H
 
 #include <openssl/opensslv.h>
+#include <openssl/opensslconf.h>
 
 #if defined(LIBRESSL_VERSION_NUMBER)
 #  define LIBRESSL_IN_USE 1
@@ -46,4 +47,13 @@
 #define OPENSSL_101_API                                                        \
   (!LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x1010000fL)
 
+// Kernel TLS offload (SSL_OP_ENABLE_KTLS, SSL_sendfile) is available
+// since OpenSSL 3.0 unless it is disabled at build time.
+#if !LIBRESSL_IN_USE && OPENSSL_VERSION_NUMBER >= 0x30000000L &&             \
+    !defined(OPENSSL_NO_KTLS)
+#  define OPENSSL_KTLS_API 1
+#else
+#  define OPENSSL_KTLS_API 0
+#endif
+
 #endif // LIBSSL_COMPAT_H
@@ -63,6 +63,8 @@
 #define MSG_NAME_RESOLUTION_FAILED                      \
   "CUID#%" PRId64 " - Name resolution for %s failed:%s"
 #define MSG_DNS_CACHE_HIT "CUID#%" PRId64 " - DNS cache hit: %s -> %s"
+#define MSG_DNS_NEGATIVE_CACHE_HIT                      \
+  "CUID#%" PRId64 " - DNS negative cache hit: %s:%s"
 #define MSG_CONNECTING_TO_PEER "CUID#%" PRId64 " - Connecting to the peer %s"
 #define MSG_PIECE_RECEIVED                                              \
   "CUID#%" PRId64 " - Piece received. index=%lu, begin=%d, length=%d, offset=%" PRId64 "," \
@@ -169,6 +171,16 @@
 #define MSG_SERVER_STAT_SAVED _("ServerStat file %s saved successfully.")
 #define MSG_WRITING_SERVER_STAT_FILE_FAILED _("Failed to write ServerStat to" \
                                               " %s.")
+#define MSG_OPENING_READABLE_DNS_CACHE_FILE_FAILED      \
+  _("Failed to open DNS cache file %s for read.")
+#define MSG_DNS_CACHE_LOADED _("DNS cache file %s loaded successfully.")
+#define MSG_READING_DNS_CACHE_FILE_FAILED _("Failed to read DNS cache from" \
+                                            " %s.")
+#define MSG_OPENING_WRITABLE_DNS_CACHE_FILE_FAILED      \
+  _("Failed to open DNS cache file %s for write.")
+#define MSG_DNS_CACHE_SAVED _("DNS cache file %s saved successfully.")
+#define MSG_WRITING_DNS_CACHE_FILE_FAILED _("Failed to write DNS cache to" \
+                                            " %s.")
 #define MSG_ESTABLISHING_CONNECTION_FAILED              \
   _("Failed to establish connection, cause: %s")
 #define MSG_NETWORK_PROBLEM _("Network problem has occurred. cause:%s")
@@ -39,11 +39,13 @@
 #include <cstdlib>
 
 #include "MessageDigest.h"
+#include "MessageDigestBatch.h"
 #include "DlAbortEx.h"
 #include "message.h"
 #include "DefaultDiskWriter.h"
 #include "util.h"
 #include "fmt.h"
+#include "a2io.h"
 
 namespace aria2 {
 
@@ -88,6 +90,69 @@ void digest(unsigned char* md, size_t mdLength, MessageDigest* ctx,
   ctx->digest(md);
 }
 
+#if defined(HAVE_PWRITE) && !defined(__MINGW32__)
+int update(MessageDigest* ctx, int fd, int64_t offset, int64_t length)
+{
+  constexpr size_t BUFSIZE = 256_k;
+  auto buf = make_unique<unsigned char[]>(BUFSIZE);
+  int64_t max = offset + length;
+  while (offset < max) {
+    ssize_t r;
+    while ((r = pread(fd, buf.get(),
+                      std::min(static_cast<int64_t>(BUFSIZE), max - offset),
+                      offset)) == -1 &&
+           errno == EINTR)
+      ;
+    if (r == -1) {
+      return errno;
+    }
+    if (r == 0) {
+      return -1;
+    }
+    ctx->update(buf.get(), r);
+    offset += r;
+  }
+  return 0;
+}
+
+int update(MessageDigestBatch* batch, const int* fds, const int64_t* offsets,
+           int64_t length)
+{
+  // Small enough for the chunks of all messages to stay in the cache
+  // until they are hashed.
+  constexpr size_t BUFSIZE = 64_k;
+  auto n = batch->size();
+  auto buf = make_unique<unsigned char[]>(BUFSIZE * n);
+  std::vector<const void*> data(n);
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = buf.get() + BUFSIZE * i;
+  }
+  for (int64_t pos = 0; pos < length;) {
+    size_t len = std::min(static_cast<int64_t>(BUFSIZE), length - pos);
+    for (size_t i = 0; i < n; ++i) {
+      auto dst = buf.get() + BUFSIZE * i;
+      for (size_t off = 0; off < len;) {
+        ssize_t r;
+        while ((r = pread(fds[i], dst + off, len - off,
+                          offsets[i] + pos + off)) == -1 &&
+               errno == EINTR)
+          ;
+        if (r == -1) {
+          return errno;
+        }
+        if (r == 0) {
+          return -1;
+        }
+        off += r;
+      }
+    }
+    batch->update(data.data(), len);
+    pos += len;
+  }
+  return 0;
+}
+#endif // HAVE_PWRITE && !__MINGW32__
+
 } // namespace message_digest
 
 } // namespace aria2
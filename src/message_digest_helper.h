@@ -44,6 +44,7 @@ namespace aria2 {
 
 class BinaryStream;
 class MessageDigest;
+class MessageDigestBatch;
 
 namespace message_digest {
 
@@ -61,6 +62,24 @@ std::string digest(MessageDigest* ctx, const std::shared_ptr<BinaryStream>& bs,
 void digest(unsigned char* md, size_t mdLength, MessageDigest* ctx,
             const void* data, size_t length);
 
+#if defined(HAVE_PWRITE) && !defined(__MINGW32__)
+/**
+ * Reads length bytes at offset from fd using pread(2) and updates ctx
+ * with them.  Unlike digest() above, this function does not throw
+ * and is safe to call from worker threads.  Returns 0 on success,
+ * errno if reading failed, or -1 if the file is too short.
+ */
+int update(MessageDigest* ctx, int fd, int64_t offset, int64_t length);
+
+/**
+ * Same as above, but reads length bytes at offsets[i] from fds[i] for
+ * each of the batch->size() messages of batch.  Returns the result of
+ * the first read which failed.
+ */
+int update(MessageDigestBatch* batch, const int* fds, const int64_t* offsets,
+           int64_t length);
+#endif // HAVE_PWRITE && !__MINGW32__
+
 } // namespace message_digest
 
 } // namespace aria2
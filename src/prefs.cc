@@ -137,6 +137,7 @@ const std::string V_FEEDBACK("feedback");
 const std::string V_ADAPTIVE("adaptive");
 const std::string V_LIBUV("libuv");
 const std::string V_EPOLL("epoll");
+const std::string V_IO_URING("io_uring");
 const std::string V_KQUEUE("kqueue");
 const std::string V_PORT("port");
 const std::string V_POLL("poll");
@@ -329,6 +330,21 @@ PrefPtr PREF_MAX_DOWNLOAD_RESULT = makePref("max-download-result");
 PrefPtr PREF_RETRY_WAIT = makePref("retry-wait");
 // value: string
 PrefPtr PREF_ASYNC_DNS_SERVER = makePref("async-dns-server");
+// value: 1*digit
+PrefPtr PREF_DNS_CACHE_MIN_TTL = makePref("dns-cache-min-ttl");
+// value: 1*digit
+PrefPtr PREF_DNS_CACHE_MAX_TTL = makePref("dns-cache-max-ttl");
+// value: 1*digit
+PrefPtr PREF_DNS_CACHE_NEGATIVE_TTL = makePref("dns-cache-negative-ttl");
+// value: string that your file system recognizes as a file name.
+PrefPtr PREF_DNS_CACHE_FILE = makePref("dns-cache-file");
+// value: 1*digit
+PrefPtr PREF_MAX_IDLE_CONNECTIONS = makePref("max-idle-connections");
+// value: 1*digit
+PrefPtr PREF_MAX_IDLE_CONNECTIONS_PER_HOST =
+    makePref("max-idle-connections-per-host");
+// value: 1*digit
+PrefPtr PREF_IDLE_CONNECTION_TIMEOUT = makePref("idle-connection-timeout");
 // value: true | false
 PrefPtr PREF_SHOW_CONSOLE_READOUT = makePref("show-console-readout");
 // value: default | inorder
@@ -368,15 +384,31 @@ PrefPtr PREF_PAUSE_METADATA = makePref("pause-metadata");
 PrefPtr PREF_RLIMIT_NOFILE = makePref("rlimit-nofile");
 // values: SSLv3 | TLSv1 | TLSv1.1 | TLSv1.2
 PrefPtr PREF_MIN_TLS_VERSION = makePref("min-tls-version");
+// values: true | false
+PrefPtr PREF_ENABLE_KTLS = makePref("enable-ktls");
 // value: 1*digit
 PrefPtr PREF_SOCKET_RECV_BUFFER_SIZE = makePref("socket-recv-buffer-size");
 // value: 1*digit
+PrefPtr PREF_MAX_READ_BUFFER_SIZE = makePref("max-read-buffer-size");
+// value: 1*digit
 PrefPtr PREF_MAX_MMAP_LIMIT = makePref("max-mmap-limit");
 // value: true | false
 PrefPtr PREF_STDERR = makePref("stderr");
 // value: true | false
 PrefPtr PREF_KEEP_UNFINISHED_DOWNLOAD_RESULT =
     makePref("keep-unfinished-download-result");
+// value: 1*digit
+PrefPtr PREF_WORKER_THREADS = makePref("worker-threads");
+// value: 1*digit
+PrefPtr PREF_MAX_DISK_WRITE_QUEUE = makePref("max-disk-write-queue");
+// value: true | false
+PrefPtr PREF_ENABLE_DISK_IO_URING = makePref("enable-disk-io-uring");
+// value: 1*digit
+PrefPtr PREF_MAX_CONCURRENT_FILE_ALLOCATIONS =
+    makePref("max-concurrent-file-allocations");
+// value: 1*digit
+PrefPtr PREF_MAX_CONCURRENT_INTEGRITY_CHECKS =
+    makePref("max-concurrent-integrity-checks");
 
 /**
  * FTP related preferences
@@ -405,8 +437,12 @@ PrefPtr PREF_LOAD_COOKIES = makePref("load-cookies");
 PrefPtr PREF_SAVE_COOKIES = makePref("save-cookies");
 // values: true | false
 PrefPtr PREF_ENABLE_HTTP_KEEP_ALIVE = makePref("enable-http-keep-alive");
+// value: 1*digit
+PrefPtr PREF_PRE_CONNECT = makePref("pre-connect");
 // values: true | false
 PrefPtr PREF_ENABLE_HTTP_PIPELINING = makePref("enable-http-pipelining");
+// values: true | false
+PrefPtr PREF_ENABLE_HTTP2 = makePref("enable-http2");
 // value: 1*digit
 PrefPtr PREF_MAX_HTTP_PIPELINING = makePref("max-http-pipelining");
 // value: string
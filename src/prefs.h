@@ -94,6 +94,7 @@ extern const std::string V_FEEDBACK;
 extern const std::string V_ADAPTIVE;
 extern const std::string V_LIBUV;
 extern const std::string V_EPOLL;
+extern const std::string V_IO_URING;
 extern const std::string V_KQUEUE;
 extern const std::string V_PORT;
 extern const std::string V_POLL;
@@ -282,6 +283,20 @@ extern PrefPtr PREF_MAX_DOWNLOAD_RESULT;
 extern PrefPtr PREF_RETRY_WAIT;
 // value: string
 extern PrefPtr PREF_ASYNC_DNS_SERVER;
+// value: 1*digit
+extern PrefPtr PREF_DNS_CACHE_MIN_TTL;
+// value: 1*digit
+extern PrefPtr PREF_DNS_CACHE_MAX_TTL;
+// value: 1*digit
+extern PrefPtr PREF_DNS_CACHE_NEGATIVE_TTL;
+// value: string that your file system recognizes as a file name.
+extern PrefPtr PREF_DNS_CACHE_FILE;
+// value: 1*digit
+extern PrefPtr PREF_MAX_IDLE_CONNECTIONS;
+// value: 1*digit
+extern PrefPtr PREF_MAX_IDLE_CONNECTIONS_PER_HOST;
+// value: 1*digit
+extern PrefPtr PREF_IDLE_CONNECTION_TIMEOUT;
 // value: true | false
 extern PrefPtr PREF_SHOW_CONSOLE_READOUT;
 // value: default | inorder | geom
@@ -322,14 +337,28 @@ extern PrefPtr PREF_PAUSE_METADATA;
 extern PrefPtr PREF_RLIMIT_NOFILE;
 // values: SSLv3 | TLSv1 | TLSv1.1 | TLSv1.2
 extern PrefPtr PREF_MIN_TLS_VERSION;
+// values: true | false
+extern PrefPtr PREF_ENABLE_KTLS;
 // value: 1*digit
 extern PrefPtr PREF_SOCKET_RECV_BUFFER_SIZE;
 // value: 1*digit
+extern PrefPtr PREF_MAX_READ_BUFFER_SIZE;
+// value: 1*digit
 extern PrefPtr PREF_MAX_MMAP_LIMIT;
 // value: true | false
 extern PrefPtr PREF_STDERR;
 // value: true | false
 extern PrefPtr PREF_KEEP_UNFINISHED_DOWNLOAD_RESULT;
+// value: 1*digit
+extern PrefPtr PREF_WORKER_THREADS;
+// value: 1*digit
+extern PrefPtr PREF_MAX_DISK_WRITE_QUEUE;
+// value: true | false
+extern PrefPtr PREF_ENABLE_DISK_IO_URING;
+// value: 1*digit
+extern PrefPtr PREF_MAX_CONCURRENT_FILE_ALLOCATIONS;
+// value: 1*digit
+extern PrefPtr PREF_MAX_CONCURRENT_INTEGRITY_CHECKS;
 
 /**
  * FTP related preferences
@@ -358,8 +387,12 @@ extern PrefPtr PREF_LOAD_COOKIES;
 extern PrefPtr PREF_SAVE_COOKIES;
 // values: true | false
 extern PrefPtr PREF_ENABLE_HTTP_KEEP_ALIVE;
+// value: 1*digit
+extern PrefPtr PREF_PRE_CONNECT;
 // values: true | false
 extern PrefPtr PREF_ENABLE_HTTP_PIPELINING;
+// values: true | false
+extern PrefPtr PREF_ENABLE_HTTP2;
 // value: 1*digit
 extern PrefPtr PREF_MAX_HTTP_PIPELINING;
 // value: string
@@ -190,8 +190,27 @@
     "                              required.")
 #define TEXT_ENABLE_HTTP_KEEP_ALIVE                                     \
   _(" --enable-http-keep-alive[=true|false] Enable HTTP/1.1 persistent connection.")
+#define TEXT_PRE_CONNECT                                                \
+  _(" --pre-connect=NUM            When HTTP(S) downloads waiting in the queue use\n" \
+    "                              the same host, establish up to NUM connections\n" \
+    "                              (including TLS handshake) to the host ahead of\n" \
+    "                              need and keep them in the connection pool, so\n" \
+    "                              that the downloads started next do not wait for\n" \
+    "                              them. Only the downloads which fill the free\n" \
+    "                              --max-concurrent-downloads slots are considered,\n" \
+    "                              and the connections count against\n" \
+    "                              --max-idle-connections and expire after\n" \
+    "                              --idle-connection-timeout. Only the hosts whose\n" \
+    "                              address is in DNS cache and which are not\n" \
+    "                              accessed through proxy are connected. Specify 0\n" \
+    "                              to disable this feature.")
 #define TEXT_ENABLE_HTTP_PIPELINING                                     \
   _(" --enable-http-pipelining[=true|false] Enable HTTP/1.1 pipelining.")
+#define TEXT_ENABLE_HTTP2                                               \
+  _(" --enable-http2[=true|false] Use HTTP/2 for HTTPS downloads if the server\n" \
+    "                              supports it. The connections to the same host\n" \
+    "                              are multiplexed as streams over single TLS\n" \
+    "                              connection.")
 #define TEXT_CHECK_INTEGRITY                                            \
   _(" -V, --check-integrity[=true|false] Check file integrity by validating piece\n" \
     "                              hashes or a hash of entire file. This option has\n" \
@@ -817,6 +836,32 @@
     "                              option is useful when the system does not have\n" \
     "                              /etc/resolv.conf and user does not have the\n" \
     "                              permission to create it.")
+#define TEXT_DNS_CACHE_MIN_TTL                                          \
+  _(" --dns-cache-min-ttl=SEC      Keep resolved addresses in DNS cache for at\n" \
+    "                              least SEC seconds, even if the TTL of the DNS\n" \
+    "                              record is shorter.")
+#define TEXT_DNS_CACHE_MAX_TTL                                          \
+  _(" --dns-cache-max-ttl=SEC      Keep resolved addresses in DNS cache for at\n" \
+    "                              most SEC seconds. This is also used for the\n" \
+    "                              addresses whose TTL is unknown.")
+#define TEXT_DNS_CACHE_NEGATIVE_TTL                                     \
+  _(" --dns-cache-negative-ttl=SEC Remember failed name resolution for SEC\n" \
+    "                              seconds when the name does not exist or the DNS\n" \
+    "                              server failed. Specify 0 to disable this.")
+#define TEXT_DNS_CACHE_FILE                                             \
+  _(" --dns-cache-file=FILE        Load DNS cache from FILE at startup if it exists\n" \
+    "                              and save DNS cache to FILE when aria2 exits.")
+#define TEXT_MAX_IDLE_CONNECTIONS                                       \
+  _(" --max-idle-connections=NUM   Set the maximum number of idle connections kept\n" \
+    "                              for reuse. When the limit is exceeded, the least\n" \
+    "                              recently used one is closed. Specify 0 to disable\n" \
+    "                              reuse of connections.")
+#define TEXT_MAX_IDLE_CONNECTIONS_PER_HOST                              \
+  _(" --max-idle-connections-per-host=NUM Set the maximum number of idle\n" \
+    "                              connections kept for reuse per host.")
+#define TEXT_IDLE_CONNECTION_TIMEOUT                                    \
+  _(" --idle-connection-timeout=SEC Close idle connections kept for reuse\n" \
+    "                              after SEC seconds.")
 #define TEXT_ENABLE_RPC                                               \
   _(" --enable-rpc[=true|false]    Enable JSON-RPC/XML-RPC server.\n" \
     "                              It is strongly recommended to set secret\n" \
@@ -945,6 +990,11 @@
     "                              your disk.")
 #define TEXT_ENABLE_MMAP                        \
   _(" --enable-mmap[=true|false]   Map files into memory.")
+#define TEXT_ENABLE_KTLS                                                \
+  _(" --enable-ktls[=true|false]   Hand TLS encryption and decryption to the\n" \
+    "                              kernel (Linux kTLS) after handshake. If the\n" \
+    "                              kernel or the negotiated cipher does not\n" \
+    "                              support it, TLS is done in user space as usual.")
 #define TEXT_RPC_CERTIFICATE                                            \
   _(" --rpc-certificate=FILE       Use the certificate in FILE for RPC server.\n" \
     "                              The certificate must be in PEM format.\n" \
@@ -997,7 +1047,9 @@
     "                              and it is reordered by the offset of the file.\n" \
     "                              If hash checking is involved and the data are\n" \
     "                              cached in memory, we don't need to read them\n" \
-    "                              from the disk.\n"                    \
+    "                              from the disk. When seeding, the pieces read\n" \
+    "                              from the disk to serve requests from peers are\n" \
+    "                              also cached within SIZE.\n"          \
     "                              SIZE can include K or M(1K = 1024, 1M = 1024K).")
 #define TEXT_GID                                \
   _(" --gid=GID                    Set GID manually. aria2 identifies each\n" \
@@ -1090,6 +1142,12 @@
     "                              Specifying 0 will disable this option. This value\n" \
     "                              will be set to socket file descriptor using\n" \
     "                              SO_RCVBUF socket option with setsockopt() call.")
+#define TEXT_MAX_READ_BUFFER_SIZE                                       \
+  _(" --max-read-buffer-size=SIZE\n"                                    \
+    "                              Set the maximum size of the buffer each\n" \
+    "                              connection reads received data into. The buffer\n" \
+    "                              starts with 16K and grows up to SIZE while the\n" \
+    "                              connection is fast.")
 #define TEXT_BT_ENABLE_HOOK_AFTER_HASH_CHECK                            \
   _(" --bt-enable-hook-after-hash-check[=true|false] Allow hook command invocation\n" \
     "                              after hash check (see -V option) in BitTorrent\n" \
@@ -1118,6 +1176,38 @@
     "                              keep in mind that there is no upper bound to the\n" \
     "                              number of unfinished download result to keep. If\n" \
     "                              that is undesirable, turn this option off.")
+#define TEXT_WORKER_THREADS                     \
+  _(" --worker-threads=NUM         Set the number of worker threads which run\n" \
+    "                              blocking disk I/O and CPU heavy jobs, such as\n" \
+    "                              hash checking, outside of the main event loop.\n" \
+    "                              If 0 is given, those jobs run in the main event\n" \
+    "                              loop.")
+#define TEXT_MAX_DISK_WRITE_QUEUE               \
+  _(" --max-disk-write-queue=SIZE  Set the maximum number of bytes of the disk\n" \
+    "                              cache being written by worker threads. When it\n" \
+    "                              is reached, downloads stop receiving data until\n" \
+    "                              the writes catch up. This option has effect only\n" \
+    "                              when both --disk-cache and --worker-threads are\n" \
+    "                              enabled.")
+#define TEXT_ENABLE_DISK_IO_URING               \
+  _(" --enable-disk-io-uring[=true|false]\n"   \
+    "                              Read and write files through io_uring. Writes\n" \
+    "                              of a disk cache flush are submitted to\n" \
+    "                              the kernel at once. This option is available\n" \
+    "                              only on Linux 5.6 or later, and ignored\n" \
+    "                              otherwise.")
+#define TEXT_MAX_CONCURRENT_FILE_ALLOCATIONS    \
+  _(" --max-concurrent-file-allocations=N\n"     \
+    "                              Set the maximum number of downloads whose files\n" \
+    "                              are allocated at the same time. When\n" \
+    "                              --worker-threads is greater than 0, the disk\n" \
+    "                              space is allocated by worker threads.")
+#define TEXT_MAX_CONCURRENT_INTEGRITY_CHECKS    \
+  _(" --max-concurrent-integrity-checks=N\n"     \
+    "                              Set the maximum number of downloads whose\n" \
+    "                              integrity is checked at the same time. When\n" \
+    "                              --worker-threads is greater than 0, pieces are\n" \
+    "                              read and hashed by worker threads.")
 
 #define TEXT_BT_LOAD_SAVED_METADATA \
   _(" --bt-load-saved-metadata[=true|false]\n" \
@@ -2522,6 +2522,40 @@ void make_fd_cloexec(int fd)
 #endif // !__MINGW32__
 }
 
+#ifdef HAVE_PWRITEV
+namespace {
+#  ifdef IOV_MAX
+constexpr int MAX_IOVCNT = IOV_MAX;
+#  else  // !IOV_MAX
+// The minimum value POSIX allows
+constexpr int MAX_IOVCNT = 16;
+#  endif // !IOV_MAX
+} // namespace
+
+int pwritevAll(int fd, struct iovec* iov, int iovcnt, int64_t offset)
+{
+  while (iovcnt > 0) {
+    auto n = pwritev(fd, iov, std::min(iovcnt, MAX_IOVCNT), offset);
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno;
+    }
+    offset += n;
+    for (; iovcnt > 0 && static_cast<size_t>(n) >= iov->iov_len;
+         ++iov, --iovcnt) {
+      n -= iov->iov_len;
+    }
+    if (n > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+      iov->iov_len -= n;
+    }
+  }
+  return 0;
+}
+#endif // HAVE_PWRITEV
+
 #ifdef __MINGW32__
 bool gainPrivilege(LPCTSTR privName)
 {
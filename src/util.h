@@ -40,6 +40,9 @@
 #include <sys/time.h>
 #include <limits.h>
 #include <stdint.h>
+#ifdef HAVE_PWRITEV
+#  include <sys/uio.h>
+#endif // HAVE_PWRITEV
 
 #include <cstdio>
 #include <cstring>
@@ -875,6 +878,14 @@ std::string formatLastError(int errNum);
 // CreateProcess call.
 void make_fd_cloexec(int fd);
 
+#ifdef HAVE_PWRITEV
+// Writes the data described by |iov| of |iovcnt| elements to |fd| at
+// |offset| using pwritev(2), retrying on short writes.  |iovcnt| may
+// exceed IOV_MAX.  The elements of |iov| are modified.  Returns 0 on
+// success, or errno.
+int pwritevAll(int fd, struct iovec* iov, int iovcnt, int64_t offset);
+#endif // HAVE_PWRITEV
+
 #ifdef __MINGW32__
 bool gainPrivilege(LPCTSTR privName);
 #endif // __MINGW32__
@@ -41,6 +41,7 @@ class BitfieldManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testGetFirstNMissingUnusedIndex);
   CPPUNIT_TEST(testGetInorderMissingUnusedIndex);
   CPPUNIT_TEST(testGetGeomMissingUnusedIndex);
+  CPPUNIT_TEST(testMissingUnusedIndex_large);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -73,6 +74,7 @@ public:
   void testGetFirstNMissingUnusedIndex();
   void testGetInorderMissingUnusedIndex();
   void testGetGeomMissingUnusedIndex();
+  void testMissingUnusedIndex_large();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(BitfieldManTest);
@@ -815,4 +817,53 @@ void BitfieldManTest::testGetGeomMissingUnusedIndex()
   bt.setUseBit(12);
 }
 
+void BitfieldManTest::testMissingUnusedIndex_large()
+{
+  // 300000 blocks need 2 words in the second level of the summary.
+  const size_t blocks = 300000;
+  BitfieldMan bt(1, blocks);
+  std::vector<unsigned char> bitfield(bt.getBitfieldLength(), 0xff);
+  bitfield.back() = bitfield::lastByteMask(blocks);
+  bitfield[290000 / 8] = 0xf0;
+  bt.setBitfield(bitfield.data(), bitfield.size());
+  std::vector<unsigned char> ignore(bt.getBitfieldLength());
+  size_t index;
+  CPPUNIT_ASSERT(bt.getFirstMissingUnusedIndex(index));
+  CPPUNIT_ASSERT_EQUAL((size_t)290004, index);
+  CPPUNIT_ASSERT(
+      bt.getSparseMissingUnusedIndex(index, 1, ignore.data(), ignore.size()));
+  CPPUNIT_ASSERT_EQUAL((size_t)290004, index);
+  CPPUNIT_ASSERT(
+      bt.getInorderMissingUnusedIndex(index, 1, ignore.data(), ignore.size()));
+  CPPUNIT_ASSERT_EQUAL((size_t)290004, index);
+  CPPUNIT_ASSERT(bt.getGeomMissingUnusedIndex(index, 1, ignore.data(),
+                                              ignore.size(), 2.0, 0));
+  CPPUNIT_ASSERT_EQUAL((size_t)290004, index);
+  std::vector<size_t> out;
+  CPPUNIT_ASSERT_EQUAL((size_t)4, bt.getFirstNMissingUnusedIndex(out, 10));
+  CPPUNIT_ASSERT_EQUAL((size_t)290007, out[3]);
+
+  ignore[290000 / 8] = 0x0c;
+  CPPUNIT_ASSERT(
+      bt.getSparseMissingUnusedIndex(index, 1, ignore.data(), ignore.size()));
+  CPPUNIT_ASSERT_EQUAL((size_t)290006, index);
+
+  for (size_t i = 290004; i < 290008; ++i) {
+    bt.setUseBit(i);
+  }
+  CPPUNIT_ASSERT(!bt.getFirstMissingUnusedIndex(index));
+  CPPUNIT_ASSERT(
+      !bt.getSparseMissingUnusedIndex(index, 1, ignore.data(), ignore.size()));
+  CPPUNIT_ASSERT(
+      !bt.getInorderMissingUnusedIndex(index, 1, ignore.data(), ignore.size()));
+
+  bt.unsetUseBit(290007);
+  bt.enableFilter();
+  bt.addFilter(0, 290000);
+  CPPUNIT_ASSERT(!bt.getFirstMissingUnusedIndex(index));
+  bt.addFilter(290007, 1);
+  CPPUNIT_ASSERT(bt.getFirstMissingUnusedIndex(index));
+  CPPUNIT_ASSERT_EQUAL((size_t)290007, index);
+}
+
 } // namespace aria2
@@ -0,0 +1,70 @@
+#include "BitfieldSummary.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class BitfieldSummaryTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BitfieldSummaryTest);
+  CPPUNIT_TEST(testSet);
+  CPPUNIT_TEST(testNext);
+  CPPUNIT_TEST(testNext_empty);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testSet();
+  void testNext();
+  void testNext_empty();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BitfieldSummaryTest);
+
+void BitfieldSummaryTest::testSet()
+{
+  BitfieldSummary summary;
+  summary.reset(100);
+  CPPUNIT_ASSERT_EQUAL((size_t)100, summary.size());
+  CPPUNIT_ASSERT(!summary.test(63));
+  summary.set(63, true);
+  summary.set(64, true);
+  CPPUNIT_ASSERT(summary.test(63));
+  CPPUNIT_ASSERT(summary.test(64));
+  summary.set(63, false);
+  CPPUNIT_ASSERT(!summary.test(63));
+  CPPUNIT_ASSERT(summary.test(64));
+  summary.reset(10);
+  CPPUNIT_ASSERT_EQUAL((size_t)10, summary.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, summary.next(0));
+}
+
+void BitfieldSummaryTest::testNext()
+{
+  // 3 words in the second level
+  BitfieldSummary summary;
+  summary.reset(64 * 64 * 2 + 100);
+  summary.set(5, true);
+  summary.set(70, true);
+  summary.set(64 * 64 * 2 + 1, true);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, summary.next(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, summary.next(5));
+  CPPUNIT_ASSERT_EQUAL((size_t)70, summary.next(6));
+  CPPUNIT_ASSERT_EQUAL((size_t)64 * 64 * 2 + 1, summary.next(71));
+  CPPUNIT_ASSERT_EQUAL(summary.size(), summary.next(64 * 64 * 2 + 2));
+  CPPUNIT_ASSERT_EQUAL(summary.size(), summary.next(summary.size()));
+  summary.set(70, false);
+  CPPUNIT_ASSERT_EQUAL((size_t)64 * 64 * 2 + 1, summary.next(6));
+}
+
+void BitfieldSummaryTest::testNext_empty()
+{
+  BitfieldSummary summary;
+  CPPUNIT_ASSERT_EQUAL((size_t)0, summary.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, summary.next(0));
+  summary.reset(4096);
+  CPPUNIT_ASSERT_EQUAL((size_t)4096, summary.next(0));
+  summary.set(4095, true);
+  CPPUNIT_ASSERT_EQUAL((size_t)4095, summary.next(0));
+}
+
+} // namespace aria2
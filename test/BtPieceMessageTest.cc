@@ -16,6 +16,21 @@
 #include "BtHandshakeMessage.h"
 #include "DownloadContext.h"
 #include "BtRejectMessage.h"
+#include "DefaultPieceStorage.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "WorkerPool.h"
+#include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
+#include "DiskWriteQueue.h"
+#include "DiskAdaptor.h"
+#include "RdDiskCache.h"
+#include "RequestGroup.h"
+#include "Option.h"
+#include "PeerConnection.h"
+#include "SocketCore.h"
+#include "ARC4Encryptor.h"
+#include "TestUtil.h"
 
 namespace aria2 {
 
@@ -33,6 +48,8 @@ class BtPieceMessageTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCancelSendingPieceEvent_allowedFastEnabled);
   CPPUNIT_TEST(testCancelSendingPieceEvent_invalidate);
   CPPUNIT_TEST(testToString);
+  CPPUNIT_TEST(testSend_rdDiskCache);
+  CPPUNIT_TEST(testSend_writingPiece);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -48,6 +65,13 @@ public:
   void testCancelSendingPieceEvent_allowedFastEnabled();
   void testCancelSendingPieceEvent_invalidate();
   void testToString();
+  void testSend_rdDiskCache();
+  void testSend_writingPiece();
+
+  // Fills piece 1 of |ps| with 'a' and completes it while its data
+  // are written by the worker thread.  The data stay in memory until
+  // the completion of the writes is processed.
+  void completeWritingPiece(DefaultPieceStorage& ps, WrDiskCache* cache);
 
   class MockBtMessageFactory2 : public MockBtMessageFactory {
   public:
@@ -262,4 +286,140 @@ void BtPieceMessageTest::testToString()
                        msg->toString());
 }
 
+void BtPieceMessageTest::completeWritingPiece(DefaultPieceStorage& ps,
+                                              WrDiskCache* cache)
+{
+  auto piece = ps.getMissingPiece(1, 1);
+  auto data = new unsigned char[16_k];
+  memset(data, 'a', 16_k);
+  // The data are larger than the cache, so they are evicted to
+  // DiskWriteQueue.
+  piece->updateWrCache(cache, data, 0, 16_k, 16_k);
+  CPPUNIT_ASSERT(piece->getWrDiskCacheEntry()->isAsyncWritePending());
+  piece->setAllBlock();
+  piece->flushWrCache(cache);
+  ps.completePiece(piece);
+  CPPUNIT_ASSERT(!ps.hasPiece(1));
+}
+
+void BtPieceMessageTest::testSend_rdDiskCache()
+{
+#ifdef HAVE_STD_THREAD
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setWorkerPool(make_unique<WorkerPool>(1));
+  WrDiskCache wrDiskCache(1_k);
+  wrDiskCache.setDiskWriteQueue(make_unique<DiskWriteQueue>(&e, 1_m));
+  RdDiskCache rdDiskCache(1_m, &wrDiskCache);
+  std::string path = A2_TEST_OUT_DIR "/aria2_BtPieceMessageTest_rdDiskCache";
+  createFile(path, 64_k);
+  auto option = std::make_shared<Option>();
+  auto dctx = std::make_shared<DownloadContext>(16_k, 64_k, path);
+  RequestGroup group(GroupId::create(), option);
+  dctx->setOwnerRequestGroup(&group);
+  DefaultPieceStorage ps(dctx, option.get());
+  ps.setWrDiskCache(&wrDiskCache);
+  ps.setRdDiskCache(&rdDiskCache);
+  ps.initStorage();
+  ps.getDiskAdaptor()->openFile();
+  // The read cache is used when sendfile(2) is not, as with the
+  // encrypted connections.
+  PeerConnection peerConnection(1, peer, std::make_shared<SocketCore>());
+  unsigned char key[20] = {};
+  auto encryptor = make_unique<ARC4Encryptor>();
+  encryptor->init(key, sizeof(key));
+  auto decryptor = make_unique<ARC4Encryptor>();
+  decryptor->init(key, sizeof(key));
+  peerConnection.enableEncryption(std::move(encryptor), std::move(decryptor));
+
+  WorkerBlocker blocker(e.getWorkerPool().get());
+  completeWritingPiece(ps, &wrDiskCache);
+  BtPieceMessage msg(1, 0, 16_k);
+  msg.setDownloadContext(dctx.get());
+  msg.setPeer(peer);
+  msg.setPieceStorage(&ps);
+  msg.setPeerConnection(&peerConnection);
+  msg.send();
+  // The file does not have the data of the piece yet.
+  CPPUNIT_ASSERT_EQUAL((size_t)0, rdDiskCache.countPieces());
+
+  blocker.release();
+  while (e.getWorkerPool()->countPending() > 0) {
+    e.getWorkerPool()->processCompletions();
+  }
+  CPPUNIT_ASSERT(ps.hasPiece(1));
+  msg.send();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, rdDiskCache.countPieces());
+  auto data = rdDiskCache.get(group.getGID(), 1, 16_k, 16_k,
+                              ps.getDiskAdaptor().get());
+  CPPUNIT_ASSERT_EQUAL(std::string(16_k, 'a'),
+                       std::string(data, data + 16_k));
+  ps.getDiskAdaptor()->closeFile();
+#endif // HAVE_STD_THREAD
+}
+
+void BtPieceMessageTest::testSend_writingPiece()
+{
+#ifdef HAVE_STD_THREAD
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setWorkerPool(make_unique<WorkerPool>(1));
+  WrDiskCache wrDiskCache(1_k);
+  wrDiskCache.setDiskWriteQueue(make_unique<DiskWriteQueue>(&e, 1_m));
+  std::string path = A2_TEST_OUT_DIR "/aria2_BtPieceMessageTest_writingPiece";
+  createFile(path, 64_k);
+  auto option = std::make_shared<Option>();
+  auto dctx = std::make_shared<DownloadContext>(16_k, 64_k, path);
+  RequestGroup group(GroupId::create(), option);
+  dctx->setOwnerRequestGroup(&group);
+  DefaultPieceStorage ps(dctx, option.get());
+  ps.setWrDiskCache(&wrDiskCache);
+  ps.initStorage();
+  ps.getDiskAdaptor()->openFile();
+
+  auto server = std::make_shared<SocketCore>();
+  server->bind(0);
+  server->beginListen();
+  server->setBlockingMode();
+  auto endpoint = server->getAddrInfo();
+  auto client = std::make_shared<SocketCore>();
+  client->establishConnection("localhost", endpoint.port);
+  while (!client->isWritable(0)) {
+  }
+  auto inbound = server->acceptConnection();
+  inbound->setBlockingMode();
+  PeerConnection peerConnection(1, peer, client);
+
+  WorkerBlocker blocker(e.getWorkerPool().get());
+  completeWritingPiece(ps, &wrDiskCache);
+  BtPieceMessage msg(1, 1_k, 8_k);
+  msg.setDownloadContext(dctx.get());
+  msg.setPeer(peer);
+  msg.setPieceStorage(&ps);
+  msg.setPeerConnection(&peerConnection);
+  msg.send();
+  // The file has zeros until the worker thread is released, so the
+  // data must be sent from memory instead of with sendfile(2).
+  CPPUNIT_ASSERT_EQUAL((size_t)1, peerConnection.getBufferEntrySize());
+  while (!peerConnection.sendBufferIsEmpty()) {
+    peerConnection.sendPendingData();
+  }
+  std::vector<char> buf(13 + 8_k);
+  size_t total = 0;
+  while (total < buf.size()) {
+    size_t len = buf.size() - total;
+    inbound->readData(buf.data() + total, len);
+    CPPUNIT_ASSERT(len > 0);
+    total += len;
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string(8_k, 'a'),
+                       std::string(buf.begin() + 13, buf.end()));
+
+  blocker.release();
+  while (e.getWorkerPool()->countPending() > 0) {
+    e.getWorkerPool()->processCompletions();
+  }
+  CPPUNIT_ASSERT(ps.hasPiece(1));
+  ps.getDiskAdaptor()->closeFile();
+#endif // HAVE_STD_THREAD
+}
+
 } // namespace aria2
@@ -0,0 +1,80 @@
+// Measures the throughput of the internal message digest implementation
+// with each block function kernel the running CPU supports.  Not run by
+// "make check"; build it with "make cryptohashbench" in this directory.
+//
+// Usage: cryptohashbench [MiB]
+#include "crypto_hash.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* kernelName(crypto::hash::Kernels kernel)
+{
+  switch (kernel) {
+  case crypto::hash::kernelSHANI:
+    return "SHA-NI";
+  case crypto::hash::kernelARMv8:
+    return "ARMv8";
+  default:
+    return "portable";
+  }
+}
+
+// Hashes |mib| MiB in 1MiB updates and returns MiB/s.
+double measure(crypto::hash::Algorithms algo, crypto::hash::Kernels kernel,
+               const std::vector<char>& buf, size_t mib)
+{
+  auto ctx = crypto::hash::create(algo, kernel);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < mib; ++i) {
+    ctx->update(buf.data(), buf.size());
+  }
+  ctx->finalize();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return mib / elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  using namespace crypto::hash;
+
+  size_t mib = argc > 1 ? strtoul(argv[1], nullptr, 10) : 512;
+  if (mib == 0) {
+    fprintf(stderr, "Usage: %s [MiB]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<char> buf(1024 * 1024);
+  for (size_t i = 0; i < buf.size(); ++i) {
+    buf[i] = static_cast<char>(i * 31 + i / 251);
+  }
+
+  const struct {
+    const char* name;
+    Algorithms algo;
+  } algos[] = {{"sha-1", algoSHA1},
+               {"sha-224", algoSHA224},
+               {"sha-256", algoSHA256},
+               {"md5", algoMD5},
+               {"sha-512", algoSHA512}};
+  const Kernels kernels[] = {kernelPortable, kernelSHANI, kernelARMv8};
+
+  for (auto& a : algos) {
+    for (auto kernel : kernels) {
+      if (!supports(a.algo, kernel)) {
+        continue;
+      }
+      printf("%-8s %-9s %8.1f MiB/s\n", a.name, kernelName(kernel),
+             measure(a.algo, kernel, buf, mib));
+    }
+  }
+  return EXIT_SUCCESS;
+}
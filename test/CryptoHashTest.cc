@@ -0,0 +1,104 @@
+#include "crypto_hash.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "util.h"
+
+namespace aria2 {
+
+class CryptoHashTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(CryptoHashTest);
+  CPPUNIT_TEST(testKernels);
+  CPPUNIT_TEST(testKernels_split);
+  CPPUNIT_TEST(testCreate_unsupportedKernel);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testKernels();
+  void testKernels_split();
+  void testCreate_unsupportedKernel();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CryptoHashTest);
+
+namespace {
+const crypto::hash::Kernels kernels[] = {crypto::hash::kernelPortable,
+                                         crypto::hash::kernelSHANI,
+                                         crypto::hash::kernelARMv8};
+} // namespace
+
+void CryptoHashTest::testKernels()
+{
+  using namespace crypto::hash;
+  std::string million(1000000, 'a');
+  for (auto kernel : kernels) {
+    if (!supports(algoSHA1, kernel)) {
+      continue;
+    }
+    auto sha1 = create(algoSHA1, kernel);
+    sha1->update("abc");
+    CPPUNIT_ASSERT_EQUAL(std::string("a9993e364706816aba3e25717850c26c9cd0d89d"),
+                         util::toHex(sha1->finalize()));
+    sha1->update(million);
+    CPPUNIT_ASSERT_EQUAL(std::string("34aa973cd4c4daa4f61eeb2bdbad27316534016f"),
+                         util::toHex(sha1->finalize()));
+
+    auto sha256 = create(algoSHA256, kernel);
+    sha256->update("abc");
+    CPPUNIT_ASSERT_EQUAL(std::string("ba7816bf8f01cfea414140de5dae2223"
+                                     "b00361a396177a9cb410ff61f20015ad"),
+                         util::toHex(sha256->finalize()));
+    sha256->update(million);
+    CPPUNIT_ASSERT_EQUAL(std::string("cdc76e5c9914fb9281a1c7e284d73e67"
+                                     "f1809a48a497200e046d39ccc7112cd0"),
+                         util::toHex(sha256->finalize()));
+
+    auto sha224 = create(algoSHA224, kernel);
+    sha224->update("abc");
+    CPPUNIT_ASSERT_EQUAL(std::string("23097d223405d8228642a477bda255b3"
+                                     "2aadbce4bda0b3f7e36c9da7"),
+                         util::toHex(sha224->finalize()));
+  }
+}
+
+void CryptoHashTest::testKernels_split()
+{
+  using namespace crypto::hash;
+  std::string data;
+  for (int i = 0; i < 4099; ++i) {
+    data += static_cast<char>(i * 7 + (i >> 5));
+  }
+  for (auto algo : {algoSHA1, algoSHA224, algoSHA256}) {
+    auto expected = compute(algo, data);
+    for (auto kernel : kernels) {
+      if (!supports(algo, kernel)) {
+        continue;
+      }
+      // Feed chunks which leave partial blocks behind, so that buffered
+      // and bulk blocks are mixed.
+      auto ctx = create(algo, kernel);
+      for (size_t pos = 0, len = 1; pos < data.size(); pos += len, len += 13) {
+        ctx->update(data.data() + pos, std::min(len, data.size() - pos));
+      }
+      CPPUNIT_ASSERT_EQUAL(util::toHex(expected), util::toHex(ctx->finalize()));
+    }
+  }
+}
+
+void CryptoHashTest::testCreate_unsupportedKernel()
+{
+  using namespace crypto::hash;
+  CPPUNIT_ASSERT(supports(algoMD5, kernelPortable));
+  CPPUNIT_ASSERT(!supports(algoMD5, kernelSHANI));
+  CPPUNIT_ASSERT(!supports(algoSHA512, kernelARMv8));
+  try {
+    create(algoSHA512, kernelSHANI);
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (std::domain_error& e) {
+  }
+  CPPUNIT_ASSERT_EQUAL(kernelPortable, kernel(algoMD5));
+}
+
+} // namespace aria2
@@ -2,6 +2,11 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "BufferedFile.h"
+#include "TimeA2.h"
+#include "wallclock.h"
+#include "fmt.h"
+
 namespace aria2 {
 
 class DNSCacheTest : public CppUnit::TestFixture {
@@ -11,6 +16,13 @@ class DNSCacheTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testMarkBad);
   CPPUNIT_TEST(testPutBadAddr);
   CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testTTL);
+  CPPUNIT_TEST(testClampTTL);
+  CPPUNIT_TEST(testNegative);
+  CPPUNIT_TEST(testRemoveExpired);
+  CPPUNIT_TEST(testNextRefreshCandidate);
+  CPPUNIT_TEST(testSaveAndLoad);
+  CPPUNIT_TEST(testLoad);
   CPPUNIT_TEST_SUITE_END();
 
   DNSCache cache_;
@@ -18,6 +30,7 @@ class DNSCacheTest : public CppUnit::TestFixture {
 public:
   void setUp()
   {
+    global::wallclock().reset();
     cache_ = DNSCache();
     cache_.put("www", "192.168.0.1", 80);
     cache_.put("www", "::1", 80);
@@ -29,6 +42,13 @@ public:
   void testMarkBad();
   void testPutBadAddr();
   void testRemove();
+  void testTTL();
+  void testClampTTL();
+  void testNegative();
+  void testRemoveExpired();
+  void testNextRefreshCandidate();
+  void testSaveAndLoad();
+  void testLoad();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DNSCacheTest);
@@ -61,4 +81,147 @@ void DNSCacheTest::testRemove()
   CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
 }
 
+void DNSCacheTest::testTTL()
+{
+  cache_.put("www", "192.168.0.2", 443, 60_s);
+  global::wallclock().advance(59_s);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache_.find("www", 443));
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 443));
+  // Address without TTL is kept for max TTL.
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache_.find("www", 80));
+  global::wallclock().advance(cache_.getMaxTTL());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
+  std::vector<std::string> addrs;
+  cache_.findAll(std::back_inserter(addrs), "www", 80);
+  CPPUNIT_ASSERT(addrs.empty());
+}
+
+void DNSCacheTest::testClampTTL()
+{
+  cache_.setMinTTL(30_s);
+  cache_.setMaxTTL(300_s);
+  cache_.put("short", "192.168.0.2", 80, 1_s);
+  cache_.put("long", "192.168.0.3", 80, 86400_s);
+  global::wallclock().advance(29_s);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache_.find("short", 80));
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("short", 80));
+  global::wallclock().advance(269_s);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), cache_.find("long", 80));
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("long", 80));
+}
+
+void DNSCacheTest::testNegative()
+{
+  std::string error;
+  cache_.setNegativeTTL(5_s);
+  cache_.putNegative("nx", 80, "Domain name not found");
+  CPPUNIT_ASSERT(cache_.findNegative(error, "nx", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("Domain name not found"), error);
+  CPPUNIT_ASSERT(!cache_.findNegative(error, "nx", 443));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("nx", 80));
+  global::wallclock().advance(5_s);
+  CPPUNIT_ASSERT(!cache_.findNegative(error, "nx", 80));
+
+  // Negative answer discards addresses, and positive one clears it.
+  cache_.putNegative("www", 80, "Server failure");
+  CPPUNIT_ASSERT(cache_.findNegative(error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
+  cache_.put("www", "192.168.0.2", 80);
+  CPPUNIT_ASSERT(!cache_.findNegative(error, "www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache_.find("www", 80));
+
+  cache_.setNegativeTTL(0_s);
+  cache_.putNegative("ftp", 21, "Domain name not found");
+  CPPUNIT_ASSERT(!cache_.findNegative(error, "ftp", 21));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache_.find("ftp", 21));
+}
+
+void DNSCacheTest::testRemoveExpired()
+{
+  cache_.put("www", "192.168.0.2", 443, 60_s);
+  cache_.putNegative("nx", 80, "Domain name not found");
+  CPPUNIT_ASSERT_EQUAL((size_t)5, cache_.size());
+  global::wallclock().advance(cache_.getNegativeTTL());
+  cache_.removeExpired();
+  CPPUNIT_ASSERT_EQUAL((size_t)4, cache_.size());
+  global::wallclock().advance(60_s);
+  cache_.removeExpired();
+  CPPUNIT_ASSERT_EQUAL((size_t)3, cache_.size());
+  global::wallclock().advance(cache_.getMaxTTL());
+  cache_.removeExpired();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache_.size());
+}
+
+void DNSCacheTest::testNextRefreshCandidate()
+{
+  std::string hostname;
+  uint16_t port;
+  cache_.put("hot", "192.168.0.2", 80, 100_s);
+  cache_.put("cold", "192.168.0.3", 80, 100_s);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache_.find("hot", 80));
+  global::wallclock().advance(74_s);
+  CPPUNIT_ASSERT(!cache_.nextRefreshCandidate(hostname, port));
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT(cache_.nextRefreshCandidate(hostname, port));
+  CPPUNIT_ASSERT_EQUAL(std::string("hot"), hostname);
+  CPPUNIT_ASSERT_EQUAL((uint16_t)80, port);
+  // Not returned again until it is looked up again.
+  CPPUNIT_ASSERT(!cache_.nextRefreshCandidate(hostname, port));
+  cache_.put("hot", "192.168.0.2", 80, 100_s);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache_.find("hot", 80));
+  CPPUNIT_ASSERT(!cache_.nextRefreshCandidate(hostname, port));
+}
+
+void DNSCacheTest::testSaveAndLoad()
+{
+  const char* filename = A2_TEST_OUT_DIR "/aria2_DNSCacheTest_testSaveAndLoad";
+  cache_.put("www", "192.168.0.2", 443, 60_s);
+  cache_.markBad("www", "::1", 80);
+  cache_.putNegative("nx", 80, "Domain name not found");
+  CPPUNIT_ASSERT(cache_.save(filename));
+
+  global::wallclock().reset();
+  DNSCache cache;
+  CPPUNIT_ASSERT(cache.load(filename));
+  std::vector<std::string> addrs;
+  cache.findAll(std::back_inserter(addrs), "www", 80);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), addrs[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), cache.find("www", 443));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache.find("ftp", 21));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.1.2"), cache.find("proxy", 8080));
+  std::string error;
+  CPPUNIT_ASSERT(!cache.findNegative(error, "nx", 80));
+  // The remaining lifetime is restored, not the original TTL.
+  global::wallclock().advance(60_s);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find("www", 443));
+}
+
+void DNSCacheTest::testLoad()
+{
+  const char* filename = A2_TEST_OUT_DIR "/aria2_DNSCacheTest_testLoad";
+  auto now = Time().getTimeFromEpoch();
+  std::string in =
+      fmt("host=www, port=80, addr=192.168.0.2, ttl=60, expires=%ld\n"
+          "host=www, port=80, addr=192.168.0.3, ttl=60, expires=%ld\n"
+          "host=www, port=99999, addr=192.168.0.4, ttl=60, expires=%ld\n"
+          "host=ftp, addr=192.168.0.5, ttl=60, expires=%ld\n",
+          static_cast<long>(now - 1), static_cast<long>(now + 100),
+          static_cast<long>(now + 100), static_cast<long>(now + 100));
+  BufferedFile fp(filename, BufferedFile::WRITE);
+  CPPUNIT_ASSERT_EQUAL((size_t)in.size(), fp.write(in.data(), in.size()));
+  CPPUNIT_ASSERT(fp.close() != EOF);
+
+  DNSCache cache;
+  CPPUNIT_ASSERT(cache.load(filename));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+  std::vector<std::string> addrs;
+  cache.findAll(std::back_inserter(addrs), "www", 80);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), addrs[0]);
+}
+
 } // namespace aria2
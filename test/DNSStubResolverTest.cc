@@ -0,0 +1,495 @@
+#include "DNSStubResolver.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "BufferedFile.h"
+#include "File.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+class DNSStubResolverTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DNSStubResolverTest);
+  CPPUNIT_TEST(testCreateQuery);
+  CPPUNIT_TEST(testParseResponse);
+  CPPUNIT_TEST(testParseResponse_mismatch);
+  CPPUNIT_TEST(testParseResolvConf);
+  CPPUNIT_TEST(testResolvConfLoader);
+  CPPUNIT_TEST(testGetSystemResolvConf_servers);
+  CPPUNIT_TEST(testLookupHostsFile);
+  CPPUNIT_TEST(testResolve);
+  CPPUNIT_TEST(testResolve_aaaa);
+  CPPUNIT_TEST(testResolve_nxdomain);
+  CPPUNIT_TEST(testResolve_search);
+  CPPUNIT_TEST(testResolve_retryNextServer);
+  CPPUNIT_TEST(testResolve_truncated);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<SocketCore> server_;
+  std::shared_ptr<ResolvConf> conf_;
+
+public:
+  void setUp()
+  {
+    global::wallclock().reset();
+    server_ = std::make_shared<SocketCore>(SOCK_DGRAM);
+    server_->bind("127.0.0.1", 0, AF_INET);
+    conf_ = std::make_shared<ResolvConf>();
+    conf_->servers.emplace_back("127.0.0.1", server_->getAddrInfo().port);
+    conf_->hostsFile = A2_TEST_DIR "/nonexistent";
+  }
+
+  void testCreateQuery();
+  void testParseResponse();
+  void testParseResponse_mismatch();
+  void testParseResolvConf();
+  void testResolvConfLoader();
+  void testGetSystemResolvConf_servers();
+  void testLookupHostsFile();
+  void testResolve();
+  void testResolve_aaaa();
+  void testResolve_nxdomain();
+  void testResolve_search();
+  void testResolve_retryNextServer();
+  void testResolve_truncated();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DNSStubResolverTest);
+
+namespace {
+// Returns the response to query.  Each answer in answers is a
+// (type, rdata) pair owned by the queried name, and the CNAME rdata
+// is appended as uncompressed name.
+std::string
+createResponse(const std::string& query, int rcode, bool truncated,
+               const std::vector<std::pair<uint16_t, std::string>>& answers,
+               uint32_t ttl = 300)
+{
+  std::string res = query.substr(0, 2);
+  res += static_cast<char>(0x81 | (truncated ? 0x02 : 0));
+  res += static_cast<char>(0x80 | rcode);
+  // QDCOUNT, ANCOUNT, NSCOUNT, ARCOUNT
+  res += std::string("\x00\x01", 2);
+  res += static_cast<char>(0);
+  res += static_cast<char>(answers.size());
+  res += std::string(4, '\0');
+  res += query.substr(12);
+  for (const auto& a : answers) {
+    // Pointer to the question name
+    res += "\xc0\x0c";
+    res += static_cast<char>(0);
+    res += static_cast<char>(a.first);
+    res += std::string("\x00\x01", 2);
+    res += static_cast<char>(ttl >> 24);
+    res += static_cast<char>(ttl >> 16);
+    res += static_cast<char>(ttl >> 8);
+    res += static_cast<char>(ttl);
+    res += static_cast<char>(a.second.size() >> 8);
+    res += static_cast<char>(a.second.size());
+    res += a.second;
+  }
+  return res;
+}
+} // namespace
+
+namespace {
+// Receives a query at server and returns it.  sender is set to the
+// address of the resolver.
+std::string receiveQuery(SocketCore& server, Endpoint& sender)
+{
+  CPPUNIT_ASSERT(server.isReadable(1));
+  unsigned char buf[512];
+  ssize_t len = server.readDataFrom(buf, sizeof(buf), sender);
+  CPPUNIT_ASSERT(len >= 12);
+  return std::string(&buf[0], &buf[len]);
+}
+} // namespace
+
+namespace {
+void answer(SocketCore& server, const std::string& response,
+            const Endpoint& sender)
+{
+  server.writeData(response.data(), response.size(), sender.addr,
+                   sender.port);
+}
+} // namespace
+
+namespace {
+// Waits for the socket of resolver to get ready and processes it.
+void processResolver(DNSStubResolver& resolver)
+{
+  const auto& socket = resolver.getSocket();
+  bool readable = resolver.wantRead() && socket->isReadable(1);
+  bool writable = resolver.wantWrite() && socket->isWritable(1);
+  resolver.process(readable, writable);
+}
+} // namespace
+
+void DNSStubResolverTest::testCreateQuery()
+{
+  auto query = dns::createQuery(0x1234, "www.example.org.", dns::TYPE_AAAA);
+  CPPUNIT_ASSERT_EQUAL(std::string("\x12\x34\x01\x00"
+                                   "\x00\x01\x00\x00\x00\x00\x00\x00"
+                                   "\x03www\x07"
+                                   "example\x03org\x00"
+                                   "\x00\x1c\x00\x01",
+                                   33),
+                       query);
+  CPPUNIT_ASSERT(dns::createQuery(1, "", dns::TYPE_A).empty());
+  CPPUNIT_ASSERT(dns::createQuery(1, "www..org", dns::TYPE_A).empty());
+  CPPUNIT_ASSERT(
+      dns::createQuery(1, std::string(64, 'a'), dns::TYPE_A).empty());
+}
+
+void DNSStubResolverTest::testParseResponse()
+{
+  auto query = dns::createQuery(0x1234, "www.example.org", dns::TYPE_A);
+  // www.example.org CNAME (TTL 60) cdn.example.net, which has 2
+  // addresses with TTL 300.
+  std::string res = createResponse(
+      query, dns::RCODE_NOERROR, false,
+      {{dns::TYPE_CNAME, std::string("\x03"
+                                     "cdn\x07"
+                                     "example\x03net\x00",
+                                     17)}},
+      60);
+  // Answer count is 3
+  res[7] = 3;
+  size_t cdnOffset = res.size() - 17;
+  for (auto& addr : {std::string("\xc0\xa8\x00\x01", 4),
+                     std::string("\xc0\xa8\x00\x02", 4)}) {
+    res += static_cast<char>(0xc0);
+    res += static_cast<char>(cdnOffset);
+    res += std::string("\x00\x01\x00\x01\x00\x00\x01\x2c\x00\x04", 10);
+    res += addr;
+  }
+  dns::Response r;
+  CPPUNIT_ASSERT(dns::parseResponse(
+      r, reinterpret_cast<const unsigned char*>(res.data()), res.size(),
+      "WWW.example.org", dns::TYPE_A));
+  CPPUNIT_ASSERT_EQUAL((uint16_t)0x1234, r.id);
+  CPPUNIT_ASSERT_EQUAL(dns::RCODE_NOERROR, r.rcode);
+  CPPUNIT_ASSERT(!r.truncated);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, r.addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), r.addrs[0].first);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)60, r.addrs[0].second);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), r.addrs[1].first);
+
+  // Truncated message is parsed up to the question.
+  res = createResponse(query, dns::RCODE_NOERROR, true, {});
+  CPPUNIT_ASSERT(dns::parseResponse(
+      r, reinterpret_cast<const unsigned char*>(res.data()), res.size(),
+      "www.example.org", dns::TYPE_A));
+  CPPUNIT_ASSERT(r.truncated);
+  CPPUNIT_ASSERT(r.addrs.empty());
+}
+
+void DNSStubResolverTest::testParseResponse_mismatch()
+{
+  auto query = dns::createQuery(1, "www.example.org", dns::TYPE_A);
+  auto res =
+      createResponse(query, dns::RCODE_NOERROR, false,
+                     {{dns::TYPE_A, std::string("\x7f\x00\x00\x01", 4)}});
+  auto data = reinterpret_cast<const unsigned char*>(res.data());
+  dns::Response r;
+  CPPUNIT_ASSERT(dns::parseResponse(r, data, res.size(), "www.example.org",
+                                    dns::TYPE_A));
+  CPPUNIT_ASSERT(!dns::parseResponse(r, data, res.size(), "www.example.com",
+                                     dns::TYPE_A));
+  CPPUNIT_ASSERT(!dns::parseResponse(r, data, res.size(), "www.example.org",
+                                     dns::TYPE_AAAA));
+  // Cut in the middle of the answer
+  CPPUNIT_ASSERT(!dns::parseResponse(r, data, res.size() - 1,
+                                     "www.example.org", dns::TYPE_A));
+  // The query itself is not a response.
+  CPPUNIT_ASSERT(!dns::parseResponse(
+      r, reinterpret_cast<const unsigned char*>(query.data()), query.size(),
+      "www.example.org", dns::TYPE_A));
+}
+
+void DNSStubResolverTest::testParseResolvConf()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_DNSStubResolverTest_testParseResolvConf";
+  {
+    BufferedFile fp(filename.c_str(), BufferedFile::WRITE);
+    fp.printf("# comment\n"
+              "nameserver 192.168.0.1\n"
+              "nameserver\t2001:db8:0::1\n"
+              "nameserver example.org\n"
+              "domain example.org\n"
+              "search a.example.org b.example.org.\n"
+              "options ndots:2 timeout:3 attempts:10 rotate\n");
+  }
+  ResolvConf conf;
+  parseResolvConf(conf, filename);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, conf.servers.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), conf.servers[0].first);
+  CPPUNIT_ASSERT_EQUAL((uint16_t)53, conf.servers[0].second);
+  CPPUNIT_ASSERT_EQUAL(std::string("2001:db8::1"), conf.servers[1].first);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, conf.search.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("a.example.org"), conf.search[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("b.example.org"), conf.search[1]);
+  CPPUNIT_ASSERT_EQUAL(2, conf.ndots);
+  CPPUNIT_ASSERT(std::chrono::seconds(3) == conf.timeout);
+  CPPUNIT_ASSERT_EQUAL(5, conf.attempts);
+
+  ResolvConf defconf;
+  parseResolvConf(defconf, A2_TEST_DIR "/nonexistent");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, defconf.servers.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("127.0.0.1"), defconf.servers[0].first);
+  CPPUNIT_ASSERT(defconf.search.empty());
+  CPPUNIT_ASSERT_EQUAL(1, defconf.ndots);
+}
+
+void DNSStubResolverTest::testResolvConfLoader()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_DNSStubResolverTest_testResolvConfLoader";
+  {
+    BufferedFile fp(filename.c_str(), BufferedFile::WRITE);
+    fp.printf("nameserver 192.168.0.1\n");
+  }
+  File(filename).utime(Time(1000000000), Time(1000000000));
+  ResolvConfLoader loader(filename);
+  auto conf = loader.get();
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), conf->servers[0].first);
+  // Not read again unless the file changes.
+  CPPUNIT_ASSERT(conf == loader.get());
+
+  // Same size, different modification time.
+  {
+    BufferedFile fp(filename.c_str(), BufferedFile::WRITE);
+    fp.printf("nameserver 192.168.0.2\n");
+  }
+  File(filename).utime(Time(1000000001), Time(1000000001));
+  conf = loader.get();
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), conf->servers[0].first);
+
+  // Same modification time, different size.
+  {
+    BufferedFile fp(filename.c_str(), BufferedFile::WRITE);
+    fp.printf("nameserver 192.168.0.3\n"
+              "search example.org\n");
+  }
+  File(filename).utime(Time(1000000001), Time(1000000001));
+  conf = loader.get();
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), conf->servers[0].first);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, conf->search.size());
+
+  File(filename).remove();
+  conf = loader.get();
+  CPPUNIT_ASSERT_EQUAL(std::string("127.0.0.1"), conf->servers[0].first);
+}
+
+void DNSStubResolverTest::testGetSystemResolvConf_servers()
+{
+  std::vector<std::pair<std::string, uint16_t>> servers{
+      {"192.168.0.1", 53}, {"2001:db8::1", 53}};
+  auto conf = getSystemResolvConf(servers);
+  CPPUNIT_ASSERT(servers == conf->servers);
+  // The servers in /etc/resolv.conf are left intact.
+  CPPUNIT_ASSERT(servers != getSystemResolvConf()->servers);
+}
+
+void DNSStubResolverTest::testLookupHostsFile()
+{
+  std::string filename =
+      A2_TEST_OUT_DIR "/aria2_DNSStubResolverTest_testLookupHostsFile";
+  {
+    BufferedFile fp(filename.c_str(), BufferedFile::WRITE);
+    fp.printf("127.0.0.1 localhost\n"
+              "192.168.0.1\tmirror Mirror.example.org # comment\n"
+              "::1 localhost mirror\n"
+              "# 192.168.0.2 mirror\n");
+  }
+  std::vector<std::string> addrs;
+  lookupHostsFile(addrs, filename, "mirror.example.org", AF_INET);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), addrs[0]);
+  addrs.clear();
+  lookupHostsFile(addrs, filename, "mirror", AF_INET6);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, addrs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("::1"), addrs[0]);
+  addrs.clear();
+  lookupHostsFile(addrs, filename, "comment", AF_INET);
+  CPPUNIT_ASSERT(addrs.empty());
+}
+
+void DNSStubResolverTest::testResolve()
+{
+  DNSStubResolver resolver(AF_INET, conf_);
+  resolver.resolve("www.example.org");
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_QUERYING, resolver.getStatus());
+  CPPUNIT_ASSERT(resolver.wantRead());
+  CPPUNIT_ASSERT(!resolver.wantWrite());
+
+  Endpoint sender;
+  auto query = receiveQuery(*server_, sender);
+  // Response from unexpected address is ignored.
+  SocketCore stranger(SOCK_DGRAM);
+  stranger.bind("127.0.0.1", 0, AF_INET);
+  answer(stranger,
+         createResponse(query, dns::RCODE_NOERROR, false,
+                        {{dns::TYPE_A, std::string("\x7f\x00\x00\x02", 4)}}),
+         sender);
+  answer(*server_,
+         createResponse(query, dns::RCODE_NOERROR, false,
+                        {{dns::TYPE_A, std::string("\x7f\x00\x00\x01", 4)}},
+                        600),
+         sender);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_SUCCESS, resolver.getStatus());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, resolver.getResolvedAddresses().size());
+  CPPUNIT_ASSERT_EQUAL(std::string("127.0.0.1"),
+                       resolver.getResolvedAddresses()[0]);
+  CPPUNIT_ASSERT_EQUAL(600, resolver.getResolvedTTLs()[0]);
+  CPPUNIT_ASSERT(!resolver.getSocket());
+}
+
+void DNSStubResolverTest::testResolve_aaaa()
+{
+  DNSStubResolver resolver(AF_INET6, conf_);
+  resolver.resolve("www.example.org");
+  Endpoint sender;
+  auto query = receiveQuery(*server_, sender);
+  CPPUNIT_ASSERT_EQUAL(std::string("\x00\x1c", 2),
+                       query.substr(query.size() - 4, 2));
+  answer(*server_,
+         createResponse(query, dns::RCODE_NOERROR, false,
+                        {{dns::TYPE_AAAA, std::string("\x20\x01\x0d\xb8"
+                                                      "\x00\x00\x00\x00"
+                                                      "\x00\x00\x00\x00"
+                                                      "\x00\x00\x00\x01",
+                                                      16)}}),
+         sender);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_SUCCESS, resolver.getStatus());
+  CPPUNIT_ASSERT_EQUAL(std::string("2001:db8::1"),
+                       resolver.getResolvedAddresses()[0]);
+}
+
+void DNSStubResolverTest::testResolve_nxdomain()
+{
+  DNSStubResolver resolver(AF_INET, conf_);
+  resolver.resolve("nonexistent.example.org");
+  Endpoint sender;
+  auto query = receiveQuery(*server_, sender);
+  answer(*server_, createResponse(query, dns::RCODE_NXDOMAIN, false, {}),
+         sender);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_ERROR, resolver.getStatus());
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::ERR_NXDOMAIN, resolver.getErrorCode());
+  CPPUNIT_ASSERT(resolver.isNegativeAnswer());
+}
+
+void DNSStubResolverTest::testResolve_search()
+{
+  conf_->search.push_back("example.org");
+  DNSStubResolver resolver(AF_INET, conf_);
+  resolver.resolve("www");
+  Endpoint sender;
+  // The name without dot is tried with search domain first.
+  auto query = receiveQuery(*server_, sender);
+  CPPUNIT_ASSERT_EQUAL(std::string("\x03www\x07"
+                                   "example\x03org\x00",
+                                   17),
+                       query.substr(12, 17));
+  answer(*server_, createResponse(query, dns::RCODE_NOERROR, false, {}),
+         sender);
+  processResolver(resolver);
+  query = receiveQuery(*server_, sender);
+  CPPUNIT_ASSERT_EQUAL(std::string("\x03www\x00", 5), query.substr(12, 5));
+  answer(*server_, createResponse(query, dns::RCODE_NXDOMAIN, false, {}),
+         sender);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_ERROR, resolver.getStatus());
+  // The name exists with the search domain.
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::ERR_NODATA, resolver.getErrorCode());
+}
+
+void DNSStubResolverTest::testResolve_retryNextServer()
+{
+  SocketCore deadServer(SOCK_DGRAM);
+  deadServer.bind("127.0.0.1", 0, AF_INET);
+  conf_->servers.insert(std::begin(conf_->servers),
+                        {"127.0.0.1", deadServer.getAddrInfo().port});
+  conf_->attempts = 1;
+  DNSStubResolver resolver(AF_INET, conf_);
+  resolver.resolve("www.example.org");
+  Endpoint sender;
+  receiveQuery(deadServer, sender);
+  resolver.process(false, false);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_QUERYING, resolver.getStatus());
+
+  global::wallclock().advance(conf_->timeout);
+  resolver.process(false, false);
+  auto query = receiveQuery(*server_, sender);
+  answer(*server_,
+         createResponse(query, dns::RCODE_NOERROR, false,
+                        {{dns::TYPE_A, std::string("\x7f\x00\x00\x01", 4)}}),
+         sender);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_SUCCESS, resolver.getStatus());
+
+  // All servers time out.
+  DNSStubResolver resolver2(AF_INET, conf_);
+  resolver2.resolve("www.example.org");
+  receiveQuery(deadServer, sender);
+  global::wallclock().advance(conf_->timeout);
+  resolver2.process(false, false);
+  receiveQuery(*server_, sender);
+  global::wallclock().advance(conf_->timeout);
+  resolver2.process(false, false);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_ERROR, resolver2.getStatus());
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::ERR_TIMEOUT, resolver2.getErrorCode());
+  CPPUNIT_ASSERT(!resolver2.isNegativeAnswer());
+}
+
+void DNSStubResolverTest::testResolve_truncated()
+{
+  SocketCore listener;
+  listener.bind("127.0.0.1", conf_->servers[0].second, AF_INET);
+  listener.beginListen();
+  DNSStubResolver resolver(AF_INET, conf_);
+  resolver.resolve("www.example.org");
+  Endpoint sender;
+  auto query = receiveQuery(*server_, sender);
+  answer(*server_, createResponse(query, dns::RCODE_NOERROR, true, {}),
+         sender);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_QUERYING, resolver.getStatus());
+  CPPUNIT_ASSERT(resolver.wantWrite());
+
+  CPPUNIT_ASSERT(listener.isReadable(1));
+  auto conn = listener.acceptConnection();
+  processResolver(resolver);
+  CPPUNIT_ASSERT(resolver.wantRead());
+
+  CPPUNIT_ASSERT(conn->isReadable(1));
+  unsigned char buf[512];
+  size_t len = sizeof(buf);
+  conn->readData(buf, len);
+  CPPUNIT_ASSERT(len > 2);
+  CPPUNIT_ASSERT_EQUAL(len - 2, (size_t)((buf[0] << 8) | buf[1]));
+  query.assign(&buf[2], &buf[len]);
+  auto res =
+      createResponse(query, dns::RCODE_NOERROR, false,
+                     {{dns::TYPE_A, std::string("\x7f\x00\x00\x01", 4)},
+                      {dns::TYPE_A, std::string("\x7f\x00\x00\x02", 4)}});
+  // Send the length prefix and the message separately.
+  std::string prefix;
+  prefix += static_cast<char>(res.size() >> 8);
+  prefix += static_cast<char>(res.size());
+  conn->writeData(prefix);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_QUERYING, resolver.getStatus());
+  conn->writeData(res);
+  processResolver(resolver);
+  CPPUNIT_ASSERT_EQUAL(DNSStubResolver::STATUS_SUCCESS, resolver.getStatus());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, resolver.getResolvedAddresses().size());
+}
+
+} // namespace aria2
@@ -20,6 +20,7 @@
 #include "array_fun.h"
 #include "UDPTrackerRequest.h"
 #include "SocketCore.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -37,6 +38,7 @@ class DefaultBtAnnounceTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testProcessAnnounceResponse_failureReason);
   CPPUNIT_TEST(testProcessAnnounceResponse);
   CPPUNIT_TEST(testProcessUDPTrackerResponse);
+  CPPUNIT_TEST(testGetNextAnnounceTime);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -94,6 +96,7 @@ public:
   void testProcessAnnounceResponse_failureReason();
   void testProcessAnnounceResponse();
   void testProcessUDPTrackerResponse();
+  void testGetNextAnnounceTime();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DefaultBtAnnounceTest);
@@ -619,4 +622,21 @@ void DefaultBtAnnounceTest::testProcessUDPTrackerResponse()
   }
 }
 
+void DefaultBtAnnounceTest::testGetNextAnnounceTime()
+{
+  DefaultBtAnnounce an(dctx_.get(), option_);
+  an.setPeerStorage(peerStorage_);
+  an.setBtRuntime(btRuntime_);
+  an.overrideMinInterval(std::chrono::seconds(120));
+  an.resetAnnounce();
+  auto expected = global::wallclock();
+  expected.advance(std::chrono::seconds(120));
+  CPPUNIT_ASSERT(expected.getTime() == an.getNextAnnounceTime().getTime());
+
+  an.setUserDefinedInterval(std::chrono::seconds(30));
+  expected = global::wallclock();
+  expected.advance(std::chrono::seconds(30));
+  CPPUNIT_ASSERT(expected.getTime() == an.getNextAnnounceTime().getTime());
+}
+
 } // namespace aria2
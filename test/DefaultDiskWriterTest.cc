@@ -1,7 +1,11 @@
 #include "DefaultDiskWriter.h"
+#include <unistd.h>
+
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "File.h"
 #include "a2functional.h"
+#include "SharedFd.h"
 
 namespace aria2 {
 
@@ -9,6 +13,8 @@ class DefaultDiskWriterTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DefaultDiskWriterTest);
   CPPUNIT_TEST(testSize);
+  CPPUNIT_TEST(testQueueWrite);
+  CPPUNIT_TEST(testShareReadFd);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -16,6 +22,8 @@ public:
   void setUp() {}
 
   void testSize();
+  void testQueueWrite();
+  void testShareReadFd();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DefaultDiskWriterTest);
@@ -28,4 +36,53 @@ void DefaultDiskWriterTest::testSize()
   CPPUNIT_ASSERT_EQUAL((int64_t)4_k, dw.size());
 }
 
+void DefaultDiskWriterTest::testQueueWrite()
+{
+  std::string path = A2_TEST_OUT_DIR "/aria2_DefaultDiskWriterTest";
+  File(path).remove();
+  DefaultDiskWriter dw(path);
+  dw.initAndOpenFile();
+  auto data = reinterpret_cast<const unsigned char*>("0123456789");
+  dw.queueWrite(data, 3, 0);
+  dw.queueWrite(data + 3, 4, 3);
+  // Not contiguous; the queued writes are flushed.
+  dw.queueWrite(data, 2, 10);
+  CPPUNIT_ASSERT_EQUAL((int64_t)7, dw.size());
+  dw.queueWrite(data + 2, 8, 12);
+  dw.flushWrites();
+  CPPUNIT_ASSERT_EQUAL((int64_t)20, dw.size());
+  unsigned char buf[20];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)20, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456"), std::string(&buf[0], &buf[7]));
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789"),
+                       std::string(&buf[10], &buf[20]));
+  // Queued writes are flushed when the file is closed.
+  dw.queueWrite(data, 1, 20);
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL((int64_t)21, File(path).size());
+}
+
+void DefaultDiskWriterTest::testShareReadFd()
+{
+  DefaultDiskWriter dw(A2_TEST_DIR "/4096chunk.txt");
+  CPPUNIT_ASSERT(!dw.shareReadFd());
+  dw.enableReadOnly();
+  dw.openExistingFile();
+  auto fd1 = dw.shareReadFd();
+#ifndef __MINGW32__
+  CPPUNIT_ASSERT(fd1);
+  // The same file descriptor is returned while it is referenced.
+  CPPUNIT_ASSERT(fd1 == dw.shareReadFd());
+  auto rawFd = fd1->get();
+  // It stays valid after the file is closed.
+  dw.closeFile();
+  char c;
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, pread(rawFd, &c, 1, 0));
+  fd1.reset();
+  CPPUNIT_ASSERT(!dw.shareReadFd());
+  dw.openExistingFile();
+  CPPUNIT_ASSERT(dw.shareReadFd());
+#endif // !__MINGW32__
+}
+
 } // namespace aria2
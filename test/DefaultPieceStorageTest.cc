@@ -1,5 +1,7 @@
 #include "DefaultPieceStorage.h"
 
+#include <cstring>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "util.h"
@@ -16,6 +18,16 @@
 #include "DiskWriterFactory.h"
 #include "PieceStatMan.h"
 #include "prefs.h"
+#include "WorkerPool.h"
+#include "TestUtil.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
+#include "DiskWriteQueue.h"
+#include "RequestGroup.h"
+#include "GroupId.h"
+#include "File.h"
 
 namespace aria2 {
 
@@ -40,6 +52,9 @@ class DefaultPieceStorageTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testGetFilteredCompletedLength);
   CPPUNIT_TEST(testGetNextUsedIndex);
   CPPUNIT_TEST(testAdvertisePiece);
+  CPPUNIT_TEST(testVerifyPieceInWorker);
+  CPPUNIT_TEST(testCompletePiece_asyncWrite);
+  CPPUNIT_TEST(testCompletePiece_asyncWriteFailure);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -78,7 +93,16 @@ public:
   void testGetCompletedLength();
   void testGetFilteredCompletedLength();
   void testGetNextUsedIndex();
+  void testVerifyPieceInWorker();
   void testAdvertisePiece();
+  void testCompletePiece_asyncWrite();
+  void testCompletePiece_asyncWriteFailure();
+
+  // Caches the data of piece 1 of |ps| and completes the piece while
+  // the data are written by a worker thread.
+  std::shared_ptr<Piece> completePieceWithAsyncWrite(DefaultPieceStorage& ps,
+                                                     DownloadEngine& e,
+                                                     WrDiskCache& cache);
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DefaultPieceStorageTest);
@@ -457,4 +481,151 @@ void DefaultPieceStorageTest::testAdvertisePiece()
   CPPUNIT_ASSERT_EQUAL((size_t)0, res.size());
 }
 
+void DefaultPieceStorageTest::testVerifyPieceInWorker()
+{
+  auto dctx = std::make_shared<DownloadContext>(
+      100, 250, A2_TEST_DIR "/chunkChecksumTestFile250.txt");
+  std::vector<std::string> hashes{
+      fromHex("29b0e7878271645fffb7eec7db4a7473a1c00bc1"),
+      fromHex("4df75a661cb7eb2733d9cdaa7f772eae3a4e2976"),
+      fromHex("0a4ea2f7dd7c52ddf2099a444ab2184b4d341bdb")};
+  dctx->setPieceHashes("sha-1", std::begin(hashes), std::end(hashes));
+  DefaultPieceStorage ps(dctx, option_.get());
+  ps.initStorage();
+  ps.getDiskAdaptor()->enableReadOnly();
+  ps.getDiskAdaptor()->openFile();
+
+  WorkerPool noThreads(0);
+  auto piece = ps.getMissingPiece(1, 1);
+  piece->setAllBlock();
+  CPPUNIT_ASSERT(!ps.verifyPieceInWorker(
+      piece, &noThreads, [](const std::string& actualHash) {}));
+
+  WorkerPool workerPool(1);
+  std::string result;
+  CPPUNIT_ASSERT(ps.verifyPieceInWorker(
+      piece, &workerPool,
+      [&result](const std::string& actualHash) { result = actualHash; }));
+  CPPUNIT_ASSERT(piece->isVerifying());
+  // The piece is kept in use until it is verified.
+  ps.cancelPiece(piece, 1);
+  CPPUNIT_ASSERT(ps.isPieceUsed(1));
+  while (result.empty()) {
+    workerPool.processCompletions();
+  }
+  CPPUNIT_ASSERT(!piece->isVerifying());
+  CPPUNIT_ASSERT_EQUAL(hashes[1], result);
+
+  // Cancelled verification does not call the callback.
+  auto piece2 = ps.getMissingPiece(2, 1);
+  piece2->setAllBlock();
+  bool called = false;
+  CPPUNIT_ASSERT(ps.verifyPieceInWorker(
+      piece2, &workerPool,
+      [&called](const std::string& actualHash) { called = true; }));
+  ps.cancelPieceVerification();
+  CPPUNIT_ASSERT(!piece2->isVerifying());
+  CPPUNIT_ASSERT(!piece2->pieceComplete());
+  while (workerPool.countPending() > 0) {
+    workerPool.processCompletions();
+  }
+  CPPUNIT_ASSERT(!called);
+}
+
+#ifdef HAVE_STD_THREAD
+std::shared_ptr<Piece> DefaultPieceStorageTest::completePieceWithAsyncWrite(
+    DefaultPieceStorage& ps, DownloadEngine& e, WrDiskCache& cache)
+{
+  ps.setWrDiskCache(&cache);
+  ps.initStorage();
+  ps.getDiskAdaptor()->openFile();
+  auto piece = ps.getMissingPiece(1, 1);
+
+  WorkerBlocker blocker(e.getWorkerPool().get());
+  // The cache limit is smaller than the piece, so the data are
+  // evicted to DiskWriteQueue.
+  auto data = new unsigned char[100];
+  memset(data, 'a', 100);
+  piece->updateWrCache(&cache, data, 0, 100, 100);
+  CPPUNIT_ASSERT(piece->getWrDiskCacheEntry()->isAsyncWritePending());
+  piece->setAllBlock();
+  piece->flushWrCache(&cache);
+  ps.completePiece(piece);
+  ps.advertisePiece(1, 1, global::wallclock());
+
+  // The piece is kept in use until its data are written.
+  CPPUNIT_ASSERT(!ps.hasPiece(1));
+  CPPUNIT_ASSERT(ps.isPieceUsed(1));
+  ps.cancelPiece(piece, 1);
+  CPPUNIT_ASSERT(ps.isPieceUsed(1));
+  std::vector<size_t> indexes;
+  ps.getAdvertisedPieceIndexes(indexes, 2, 0);
+  CPPUNIT_ASSERT(indexes.empty());
+
+  blocker.release();
+  while (e.getWorkerPool()->countPending() > 0) {
+    e.getWorkerPool()->processCompletions();
+  }
+  return piece;
+}
+#endif // HAVE_STD_THREAD
+
+void DefaultPieceStorageTest::testCompletePiece_asyncWrite()
+{
+#ifdef HAVE_STD_THREAD
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setWorkerPool(make_unique<WorkerPool>(1));
+  WrDiskCache cache(50);
+  cache.setDiskWriteQueue(make_unique<DiskWriteQueue>(&e, 1024));
+  std::string path = A2_TEST_OUT_DIR "/aria2_DefaultPieceStorageTest_async";
+  File(path).remove();
+  auto dctx = std::make_shared<DownloadContext>(100, 250, path);
+  RequestGroup group(GroupId::create(), util::copy(option_));
+  dctx->setOwnerRequestGroup(&group);
+  DefaultPieceStorage ps(dctx, option_.get());
+
+  completePieceWithAsyncWrite(ps, e, cache);
+  CPPUNIT_ASSERT(ps.hasPiece(1));
+  CPPUNIT_ASSERT(!ps.isPieceUsed(1));
+  std::vector<size_t> indexes;
+  ps.getAdvertisedPieceIndexes(indexes, 2, 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, indexes.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, indexes[0]);
+  CPPUNIT_ASSERT(!group.isHaltRequested());
+  ps.getDiskAdaptor()->closeFile();
+  CPPUNIT_ASSERT_EQUAL(std::string(100, 'a'), readFile(path).substr(100, 100));
+#endif // HAVE_STD_THREAD
+}
+
+void DefaultPieceStorageTest::testCompletePiece_asyncWriteFailure()
+{
+#ifdef HAVE_STD_THREAD
+  if (!File("/dev/full").exists()) {
+    return;
+  }
+  DownloadEngine e(make_unique<SelectEventPoll>());
+  e.setWorkerPool(make_unique<WorkerPool>(1));
+  WrDiskCache cache(50);
+  cache.setDiskWriteQueue(make_unique<DiskWriteQueue>(&e, 1024));
+  // Writes to /dev/full fail with ENOSPC.
+  auto dctx = std::make_shared<DownloadContext>(100, 250, "/dev/full");
+  RequestGroup group(GroupId::create(), util::copy(option_));
+  dctx->setOwnerRequestGroup(&group);
+  DefaultPieceStorage ps(dctx, option_.get());
+
+  auto piece = completePieceWithAsyncWrite(ps, e, cache);
+  // The piece has to be downloaded again, and the download fails.
+  CPPUNIT_ASSERT(!ps.hasPiece(1));
+  CPPUNIT_ASSERT(!ps.isPieceUsed(1));
+  CPPUNIT_ASSERT(!piece->pieceComplete());
+  std::vector<size_t> indexes;
+  ps.getAdvertisedPieceIndexes(indexes, 2, 0);
+  CPPUNIT_ASSERT(indexes.empty());
+  CPPUNIT_ASSERT(group.isHaltRequested());
+  CPPUNIT_ASSERT_EQUAL(error_code::NOT_ENOUGH_DISK_SPACE,
+                       group.getLastErrorCode());
+  ps.getDiskAdaptor()->closeFile();
+#endif // HAVE_STD_THREAD
+}
+
 } // namespace aria2
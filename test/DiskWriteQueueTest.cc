@@ -0,0 +1,142 @@
+#include "DiskWriteQueue.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "TestUtil.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "WorkerPool.h"
+#include "DirectDiskAdaptor.h"
+#include "DefaultDiskWriter.h"
+#include "ByteArrayDiskWriter.h"
+#include "FileEntry.h"
+#include "File.h"
+
+namespace aria2 {
+
+class DiskWriteQueueTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DiskWriteQueueTest);
+  CPPUNIT_TEST(testPush);
+  CPPUNIT_TEST(testPush_notSupported);
+  CPPUNIT_TEST(testWriteToDisk_afterPush);
+  CPPUNIT_TEST(testClear_afterPush);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::unique_ptr<DownloadEngine> e_;
+  std::shared_ptr<DirectDiskAdaptor> adaptor_;
+  std::string path_;
+
+public:
+  void setUp()
+  {
+    e_ = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+    e_->setWorkerPool(make_unique<WorkerPool>(2));
+    path_ = A2_TEST_OUT_DIR "/aria2_DiskWriteQueueTest";
+    File(path_).remove();
+    auto entry = std::make_shared<FileEntry>(path_, 20, 0);
+    auto fileEntries = std::vector<std::shared_ptr<FileEntry>>{entry};
+    adaptor_ = std::make_shared<DirectDiskAdaptor>();
+    adaptor_->setDiskWriter(make_unique<DefaultDiskWriter>(path_));
+    adaptor_->setTotalLength(entry->getLength());
+    adaptor_->setFileEntries(fileEntries.begin(), fileEntries.end());
+    adaptor_->initAndOpenFile();
+  }
+
+  void tearDown() { adaptor_->closeFile(); }
+
+  void processCompletions()
+  {
+    while (e_->getWorkerPool()->countPending()) {
+      e_->getWorkerPool()->processCompletions();
+    }
+  }
+
+  void testPush();
+  void testPush_notSupported();
+  void testWriteToDisk_afterPush();
+  void testClear_afterPush();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DiskWriteQueueTest);
+
+void DiskWriteQueueTest::testPush()
+{
+  DiskWriteQueue queue(e_.get(), 10);
+  WrDiskCacheEntry ent(adaptor_);
+  ent.cacheData(createDataCell(0, "hello"));
+  ent.cacheData(createDataCell(10, "world"));
+  CPPUNIT_ASSERT(queue.push(&ent));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, ent.getSize());
+  CPPUNIT_ASSERT(ent.getDataSet().empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, queue.getSize());
+  CPPUNIT_ASSERT(queue.isFull());
+
+  // The data being written are still visible.
+  std::vector<const WrDiskCacheEntry::DataCell*> cells;
+  ent.getDataCells(cells);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cells.size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)10, cells[1]->goff);
+
+  processCompletions();
+  CPPUNIT_ASSERT(!ent.isAsyncWritePending());
+  ent.writeToDisk();
+  CPPUNIT_ASSERT_EQUAL((int)WrDiskCacheEntry::CACHE_ERR_SUCCESS,
+                       ent.getError());
+  ent.getDataCells(cells);
+  CPPUNIT_ASSERT(cells.empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, queue.getSize());
+  CPPUNIT_ASSERT(!queue.isFull());
+  CPPUNIT_ASSERT_EQUAL(std::string("hello"), readFile(path_).substr(0, 5));
+  CPPUNIT_ASSERT_EQUAL(std::string("world"), readFile(path_).substr(10, 5));
+}
+
+void DiskWriteQueueTest::testPush_notSupported()
+{
+  DiskWriteQueue queue(e_.get(), 10);
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  adaptor->setDiskWriter(make_unique<ByteArrayDiskWriter>());
+  WrDiskCacheEntry ent(adaptor);
+  ent.cacheData(createDataCell(0, "hello"));
+  CPPUNIT_ASSERT(!queue.push(&ent));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, ent.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, queue.getSize());
+  ent.clear();
+}
+
+void DiskWriteQueueTest::testWriteToDisk_afterPush()
+{
+  DiskWriteQueue queue(e_.get(), 1024);
+  WrDiskCacheEntry ent(adaptor_);
+  ent.cacheData(createDataCell(0, "hello"));
+  CPPUNIT_ASSERT(queue.push(&ent));
+  ent.cacheData(createDataCell(5, " world"));
+  ent.cacheData(createDataCell(0, "HELLO"));
+  // writeToDisk() queues the data after the asynchronous write if it
+  // is still in progress.
+  ent.writeToDisk(&queue);
+  CPPUNIT_ASSERT(ent.getDataSet().empty());
+  processCompletions();
+  CPPUNIT_ASSERT_EQUAL(std::string("HELLO world"),
+                       readFile(path_).substr(0, 11));
+}
+
+void DiskWriteQueueTest::testClear_afterPush()
+{
+  DiskWriteQueue queue(e_.get(), 1024);
+  WrDiskCacheEntry ent(adaptor_);
+  ent.cacheData(createDataCell(0, "hello"));
+  CPPUNIT_ASSERT(queue.push(&ent));
+  ent.clear();
+  // The discarded data are not visible, and the data cached later are
+  // written after them.
+  std::vector<const WrDiskCacheEntry::DataCell*> cells;
+  ent.getDataCells(cells);
+  CPPUNIT_ASSERT(cells.empty());
+  ent.cacheData(createDataCell(0, "HELLO"));
+  CPPUNIT_ASSERT(queue.push(&ent));
+  processCompletions();
+  CPPUNIT_ASSERT_EQUAL(std::string("HELLO"), readFile(path_).substr(0, 5));
+}
+
+} // namespace aria2
@@ -0,0 +1,188 @@
+#include "DownloadEngine.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SelectEventPoll.h"
+#include "Command.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+class DownloadEngineTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DownloadEngineTest);
+  CPPUNIT_TEST(testWakeupTime);
+  CPPUNIT_TEST(testWakeupCommands);
+  CPPUNIT_TEST(testReadyCommands);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::unique_ptr<DownloadEngine> e_;
+
+public:
+  void setUp()
+  {
+    e_ = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+  }
+
+  // Runs one iteration without waiting for an event.
+  void runOnce()
+  {
+    e_->setNoWait(true);
+    e_->run(true);
+  }
+
+  void testWakeupTime();
+  void testWakeupCommands();
+  void testReadyCommands();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DownloadEngineTest);
+
+namespace {
+class CountCommand : public Command {
+public:
+  CountCommand(cuid_t cuid, DownloadEngine* e, int* count, bool sleep,
+               a2_gid_t gid = 0)
+      : Command(cuid), e_(e), count_(count), sleep_(sleep), gid_(gid)
+  {
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    ++*count_;
+    auto t = global::wallclock();
+    t.advance(std::chrono::hours(1));
+    if (sleep_) {
+      e_->addTimerCommand(std::unique_ptr<Command>(this), t, gid_);
+    }
+    else {
+      setWakeupTime(t);
+      e_->addCommand(std::unique_ptr<Command>(this));
+    }
+    return false;
+  }
+
+private:
+  DownloadEngine* e_;
+  int* count_;
+  bool sleep_;
+  a2_gid_t gid_;
+};
+
+class WaitCommand : public Command {
+public:
+  WaitCommand(cuid_t cuid, DownloadEngine* e, int* count)
+      : Command(cuid), e_(e), count_(count)
+  {
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    ++*count_;
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+
+private:
+  DownloadEngine* e_;
+  int* count_;
+};
+} // namespace
+
+void DownloadEngineTest::testWakeupTime()
+{
+  int count = 0;
+  e_->addCommand(make_unique<CountCommand>(1, e_.get(), &count, false));
+  // New command is executed at once.
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(1, count);
+  // Not executed until its wake up time.
+  runOnce();
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(1, count);
+
+  e_->setRefreshInterval(std::chrono::milliseconds(0));
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(2, count);
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(2, count);
+}
+
+void DownloadEngineTest::testWakeupCommands()
+{
+  int count1 = 0, count2 = 0, count3 = 0;
+  auto deadline = global::wallclock();
+  deadline.advance(std::chrono::hours(1));
+  e_->addTimerCommand(make_unique<CountCommand>(1, e_.get(), &count1, true, 1),
+                      deadline, 1);
+  e_->addTimerCommand(make_unique<CountCommand>(2, e_.get(), &count2, true, 2),
+                      deadline, 2);
+  e_->addTimerCommand(make_unique<CountCommand>(3, e_.get(), &count3, true),
+                      deadline);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, e_->countTimerCommand());
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(0, count1 + count2 + count3);
+
+  e_->wakeupCommands(1);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, e_->countTimerCommand());
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(1, count1);
+  CPPUNIT_ASSERT_EQUAL(0, count2);
+  CPPUNIT_ASSERT_EQUAL(0, count3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, e_->countTimerCommand());
+
+  // Refresh does not wake up sleeping commands.
+  e_->setRefreshInterval(std::chrono::milliseconds(0));
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(1, count1);
+  CPPUNIT_ASSERT_EQUAL(0, count2);
+  CPPUNIT_ASSERT_EQUAL(0, count3);
+
+  e_->wakeupCommands(1);
+  e_->wakeupCommands(1);
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(2, count1);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, e_->countTimerCommand());
+}
+
+void DownloadEngineTest::testReadyCommands()
+{
+  int count = 0;
+  auto command = make_unique<WaitCommand>(1, e_.get(), &count);
+  auto c = command.get();
+  e_->addCommand(std::move(command));
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(1, count);
+  // Without wake up time, only an event or a status change wakes the
+  // command up.
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(1, count);
+
+  c->readEventReceived();
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(2, count);
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(2, count);
+
+  c->setStatusActive();
+  c->setStatusActive();
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(3, count);
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(3, count);
+
+  auto t = global::wallclock();
+  t.advance(std::chrono::hours(1));
+  c->setWakeupTime(t);
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(3, count);
+  // The earlier wake up time replaces the later one.
+  c->setWakeupTime(Timer::zero());
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(4, count);
+  runOnce();
+  CPPUNIT_ASSERT_EQUAL(4, count);
+}
+
+} // namespace aria2
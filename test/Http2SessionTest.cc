@@ -0,0 +1,347 @@
+#include "Http2Session.h"
+
+#include <cstring>
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "Command.h"
+#include "a2functional.h"
+#include "fmt.h"
+#include "util.h"
+
+namespace aria2 {
+
+namespace {
+// Minimal HTTP/2 server which answers every request with 206 Partial
+// Content carrying |body|.
+class MockHttp2Server {
+public:
+  MockHttp2Server(const std::shared_ptr<SocketCore>& socket,
+                  const std::string& body)
+      : socket_(socket),
+        body_(body),
+        bodyOffset_(0),
+        session_(nullptr),
+        lastErrorCode_(NGHTTP2_NO_ERROR),
+        streamClosed_(false)
+  {
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_send_callback(callbacks, sendCallback);
+    nghttp2_session_callbacks_set_recv_callback(callbacks, recvCallback);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+                                                         onFrameRecvCallback);
+    nghttp2_session_callbacks_set_on_stream_close_callback(
+        callbacks, onStreamCloseCallback);
+    nghttp2_session_server_new(&session_, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, nullptr, 0);
+  }
+
+  ~MockHttp2Server() { nghttp2_session_del(session_); }
+
+  void performIO()
+  {
+    nghttp2_session_recv(session_);
+    nghttp2_session_send(session_);
+  }
+
+  nghttp2_session* getSession() const { return session_; }
+
+  uint32_t getLastErrorCode() const { return lastErrorCode_; }
+
+  bool streamClosed() const { return streamClosed_; }
+
+private:
+  static ssize_t sendCallback(nghttp2_session* session, const uint8_t* data,
+                              size_t length, int flags, void* userData)
+  {
+    auto server = static_cast<MockHttp2Server*>(userData);
+    ssize_t r = server->socket_->writeData(data, length);
+    if (r == 0) {
+      return NGHTTP2_ERR_WOULDBLOCK;
+    }
+    return r;
+  }
+
+  static ssize_t recvCallback(nghttp2_session* session, uint8_t* buf,
+                              size_t length, int flags, void* userData)
+  {
+    auto server = static_cast<MockHttp2Server*>(userData);
+    server->socket_->readData(buf, length);
+    if (length == 0) {
+      return NGHTTP2_ERR_WOULDBLOCK;
+    }
+    return length;
+  }
+
+  static ssize_t readBodyCallback(nghttp2_session* session, int32_t streamId,
+                                  uint8_t* buf, size_t length,
+                                  uint32_t* dataFlags,
+                                  nghttp2_data_source* source, void* userData)
+  {
+    auto server = static_cast<MockHttp2Server*>(userData);
+    size_t n = std::min(length, server->body_.size() - server->bodyOffset_);
+    memcpy(buf, server->body_.data() + server->bodyOffset_, n);
+    server->bodyOffset_ += n;
+    if (server->bodyOffset_ == server->body_.size()) {
+      *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return n;
+  }
+
+  static int onFrameRecvCallback(nghttp2_session* session,
+                                 const nghttp2_frame* frame, void* userData)
+  {
+    auto server = static_cast<MockHttp2Server*>(userData);
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+        frame->headers.cat != NGHTTP2_HCAT_REQUEST) {
+      return 0;
+    }
+    server->contentRange_ =
+        fmt("bytes 0-%d/%d", static_cast<int>(server->body_.size()) - 1,
+            static_cast<int>(server->body_.size()));
+    server->contentLength_ = util::itos(server->body_.size());
+    nghttp2_nv nva[] = {
+        {(uint8_t*)":status", (uint8_t*)"206", 7, 3, NGHTTP2_NV_FLAG_NONE},
+        {(uint8_t*)"content-range", (uint8_t*)server->contentRange_.c_str(),
+         13, server->contentRange_.size(), NGHTTP2_NV_FLAG_NONE},
+        {(uint8_t*)"content-length", (uint8_t*)server->contentLength_.c_str(),
+         14, server->contentLength_.size(), NGHTTP2_NV_FLAG_NONE}};
+    nghttp2_data_provider prd;
+    prd.read_callback = readBodyCallback;
+    nghttp2_submit_response(session, frame->hd.stream_id, nva,
+                            sizeof(nva) / sizeof(nva[0]), &prd);
+    return 0;
+  }
+
+  static int onStreamCloseCallback(nghttp2_session* session, int32_t streamId,
+                                   uint32_t errorCode, void* userData)
+  {
+    auto server = static_cast<MockHttp2Server*>(userData);
+    server->streamClosed_ = true;
+    server->lastErrorCode_ = errorCode;
+    return 0;
+  }
+
+  std::shared_ptr<SocketCore> socket_;
+  std::string body_;
+  size_t bodyOffset_;
+  std::string contentRange_;
+  std::string contentLength_;
+  nghttp2_session* session_;
+  uint32_t lastErrorCode_;
+  bool streamClosed_;
+};
+} // namespace
+
+namespace {
+class MockCommand : public Command {
+public:
+  MockCommand() : Command(1) {}
+
+  virtual bool execute() CXX11_OVERRIDE { return false; }
+
+  bool isWokenUp() const { return statusMatch(STATUS_ONESHOT_REALTIME); }
+};
+} // namespace
+
+class Http2SessionTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(Http2SessionTest);
+  CPPUNIT_TEST(testSubmitRequest);
+  CPPUNIT_TEST(testFlowControlWindow);
+  CPPUNIT_TEST(testCloseStream);
+  CPPUNIT_TEST(testGoaway);
+  CPPUNIT_TEST(testEof);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<SocketCore> client_;
+  std::shared_ptr<SocketCore> inbound_;
+  std::unique_ptr<DownloadEngine> e_;
+  uint16_t port_;
+
+public:
+  void setUp()
+  {
+    SocketCore server;
+    server.bind(0);
+    server.beginListen();
+    server.setBlockingMode();
+    port_ = server.getAddrInfo().port;
+    client_ = std::make_shared<SocketCore>();
+    client_->establishConnection("localhost", port_);
+    while (!client_->isWritable(0)) {
+    }
+    inbound_ = server.acceptConnection();
+    inbound_->setNonBlockingMode();
+    e_ = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+  }
+
+  std::unique_ptr<Http2Session> createSession()
+  {
+    auto session = make_unique<Http2Session>(client_, "localhost",
+                                             "127.0.0.1", port_, false,
+                                             e_.get());
+    session->onConnected();
+    return session;
+  }
+
+  std::vector<std::pair<std::string, std::string>> createRequest()
+  {
+    return {{":method", "GET"},
+            {":scheme", "http"},
+            {":authority", "localhost"},
+            {":path", "/file"},
+            {"range", "bytes=0-"}};
+  }
+
+  // Exchanges frames until the stream |streamId| is closed or the
+  // session fails.
+  void pump(Http2Session& session, MockHttp2Server& server, int32_t streamId)
+  {
+    for (int i = 0; i < 10000; ++i) {
+      session.performIO();
+      server.performIO();
+      if (session.getState() != Http2Session::CONNECTED) {
+        return;
+      }
+      auto stream = session.findStream(streamId);
+      if (!stream || stream->closed) {
+        return;
+      }
+    }
+  }
+
+  void testSubmitRequest();
+  void testFlowControlWindow();
+  void testCloseStream();
+  void testGoaway();
+  void testEof();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Http2SessionTest);
+
+void Http2SessionTest::testSubmitRequest()
+{
+  MockHttp2Server server(inbound_, "0123456789");
+  auto session = createSession();
+  CPPUNIT_ASSERT_EQUAL(Http2Session::CONNECTED, session->getState());
+  CPPUNIT_ASSERT(session->canSubmitRequest());
+  MockCommand command;
+  auto streamId = session->submitRequest(createRequest(), &command);
+  CPPUNIT_ASSERT_EQUAL((int32_t)1, streamId);
+  pump(*session, server, streamId);
+
+  CPPUNIT_ASSERT(command.isWokenUp());
+  auto stream = session->findStream(streamId);
+  CPPUNIT_ASSERT(stream);
+  CPPUNIT_ASSERT(stream->headerReceived);
+  CPPUNIT_ASSERT(stream->closed);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)NGHTTP2_NO_ERROR, stream->errorCode);
+  CPPUNIT_ASSERT_EQUAL(206, stream->header.getStatusCode());
+  auto range = stream->header.getRange();
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, range.startByte);
+  CPPUNIT_ASSERT_EQUAL((int64_t)9, range.endByte);
+  CPPUNIT_ASSERT_EQUAL((int64_t)10, range.entityLength);
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789"),
+                       std::string(stream->getData(),
+                                   stream->getData() +
+                                       stream->getDataLength()));
+
+  session->consume(streamId, 4);
+  CPPUNIT_ASSERT_EQUAL((size_t)6, stream->getDataLength());
+  CPPUNIT_ASSERT(memcmp("456789", stream->getData(), 6) == 0);
+  session->consume(streamId, 6);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, stream->getDataLength());
+
+  session->closeStream(streamId);
+  CPPUNIT_ASSERT(!session->findStream(streamId));
+}
+
+void Http2SessionTest::testFlowControlWindow()
+{
+  // Much larger than the default window size 65535.  The server must
+  // be able to send all of it before we consume anything.
+  std::string body(1_m, 'a');
+  MockHttp2Server server(inbound_, body);
+  auto session = createSession();
+  MockCommand command;
+  auto streamId = session->submitRequest(createRequest(), &command);
+  pump(*session, server, streamId);
+
+  CPPUNIT_ASSERT_EQUAL(
+      (uint32_t)Http2Session::STREAM_WINDOW_SIZE,
+      nghttp2_session_get_remote_settings(
+          server.getSession(), NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
+  auto stream = session->findStream(streamId);
+  CPPUNIT_ASSERT(stream->closed);
+  CPPUNIT_ASSERT_EQUAL(body.size(), stream->getDataLength());
+  CPPUNIT_ASSERT_EQUAL(
+      Http2Session::CONNECTION_WINDOW_SIZE - (int32_t)body.size(),
+      nghttp2_session_get_remote_window_size(server.getSession()));
+}
+
+void Http2SessionTest::testCloseStream()
+{
+  std::string body(1_m, 'a');
+  MockHttp2Server server(inbound_, body);
+  auto session = createSession();
+  MockCommand command;
+  auto streamId = session->submitRequest(createRequest(), &command);
+  for (int i = 0; i < 10000; ++i) {
+    session->performIO();
+    server.performIO();
+    if (session->findStream(streamId)->headerReceived) {
+      break;
+    }
+  }
+  session->closeStream(streamId);
+  CPPUNIT_ASSERT(!session->findStream(streamId));
+  for (int i = 0; i < 10000 && !server.streamClosed(); ++i) {
+    session->send();
+    server.performIO();
+  }
+  CPPUNIT_ASSERT(server.streamClosed());
+  CPPUNIT_ASSERT_EQUAL((uint32_t)NGHTTP2_CANCEL, server.getLastErrorCode());
+  CPPUNIT_ASSERT_EQUAL(Http2Session::CONNECTED, session->getState());
+}
+
+void Http2SessionTest::testGoaway()
+{
+  MockHttp2Server server(inbound_, "0123456789");
+  auto session = createSession();
+  MockCommand command;
+  session->addCommand(&command);
+  nghttp2_submit_goaway(server.getSession(), NGHTTP2_FLAG_NONE, 0,
+                        NGHTTP2_NO_ERROR, nullptr, 0);
+  for (int i = 0; i < 10000 && session->canSubmitRequest(); ++i) {
+    server.performIO();
+    session->performIO();
+  }
+  CPPUNIT_ASSERT(!session->canSubmitRequest());
+  session->removeCommand(&command);
+  CPPUNIT_ASSERT(session->isIdle());
+}
+
+void Http2SessionTest::testEof()
+{
+  auto session = createSession();
+  MockCommand command;
+  session->addCommand(&command);
+  inbound_->closeConnection();
+  for (int i = 0;
+       i < 10000 && session->getState() == Http2Session::CONNECTED; ++i) {
+    session->performIO();
+  }
+  CPPUNIT_ASSERT_EQUAL(Http2Session::FAILED, session->getState());
+  CPPUNIT_ASSERT(command.isWokenUp());
+  CPPUNIT_ASSERT(!session->canSubmitRequest());
+  session->removeCommand(&command);
+}
+
+} // namespace aria2
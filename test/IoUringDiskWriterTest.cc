@@ -0,0 +1,177 @@
+#include "IoUringDiskWriter.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "File.h"
+#include "DiskIoUring.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class IoUringDiskWriterTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(IoUringDiskWriterTest);
+  CPPUNIT_TEST(testQueueWrite);
+  CPPUNIT_TEST(testReadData);
+  CPPUNIT_TEST(testEnableMmap);
+  CPPUNIT_TEST(testSharedRing);
+  CPPUNIT_TEST(testQueueWrite_manyRequests);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::string path_;
+
+public:
+  void setUp()
+  {
+    path_ = A2_TEST_OUT_DIR "/aria2_IoUringDiskWriterTest";
+    File(path_).remove();
+  }
+
+  void tearDown()
+  {
+    File(path_).remove();
+    File(path_ + ".2").remove();
+  }
+
+  void testQueueWrite();
+  void testReadData();
+  void testEnableMmap();
+  void testSharedRing();
+  void testQueueWrite_manyRequests();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IoUringDiskWriterTest);
+
+void IoUringDiskWriterTest::testQueueWrite()
+{
+  IoUringDiskWriter dw(path_);
+  dw.initAndOpenFile();
+  if (!dw.isIoUringActive()) {
+    std::cerr << "io_uring is not available. Skipping test." << std::endl;
+    return;
+  }
+  // 12 blocks of 16KiB, which is more than the number of fixed
+  // buffers, and one 40KiB block, which does not fit in a fixed
+  // buffer.
+  std::vector<unsigned char> data(12 * 16_k + 40_k);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i * 7 + (i >> 14);
+  }
+  auto numEnterCalls = dw.getNumEnterCalls();
+  // Write blocks in reverse order to make sure that offsets are
+  // respected.
+  dw.queueWrite(data.data() + 12 * 16_k, 40_k, 12 * 16_k);
+  for (size_t i = 12; i > 0; --i) {
+    dw.queueWrite(data.data() + (i - 1) * 16_k, 16_k, (i - 1) * 16_k);
+  }
+  dw.flushWrites();
+  CPPUNIT_ASSERT_EQUAL(numEnterCalls + 1, dw.getNumEnterCalls());
+  // Nothing to flush
+  dw.flushWrites();
+  CPPUNIT_ASSERT_EQUAL(numEnterCalls + 1, dw.getNumEnterCalls());
+  dw.closeFile();
+
+  CPPUNIT_ASSERT_EQUAL((int64_t)data.size(), File(path_).size());
+  DefaultDiskWriter ddw(path_);
+  ddw.openExistingFile();
+  std::vector<unsigned char> buf(data.size());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)buf.size(),
+                       ddw.readData(buf.data(), buf.size(), 0));
+  CPPUNIT_ASSERT(data == buf);
+}
+
+void IoUringDiskWriterTest::testReadData()
+{
+  IoUringDiskWriter dw(path_);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello world"), 11, 0);
+  // Queued write must be visible to the following read.
+  dw.queueWrite(reinterpret_cast<const unsigned char*>("W"), 1, 6);
+
+  unsigned char buf[32];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)11, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("hello World"),
+                       std::string(&buf[0], &buf[11]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, dw.readData(buf, 5, 6));
+  CPPUNIT_ASSERT_EQUAL(std::string("World"), std::string(&buf[0], &buf[5]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, dw.readData(buf, sizeof(buf), 11));
+}
+
+void IoUringDiskWriterTest::testEnableMmap()
+{
+  IoUringDiskWriter dw(path_);
+  dw.enableMmap();
+  dw.initAndOpenFile();
+  CPPUNIT_ASSERT(!dw.isIoUringActive());
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello"), 5, 0);
+  unsigned char buf[5];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("hello"), std::string(&buf[0], &buf[5]));
+}
+
+void IoUringDiskWriterTest::testSharedRing()
+{
+  auto uring = std::make_shared<DiskIoUring>();
+  if (!uring->good()) {
+    std::cerr << "io_uring is not available. Skipping test." << std::endl;
+    return;
+  }
+  IoUringDiskWriter dw1(path_, uring);
+  IoUringDiskWriter dw2(path_ + ".2", uring);
+  dw1.initAndOpenFile();
+  dw2.initAndOpenFile();
+  CPPUNIT_ASSERT(dw1.isIoUringActive());
+  CPPUNIT_ASSERT(dw2.isIoUringActive());
+  auto numEnterCalls = uring->getNumEnterCalls();
+  dw1.queueWrite(reinterpret_cast<const unsigned char*>("hello"), 5, 0);
+  // Contiguous writes are merged.
+  dw1.queueWrite(reinterpret_cast<const unsigned char*>(" world"), 6, 5);
+  dw1.flushWrites();
+  dw2.writeData(reinterpret_cast<const unsigned char*>("foo"), 3, 0);
+  CPPUNIT_ASSERT_EQUAL(numEnterCalls + 2, uring->getNumEnterCalls());
+  CPPUNIT_ASSERT_EQUAL(numEnterCalls + 2, dw1.getNumEnterCalls());
+
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)11, dw1.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world"),
+                       std::string(&buf[0], &buf[11]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)3, dw2.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("foo"), std::string(&buf[0], &buf[3]));
+  // The writer still works after the other one closed its file.
+  dw2.closeFile();
+  dw1.writeData(reinterpret_cast<const unsigned char*>("W"), 1, 6);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)11, dw1.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("hello World"),
+                       std::string(&buf[0], &buf[11]));
+}
+
+void IoUringDiskWriterTest::testQueueWrite_manyRequests()
+{
+  IoUringDiskWriter dw(path_);
+  dw.initAndOpenFile();
+  if (!dw.isIoUringActive()) {
+    std::cerr << "io_uring is not available. Skipping test." << std::endl;
+    return;
+  }
+  // More requests than the submission queue can hold.  Every other
+  // byte is written, so that no request is merged.
+  const size_t n = DiskIoUring::ENTRIES * 3;
+  std::vector<unsigned char> data(n * 2, '.');
+  for (size_t i = 0; i < n; ++i) {
+    data[i * 2] = 'a' + i % 26;
+    dw.queueWrite(&data[i * 2], 1, i * 2);
+  }
+  dw.flushWrites();
+  for (size_t i = 0; i < n; ++i) {
+    dw.queueWrite(&data[i * 2 + 1], 1, i * 2 + 1);
+  }
+  dw.flushWrites();
+  std::vector<unsigned char> buf(data.size());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)buf.size(),
+                       dw.readData(buf.data(), buf.size(), 0));
+  CPPUNIT_ASSERT(data == buf);
+}
+
+} // namespace aria2
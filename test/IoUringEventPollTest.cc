@@ -0,0 +1,189 @@
+#include "IoUringEventPoll.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+#include "SocketCore.h"
+#include "a2functional.h"
+#ifdef HAVE_EPOLL
+#  include "EpollEventPoll.h"
+#endif // HAVE_EPOLL
+
+namespace aria2 {
+
+class IoUringEventPollTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(IoUringEventPollTest);
+  CPPUNIT_TEST(testPoll_levelTriggered);
+  CPPUNIT_TEST(testPoll_batchUpdates);
+  CPPUNIT_TEST(testDeleteEvents);
+#ifdef HAVE_EPOLL
+  CPPUNIT_TEST(testNumSyscalls_epoll);
+#endif // HAVE_EPOLL
+  CPPUNIT_TEST_SUITE_END();
+
+  std::unique_ptr<SocketCore> server_;
+  std::unique_ptr<SocketCore> client_;
+  std::shared_ptr<SocketCore> inbound_;
+
+public:
+  void setUp()
+  {
+    server_ = make_unique<SocketCore>();
+    server_->bind(0);
+    server_->beginListen();
+    server_->setBlockingMode();
+    auto endpoint = server_->getAddrInfo();
+    client_ = make_unique<SocketCore>();
+    client_->establishConnection("localhost", endpoint.port);
+    while (!client_->isWritable(0)) {
+    }
+    inbound_ = server_->acceptConnection();
+  }
+
+  void testPoll_levelTriggered();
+  void testPoll_batchUpdates();
+  void testDeleteEvents();
+#ifdef HAVE_EPOLL
+  void testNumSyscalls_epoll();
+#endif // HAVE_EPOLL
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IoUringEventPollTest);
+
+namespace {
+class MockCommand : public Command {
+public:
+  MockCommand() : Command(1) {}
+
+  virtual bool execute() CXX11_OVERRIDE { return false; }
+
+  bool readEvent() const { return readEventEnabled(); }
+
+  bool writeEvent() const { return writeEventEnabled(); }
+};
+} // namespace
+
+namespace {
+struct timeval makeTimeval(int msec)
+{
+  struct timeval tv;
+  tv.tv_sec = msec / 1000;
+  tv.tv_usec = (msec % 1000) * 1000;
+  return tv;
+}
+} // namespace
+
+namespace {
+// Typical per-iteration pattern of a download: Commands toggle read and
+// write interest several times, and then the engine waits for events.
+// Returns the number of system calls made by poll.
+template <typename Poll>
+uint64_t runWorkload(Poll& poll, sock_t fd, Command* command)
+{
+  auto before = poll.getNumSyscalls();
+  for (int i = 0; i < 10; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      poll.addEvents(fd, command, EventPoll::EVENT_READ);
+      poll.addEvents(fd, command, EventPoll::EVENT_WRITE);
+      poll.deleteEvents(fd, command, EventPoll::EVENT_READ);
+    }
+    poll.poll(makeTimeval(1000));
+  }
+  poll.deleteEvents(fd, command, EventPoll::EVENT_WRITE);
+  return poll.getNumSyscalls() - before;
+}
+} // namespace
+
+void IoUringEventPollTest::testPoll_levelTriggered()
+{
+  IoUringEventPoll poll;
+  if (!poll.good()) {
+    // io_uring is disabled in this kernel.
+    return;
+  }
+  MockCommand command;
+  CPPUNIT_ASSERT(poll.addEvents(inbound_->getSockfd(), &command,
+                                EventPoll::EVENT_READ));
+  poll.poll(makeTimeval(0));
+  CPPUNIT_ASSERT(!command.readEvent());
+
+  client_->writeData("hello");
+  poll.poll(makeTimeval(1000));
+  CPPUNIT_ASSERT(command.readEvent());
+
+  // We did not read data, so the event must be reported again.
+  command.clearIOEvents();
+  poll.poll(makeTimeval(1000));
+  CPPUNIT_ASSERT(command.readEvent());
+
+  char buf[16];
+  size_t len = sizeof(buf);
+  inbound_->readData(buf, len);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, len);
+  command.clearIOEvents();
+  poll.poll(makeTimeval(0));
+  CPPUNIT_ASSERT(!command.readEvent());
+}
+
+void IoUringEventPollTest::testPoll_batchUpdates()
+{
+  IoUringEventPoll poll;
+  if (!poll.good()) {
+    return;
+  }
+  MockCommand command;
+  auto fd = inbound_->getSockfd();
+  auto before = poll.getNumSyscalls();
+  // EpollEventPoll issues epoll_ctl(2) for each of these calls.
+  for (int i = 0; i < 100; ++i) {
+    poll.addEvents(fd, &command, EventPoll::EVENT_READ);
+    poll.addEvents(fd, &command, EventPoll::EVENT_WRITE);
+    poll.deleteEvents(fd, &command, EventPoll::EVENT_READ);
+  }
+  CPPUNIT_ASSERT_EQUAL(before, poll.getNumSyscalls());
+  poll.poll(makeTimeval(1000));
+  CPPUNIT_ASSERT_EQUAL(before + 1, poll.getNumSyscalls());
+  CPPUNIT_ASSERT(command.writeEvent());
+  CPPUNIT_ASSERT(!command.readEvent());
+}
+
+void IoUringEventPollTest::testDeleteEvents()
+{
+  IoUringEventPoll poll;
+  if (!poll.good()) {
+    return;
+  }
+  MockCommand command;
+  auto fd = inbound_->getSockfd();
+  CPPUNIT_ASSERT(!poll.deleteEvents(fd, &command, EventPoll::EVENT_READ));
+  poll.addEvents(fd, &command, EventPoll::EVENT_READ);
+  poll.poll(makeTimeval(0));
+  CPPUNIT_ASSERT(poll.deleteEvents(fd, &command, EventPoll::EVENT_READ));
+  client_->writeData("hello");
+  poll.poll(makeTimeval(100));
+  CPPUNIT_ASSERT(!command.readEvent());
+}
+
+#ifdef HAVE_EPOLL
+void IoUringEventPollTest::testNumSyscalls_epoll()
+{
+  IoUringEventPoll uringPoll;
+  if (!uringPoll.good()) {
+    return;
+  }
+  EpollEventPoll epollPoll;
+  CPPUNIT_ASSERT(epollPoll.good());
+  MockCommand command;
+  auto fd = inbound_->getSockfd();
+  // 300 epoll_ctl(2), 10 epoll_wait(2) and the final EPOLL_CTL_DEL.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)311,
+                       runWorkload(epollPoll, fd, &command));
+  command.clearIOEvents();
+  // One io_uring_enter(2) per poll().  The final cancellation is
+  // queued for the next one.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)10, runWorkload(uringPoll, fd, &command));
+}
+#endif // HAVE_EPOLL
+
+} // namespace aria2
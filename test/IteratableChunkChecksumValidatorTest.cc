@@ -1,5 +1,7 @@
 #include "IteratableChunkChecksumValidator.h"
 
+#include <fstream>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "TestUtil.h"
@@ -9,6 +11,10 @@
 #include "DiskAdaptor.h"
 #include "FileEntry.h"
 #include "PieceSelector.h"
+#include "WorkerPool.h"
+#include "File.h"
+#include "MessageDigest.h"
+#include "MessageDigestBatch.h"
 
 namespace aria2 {
 
@@ -17,6 +23,9 @@ class IteratableChunkChecksumValidatorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChunkChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_readError);
+  CPPUNIT_TEST(testValidate_workerPool);
+  CPPUNIT_TEST(testValidate_batch);
+  CPPUNIT_TEST(testDeleteWithPendingJobs);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -27,6 +36,9 @@ public:
 
   void testValidate();
   void testValidate_readError();
+  void testValidate_workerPool();
+  void testValidate_batch();
+  void testDeleteWithPendingJobs();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IteratableChunkChecksumValidatorTest);
@@ -106,4 +118,147 @@ void IteratableChunkChecksumValidatorTest::testValidate_readError()
   CPPUNIT_ASSERT(!ps->hasPiece(4));
 }
 
+void IteratableChunkChecksumValidatorTest::testValidate_workerPool()
+{
+  Option option;
+  std::shared_ptr<DownloadContext> dctx(new DownloadContext(
+      100, 500, A2_TEST_DIR "/chunkChecksumTestFile250.txt"));
+  std::deque<std::string> hashes(&csArray[0], &csArray[3]);
+  hashes[1] = fromHex("ffffffffffffffffffffffffffffffffffffffff");
+  hashes.push_back(fromHex("ffffffffffffffffffffffffffffffffffffffff"));
+  hashes.push_back(fromHex("ffffffffffffffffffffffffffffffffffffffff"));
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+  std::shared_ptr<DefaultPieceStorage> ps(
+      new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+
+  WorkerPool workerPool(2);
+  int numWakeups = 0;
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.setWorkerPool(&workerPool, [&numWakeups]() { ++numWakeups; });
+  validator.init();
+
+  while (!validator.finished()) {
+    validator.validateChunk();
+    workerPool.processCompletions();
+  }
+  CPPUNIT_ASSERT(!validator.hasPendingJobs());
+  CPPUNIT_ASSERT(numWakeups > 0);
+
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(!ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+  CPPUNIT_ASSERT(!ps->hasPiece(3));
+  CPPUNIT_ASSERT(!ps->hasPiece(4));
+
+  hashes[1] = csArray[1];
+  hashes[2] = csArray[2];
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+  validator.init();
+  while (!validator.finished()) {
+    validator.validateChunk();
+    workerPool.processCompletions();
+  }
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(ps->hasPiece(1));
+  // Only 50 bytes of piece #2 are in the file.
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+}
+
+void IteratableChunkChecksumValidatorTest::testValidate_batch()
+{
+  // Enough pieces for 2 full batches, whatever the number of lanes is.
+  size_t lanes = MessageDigestBatch::getLanes("sha-1");
+  size_t numPieces = lanes * 2 + 3;
+  std::string data;
+  for (size_t i = 0; i < numPieces * 100 - 40; ++i) {
+    data += static_cast<char>(i * 31 + i / 100);
+  }
+  std::string path = A2_TEST_OUT_DIR
+      "/aria2_IteratableChunkChecksumValidatorTest_testValidate_batch";
+  {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out << data;
+  }
+  std::vector<std::string> hashes;
+  for (size_t i = 0; i < data.size(); i += 100) {
+    auto ctx = MessageDigest::sha1();
+    ctx->update(data.data() + i, std::min(static_cast<size_t>(100),
+                                          data.size() - i));
+    hashes.push_back(ctx->digest());
+  }
+  hashes[1] = fromHex("ffffffffffffffffffffffffffffffffffffffff");
+  hashes[lanes + 2] = fromHex("ffffffffffffffffffffffffffffffffffffffff");
+
+  Option option;
+  std::shared_ptr<DownloadContext> dctx(
+      new DownloadContext(100, data.size(), path));
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+  std::shared_ptr<DefaultPieceStorage> ps(
+      new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+
+  WorkerPool workerPool(1);
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.setWorkerPool(&workerPool, []() {});
+  validator.init();
+  while (!validator.finished()) {
+    validator.validateChunk();
+    workerPool.processCompletions();
+  }
+  for (size_t i = 0; i < numPieces; ++i) {
+    CPPUNIT_ASSERT_EQUAL(i != 1 && i != lanes + 2, ps->hasPiece(i));
+  }
+
+  // The second batch cannot be read completely.
+  File(path).remove();
+  {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out << data.substr(0, (lanes + 4) * 100 + 50);
+  }
+  ps->getDiskAdaptor()->closeFile();
+  ps->getDiskAdaptor()->openFile();
+  validator.init();
+  while (!validator.finished()) {
+    validator.validateChunk();
+    workerPool.processCompletions();
+  }
+  for (size_t i = 0; i < numPieces; ++i) {
+    CPPUNIT_ASSERT_EQUAL(i != 1 && i != lanes + 2 && i < lanes + 4,
+                         ps->hasPiece(i));
+  }
+}
+
+void IteratableChunkChecksumValidatorTest::testDeleteWithPendingJobs()
+{
+  Option option;
+  std::shared_ptr<DownloadContext> dctx(new DownloadContext(
+      100, 250, A2_TEST_DIR "/chunkChecksumTestFile250.txt"));
+  dctx->setPieceHashes("sha-1", &csArray[0], &csArray[3]);
+  std::shared_ptr<DefaultPieceStorage> ps(
+      new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+
+  WorkerPool workerPool(2);
+  int numWakeups = 0;
+  {
+    IteratableChunkChecksumValidator validator(dctx, ps);
+    validator.setWorkerPool(&workerPool, [&numWakeups]() { ++numWakeups; });
+    validator.init();
+    validator.validateChunk();
+    CPPUNIT_ASSERT(validator.hasPendingJobs());
+  }
+  // The completions run after the validator is gone.
+  while (workerPool.countPending() > 0) {
+    workerPool.processCompletions();
+  }
+  CPPUNIT_ASSERT_EQUAL(0, numWakeups);
+}
+
 } // namespace aria2
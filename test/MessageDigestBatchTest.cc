@@ -0,0 +1,99 @@
+#include "MessageDigestBatch.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "MessageDigest.h"
+#include "util.h"
+
+namespace aria2 {
+
+class MessageDigestBatchTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(MessageDigestBatchTest);
+  CPPUNIT_TEST(testDigest);
+  CPPUNIT_TEST(testDigest_noMultiBuffer);
+  CPPUNIT_TEST(testGetLanes);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::vector<std::string> messages_;
+
+  void check(const std::string& hashType, size_t n);
+
+public:
+  void setUp()
+  {
+    messages_.clear();
+    for (size_t i = 0; i < 20; ++i) {
+      std::string m;
+      for (size_t j = 0; j < 1000; ++j) {
+        m += static_cast<char>(i * 13 + j * 7 + (j >> 6));
+      }
+      messages_.push_back(m);
+    }
+  }
+
+  void testDigest();
+  void testDigest_noMultiBuffer();
+  void testGetLanes();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MessageDigestBatchTest);
+
+void MessageDigestBatchTest::check(const std::string& hashType, size_t n)
+{
+  auto batch = MessageDigestBatch::create(hashType, n);
+  CPPUNIT_ASSERT_EQUAL(n, batch->size());
+  CPPUNIT_ASSERT_EQUAL(MessageDigest::getDigestLength(hashType),
+                       batch->getDigestLength());
+  // Odd sized updates mix buffered and whole blocks.
+  std::vector<const void*> data(n);
+  for (size_t pos = 0, len = 1; pos < 1000; pos += len, len += 17) {
+    len = std::min(len, 1000 - pos);
+    for (size_t i = 0; i < n; ++i) {
+      data[i] = messages_[i].data() + pos;
+    }
+    batch->update(data.data(), len);
+  }
+  auto digests = batch->digest();
+  CPPUNIT_ASSERT_EQUAL(n, digests.size());
+  for (size_t i = 0; i < n; ++i) {
+    auto ctx = MessageDigest::create(hashType);
+    ctx->update(messages_[i].data(), messages_[i].size());
+    CPPUNIT_ASSERT_EQUAL(util::toHex(ctx->digest()), util::toHex(digests[i]));
+  }
+
+  // digest() resets the batch.
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = "abc";
+  }
+  batch->update(data.data(), 3);
+  digests = batch->digest();
+  auto ctx = MessageDigest::create(hashType);
+  ctx->update("abc", 3);
+  CPPUNIT_ASSERT_EQUAL(util::toHex(ctx->digest()), util::toHex(digests[n - 1]));
+}
+
+void MessageDigestBatchTest::testDigest()
+{
+  auto lanes = MessageDigestBatch::getLanes("sha-1");
+  for (auto n : {static_cast<size_t>(1), lanes, lanes + 3}) {
+    check("sha-1", n);
+  }
+}
+
+void MessageDigestBatchTest::testDigest_noMultiBuffer()
+{
+  check("sha-256", 3);
+  check("md5", 2);
+}
+
+void MessageDigestBatchTest::testGetLanes()
+{
+  CPPUNIT_ASSERT(MessageDigestBatch::getLanes("sha-1") >= 1);
+  CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1),
+                       MessageDigestBatch::getLanes("sha-256"));
+  CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1),
+                       MessageDigestBatch::getLanes("unknown"));
+}
+
+} // namespace aria2
@@ -59,6 +59,8 @@ public:
   {
   }
 
+  virtual Timer getNextAnnounceTime() CXX11_OVERRIDE { return Timer::zero(); }
+
   virtual void setTcpPort(uint16_t port) CXX11_OVERRIDE {}
 
   void setPeerId(const std::string& peerId) { this->peerId = peerId; }
@@ -92,6 +92,8 @@ public:
 
   virtual bool chokeRoundIntervalElapsed() CXX11_OVERRIDE { return false; }
 
+  virtual Timer getNextChokeRoundTime() CXX11_OVERRIDE { return Timer(); }
+
   virtual void executeChoke() CXX11_OVERRIDE { ++numChokeExecuted_; }
 
   int getNumChokeExecuted() const { return numChokeExecuted_; }
@@ -131,6 +131,15 @@ public:
   {
   }
 
+  virtual bool verifyPieceInWorker(
+      const std::shared_ptr<Piece>& piece, WorkerPool* workerPool,
+      std::function<void(const std::string&)> callback) CXX11_OVERRIDE
+  {
+    return false;
+  }
+
+  virtual void cancelPieceVerification() CXX11_OVERRIDE {}
+
   virtual bool hasPiece(size_t index) CXX11_OVERRIDE { return false; }
 
   virtual int64_t getTotalLength() CXX11_OVERRIDE { return totalLength; }
@@ -228,6 +237,8 @@ public:
 
   virtual WrDiskCache* getWrDiskCache() CXX11_OVERRIDE { return 0; }
 
+  virtual RdDiskCache* getRdDiskCache() CXX11_OVERRIDE { return 0; }
+
   virtual void flushWrDiskCacheEntry() CXX11_OVERRIDE {}
 
   void setDiskAdaptor(const std::shared_ptr<DiskAdaptor>& adaptor)
@@ -1,11 +1,17 @@
 #include "PeerConnection.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cstring>
+#include <fstream>
 
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "Peer.h"
 #include "SocketCore.h"
+#include "File.h"
+#include "SharedFd.h"
 
 namespace aria2 {
 
@@ -13,10 +19,12 @@ class PeerConnectionTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(PeerConnectionTest);
   CPPUNIT_TEST(testReserveBuffer);
+  CPPUNIT_TEST(testPushFile);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   void testReserveBuffer();
+  void testPushFile();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(PeerConnectionTest);
@@ -36,4 +44,55 @@ void PeerConnectionTest::testReserveBuffer()
   CPPUNIT_ASSERT(memcmp("foo", con.getBuffer(), 3) == 0);
 }
 
+void PeerConnectionTest::testPushFile()
+{
+  auto server = std::make_shared<SocketCore>();
+  server->bind(0);
+  server->beginListen();
+  server->setBlockingMode();
+  auto endpoint = server->getAddrInfo();
+  auto client = std::make_shared<SocketCore>();
+  client->establishConnection("localhost", endpoint.port);
+  while (!client->isWritable(0)) {
+  }
+  auto inbound = server->acceptConnection();
+  inbound->setBlockingMode();
+
+  PeerConnection con(1, std::shared_ptr<Peer>(), client);
+  if (!con.isSendFileAvailable()) {
+    return;
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_PeerConnectionTest_file";
+  {
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    out << "0123456789";
+  }
+  int rawFd = open(filename.c_str(), O_RDONLY);
+  CPPUNIT_ASSERT(rawFd != -1);
+  auto fd = std::make_shared<SharedFd>(rawFd);
+  con.pushBytes({'h', 'd', 'r'});
+  con.pushFile(fd, 2, 5);
+  con.pushFile(fd, 0, 2);
+  con.pushBytes({'!'});
+  CPPUNIT_ASSERT_EQUAL((size_t)4, con.getBufferEntrySize());
+  CPPUNIT_ASSERT_EQUAL(3L, fd.use_count());
+  while (!con.sendBufferIsEmpty()) {
+    con.sendPendingData();
+  }
+  // The file descriptor is released when the data are sent.
+  CPPUNIT_ASSERT_EQUAL(1L, fd.use_count());
+
+  char buf[16];
+  size_t total = 0;
+  while (total < 11) {
+    size_t len = sizeof(buf) - total;
+    inbound->readData(buf + total, len);
+    CPPUNIT_ASSERT(len > 0);
+    total += len;
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("hdr2345601!"),
+                       std::string(buf, total));
+  File(filename).remove();
+}
+
 } // namespace aria2
@@ -1,5 +1,9 @@
 #include "PieceStatMan.h"
 
+#include <algorithm>
+#include <functional>
+#include <random>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 namespace aria2 {
@@ -11,6 +15,8 @@ class PieceStatManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddPieceStats_bitfield);
   CPPUNIT_TEST(testUpdatePieceStats);
   CPPUNIT_TEST(testSubtractPieceStats);
+  CPPUNIT_TEST(testUpdatePieceStats_words);
+  CPPUNIT_TEST(testGetOrder);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -22,22 +28,44 @@ public:
   void testAddPieceStats_bitfield();
   void testUpdatePieceStats();
   void testSubtractPieceStats();
+  void testUpdatePieceStats_words();
+  void testGetOrder();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(PieceStatManTest);
 
+namespace {
+// Checks that getOrder() is a permutation of the pieces sorted by
+// their counts.
+void checkOrder(const PieceStatMan& pieceStatMan)
+{
+  const std::vector<size_t>& order(pieceStatMan.getOrder());
+  const std::vector<int>& counts(pieceStatMan.getCounts());
+  CPPUNIT_ASSERT_EQUAL(counts.size(), order.size());
+  std::vector<bool> seen(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    CPPUNIT_ASSERT(order[i] < order.size());
+    CPPUNIT_ASSERT(!seen[order[i]]);
+    seen[order[i]] = true;
+    if (i > 0) {
+      CPPUNIT_ASSERT(counts[order[i - 1]] <= counts[order[i]]);
+    }
+  }
+}
+} // namespace
+
 void PieceStatManTest::testAddPieceStats_index()
 {
   PieceStatMan pieceStatMan(10, false);
   pieceStatMan.addPieceStats(1);
   {
     int ans[] = {0, 1, 0, 0, 0, 0, 0, 0, 0, 0};
-    const std::vector<size_t>& order(pieceStatMan.getOrder());
     const std::vector<int>& counts(pieceStatMan.getCounts());
     for (size_t i = 0; i < 10; ++i) {
-      CPPUNIT_ASSERT_EQUAL(i, order[i]);
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStatMan.getOrder()[9]);
+    checkOrder(pieceStatMan);
   }
   pieceStatMan.addPieceStats(1);
   {
@@ -57,6 +85,7 @@ void PieceStatManTest::testAddPieceStats_index()
     for (size_t i = 0; i < 10; ++i) {
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    checkOrder(pieceStatMan);
   }
 }
 
@@ -102,6 +131,7 @@ void PieceStatManTest::testUpdatePieceStats()
     for (size_t i = 0; i < 10; ++i) {
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    checkOrder(pieceStatMan);
   }
 }
 
@@ -123,6 +153,63 @@ void PieceStatManTest::testSubtractPieceStats()
     for (size_t i = 0; i < 10; ++i) {
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    checkOrder(pieceStatMan);
+  }
+}
+
+void PieceStatManTest::testUpdatePieceStats_words()
+{
+  // 140 pieces span 2 full 64 bits words and 12 trailing bits.
+  PieceStatMan pieceStatMan(140, false);
+  std::vector<unsigned char> bitfield(18, 0xff);
+  bitfield[17] = 0xf0;
+  pieceStatMan.addPieceStats(bitfield.data(), bitfield.size());
+  std::vector<unsigned char> oldBitfield(18);
+  oldBitfield[0] = 0x80;
+  oldBitfield[9] = 0xff;
+  oldBitfield[17] = 0x10;
+  std::vector<unsigned char> newBitfield(18);
+  newBitfield[9] = 0x0f;
+  newBitfield[16] = 0x01;
+  newBitfield[17] = 0x30;
+  pieceStatMan.updatePieceStats(newBitfield.data(), newBitfield.size(),
+                                oldBitfield.data());
+  const std::vector<int>& counts(pieceStatMan.getCounts());
+  for (size_t i = 0; i < 140; ++i) {
+    int ans = 1;
+    if (i == 0 || (72 <= i && i < 76)) {
+      ans = 0;
+    }
+    else if (i == 135 || i == 138) {
+      ans = 2;
+    }
+    CPPUNIT_ASSERT_EQUAL(ans, counts[i]);
+  }
+  checkOrder(pieceStatMan);
+}
+
+void PieceStatManTest::testGetOrder()
+{
+  PieceStatMan pieceStatMan(1000, true);
+  std::vector<unsigned char> bitfield(125), oldBitfield(125);
+  std::mt19937 rng(0);
+  for (int k = 0; k < 100; ++k) {
+    std::generate(bitfield.begin(), bitfield.end(), std::ref(rng));
+    switch (k % 4) {
+    case 0:
+    case 1:
+      pieceStatMan.addPieceStats(bitfield.data(), bitfield.size());
+      break;
+    case 2:
+      pieceStatMan.updatePieceStats(bitfield.data(), bitfield.size(),
+                                    oldBitfield.data());
+      break;
+    default:
+      pieceStatMan.subtractPieceStats(bitfield.data(), bitfield.size());
+    }
+    pieceStatMan.addPieceStats(rng() % 1000);
+    oldBitfield = bitfield;
+    checkOrder(pieceStatMan);
   }
 }
 
@@ -20,6 +20,7 @@ class PieceTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testAppendWrCache);
 
   CPPUNIT_TEST(testGetDigestWithWrCache);
+  CPPUNIT_TEST(testGetDigestWithWrCache_overlap);
   CPPUNIT_TEST(testUpdateHash);
 
   CPPUNIT_TEST_SUITE_END();
@@ -43,6 +44,7 @@ public:
   void testAppendWrCache();
 
   void testGetDigestWithWrCache();
+  void testGetDigestWithWrCache_overlap();
   void testUpdateHash();
 };
 
@@ -139,6 +141,29 @@ void PieceTest::testGetDigestWithWrCache()
       util::toHex(p.getDigestWithWrCache(p.getLength(), adaptor_)));
 }
 
+void PieceTest::testGetDigestWithWrCache_overlap()
+{
+  unsigned char* data;
+  Piece p(0, 26);
+  p.setHashType("sha-1");
+  WrDiskCache dc(64);
+  //                  012345678901234567890123456
+  writer_->setString("abcde...ijklmnopqrstuvwxyz");
+  p.initWrCache(&dc, adaptor_);
+  data = new unsigned char[3];
+  memcpy(data, "fgh", 3);
+  p.updateWrCache(&dc, data, 0, 3, 5);
+  data = new unsigned char[4];
+  memcpy(data, "ghij", 4);
+  p.updateWrCache(&dc, data, 0, 4, 6);
+
+  CPPUNIT_ASSERT_EQUAL(
+      std::string("32d10c7b8cf96570ca04ce37f2a19d84240d3a89"),
+      util::toHex(p.getDigestWithWrCache(p.getLength(), adaptor_)));
+  p.clearWrCache(&dc);
+  p.releaseWrCache(&dc);
+}
+
 void PieceTest::testUpdateHash()
 {
   Piece p(0, 16, 2_m);
@@ -0,0 +1,152 @@
+#include "RdDiskCache.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "TestUtil.h"
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
+
+namespace aria2 {
+
+class RdDiskCacheTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(RdDiskCacheTest);
+  CPPUNIT_TEST(testGet);
+  CPPUNIT_TEST(testGet_evict);
+  CPPUNIT_TEST(testGet_sharedLimit);
+  CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testRemove_piece);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<DirectDiskAdaptor> adaptor_;
+  ByteArrayDiskWriter* writer_;
+
+public:
+  void setUp()
+  {
+    adaptor_ = std::make_shared<DirectDiskAdaptor>();
+    auto dw = make_unique<ByteArrayDiskWriter>();
+    writer_ = dw.get();
+    writer_->setString("0123456789abcdefghijklmnopqrstuvwxyz");
+    adaptor_->setDiskWriter(std::move(dw));
+  }
+
+  void testGet();
+  void testGet_evict();
+  void testGet_sharedLimit();
+  void testRemove();
+  void testRemove_piece();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RdDiskCacheTest);
+
+namespace {
+std::string get(RdDiskCache& cache, a2_gid_t gid, size_t index,
+                DiskAdaptor* diskAdaptor)
+{
+  auto data = cache.get(gid, index, index * 4, 4, diskAdaptor);
+  if (!data) {
+    return "";
+  }
+  return std::string(data, data + 4);
+}
+} // namespace
+
+void RdDiskCacheTest::testGet()
+{
+  RdDiskCache cache(20, nullptr);
+  CPPUNIT_ASSERT_EQUAL(std::string("4567"), get(cache, 1, 1, adaptor_.get()));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, cache.getNumHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getNumMisses());
+  CPPUNIT_ASSERT_EQUAL((size_t)4, cache.getSize());
+
+  // Cached data is served without reading the disk.
+  writer_->setString("----------");
+  CPPUNIT_ASSERT_EQUAL(std::string("4567"), get(cache, 1, 1, adaptor_.get()));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getNumHits());
+
+  // Same index of the other download is not shared.
+  CPPUNIT_ASSERT_EQUAL(std::string("----"), get(cache, 2, 1, adaptor_.get()));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache.getNumMisses());
+
+  // The piece larger than the quarter of the limit is not cached.
+  CPPUNIT_ASSERT(!cache.get(1, 0, 0, 6, adaptor_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.countPieces());
+}
+
+void RdDiskCacheTest::testGet_evict()
+{
+  RdDiskCache cache(20, nullptr);
+  for (size_t i = 0; i < 5; ++i) {
+    get(cache, 1, i, adaptor_.get());
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)20, cache.getSize());
+  // Piece 1 becomes the least recently used one.
+  get(cache, 1, 0, adaptor_.get());
+  get(cache, 1, 5, adaptor_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)20, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)5, cache.countPieces());
+
+  auto misses = cache.getNumMisses();
+  get(cache, 1, 0, adaptor_.get());
+  CPPUNIT_ASSERT_EQUAL(misses, cache.getNumMisses());
+  get(cache, 1, 1, adaptor_.get());
+  CPPUNIT_ASSERT_EQUAL(misses + 1, cache.getNumMisses());
+}
+
+void RdDiskCacheTest::testGet_sharedLimit()
+{
+  WrDiskCache wrDiskCache(20);
+  RdDiskCache cache(20, &wrDiskCache);
+  wrDiskCache.setRdDiskCache(&cache);
+  for (size_t i = 0; i < 5; ++i) {
+    get(cache, 1, i, adaptor_.get());
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)20, cache.getSize());
+
+  WrDiskCacheEntry ent(adaptor_);
+  ent.cacheData(createDataCell(0, "who knows?"));
+  CPPUNIT_ASSERT(wrDiskCache.add(&ent));
+  // WrDiskCache evicts the least recently used pieces at once.
+  CPPUNIT_ASSERT_EQUAL((size_t)8, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL(std::string("0123"), get(cache, 1, 0, adaptor_.get()));
+  CPPUNIT_ASSERT_EQUAL((size_t)8, cache.getSize());
+  CPPUNIT_ASSERT(wrDiskCache.remove(&ent));
+}
+
+void RdDiskCacheTest::testRemove()
+{
+  RdDiskCache cache(20, nullptr);
+  get(cache, 1, 0, adaptor_.get());
+  get(cache, 2, 0, adaptor_.get());
+  get(cache, 2, 1, adaptor_.get());
+  get(cache, 3, 0, adaptor_.get());
+  cache.remove(2);
+  CPPUNIT_ASSERT_EQUAL((size_t)8, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.countPieces());
+  cache.remove(1);
+  cache.remove(3);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.getSize());
+}
+
+void RdDiskCacheTest::testRemove_piece()
+{
+  RdDiskCache cache(20, nullptr);
+  get(cache, 1, 0, adaptor_.get());
+  get(cache, 1, 1, adaptor_.get());
+  auto misses = cache.getNumMisses();
+  // The piece is rewritten on disk.
+  writer_->setString("ABCDEFGHIJ");
+  cache.remove(1, 0);
+  cache.remove(1, 2);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL(std::string("ABCD"), get(cache, 1, 0, adaptor_.get()));
+  CPPUNIT_ASSERT_EQUAL(misses + 1, cache.getNumMisses());
+  CPPUNIT_ASSERT_EQUAL(std::string("4567"), get(cache, 1, 1, adaptor_.get()));
+}
+
+} // namespace aria2
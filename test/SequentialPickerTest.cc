@@ -10,10 +10,12 @@ class SequentialPickerTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(SequentialPickerTest);
   CPPUNIT_TEST(testPick);
+  CPPUNIT_TEST(testPick_maxPicked);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   void testPick();
+  void testPick_maxPicked();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SequentialPickerTest);
@@ -37,7 +39,7 @@ void SequentialPickerTest::testPick()
   CPPUNIT_ASSERT(picker.isPicked());
   CPPUNIT_ASSERT_EQUAL(1, *picker.getPickedEntry());
 
-  picker.dropPickedEntry();
+  picker.dropPickedEntry(picker.getPickedEntry());
 
   CPPUNIT_ASSERT(!picker.isPicked());
   CPPUNIT_ASSERT(picker.hasNext());
@@ -48,4 +50,29 @@ void SequentialPickerTest::testPick()
   CPPUNIT_ASSERT(!picker.hasNext());
 }
 
+void SequentialPickerTest::testPick_maxPicked()
+{
+  SequentialPicker<int> picker(2);
+  for (int i = 1; i <= 3; ++i) {
+    picker.pushEntry(make_unique<int>(i));
+  }
+  CPPUNIT_ASSERT(picker.canPickNext());
+  auto first = picker.pickNext();
+  CPPUNIT_ASSERT(picker.canPickNext());
+  picker.pickNext();
+  CPPUNIT_ASSERT(!picker.canPickNext());
+  CPPUNIT_ASSERT(picker.hasNext());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, picker.getPickedEntries().size());
+  CPPUNIT_ASSERT_EQUAL(2, *picker.findPicked([](const int& i) {
+    return i == 2;
+  }));
+  CPPUNIT_ASSERT(!picker.isPicked([](const int& i) { return i == 3; }));
+
+  picker.dropPickedEntry(first);
+  CPPUNIT_ASSERT_EQUAL(2, *picker.getPickedEntry());
+  CPPUNIT_ASSERT(picker.canPickNext());
+  CPPUNIT_ASSERT_EQUAL(3, *picker.pickNext());
+  CPPUNIT_ASSERT(!picker.canPickNext());
+}
+
 } // namespace aria2
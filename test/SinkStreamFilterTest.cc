@@ -8,6 +8,14 @@
 #include "ByteArrayDiskWriter.h"
 #include "SinkStreamFilter.h"
 #include "MockSegment.h"
+#include "PiecedSegment.h"
+#include "Piece.h"
+#include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
+#include "DirectDiskAdaptor.h"
+#include "SocketCore.h"
+#include "SocketRecvBuffer.h"
+#include "util.h"
 
 namespace aria2 {
 
@@ -16,6 +24,7 @@ class SinkStreamFilterTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(SinkStreamFilterTest);
   CPPUNIT_TEST(testTransform_with_length);
   CPPUNIT_TEST(testTransform_without_length);
+  CPPUNIT_TEST(testReceive);
   CPPUNIT_TEST_SUITE_END();
 
   class MockSegment2 : public MockSegment {
@@ -55,6 +64,7 @@ public:
 
   void testTransform_with_length();
   void testTransform_without_length();
+  void testReceive();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SinkStreamFilterTest);
@@ -82,4 +92,56 @@ void SinkStreamFilterTest::testTransform_without_length()
   CPPUNIT_ASSERT_EQUAL((ssize_t)17, r);
 }
 
+void SinkStreamFilterTest::testReceive()
+{
+  auto server = std::make_shared<SocketCore>();
+  server->bind(0);
+  server->beginListen();
+  server->setBlockingMode();
+  auto endpoint = server->getAddrInfo();
+  auto client = std::make_shared<SocketCore>();
+  client->establishConnection("localhost", endpoint.port);
+  while (!client->isWritable(0)) {
+  }
+  auto inbound = server->acceptConnection();
+  inbound->setBlockingMode();
+
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<ByteArrayDiskWriter>();
+  auto writer = dw.get();
+  adaptor->setDiskWriter(std::move(dw));
+  WrDiskCache dc(1_m);
+  auto piece = std::make_shared<Piece>(0, 16);
+  piece->setHashType("sha-1");
+  piece->initWrCache(&dc, adaptor);
+  auto segment = std::make_shared<PiecedSegment>(16, piece);
+  SinkStreamFilter filter(&dc, true);
+  SocketRecvBuffer recvBuf(inbound);
+
+  client->writeData("0123");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)4, filter.receive(&recvBuf, segment, 1_k));
+  CPPUNIT_ASSERT_EQUAL((int64_t)4, segment->getWrittenLength());
+  CPPUNIT_ASSERT_EQUAL((size_t)4, filter.getBytesProcessed());
+  CPPUNIT_ASSERT(recvBuf.bufferEmpty());
+  // Following data is appended to the same cache cell.
+  client->writeData("456789");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, filter.receive(&recvBuf, segment, 1_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)1,
+                       piece->getWrDiskCacheEntry()->getDataSet().size());
+  // Not more than segment length.  The rest is stored in recvBuf.
+  client->writeData("abcdefghij");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, filter.receive(&recvBuf, segment, 1_k));
+  CPPUNIT_ASSERT_EQUAL((size_t)4, recvBuf.getBufferLength());
+  CPPUNIT_ASSERT(memcmp("ghij", recvBuf.getBuffer(), 4) == 0);
+  CPPUNIT_ASSERT(segment->complete());
+  // The whole 16KiB block is accounted.
+  CPPUNIT_ASSERT_EQUAL((size_t)16_k, piece->getWrDiskCacheEntry()->getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)16_k, dc.getSize());
+  CPPUNIT_ASSERT_EQUAL(std::string("fe5567e8d769550852182cdf69d74bb16dff8e29"),
+                       util::toHex(segment->getDigest()));
+  piece->flushWrCache(&dc);
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789abcdef"), writer->getString());
+  piece->clearWrCache(&dc);
+}
+
 } // namespace aria2
@@ -0,0 +1,125 @@
+#include "SlabPool.h"
+
+#include <vector>
+#include <cstring>
+#include <memory>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class SlabPoolTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SlabPoolTest);
+  CPPUNIT_TEST(testAllocate);
+  CPPUNIT_TEST(testDeallocate_releaseSlab);
+  CPPUNIT_TEST(testDeallocate_foreign);
+  CPPUNIT_TEST(testDeallocate_manySlabs);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testAllocate();
+  void testDeallocate_releaseSlab();
+  void testDeallocate_foreign();
+  void testDeallocate_manySlabs();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SlabPoolTest);
+
+void SlabPoolTest::testAllocate()
+{
+  SlabPool pool(16, 4, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)16, pool.getBlockSize());
+  std::vector<unsigned char*> blocks;
+  for (int i = 0; i < 5; ++i) {
+    auto p = pool.allocate();
+    memset(p, i, pool.getBlockSize());
+    blocks.push_back(p);
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)5, pool.countLive());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.countFree());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.countSlabs());
+  for (int i = 0; i < 5; ++i) {
+    for (size_t j = 0; j < pool.getBlockSize(); ++j) {
+      CPPUNIT_ASSERT_EQUAL(i, (int)blocks[i][j]);
+    }
+  }
+  // Freed block is reused.
+  CPPUNIT_ASSERT(pool.deallocate(blocks[2]));
+  CPPUNIT_ASSERT_EQUAL((size_t)4, pool.countLive());
+  CPPUNIT_ASSERT(blocks[2] == pool.allocate());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.countSlabs());
+  for (auto p : blocks) {
+    CPPUNIT_ASSERT(pool.deallocate(p));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countLive());
+}
+
+void SlabPoolTest::testDeallocate_releaseSlab()
+{
+  SlabPool pool(16, 2, 1);
+  std::vector<unsigned char*> blocks;
+  for (int i = 0; i < 6; ++i) {
+    blocks.push_back(pool.allocate());
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.countSlabs());
+  for (auto p : blocks) {
+    CPPUNIT_ASSERT(pool.deallocate(p));
+  }
+  // Only 1 empty slab is kept.
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countSlabs());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countLive());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.countFree());
+
+  blocks.clear();
+  blocks.push_back(pool.allocate());
+  blocks.push_back(pool.allocate());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countSlabs());
+  blocks.push_back(pool.allocate());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.countSlabs());
+  for (auto p : blocks) {
+    CPPUNIT_ASSERT(pool.deallocate(p));
+  }
+}
+
+void SlabPoolTest::testDeallocate_foreign()
+{
+  SlabPool pool(16, 2, 1);
+  unsigned char buf[16];
+  CPPUNIT_ASSERT(!pool.deallocate(buf));
+  auto p = pool.allocate();
+  unsigned char* q = new unsigned char[16];
+  CPPUNIT_ASSERT(!pool.deallocate(q));
+  delete[] q;
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countLive());
+  CPPUNIT_ASSERT(pool.deallocate(p));
+}
+
+void SlabPoolTest::testDeallocate_manySlabs()
+{
+  // Slabs and foreign buffers of the same size are interleaved in the
+  // heap, so that they share the address windows used for lookup.
+  SlabPool pool(16, 2, 0);
+  std::vector<unsigned char*> blocks;
+  std::vector<std::unique_ptr<unsigned char[]>> foreign;
+  for (int i = 0; i < 100; ++i) {
+    blocks.push_back(pool.allocate());
+    foreign.emplace_back(new unsigned char[32]);
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)50, pool.countSlabs());
+  for (auto& p : foreign) {
+    CPPUNIT_ASSERT(!pool.deallocate(p.get()));
+  }
+  for (size_t i = 0; i < blocks.size(); i += 2) {
+    CPPUNIT_ASSERT(pool.deallocate(blocks[i]));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)50, pool.countLive());
+  for (size_t i = 1; i < blocks.size(); i += 2) {
+    CPPUNIT_ASSERT(pool.deallocate(blocks[i]));
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countLive());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countSlabs());
+  CPPUNIT_ASSERT(!pool.deallocate(blocks[0]));
+}
+
+} // namespace aria2
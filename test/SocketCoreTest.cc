@@ -6,6 +6,15 @@
 
 #include "a2functional.h"
 #include "Exception.h"
+#ifdef ENABLE_SSL
+#  include <fcntl.h>
+#  include <fstream>
+#  include "TLSContext.h"
+#  include "BufferedFile.h"
+#  include "File.h"
+#  include "util.h"
+#  include "a2io.h"
+#endif // ENABLE_SSL
 
 namespace aria2 {
 
@@ -18,6 +27,9 @@ class SocketCoreTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testInetPton);
   CPPUNIT_TEST(testGetBinAddr);
   CPPUNIT_TEST(testVerifyHostname);
+#ifdef ENABLE_SSL
+  CPPUNIT_TEST(testSendFile_kernelTLS);
+#endif // ENABLE_SSL
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -31,6 +43,9 @@ public:
   void testInetPton();
   void testGetBinAddr();
   void testVerifyHostname();
+#ifdef ENABLE_SSL
+  void testSendFile_kernelTLS();
+#endif // ENABLE_SSL
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SocketCoreTest);
@@ -239,4 +254,102 @@ void SocketCoreTest::testVerifyHostname()
   }
 }
 
+#ifdef ENABLE_SSL
+namespace {
+// Returns true if the kernel has registered TCP "tls" ULP.
+bool kernelHasTLSUlp()
+{
+  BufferedFile fp("/proc/sys/net/ipv4/tcp_available_ulp", BufferedFile::READ);
+  if (!fp) {
+    return false;
+  }
+  std::string line = fp.getLine();
+  std::vector<std::string> ulps;
+  util::split(line.begin(), line.end(), std::back_inserter(ulps), ' ', true);
+  return std::find(ulps.begin(), ulps.end(), std::string("tls")) != ulps.end();
+}
+} // namespace
+
+void SocketCoreTest::testSendFile_kernelTLS()
+{
+  std::shared_ptr<TLSContext> svTlsContext(
+      TLSContext::make(TLS_SERVER, TLS_PROTO_TLS12));
+  CPPUNIT_ASSERT(svTlsContext->addCredentialFile(
+      A2_TEST_DIR "/tls-server.crt", A2_TEST_DIR "/tls-server.key"));
+  std::shared_ptr<TLSContext> clTlsContext(
+      TLSContext::make(TLS_CLIENT, TLS_PROTO_TLS12));
+  clTlsContext->setVerifyPeer(false);
+  // Returns false for the backends without kernel TLS.  They must
+  // keep working in user space, just like the kernels without it.
+  svTlsContext->enableKernelTLS();
+  clTlsContext->enableKernelTLS();
+  SocketCore::setServerTLSContext(svTlsContext);
+  SocketCore::setClientTLSContext(clTlsContext);
+
+  SocketCore server;
+  server.bind(0);
+  server.beginListen();
+  server.setBlockingMode();
+  auto endpoint = server.getAddrInfo();
+  SocketCore client;
+  client.establishConnection("localhost", endpoint.port);
+  while (!client.isWritable(0)) {
+  }
+  auto inbound = server.acceptConnection();
+  inbound->setNonBlockingMode();
+
+  bool clientDone = false, inboundDone = false;
+  while (!clientDone || !inboundDone) {
+    if (!clientDone) {
+      clientDone = client.tlsConnect("localhost", endpoint.port);
+    }
+    if (!inboundDone) {
+      inboundDone = inbound->tlsAccept();
+    }
+  }
+
+  if (!kernelHasTLSUlp()) {
+    // The handshake has already tried to install the ULP, so that it
+    // is not available.  TLS must be done in user space.
+    CPPUNIT_ASSERT(!inbound->isSendFileAvailable());
+  }
+
+  std::string data;
+  for (size_t i = 0; i < 100000; ++i) {
+    data += static_cast<char>(i * 7 + i / 256);
+  }
+  std::string filename = A2_TEST_OUT_DIR "/aria2_SocketCoreTest_kernelTLS";
+  {
+    std::ofstream out(filename.c_str(), std::ios::binary);
+    out << data;
+  }
+  int fd = open(filename.c_str(), O_RDONLY);
+  CPPUNIT_ASSERT(fd != -1);
+
+  bool sendFile = inbound->isSendFileAvailable();
+  size_t sent = 0;
+  std::string received;
+  char buf[16_k];
+  while (received.size() < data.size()) {
+    if (sent < data.size()) {
+      if (sendFile) {
+        sent += inbound->sendFile(fd, sent, data.size() - sent);
+      }
+      else {
+        sent += inbound->writeData(data.data() + sent, data.size() - sent);
+      }
+    }
+    size_t len = sizeof(buf);
+    client.readData(buf, len);
+    received.append(buf, len);
+  }
+  close(fd);
+  CPPUNIT_ASSERT(data == received);
+
+  SocketCore::setServerTLSContext(nullptr);
+  SocketCore::setClientTLSContext(nullptr);
+  File(filename).remove();
+}
+#endif // ENABLE_SSL
+
 } // namespace aria2
@@ -0,0 +1,250 @@
+#include "SocketPool.h"
+
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "wallclock.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class SocketPoolTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SocketPoolTest);
+  CPPUNIT_TEST(testAddAndPop);
+  CPPUNIT_TEST(testMaxIdlePerHost);
+  CPPUNIT_TEST(testMaxIdle);
+  CPPUNIT_TEST(testMaxIdle_zero);
+  CPPUNIT_TEST(testEvictTimedOut);
+  CPPUNIT_TEST(testPop_timedOut);
+  CPPUNIT_TEST(testPop_closedByPeer);
+  CPPUNIT_TEST(testCount);
+  CPPUNIT_TEST(testSetMaxIdlePerHost);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::unique_ptr<SocketCore> listener_;
+  // Server side of the connections.  Kept open so that the client
+  // side stays alive in the pool.
+  std::vector<std::shared_ptr<SocketCore>> inbounds_;
+
+  std::shared_ptr<SocketCore> connect()
+  {
+    auto socket = std::make_shared<SocketCore>();
+    socket->establishConnection("localhost", listener_->getAddrInfo().port);
+    while (!socket->isWritable(0))
+      ;
+    socket->setBlockingMode();
+    inbounds_.push_back(listener_->acceptConnection());
+    return socket;
+  }
+
+public:
+  void setUp()
+  {
+    global::wallclock().reset();
+    listener_ = make_unique<SocketCore>();
+    listener_->bind(0);
+    listener_->beginListen();
+    listener_->setBlockingMode();
+    inbounds_.clear();
+  }
+
+  void testAddAndPop();
+  void testMaxIdlePerHost();
+  void testMaxIdle();
+  void testMaxIdle_zero();
+  void testEvictTimedOut();
+  void testPop_timedOut();
+  void testPop_closedByPeer();
+  void testCount();
+  void testSetMaxIdlePerHost();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SocketPoolTest);
+
+void SocketPoolTest::testAddAndPop()
+{
+  SocketPool pool;
+  auto s1 = connect();
+  auto s2 = connect();
+  auto s3 = connect();
+  pool.add("a", s1, "opt1");
+  pool.add("a", s2, "opt2");
+  pool.add("b", s3, "opt3");
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.size());
+
+  std::string options;
+  // The most recently pooled one comes first.
+  CPPUNIT_ASSERT(s2 == pool.pop(options, "a"));
+  CPPUNIT_ASSERT_EQUAL(std::string("opt2"), options);
+  CPPUNIT_ASSERT(s1 == pool.pop(options, "a"));
+  CPPUNIT_ASSERT_EQUAL(std::string("opt1"), options);
+  CPPUNIT_ASSERT(!pool.pop(options, "a"));
+  CPPUNIT_ASSERT(!pool.pop(options, "c"));
+  CPPUNIT_ASSERT(s3 == pool.pop(options, "b"));
+  CPPUNIT_ASSERT(pool.empty());
+}
+
+void SocketPoolTest::testMaxIdlePerHost()
+{
+  SocketPool pool;
+  pool.setMaxIdlePerHost(2);
+  auto s1 = connect();
+  auto s2 = connect();
+  auto s3 = connect();
+  auto s4 = connect();
+  pool.add("a", s1, "");
+  pool.add("b", s2, "");
+  pool.add("a", s3, "");
+  pool.add("a", s4, "");
+  // s1 was closed to make room for s4.
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.count("a"));
+
+  std::string options;
+  CPPUNIT_ASSERT(s4 == pool.pop(options, "a"));
+  CPPUNIT_ASSERT(s3 == pool.pop(options, "a"));
+  CPPUNIT_ASSERT(!pool.pop(options, "a"));
+  CPPUNIT_ASSERT(s2 == pool.pop(options, "b"));
+}
+
+void SocketPoolTest::testMaxIdle()
+{
+  SocketPool pool;
+  pool.setMaxIdle(2);
+  auto s1 = connect();
+  auto s2 = connect();
+  auto s3 = connect();
+  pool.add("a", s1, "");
+  pool.add("b", s2, "");
+  pool.add("c", s3, "");
+  // s1 is the least recently pooled.
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.count("a"));
+
+  std::string options;
+  CPPUNIT_ASSERT(!pool.pop(options, "a"));
+  CPPUNIT_ASSERT(s2 == pool.pop(options, "b"));
+  CPPUNIT_ASSERT(s3 == pool.pop(options, "c"));
+}
+
+void SocketPoolTest::testMaxIdle_zero()
+{
+  SocketPool pool;
+  pool.setMaxIdle(0);
+  pool.add("a", connect(), "");
+  CPPUNIT_ASSERT(pool.empty());
+
+  pool.setMaxIdle(64);
+  pool.setMaxIdlePerHost(0);
+  pool.add("a", connect(), "");
+  CPPUNIT_ASSERT(pool.empty());
+}
+
+void SocketPoolTest::testEvictTimedOut()
+{
+  SocketPool pool;
+  pool.setIdleTimeout(2_s);
+  CPPUNIT_ASSERT_EQUAL((int64_t)2, (int64_t)pool.getIdleTimeout().count());
+  pool.add("a", connect(), "");
+  global::wallclock().advance(1_s);
+  pool.add("b", connect(), "");
+  pool.add("a", connect(), "");
+
+  global::wallclock().advance(1_s);
+  // Only the first one has timed out.
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.evictTimedOut());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.count("a"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.count("b"));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.evictTimedOut());
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.evictTimedOut());
+  CPPUNIT_ASSERT(pool.empty());
+}
+
+void SocketPoolTest::testPop_timedOut()
+{
+  SocketPool pool;
+  pool.setIdleTimeout(2_s);
+  pool.add("a", connect(), "");
+  global::wallclock().advance(1_s);
+  auto s2 = connect();
+  pool.add("a", s2, "");
+  global::wallclock().advance(1_s);
+
+  std::string options;
+  CPPUNIT_ASSERT(s2 == pool.pop(options, "a"));
+  // The timed out one is skipped and removed.
+  CPPUNIT_ASSERT(!pool.pop(options, "a"));
+  CPPUNIT_ASSERT(pool.empty());
+}
+
+void SocketPoolTest::testPop_closedByPeer()
+{
+  SocketPool pool;
+  auto s1 = connect();
+  auto s2 = connect();
+  pool.add("a", s1, "");
+  pool.add("a", s2, "");
+  inbounds_.back()->closeConnection();
+  // Wait for FIN from the peer.
+  while (!s2->isReadable(0))
+    ;
+  std::string options;
+  // s2 is skipped and removed.
+  CPPUNIT_ASSERT(s1 == pool.pop(options, "a"));
+  CPPUNIT_ASSERT(pool.empty());
+}
+
+void SocketPoolTest::testCount()
+{
+  SocketPool pool;
+  pool.addPending("a");
+  pool.addPending("a");
+  pool.addPending("b");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.count("a"));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.countPending());
+  pool.removePending("b");
+  pool.add("a", connect(), "");
+  pool.removePending("a");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.count("a"));
+
+  std::string options;
+  CPPUNIT_ASSERT(pool.pop(options, "a"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.count("a"));
+  pool.removePending("a");
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.count("a"));
+  // Excess removal is harmless.
+  pool.removePending("a");
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.count("a"));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countPending());
+}
+
+void SocketPoolTest::testSetMaxIdlePerHost()
+{
+  SocketPool pool;
+  auto s1 = connect();
+  auto s2 = connect();
+  auto s3 = connect();
+  auto s4 = connect();
+  pool.add("a", s1, "");
+  pool.add("a", s2, "");
+  pool.add("a", s3, "");
+  pool.add("b", s4, "");
+  pool.setMaxIdlePerHost(1);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pool.size());
+
+  std::string options;
+  CPPUNIT_ASSERT(s3 == pool.pop(options, "a"));
+  CPPUNIT_ASSERT(s4 == pool.pop(options, "b"));
+
+  pool.add("a", s1, "");
+  pool.add("b", s2, "");
+  pool.setMaxIdle(1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.size());
+  CPPUNIT_ASSERT(s2 == pool.pop(options, "b"));
+}
+
+} // namespace aria2
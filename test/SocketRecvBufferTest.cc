@@ -0,0 +1,157 @@
+#include "SocketRecvBuffer.h"
+
+#include <cstring>
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+
+namespace aria2 {
+
+class SocketRecvBufferTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SocketRecvBufferTest);
+  CPPUNIT_TEST(testRecv);
+  CPPUNIT_TEST(testRecv_grow);
+  CPPUNIT_TEST(testRecv_shrink);
+  CPPUNIT_TEST(testRecvVector);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<SocketCore> client_;
+  std::shared_ptr<SocketCore> inbound_;
+
+public:
+  void setUp()
+  {
+    auto server = std::make_shared<SocketCore>();
+    server->bind(0);
+    server->beginListen();
+    server->setBlockingMode();
+    auto endpoint = server->getAddrInfo();
+    client_ = std::make_shared<SocketCore>();
+    client_->establishConnection("localhost", endpoint.port);
+    while (!client_->isWritable(0)) {
+    }
+    client_->setBlockingMode();
+    inbound_ = server->acceptConnection();
+    inbound_->setBlockingMode();
+    SocketRecvBuffer::setMaxCapacity(64_k);
+  }
+
+  void tearDown()
+  {
+    SocketRecvBuffer::setMaxCapacity(SocketRecvBuffer::MIN_CAPACITY);
+  }
+
+  void writeData(size_t len)
+  {
+    std::string data(len, 'a');
+    size_t off = 0;
+    while (off < len) {
+      off += client_->writeData(data.data() + off, len - off);
+    }
+  }
+
+  // Reads len bytes and drains them.
+  void readData(SocketRecvBuffer& buf, size_t len)
+  {
+    while (len > 0) {
+      buf.recv();
+      size_t n = buf.getBufferLength();
+      CPPUNIT_ASSERT(n > 0);
+      CPPUNIT_ASSERT(n <= len);
+      buf.drain(n);
+      len -= n;
+    }
+  }
+
+  void testRecv();
+  void testRecv_grow();
+  void testRecv_shrink();
+  void testRecvVector();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SocketRecvBufferTest);
+
+void SocketRecvBufferTest::testRecv()
+{
+  SocketRecvBuffer buf(inbound_);
+  client_->writeData("foobar");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, buf.recv());
+  CPPUNIT_ASSERT_EQUAL(std::string("foobar"),
+                       std::string(buf.getBuffer(),
+                                   buf.getBuffer() + buf.getBufferLength()));
+  buf.drain(3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, buf.getBufferLength());
+  CPPUNIT_ASSERT(memcmp("bar", buf.getBuffer(), 3) == 0);
+  buf.drain(3);
+  CPPUNIT_ASSERT(buf.bufferEmpty());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, buf.getRecvCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)6, buf.getRecvBytes());
+}
+
+void SocketRecvBufferTest::testRecv_grow()
+{
+  SocketRecvBuffer buf(inbound_);
+  CPPUNIT_ASSERT_EQUAL(16_k, buf.getCapacity());
+  writeData(16_k);
+  readData(buf, 16_k);
+  if (buf.getRecvCount() == 1) {
+    // The whole buffer was filled by one read.
+    CPPUNIT_ASSERT_EQUAL(32_k, buf.getCapacity());
+  }
+  // Never exceeds the maximum capacity.
+  for (int i = 0; i < 8; ++i) {
+    writeData(buf.getCapacity());
+    readData(buf, buf.getCapacity());
+    CPPUNIT_ASSERT(buf.getCapacity() <= 64_k);
+  }
+}
+
+void SocketRecvBufferTest::testRecv_shrink()
+{
+  SocketRecvBuffer buf(inbound_);
+  writeData(16_k);
+  readData(buf, 16_k);
+  writeData(32_k);
+  readData(buf, 32_k);
+  size_t capacity = buf.getCapacity();
+  if (capacity == 16_k) {
+    // Reads did not fill the buffer in this environment.
+    return;
+  }
+  for (int i = 0; i < 16; ++i) {
+    client_->writeData("a");
+    readData(buf, 1);
+  }
+  CPPUNIT_ASSERT_EQUAL(capacity / 2, buf.getCapacity());
+}
+
+void SocketRecvBufferTest::testRecvVector()
+{
+  SocketRecvBuffer buf(inbound_);
+  client_->writeData("0123456789");
+  unsigned char a[3], b[4];
+  a2iovec iov[2];
+  iov[0].A2IOVEC_BASE = reinterpret_cast<char*>(a);
+  iov[0].A2IOVEC_LEN = sizeof(a);
+  iov[1].A2IOVEC_BASE = reinterpret_cast<char*>(b);
+  iov[1].A2IOVEC_LEN = sizeof(b);
+  // The data beyond iov are stored in buf.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)7, buf.recv(iov, 2));
+  CPPUNIT_ASSERT(memcmp("012", a, 3) == 0);
+  CPPUNIT_ASSERT(memcmp("3456", b, 4) == 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, buf.getBufferLength());
+  CPPUNIT_ASSERT(memcmp("789", buf.getBuffer(), 3) == 0);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, buf.getRecvCount());
+  buf.drain(3);
+
+  client_->writeData("abc");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)3, buf.recv(iov, 2));
+  CPPUNIT_ASSERT(memcmp("abc", a, 3) == 0);
+  CPPUNIT_ASSERT(buf.bufferEmpty());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)13, buf.getRecvBytes());
+}
+
+} // namespace aria2
@@ -0,0 +1,133 @@
+#include "TLSSessionCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class TLSSessionCacheTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TLSSessionCacheTest);
+  CPPUNIT_TEST(testPut);
+  CPPUNIT_TEST(testPut_singleUse);
+  CPPUNIT_TEST(testPut_evict);
+  CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testCountHandshake);
+  CPPUNIT_TEST(testCountHandshake_evict);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testPut();
+  void testPut_singleUse();
+  void testPut_evict();
+  void testRemove();
+  void testCountHandshake();
+  void testCountHandshake_evict();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TLSSessionCacheTest);
+
+void TLSSessionCacheTest::testPut()
+{
+  TLSSessionCache cache;
+  auto key = TLSSessionCache::makeKey("example.org", 443);
+  CPPUNIT_ASSERT_EQUAL(std::string("example.org:443"), key);
+  CPPUNIT_ASSERT(cache.take(key).empty());
+  cache.put(key, "session1", true);
+  // Reusable session is handed to every connection.
+  CPPUNIT_ASSERT_EQUAL(std::string("session1"), cache.take(key));
+  CPPUNIT_ASSERT_EQUAL(std::string("session1"), cache.take(key));
+  // The latest reusable session replaces the old one.
+  cache.put(key, "session2", true);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countSessions(key));
+  CPPUNIT_ASSERT_EQUAL(std::string("session2"), cache.take(key));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+  // Different port is different server.
+  CPPUNIT_ASSERT(
+      cache.take(TLSSessionCache::makeKey("example.org", 8443)).empty());
+  // Empty data is ignored.
+  cache.put("empty", "", true);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+}
+
+void TLSSessionCacheTest::testPut_singleUse()
+{
+  TLSSessionCache cache(256, 3);
+  cache.put("a", "1", false);
+  cache.put("a", "2", false);
+  cache.put("a", "3", false);
+  cache.put("a", "4", false);
+  // The oldest ticket was dropped.
+  CPPUNIT_ASSERT_EQUAL((size_t)3, cache.countSessions("a"));
+  // Each ticket is handed out once, the newest first.
+  CPPUNIT_ASSERT_EQUAL(std::string("4"), cache.take("a"));
+  CPPUNIT_ASSERT_EQUAL(std::string("3"), cache.take("a"));
+  CPPUNIT_ASSERT_EQUAL(std::string("2"), cache.take("a"));
+  CPPUNIT_ASSERT(cache.take("a").empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.countSessions("a"));
+
+  // Reusable session replaces the tickets.
+  cache.put("a", "5", false);
+  cache.put("a", "6", true);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countSessions("a"));
+  CPPUNIT_ASSERT_EQUAL(std::string("6"), cache.take("a"));
+}
+
+void TLSSessionCacheTest::testPut_evict()
+{
+  TLSSessionCache cache(2);
+  cache.put("a", "1", true);
+  cache.put("b", "2", true);
+  // "a" is now more recently used than "b".
+  cache.take("a");
+  cache.put("c", "3", true);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("1"), cache.take("a"));
+  CPPUNIT_ASSERT(cache.take("b").empty());
+  CPPUNIT_ASSERT_EQUAL(std::string("3"), cache.take("c"));
+}
+
+void TLSSessionCacheTest::testRemove()
+{
+  TLSSessionCache cache;
+  cache.put("a", "1", false);
+  cache.put("a", "2", false);
+  cache.countHandshake("a", true);
+  cache.remove("a");
+  CPPUNIT_ASSERT(cache.take("a").empty());
+  // The statistics are kept.
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getStat("a").hits);
+}
+
+void TLSSessionCacheTest::testCountHandshake()
+{
+  TLSSessionCache cache;
+  auto stat = cache.getStat("a");
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, stat.hits);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, stat.misses);
+  cache.countHandshake("a", false);
+  cache.countHandshake("a", true);
+  cache.countHandshake("a", true);
+  cache.countHandshake("b", false);
+  stat = cache.getStat("a");
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, stat.hits);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, stat.misses);
+  stat = cache.getStat("b");
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, stat.hits);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, stat.misses);
+}
+
+void TLSSessionCacheTest::testCountHandshake_evict()
+{
+  TLSSessionCache cache(2);
+  cache.countHandshake("a", false);
+  cache.countHandshake("b", false);
+  cache.countHandshake("a", true);
+  // The statistics are limited together with the sessions.
+  cache.countHandshake("c", false);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getStat("a").hits);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, cache.getStat("b").misses);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getStat("c").misses);
+}
+
+} // namespace aria2
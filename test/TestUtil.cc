@@ -22,6 +22,7 @@
 #include "FileEntry.h"
 #include "DownloadResult.h"
 #include "message_digest_helper.h"
+#include "WorkerPool.h"
 
 namespace aria2 {
 
@@ -149,4 +150,25 @@ std::shared_ptr<DownloadResult> createDownloadResult(error_code::Value result,
   return dr;
 }
 
+#ifdef HAVE_STD_THREAD
+WorkerBlocker::WorkerBlocker(WorkerPool* pool) : released_(false)
+{
+  pool->submit(
+      [this]() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return released_; });
+      },
+      nullptr);
+}
+
+void WorkerBlocker::release()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    released_ = true;
+  }
+  cond_.notify_all();
+}
+#endif // HAVE_STD_THREAD
+
 } // namespace aria2
@@ -2,6 +2,10 @@
 
 #include <string>
 #include <memory>
+#ifdef HAVE_STD_THREAD
+#  include <mutex>
+#  include <condition_variable>
+#endif // HAVE_STD_THREAD
 
 #include "Cookie.h"
 #include "WrDiskCacheEntry.h"
@@ -10,6 +14,7 @@
 namespace aria2 {
 
 class MessageDigest;
+class WorkerPool;
 class RequestGroupMan;
 class RequestGroup;
 class Option;
@@ -65,6 +70,22 @@ createRequestGroup(int32_t pieceLength, int64_t totalLength,
 std::shared_ptr<DownloadResult> createDownloadResult(error_code::Value result,
                                                      const std::string& uri);
 
+#ifdef HAVE_STD_THREAD
+// Occupies a thread of WorkerPool until release() is called, so that
+// the jobs submitted later to a pool of one thread stay pending.
+class WorkerBlocker {
+public:
+  WorkerBlocker(WorkerPool* pool);
+
+  void release();
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  bool released_;
+};
+#endif // HAVE_STD_THREAD
+
 namespace {
 template <typename V, typename T> bool derefFind(const V& v, const T& t)
 {
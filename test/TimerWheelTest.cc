@@ -0,0 +1,172 @@
+#include "TimerWheel.h"
+
+#include <vector>
+#include <algorithm>
+#include <memory>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class TimerWheelTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TimerWheelTest);
+  CPPUNIT_TEST(testExpire);
+  CPPUNIT_TEST(testExpire_cascade);
+  CPPUNIT_TEST(testExpire_beyondSpan);
+  CPPUNIT_TEST(testDrain);
+  CPPUNIT_TEST(testGetNextExpiry);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testExpire();
+  void testExpire_cascade();
+  void testExpire_beyondSpan();
+  void testDrain();
+  void testGetNextExpiry();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TimerWheelTest);
+
+namespace {
+Timer at(std::chrono::milliseconds ms)
+{
+  auto t = Timer::zero();
+  t.advance(ms);
+  return t;
+}
+} // namespace
+
+void TimerWheelTest::testExpire()
+{
+  TimerWheel<int> wheel(100_ms, Timer::zero());
+  std::vector<int> out;
+  wheel.add(1, at(250_ms));
+  wheel.add(2, at(100_ms));
+  wheel.add(3, Timer::zero());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, wheel.size());
+
+  wheel.expire(at(0_ms), out);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+  CPPUNIT_ASSERT_EQUAL(3, out[0]);
+  out.clear();
+
+  wheel.expire(at(99_ms), out);
+  CPPUNIT_ASSERT(out.empty());
+
+  wheel.expire(at(100_ms), out);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+  CPPUNIT_ASSERT_EQUAL(2, out[0]);
+  out.clear();
+
+  // The deadline is rounded up to the tick.
+  wheel.expire(at(250_ms), out);
+  CPPUNIT_ASSERT(out.empty());
+  wheel.expire(at(300_ms), out);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+  CPPUNIT_ASSERT_EQUAL(1, out[0]);
+  CPPUNIT_ASSERT(wheel.empty());
+
+  // Deadline in the past is expired by the next call.
+  out.clear();
+  wheel.add(4, at(100_ms));
+  wheel.expire(at(300_ms), out);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+  CPPUNIT_ASSERT_EQUAL(4, out[0]);
+}
+
+void TimerWheelTest::testExpire_cascade()
+{
+  TimerWheel<int> wheel(1_ms, Timer::zero());
+  std::vector<int> deadlines{1, 63, 64, 65, 127, 128, 4095, 4096, 4097,
+                             262143, 262144, 300000};
+  for (auto d : deadlines) {
+    wheel.add(d, at(std::chrono::milliseconds(d)));
+  }
+  std::vector<int> out;
+  for (int now = 0; now <= 300000; now += 37) {
+    wheel.expire(at(std::chrono::milliseconds(now)), out);
+    for (auto v : out) {
+      CPPUNIT_ASSERT(v <= now);
+      CPPUNIT_ASSERT(now - v < 37);
+    }
+    out.clear();
+  }
+  wheel.expire(at(300037_ms), out);
+  CPPUNIT_ASSERT(wheel.empty());
+}
+
+void TimerWheelTest::testExpire_beyondSpan()
+{
+  TimerWheel<int> wheel(1_ms, Timer::zero());
+  // The wheel covers 64^4 ticks.
+  wheel.add(1, at(20000000_ms));
+  std::vector<int> out;
+  wheel.expire(at(19999999_ms), out);
+  CPPUNIT_ASSERT(out.empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, wheel.size());
+  wheel.expire(at(20000000_ms), out);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+}
+
+void TimerWheelTest::testDrain()
+{
+  TimerWheel<std::unique_ptr<int>> wheel(100_ms, Timer::zero());
+  wheel.add(make_unique<int>(1), at(1_s));
+  wheel.add(make_unique<int>(2), at(1_h));
+  wheel.add(make_unique<int>(3), Timer::zero());
+  std::vector<std::unique_ptr<int>> out;
+  wheel.drain(out);
+  CPPUNIT_ASSERT(wheel.empty());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, out.size());
+  std::vector<int> values;
+  for (auto& v : out) {
+    values.push_back(*v);
+  }
+  std::sort(std::begin(values), std::end(values));
+  CPPUNIT_ASSERT_EQUAL(1, values[0]);
+  CPPUNIT_ASSERT_EQUAL(3, values[2]);
+}
+
+void TimerWheelTest::testGetNextExpiry()
+{
+  TimerWheel<int> wheel(100_ms, Timer::zero());
+  auto next = Timer::zero();
+  CPPUNIT_ASSERT(!wheel.getNextExpiry(next));
+
+  wheel.add(1, at(550_ms));
+  CPPUNIT_ASSERT(wheel.getNextExpiry(next));
+  CPPUNIT_ASSERT(at(600_ms).getTime() == next.getTime());
+
+  std::vector<int> out;
+  wheel.expire(at(600_ms), out);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+
+  // Higher level slot cascades at the beginning of its range, which
+  // is the earliest possible expiry.  1 hour is 36000 ticks, which is
+  // in the level 2 slot starting at 8 * 64 * 64 ticks.
+  wheel.add(2, at(1_h));
+  CPPUNIT_ASSERT(wheel.getNextExpiry(next));
+  CPPUNIT_ASSERT(at(3276800_ms).getTime() == next.getTime());
+  out.clear();
+  wheel.expire(at(3276700_ms), out);
+  CPPUNIT_ASSERT(out.empty());
+  wheel.expire(next, out);
+  CPPUNIT_ASSERT(out.empty());
+  // Cascaded into the level 1 slot starting at 562 * 64 ticks.
+  CPPUNIT_ASSERT(wheel.getNextExpiry(next));
+  CPPUNIT_ASSERT(at(3596800_ms).getTime() == next.getTime());
+  wheel.expire(next, out);
+  CPPUNIT_ASSERT(wheel.getNextExpiry(next));
+  CPPUNIT_ASSERT(at(1_h).getTime() == next.getTime());
+  wheel.expire(next, out);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, out.size());
+  CPPUNIT_ASSERT_EQUAL(2, out[0]);
+  out.clear();
+
+  wheel.add(3, Timer::zero());
+  CPPUNIT_ASSERT(wheel.getNextExpiry(next));
+  CPPUNIT_ASSERT(at(1_h).getTime() == next.getTime());
+}
+
+} // namespace aria2
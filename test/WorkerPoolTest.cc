@@ -0,0 +1,117 @@
+#include "WorkerPool.h"
+
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "a2io.h"
+
+namespace aria2 {
+
+class WorkerPoolTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(WorkerPoolTest);
+  CPPUNIT_TEST(testSubmit_noThread);
+  CPPUNIT_TEST(testSubmit_threads);
+  CPPUNIT_TEST(testProcessCompletions_submitInCompletion);
+  CPPUNIT_TEST(testDestructor_runsQueuedJobs);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testSubmit_noThread();
+  void testSubmit_threads();
+  void testProcessCompletions_submitInCompletion();
+  void testDestructor_runsQueuedJobs();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WorkerPoolTest);
+
+void WorkerPoolTest::testSubmit_noThread()
+{
+  WorkerPool pool(0);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.getNumThreads());
+  CPPUNIT_ASSERT_EQUAL(-1, pool.getWakeupFd());
+
+  int work = 0;
+  int completion = 0;
+  pool.submit([&work]() { ++work; }, [&completion]() { ++completion; });
+  // Work is done in submit(), but the completion is deferred.
+  CPPUNIT_ASSERT_EQUAL(1, work);
+  CPPUNIT_ASSERT_EQUAL(0, completion);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countPending());
+  CPPUNIT_ASSERT(pool.completionReady());
+
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.processCompletions());
+  CPPUNIT_ASSERT_EQUAL(1, completion);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.countPending());
+  CPPUNIT_ASSERT(!pool.completionReady());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pool.processCompletions());
+}
+
+void WorkerPoolTest::testSubmit_threads()
+{
+  WorkerPool pool(4);
+#ifdef HAVE_STD_THREAD
+  CPPUNIT_ASSERT_EQUAL((size_t)4, pool.getNumThreads());
+#endif // HAVE_STD_THREAD
+
+  const int n = 100;
+  std::vector<int> results(n);
+  int completions = 0;
+  for (int i = 0; i < n; ++i) {
+    // Each job writes its own slot, so no synchronization is needed.
+    pool.submit([&results, i]() { results[i] = i * 2; },
+                [&completions]() { ++completions; });
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)n, pool.countPending());
+  while (pool.countPending() > 0) {
+    if (!pool.completionReady()) {
+#ifdef HAVE_POLL
+      if (pool.getWakeupFd() != -1) {
+        pollfd pfd = {pool.getWakeupFd(), POLLIN, 0};
+        poll(&pfd, 1, 1000);
+      }
+#endif // HAVE_POLL
+      continue;
+    }
+    pool.processCompletions();
+  }
+  CPPUNIT_ASSERT_EQUAL(n, completions);
+  for (int i = 0; i < n; ++i) {
+    CPPUNIT_ASSERT_EQUAL(i * 2, results[i]);
+  }
+}
+
+void WorkerPoolTest::testProcessCompletions_submitInCompletion()
+{
+  WorkerPool pool(0);
+  std::vector<int> order;
+  pool.submit([]() {},
+              [&pool, &order]() {
+                order.push_back(1);
+                pool.submit([]() {}, [&order]() { order.push_back(2); });
+              });
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.processCompletions());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, order.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.countPending());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pool.processCompletions());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, order.size());
+  CPPUNIT_ASSERT_EQUAL(2, order[1]);
+}
+
+void WorkerPoolTest::testDestructor_runsQueuedJobs()
+{
+  const int n = 100;
+  std::vector<int> results(n);
+  {
+    WorkerPool pool(1);
+    for (int i = 0; i < n; ++i) {
+      pool.submit([&results, i]() { results[i] = 1; }, nullptr);
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    CPPUNIT_ASSERT_EQUAL(1, results[i]);
+  }
+}
+
+} // namespace aria2
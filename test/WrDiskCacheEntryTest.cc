@@ -7,14 +7,62 @@
 #include "TestUtil.h"
 #include "DirectDiskAdaptor.h"
 #include "ByteArrayDiskWriter.h"
+#include "DlAbortEx.h"
 
 namespace aria2 {
 
+namespace {
+// Merges queued writes, and fails the writes overlapping
+// [badBegin, badEnd).
+class FailingDiskWriter : public ByteArrayDiskWriter {
+public:
+  FailingDiskWriter(int64_t badBegin, int64_t badEnd)
+      : badBegin_(badBegin), badEnd_(badEnd), queuedOffset_(0)
+  {
+  }
+
+  virtual void writeData(const unsigned char* data, size_t len,
+                         int64_t offset) CXX11_OVERRIDE
+  {
+    if (offset < badEnd_ && badBegin_ < offset + static_cast<int64_t>(len)) {
+      throw DL_ABORT_EX2("bad range", error_code::FILE_IO_ERROR);
+    }
+    ByteArrayDiskWriter::writeData(data, len, offset);
+  }
+
+  virtual void queueWrite(const unsigned char* data, size_t len,
+                          int64_t offset) CXX11_OVERRIDE
+  {
+    if (queued_.empty()) {
+      queuedOffset_ = offset;
+    }
+    queued_.append(data, data + len);
+  }
+
+  virtual void flushWrites() CXX11_OVERRIDE
+  {
+    std::string data;
+    data.swap(queued_);
+    if (!data.empty()) {
+      writeData(reinterpret_cast<const unsigned char*>(data.data()),
+                data.size(), queuedOffset_);
+    }
+  }
+
+private:
+  int64_t badBegin_, badEnd_;
+  std::string queued_;
+  int64_t queuedOffset_;
+};
+} // namespace
+
 class WrDiskCacheEntryTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(WrDiskCacheEntryTest);
   CPPUNIT_TEST(testWriteToDisk);
+  CPPUNIT_TEST(testWriteToDisk_entriesError);
   CPPUNIT_TEST(testAppend);
+  CPPUNIT_TEST(testGetAppendBuffer);
   CPPUNIT_TEST(testClear);
   CPPUNIT_TEST_SUITE_END();
 
@@ -31,7 +79,9 @@ public:
   }
 
   void testWriteToDisk();
+  void testWriteToDisk_entriesError();
   void testAppend();
+  void testGetAppendBuffer();
   void testClear();
 };
 
@@ -47,6 +97,29 @@ void WrDiskCacheEntryTest::testWriteToDisk()
   CPPUNIT_ASSERT_EQUAL(std::string("01234567890"), writer_->getString());
 }
 
+void WrDiskCacheEntryTest::testWriteToDisk_entriesError()
+{
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<FailingDiskWriter>(7, 8);
+  auto writer = dw.get();
+  adaptor->setDiskWriter(std::move(dw));
+  WrDiskCacheEntry e1(adaptor), e2(adaptor), e3(adaptor);
+  e1.cacheData(createDataCell(0, "01234"));
+  e2.cacheData(createDataCell(5, "56789"));
+  e3.cacheData(createDataCell(10, "abcde"));
+  WrDiskCacheEntry::writeToDisk({&e1, &e2, &e3});
+  // Only e2 overlaps the range which cannot be written.
+  CPPUNIT_ASSERT_EQUAL((int)WrDiskCacheEntry::CACHE_ERR_SUCCESS,
+                       e1.getError());
+  CPPUNIT_ASSERT_EQUAL((int)WrDiskCacheEntry::CACHE_ERR_ERROR, e2.getError());
+  CPPUNIT_ASSERT_EQUAL(error_code::FILE_IO_ERROR, e2.getErrorCode());
+  CPPUNIT_ASSERT_EQUAL((int)WrDiskCacheEntry::CACHE_ERR_SUCCESS,
+                       e3.getError());
+  CPPUNIT_ASSERT_EQUAL(std::string("01234\0\0\0\0\0abcde", 15),
+                       writer->getString());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, e2.getSize());
+}
+
 void WrDiskCacheEntryTest::testAppend()
 {
   WrDiskCacheEntry e(adaptor_);
@@ -63,11 +136,49 @@ void WrDiskCacheEntryTest::testAppend()
   CPPUNIT_ASSERT_EQUAL((size_t)3,
                        e.append(3, (const unsigned char*)"barbaz", 6));
   CPPUNIT_ASSERT_EQUAL((size_t)6, cell->len);
-  CPPUNIT_ASSERT_EQUAL((size_t)6, e.getSize());
+  // The whole buffer is accounted.
+  CPPUNIT_ASSERT_EQUAL((size_t)8, e.getSize());
 
   CPPUNIT_ASSERT_EQUAL((size_t)0, e.append(7, (const unsigned char*)"FOO", 3));
 }
 
+void WrDiskCacheEntryTest::testGetAppendBuffer()
+{
+  WrDiskCacheEntry e(adaptor_);
+  size_t len;
+  CPPUNIT_ASSERT(!e.getAppendBuffer(0, len));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, len);
+
+  auto cell = new WrDiskCacheEntry::DataCell{};
+  cell->goff = 0;
+  cell->data = new unsigned char[8];
+  memcpy(cell->data, "??foo", 5);
+  cell->offset = 2;
+  cell->len = 3;
+  cell->capacity = 6;
+  e.cacheData(cell);
+
+  // Not contiguous
+  CPPUNIT_ASSERT(!e.getAppendBuffer(4, len));
+  auto buf = e.getAppendBuffer(3, len);
+  CPPUNIT_ASSERT(buf == cell->data + 5);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, len);
+  memcpy(buf, "ba", 2);
+  e.commitAppend(2);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, cell->len);
+  CPPUNIT_ASSERT_EQUAL((size_t)8, e.getSize());
+
+  buf = e.getAppendBuffer(5, len);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, len);
+  *buf = 'r';
+  e.commitAppend(1);
+  // Cell is full
+  CPPUNIT_ASSERT(!e.getAppendBuffer(6, len));
+
+  e.writeToDisk();
+  CPPUNIT_ASSERT_EQUAL(std::string("foobar"), writer_->getString());
+}
+
 void WrDiskCacheEntryTest::testClear()
 {
   WrDiskCacheEntry e(adaptor_);
@@ -10,10 +10,28 @@
 
 namespace aria2 {
 
+namespace {
+class RecordingDiskWriter : public ByteArrayDiskWriter {
+public:
+  virtual void queueWrite(const unsigned char* data, size_t len,
+                          int64_t offset) CXX11_OVERRIDE
+  {
+    offsets.push_back(offset);
+    writeData(data, len, offset);
+  }
+
+  virtual void flushWrites() CXX11_OVERRIDE { ++numFlushes; }
+
+  std::vector<int64_t> offsets;
+  int numFlushes = 0;
+};
+} // namespace
+
 class WrDiskCacheTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(WrDiskCacheTest);
   CPPUNIT_TEST(testAdd);
+  CPPUNIT_TEST(testEnsureLimit_orderByOffset);
   CPPUNIT_TEST_SUITE_END();
 
   std::shared_ptr<DirectDiskAdaptor> adaptor_;
@@ -29,6 +47,7 @@ public:
   }
 
   void testAdd();
+  void testEnsureLimit_orderByOffset();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(WrDiskCacheTest);
@@ -74,4 +93,34 @@ void WrDiskCacheTest::testAdd()
   CPPUNIT_ASSERT_EQUAL((size_t)0, dc.getSize());
 }
 
+void WrDiskCacheTest::testEnsureLimit_orderByOffset()
+{
+  auto adaptor = std::make_shared<DirectDiskAdaptor>();
+  auto dw = make_unique<RecordingDiskWriter>();
+  auto writer = dw.get();
+  adaptor->setDiskWriter(std::move(dw));
+
+  WrDiskCache dc(40);
+  std::vector<std::unique_ptr<WrDiskCacheEntry>> entries;
+  for (auto goff : {15, 0, 10, 5, 20, 25, 30, 35, 100}) {
+    entries.push_back(make_unique<WrDiskCacheEntry>(adaptor));
+    entries.back()->cacheData(createDataCell(goff, "abcde"));
+    CPPUNIT_ASSERT(dc.add(entries.back().get()));
+  }
+  // The cache exceeded the limit by the last entry.  The 3 oldest
+  // entries are evicted to go under 3/4 of the limit, and written in
+  // the order of offset with one flush.
+  CPPUNIT_ASSERT_EQUAL((size_t)30, dc.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, writer->offsets.size());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, writer->offsets[0]);
+  CPPUNIT_ASSERT_EQUAL((int64_t)10, writer->offsets[1]);
+  CPPUNIT_ASSERT_EQUAL((int64_t)15, writer->offsets[2]);
+  CPPUNIT_ASSERT_EQUAL(1, writer->numFlushes);
+
+  for (auto& e : entries) {
+    dc.remove(e.get());
+    e->clear();
+  }
+}
+
 } // namespace aria2
@@ -1,8 +1,12 @@
 #include "bitfield.h"
 
+#include <vector>
+#include <iterator>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "TimerA2.h"
+#include "array_fun.h"
 
 namespace aria2 {
 
@@ -13,6 +17,14 @@ class bitfieldTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCountBit32);
   CPPUNIT_TEST(testCountSetBit);
   CPPUNIT_TEST(testLastByteMask);
+  CPPUNIT_TEST(testCountBit64);
+  CPPUNIT_TEST(testCountLeadingZero64);
+  CPPUNIT_TEST(testCountSetBit_words);
+  CPPUNIT_TEST(testGetFirstSetBitIndex);
+  CPPUNIT_TEST(testGetFirstNSetBitIndex);
+  CPPUNIT_TEST(testAnySetBit);
+  CPPUNIT_TEST(testIncrementCounts);
+  CPPUNIT_TEST(testDecrementCounts);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -21,6 +33,14 @@ public:
   void testCountBit32();
   void testCountSetBit();
   void testLastByteMask();
+  void testCountBit64();
+  void testCountLeadingZero64();
+  void testCountSetBit_words();
+  void testGetFirstSetBitIndex();
+  void testGetFirstNSetBitIndex();
+  void testAnySetBit();
+  void testIncrementCounts();
+  void testDecrementCounts();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(bitfieldTest);
@@ -71,4 +91,133 @@ void bitfieldTest::testLastByteMask()
                        (unsigned int)bitfield::lastByteMask(16));
 }
 
+void bitfieldTest::testCountBit64()
+{
+  CPPUNIT_ASSERT_EQUAL((size_t)64, bitfield::countBit64(UINT64_MAX));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, bitfield::countBit64(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)33,
+                       bitfield::countBit64(0x80000000ffffffffllu));
+}
+
+void bitfieldTest::testCountLeadingZero64()
+{
+  CPPUNIT_ASSERT_EQUAL((size_t)0, bitfield::countLeadingZero64(UINT64_MAX));
+  CPPUNIT_ASSERT_EQUAL((size_t)63, bitfield::countLeadingZero64(1));
+  CPPUNIT_ASSERT_EQUAL((size_t)31,
+                       bitfield::countLeadingZero64(0x1ffffffffllu));
+}
+
+namespace {
+// 20 bytes, which is 2 full words and 4 trailing bytes.  The set
+// bits are 107, 110, 120, 137, 157, 158 and 159.
+const unsigned char wordBitfield[] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x12, 0x00, 0x80, 0x00, 0x40, 0x00, 0x07,
+};
+const unsigned char wordBitfieldMask[] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xef, 0xff, 0xff, 0xff, 0xbf, 0xff, 0xff,
+};
+} // namespace
+
+void bitfieldTest::testCountSetBit_words()
+{
+  for (size_t nbits = 0; nbits <= 160; ++nbits) {
+    size_t ans = 0;
+    for (size_t i = 0; i < nbits; ++i) {
+      ans += bitfield::test(wordBitfield, nbits, i);
+    }
+    CPPUNIT_ASSERT_EQUAL(ans, bitfield::countSetBit(wordBitfield, nbits));
+    CPPUNIT_ASSERT_EQUAL(ans, bitfield::countSetBitSlow(
+                                  expr::array(wordBitfield), nbits));
+  }
+  CPPUNIT_ASSERT_EQUAL(
+      (size_t)5, bitfield::countSetBitSlow(expr::array(wordBitfield) &
+                                               expr::array(wordBitfieldMask),
+                                           160));
+  CPPUNIT_ASSERT_EQUAL(
+      (size_t)2, bitfield::countSetBitSlow(expr::array(wordBitfield) &
+                                               ~expr::array(wordBitfieldMask),
+                                           160));
+}
+
+void bitfieldTest::testGetFirstSetBitIndex()
+{
+  size_t index;
+  CPPUNIT_ASSERT(bitfield::getFirstSetBitIndex(index, wordBitfield, 160));
+  CPPUNIT_ASSERT_EQUAL((size_t)107, index);
+  CPPUNIT_ASSERT(!bitfield::getFirstSetBitIndex(index, wordBitfield, 107));
+  CPPUNIT_ASSERT(bitfield::getFirstSetBitIndex(
+      index, expr::array(wordBitfield) & expr::array(wordBitfieldMask), 160));
+  CPPUNIT_ASSERT_EQUAL((size_t)110, index);
+  CPPUNIT_ASSERT(bitfield::getFirstSetBitIndex(
+      index, ~expr::array(wordBitfieldMask), 160));
+  CPPUNIT_ASSERT_EQUAL((size_t)107, index);
+  // Trailing bits beyond nbits must be ignored.
+  CPPUNIT_ASSERT(!bitfield::getFirstSetBitIndex(index, wordBitfield, 0));
+  CPPUNIT_ASSERT(
+      !bitfield::getFirstSetBitIndex(index, ~expr::array(wordBitfield), 0));
+  const unsigned char ones[] = {0xff, 0xff};
+  CPPUNIT_ASSERT(!bitfield::getFirstSetBitIndex(index, ~expr::array(ones), 16));
+}
+
+void bitfieldTest::testGetFirstNSetBitIndex()
+{
+  std::vector<size_t> out;
+  CPPUNIT_ASSERT_EQUAL((size_t)7,
+                       bitfield::getFirstNSetBitIndex(std::back_inserter(out),
+                                                      10, wordBitfield, 160));
+  std::vector<size_t> ans = {107, 110, 120, 137, 157, 158, 159};
+  CPPUNIT_ASSERT(ans == out);
+  out.clear();
+  CPPUNIT_ASSERT_EQUAL((size_t)2,
+                       bitfield::getFirstNSetBitIndex(std::back_inserter(out),
+                                                      2, wordBitfield, 160));
+  CPPUNIT_ASSERT_EQUAL((size_t)107, out[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)110, out[1]);
+  out.clear();
+  CPPUNIT_ASSERT_EQUAL((size_t)5,
+                       bitfield::getFirstNSetBitIndex(std::back_inserter(out),
+                                                      10, wordBitfield, 158));
+  CPPUNIT_ASSERT_EQUAL((size_t)0,
+                       bitfield::getFirstNSetBitIndex(std::back_inserter(out),
+                                                      0, wordBitfield, 160));
+}
+
+void bitfieldTest::testAnySetBit()
+{
+  CPPUNIT_ASSERT(bitfield::anySetBit(wordBitfield, 160));
+  CPPUNIT_ASSERT(!bitfield::anySetBit(wordBitfield, 107));
+  CPPUNIT_ASSERT(bitfield::anySetBit(wordBitfield, 108));
+  CPPUNIT_ASSERT(!bitfield::anySetBit(
+      expr::array(wordBitfieldMask) & ~expr::array(wordBitfieldMask), 160));
+}
+
+void bitfieldTest::testIncrementCounts()
+{
+  std::vector<int> counts(160);
+  counts[110] = std::numeric_limits<int>::max();
+  bitfield::incrementCounts(counts.data(), wordBitfield, 160);
+  bitfield::incrementCounts(counts.data(), wordBitfieldMask, 160);
+  for (size_t i = 0; i < 160; ++i) {
+    int ans = bitfield::test(wordBitfield, 160, i) +
+              bitfield::test(wordBitfieldMask, 160, i);
+    if (i == 110) {
+      ans = std::numeric_limits<int>::max();
+    }
+    CPPUNIT_ASSERT_EQUAL(ans, counts[i]);
+  }
+}
+
+void bitfieldTest::testDecrementCounts()
+{
+  std::vector<int> counts(160, 1);
+  bitfield::decrementCounts(counts.data(), wordBitfieldMask, 160);
+  bitfield::decrementCounts(counts.data(), wordBitfieldMask, 150);
+  for (size_t i = 0; i < 160; ++i) {
+    int ans = bitfield::test(wordBitfieldMask, 160, i) ? 0 : 1;
+    CPPUNIT_ASSERT_EQUAL(ans, counts[i]);
+  }
+}
+
 } // namespace aria2